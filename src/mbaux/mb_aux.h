@@ -186,6 +186,30 @@ struct mb_topogrid_struct {
   float *data;
 };
 
+/* multiresolution grid pyramid cache (file.grd.mbpyr) */
+#define MB_GRIDPYRAMID_TILE 256
+#define MB_GRIDPYRAMID_LEVEL_MAX 24
+struct mb_gridpyramid_struct {
+  mb_path file;
+  int projection_mode;
+  mb_path projection_id;
+  float nodatavalue;
+  double min;
+  double max;
+  double xmin;
+  double xmax;
+  double ymin;
+  double ymax;
+  double dx; /* level 0 node spacing, level L spacing is dx * 2^L */
+  double dy;
+  int num_levels;
+  int n_columns[MB_GRIDPYRAMID_LEVEL_MAX];
+  int n_rows[MB_GRIDPYRAMID_LEVEL_MAX];
+  size_t level_offset[MB_GRIDPYRAMID_LEVEL_MAX];
+  void *map;
+  size_t map_size;
+};
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -221,6 +245,11 @@ void mb_plot_string(double x, double y, double hgt, double angle, char *label);
 /* mb_surface function prototypes */
 int mb_surface(int verbose, int ndat, float *xdat, float *ydat, float *zdat, double xxmin, double xxmax, double yymin,
                double yymax, double xxinc, double yyinc, double ttension, float *sgrid);
+int mb_surface_ctx_init(int verbose, int nthreads, void **surface_ptr, int *error);
+int mb_surface_ctx_compute(int verbose, void *surface_ptr, int ndat, float *xdat, float *ydat, float *zdat, double xxmin,
+                           double xxmax, double yymin, double yymax, double xxinc, double yyinc, double ttension, float *sgrid,
+                           int *error);
+int mb_surface_ctx_deall(int verbose, void **surface_ptr, int *error);
 int mb_zgrid(float *z, int *n_columns, int *n_rows, float *x1, float *y1, float *dx, float *dy, float *xyz, int *n, float *zpij, int *knxt,
              bool *imnew, float *cay, int *nrng);
 int mb_zgrid2(float *z, int *n_columns, int *n_rows, float *x1, float *y1, float *dx, float *dy, float *xyz, int *n, float *zpij, int *knxt,
@@ -246,6 +275,17 @@ int mb_write_gmt_grd(int verbose, const char *grdfile, float *grid,
                      const char *titl, const char *projection,
                      int argc, char **argv, int *error);
 
+/* mb_gridpyramid function prototypes */
+int mb_gridpyramid_write(int verbose, const char *grdfile, int projection_mode, const char *projection_id, float nodatavalue,
+                         int n_columns, int n_rows, double min, double max, double xmin, double xmax, double ymin, double ymax,
+                         double dx, double dy, const float *data, int *error);
+int mb_gridpyramid_open(int verbose, const char *grdfile, struct mb_gridpyramid_struct **pyramid, int *error);
+int mb_gridpyramid_getlevel(int verbose, struct mb_gridpyramid_struct *pyramid, int ixmin, int ixmax, int jymin, int jymax,
+                            int nxy_max, int *level, int *error);
+int mb_gridpyramid_read(int verbose, struct mb_gridpyramid_struct *pyramid, int level, int ixmin, int ixmax, int jymin,
+                        int jymax, float *data, double *min, double *max, int *error);
+int mb_gridpyramid_close(int verbose, struct mb_gridpyramid_struct **pyramid, int *error);
+
 /* mb_cheb function prototypes */
 void lsqup(const double *a, const int *ia, const int *nia, int nnz, int nc, int nr, double *x, double *dx, const double *d, int nfix, const int *ifix,
            const double *fix, int ncycle, const double *sigma);
@@ -0,0 +1,558 @@
+/*--------------------------------------------------------------------
+ *    The MB-system:  mb_gridpyramid.c  10/17/2026
+ *
+ *    Copyright (c) 2026 by
+ *    David W. Caress (caress@mbari.org)
+ *      Monterey Bay Aquarium Research Institute
+ *      Moss Landing, California, USA
+ *    Dale N. Chayes
+ *      Center for Coastal and Ocean Mapping
+ *      University of New Hampshire
+ *      Durham, New Hampshire, USA
+ *    Christian dos Santos Ferreira
+ *      MARUM
+ *      University of Bremen
+ *      Bremen Germany
+ *
+ *    MB-System was created by Caress and Chayes in 1992 at the
+ *      Lamont-Doherty Earth Observatory
+ *      Columbia University
+ *      Palisades, NY 10964
+ *
+ *    See README.md file for copying and redistribution conditions.
+ *--------------------------------------------------------------------*/
+/*
+ * mb_gridpyramid.c contains the functions that build and read
+ * multiresolution grid pyramid caches. A pyramid cache is written next
+ * to a grid as file.grd.mbpyr, and holds the grid values at full
+ * resolution (level 0) and at successively halved resolutions down to a
+ * level that fits within a single tile.
+ *
+ * These functions include:
+ *   mb_gridpyramid_write  - build and write file.grd.mbpyr from a grid in memory
+ *   mb_gridpyramid_open  - memory map a current file.grd.mbpyr
+ *   mb_gridpyramid_getlevel  - get the finest level at which a region fits in a node budget
+ *   mb_gridpyramid_read  - extract a region of one level into a grid array
+ *   mb_gridpyramid_close  - unmap and release a pyramid
+ *
+ * Node (i, j) of level L lies at node (i * 2^L, j * 2^L) of the full grid,
+ * so all levels share the grid origin. Its value is a 1-2-1 weighted mean
+ * of the valid nodes around node (2i, 2j) of level L - 1, and it has no
+ * data wherever that node has no data, so that data boundaries stay sharp.
+ *
+ * Each level is stored in square tiles of MB_GRIDPYRAMID_TILE nodes on
+ * a side, with the values in each tile in the internal column major
+ * order (k = i * n_rows + j). Reading a region from the memory mapped
+ * cache only pages in the tiles that the region touches, so a subregion
+ * of a grid larger than memory can be read at full resolution.
+ *
+ * A pyramid is used only if the size and modification time of the grid
+ * file match those recorded in it. Like the sidecar index files, the
+ * cache is written in the native byte order and structure layout.
+ *
+ * Author:  D. W. Caress
+ * Date:  October 17, 2026
+ */
+
+#include <fcntl.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mb_aux.h"
+#include "mb_define.h"
+#include "mb_status.h"
+
+#define MB_GRIDPYRAMID_MAGIC "MBPYR\0\0\1"
+#define MB_GRIDPYRAMID_MAGIC_LEN 8
+#define MB_GRIDPYRAMID_VERSION 1
+#define MB_GRIDPYRAMID_DATA_OFFSET 8192
+
+/* file.grd.mbpyr header */
+struct mb_gridpyramid_header {
+  char magic[MB_GRIDPYRAMID_MAGIC_LEN];
+  int32_t version;
+  int32_t header_size; /* sizeof(struct mb_gridpyramid_header) */
+  int32_t tile;        /* MB_GRIDPYRAMID_TILE */
+  int32_t num_levels;
+  int64_t file_size;   /* size of the grid file in bytes */
+  int64_t file_mtime;  /* modification time of the grid file */
+  int32_t projection_mode;
+  float nodatavalue;
+  char projection_id[MB_PATH_MAXLINE];
+  double min;
+  double max;
+  double xmin;
+  double xmax;
+  double ymin;
+  double ymax;
+  double dx;
+  double dy;
+  int32_t n_columns[MB_GRIDPYRAMID_LEVEL_MAX];
+  int32_t n_rows[MB_GRIDPYRAMID_LEVEL_MAX];
+};
+
+/*--------------------------------------------------------------------*/
+/* Gets the number of values stored for a level, including tile padding. */
+static size_t mb_gridpyramid_levelsize(int n_columns, int n_rows) {
+  const size_t ntx = (n_columns + MB_GRIDPYRAMID_TILE - 1) / MB_GRIDPYRAMID_TILE;
+  const size_t nty = (n_rows + MB_GRIDPYRAMID_TILE - 1) / MB_GRIDPYRAMID_TILE;
+  return ntx * nty * MB_GRIDPYRAMID_TILE * MB_GRIDPYRAMID_TILE;
+}
+/*--------------------------------------------------------------------*/
+/* Gets the number of levels and their dimensions for a grid. */
+static int mb_gridpyramid_levels(int n_columns, int n_rows, int32_t *level_n_columns, int32_t *level_n_rows) {
+  int num_levels = 0;
+  level_n_columns[num_levels] = n_columns;
+  level_n_rows[num_levels] = n_rows;
+  num_levels++;
+  while (num_levels < MB_GRIDPYRAMID_LEVEL_MAX &&
+         (level_n_columns[num_levels - 1] > MB_GRIDPYRAMID_TILE || level_n_rows[num_levels - 1] > MB_GRIDPYRAMID_TILE)) {
+    level_n_columns[num_levels] = (level_n_columns[num_levels - 1] + 1) / 2;
+    level_n_rows[num_levels] = (level_n_rows[num_levels - 1] + 1) / 2;
+    num_levels++;
+  }
+  return (num_levels);
+}
+/*--------------------------------------------------------------------*/
+/* Makes the next coarser level of a pyramid from a level held in the
+   internal column major order. */
+static void mb_gridpyramid_reduce(float nodatavalue, int n_columns, int n_rows, const float *data, int n_columns_out,
+                                  int n_rows_out, float *data_out) {
+  static const double weight[3] = {1.0, 2.0, 1.0};
+  for (int i = 0; i < n_columns_out; i++) {
+    for (int j = 0; j < n_rows_out; j++) {
+      const int kout = i * n_rows_out + j;
+      const int ii = 2 * i;
+      const int jj = 2 * j;
+      if (data[ii * n_rows + jj] == nodatavalue) {
+        data_out[kout] = nodatavalue;
+        continue;
+      }
+      double sum = 0.0;
+      double sumweight = 0.0;
+      for (int di = -1; di <= 1; di++) {
+        const int iii = ii + di;
+        if (iii < 0 || iii >= n_columns)
+          continue;
+        for (int dj = -1; dj <= 1; dj++) {
+          const int jjj = jj + dj;
+          if (jjj < 0 || jjj >= n_rows)
+            continue;
+          const float value = data[iii * n_rows + jjj];
+          if (value != nodatavalue) {
+            sum += weight[di + 1] * weight[dj + 1] * value;
+            sumweight += weight[di + 1] * weight[dj + 1];
+          }
+        }
+      }
+      data_out[kout] = (float)(sum / sumweight);
+    }
+  }
+}
+/*--------------------------------------------------------------------*/
+/* Writes one level in tiles, padding partial tiles with the no data value. */
+static bool mb_gridpyramid_writelevel(FILE *fp, float nodatavalue, int n_columns, int n_rows, const float *data,
+                                      float *tile) {
+  const int ntx = (n_columns + MB_GRIDPYRAMID_TILE - 1) / MB_GRIDPYRAMID_TILE;
+  const int nty = (n_rows + MB_GRIDPYRAMID_TILE - 1) / MB_GRIDPYRAMID_TILE;
+  bool ok = true;
+  for (int itile = 0; itile < ntx && ok; itile++) {
+    for (int jtile = 0; jtile < nty && ok; jtile++) {
+      for (int it = 0; it < MB_GRIDPYRAMID_TILE; it++) {
+        const int i = itile * MB_GRIDPYRAMID_TILE + it;
+        float *column = &tile[it * MB_GRIDPYRAMID_TILE];
+        const int j0 = jtile * MB_GRIDPYRAMID_TILE;
+        const int nj = i < n_columns ? MIN(MB_GRIDPYRAMID_TILE, n_rows - j0) : 0;
+        if (nj > 0)
+          memcpy(column, &data[(size_t)i * n_rows + j0], nj * sizeof(float));
+        for (int jt = nj; jt < MB_GRIDPYRAMID_TILE; jt++)
+          column[jt] = nodatavalue;
+      }
+      ok = fwrite(tile, sizeof(float), MB_GRIDPYRAMID_TILE * MB_GRIDPYRAMID_TILE, fp) ==
+           MB_GRIDPYRAMID_TILE * MB_GRIDPYRAMID_TILE;
+    }
+  }
+  return (ok);
+}
+/*--------------------------------------------------------------------*/
+int mb_gridpyramid_write(int verbose, const char *grdfile, int projection_mode, const char *projection_id, float nodatavalue,
+                         int n_columns, int n_rows, double min, double max, double xmin, double xmax, double ymin, double ymax,
+                         double dx, double dy, const float *data, int *error) {
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBBA function <%s> called\n", __func__);
+    fprintf(stderr, "dbg2  Input arguments:\n");
+    fprintf(stderr, "dbg2       verbose:         %d\n", verbose);
+    fprintf(stderr, "dbg2       grdfile:         %s\n", grdfile);
+    fprintf(stderr, "dbg2       projection_mode: %d\n", projection_mode);
+    fprintf(stderr, "dbg2       projection_id:   %s\n", projection_id);
+    fprintf(stderr, "dbg2       nodatavalue:     %f\n", nodatavalue);
+    fprintf(stderr, "dbg2       n_columns:       %d\n", n_columns);
+    fprintf(stderr, "dbg2       n_rows:          %d\n", n_rows);
+    fprintf(stderr, "dbg2       min:             %f\n", min);
+    fprintf(stderr, "dbg2       max:             %f\n", max);
+    fprintf(stderr, "dbg2       xmin:            %f\n", xmin);
+    fprintf(stderr, "dbg2       xmax:            %f\n", xmax);
+    fprintf(stderr, "dbg2       ymin:            %f\n", ymin);
+    fprintf(stderr, "dbg2       ymax:            %f\n", ymax);
+    fprintf(stderr, "dbg2       dx:              %f\n", dx);
+    fprintf(stderr, "dbg2       dy:              %f\n", dy);
+    fprintf(stderr, "dbg2       data:            %p\n", data);
+  }
+
+  int status = MB_SUCCESS;
+  *error = MB_ERROR_NO_ERROR;
+
+  /* the pyramid matches the grid file as it is now */
+  struct stat file_status;
+  struct mb_gridpyramid_header header;
+  memset(&header, 0, sizeof(struct mb_gridpyramid_header));
+  if (n_columns <= 0 || n_rows <= 0 || data == NULL) {
+    status = MB_FAILURE;
+    *error = MB_ERROR_BAD_PARAMETER;
+  }
+  else if (stat(grdfile, &file_status) != 0 || (file_status.st_mode & S_IFMT) == S_IFDIR) {
+    status = MB_FAILURE;
+    *error = MB_ERROR_OPEN_FAIL;
+  }
+  else {
+    memcpy(header.magic, MB_GRIDPYRAMID_MAGIC, MB_GRIDPYRAMID_MAGIC_LEN);
+    header.version = MB_GRIDPYRAMID_VERSION;
+    header.header_size = sizeof(struct mb_gridpyramid_header);
+    header.tile = MB_GRIDPYRAMID_TILE;
+    header.file_size = file_status.st_size;
+    header.file_mtime = file_status.st_mtime;
+    header.projection_mode = projection_mode;
+    header.nodatavalue = nodatavalue;
+    strncpy(header.projection_id, projection_id, MB_PATH_MAXLINE - 1);
+    header.min = min;
+    header.max = max;
+    header.xmin = xmin;
+    header.xmax = xmax;
+    header.ymin = ymin;
+    header.ymax = ymax;
+    header.dx = dx;
+    header.dy = dy;
+    header.num_levels = mb_gridpyramid_levels(n_columns, n_rows, header.n_columns, header.n_rows);
+  }
+
+  /* working space for one tile and for two successive reduced levels */
+  float *tile = NULL;
+  float *level_data[2] = {NULL, NULL};
+  if (status == MB_SUCCESS)
+    status = mb_mallocd(verbose, __FILE__, __LINE__, sizeof(float) * MB_GRIDPYRAMID_TILE * MB_GRIDPYRAMID_TILE,
+                        (void **)&tile, error);
+  for (int ibuffer = 0; ibuffer < 2 && status == MB_SUCCESS && header.num_levels > ibuffer + 1; ibuffer++)
+    status = mb_mallocd(verbose, __FILE__, __LINE__,
+                        sizeof(float) * (size_t)header.n_columns[ibuffer + 1] * header.n_rows[ibuffer + 1],
+                        (void **)&level_data[ibuffer], error);
+
+  /* write to a temporary file and rename it so that a reader never
+      sees a partial pyramid */
+  if (status == MB_SUCCESS) {
+    char path[MB_PATH_MAXLINE + 8];
+    char tmppath[MB_PATH_MAXLINE + 16];
+    snprintf(path, sizeof(path), "%s.mbpyr", grdfile);
+    snprintf(tmppath, sizeof(tmppath), "%s.tmp", path);
+    FILE *fp = fopen(tmppath, "wb");
+    if (fp == NULL) {
+      status = MB_FAILURE;
+      *error = MB_ERROR_OPEN_FAIL;
+    }
+    else {
+      bool ok = fwrite(&header, sizeof(struct mb_gridpyramid_header), 1, fp) == 1 &&
+                fseek(fp, MB_GRIDPYRAMID_DATA_OFFSET, SEEK_SET) == 0;
+      const float *level = data;
+      for (int ilevel = 0; ilevel < header.num_levels && ok; ilevel++) {
+        if (ilevel > 0) {
+          float *reduced = level_data[(ilevel - 1) % 2];
+          mb_gridpyramid_reduce(nodatavalue, header.n_columns[ilevel - 1], header.n_rows[ilevel - 1], level,
+                                header.n_columns[ilevel], header.n_rows[ilevel], reduced);
+          level = reduced;
+        }
+        ok = mb_gridpyramid_writelevel(fp, nodatavalue, header.n_columns[ilevel], header.n_rows[ilevel], level, tile);
+      }
+      if (fclose(fp) != 0)
+        ok = false;
+      if (ok && rename(tmppath, path) == 0) {
+        if (verbose >= 1)
+          fprintf(stderr, "Wrote grid pyramid %s with %d levels\n", path, header.num_levels);
+      }
+      else {
+        unlink(tmppath);
+        status = MB_FAILURE;
+        *error = MB_ERROR_WRITE_FAIL;
+      }
+    }
+  }
+
+  /* deallocate working space */
+  int tmp_error = MB_ERROR_NO_ERROR;
+  if (tile != NULL)
+    mb_freed(verbose, __FILE__, __LINE__, (void **)&tile, &tmp_error);
+  for (int ibuffer = 0; ibuffer < 2; ibuffer++)
+    if (level_data[ibuffer] != NULL)
+      mb_freed(verbose, __FILE__, __LINE__, (void **)&level_data[ibuffer], &tmp_error);
+
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBBA function <%s> completed\n", __func__);
+    fprintf(stderr, "dbg2  Return values:\n");
+    fprintf(stderr, "dbg2       error:      %d\n", *error);
+    fprintf(stderr, "dbg2  Return status:\n");
+    fprintf(stderr, "dbg2       status:     %d\n", status);
+  }
+
+  return (status);
+}
+/*--------------------------------------------------------------------*/
+int mb_gridpyramid_open(int verbose, const char *grdfile, struct mb_gridpyramid_struct **pyramid, int *error) {
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBBA function <%s> called\n", __func__);
+    fprintf(stderr, "dbg2  Input arguments:\n");
+    fprintf(stderr, "dbg2       verbose:    %d\n", verbose);
+    fprintf(stderr, "dbg2       grdfile:    %s\n", grdfile);
+  }
+
+  int status = MB_SUCCESS;
+  *error = MB_ERROR_NO_ERROR;
+  *pyramid = NULL;
+
+  char path[MB_PATH_MAXLINE + 8];
+  snprintf(path, sizeof(path), "%s.mbpyr", grdfile);
+  struct stat file_status;
+  struct stat pyramid_status;
+  int fd = -1;
+  if (stat(grdfile, &file_status) != 0 || (file_status.st_mode & S_IFMT) == S_IFDIR ||
+      stat(path, &pyramid_status) != 0 || (pyramid_status.st_mode & S_IFMT) == S_IFDIR ||
+      (fd = open(path, O_RDONLY)) < 0) {
+    status = MB_FAILURE;
+    *error = MB_ERROR_OPEN_FAIL;
+  }
+
+  /* a pyramid is used only if it was made on this kind of machine
+      from the grid file as it is now */
+  struct mb_gridpyramid_header header;
+  int32_t n_columns[MB_GRIDPYRAMID_LEVEL_MAX];
+  int32_t n_rows[MB_GRIDPYRAMID_LEVEL_MAX];
+  size_t level_offset[MB_GRIDPYRAMID_LEVEL_MAX];
+  if (status == MB_SUCCESS) {
+    bool ok = read(fd, &header, sizeof(struct mb_gridpyramid_header)) == sizeof(struct mb_gridpyramid_header) &&
+              memcmp(header.magic, MB_GRIDPYRAMID_MAGIC, MB_GRIDPYRAMID_MAGIC_LEN) == 0 &&
+              header.version == MB_GRIDPYRAMID_VERSION && header.header_size == sizeof(struct mb_gridpyramid_header) &&
+              header.tile == MB_GRIDPYRAMID_TILE && header.file_size == (int64_t)file_status.st_size &&
+              header.file_mtime == (int64_t)file_status.st_mtime && header.n_columns[0] > 0 && header.n_rows[0] > 0 &&
+              header.num_levels == mb_gridpyramid_levels(header.n_columns[0], header.n_rows[0], n_columns, n_rows);
+    size_t size = MB_GRIDPYRAMID_DATA_OFFSET;
+    for (int ilevel = 0; ok && ilevel < header.num_levels; ilevel++) {
+      ok = header.n_columns[ilevel] == n_columns[ilevel] && header.n_rows[ilevel] == n_rows[ilevel];
+      level_offset[ilevel] = size;
+      size += sizeof(float) * mb_gridpyramid_levelsize(n_columns[ilevel], n_rows[ilevel]);
+    }
+    if (!ok || (size_t)pyramid_status.st_size != size) {
+      status = MB_FAILURE;
+      *error = MB_ERROR_BAD_FORMAT;
+    }
+  }
+
+  /* memory map the pyramid */
+  void *map = MAP_FAILED;
+  if (status == MB_SUCCESS) {
+    map = mmap(NULL, (size_t)pyramid_status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+      status = MB_FAILURE;
+      *error = MB_ERROR_OPEN_FAIL;
+    }
+  }
+  if (fd >= 0)
+    close(fd);
+
+  if (status == MB_SUCCESS) {
+    status = mb_mallocd(verbose, __FILE__, __LINE__, sizeof(struct mb_gridpyramid_struct), (void **)pyramid, error);
+    if (status == MB_SUCCESS) {
+      struct mb_gridpyramid_struct *p = *pyramid;
+      memset(p, 0, sizeof(struct mb_gridpyramid_struct));
+      strncpy(p->file, grdfile, MB_PATH_MAXLINE - 1);
+      p->projection_mode = header.projection_mode;
+      strncpy(p->projection_id, header.projection_id, MB_PATH_MAXLINE - 1);
+      p->nodatavalue = header.nodatavalue;
+      p->min = header.min;
+      p->max = header.max;
+      p->xmin = header.xmin;
+      p->xmax = header.xmax;
+      p->ymin = header.ymin;
+      p->ymax = header.ymax;
+      p->dx = header.dx;
+      p->dy = header.dy;
+      p->num_levels = header.num_levels;
+      for (int ilevel = 0; ilevel < header.num_levels; ilevel++) {
+        p->n_columns[ilevel] = header.n_columns[ilevel];
+        p->n_rows[ilevel] = header.n_rows[ilevel];
+        p->level_offset[ilevel] = level_offset[ilevel];
+      }
+      p->map = map;
+      p->map_size = (size_t)pyramid_status.st_size;
+    }
+    else {
+      munmap(map, (size_t)pyramid_status.st_size);
+    }
+  }
+
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBBA function <%s> completed\n", __func__);
+    fprintf(stderr, "dbg2  Return values:\n");
+    fprintf(stderr, "dbg2       pyramid:    %p\n", (void *)*pyramid);
+    if (*pyramid != NULL)
+      fprintf(stderr, "dbg2       num_levels: %d\n", (*pyramid)->num_levels);
+    fprintf(stderr, "dbg2       error:      %d\n", *error);
+    fprintf(stderr, "dbg2  Return status:\n");
+    fprintf(stderr, "dbg2       status:     %d\n", status);
+  }
+
+  return (status);
+}
+/*--------------------------------------------------------------------*/
+int mb_gridpyramid_getlevel(int verbose, struct mb_gridpyramid_struct *pyramid, int ixmin, int ixmax, int jymin, int jymax,
+                            int nxy_max, int *level, int *error) {
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBBA function <%s> called\n", __func__);
+    fprintf(stderr, "dbg2  Input arguments:\n");
+    fprintf(stderr, "dbg2       verbose:    %d\n", verbose);
+    fprintf(stderr, "dbg2       pyramid:    %p\n", (void *)pyramid);
+    fprintf(stderr, "dbg2       ixmin:      %d\n", ixmin);
+    fprintf(stderr, "dbg2       ixmax:      %d\n", ixmax);
+    fprintf(stderr, "dbg2       jymin:      %d\n", jymin);
+    fprintf(stderr, "dbg2       jymax:      %d\n", jymax);
+    fprintf(stderr, "dbg2       nxy_max:    %d\n", nxy_max);
+  }
+
+  /* use the finest level at which the nodes covering the region, given
+      in full resolution nodes, number no more than nxy_max, or else the
+      coarsest level */
+  *level = 0;
+  while (*level < pyramid->num_levels - 1) {
+    const int n = 1 << *level;
+    const double n_columns = MIN((ixmax + n - 1) / n, pyramid->n_columns[*level] - 1) - ixmin / n + 1;
+    const double n_rows = MIN((jymax + n - 1) / n, pyramid->n_rows[*level] - 1) - jymin / n + 1;
+    if (n_columns * n_rows <= nxy_max)
+      break;
+    (*level)++;
+  }
+
+  const int status = MB_SUCCESS;
+  *error = MB_ERROR_NO_ERROR;
+
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBBA function <%s> completed\n", __func__);
+    fprintf(stderr, "dbg2  Return values:\n");
+    fprintf(stderr, "dbg2       level:      %d\n", *level);
+    fprintf(stderr, "dbg2       error:      %d\n", *error);
+    fprintf(stderr, "dbg2  Return status:\n");
+    fprintf(stderr, "dbg2       status:     %d\n", status);
+  }
+
+  return (status);
+}
+/*--------------------------------------------------------------------*/
+int mb_gridpyramid_read(int verbose, struct mb_gridpyramid_struct *pyramid, int level, int ixmin, int ixmax, int jymin,
+                        int jymax, float *data, double *min, double *max, int *error) {
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBBA function <%s> called\n", __func__);
+    fprintf(stderr, "dbg2  Input arguments:\n");
+    fprintf(stderr, "dbg2       verbose:    %d\n", verbose);
+    fprintf(stderr, "dbg2       pyramid:    %p\n", (void *)pyramid);
+    fprintf(stderr, "dbg2       level:      %d\n", level);
+    fprintf(stderr, "dbg2       ixmin:      %d\n", ixmin);
+    fprintf(stderr, "dbg2       ixmax:      %d\n", ixmax);
+    fprintf(stderr, "dbg2       jymin:      %d\n", jymin);
+    fprintf(stderr, "dbg2       jymax:      %d\n", jymax);
+    fprintf(stderr, "dbg2       data:       %p\n", data);
+  }
+
+  int status = MB_SUCCESS;
+  *error = MB_ERROR_NO_ERROR;
+  *min = pyramid->nodatavalue;
+  *max = pyramid->nodatavalue;
+
+  if (level < 0 || level >= pyramid->num_levels || ixmin < 0 || ixmax >= pyramid->n_columns[level] || ixmin > ixmax ||
+      jymin < 0 || jymax >= pyramid->n_rows[level] || jymin > jymax) {
+    status = MB_FAILURE;
+    *error = MB_ERROR_BAD_PARAMETER;
+  }
+
+  /* copy the region one column at a time, in runs that lie within a tile */
+  else {
+    const float *level_data = (const float *)((const char *)pyramid->map + pyramid->level_offset[level]);
+    const int nty = (pyramid->n_rows[level] + MB_GRIDPYRAMID_TILE - 1) / MB_GRIDPYRAMID_TILE;
+    const int n_rows = jymax - jymin + 1;
+    bool found = false;
+    for (int i = ixmin; i <= ixmax; i++) {
+      float *column = &data[(size_t)(i - ixmin) * n_rows];
+      const int itile = i / MB_GRIDPYRAMID_TILE;
+      const int it = i % MB_GRIDPYRAMID_TILE;
+      for (int j = jymin; j <= jymax;) {
+        const int jtile = j / MB_GRIDPYRAMID_TILE;
+        const int jt = j % MB_GRIDPYRAMID_TILE;
+        const int nj = MIN(MB_GRIDPYRAMID_TILE - jt, jymax - j + 1);
+        const float *tile = &level_data[((size_t)itile * nty + jtile) * MB_GRIDPYRAMID_TILE * MB_GRIDPYRAMID_TILE];
+        memcpy(&column[j - jymin], &tile[it * MB_GRIDPYRAMID_TILE + jt], nj * sizeof(float));
+        j += nj;
+      }
+      for (int j = 0; j < n_rows; j++) {
+        if (column[j] != pyramid->nodatavalue) {
+          if (!found || column[j] < *min)
+            *min = column[j];
+          if (!found || column[j] > *max)
+            *max = column[j];
+          found = true;
+        }
+      }
+    }
+  }
+
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBBA function <%s> completed\n", __func__);
+    fprintf(stderr, "dbg2  Return values:\n");
+    fprintf(stderr, "dbg2       min:        %f\n", *min);
+    fprintf(stderr, "dbg2       max:        %f\n", *max);
+    fprintf(stderr, "dbg2       error:      %d\n", *error);
+    fprintf(stderr, "dbg2  Return status:\n");
+    fprintf(stderr, "dbg2       status:     %d\n", status);
+  }
+
+  return (status);
+}
+/*--------------------------------------------------------------------*/
+int mb_gridpyramid_close(int verbose, struct mb_gridpyramid_struct **pyramid, int *error) {
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBBA function <%s> called\n", __func__);
+    fprintf(stderr, "dbg2  Input arguments:\n");
+    fprintf(stderr, "dbg2       verbose:    %d\n", verbose);
+    fprintf(stderr, "dbg2       pyramid:    %p\n", (void *)*pyramid);
+  }
+
+  int status = MB_SUCCESS;
+  *error = MB_ERROR_NO_ERROR;
+
+  if (*pyramid != NULL) {
+    if ((*pyramid)->map != NULL)
+      munmap((*pyramid)->map, (*pyramid)->map_size);
+    status = mb_freed(verbose, __FILE__, __LINE__, (void **)pyramid, error);
+  }
+
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBBA function <%s> completed\n", __func__);
+    fprintf(stderr, "dbg2  Return values:\n");
+    fprintf(stderr, "dbg2       error:      %d\n", *error);
+    fprintf(stderr, "dbg2  Return status:\n");
+    fprintf(stderr, "dbg2       status:     %d\n", status);
+  }
+
+  return (status);
+}
+/*--------------------------------------------------------------------*/
@@ -121,6 +121,13 @@
 #define MBGRDVIZ_REALTIME_OFF 0
 #define MBGRDVIZ_REALTIME_ON 1
 #define MBGRDVIZ_REALTIME_PAUSE 2
+
+/* grids with at least MBGRDVIZ_PYRAMID_NXY_MIN nodes are cached in a
+    multiresolution pyramid (file.grd.mbpyr), and no more nodes than fit
+    in about a quarter of physical memory are loaded into a window */
+#define MBGRDVIZ_PYRAMID_NXY_MIN 4194304
+#define MBGRDVIZ_PYRAMID_NXY_MAX 268435456
+#define MBGRDVIZ_PYRAMID_BYTES_PER_NODE 40
 static int working_route = -1;
 static int survey_instance = 0;
 static int survey_mode = MBGRDVIZ_SURVEY_MODE_UNIFORM;
@@ -146,6 +153,7 @@ static char **pargv;
 
 /* widgets */
 static bool mbview_id[MBV_MAX_WINDOWS];
+static mb_path mbview_pyramid_file[MBV_MAX_WINDOWS];
 extern Widget mainWindow;
 static Widget fileSelectionList;
 static Widget fileSelectionText;
@@ -544,6 +552,7 @@ int do_mbgrdviz_init(int argc, char **argv, int verbosity) {
   /* initialize mbview_id list */
   for (int i = 0; i < MBV_MAX_WINDOWS; i++) {
     mbview_id[i] = false;
+    mbview_pyramid_file[i][0] = '\0';
   }
 
   /* set sensitivity of widgets that require an mbview instance to be active */
@@ -1438,6 +1447,7 @@ int do_mbgrdviz_dismiss_notify(size_t instance) {
   /* set mbview window <id> to inactive */
   if (instance != MBV_NO_WINDOW && instance < MBV_MAX_WINDOWS && mbview_id[instance]) {
     mbview_id[instance] = false;
+    mbview_pyramid_file[instance][0] = '\0';
     /* fprintf(stderr, "Freeing mbview window %d in local list...\n",
             instance); */
   }
@@ -1681,6 +1691,77 @@ void do_mbgrdviz_openfile(Widget w, XtPointer client_data, XtPointer call_data)
     do_mbview_message_off(instance);
 }
 /*---------------------------------------------------------------------------------------*/
+/* Gets the largest number of grid nodes to load into a new mbview window. */
+
+static int do_mbgrdviz_pyramid_nxymax(void) {
+  const double memory = (double)sysconf(_SC_PHYS_PAGES) * (double)sysconf(_SC_PAGESIZE);
+  const double nxy_max = 0.25 * memory / MBGRDVIZ_PYRAMID_BYTES_PER_NODE;
+  return (nxy_max > 0.0 ? (int)MAX(MIN(nxy_max, MBGRDVIZ_PYRAMID_NXY_MAX), MBGRDVIZ_PYRAMID_NXY_MIN)
+                        : MBGRDVIZ_PYRAMID_NXY_MAX);
+}
+/*---------------------------------------------------------------------------------------*/
+/* Reads the region of a grid pyramid covering full resolution nodes ixmin-ixmax
+    and jymin-jymax from the finest level at which it fits in memory. */
+
+static int do_mbgrdviz_pyramid_read(struct mb_gridpyramid_struct *pyramid, int ixmin, int ixmax, int jymin, int jymax,
+                                    int *nxy, int *n_columns, int *n_rows, double *min, double *max, double *xmin,
+                                    double *xmax, double *ymin, double *ymax, double *dx, double *dy, float **data) {
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> called\n", __func__);
+    fprintf(stderr, "dbg2  Input arguments:\n");
+    fprintf(stderr, "dbg2       pyramid:     %s\n", pyramid->file);
+    fprintf(stderr, "dbg2       ixmin:       %d\n", ixmin);
+    fprintf(stderr, "dbg2       ixmax:       %d\n", ixmax);
+    fprintf(stderr, "dbg2       jymin:       %d\n", jymin);
+    fprintf(stderr, "dbg2       jymax:       %d\n", jymax);
+  }
+
+  int level;
+  int status = mb_gridpyramid_getlevel(verbose, pyramid, ixmin, ixmax, jymin, jymax, do_mbgrdviz_pyramid_nxymax(), &level,
+                                       &error);
+
+  /* get the nodes of the level covering the region */
+  const int n = 1 << level;
+  const int ixmin_level = ixmin / n;
+  const int ixmax_level = MIN((ixmax + n - 1) / n, pyramid->n_columns[level] - 1);
+  const int jymin_level = jymin / n;
+  const int jymax_level = MIN((jymax + n - 1) / n, pyramid->n_rows[level] - 1);
+  *n_columns = ixmax_level - ixmin_level + 1;
+  *n_rows = jymax_level - jymin_level + 1;
+  *nxy = *n_columns * *n_rows;
+  *dx = pyramid->dx * n;
+  *dy = pyramid->dy * n;
+  *xmin = pyramid->xmin + *dx * ixmin_level;
+  *xmax = pyramid->xmin + *dx * ixmax_level;
+  *ymin = pyramid->ymin + *dy * jymin_level;
+  *ymax = pyramid->ymin + *dy * jymax_level;
+  if (level > 0)
+    fprintf(stderr, "Displaying %d x %d nodes of %s at 1/%d resolution from its grid pyramid\n", *n_columns, *n_rows,
+            pyramid->file, n);
+
+  if (status == MB_SUCCESS)
+    status = mb_mallocd(verbose, __FILE__, __LINE__, sizeof(float) * (*nxy), (void **)data, &error);
+  if (status == MB_SUCCESS) {
+    status = mb_gridpyramid_read(verbose, pyramid, level, ixmin_level, ixmax_level, jymin_level, jymax_level, *data, min,
+                                 max, &error);
+    if (status != MB_SUCCESS)
+      mb_freed(verbose, __FILE__, __LINE__, (void **)data, &error);
+  }
+
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> completed\n", __func__);
+    fprintf(stderr, "dbg2  Return values:\n");
+    fprintf(stderr, "dbg2       level:       %d\n", level);
+    fprintf(stderr, "dbg2       n_columns:   %d\n", *n_columns);
+    fprintf(stderr, "dbg2       n_rows:      %d\n", *n_rows);
+    fprintf(stderr, "dbg2       error:       %d\n", error);
+    fprintf(stderr, "dbg2  Return status:\n");
+    fprintf(stderr, "dbg2       status:      %d\n", status);
+  }
+
+  return (status);
+}
+/*---------------------------------------------------------------------------------------*/
 
 int do_mbgrdviz_openprimary(char *input_file_ptr) {
   int status = MB_SUCCESS;
@@ -1801,12 +1882,47 @@ int do_mbgrdviz_openprimary(char *input_file_ptr) {
                                    mbv_height, mbv_lorez_dimension, mbv_hirez_dimension, mbv_lorez_navdecimate,
                                    mbv_hirez_navdecimate, &error);
 
-    /* read in the grd file */
-    if (status == MB_SUCCESS && input_file_ptr != NULL)
-      status = mb_read_gmt_grd(verbose, input_file_ptr, &mbv_primary_grid_projection_mode, mbv_primary_grid_projection_id,
-                               &mbv_primary_nodatavalue, &mbv_primary_nxy, &mbv_primary_n_columns, &mbv_primary_n_rows,
-                               &mbv_primary_min, &mbv_primary_max, &mbv_primary_xmin, &mbv_primary_xmax, &mbv_primary_ymin,
-                               &mbv_primary_ymax, &mbv_primary_dx, &mbv_primary_dy, &mbv_primary_data, NULL, NULL, &error);
+    /* read in the grd file, from its grid pyramid if that is current */
+    if (status == MB_SUCCESS && input_file_ptr != NULL) {
+      struct mb_gridpyramid_struct *pyramid = NULL;
+      mbview_pyramid_file[instance][0] = '\0';
+      if (mb_gridpyramid_open(verbose, input_file_ptr, &pyramid, &error) != MB_SUCCESS) {
+        error = MB_ERROR_NO_ERROR;
+        status = mb_read_gmt_grd(verbose, input_file_ptr, &mbv_primary_grid_projection_mode, mbv_primary_grid_projection_id,
+                                 &mbv_primary_nodatavalue, &mbv_primary_nxy, &mbv_primary_n_columns, &mbv_primary_n_rows,
+                                 &mbv_primary_min, &mbv_primary_max, &mbv_primary_xmin, &mbv_primary_xmax, &mbv_primary_ymin,
+                                 &mbv_primary_ymax, &mbv_primary_dx, &mbv_primary_dy, &mbv_primary_data, NULL, NULL, &error);
+
+        /* make a grid pyramid for a large grid so that it opens quickly
+            next time, and use it now if the grid does not fit in memory */
+        if (status == MB_SUCCESS && mbv_primary_nxy >= MBGRDVIZ_PYRAMID_NXY_MIN) {
+          int pyramid_error = MB_ERROR_NO_ERROR;
+          if (mb_gridpyramid_write(verbose, input_file_ptr, mbv_primary_grid_projection_mode, mbv_primary_grid_projection_id,
+                                   mbv_primary_nodatavalue, mbv_primary_n_columns, mbv_primary_n_rows, mbv_primary_min,
+                                   mbv_primary_max, mbv_primary_xmin, mbv_primary_xmax, mbv_primary_ymin, mbv_primary_ymax,
+                                   mbv_primary_dx, mbv_primary_dy, mbv_primary_data, &pyramid_error) == MB_SUCCESS)
+            mb_gridpyramid_open(verbose, input_file_ptr, &pyramid, &pyramid_error);
+          if (pyramid != NULL && mbv_primary_nxy > do_mbgrdviz_pyramid_nxymax())
+            mb_freed(verbose, __FILE__, __LINE__, (void **)&mbv_primary_data, &error);
+        }
+      }
+      else {
+        mbv_primary_grid_projection_mode = pyramid->projection_mode;
+        strcpy(mbv_primary_grid_projection_id, pyramid->projection_id);
+        mbv_primary_nodatavalue = pyramid->nodatavalue;
+        mbv_primary_data = NULL;
+      }
+      if (pyramid != NULL) {
+        strcpy(mbview_pyramid_file[instance], input_file_ptr);
+        if (mbv_primary_data == NULL)
+          status = do_mbgrdviz_pyramid_read(pyramid, 0, pyramid->n_columns[0] - 1, 0, pyramid->n_rows[0] - 1,
+                                            &mbv_primary_nxy, &mbv_primary_n_columns, &mbv_primary_n_rows, &mbv_primary_min,
+                                            &mbv_primary_max, &mbv_primary_xmin, &mbv_primary_xmax, &mbv_primary_ymin,
+                                            &mbv_primary_ymax, &mbv_primary_dx, &mbv_primary_dy, &mbv_primary_data);
+        int pyramid_error = MB_ERROR_NO_ERROR;
+        mb_gridpyramid_close(verbose, &pyramid, &pyramid_error);
+      }
+    }
 
     else if (status == MB_SUCCESS)
       status =
@@ -5756,7 +5872,7 @@ void do_mbgrdviz_open_region(Widget w, XtPointer client_data, XtPointer call_dat
   double mbv_primary_ymax;
   double mbv_primary_dx;
   double mbv_primary_dy;
-  float *mbv_primary_data;
+  float *mbv_primary_data = NULL;
   int mbv_secondary_nxy;
   int mbv_secondary_n_columns;
   int mbv_secondary_n_rows;
@@ -5769,6 +5885,7 @@ void do_mbgrdviz_open_region(Widget w, XtPointer client_data, XtPointer call_dat
   double mbv_secondary_dx;
   double mbv_secondary_dy;
   float *mbv_secondary_data;
+  struct mb_gridpyramid_struct *pyramid = NULL;
 
   /* get source mbview instance */
   instance_source = (size_t)client_data;
@@ -5829,42 +5946,72 @@ void do_mbgrdviz_open_region(Widget w, XtPointer client_data, XtPointer call_dat
                                    mbv_height, mbv_lorez_dimension, mbv_hirez_dimension, mbv_lorez_navdecimate,
                                    mbv_hirez_navdecimate, &error);
 
-    /* extract the primary grid from the source */
-    mbv_primary_dx = data_source->primary_dx;
-    mbv_primary_dy = data_source->primary_dy;
-    mbv_primary_xmin = MIN(data_source->region.cornerpoints[0].xgrid, data_source->region.cornerpoints[3].xgrid);
-    mbv_primary_xmax = MAX(data_source->region.cornerpoints[0].xgrid, data_source->region.cornerpoints[3].xgrid);
-    mbv_primary_ymin = MIN(data_source->region.cornerpoints[0].ygrid, data_source->region.cornerpoints[3].ygrid);
-    mbv_primary_ymax = MAX(data_source->region.cornerpoints[0].ygrid, data_source->region.cornerpoints[3].ygrid);
-    ixmin = (mbv_primary_xmin - data_source->primary_xmin) / mbv_primary_dx;
-    ixmax = ((mbv_primary_xmax - data_source->primary_xmin) / mbv_primary_dx) + 1;
-    jymin = (mbv_primary_ymin - data_source->primary_ymin) / mbv_primary_dy;
-    jymax = ((mbv_primary_ymax - data_source->primary_ymin) / mbv_primary_dy) + 1;
-    ixmin = MAX(ixmin, 0);
-    ixmax = MIN(ixmax, data_source->primary_n_columns - 1);
-    jymin = MAX(jymin, 0);
-    jymax = MIN(jymax, data_source->primary_n_rows - 1);
-    mbv_primary_xmin = data_source->primary_xmin + mbv_primary_dx * ixmin;
-    mbv_primary_xmax = data_source->primary_xmin + mbv_primary_dx * ixmax;
-    mbv_primary_ymin = data_source->primary_ymin + mbv_primary_dy * jymin;
-    mbv_primary_ymax = data_source->primary_ymin + mbv_primary_dy * jymax;
-    mbv_primary_n_columns = ixmax - ixmin + 1;
-    mbv_primary_n_rows = jymax - jymin + 1;
-    mbv_primary_nxy = mbv_primary_n_columns * mbv_primary_n_rows;
-    status = mb_mallocd(verbose, __FILE__, __LINE__, sizeof(float) * mbv_primary_nxy, (void **)&mbv_primary_data, &error);
-    mbv_primary_min = data_source->primary_nodatavalue;
-    mbv_primary_max = data_source->primary_nodatavalue;
-    for (i = 0; i < mbv_primary_n_columns; i++) {
-      for (j = 0; j < mbv_primary_n_rows; j++) {
-        k = i * mbv_primary_n_rows + j;
-        ksource = (i + ixmin) * data_source->primary_n_rows + (j + jymin);
-        mbv_primary_data[k] = data_source->primary_data[ksource];
-        if (mbv_primary_data[k] != data_source->primary_nodatavalue) {
-          if (mbv_primary_min == data_source->primary_nodatavalue || mbv_primary_data[k] < mbv_primary_min) {
-            mbv_primary_min = mbv_primary_data[k];
-          }
-          if (mbv_primary_max == data_source->primary_nodatavalue || mbv_primary_data[k] > mbv_primary_max) {
-            mbv_primary_max = mbv_primary_data[k];
+    /* if the source grid has a current grid pyramid then read the region
+        from the finest level at which it fits in memory, so that a region
+        of a decimated view is opened at full resolution where possible */
+    if (mbview_pyramid_file[instance_source][0] != '\0' &&
+        mb_gridpyramid_open(verbose, mbview_pyramid_file[instance_source], &pyramid, &error) == MB_SUCCESS) {
+      mbv_primary_xmin = MIN(data_source->region.cornerpoints[0].xgrid, data_source->region.cornerpoints[3].xgrid);
+      mbv_primary_xmax = MAX(data_source->region.cornerpoints[0].xgrid, data_source->region.cornerpoints[3].xgrid);
+      mbv_primary_ymin = MIN(data_source->region.cornerpoints[0].ygrid, data_source->region.cornerpoints[3].ygrid);
+      mbv_primary_ymax = MAX(data_source->region.cornerpoints[0].ygrid, data_source->region.cornerpoints[3].ygrid);
+      ixmin = MAX((int)floor((mbv_primary_xmin - pyramid->xmin) / pyramid->dx), 0);
+      ixmax = MIN((int)ceil((mbv_primary_xmax - pyramid->xmin) / pyramid->dx), pyramid->n_columns[0] - 1);
+      jymin = MAX((int)floor((mbv_primary_ymin - pyramid->ymin) / pyramid->dy), 0);
+      jymax = MIN((int)ceil((mbv_primary_ymax - pyramid->ymin) / pyramid->dy), pyramid->n_rows[0] - 1);
+      if (ixmin <= ixmax && jymin <= jymax)
+        status = do_mbgrdviz_pyramid_read(pyramid, ixmin, ixmax, jymin, jymax, &mbv_primary_nxy, &mbv_primary_n_columns,
+                                          &mbv_primary_n_rows, &mbv_primary_min, &mbv_primary_max, &mbv_primary_xmin,
+                                          &mbv_primary_xmax, &mbv_primary_ymin, &mbv_primary_ymax, &mbv_primary_dx,
+                                          &mbv_primary_dy, &mbv_primary_data);
+      else
+        status = MB_FAILURE;
+      if (status == MB_SUCCESS)
+        strcpy(mbview_pyramid_file[instance], mbview_pyramid_file[instance_source]);
+      int pyramid_error = MB_ERROR_NO_ERROR;
+      mb_gridpyramid_close(verbose, &pyramid, &pyramid_error);
+    }
+
+    /* else extract the primary grid from the source */
+    else {
+      error = MB_ERROR_NO_ERROR;
+      mbview_pyramid_file[instance][0] = '\0';
+      mbv_primary_dx = data_source->primary_dx;
+      mbv_primary_dy = data_source->primary_dy;
+      mbv_primary_xmin = MIN(data_source->region.cornerpoints[0].xgrid, data_source->region.cornerpoints[3].xgrid);
+      mbv_primary_xmax = MAX(data_source->region.cornerpoints[0].xgrid, data_source->region.cornerpoints[3].xgrid);
+      mbv_primary_ymin = MIN(data_source->region.cornerpoints[0].ygrid, data_source->region.cornerpoints[3].ygrid);
+      mbv_primary_ymax = MAX(data_source->region.cornerpoints[0].ygrid, data_source->region.cornerpoints[3].ygrid);
+      ixmin = (mbv_primary_xmin - data_source->primary_xmin) / mbv_primary_dx;
+      ixmax = ((mbv_primary_xmax - data_source->primary_xmin) / mbv_primary_dx) + 1;
+      jymin = (mbv_primary_ymin - data_source->primary_ymin) / mbv_primary_dy;
+      jymax = ((mbv_primary_ymax - data_source->primary_ymin) / mbv_primary_dy) + 1;
+      ixmin = MAX(ixmin, 0);
+      ixmax = MIN(ixmax, data_source->primary_n_columns - 1);
+      jymin = MAX(jymin, 0);
+      jymax = MIN(jymax, data_source->primary_n_rows - 1);
+      mbv_primary_xmin = data_source->primary_xmin + mbv_primary_dx * ixmin;
+      mbv_primary_xmax = data_source->primary_xmin + mbv_primary_dx * ixmax;
+      mbv_primary_ymin = data_source->primary_ymin + mbv_primary_dy * jymin;
+      mbv_primary_ymax = data_source->primary_ymin + mbv_primary_dy * jymax;
+      mbv_primary_n_columns = ixmax - ixmin + 1;
+      mbv_primary_n_rows = jymax - jymin + 1;
+      mbv_primary_nxy = mbv_primary_n_columns * mbv_primary_n_rows;
+      status = mb_mallocd(verbose, __FILE__, __LINE__, sizeof(float) * mbv_primary_nxy, (void **)&mbv_primary_data, &error);
+      mbv_primary_min = data_source->primary_nodatavalue;
+      mbv_primary_max = data_source->primary_nodatavalue;
+      for (i = 0; i < mbv_primary_n_columns; i++) {
+        for (j = 0; j < mbv_primary_n_rows; j++) {
+          k = i * mbv_primary_n_rows + j;
+          ksource = (i + ixmin) * data_source->primary_n_rows + (j + jymin);
+          mbv_primary_data[k] = data_source->primary_data[ksource];
+          if (mbv_primary_data[k] != data_source->primary_nodatavalue) {
+            if (mbv_primary_min == data_source->primary_nodatavalue || mbv_primary_data[k] < mbv_primary_min) {
+              mbv_primary_min = mbv_primary_data[k];
+            }
+            if (mbv_primary_max == data_source->primary_nodatavalue || mbv_primary_data[k] > mbv_primary_max) {
+              mbv_primary_max = mbv_primary_data[k];
+            }
           }
         }
       }
@@ -619,6 +619,8 @@ int mb_make_info(int verbose, bool force, char *file, int format, int *error) {
 	sprintf(fbtfile, "%s.fbt", file);
 	char fnvfile[MB_PATH_MAXLINE];
 	sprintf(fnvfile, "%s.fnv", file);
+	char idxfile[MB_PATH_MAXLINE];
+	sprintf(idxfile, "%s.idx", file);
 
 	int fstat;
 	struct stat file_status;
@@ -639,47 +641,31 @@ int mb_make_info(int verbose, bool force, char *file, int format, int *error) {
 		fnvmodtime = file_status.st_mtime;
 	}
 
+	int idxmodtime = 0;
+	if ((fstat = stat(idxfile, &file_status)) == 0 && (file_status.st_mode & S_IFMT) != S_IFDIR && file_status.st_size > 0) {
+		idxmodtime = file_status.st_mtime;
+	}
+
 	int status = MB_SUCCESS;
 	int shellstatus = 0;
 
-	/* make new inf file if not there or out of date */
-	if (force || (datmodtime > 0 && datmodtime > infmodtime)) {
+	/* make new inf, idx, fbt and fnv files if any are not there or out of
+	    date - a single mbinfo pass through the data generates all of them */
+	const bool make_fbt = mb_should_make_fbt(verbose, format);
+	const bool make_fnv = mb_should_make_fnv(verbose, format);
+	if (force || (datmodtime > 0 && (datmodtime > infmodtime || datmodtime > idxmodtime
+	                                 || (make_fbt && datmodtime > fbtmodtime)
+	                                 || (make_fnv && datmodtime > fnvmodtime)))) {
 		if (verbose >= 1)
-			fprintf(stderr, "\nGenerating inf file for %s\n", file);
+			fprintf(stderr, "\nGenerating inf%s%s files for %s\n", make_fbt ? " fbt" : "", make_fnv ? " fnv" : "", file);
 		char command[MB_PATH_MAXLINE];
-		sprintf(command, "mbinfo -F %d -I %s -G -N -O -M10/10", format, file);
+		sprintf(command, "mbinfo -F %d -I %s -G -K -N -O -Y -M10/10", format, file);
 		if (verbose >= 2)
 			fprintf(stderr, "\t%s\n", command);
 		if ((shellstatus = system(command)) != 0)
       status = MB_FAILURE;
 	}
 
-	/* make new fbt file if not there or out of date */
-	if ((force || (datmodtime > 0 && datmodtime > fbtmodtime)) && mb_should_make_fbt(verbose, format)) {
-		if (verbose >= 1)
-			fprintf(stderr, "Generating fbt file for %s\n", file);
-		  char command[MB_PATH_MAXLINE];
-		  sprintf(command, "mbcopy -F %d/71 -I %s -D -O %s.fbt", format, file, file);
-		  if ((shellstatus = system(command)) != 0)
-        status = MB_FAILURE;
-	}
-
-	/* make new fnv file if not there or out of date */
-	if ((force || (datmodtime > 0 && datmodtime > fnvmodtime)) && mb_should_make_fnv(verbose, format)) {
-		if (verbose >= 1)
-			fprintf(stderr, "Generating fnv file for %s\n", file);
-	  char command[MB_PATH_MAXLINE];
-    sprintf(command,  "echo \"## <yyyy mm dd hh mm ss.ssssss> <epoch seconds> "
-                      "<longitude (deg)> <latitude (deg)> <heading (deg)> <speed (km/hr)> "
-                      "<draft (m)> <roll (deg)> <pitch (deg)> <heave (m)> <portlon (deg)> "
-                      "<portlat (deg)> <stbdlon (deg)> <stbdlat (deg)>\"  > %s.fnv", file);
-	  if ((shellstatus = system(command)) != 0)
-      status = MB_FAILURE;
-	  sprintf(command, "mblist -F %d -I %s -O tMXYHScRPr=X=Y+X+Y -UN >> %s.fnv", format, file, file);
-	  if ((shellstatus = system(command)) != 0)
-      status = MB_FAILURE;
-	}
-
 	if (verbose >= 2) {
 		fprintf(stderr, "\ndbg2  MBIO function <%s> completed\n", __func__);
 		fprintf(stderr, "dbg2  Return values:\n");
@@ -57,8 +57,17 @@ int mb_close(int verbose, void **mbio_ptr, int *error) {
   /* get pointer to mbio descriptor */
   struct mb_io_struct *mb_io_ptr = (struct mb_io_struct *)*mbio_ptr;
 
+  /* stop reading ahead before the format and files are released */
+  int status = mb_readahead_close(verbose, *mbio_ptr, error);
+
+  /* write a sidecar index if one was built, then release the index while
+      any format private index data is still allocated */
+  if (mb_io_ptr->index_build != NULL)
+    mb_index_write(verbose, *mbio_ptr, error);
+  mb_index_free(verbose, *mbio_ptr, error);
+
   /* deallocate format dependent structures */
-  int status = (*mb_io_ptr->mb_io_format_free)(verbose, *mbio_ptr, error);
+  status = (*mb_io_ptr->mb_io_format_free)(verbose, *mbio_ptr, error);
 
   /* deallocate system dependent structures */
   /*status = (*mb_io_ptr->mb_io_store_free)
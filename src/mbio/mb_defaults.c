@@ -604,3 +604,46 @@ int mb_fileiobuffer(int verbose, int *fileiobuffer) {
   return (status);
 }
 /*--------------------------------------------------------------------*/
+int mb_readahead(int verbose, int *readahead) {
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> called\n", __func__);
+    fprintf(stderr, "dbg2  Input arguments:\n");
+    fprintf(stderr, "dbg2       verbose: %d\n", verbose);
+  }
+
+  /* set system default values */
+  *readahead = 0;
+
+  /* set the filename */
+  const char *home_ptr = getenv(HOME);
+  if (home_ptr != NULL) {
+    char file[MB_PATH_MAXLINE];
+    strcpy(file, home_ptr);
+    strcat(file, "/.mbio_defaults");
+
+    /* open and read values from file if possible */
+    FILE *fp = fopen(file, "r");
+    if (fp != NULL) {
+      char string[MB_PATH_MAXLINE];
+      while (fgets(string, sizeof(string), fp) != NULL) {
+        if (strncmp(string, "readahead:", 10) == 0)
+          sscanf(string, "readahead:%d", readahead);
+      }
+      fclose(fp);
+    }
+  }
+
+  /* successful no matter what happens */
+  const int status = MB_SUCCESS;
+
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> completed\n", __func__);
+    fprintf(stderr, "dbg2  Return values:\n");
+    fprintf(stderr, "dbg2       readahead:    %d\n", *readahead);
+    fprintf(stderr, "dbg2  Return status:\n");
+    fprintf(stderr, "dbg2       status:       %d\n", status);
+  }
+
+  return (status);
+}
+/*--------------------------------------------------------------------*/
@@ -296,6 +296,7 @@ int mb_mbview_defaults(int verbose, int *primary_colortable, int *primary_colort
 int mb_fbtversion(int verbose, int *fbtversion);
 int mb_uselockfiles(int verbose, bool *uselockfiles);
 int mb_fileiobuffer(int verbose, int *fileiobuffer);
+int mb_readahead(int verbose, int *readahead);
 int mb_format_register(int verbose, int *format, void *mbio_ptr, int *error);
 int mb_format_info(int verbose, int *format, int *system, int *beams_bath_max, int *beams_amp_max, int *pixels_ss_max,
                    char *format_name, char *system_name, char *format_description, int *numfile, int *filetype,
@@ -396,7 +397,20 @@ int mb_put_comment(int verbose, void *mbio_ptr, char *comment, int *error);
 int mb_fileio_open(int verbose, void *mbio_ptr, int *error);
 int mb_fileio_close(int verbose, void *mbio_ptr, int *error);
 int mb_fileio_get(int verbose, void *mbio_ptr, char *buffer, size_t *size, int *error);
+int mb_fileio_getptr(int verbose, void *mbio_ptr, char *buffer, char **data, size_t *size, int *error);
+int mb_fileio_seek(int verbose, void *mbio_ptr, long offset, int whence, int *error);
+int mb_fileio_tell(int verbose, void *mbio_ptr, long *offset, int *error);
 int mb_fileio_put(int verbose, void *mbio_ptr, char *buffer, size_t *size, int *error);
+int mb_readahead_init(int verbose, void *mbio_ptr, int nrecord, int *error);
+int mb_readahead_read_ping(int verbose, void *mbio_ptr, void *store_ptr, int *error);
+int mb_readahead_close(int verbose, void *mbio_ptr, int *error);
+int mb_index_build(int verbose, void *mbio_ptr, int *error);
+int mb_index_add(int verbose, void *mbio_ptr, int kind, double time_d, double navlon, double navlat, int *error);
+int mb_index_write(int verbose, void *mbio_ptr, int *error);
+int mb_index_read(int verbose, void *mbio_ptr, int *error);
+int mb_index_seek(int verbose, void *mbio_ptr, int *error);
+int mb_index_get_blob(int verbose, void *mbio_ptr, void **blob, size_t *blob_size, int *error);
+int mb_index_free(int verbose, void *mbio_ptr, int *error);
 int mb_copyfile(int verbose, const char *src, const char *dst, int *error);
 int mb_catfiles(int verbose, const char *src1, const char *src2, const char *dst, int *error);
 int mb_alloc(int verbose, void *mbio_ptr, void **store_ptr, int *error);
@@ -682,6 +696,8 @@ int mb_proj_init(int verbose, char *projection, void **pjptr, int *error);
 int mb_proj_free(int verbose, void **pjptr, int *error);
 int mb_proj_forward(int verbose, void *pjptr, double lon, double lat, double *easting, double *northing, int *error);
 int mb_proj_inverse(int verbose, void *pjptr, double easting, double northing, double *lon, double *lat, int *error);
+int mb_proj_clone(int verbose, void *pjptr, void **ctxptr, void **cloneptr, int *error);
+int mb_proj_clone_free(int verbose, void **ctxptr, void **cloneptr, int *error);
 int mb_geod_init(int verbose, double radius_equatorial, double flattening, void **g_ptr, int *error);
 int mb_geod_free(int verbose, void **g_ptr, int *error);
 int mb_geod_inverse(int verbose, void *g_ptr,
@@ -713,6 +729,13 @@ int mb_rt(int verbose, void *modelptr, double source_depth, double source_angle,
           double surface_vel, double null_angle, int nplot_max,
           int *nplot, double *xplot, double *zplot, double *tplot,
           double *x, double *z, double *travel_time, int *ray_stat, int *error);
+int mb_rt_table_init(int verbose, void *modelptr, double angle_max, double angle_interval, double ttime_max,
+                     double ttime_interval, double depth_interval, double error_bound, void **tableptr, int *error);
+int mb_rt_table_deall(int verbose, void **tableptr, int *error);
+int mb_rt_table(int verbose, void *tableptr, int nray, double *source_depth, double *source_angle, double *end_time,
+                int ssv_mode, double surface_vel, double *null_angle, double *x, double *z, double *travel_time,
+                int *ray_stat, int *error);
+int mb_rt_table_stats(int verbose, void *tableptr, int *nbin, long *ninterpolated, long *nexact, int *error);
 
 #ifdef __cplusplus
 }  /* extern "C" */
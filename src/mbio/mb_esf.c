@@ -122,6 +122,11 @@ int mb_esf_load(int verbose, const char *program_name, char *swathfile, bool loa
 	esf->esffp = NULL;
 	esf->essfp = NULL;
 	esf->startnextsearch = 0;
+	esf->nbucket = 0;
+	esf->bucket = NULL;
+	esf->bucket_next = NULL;
+	esf->nmatch_alloc = 0;
+	esf->match = NULL;
 
 	/* get name of existing or new esffile, then load old edits
 	    and/or open new esf file */
@@ -196,6 +201,11 @@ int mb_esf_open(int verbose, const char *program_name, char *esffile, bool load,
 	esf->esffp = NULL;
 	esf->essfp = NULL;
 	esf->startnextsearch = 0;
+	esf->nbucket = 0;
+	esf->bucket = NULL;
+	esf->bucket_next = NULL;
+	esf->nmatch_alloc = 0;
+	esf->match = NULL;
 
 	/* load edits from existing esf file if requested */
 	if (load) {
@@ -239,7 +249,12 @@ int mb_esf_open(int verbose, const char *program_name, char *esffile, bool load,
 
 				/* read file header to discern the format */
 				if (fread(esf_header, MB_PATH_MAXLINE, 1, esffp) == 1) {
-					if (strncmp(esf_header, "ESFVERSION03", 12) == 0) {
+					if (strncmp(esf_header, "ESFVERSION04", 12) == 0) {
+						esf->version = 4;
+						esf->nedit -= MB_PATH_MAXLINE / (sizeof(double) + 2 * sizeof(int));
+						sscanf(&esf_header[13], "ESF Mode: %d", &esf->mode);
+					}
+					else if (strncmp(esf_header, "ESFVERSION03", 12) == 0) {
 						esf->version = 3;
 						esf->nedit -= MB_PATH_MAXLINE / (sizeof(double) + 2 * sizeof(int));
 						sscanf(&esf_header[13], "ESF Mode: %d", &esf->mode);
@@ -316,6 +331,17 @@ int mb_esf_open(int verbose, const char *program_name, char *esffile, bool load,
 				fprintf(stderr,"EDITS SORTED: i:%d edit: %f %d %d  use:%d\n",
 				i,esf->edit[i].time_d,esf->edit[i].beam,
 				esf->edit[i].action,esf->edit[i].use); */
+
+				/* collapse edits superseded by later edits of the same beam */
+				if (esf->nedit > 1) {
+					const int nedit_old = esf->nedit;
+					mb_esf_compact(verbose, esf, error);
+					if (verbose > 0 && esf->nedit < nedit_old)
+						fprintf(stderr, "Compacted %d old edits to %d...\n", nedit_old, esf->nedit);
+				}
+
+				/* index the edits by ping time */
+				status = mb_esf_index(verbose, esf, error);
 			}
 		}
 	}
@@ -350,6 +376,8 @@ int mb_esf_open(int verbose, const char *program_name, char *esffile, bool load,
 			*error = MB_ERROR_OPEN_FAIL;
 			fprintf(stderr,"Failed to open esffile %s with file mode %s\n", esf->esffile, fmode);
 		}
+		else
+			setvbuf(esf->esffp, NULL, _IOFBF, MB_ESF_BUFFER_SIZE);
 		//else
 		//	fprintf(stderr,"esffile %s opened with file mode %s\n", esf->esffile, fmode);
 
@@ -360,6 +388,8 @@ int mb_esf_open(int verbose, const char *program_name, char *esffile, bool load,
 				*error = MB_ERROR_OPEN_FAIL;
 				fprintf(stderr,"Failed to open esstream %s with file mode %s\n", esf->esstream, fmode);
 			}
+			else
+				setvbuf(esf->essfp, NULL, _IOFBF, MB_ESF_BUFFER_SIZE);
 			//else
 			//	fprintf(stderr,"esstream %s opened with file mode %s\n", esf->esstream, fmode);
 		}
@@ -407,6 +437,196 @@ int mb_esf_open(int verbose, const char *program_name, char *esffile, bool load,
 	return (status);
 }
 
+/*--------------------------------------------------------------------*/
+/* 	function mb_esf_compact collapses edit events that are superseded
+        by later events for the same beam of the same ping. The edits
+        must already be sorted so that all of the events for a beam in
+        a ping are adjacent and in the order they were made. Once a beam
+        is zeroed later events are ignored, an unflag undoes all of the
+        events before it, and repeating a flagging action changes
+        nothing, so the compacted edits set the same beamflags as the
+        originals. */
+int mb_esf_compact(int verbose, struct mb_esf_struct *esf, int *error) {
+	if (verbose >= 2) {
+		fprintf(stderr, "\ndbg2  MBIO function <%s> called\n", __func__);
+		fprintf(stderr, "dbg2  Input arguments:\n");
+		fprintf(stderr, "dbg2       verbose:          %d\n", verbose);
+		fprintf(stderr, "dbg2       esf:              %p\n", (void *)esf);
+		fprintf(stderr, "dbg2       nedit:            %d\n", esf->nedit);
+	}
+
+	int nedit = 0;
+	int first = 0;
+	while (first < esf->nedit) {
+		/* get the events for this beam */
+		int last = first;
+		while (last + 1 < esf->nedit && esf->edit[last + 1].time_d == esf->edit[first].time_d &&
+		       esf->edit[last + 1].beam == esf->edit[first].beam)
+			last++;
+
+		/* find the first zero and the last unflag */
+		int zero = -1;
+		int unflag = -1;
+		bool unknown = false;
+		for (int j = first; j <= last; j++) {
+			if (esf->edit[j].action == MBP_EDIT_ZERO) {
+				if (zero < 0)
+					zero = j;
+			}
+			else if (esf->edit[j].action == MBP_EDIT_UNFLAG) {
+				unflag = j;
+			}
+			else if (esf->edit[j].action != MBP_EDIT_FLAG && esf->edit[j].action != MBP_EDIT_FILTER &&
+			         esf->edit[j].action != MBP_EDIT_SONAR) {
+				unknown = true;
+			}
+		}
+
+		/* keep the events that still matter */
+		for (int j = first; j <= last; j++) {
+			bool keep;
+			if (unknown)
+				keep = true;
+			else if (zero >= 0)
+				keep = (j == zero);
+			else if (esf->edit[j].action == MBP_EDIT_UNFLAG)
+				keep = (j == unflag);
+			else {
+				keep = (j > unflag);
+				for (int k = j + 1; k <= last && keep; k++) {
+					if (esf->edit[k].action == esf->edit[j].action)
+						keep = false;
+				}
+			}
+			if (keep) {
+				esf->edit[nedit] = esf->edit[j];
+				nedit++;
+			}
+		}
+
+		first = last + 1;
+	}
+
+	int status = MB_SUCCESS;
+
+	/* any index no longer matches the edits */
+	if (nedit < esf->nedit) {
+		esf->nedit = nedit;
+		esf->startnextsearch = 0;
+		if (esf->bucket != NULL)
+			status = mb_esf_index(verbose, esf, error);
+	}
+
+	if (verbose >= 2) {
+		fprintf(stderr, "\ndbg2  MBIO function <%s> completed\n", __func__);
+		fprintf(stderr, "dbg2  Return value:\n");
+		fprintf(stderr, "dbg2       nedit:       %d\n", esf->nedit);
+		for (int i = 0; i < esf->nedit; i++)
+			fprintf(stderr, "dbg2       edit event:  %d %.6f %5d %3d %3d\n", i, esf->edit[i].time_d, esf->edit[i].beam,
+			        esf->edit[i].action, esf->edit[i].use);
+		fprintf(stderr, "dbg2       error:       %d\n", *error);
+		fprintf(stderr, "dbg2  Return status:\n");
+		fprintf(stderr, "dbg2       status:      %d\n", status);
+	}
+
+	return (status);
+}
+
+/*--------------------------------------------------------------------*/
+/* 	function mb_esf_bucket returns the slot of the index hash table
+        holding the edits in the time bucket key, or the empty slot
+        where that bucket belongs. */
+static int mb_esf_bucket(struct mb_esf_struct *esf, long key) {
+	int slot = (int)(((unsigned long)key * 2654435761UL) & (unsigned long)(esf->nbucket - 1));
+	while (esf->bucket[slot].first >= 0 && esf->bucket[slot].key != key)
+		slot = (slot + 1) & (esf->nbucket - 1);
+	return (slot);
+}
+
+/*--------------------------------------------------------------------*/
+/* 	function mb_esf_index builds a hash table of the edits keyed by
+        ping time in MB_ESF_INDEX_BUCKET second buckets, each bucket
+        listing its edits in order, so that mb_esf_apply() finds the
+        edits for a ping without searching the edit list. A NULL index
+        is built again when next needed. */
+int mb_esf_index(int verbose, struct mb_esf_struct *esf, int *error) {
+	if (verbose >= 2) {
+		fprintf(stderr, "\ndbg2  MBIO function <%s> called\n", __func__);
+		fprintf(stderr, "dbg2  Input arguments:\n");
+		fprintf(stderr, "dbg2       verbose:          %d\n", verbose);
+		fprintf(stderr, "dbg2       esf:              %p\n", (void *)esf);
+		fprintf(stderr, "dbg2       nedit:            %d\n", esf->nedit);
+	}
+
+	int status = MB_SUCCESS;
+
+	/* release any old index */
+	if (esf->bucket != NULL)
+		mb_freed(verbose, __FILE__, __LINE__, (void **)&(esf->bucket), error);
+	if (esf->bucket_next != NULL)
+		mb_freed(verbose, __FILE__, __LINE__, (void **)&(esf->bucket_next), error);
+	esf->nbucket = 0;
+
+	if (esf->nedit > 0) {
+		/* size the hash table to keep it at most half full - the number of
+		    runs of edits in the same bucket is at least the number of buckets */
+		long key = (long)floor(esf->edit[0].time_d / MB_ESF_INDEX_BUCKET);
+		int nrun = 1;
+		for (int j = 1; j < esf->nedit; j++) {
+			const long keyj = (long)floor(esf->edit[j].time_d / MB_ESF_INDEX_BUCKET);
+			if (keyj != key)
+				nrun++;
+			key = keyj;
+		}
+		int nbucket = 16;
+		while (nbucket < 2 * nrun)
+			nbucket *= 2;
+
+		status = mb_mallocd(verbose, __FILE__, __LINE__, nbucket * sizeof(struct mb_esf_bucket_struct),
+		                    (void **)&(esf->bucket), error);
+		if (status == MB_SUCCESS)
+			status = mb_mallocd(verbose, __FILE__, __LINE__, esf->nedit * sizeof(int), (void **)&(esf->bucket_next), error);
+		if (status != MB_SUCCESS) {
+			if (esf->bucket != NULL)
+				mb_freed(verbose, __FILE__, __LINE__, (void **)&(esf->bucket), error);
+			*error = MB_ERROR_MEMORY_FAIL;
+			fprintf(stderr, "\nUnable to allocate memory to index %d edit events\n", esf->nedit);
+		}
+		else {
+			esf->nbucket = nbucket;
+			for (int i = 0; i < nbucket; i++) {
+				esf->bucket[i].key = 0;
+				esf->bucket[i].first = -1;
+				esf->bucket[i].last = -1;
+			}
+			for (int j = 0; j < esf->nedit; j++) {
+				key = (long)floor(esf->edit[j].time_d / MB_ESF_INDEX_BUCKET);
+				const int slot = mb_esf_bucket(esf, key);
+				esf->bucket_next[j] = -1;
+				if (esf->bucket[slot].first < 0) {
+					esf->bucket[slot].key = key;
+					esf->bucket[slot].first = j;
+				}
+				else {
+					esf->bucket_next[esf->bucket[slot].last] = j;
+				}
+				esf->bucket[slot].last = j;
+			}
+		}
+	}
+
+	if (verbose >= 2) {
+		fprintf(stderr, "\ndbg2  MBIO function <%s> completed\n", __func__);
+		fprintf(stderr, "dbg2  Return value:\n");
+		fprintf(stderr, "dbg2       nbucket:     %d\n", esf->nbucket);
+		fprintf(stderr, "dbg2       error:       %d\n", *error);
+		fprintf(stderr, "dbg2  Return status:\n");
+		fprintf(stderr, "dbg2       status:      %d\n", status);
+	}
+
+	return (status);
+}
+
 /*--------------------------------------------------------------------*/
 /* 	function mb_esf_fixtimestamps fixes timestamps of all edits
         in esf that are within tolerance of time_d - those timestamps
@@ -431,12 +651,22 @@ int mb_esf_fixtimestamps(int verbose, struct mb_esf_struct *esf, double time_d,
 
 	/* all edits that have timestamps within tolerance of time_d will have
 	their timestamps set to time_d */
+	bool changed = false;
 	for (int j = 0; j < esf->nedit; j++) {
-		if (fabs(esf->edit[j].time_d - time_d) < tolerance) {
+		if (fabs(esf->edit[j].time_d - time_d) < tolerance && esf->edit[j].time_d != time_d) {
 			esf->edit[j].time_d = time_d;
+			changed = true;
 		}
 	}
 
+	/* the edits may have moved between time buckets, so rebuild the
+	    index when it is next needed */
+	if (changed && esf->bucket != NULL) {
+		mb_freed(verbose, __FILE__, __LINE__, (void **)&(esf->bucket), error);
+		mb_freed(verbose, __FILE__, __LINE__, (void **)&(esf->bucket_next), error);
+		esf->nbucket = 0;
+	}
+
 	if (verbose >= 2) {
 		fprintf(stderr, "\ndbg2  MBIO function <%s> completed\n", __func__);
 		fprintf(stderr, "dbg2  Return value:\n");
@@ -458,7 +688,7 @@ int mb_esf_fixtimestamps(int verbose, struct mb_esf_struct *esf, double time_d,
     are saved to that file.  */
 int mb_esf_apply(int verbose, struct mb_esf_struct *esf, double time_d, int pingmultiplicity, int nbath, char *beamflag,
                  int *error) {
-	int firstedit, lastedit;
+	int nmatch;
 	int action;
 	int beamoffset, beamoffsetmax;
 	char beamflagorg;
@@ -497,47 +727,79 @@ int mb_esf_apply(int verbose, struct mb_esf_struct *esf, double time_d, int ping
 	else
 		maxtimediff = MB_ESF_MAXTIMEDIFF;
 
-	/* find first and last edits for this ping - take ping multiplicity into account */
-	if (esf->nedit > 0 && esf->startnextsearch > 0
-		&& time_d < (esf->edit[esf->startnextsearch].time_d - maxtimediff)
-			&& time_d < (esf->edit[esf->startnextsearch - 1].time_d - maxtimediff))
-		firstedit = 0;
-	else if (esf->nedit > 0 && esf->startnextsearch > 0
-		&& fabs(time_d - esf->edit[esf->startnextsearch - 1].time_d) <= maxtimediff
-		&& (esf->edit[esf->startnextsearch - 1].beam < beamoffset
-				|| esf->edit[esf->startnextsearch-1].beam > beamoffsetmax))
-		firstedit = 0;
-	else
-		firstedit = esf->startnextsearch;
-	lastedit = firstedit - 1;
-	for (j = firstedit; j < esf->nedit && time_d >= (esf->edit[j].time_d - maxtimediff); j++) {
-		if (fabs(esf->edit[j].time_d - time_d) < maxtimediff && esf->edit[j].beam >= beamoffset &&
-		    esf->edit[j].beam < beamoffsetmax) {
-			if (lastedit < firstedit)
-				firstedit = j;
-			lastedit = j;
+	/* (re)build the index if needed */
+	if (esf->nedit > 0 && esf->bucket == NULL)
+		mb_esf_index(verbose, esf, error);
+
+	/* find the edits for this ping in the time buckets that the ping
+	    time could match - take ping multiplicity into account */
+	nmatch = 0;
+	const long key0 = (long)floor((time_d - maxtimediff) / MB_ESF_INDEX_BUCKET);
+	const long key1 = (long)floor((time_d + maxtimediff) / MB_ESF_INDEX_BUCKET);
+	for (long key = key0; key <= key1 && esf->nbucket > 0; key++) {
+		const int slot = mb_esf_bucket(esf, key);
+		for (j = esf->bucket[slot].first; j >= 0; j = esf->bucket_next[j]) {
+			if (fabs(esf->edit[j].time_d - time_d) < maxtimediff && esf->edit[j].beam >= beamoffset &&
+			    esf->edit[j].beam < beamoffsetmax) {
+				if (nmatch >= esf->nmatch_alloc) {
+					esf->nmatch_alloc = MAX(2 * esf->nmatch_alloc, 1024);
+					if (mb_reallocd(verbose, __FILE__, __LINE__, esf->nmatch_alloc * sizeof(int), (void **)&(esf->match),
+					                error) != MB_SUCCESS) {
+						esf->nmatch_alloc = 0;
+						nmatch = 0;
+						break;
+					}
+				}
+				esf->match[nmatch] = j;
+				nmatch++;
+			}
 		}
 	}
 
+	/* edits from two buckets are put back in the order they were made */
+	for (int m = 1; m < nmatch; m++) {
+		const int jm = esf->match[m];
+		int k = m - 1;
+		for (; k >= 0 && esf->match[k] > jm; k--)
+			esf->match[k + 1] = esf->match[k];
+		esf->match[k + 1] = jm;
+	}
+
 	/* apply edits */
-	if (lastedit >= firstedit) {
-		/* check for edits with bad beam numbers */
-		for (j = firstedit; j <= lastedit; j++) {
+	if (nmatch > 0) {
+		/* check for edits with bad beam numbers, and whether the edits
+		    are in beam order as they are when loaded from an esf file */
+		bool beamorder = true;
+		for (int m = 0; m < nmatch; m++) {
+			j = esf->match[m];
 			if ((esf->edit[j].beam % MB_ESF_MULTIPLICITY_FACTOR) >= nbath)
 				esf->edit[j].use += 10000;
+			if (m > 0 && esf->edit[j].beam < esf->edit[esf->match[m - 1]].beam)
+				beamorder = false;
 		}
 
 		bool apply;
+		int mstart = 0;
 
 		/* loop over all beams */
 		for (int i = 0; i < nbath; i++) {
 			/* apply beam offset for cases of multiple pings */
 			ibeam = i + beamoffset;
 
+			/* in beam order only the edits for this beam need be checked */
+			if (beamorder) {
+				while (mstart < nmatch && esf->edit[esf->match[mstart]].beam < ibeam)
+					mstart++;
+			}
+
 			/* loop over all edits for this ping */
 			apply = false;
 			beamflagorg = beamflag[i];
-			for (j = firstedit; j <= lastedit; j++) {
+			for (int m = mstart; m < nmatch; m++) {
+				j = esf->match[m];
+				if (beamorder && esf->edit[j].beam > ibeam)
+					break;
+
 				/* apply the edits for this beam in the
 				   order they were created so that the last
 				   edit event is applied last - only the
@@ -631,7 +893,7 @@ int mb_esf_apply(int verbose, struct mb_esf_struct *esf, double time_d, int ping
 		}
 
 		/* reset startnextsearch */
-		esf->startnextsearch = lastedit + 1;
+		esf->startnextsearch = esf->match[nmatch - 1] + 1;
 		if (esf->startnextsearch >= esf->nedit)
 			esf->startnextsearch = esf->nedit - 1;
 	}
@@ -795,6 +1057,14 @@ int mb_esf_close(int verbose, struct mb_esf_struct *esf, int *error) {
 	if (esf->edit != NULL)
 		status = mb_freed(verbose, __FILE__, __LINE__, (void **)&(esf->edit), error);
 	esf->nedit = 0;
+	if (esf->bucket != NULL)
+		mb_freed(verbose, __FILE__, __LINE__, (void **)&(esf->bucket), error);
+	if (esf->bucket_next != NULL)
+		mb_freed(verbose, __FILE__, __LINE__, (void **)&(esf->bucket_next), error);
+	esf->nbucket = 0;
+	if (esf->match != NULL)
+		mb_freed(verbose, __FILE__, __LINE__, (void **)&(esf->match), error);
+	esf->nmatch_alloc = 0;
 
 	/* close the esf file */
 	if (esf->esffp != NULL) {
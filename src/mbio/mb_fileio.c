@@ -31,8 +31,19 @@
  *   mb_fileio_open  - initialize i/o, called by mb_read_init() and mb_write_init()
  *   mb_fileio_close  - cleanup i/o, called by mb_close()
  *   mb_fileio_get  - get bytes from input
+ *   mb_fileio_getptr  - get a pointer to bytes from input, without copying if possible
+ *   mb_fileio_seek  - set the input or output position
+ *   mb_fileio_tell  - get the input or output position
  *   mb_fileio_put  - put bytes to output
  *
+ * Input files are memory mapped when the fileiobuffer default (set with
+ * mbdefaults) is negative and the format has set mb_io_ptr->file_mmap_ok
+ * in its register function. Such formats must position and read the file
+ * only through mb_fileio_seek(), mb_fileio_tell(), mb_fileio_get() and
+ * mb_fileio_getptr(), never through mb_io_ptr->mbfp directly. The stdio
+ * file stays open alongside the map so that mb_io_ptr->mbfp != NULL still
+ * distinguishes file input from socket input.
+ *
  * Author:  D. W. Caress
  * Date:  23 May 2012
  */
@@ -40,11 +51,48 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#ifndef WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 #include "mb_define.h"
 #include "mb_io.h"
 #include "mb_status.h"
 
+/*--------------------------------------------------------------------*/
+/* map the open input file into memory, returning MB_FAILURE without
+   setting an error if the file cannot be mapped so that stdio is used */
+static int mb_fileio_mmap(int verbose, struct mb_io_struct *mb_io_ptr) {
+  int status = MB_FAILURE;
+
+#ifndef WIN32
+  const int fd = fileno(mb_io_ptr->mbfp);
+  struct stat file_status;
+  if (fstat(fd, &file_status) == 0 && S_ISREG(file_status.st_mode) && file_status.st_size > 0) {
+    void *map = mmap(NULL, (size_t)file_status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map != MAP_FAILED) {
+      /* the file is read front to back, so ask for aggressive readahead
+         and early release of the pages already read */
+      posix_madvise(map, (size_t)file_status.st_size, POSIX_MADV_SEQUENTIAL);
+      posix_madvise(map, (size_t)file_status.st_size, POSIX_MADV_WILLNEED);
+      mb_io_ptr->file_mmap = (char *)map;
+      mb_io_ptr->file_mmap_size = (size_t)file_status.st_size;
+      mb_io_ptr->file_mmap_pos = 0;
+      status = MB_SUCCESS;
+    }
+  }
+#endif
+
+  if (verbose >= 4) {
+    fprintf(stderr, "dbg4  Input file memory mapped in MBIO function <%s>\n", __func__);
+    fprintf(stderr, "dbg4       file_mmap:      %p\n", (void *)mb_io_ptr->file_mmap);
+    fprintf(stderr, "dbg4       file_mmap_size: %zu\n", mb_io_ptr->file_mmap_size);
+    fprintf(stderr, "dbg4       status:         %d\n", status);
+  }
+
+  return (status);
+}
 /*--------------------------------------------------------------------*/
 int mb_fileio_open(int verbose, void *mbio_ptr, int *error) {
   if (verbose >= 2) {
@@ -88,7 +136,14 @@ int mb_fileio_open(int verbose, void *mbio_ptr, int *error) {
   int fileiobuffer;
   if (status == MB_SUCCESS) {
     mb_fileiobuffer(verbose, &fileiobuffer);
-    if (fileiobuffer > 0) {
+
+    /* memory map input files for formats that read only through these
+       functions - other formats and output files use standard buffering */
+    if (fileiobuffer < 0) {
+      if (mb_io_ptr->filemode == MB_FILEMODE_READ && mb_io_ptr->file_mmap_ok)
+        mb_fileio_mmap(verbose, mb_io_ptr);
+    }
+    else if (fileiobuffer > 0) {
       /* the buffer size must be a multiple of 512, plus 8 to be efficient */
       const size_t fileiobufferbytes = (fileiobuffer * 1024) + 8;
 
@@ -125,12 +180,24 @@ int mb_fileio_close(int verbose, void *mbio_ptr, int *error) {
 
   struct mb_io_struct *mb_io_ptr = (struct mb_io_struct *)mbio_ptr;
 
+#ifndef WIN32
+  if (mb_io_ptr->file_mmap != NULL) {
+    munmap(mb_io_ptr->file_mmap, mb_io_ptr->file_mmap_size);
+    mb_io_ptr->file_mmap = NULL;
+    mb_io_ptr->file_mmap_size = 0;
+    mb_io_ptr->file_mmap_pos = 0;
+  }
+#endif
+
   if (mb_io_ptr->mbfp != NULL) {
     fclose(mb_io_ptr->mbfp);
     mb_io_ptr->mbfp = NULL;
   }
 
-  const int status = MB_SUCCESS;
+  /* the setvbuf() buffer can only be released once the file is closed */
+  int status = MB_SUCCESS;
+  if (mb_io_ptr->file_iobuffer != NULL)
+    status = mb_freed(verbose, __FILE__, __LINE__, (void **)&mb_io_ptr->file_iobuffer, error);
 
   if (verbose >= 2) {
     fprintf(stderr, "\ndbg2  MBIO function <%s> completed\n", __func__);
@@ -159,7 +226,21 @@ int mb_fileio_get(int verbose, void *mbio_ptr, char *buffer, size_t *size, int *
   int status = MB_SUCCESS;
 
   size_t read_len = 0;
-  if (mb_io_ptr->mbfp != NULL) {
+  if (mb_io_ptr->file_mmap != NULL) {
+      /* copy expected number of bytes from the file map into buffer */
+      read_len = MIN(*size, mb_io_ptr->file_mmap_size - mb_io_ptr->file_mmap_pos);
+      memcpy(buffer, &mb_io_ptr->file_mmap[mb_io_ptr->file_mmap_pos], read_len);
+      mb_io_ptr->file_mmap_pos += read_len;
+      if (read_len != *size) {
+          status = MB_FAILURE;
+          *error = MB_ERROR_EOF;
+          *size = read_len;
+      }
+      else {
+          *error = MB_ERROR_NO_ERROR;
+      }
+  }
+  else if (mb_io_ptr->mbfp != NULL) {
       /* read expected number of bytes into buffer */
       if ((read_len = fread(buffer, 1, *size, mb_io_ptr->mbfp)) != *size) {
           status = MB_FAILURE;
@@ -193,6 +274,135 @@ int mb_fileio_get(int verbose, void *mbio_ptr, char *buffer, size_t *size, int *
   return (status);
 }
 /*--------------------------------------------------------------------*/
+int mb_fileio_getptr(int verbose, void *mbio_ptr, char *buffer, char **data, size_t *size, int *error) {
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> called\n", __func__);
+    fprintf(stderr, "dbg2  Input arguments:\n");
+    fprintf(stderr, "dbg2       verbose:    %d\n", verbose);
+    fprintf(stderr, "dbg2       mbio_ptr:   %p\n", (void *)mbio_ptr);
+    fprintf(stderr, "dbg2       buffer:     %p\n", (void *)buffer);
+    fprintf(stderr, "dbg2       size:       %p\n", (void *)size);
+    fprintf(stderr, "dbg2       *size:      %p\n", (void *)(*size));
+  }
+
+  struct mb_io_struct *mb_io_ptr = (struct mb_io_struct *)mbio_ptr;
+
+  int status = MB_SUCCESS;
+
+  /* if the file is memory mapped point directly at the bytes in the map,
+     which are read only and remain valid until mb_fileio_close() */
+  if (mb_io_ptr->file_mmap != NULL) {
+    const size_t read_len = MIN(*size, mb_io_ptr->file_mmap_size - mb_io_ptr->file_mmap_pos);
+    *data = &mb_io_ptr->file_mmap[mb_io_ptr->file_mmap_pos];
+    mb_io_ptr->file_mmap_pos += read_len;
+    if (read_len != *size) {
+      status = MB_FAILURE;
+      *error = MB_ERROR_EOF;
+      *size = read_len;
+    }
+    else {
+      *error = MB_ERROR_NO_ERROR;
+    }
+  }
+
+  /* otherwise read the bytes into the buffer */
+  else {
+    *data = buffer;
+    status = mb_fileio_get(verbose, mbio_ptr, buffer, size, error);
+  }
+
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> completed\n", __func__);
+    fprintf(stderr, "dbg2  Return values:\n");
+    fprintf(stderr, "dbg2       data:       %p\n", (void *)*data);
+    fprintf(stderr, "dbg2       *size:      %p\n", (void *)(*size));
+    fprintf(stderr, "dbg2       error:      %d\n", *error);
+    fprintf(stderr, "dbg2  Return status:\n");
+    fprintf(stderr, "dbg2       status:  %d\n", status);
+  }
+
+  return (status);
+}
+/*--------------------------------------------------------------------*/
+int mb_fileio_seek(int verbose, void *mbio_ptr, long offset, int whence, int *error) {
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> called\n", __func__);
+    fprintf(stderr, "dbg2  Input arguments:\n");
+    fprintf(stderr, "dbg2       verbose:    %d\n", verbose);
+    fprintf(stderr, "dbg2       mbio_ptr:   %p\n", (void *)mbio_ptr);
+    fprintf(stderr, "dbg2       offset:     %ld\n", offset);
+    fprintf(stderr, "dbg2       whence:     %d\n", whence);
+  }
+
+  struct mb_io_struct *mb_io_ptr = (struct mb_io_struct *)mbio_ptr;
+
+  int status = MB_SUCCESS;
+
+  /* positions past the end of a memory mapped file are allowed as with
+     fseek(), subsequent reads just return MB_ERROR_EOF */
+  if (mb_io_ptr->file_mmap != NULL) {
+    long position = offset;
+    if (whence == SEEK_CUR)
+      position += (long)mb_io_ptr->file_mmap_pos;
+    else if (whence == SEEK_END)
+      position += (long)mb_io_ptr->file_mmap_size;
+    if (position < 0) {
+      status = MB_FAILURE;
+      *error = MB_ERROR_BAD_PARAMETER;
+    }
+    else {
+      mb_io_ptr->file_mmap_pos = MIN((size_t)position, mb_io_ptr->file_mmap_size);
+    }
+  }
+  else if (mb_io_ptr->mbfp == NULL || fseek(mb_io_ptr->mbfp, offset, whence) != 0) {
+    status = MB_FAILURE;
+    *error = MB_ERROR_BAD_PARAMETER;
+  }
+
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> completed\n", __func__);
+    fprintf(stderr, "dbg2  Return values:\n");
+    fprintf(stderr, "dbg2       error:      %d\n", *error);
+    fprintf(stderr, "dbg2  Return status:\n");
+    fprintf(stderr, "dbg2       status:  %d\n", status);
+  }
+
+  return (status);
+}
+/*--------------------------------------------------------------------*/
+int mb_fileio_tell(int verbose, void *mbio_ptr, long *offset, int *error) {
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> called\n", __func__);
+    fprintf(stderr, "dbg2  Input arguments:\n");
+    fprintf(stderr, "dbg2       verbose:    %d\n", verbose);
+    fprintf(stderr, "dbg2       mbio_ptr:   %p\n", (void *)mbio_ptr);
+  }
+
+  struct mb_io_struct *mb_io_ptr = (struct mb_io_struct *)mbio_ptr;
+
+  int status = MB_SUCCESS;
+
+  if (mb_io_ptr->file_mmap != NULL) {
+    *offset = (long)mb_io_ptr->file_mmap_pos;
+  }
+  else if (mb_io_ptr->mbfp == NULL || (*offset = ftell(mb_io_ptr->mbfp)) < 0) {
+    *offset = 0;
+    status = MB_FAILURE;
+    *error = MB_ERROR_BAD_PARAMETER;
+  }
+
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> completed\n", __func__);
+    fprintf(stderr, "dbg2  Return values:\n");
+    fprintf(stderr, "dbg2       offset:     %ld\n", *offset);
+    fprintf(stderr, "dbg2       error:      %d\n", *error);
+    fprintf(stderr, "dbg2  Return status:\n");
+    fprintf(stderr, "dbg2       status:  %d\n", status);
+  }
+
+  return (status);
+}
+/*--------------------------------------------------------------------*/
 int mb_fileio_put(int verbose, void *mbio_ptr, char *buffer, size_t *size, int *error) {
   if (verbose >= 2) {
     fprintf(stderr, "\ndbg2  MBIO function <%s> called\n", __func__);
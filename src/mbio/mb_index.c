@@ -0,0 +1,574 @@
+/*--------------------------------------------------------------------
+ *    The MB-system:  mb_index.c  10/17/2026
+ *
+ *    Copyright (c) 2026 by
+ *    David W. Caress (caress@mbari.org)
+ *      Monterey Bay Aquarium Research Institute
+ *      Moss Landing, California, USA
+ *    Dale N. Chayes
+ *      Center for Coastal and Ocean Mapping
+ *      University of New Hampshire
+ *      Durham, New Hampshire, USA
+ *    Christian dos Santos Ferreira
+ *      MARUM
+ *      University of Bremen
+ *      Bremen Germany
+ *
+ *    MB-System was created by Caress and Chayes in 1992 at the
+ *      Lamont-Doherty Earth Observatory
+ *      Columbia University
+ *      Palisades, NY 10964
+ *
+ *    See README.md file for copying and redistribution conditions.
+ *--------------------------------------------------------------------*/
+/*
+ * mb_index.c contains the functions that build, save and use sidecar
+ * record index files. A sidecar index is written next to a swath file
+ * as file.idx, alongside the file.inf, file.fnv and file.fbt ancillary
+ * files, by mbinfo -K (and so by mbdatalist -O through mb_make_info()).
+ *
+ * These functions include:
+ *   mb_index_build  - start building an index while a file is read
+ *   mb_index_add  - add the record just returned by mb_read() or mb_get_all()
+ *   mb_index_write  - write file.idx, called by mb_close()
+ *   mb_index_read  - load a current file.idx, called by mb_read_init()
+ *   mb_index_seek  - skip to the requested start time and bounds, called by mb_read_init()
+ *   mb_index_get_blob  - get the format private index data from a loaded file.idx
+ *   mb_index_free  - release the index, called by mb_close()
+ *
+ * The index holds, for each record returned to the application, the file
+ * offset from which reading returns that record, the time stamp, the
+ * navigation, the data kind and the number of bytes read. It also holds
+ * an optional block of format private data - formats that scan the whole
+ * file before reading the first record (e.g. MBF_KEMKMALL) store their
+ * scan results there and reload them instead of rescanning.
+ *
+ * An index is used only if the size and modification time of the swath
+ * file and the format id match those recorded in it, so a changed file
+ * is read without it. The index is a local cache written in the native
+ * byte order and structure layout, and one from another machine is
+ * rejected by its header check.
+ *
+ * mb_index_seek() only repositions files of formats that set
+ * mb_io_ptr->index_seek_ok in their register function. Those formats
+ * must be able to start reading at any record boundary, with no state
+ * carried from earlier records beyond what is in the record itself.
+ *
+ * Author:  D. W. Caress
+ * Date:  October 17, 2026
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mb_define.h"
+#include "mb_io.h"
+#include "mb_status.h"
+
+#define MB_INDEX_MAGIC "MBIDX\0\0\1"
+#define MB_INDEX_MAGIC_LEN 8
+#define MB_INDEX_VERSION 1
+#define MB_INDEX_RECORD_BLOCK 4096
+
+/* file.idx header */
+struct mb_index_header {
+  char magic[MB_INDEX_MAGIC_LEN];
+  int32_t version;
+  int32_t header_size;    /* sizeof(struct mb_index_header) */
+  int32_t record_size;    /* sizeof(struct mb_index_record) */
+  int32_t format;         /* MBIO format id */
+  int64_t file_size;      /* size of the swath file in bytes */
+  int64_t file_mtime;     /* modification time of the swath file */
+  int64_t num_records;    /* number of records */
+  int64_t blob_size;      /* size of the format private data in bytes */
+  int32_t seekable;       /* all record offsets are valid */
+  int32_t spare;
+  double btime_d;         /* time of the first survey record */
+  double etime_d;         /* time of the last survey record */
+};
+
+/* file.idx record entry */
+struct mb_index_record {
+  int64_t offset; /* file offset from which reading returns this record */
+  int64_t size;   /* number of bytes read for this record */
+  double time_d;
+  double navlon;
+  double navlat;
+  int32_t kind;
+  int32_t spare;
+};
+
+/* sidecar index held in the mbio descriptor */
+struct mb_index_struct {
+  struct mb_index_header header;
+  struct mb_index_record *records;
+  int64_t num_alloc;
+  void *blob;
+  long position; /* file position after the last record added */
+};
+
+/*--------------------------------------------------------------------*/
+static void mb_index_path(struct mb_io_struct *mb_io_ptr, char *path) {
+  snprintf(path, MB_PATH_MAXLINE, "%s.idx", mb_io_ptr->file);
+}
+/*--------------------------------------------------------------------*/
+/* Gets the current read position of the first file, or fails if the file
+   position does not follow the records returned to the application. */
+static bool mb_index_tell(int verbose, struct mb_io_struct *mb_io_ptr, long *position) {
+  if (mb_io_ptr->readahead != NULL || mb_io_ptr->mbfp == NULL)
+    return false;
+  if (mb_io_ptr->filetype == MB_FILETYPE_SINGLE) {
+    int error = MB_ERROR_NO_ERROR;
+    return mb_fileio_tell(verbose, mb_io_ptr, position, &error) == MB_SUCCESS;
+  }
+  if (mb_io_ptr->filetype == MB_FILETYPE_NORMAL || mb_io_ptr->filetype == MB_FILETYPE_XDR) {
+    *position = ftell(mb_io_ptr->mbfp);
+    return *position >= 0;
+  }
+  return false;
+}
+/*--------------------------------------------------------------------*/
+static void mb_index_release(int verbose, struct mb_index_struct **index, int *error) {
+  if ((*index)->records != NULL)
+    mb_freed(verbose, __FILE__, __LINE__, (void **)&(*index)->records, error);
+  if ((*index)->blob != NULL)
+    mb_freed(verbose, __FILE__, __LINE__, (void **)&(*index)->blob, error);
+  mb_freed(verbose, __FILE__, __LINE__, (void **)index, error);
+}
+/*--------------------------------------------------------------------*/
+int mb_index_build(int verbose, void *mbio_ptr, int *error) {
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> called\n", __func__);
+    fprintf(stderr, "dbg2  Input arguments:\n");
+    fprintf(stderr, "dbg2       verbose:    %d\n", verbose);
+    fprintf(stderr, "dbg2       mbio_ptr:   %p\n", (void *)mbio_ptr);
+  }
+
+  /* get pointer to mbio descriptor */
+  struct mb_io_struct *mb_io_ptr = (struct mb_io_struct *)mbio_ptr;
+
+  int status = MB_SUCCESS;
+  *error = MB_ERROR_NO_ERROR;
+
+  /* only files being read can be indexed */
+  if (mb_io_ptr->filemode != MB_FILEMODE_READ || mb_io_ptr->filetype == MB_FILETYPE_INPUT) {
+    status = MB_FAILURE;
+    *error = MB_ERROR_BAD_USAGE;
+  }
+  else if (mb_io_ptr->index_build == NULL) {
+    struct mb_index_struct *index = NULL;
+    status = mb_mallocd(verbose, __FILE__, __LINE__, sizeof(struct mb_index_struct), (void **)&index, error);
+    if (status == MB_SUCCESS) {
+      memset(index, 0, sizeof(struct mb_index_struct));
+      memcpy(index->header.magic, MB_INDEX_MAGIC, MB_INDEX_MAGIC_LEN);
+      index->header.version = MB_INDEX_VERSION;
+      index->header.header_size = sizeof(struct mb_index_header);
+      index->header.record_size = sizeof(struct mb_index_record);
+      index->header.format = mb_io_ptr->format;
+      index->header.seekable = mb_index_tell(verbose, mb_io_ptr, &index->position);
+      mb_io_ptr->index_build = index;
+    }
+  }
+
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> completed\n", __func__);
+    fprintf(stderr, "dbg2  Return values:\n");
+    fprintf(stderr, "dbg2       index_build:%p\n", mb_io_ptr->index_build);
+    fprintf(stderr, "dbg2       error:      %d\n", *error);
+    fprintf(stderr, "dbg2  Return status:\n");
+    fprintf(stderr, "dbg2       status:     %d\n", status);
+  }
+
+  return (status);
+}
+/*--------------------------------------------------------------------*/
+int mb_index_add(int verbose, void *mbio_ptr, int kind, double time_d, double navlon, double navlat, int *error) {
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> called\n", __func__);
+    fprintf(stderr, "dbg2  Input arguments:\n");
+    fprintf(stderr, "dbg2       verbose:    %d\n", verbose);
+    fprintf(stderr, "dbg2       mbio_ptr:   %p\n", (void *)mbio_ptr);
+    fprintf(stderr, "dbg2       kind:       %d\n", kind);
+    fprintf(stderr, "dbg2       time_d:     %f\n", time_d);
+    fprintf(stderr, "dbg2       navlon:     %f\n", navlon);
+    fprintf(stderr, "dbg2       navlat:     %f\n", navlat);
+  }
+
+  /* get pointer to mbio descriptor */
+  struct mb_io_struct *mb_io_ptr = (struct mb_io_struct *)mbio_ptr;
+  struct mb_index_struct *index = (struct mb_index_struct *)mb_io_ptr->index_build;
+
+  int status = MB_SUCCESS;
+  *error = MB_ERROR_NO_ERROR;
+
+  if (index != NULL) {
+    /* allocate more entries as needed */
+    if (index->header.num_records >= index->num_alloc) {
+      const int64_t num_alloc = index->num_alloc + MB_INDEX_RECORD_BLOCK;
+      status = mb_reallocd(verbose, __FILE__, __LINE__, num_alloc * sizeof(struct mb_index_record),
+                           (void **)&index->records, error);
+      if (status == MB_SUCCESS)
+        index->num_alloc = num_alloc;
+    }
+
+    /* the record was read from the end of the previous one */
+    if (status == MB_SUCCESS) {
+      struct mb_index_record *record = &index->records[index->header.num_records];
+      memset(record, 0, sizeof(struct mb_index_record));
+      long position = 0;
+      if (index->header.seekable && mb_index_tell(verbose, mb_io_ptr, &position)) {
+        record->offset = index->position;
+        record->size = position - index->position;
+        index->position = position;
+      }
+      else {
+        record->offset = -1;
+        index->header.seekable = false;
+      }
+      record->time_d = time_d;
+      record->navlon = navlon;
+      record->navlat = navlat;
+      record->kind = kind;
+      index->header.num_records++;
+
+      if (kind == MB_DATA_DATA) {
+        if (index->header.btime_d == 0.0 || time_d < index->header.btime_d)
+          index->header.btime_d = time_d;
+        if (time_d > index->header.etime_d)
+          index->header.etime_d = time_d;
+      }
+    }
+  }
+
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> completed\n", __func__);
+    fprintf(stderr, "dbg2  Return values:\n");
+    fprintf(stderr, "dbg2       error:      %d\n", *error);
+    fprintf(stderr, "dbg2  Return status:\n");
+    fprintf(stderr, "dbg2       status:     %d\n", status);
+  }
+
+  return (status);
+}
+/*--------------------------------------------------------------------*/
+int mb_index_write(int verbose, void *mbio_ptr, int *error) {
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> called\n", __func__);
+    fprintf(stderr, "dbg2  Input arguments:\n");
+    fprintf(stderr, "dbg2       verbose:    %d\n", verbose);
+    fprintf(stderr, "dbg2       mbio_ptr:   %p\n", (void *)mbio_ptr);
+  }
+
+  /* get pointer to mbio descriptor */
+  struct mb_io_struct *mb_io_ptr = (struct mb_io_struct *)mbio_ptr;
+  struct mb_index_struct *index = (struct mb_index_struct *)mb_io_ptr->index_build;
+
+  int status = MB_SUCCESS;
+  *error = MB_ERROR_NO_ERROR;
+
+  if (index != NULL) {
+    /* the index matches the file as it is now */
+    struct stat file_status;
+    if (stat(mb_io_ptr->file, &file_status) != 0 || (file_status.st_mode & S_IFMT) == S_IFDIR) {
+      status = MB_FAILURE;
+      *error = MB_ERROR_OPEN_FAIL;
+    }
+    else {
+      index->header.file_size = file_status.st_size;
+      index->header.file_mtime = file_status.st_mtime;
+      index->header.blob_size = mb_io_ptr->index_blob != NULL ? (int64_t)mb_io_ptr->index_blob_size : 0;
+
+      /* write to a temporary file and rename it so that a reader never
+          sees a partial index */
+      char path[MB_PATH_MAXLINE];
+      char tmppath[MB_PATH_MAXLINE + 8];
+      mb_index_path(mb_io_ptr, path);
+      snprintf(tmppath, sizeof(tmppath), "%s.tmp", path);
+      FILE *fp = fopen(tmppath, "wb");
+      if (fp == NULL) {
+        status = MB_FAILURE;
+        *error = MB_ERROR_OPEN_FAIL;
+      }
+      else {
+        bool ok = fwrite(&index->header, sizeof(struct mb_index_header), 1, fp) == 1;
+        if (ok && index->header.num_records > 0)
+          ok = fwrite(index->records, sizeof(struct mb_index_record), (size_t)index->header.num_records, fp) ==
+               (size_t)index->header.num_records;
+        if (ok && index->header.blob_size > 0)
+          ok = fwrite(mb_io_ptr->index_blob, 1, (size_t)index->header.blob_size, fp) == (size_t)index->header.blob_size;
+        if (fclose(fp) != 0)
+          ok = false;
+        if (ok && rename(tmppath, path) == 0) {
+          if (verbose >= 1)
+            fprintf(stderr, "Wrote index %s with %lld records\n", path, (long long)index->header.num_records);
+        }
+        else {
+          unlink(tmppath);
+          status = MB_FAILURE;
+          *error = MB_ERROR_WRITE_FAIL;
+        }
+      }
+    }
+  }
+
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> completed\n", __func__);
+    fprintf(stderr, "dbg2  Return values:\n");
+    fprintf(stderr, "dbg2       error:      %d\n", *error);
+    fprintf(stderr, "dbg2  Return status:\n");
+    fprintf(stderr, "dbg2       status:     %d\n", status);
+  }
+
+  return (status);
+}
+/*--------------------------------------------------------------------*/
+int mb_index_read(int verbose, void *mbio_ptr, int *error) {
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> called\n", __func__);
+    fprintf(stderr, "dbg2  Input arguments:\n");
+    fprintf(stderr, "dbg2       verbose:    %d\n", verbose);
+    fprintf(stderr, "dbg2       mbio_ptr:   %p\n", (void *)mbio_ptr);
+  }
+
+  /* get pointer to mbio descriptor */
+  struct mb_io_struct *mb_io_ptr = (struct mb_io_struct *)mbio_ptr;
+
+  int status = MB_SUCCESS;
+  *error = MB_ERROR_NO_ERROR;
+
+  char path[MB_PATH_MAXLINE];
+  mb_index_path(mb_io_ptr, path);
+  struct stat file_status;
+  struct stat index_status;
+  FILE *fp = NULL;
+  if (mb_io_ptr->index == NULL && mb_io_ptr->filemode == MB_FILEMODE_READ &&
+      stat(mb_io_ptr->file, &file_status) == 0 && (file_status.st_mode & S_IFMT) != S_IFDIR &&
+      stat(path, &index_status) == 0 && (index_status.st_mode & S_IFMT) != S_IFDIR &&
+      (fp = fopen(path, "rb")) != NULL) {
+    struct mb_index_struct *index = NULL;
+    status = mb_mallocd(verbose, __FILE__, __LINE__, sizeof(struct mb_index_struct), (void **)&index, error);
+    if (status == MB_SUCCESS) {
+      memset(index, 0, sizeof(struct mb_index_struct));
+
+      /* an index is used only if it was made on this kind of machine
+          from the file as it is now */
+      struct mb_index_header *header = &index->header;
+      bool ok = fread(header, sizeof(struct mb_index_header), 1, fp) == 1 &&
+                memcmp(header->magic, MB_INDEX_MAGIC, MB_INDEX_MAGIC_LEN) == 0 &&
+                header->version == MB_INDEX_VERSION && header->header_size == sizeof(struct mb_index_header) &&
+                header->record_size == sizeof(struct mb_index_record) && header->format == mb_io_ptr->format &&
+                header->file_size == (int64_t)file_status.st_size && header->file_mtime == (int64_t)file_status.st_mtime &&
+                header->num_records >= 0 && header->blob_size >= 0 &&
+                (int64_t)index_status.st_size == (int64_t)sizeof(struct mb_index_header) +
+                                                    header->num_records * (int64_t)sizeof(struct mb_index_record) +
+                                                    header->blob_size;
+      if (ok && header->num_records > 0) {
+        ok = mb_mallocd(verbose, __FILE__, __LINE__, header->num_records * sizeof(struct mb_index_record),
+                        (void **)&index->records, error) == MB_SUCCESS &&
+             fread(index->records, sizeof(struct mb_index_record), (size_t)header->num_records, fp) ==
+                 (size_t)header->num_records;
+        index->num_alloc = header->num_records;
+      }
+      if (ok && header->blob_size > 0) {
+        ok = mb_mallocd(verbose, __FILE__, __LINE__, (size_t)header->blob_size, (void **)&index->blob, error) ==
+                 MB_SUCCESS &&
+             fread(index->blob, 1, (size_t)header->blob_size, fp) == (size_t)header->blob_size;
+      }
+
+      /* a missing or stale index just means reading without one */
+      if (ok) {
+        mb_io_ptr->index = index;
+      }
+      else {
+        if (verbose >= 1)
+          fprintf(stderr, "Ignoring out of date or unreadable index %s\n", path);
+        int free_error = MB_ERROR_NO_ERROR;
+        mb_index_release(verbose, &index, &free_error);
+      }
+      status = MB_SUCCESS;
+      *error = MB_ERROR_NO_ERROR;
+    }
+    fclose(fp);
+  }
+
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> completed\n", __func__);
+    fprintf(stderr, "dbg2  Return values:\n");
+    fprintf(stderr, "dbg2       index:      %p\n", mb_io_ptr->index);
+    fprintf(stderr, "dbg2       error:      %d\n", *error);
+    fprintf(stderr, "dbg2  Return status:\n");
+    fprintf(stderr, "dbg2       status:     %d\n", status);
+  }
+
+  return (status);
+}
+/*--------------------------------------------------------------------*/
+int mb_index_seek(int verbose, void *mbio_ptr, int *error) {
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> called\n", __func__);
+    fprintf(stderr, "dbg2  Input arguments:\n");
+    fprintf(stderr, "dbg2       verbose:    %d\n", verbose);
+    fprintf(stderr, "dbg2       mbio_ptr:   %p\n", (void *)mbio_ptr);
+  }
+
+  /* get pointer to mbio descriptor */
+  struct mb_io_struct *mb_io_ptr = (struct mb_io_struct *)mbio_ptr;
+  struct mb_index_struct *index = (struct mb_index_struct *)mb_io_ptr->index;
+
+  int status = MB_SUCCESS;
+  *error = MB_ERROR_NO_ERROR;
+  long offset = 0;
+
+  /* seek only in single files of formats that can start reading at
+      any record, and only if the reading position is still at the start */
+  long position = -1;
+  if (index != NULL && index->header.seekable && mb_io_ptr->index_seek_ok && mb_io_ptr->numfile == 1 &&
+      (mb_io_ptr->filetype == MB_FILETYPE_NORMAL || mb_io_ptr->filetype == MB_FILETYPE_SINGLE) &&
+      mb_index_tell(verbose, mb_io_ptr, &position) && position == 0) {
+    const bool check_bounds = mb_io_ptr->bounds[0] > -360.0 || mb_io_ptr->bounds[1] < 360.0 ||
+                              mb_io_ptr->bounds[2] > -90.0 || mb_io_ptr->bounds[3] < 90.0;
+
+    /* find the first survey record that will be returned */
+    int64_t ifirst = -1;
+    int64_t iprevious = -1;
+    for (int64_t i = 0; i < index->header.num_records && ifirst < 0; i++) {
+      const struct mb_index_record *record = &index->records[i];
+      if (record->kind != MB_DATA_DATA)
+        continue;
+      bool use = record->time_d >= mb_io_ptr->btime_d;
+      if (use && check_bounds && (record->navlon != 0.0 || record->navlat != 0.0)) {
+        /* the index holds longitudes as read by mbinfo, so bring them into
+            the longitude range of the bounds before comparing */
+        double navlon = record->navlon;
+        while (navlon < mb_io_ptr->bounds[0])
+          navlon += 360.0;
+        while (navlon > mb_io_ptr->bounds[0] + 360.0)
+          navlon -= 360.0;
+        use = navlon <= mb_io_ptr->bounds[1] && record->navlat >= mb_io_ptr->bounds[2] &&
+              record->navlat <= mb_io_ptr->bounds[3];
+      }
+      if (use)
+        ifirst = i;
+      else
+        iprevious = i;
+    }
+
+    /* start one survey record early so that the first record returned is
+        preceded by the same ping as when reading from the start */
+    if (ifirst > 0 && iprevious >= 0)
+      offset = (long)index->records[iprevious].offset;
+    if (offset > 0) {
+      if (mb_io_ptr->filetype == MB_FILETYPE_SINGLE)
+        status = mb_fileio_seek(verbose, mb_io_ptr, offset, SEEK_SET, error);
+      else if (fseek(mb_io_ptr->mbfp, offset, SEEK_SET) != 0) {
+        status = MB_FAILURE;
+        *error = MB_ERROR_EOF;
+      }
+      if (status == MB_SUCCESS) {
+        mb_io_ptr->file_pos = offset;
+        mb_io_ptr->file_bytes = offset;
+        if (verbose >= 1)
+          fprintf(stderr, "Skipped %ld bytes of %s using its index\n", offset, mb_io_ptr->file);
+      }
+      else {
+        /* fall back to reading from the start */
+        int seek_error = MB_ERROR_NO_ERROR;
+        if (mb_io_ptr->filetype == MB_FILETYPE_SINGLE)
+          mb_fileio_seek(verbose, mb_io_ptr, 0, SEEK_SET, &seek_error);
+        else
+          fseek(mb_io_ptr->mbfp, 0, SEEK_SET);
+        offset = 0;
+        status = MB_SUCCESS;
+        *error = MB_ERROR_NO_ERROR;
+      }
+    }
+  }
+
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> completed\n", __func__);
+    fprintf(stderr, "dbg2  Return values:\n");
+    fprintf(stderr, "dbg2       offset:     %ld\n", offset);
+    fprintf(stderr, "dbg2       error:      %d\n", *error);
+    fprintf(stderr, "dbg2  Return status:\n");
+    fprintf(stderr, "dbg2       status:     %d\n", status);
+  }
+
+  return (status);
+}
+/*--------------------------------------------------------------------*/
+int mb_index_get_blob(int verbose, void *mbio_ptr, void **blob, size_t *blob_size, int *error) {
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> called\n", __func__);
+    fprintf(stderr, "dbg2  Input arguments:\n");
+    fprintf(stderr, "dbg2       verbose:    %d\n", verbose);
+    fprintf(stderr, "dbg2       mbio_ptr:   %p\n", (void *)mbio_ptr);
+  }
+
+  /* get pointer to mbio descriptor */
+  struct mb_io_struct *mb_io_ptr = (struct mb_io_struct *)mbio_ptr;
+  struct mb_index_struct *index = (struct mb_index_struct *)mb_io_ptr->index;
+
+  int status = MB_SUCCESS;
+  *error = MB_ERROR_NO_ERROR;
+  *blob = NULL;
+  *blob_size = 0;
+  if (index != NULL && index->blob != NULL && index->header.blob_size > 0) {
+    *blob = index->blob;
+    *blob_size = (size_t)index->header.blob_size;
+  }
+  else {
+    status = MB_FAILURE;
+    *error = MB_ERROR_NO_DATA_REQUESTED;
+  }
+
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> completed\n", __func__);
+    fprintf(stderr, "dbg2  Return values:\n");
+    fprintf(stderr, "dbg2       blob:       %p\n", *blob);
+    fprintf(stderr, "dbg2       blob_size:  %zu\n", *blob_size);
+    fprintf(stderr, "dbg2       error:      %d\n", *error);
+    fprintf(stderr, "dbg2  Return status:\n");
+    fprintf(stderr, "dbg2       status:     %d\n", status);
+  }
+
+  return (status);
+}
+/*--------------------------------------------------------------------*/
+int mb_index_free(int verbose, void *mbio_ptr, int *error) {
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> called\n", __func__);
+    fprintf(stderr, "dbg2  Input arguments:\n");
+    fprintf(stderr, "dbg2       verbose:    %d\n", verbose);
+    fprintf(stderr, "dbg2       mbio_ptr:   %p\n", (void *)mbio_ptr);
+  }
+
+  /* get pointer to mbio descriptor */
+  struct mb_io_struct *mb_io_ptr = (struct mb_io_struct *)mbio_ptr;
+
+  const int status = MB_SUCCESS;
+  *error = MB_ERROR_NO_ERROR;
+
+  if (mb_io_ptr->index != NULL)
+    mb_index_release(verbose, (struct mb_index_struct **)&mb_io_ptr->index, error);
+  if (mb_io_ptr->index_build != NULL)
+    mb_index_release(verbose, (struct mb_index_struct **)&mb_io_ptr->index_build, error);
+  mb_io_ptr->index_blob = NULL;
+  mb_io_ptr->index_blob_size = 0;
+
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> completed\n", __func__);
+    fprintf(stderr, "dbg2  Return values:\n");
+    fprintf(stderr, "dbg2       error:      %d\n", *error);
+    fprintf(stderr, "dbg2  Return status:\n");
+    fprintf(stderr, "dbg2       status:     %d\n", status);
+  }
+
+  return (status);
+}
+/*--------------------------------------------------------------------*/
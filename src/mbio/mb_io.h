@@ -514,6 +514,17 @@ struct mb_io_struct {
   long file_pos;               /* file position at start of last record read */
   long file_bytes;             /* number of bytes read from file */
   char *file_iobuffer;         /* file i/o buffer for fread() and fwrite() calls */
+  bool file_mmap_ok;           /* format reads single files only through mb_fileio_*(), so mmap may be used */
+  char *file_mmap;             /* memory mapped input file, or NULL */
+  size_t file_mmap_size;       /* size of memory mapped input file */
+  size_t file_mmap_pos;        /* read position within memory mapped input file */
+  bool readahead_ok;           /* format read path is safe to run in a read-ahead thread */
+  void *readahead;             /* read-ahead thread and record queue, or NULL */
+  bool index_seek_ok;          /* format can start reading at any record offset in a sidecar index */
+  void *index;                 /* sidecar index (file.idx) matching the file, or NULL */
+  void *index_build;           /* sidecar index being built while reading, or NULL */
+  void *index_blob;            /* format private index data to save in the sidecar index */
+  size_t index_blob_size;      /* size of the format private index data */
   FILE *mbfp2;                 /* file descriptor #2 */
   char file2[MB_PATH_MAXLINE]; /* file name #2 */
   long file2_pos;              /* file position #2 at start of last record read */
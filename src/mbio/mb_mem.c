@@ -31,6 +31,7 @@
  * Date:  March 1, 1993
  */
 
+#include <pthread.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -51,6 +52,7 @@ static size_t mb_alloc_size[MB_MEMORY_HEAP_MAX];
 static mb_name mb_alloc_sourcefile[MB_MEMORY_HEAP_MAX];
 static int mb_alloc_sourceline[MB_MEMORY_HEAP_MAX];
 static bool mb_alloc_overflow = false;
+static pthread_mutex_t mb_alloc_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 /*--------------------------------------------------------------------*/
 int mb_mem_list_enable(int verbose, int *error) {
@@ -210,6 +212,7 @@ int mb_malloc(int verbose, size_t size, void **ptr, int *error) {
   }
 
   /* keep list of allocated memory */
+  pthread_mutex_lock(&mb_alloc_mutex);
   if (mb_memory_list_enabled) {
     /* add to list if size > 0 */
     if (size > 0) {
@@ -233,6 +236,7 @@ int mb_malloc(int verbose, size_t size, void **ptr, int *error) {
                 mb_alloc_sourcefile[i], mb_alloc_sourceline[i]);
     }
   }
+  pthread_mutex_unlock(&mb_alloc_mutex);
   if (verbose >= 2 || mb_mem_debug) {
     fprintf(stderr, "\ndbg2  MBIO function <%s> completed\n", __func__);
     fprintf(stderr, "dbg2  Return values:\n");
@@ -277,6 +281,7 @@ int mb_mallocd(int verbose, const char *sourcefile, int sourceline, size_t size,
   }
 
   /* keep list of allocated memory */
+  pthread_mutex_lock(&mb_alloc_mutex);
   if (mb_memory_list_enabled) {
 
     if ((verbose >= 5 || mb_mem_debug) && size > 0) {
@@ -308,6 +313,7 @@ int mb_mallocd(int verbose, const char *sourcefile, int sourceline, size_t size,
                 mb_alloc_sourcefile[i], mb_alloc_sourceline[i]);
     }
   }
+  pthread_mutex_unlock(&mb_alloc_mutex);
 
   if (verbose >= 2 || mb_mem_debug) {
     fprintf(stderr, "\ndbg2  MBIO function <%s> completed\n", __func__);
@@ -334,6 +340,7 @@ int mb_realloc(int verbose, size_t size, void **ptr, int *error) {
 
   /* keep list of allocated memory */
   int iptr = -1;
+  pthread_mutex_lock(&mb_alloc_mutex);
   if (mb_memory_list_enabled) {
     /* check if pointer is in list */
     for (int i = 0; i < n_mb_alloc; i++)
@@ -406,6 +413,7 @@ int mb_realloc(int verbose, size_t size, void **ptr, int *error) {
                 mb_alloc_sourcefile[i], mb_alloc_sourceline[i]);
     }
   }
+  pthread_mutex_unlock(&mb_alloc_mutex);
 
   /* assume success */
   *error = MB_ERROR_NO_ERROR;
@@ -437,6 +445,7 @@ int mb_reallocd(int verbose, const char *sourcefile, int sourceline, size_t size
 
   /* keep list of allocated memory */
   int iptr = -1;
+  pthread_mutex_lock(&mb_alloc_mutex);
   if (mb_memory_list_enabled) {
     /* check if pointer is in list */
     for (int i = 0; i < n_mb_alloc; i++) {
@@ -518,6 +527,7 @@ int mb_reallocd(int verbose, const char *sourcefile, int sourceline, size_t size
                 mb_alloc_sourcefile[i], mb_alloc_sourceline[i]);
     }
   }
+  pthread_mutex_unlock(&mb_alloc_mutex);
 
   /* assume success */
   *error = MB_ERROR_NO_ERROR;
@@ -546,6 +556,7 @@ int mb_free(int verbose, void **ptr, int *error) {
 
   /* if keeping list of allocated memory then free memory only if it is in
       the list or list has overflowed */
+  pthread_mutex_lock(&mb_alloc_mutex);
   if (mb_memory_list_enabled) {
     /* check if pointer is in list */
     int iptr = -1;
@@ -606,6 +617,7 @@ int mb_free(int verbose, void **ptr, int *error) {
     free(*ptr);
     *ptr = NULL;
   }
+  pthread_mutex_unlock(&mb_alloc_mutex);
 
   /* assume success */
   *error = MB_ERROR_NO_ERROR;
@@ -635,6 +647,7 @@ int mb_freed(int verbose, const char *sourcefile, int sourceline, void **ptr, in
 
   /* if keeping list of allocated memory then free memory only if it is in
       the list or list has overflowed */
+  pthread_mutex_lock(&mb_alloc_mutex);
   if (mb_memory_list_enabled) {
     /* check if pointer is in list */
     int iptr = -1;
@@ -693,6 +706,7 @@ int mb_freed(int verbose, const char *sourcefile, int sourceline, void **ptr, in
     free(*ptr);
     *ptr = NULL;
   }
+  pthread_mutex_unlock(&mb_alloc_mutex);
 
   /* assume success */
   *error = MB_ERROR_NO_ERROR;
@@ -717,6 +731,7 @@ int mb_memory_clear(int verbose, int *error) {
   }
 
   /* keep list of allocated memory */
+  pthread_mutex_lock(&mb_alloc_mutex);
   if (mb_memory_list_enabled) {
     /* loop over all allocated memory */
     for (int i = 0; i < n_mb_alloc; i++) {
@@ -735,6 +750,7 @@ int mb_memory_clear(int verbose, int *error) {
     }
     n_mb_alloc = 0;
   }
+  pthread_mutex_unlock(&mb_alloc_mutex);
 
   /* assume success */
   *error = MB_ERROR_NO_ERROR;
@@ -764,6 +780,7 @@ int mb_memory_status(int verbose, int *nalloc, int *nallocmax, int *overflow, si
   *allocsize = 0;
 
   /* keep list of allocated memory */
+  pthread_mutex_lock(&mb_alloc_mutex);
   if (mb_memory_list_enabled) {
     /* get status */
     *nalloc = n_mb_alloc;
@@ -773,6 +790,7 @@ int mb_memory_status(int verbose, int *nalloc, int *nallocmax, int *overflow, si
     for (int i = 0; i < n_mb_alloc; i++)
       *allocsize += mb_alloc_size[i];
   }
+  pthread_mutex_unlock(&mb_alloc_mutex);
 
   /* assume success */
   *error = MB_ERROR_NO_ERROR;
@@ -801,6 +819,7 @@ int mb_memory_list(int verbose, int *error) {
   }
 
   /* keep list of allocated memory */
+  pthread_mutex_lock(&mb_alloc_mutex);
   if (mb_memory_list_enabled) {
     if (verbose >= 4 || mb_mem_debug) {
       if (n_mb_alloc > 0) {
@@ -821,6 +840,7 @@ int mb_memory_list(int verbose, int *error) {
       fprintf(stderr, "Probable failure in MB-System garbage collection...\n");
     }
   }
+  pthread_mutex_unlock(&mb_alloc_mutex);
 
   /* assume success */
   *error = MB_ERROR_NO_ERROR;
@@ -235,6 +235,8 @@ int mb_pr_readpar(int verbose, char *file, int lookforfiles, struct mb_process_s
 	process->mbp_tt_mult = 1.0;
 	process->mbp_angle_mode = MBP_ANGLES_SNELL;
 	process->mbp_corrected = true;
+	process->mbp_raytable_mode = MBP_RAYTABLE_OFF;
+	process->mbp_raytable_error = 0.01;
 	process->mbp_static_mode = MBP_STATIC_OFF;
 	process->mbp_staticfile[0] = '\0';
 
@@ -617,6 +619,12 @@ int mb_pr_readpar(int verbose, char *file, int lookforfiles, struct mb_process_s
 				else if (strncmp(buffer, "SOUNDSPEEDREF", 13) == 0) {
 					sscanf(buffer, "%s %d", dummy, &process->mbp_corrected);
 				}
+				else if (strncmp(buffer, "RAYTABLEMODE", 12) == 0) {
+					sscanf(buffer, "%s %d", dummy, &process->mbp_raytable_mode);
+				}
+				else if (strncmp(buffer, "RAYTABLEERROR", 13) == 0) {
+					sscanf(buffer, "%s %lf", dummy, &process->mbp_raytable_error);
+				}
 
 				/* static beam bathymetry correction */
 				else if (strncmp(buffer, "STATICMODE", 10) == 0) {
@@ -1244,6 +1252,8 @@ int mb_pr_readpar(int verbose, char *file, int lookforfiles, struct mb_process_s
 		fprintf(stderr, "dbg2       mbp_tt_mode:            %d\n", process->mbp_tt_mode);
 		fprintf(stderr, "dbg2       mbp_tt_mult:            %f\n", process->mbp_tt_mult);
 		fprintf(stderr, "dbg2       mbp_angle_mode:         %d\n", process->mbp_angle_mode);
+		fprintf(stderr, "dbg2       mbp_raytable_mode:      %d\n", process->mbp_raytable_mode);
+		fprintf(stderr, "dbg2       mbp_raytable_error:     %f\n", process->mbp_raytable_error);
 		fprintf(stderr, "dbg2       mbp_static_mode:        %d\n", process->mbp_static_mode);
 		fprintf(stderr, "dbg2       mbp_staticfile:         %s\n", process->mbp_staticfile);
 		fprintf(stderr, "dbg2       mbp_heading_mode:       %d\n", process->mbp_heading_mode);
@@ -1383,6 +1393,8 @@ int mb_pr_writepar(int verbose, char *file, struct mb_process_struct *process, i
 		fprintf(stderr, "dbg2       mbp_tt_mode:            %d\n", process->mbp_tt_mode);
 		fprintf(stderr, "dbg2       mbp_tt_mult:            %f\n", process->mbp_tt_mult);
 		fprintf(stderr, "dbg2       mbp_angle_mode:         %d\n", process->mbp_angle_mode);
+		fprintf(stderr, "dbg2       mbp_raytable_mode:      %d\n", process->mbp_raytable_mode);
+		fprintf(stderr, "dbg2       mbp_raytable_error:     %f\n", process->mbp_raytable_error);
 		fprintf(stderr, "dbg2       mbp_static_mode:        %d\n", process->mbp_static_mode);
 		fprintf(stderr, "dbg2       mbp_staticfile:         %s\n", process->mbp_staticfile);
 		fprintf(stderr, "dbg2       mbp_heading_mode:       %d\n", process->mbp_heading_mode);
@@ -1585,6 +1597,8 @@ int mb_pr_writepar(int verbose, char *file, struct mb_process_struct *process, i
 		fprintf(fp, "TTMULTIPLY %f\n", process->mbp_tt_mult);
 		fprintf(fp, "ANGLEMODE %d\n", process->mbp_angle_mode);
 		fprintf(fp, "SOUNDSPEEDREF %d\n", process->mbp_corrected);
+		fprintf(fp, "RAYTABLEMODE %d\n", process->mbp_raytable_mode);
+		fprintf(fp, "RAYTABLEERROR %f\n", process->mbp_raytable_error);
 		fprintf(fp, "STATICMODE %d\n", process->mbp_static_mode);
 		strcpy(relative_path, process->mbp_staticfile);
 		status = mb_get_relative_path(verbose, relative_path, pwd, error);
@@ -1820,6 +1834,8 @@ int mb_pr_compare(int verbose, struct mb_process_struct *process1,
 	if (process1->mbp_tt_mode != process2->mbp_tt_mode) (*num_difference)++;
 	if (process1->mbp_tt_mult != process2->mbp_tt_mult) (*num_difference)++;
 	if (process1->mbp_angle_mode != process2->mbp_angle_mode) (*num_difference)++;
+	if (process1->mbp_raytable_mode != process2->mbp_raytable_mode) (*num_difference)++;
+	if (process1->mbp_raytable_error != process2->mbp_raytable_error) (*num_difference)++;
 	if (process1->mbp_static_mode != process2->mbp_static_mode) (*num_difference)++;
 	if (strncmp(process1->mbp_staticfile, process2->mbp_staticfile, MBP_FILENAMESIZE) != 0) (*num_difference)++;
 	if (process1->mbp_heading_mode != process2->mbp_heading_mode) (*num_difference)++;
@@ -264,6 +264,12 @@
  *                                  #  2: adjust beams angles by Snell's law
  *                                  #     using array geometry
  *   SOUNDSPEEDREF boolean          # sets raytraced bathymetry to "corrected" values [1]
+ *   RAYTABLEMODE boolean           # sets raytracing from precomputed tables [0]
+ *                                  #  0: trace every beam
+ *                                  #  1: interpolate beams from raytracing tables
+ *                                  #     precomputed for the SVP, tracing beams
+ *                                  #     that fall outside the tables
+ *   RAYTABLEERROR error            # sets maximum raytracing table error (m) [0.01]
  *
  * STATIC BEAM BATHYMETRY OFFSETS:
  *   STATICMODE mode                # sets offsetting of bathymetry by per-beam statics [0]
@@ -623,6 +629,8 @@
 #define MBP_ANGLES_OK 0
 #define MBP_ANGLES_SNELL 1
 #define MBP_ANGLES_SNELLNULL 2
+#define MBP_RAYTABLE_OFF 0
+#define MBP_RAYTABLE_ON 1
 #define MBP_STATIC_OFF 0
 #define MBP_STATIC_BEAM_ON 1
 #define MBP_STATIC_ANGLE_ON 2
@@ -891,6 +899,8 @@ struct mb_process_struct {
   double mbp_tt_mult;
   int mbp_angle_mode;
   int mbp_corrected;
+  int mbp_raytable_mode;
+  double mbp_raytable_error;
   int mbp_static_mode;
   char mbp_staticfile[MBP_FILENAMESIZE];
 
@@ -1001,12 +1011,19 @@ struct mb_process_struct {
 #define MB_ESF_MAXTIMEDIFF 0.0000011
 #define MB_ESF_MAXTIMEDIFF_X10 0.0011
 #define MB_ESF_MULTIPLICITY_FACTOR 100000000
+#define MB_ESF_INDEX_BUCKET 0.01
+#define MB_ESF_BUFFER_SIZE 65536
 struct mb_edit_struct {
   double time_d;
   int beam;
   int action;
   int use;
 };
+struct mb_esf_bucket_struct {
+  long key;
+  int first;
+  int last;
+};
 struct mb_esf_struct {
   char esffile[MB_PATH_MAXLINE];
   char esstream[MB_PATH_MAXLINE];
@@ -1018,6 +1035,11 @@ struct mb_esf_struct {
   FILE *esffp;
   FILE *essfp;
   int startnextsearch;
+  int nbucket;
+  struct mb_esf_bucket_struct *bucket;
+  int *bucket_next;
+  int nmatch_alloc;
+  int *match;
 };
 
 #ifdef __cplusplus
@@ -1144,6 +1166,8 @@ int mb_esf_check(int verbose, char *swathfile, char *esffile, int *found, int *e
 int mb_esf_load(int verbose, const char *program_name, char *swathfile, bool load, int output, char *esffile, struct mb_esf_struct *esf,
                 int *error);
 int mb_esf_open(int verbose, const char *program_name, char *esffile, bool load, int output, struct mb_esf_struct *esf, int *error);
+int mb_esf_compact(int verbose, struct mb_esf_struct *esf, int *error);
+int mb_esf_index(int verbose, struct mb_esf_struct *esf, int *error);
 int mb_esf_fixtimestamps(int verbose, struct mb_esf_struct *esf, double time_d, double tolerance, int *error);
 int mb_esf_apply(int verbose, struct mb_esf_struct *esf, double time_d, int pingmultiplicity, int nbath, char *beamflag,
                  int *error);
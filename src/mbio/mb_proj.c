@@ -282,6 +282,87 @@ int mb_proj_inverse(int verbose, void *pjptr, double easting, double northing, d
 
   return (status);
 }
+/*--------------------------------------------------------------------*/
+int mb_proj_clone(int verbose, void *pjptr, void **ctxptr, void **cloneptr, int *error) {
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> called\n", __func__);
+    fprintf(stderr, "dbg2  Input arguments:\n");
+    fprintf(stderr, "dbg2       verbose:    %d\n", verbose);
+    fprintf(stderr, "dbg2       pjptr:      %p\n", (void *)pjptr);
+  }
+
+  /* projection objects are not thread safe - make an independent copy
+      with its own context for use in another thread */
+  int status = MB_SUCCESS;
+  *ctxptr = NULL;
+  *cloneptr = NULL;
+  *error = MB_ERROR_NO_ERROR;
+  if (pjptr != NULL) {
+    projCtx ctx = pj_ctx_alloc();
+    char *definition = pj_get_def((projPJ)pjptr, 0);
+    projPJ pj = NULL;
+    if (ctx != NULL && definition != NULL)
+      pj = pj_init_plus_ctx(ctx, definition);
+    if (definition != NULL)
+      pj_dalloc(definition);
+    if (pj != NULL) {
+      *ctxptr = (void *)ctx;
+      *cloneptr = (void *)pj;
+    }
+    else {
+      if (ctx != NULL)
+        pj_ctx_free(ctx);
+      *error = MB_ERROR_BAD_PROJECTION;
+      status = MB_FAILURE;
+    }
+  }
+
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> completed\n", __func__);
+    fprintf(stderr, "dbg2  Return values:\n");
+    fprintf(stderr, "dbg2       ctxptr:          %p\n", (void *)*ctxptr);
+    fprintf(stderr, "dbg2       cloneptr:        %p\n", (void *)*cloneptr);
+    fprintf(stderr, "dbg2       error:           %d\n", *error);
+    fprintf(stderr, "dbg2  Return status:\n");
+    fprintf(stderr, "dbg2       status:          %d\n", status);
+  }
+
+  return (status);
+}
+/*--------------------------------------------------------------------*/
+int mb_proj_clone_free(int verbose, void **ctxptr, void **cloneptr, int *error) {
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> called\n", __func__);
+    fprintf(stderr, "dbg2  Input arguments:\n");
+    fprintf(stderr, "dbg2       verbose:    %d\n", verbose);
+    fprintf(stderr, "dbg2       ctxptr:     %p\n", (void *)*ctxptr);
+    fprintf(stderr, "dbg2       cloneptr:   %p\n", (void *)*cloneptr);
+  }
+
+  /* free the projection and then its context */
+  if (*cloneptr != NULL) {
+    pj_free((projPJ)*cloneptr);
+    *cloneptr = NULL;
+  }
+  if (*ctxptr != NULL) {
+    pj_ctx_free((projCtx)*ctxptr);
+    *ctxptr = NULL;
+  }
+
+  /* assume success */
+  *error = MB_ERROR_NO_ERROR;
+  const int status = MB_SUCCESS;
+
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> completed\n", __func__);
+    fprintf(stderr, "dbg2  Return values:\n");
+    fprintf(stderr, "dbg2       error:           %d\n", *error);
+    fprintf(stderr, "dbg2  Return status:\n");
+    fprintf(stderr, "dbg2       status:          %d\n", status);
+  }
+
+  return (status);
+}
 
 /*--------------------------------------------------------------------*/
 /*--------------------------------------------------------------------*/
@@ -537,5 +618,88 @@ int mb_proj_inverse(int verbose, void *pjptr, double u, double v, double *uu, do
   return (status);
 }
 /*--------------------------------------------------------------------*/
+int mb_proj_clone(int verbose, void *pjptr, void **ctxptr, void **cloneptr, int *error) {
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> called\n", __func__);
+    fprintf(stderr, "dbg2  Input arguments:\n");
+    fprintf(stderr, "dbg2       verbose:    %d\n", verbose);
+    fprintf(stderr, "dbg2       pjptr:      %p\n", (void *)pjptr);
+  }
+
+  /* PJ objects and the default context are not thread safe - make an
+      independent copy with its own context for use in another thread */
+  int status = MB_SUCCESS;
+  *ctxptr = NULL;
+  *cloneptr = NULL;
+  *error = MB_ERROR_NO_ERROR;
+  if (pjptr != NULL) {
+#if PROJ_VERSION_MAJOR > 6 || (PROJ_VERSION_MAJOR == 6 && PROJ_VERSION_MINOR >= 2)
+    PJ_CONTEXT *ctx = proj_context_create();
+    PJ *p = NULL;
+    if (ctx != NULL)
+      p = proj_clone(ctx, (PJ *)pjptr);
+    if (p != NULL) {
+      *ctxptr = (void *)ctx;
+      *cloneptr = (void *)p;
+    }
+    else {
+      if (ctx != NULL)
+        proj_context_destroy(ctx);
+      *error = MB_ERROR_BAD_PROJECTION;
+      status = MB_FAILURE;
+    }
+#else
+    *error = MB_ERROR_BAD_PROJECTION;
+    status = MB_FAILURE;
+#endif
+  }
+
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> completed\n", __func__);
+    fprintf(stderr, "dbg2  Return values:\n");
+    fprintf(stderr, "dbg2       ctxptr:          %p\n", (void *)*ctxptr);
+    fprintf(stderr, "dbg2       cloneptr:        %p\n", (void *)*cloneptr);
+    fprintf(stderr, "dbg2       error:           %d\n", *error);
+    fprintf(stderr, "dbg2  Return status:\n");
+    fprintf(stderr, "dbg2       status:          %d\n", status);
+  }
+
+  return (status);
+}
+/*--------------------------------------------------------------------*/
+int mb_proj_clone_free(int verbose, void **ctxptr, void **cloneptr, int *error) {
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> called\n", __func__);
+    fprintf(stderr, "dbg2  Input arguments:\n");
+    fprintf(stderr, "dbg2       verbose:    %d\n", verbose);
+    fprintf(stderr, "dbg2       ctxptr:     %p\n", (void *)*ctxptr);
+    fprintf(stderr, "dbg2       cloneptr:   %p\n", (void *)*cloneptr);
+  }
+
+  /* free the projection and then its context */
+  if (*cloneptr != NULL) {
+    proj_destroy((PJ *)*cloneptr);
+    *cloneptr = NULL;
+  }
+  if (*ctxptr != NULL) {
+    proj_context_destroy((PJ_CONTEXT *)*ctxptr);
+    *ctxptr = NULL;
+  }
+
+  /* assume success */
+  *error = MB_ERROR_NO_ERROR;
+  const int status = MB_SUCCESS;
+
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> completed\n", __func__);
+    fprintf(stderr, "dbg2  Return values:\n");
+    fprintf(stderr, "dbg2       error:           %d\n", *error);
+    fprintf(stderr, "dbg2  Return status:\n");
+    fprintf(stderr, "dbg2       status:          %d\n", status);
+  }
+
+  return (status);
+}
+/*--------------------------------------------------------------------*/
 
 #endif
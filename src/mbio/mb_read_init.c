@@ -648,6 +648,18 @@ int mb_read_init(int verbose, char *file, int format, int pings, int lonflip, do
     }
 	}
 
+	/* use a current sidecar index (file.idx) to skip to the requested start
+		time and bounds - without one the file is read from the start */
+	mb_index_read(verbose, *mbio_ptr, error);
+	mb_index_seek(verbose, *mbio_ptr, error);
+
+	/* start reading ahead in a separate thread if requested and supported
+		by the format - failure to start leaves the file read synchronously */
+	int readahead = 0;
+	mb_readahead(verbose, &readahead);
+	if (readahead > 0)
+		mb_readahead_init(verbose, *mbio_ptr, readahead, error);
+
 	/* set error and status (if you got here you succeeded */
 	*error = MB_ERROR_NO_ERROR;
 	status = MB_SUCCESS;
@@ -56,8 +56,13 @@ int mb_read_ping(int verbose, void *mbio_ptr, void *store_ptr, int *kind, int *e
 
 	int status = MB_SUCCESS;
 
-	/* call the appropriate mbr_ read and translate routine */
-	if (mb_io_ptr->mb_io_read_ping != NULL) {
+	/* get the next record from the read-ahead thread if there is one */
+	if (mb_io_ptr->readahead != NULL) {
+		status = mb_readahead_read_ping(verbose, mbio_ptr, store_ptr, error);
+	}
+
+	/* else call the appropriate mbr_ read and translate routine */
+	else if (mb_io_ptr->mb_io_read_ping != NULL) {
 		status = (*mb_io_ptr->mb_io_read_ping)(verbose, mbio_ptr, store_ptr, error);
 	}
 	else {
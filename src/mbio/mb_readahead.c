@@ -0,0 +1,522 @@
+/*--------------------------------------------------------------------
+ *    The MB-system:  mb_readahead.c  10/17/2026
+ *
+ *    Copyright (c) 2026 by
+ *    David W. Caress (caress@mbari.org)
+ *      Monterey Bay Aquarium Research Institute
+ *      Moss Landing, California, USA
+ *    Dale N. Chayes
+ *      Center for Coastal and Ocean Mapping
+ *      University of New Hampshire
+ *      Durham, New Hampshire, USA
+ *    Christian dos Santos Ferreira
+ *      MARUM
+ *      University of Bremen
+ *      Bremen Germany
+ *
+ *    MB-System was created by Caress and Chayes in 1992 at the
+ *      Lamont-Doherty Earth Observatory
+ *      Columbia University
+ *      Palisades, NY 10964
+ *
+ *    See README.md file for copying and redistribution conditions.
+ *--------------------------------------------------------------------*/
+/*
+ * mb_readahead.c contains the functions that read and decode data records
+ * in a separate thread, ahead of the application, so that file i/o and
+ * format decoding overlap with the processing of earlier records.
+ *
+ * These functions include:
+ *   mb_readahead_init  - start the read-ahead thread, called by mb_read_init()
+ *   mb_readahead_read_ping  - return the next record, called by mb_read_ping()
+ *   mb_readahead_close  - stop the thread and release the queue, called by mb_close()
+ *
+ * Read-ahead is used when the readahead default (set with mbdefaults) is
+ * positive and the format has set mb_io_ptr->readahead_ok in its register
+ * function. The thread calls the format's read function on a private copy
+ * of the mbio descriptor and its own data storage structure, and copies
+ * each record with mb_io_copyrecord() into one of readahead queued storage
+ * structures. mb_read_ping() copies the queued records into the storage
+ * structure of the application in file order.
+ *
+ * Formats commonly add asynchronous navigation, attitude, heading, sensor
+ * depth and altitude to the interpolation lists in the mbio descriptor while
+ * reading. The entries added while reading each record are queued with it
+ * and added to the application's descriptor when the record is returned,
+ * so the interpolated values are the same as when reading synchronously.
+ *
+ * Formats setting readahead_ok must read single files only through the
+ * mb_fileio_*() functions, must keep all reading state in the mbio
+ * descriptor (raw_data, the save variables and the index table) or in the
+ * storage structure, and must make complete copies in mb_io_copyrecord().
+ *
+ * Author:  D. W. Caress
+ * Date:  October 17, 2026
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mb_define.h"
+#include "mb_io.h"
+#include "mb_status.h"
+
+/* asynchronous data interpolation lists in the mbio descriptor */
+#define MB_READAHEAD_NASYNCH 5
+#define MB_READAHEAD_NVALUE_MAX 3
+
+/* asynchronous data added to one interpolation list while reading a record */
+struct mb_readahead_asynch {
+  bool reset;   /* list was emptied by the format before adding */
+  int n;        /* number of entries added */
+  int nalloc;   /* number of entries allocated */
+  double *data; /* time_d followed by the values of each entry */
+};
+
+/* a record read ahead of the application */
+struct mb_readahead_record {
+  void *store;
+  int status;
+  int error;
+  int kind;
+  long file_pos;
+  long file_bytes;
+  struct mb_readahead_asynch asynch[MB_READAHEAD_NASYNCH];
+};
+
+/* read-ahead thread and record queue */
+struct mb_readahead_struct {
+  int verbose;
+  struct mb_io_struct *reader_io; /* copy of the mbio descriptor used by the thread */
+  void *reader_store;             /* storage structure used by the thread */
+  int nrecord;
+  struct mb_readahead_record *records;
+  int head;  /* next record to return */
+  int count; /* records read but not yet returned */
+  bool stop; /* thread asked to stop */
+  bool done; /* thread stopped at end of file or a fatal error */
+  int last_error;
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond_read; /* signaled when a record is queued */
+  pthread_cond_t cond_used; /* signaled when a record is returned or on stop */
+};
+
+/*--------------------------------------------------------------------*/
+static int mb_readahead_asynch_list(struct mb_io_struct *mb_io_ptr, int ilist, int **n, double **time_d,
+                                    double *values[MB_READAHEAD_NVALUE_MAX]) {
+  /* the values are in the argument order of the matching mb_*int_add() function */
+  int nvalue = 1;
+  if (ilist == 0) {
+    *n = &mb_io_ptr->nfix;
+    *time_d = mb_io_ptr->fix_time_d;
+    values[0] = mb_io_ptr->fix_lon;
+    values[1] = mb_io_ptr->fix_lat;
+    nvalue = 2;
+  }
+  else if (ilist == 1) {
+    *n = &mb_io_ptr->nattitude;
+    *time_d = mb_io_ptr->attitude_time_d;
+    values[0] = mb_io_ptr->attitude_heave;
+    values[1] = mb_io_ptr->attitude_roll;
+    values[2] = mb_io_ptr->attitude_pitch;
+    nvalue = 3;
+  }
+  else if (ilist == 2) {
+    *n = &mb_io_ptr->nheading;
+    *time_d = mb_io_ptr->heading_time_d;
+    values[0] = mb_io_ptr->heading_heading;
+  }
+  else if (ilist == 3) {
+    *n = &mb_io_ptr->nsensordepth;
+    *time_d = mb_io_ptr->sensordepth_time_d;
+    values[0] = mb_io_ptr->sensordepth_sensordepth;
+  }
+  else {
+    *n = &mb_io_ptr->naltitude;
+    *time_d = mb_io_ptr->altitude_time_d;
+    values[0] = mb_io_ptr->altitude_altitude;
+  }
+  return (nvalue);
+}
+/*--------------------------------------------------------------------*/
+static int mb_readahead_asynch_save(int verbose, struct mb_io_struct *reader_io, struct mb_readahead_record *record,
+                                    const int nbefore[MB_READAHEAD_NASYNCH], const double tbefore[MB_READAHEAD_NASYNCH],
+                                    int *error) {
+  int status = MB_SUCCESS;
+
+  for (int ilist = 0; ilist < MB_READAHEAD_NASYNCH && status == MB_SUCCESS; ilist++) {
+    struct mb_readahead_asynch *asynch = &record->asynch[ilist];
+    int *n;
+    double *time_d;
+    double *values[MB_READAHEAD_NVALUE_MAX];
+    const int nvalue = mb_readahead_asynch_list(reader_io, ilist, &n, &time_d, values);
+
+    /* the mb_*int_add() functions only append entries with increasing time
+        stamps, shifting the list by half when it is full, so the entries
+        added are those after the last entry present before the read - if
+        that entry is gone the format emptied the list */
+    int first = 0;
+    asynch->reset = false;
+    if (nbefore[ilist] > 0) {
+      int j = *n - 1;
+      while (j >= 0 && time_d[j] > tbefore[ilist])
+        j--;
+      if (j >= 0 && time_d[j] == tbefore[ilist] && (nbefore[ilist] - 1 - j) % (MB_ASYNCH_SAVE_MAX / 2) == 0)
+        first = j + 1;
+      else
+        asynch->reset = true;
+    }
+
+    asynch->n = *n - first;
+    if (asynch->n > asynch->nalloc) {
+      status = mb_reallocd(verbose, __FILE__, __LINE__, asynch->n * (1 + nvalue) * sizeof(double),
+                           (void **)&asynch->data, error);
+      if (status == MB_SUCCESS) {
+        asynch->nalloc = asynch->n;
+      }
+      else {
+        asynch->nalloc = 0;
+        asynch->n = 0;
+      }
+    }
+    for (int i = 0; i < asynch->n; i++) {
+      double *entry = &asynch->data[i * (1 + nvalue)];
+      entry[0] = time_d[first + i];
+      for (int k = 0; k < nvalue; k++)
+        entry[1 + k] = values[k][first + i];
+    }
+  }
+
+  return (status);
+}
+/*--------------------------------------------------------------------*/
+static void mb_readahead_asynch_apply(int verbose, struct mb_io_struct *mb_io_ptr, struct mb_readahead_record *record) {
+  int error = MB_ERROR_NO_ERROR;
+
+  for (int ilist = 0; ilist < MB_READAHEAD_NASYNCH; ilist++) {
+    struct mb_readahead_asynch *asynch = &record->asynch[ilist];
+    int *n;
+    double *time_d;
+    double *values[MB_READAHEAD_NVALUE_MAX];
+    const int nvalue = mb_readahead_asynch_list(mb_io_ptr, ilist, &n, &time_d, values);
+
+    if (asynch->reset)
+      *n = 0;
+    for (int i = 0; i < asynch->n; i++) {
+      const double *entry = &asynch->data[i * (1 + nvalue)];
+      if (ilist == 0)
+        mb_navint_add(verbose, mb_io_ptr, entry[0], entry[1], entry[2], &error);
+      else if (ilist == 1)
+        mb_attint_add(verbose, mb_io_ptr, entry[0], entry[1], entry[2], entry[3], &error);
+      else if (ilist == 2)
+        mb_hedint_add(verbose, mb_io_ptr, entry[0], entry[1], &error);
+      else if (ilist == 3)
+        mb_depint_add(verbose, mb_io_ptr, entry[0], entry[1], &error);
+      else
+        mb_altint_add(verbose, mb_io_ptr, entry[0], entry[1], &error);
+    }
+  }
+}
+/*--------------------------------------------------------------------*/
+static void *mb_readahead_thread(void *arg) {
+  struct mb_readahead_struct *readahead = (struct mb_readahead_struct *)arg;
+  struct mb_io_struct *reader_io = readahead->reader_io;
+  const int verbose = readahead->verbose;
+
+  bool done = false;
+  while (!done) {
+    /* wait for a free record */
+    pthread_mutex_lock(&readahead->mutex);
+    while (readahead->count == readahead->nrecord && !readahead->stop)
+      pthread_cond_wait(&readahead->cond_used, &readahead->mutex);
+    const bool stop = readahead->stop;
+    struct mb_readahead_record *record =
+        &readahead->records[(readahead->head + readahead->count) % readahead->nrecord];
+    pthread_mutex_unlock(&readahead->mutex);
+    if (stop)
+      break;
+
+    /* note the ends of the asynchronous data lists */
+    int nbefore[MB_READAHEAD_NASYNCH];
+    double tbefore[MB_READAHEAD_NASYNCH];
+    for (int ilist = 0; ilist < MB_READAHEAD_NASYNCH; ilist++) {
+      int *n;
+      double *time_d;
+      double *values[MB_READAHEAD_NVALUE_MAX];
+      mb_readahead_asynch_list(reader_io, ilist, &n, &time_d, values);
+      nbefore[ilist] = *n;
+      tbefore[ilist] = *n > 0 ? time_d[*n - 1] : 0.0;
+    }
+
+    /* read the next record */
+    int error = MB_ERROR_NO_ERROR;
+    record->status = (*reader_io->mb_io_read_ping)(verbose, reader_io, readahead->reader_store, &error);
+    record->error = error;
+    record->kind = reader_io->new_kind;
+    record->file_pos = reader_io->file_pos;
+    record->file_bytes = reader_io->file_bytes;
+
+    /* queue the asynchronous data and a copy of the record */
+    int queue_error = MB_ERROR_NO_ERROR;
+    int queue_status = mb_readahead_asynch_save(verbose, reader_io, record, nbefore, tbefore, &queue_error);
+    if (queue_status == MB_SUCCESS && record->error <= MB_ERROR_NO_ERROR)
+      queue_status = (*reader_io->mb_io_copyrecord)(verbose, reader_io, readahead->reader_store, record->store,
+                                                    &queue_error);
+    if (queue_status != MB_SUCCESS) {
+      record->status = MB_FAILURE;
+      record->error = queue_error;
+    }
+
+    /* stop at the end of the file or any other fatal error */
+    done = record->status == MB_FAILURE && record->error > MB_ERROR_NO_ERROR;
+
+    pthread_mutex_lock(&readahead->mutex);
+    readahead->count++;
+    readahead->done = done;
+    pthread_cond_signal(&readahead->cond_read);
+    pthread_mutex_unlock(&readahead->mutex);
+  }
+
+  return (NULL);
+}
+/*--------------------------------------------------------------------*/
+static void mb_readahead_free(int verbose, struct mb_io_struct *mb_io_ptr, struct mb_readahead_struct *readahead,
+                              int *error) {
+  if (readahead->records != NULL) {
+    for (int i = 0; i < readahead->nrecord; i++) {
+      if (readahead->records[i].store != NULL)
+        (*mb_io_ptr->mb_io_store_free)(verbose, mb_io_ptr, &readahead->records[i].store, error);
+      for (int ilist = 0; ilist < MB_READAHEAD_NASYNCH; ilist++)
+        if (readahead->records[i].asynch[ilist].data != NULL)
+          mb_freed(verbose, __FILE__, __LINE__, (void **)&readahead->records[i].asynch[ilist].data, error);
+    }
+    mb_freed(verbose, __FILE__, __LINE__, (void **)&readahead->records, error);
+  }
+  if (readahead->reader_store != NULL)
+    (*mb_io_ptr->mb_io_store_free)(verbose, readahead->reader_io, &readahead->reader_store, error);
+  if (readahead->reader_io != NULL)
+    mb_freed(verbose, __FILE__, __LINE__, (void **)&readahead->reader_io, error);
+  mb_freed(verbose, __FILE__, __LINE__, (void **)&readahead, error);
+}
+/*--------------------------------------------------------------------*/
+int mb_readahead_init(int verbose, void *mbio_ptr, int nrecord, int *error) {
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> called\n", __func__);
+    fprintf(stderr, "dbg2  Input arguments:\n");
+    fprintf(stderr, "dbg2       verbose:    %d\n", verbose);
+    fprintf(stderr, "dbg2       mbio_ptr:   %p\n", (void *)mbio_ptr);
+    fprintf(stderr, "dbg2       nrecord:    %d\n", nrecord);
+  }
+
+  /* get pointer to mbio descriptor */
+  struct mb_io_struct *mb_io_ptr = (struct mb_io_struct *)mbio_ptr;
+
+  int status = MB_SUCCESS;
+  *error = MB_ERROR_NO_ERROR;
+
+  /* read ahead only single files of formats that allow it - anything else
+      is read synchronously as before */
+  if (nrecord > 0 && mb_io_ptr->readahead_ok && mb_io_ptr->readahead == NULL && mb_io_ptr->filemode == MB_FILEMODE_READ &&
+      mb_io_ptr->filetype == MB_FILETYPE_SINGLE && mb_io_ptr->mbfp != NULL && mb_io_ptr->mb_io_read_ping != NULL &&
+      mb_io_ptr->mb_io_copyrecord != NULL && mb_io_ptr->mb_io_store_alloc != NULL &&
+      mb_io_ptr->mb_io_store_free != NULL) {
+    struct mb_readahead_struct *readahead = NULL;
+    status = mb_mallocd(verbose, __FILE__, __LINE__, sizeof(struct mb_readahead_struct), (void **)&readahead, error);
+    if (status == MB_SUCCESS) {
+      memset(readahead, 0, sizeof(struct mb_readahead_struct));
+      readahead->verbose = verbose;
+      readahead->nrecord = nrecord;
+      readahead->last_error = MB_ERROR_EOF;
+
+      /* the thread reads with its own copy of the descriptor and storage */
+      status = mb_mallocd(verbose, __FILE__, __LINE__, sizeof(struct mb_io_struct), (void **)&readahead->reader_io, error);
+      if (status == MB_SUCCESS) {
+        memcpy(readahead->reader_io, mb_io_ptr, sizeof(struct mb_io_struct));
+        readahead->reader_io->readahead = NULL;
+        status = (*mb_io_ptr->mb_io_store_alloc)(verbose, readahead->reader_io, &readahead->reader_store, error);
+        readahead->reader_io->store_data = readahead->reader_store;
+      }
+
+      /* allocate the queued records */
+      if (status == MB_SUCCESS) {
+        status = mb_mallocd(verbose, __FILE__, __LINE__, nrecord * sizeof(struct mb_readahead_record),
+                            (void **)&readahead->records, error);
+        if (status == MB_SUCCESS)
+          memset(readahead->records, 0, nrecord * sizeof(struct mb_readahead_record));
+      }
+      for (int i = 0; i < nrecord && status == MB_SUCCESS; i++)
+        status = (*mb_io_ptr->mb_io_store_alloc)(verbose, mb_io_ptr, &readahead->records[i].store, error);
+
+      /* start the thread */
+      if (status == MB_SUCCESS) {
+        pthread_mutex_init(&readahead->mutex, NULL);
+        pthread_cond_init(&readahead->cond_read, NULL);
+        pthread_cond_init(&readahead->cond_used, NULL);
+        if (pthread_create(&readahead->thread, NULL, mb_readahead_thread, readahead) == 0) {
+          mb_io_ptr->readahead = readahead;
+        }
+        else {
+          pthread_mutex_destroy(&readahead->mutex);
+          pthread_cond_destroy(&readahead->cond_read);
+          pthread_cond_destroy(&readahead->cond_used);
+        }
+      }
+
+      /* if the thread could not be started read synchronously */
+      if (mb_io_ptr->readahead == NULL) {
+        int free_error = MB_ERROR_NO_ERROR;
+        mb_readahead_free(verbose, mb_io_ptr, readahead, &free_error);
+        status = MB_SUCCESS;
+        *error = MB_ERROR_NO_ERROR;
+      }
+    }
+  }
+
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> completed\n", __func__);
+    fprintf(stderr, "dbg2  Return values:\n");
+    fprintf(stderr, "dbg2       readahead:  %p\n", mb_io_ptr->readahead);
+    fprintf(stderr, "dbg2       error:      %d\n", *error);
+    fprintf(stderr, "dbg2  Return status:\n");
+    fprintf(stderr, "dbg2       status:     %d\n", status);
+  }
+
+  return (status);
+}
+/*--------------------------------------------------------------------*/
+int mb_readahead_read_ping(int verbose, void *mbio_ptr, void *store_ptr, int *error) {
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> called\n", __func__);
+    fprintf(stderr, "dbg2  Input arguments:\n");
+    fprintf(stderr, "dbg2       verbose:    %d\n", verbose);
+    fprintf(stderr, "dbg2       mbio_ptr:   %p\n", (void *)mbio_ptr);
+    fprintf(stderr, "dbg2       store_ptr:  %p\n", (void *)store_ptr);
+  }
+
+  /* get pointer to mbio descriptor */
+  struct mb_io_struct *mb_io_ptr = (struct mb_io_struct *)mbio_ptr;
+  struct mb_readahead_struct *readahead = (struct mb_readahead_struct *)mb_io_ptr->readahead;
+
+  int status = MB_SUCCESS;
+
+  /* wait for the next record */
+  pthread_mutex_lock(&readahead->mutex);
+  while (readahead->count == 0 && !readahead->done)
+    pthread_cond_wait(&readahead->cond_read, &readahead->mutex);
+  struct mb_readahead_record *record = readahead->count > 0 ? &readahead->records[readahead->head] : NULL;
+  pthread_mutex_unlock(&readahead->mutex);
+
+  /* reading past the fatal error that stopped the thread repeats it */
+  if (record == NULL) {
+    status = MB_FAILURE;
+    *error = readahead->last_error;
+    mb_io_ptr->new_error = *error;
+  }
+
+  else {
+    /* add the asynchronous data read with the record */
+    mb_readahead_asynch_apply(verbose, mb_io_ptr, record);
+
+    /* copy the record to the application's storage structure */
+    status = record->status;
+    *error = record->error;
+    if (*error <= MB_ERROR_NO_ERROR) {
+      int copy_error = MB_ERROR_NO_ERROR;
+      if ((*mb_io_ptr->mb_io_copyrecord)(verbose, mbio_ptr, record->store, store_ptr, &copy_error) != MB_SUCCESS) {
+        status = MB_FAILURE;
+        *error = copy_error;
+      }
+    }
+    mb_io_ptr->new_kind = record->kind;
+    mb_io_ptr->new_error = *error;
+    mb_io_ptr->file_pos = record->file_pos;
+    mb_io_ptr->file_bytes = record->file_bytes;
+    if (*error > MB_ERROR_NO_ERROR)
+      readahead->last_error = *error;
+
+    /* release the record to the thread */
+    pthread_mutex_lock(&readahead->mutex);
+    readahead->head = (readahead->head + 1) % readahead->nrecord;
+    readahead->count--;
+    pthread_cond_signal(&readahead->cond_used);
+    pthread_mutex_unlock(&readahead->mutex);
+  }
+
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> completed\n", __func__);
+    fprintf(stderr, "dbg2  Return values:\n");
+    fprintf(stderr, "dbg2       error:      %d\n", *error);
+    fprintf(stderr, "dbg2  Return status:\n");
+    fprintf(stderr, "dbg2       status:     %d\n", status);
+  }
+
+  return (status);
+}
+/*--------------------------------------------------------------------*/
+int mb_readahead_close(int verbose, void *mbio_ptr, int *error) {
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> called\n", __func__);
+    fprintf(stderr, "dbg2  Input arguments:\n");
+    fprintf(stderr, "dbg2       verbose:    %d\n", verbose);
+    fprintf(stderr, "dbg2       mbio_ptr:   %p\n", (void *)mbio_ptr);
+  }
+
+  /* get pointer to mbio descriptor */
+  struct mb_io_struct *mb_io_ptr = (struct mb_io_struct *)mbio_ptr;
+  struct mb_readahead_struct *readahead = (struct mb_readahead_struct *)mb_io_ptr->readahead;
+
+  const int status = MB_SUCCESS;
+  *error = MB_ERROR_NO_ERROR;
+
+  if (readahead != NULL) {
+    /* stop the thread */
+    pthread_mutex_lock(&readahead->mutex);
+    readahead->stop = true;
+    pthread_cond_broadcast(&readahead->cond_used);
+    pthread_mutex_unlock(&readahead->mutex);
+    pthread_join(readahead->thread, NULL);
+    pthread_mutex_destroy(&readahead->mutex);
+    pthread_cond_destroy(&readahead->cond_read);
+    pthread_cond_destroy(&readahead->cond_used);
+
+    /* the format may have reallocated its buffers in the thread, so hand
+        the reading state back before the format frees it */
+    struct mb_io_struct *reader_io = readahead->reader_io;
+    mb_io_ptr->file_mmap_pos = reader_io->file_mmap_pos;
+    mb_io_ptr->num_indextable = reader_io->num_indextable;
+    mb_io_ptr->num_indextable_alloc = reader_io->num_indextable_alloc;
+    mb_io_ptr->indextable = reader_io->indextable;
+    mb_io_ptr->fileheader = reader_io->fileheader;
+    mb_io_ptr->hdr_comment_size = reader_io->hdr_comment_size;
+    mb_io_ptr->hdr_comment_loc = reader_io->hdr_comment_loc;
+    mb_io_ptr->hdr_comment = reader_io->hdr_comment;
+    mb_io_ptr->structure_size = reader_io->structure_size;
+    mb_io_ptr->data_structure_size = reader_io->data_structure_size;
+    mb_io_ptr->header_structure_size = reader_io->header_structure_size;
+    mb_io_ptr->raw_data = reader_io->raw_data;
+    mb_io_ptr->index_blob = reader_io->index_blob;
+    mb_io_ptr->index_blob_size = reader_io->index_blob_size;
+    memcpy(&mb_io_ptr->save_label, &reader_io->save_label,
+           offsetof(struct mb_io_struct, saveptr3) + sizeof(mb_io_ptr->saveptr3) -
+               offsetof(struct mb_io_struct, save_label));
+
+    mb_readahead_free(verbose, mb_io_ptr, readahead, error);
+    mb_io_ptr->readahead = NULL;
+  }
+
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> completed\n", __func__);
+    fprintf(stderr, "dbg2  Return values:\n");
+    fprintf(stderr, "dbg2       error:      %d\n", *error);
+    fprintf(stderr, "dbg2  Return status:\n");
+    fprintf(stderr, "dbg2       status:     %d\n", status);
+  }
+
+  return (status);
+}
+/*--------------------------------------------------------------------*/
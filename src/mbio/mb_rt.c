@@ -820,6 +820,63 @@ int mb_rt_vertical(int verbose, void *modelptr, int *error) {
 	return (status);
 }
 /*--------------------------------------------------------------------------*/
+/* Returns the layer containing depth, or -1 if depth is outside the model.
+   A depth on a layer boundary belongs to the lower layer. */
+static int mb_rt_find_layer(const struct velocity_model *model, double depth) {
+	int layer = -1;
+	for (int i = 0; i < model->number_layer; i++) {
+		if (depth >= model->layer_depth_top[i] && depth <= model->layer_depth_bottom[i])
+			layer = i;
+	}
+	return (layer);
+}
+/*--------------------------------------------------------------------------*/
+/* Returns the takeoff angle adjusted for a change in the surface sound
+   velocity according to ssv_mode, as described in mb_rt(). */
+static double mb_rt_ssv_angle(double vv_source, double source_angle, int ssv_mode, double surface_vel, double null_angle) {
+	if (ssv_mode == MB_SSV_CORRECT && surface_vel > 0.0) {
+		const double pp = sin(DTR * source_angle) / surface_vel;
+		const double vel_ratio = MIN(1.0, pp * vv_source);
+		source_angle = asin(vel_ratio) * RTD;
+	}
+	else if (ssv_mode == MB_SSV_INCORRECT && surface_vel > 0.0) {
+		double diff_angle = source_angle - null_angle;
+		const double pp = sin(DTR * diff_angle) / surface_vel;
+		const double vel_ratio = MIN(1.0, pp * vv_source);
+		diff_angle = asin(vel_ratio) * RTD;
+		source_angle = null_angle + diff_angle;
+	}
+	// else do nothing
+	return (source_angle);
+}
+/*--------------------------------------------------------------------------*/
+/* Traces the ray through the current layer, stopping at the layer boundary
+   or when the travel time is exhausted, and updates the ray status. */
+static int mb_rt_layer(int verbose, struct velocity_model *model, int *error) {
+	int status = MB_SUCCESS;
+	if (model->layer_mode[model->layer] == MB_RT_LAYER_GRADIENT && model->pp > 0.0)
+		status = mb_rt_circular(verbose, model, error);
+	else if (model->layer_mode[model->layer] == MB_RT_LAYER_GRADIENT)
+		status = mb_rt_vertical(verbose, model, error);
+	else
+		status = mb_rt_line(verbose, model, error);
+
+	/* update ray */
+	model->tt = model->tt + model->dt;
+	if (model->layer < 0) {
+		model->outofbounds = true;
+		model->ray_status = MB_RT_OUT_TOP;
+	}
+	if (model->layer >= model->number_layer) {
+		model->outofbounds = true;
+		model->ray_status = MB_RT_OUT_BOTTOM;
+	}
+	if (model->tt_left <= 0.0)
+		model->done = true;
+
+	return (status);
+}
+/*--------------------------------------------------------------------------*/
 int mb_rt(int verbose, void *modelptr, double source_depth, double source_angle, double end_time, int ssv_mode,
           double surface_vel, double null_angle, int nplot_max,
           int *nplot, double *xplot, double *zplot, double *tplot,
@@ -854,11 +911,7 @@ int mb_rt(int verbose, void *modelptr, double source_depth, double source_angle,
 	}
 
 	/* prepare the ray */
-	model->layer = -1;
-	for (int i = 0; i < model->number_layer; i++) {
-		if (source_depth >= model->layer_depth_top[i] && source_depth <= model->layer_depth_bottom[i])
-			model->layer = i;
-	}
+	model->layer = mb_rt_find_layer(model, source_depth);
 	if (verbose > 0 && model->layer == -1) {
 		fprintf(stderr, "\nError in MBIO function <%s>\n", __func__);
 		fprintf(stderr, "Ray source depth not within model!!\n");
@@ -892,20 +945,7 @@ int mb_rt(int verbose, void *modelptr, double source_depth, double source_angle,
 	      SVP at the initial depth. This insures that the geometry
 	      of the receiving transducer array is properly handled.
 	 */
-	double vel_ratio;
-	if (ssv_mode == MB_SSV_CORRECT && surface_vel > 0.0) {
-		model->pp = sin(DTR * source_angle) / surface_vel;
-		vel_ratio = MIN(1.0, model->pp * model->vv_source);
-		source_angle = asin(vel_ratio) * RTD;
-	}
-	else if (ssv_mode == MB_SSV_INCORRECT && surface_vel > 0.0) {
-		double diff_angle = source_angle - null_angle;
-		model->pp = sin(DTR * diff_angle) / surface_vel;
-		vel_ratio = MIN(1.0, model->pp * model->vv_source);
-		diff_angle = asin(vel_ratio) * RTD;
-		source_angle = null_angle + diff_angle;
-	}
-  // else do nothing
+	source_angle = mb_rt_ssv_angle(model->vv_source, source_angle, ssv_mode, surface_vel, null_angle);
 
 	/* now initialize ray */
 	if (source_angle > 0.0)
@@ -970,25 +1010,7 @@ int mb_rt(int verbose, void *modelptr, double source_depth, double source_angle,
 	/* trace the ray */
 	while (!model->done && !model->outofbounds) {
 		/* trace ray through current layer */
-		if (model->layer_mode[model->layer] == MB_RT_LAYER_GRADIENT && model->pp > 0.0)
-			status = mb_rt_circular(verbose, modelptr, error);
-		else if (model->layer_mode[model->layer] == MB_RT_LAYER_GRADIENT)
-			status = mb_rt_vertical(verbose, modelptr, error);
-		else
-			status = mb_rt_line(verbose, modelptr, error);
-
-		/* update ray */
-		model->tt = model->tt + model->dt;
-		if (model->layer < 0) {
-			model->outofbounds = true;
-			model->ray_status = MB_RT_OUT_TOP;
-		}
-		if (model->layer >= model->number_layer) {
-			model->outofbounds = true;
-			model->ray_status = MB_RT_OUT_BOTTOM;
-		}
-		if (model->tt_left <= 0.0)
-			model->done = true;
+		status = mb_rt_layer(verbose, model, error);
 
 		if (verbose >= 2) {
 			fprintf(stderr, "\ndbg2  model->done with ray iteration in MB_RT function <%s>\n", __func__);
@@ -1033,3 +1055,565 @@ int mb_rt(int verbose, void *modelptr, double source_depth, double source_angle,
 	return (status);
 }
 /*--------------------------------------------------------------------------*/
+/*--------------------------------------------------------------------------*/
+/*
+ * The raytracing table functions serve rays from tables precomputed for a
+ * velocity model. For each source depth bin the ray positions are tabulated
+ * over a grid of takeoff angle and one way travel time, and a ray is
+ * obtained by interpolating between the two depth bins bracketing its source
+ * depth. The surface sound velocity correction of mb_rt() is applied to the
+ * takeoff angle before the lookup.
+ *
+ * The interpolation error of each table cell is estimated from the second
+ * differences of the tabulated positions. Rays falling in a cell whose
+ * estimated error exceeds the requested error bound, in a cell touched by a
+ * ray leaving the model, or outside the table are traced exactly by mb_rt().
+ *
+ * The depth bins are built as they are needed and extended in travel time
+ * as longer rays are requested. Each table ray is traced once, resuming from
+ * the last layer boundary it reached for each successive time node.
+ */
+
+/* raytracing table defines */
+static const int MB_RT_TABLE_BIN_MAX = 32;
+static const int MB_RT_TABLE_NTIME_MIN = 64;
+
+/* state of a table ray at the last layer boundary it reached */
+struct rt_table_ray {
+	double xx;
+	double zz;
+	double tt;
+	double pp;
+	int layer;
+	int turned;
+	int ray_status;
+	int outofbounds;
+};
+
+/* table for one source depth */
+struct rt_table_bin {
+	double source_depth;
+	unsigned long used;
+	int ntime;
+	int ntime_alloc;
+	double *x;                  /* [itime * nangle + iangle] */
+	double *z;                  /* [itime * nangle + iangle] */
+	char *ray_status;           /* [itime * nangle + iangle] */
+	char *cell_ok;              /* [itime * (nangle - 1) + iangle] */
+	struct rt_table_ray *ray;   /* [iangle] */
+};
+
+struct rt_table {
+	struct velocity_model *model;
+
+	/* table dimensions */
+	int nangle;
+	double angle_interval;
+	double angle_max;
+	int ntime_max;
+	double ttime_interval;
+	double ttime_max;
+	int ndepth;
+	double depth_interval;
+	double depth_min;
+	double error_bound;
+
+	/* source depth bins, built when needed */
+	struct rt_table_bin **bin;
+	int nbin;
+	unsigned long clock;
+
+	/* work arrays for the interpolated rays */
+	int nwork_alloc;
+	int *work_ray;
+	double *work_wa;
+	double *work_wt;
+	double *work_wd;
+	double *work_x;             /* [iwork * 8 + corner] */
+	double *work_z;             /* [iwork * 8 + corner] */
+
+	/* statistics */
+	long ninterpolated;
+	long nexact;
+};
+
+/*--------------------------------------------------------------------------*/
+int mb_rt_table_init(int verbose, void *modelptr, double angle_max, double angle_interval, double ttime_max,
+                     double ttime_interval, double depth_interval, double error_bound, void **tableptr, int *error) {
+	if (verbose >= 2) {
+		fprintf(stderr, "\ndbg2  MBIO function <%s> called\n", __func__);
+		fprintf(stderr, "dbg2  Input arguments:\n");
+		fprintf(stderr, "dbg2       verbose:          %d\n", verbose);
+		fprintf(stderr, "dbg2       modelptr:         %p\n", modelptr);
+		fprintf(stderr, "dbg2       angle_max:        %f\n", angle_max);
+		fprintf(stderr, "dbg2       angle_interval:   %f\n", angle_interval);
+		fprintf(stderr, "dbg2       ttime_max:        %f\n", ttime_max);
+		fprintf(stderr, "dbg2       ttime_interval:   %f\n", ttime_interval);
+		fprintf(stderr, "dbg2       depth_interval:   %f\n", depth_interval);
+		fprintf(stderr, "dbg2       error_bound:      %f\n", error_bound);
+		fprintf(stderr, "dbg2       tableptr:         %p\n", (void *)tableptr);
+	}
+
+	struct velocity_model *model = (struct velocity_model *)modelptr;
+
+	int status = MB_SUCCESS;
+	*tableptr = NULL;
+
+	/* check the table dimensions */
+	if (model == NULL || model->number_layer < 1 || angle_max <= 0.0 || angle_max >= 90.0 || angle_interval <= 0.0 ||
+	    2.0 * angle_interval >= 90.0 || ttime_max <= 0.0 || ttime_interval <= 0.0 || depth_interval <= 0.0 ||
+	    error_bound <= 0.0) {
+		status = MB_FAILURE;
+		*error = MB_ERROR_BAD_PARAMETER;
+	}
+
+	/* allocate the table */
+	if (status == MB_SUCCESS)
+		status = mb_mallocd(verbose, __FILE__, __LINE__, sizeof(struct rt_table), tableptr, error);
+	if (status == MB_SUCCESS) {
+		struct rt_table *table = (struct rt_table *)*tableptr;
+		memset(table, 0, sizeof(struct rt_table));
+		table->model = model;
+		table->nangle = (int)ceil(angle_max / angle_interval) + 1;
+		while ((table->nangle - 1) * angle_interval >= 90.0)
+			table->nangle--;
+		table->nangle = MAX(3, table->nangle);
+		table->angle_interval = angle_interval;
+		table->angle_max = (table->nangle - 1) * angle_interval;
+		table->ntime_max = MAX(3, (int)ceil(ttime_max / ttime_interval) + 1);
+		table->ttime_interval = ttime_interval;
+		table->ttime_max = (table->ntime_max - 1) * ttime_interval;
+		table->depth_interval = depth_interval;
+		table->depth_min = model->depth[0];
+		table->ndepth = (int)floor((model->depth[model->number_node - 1] - model->depth[0]) / depth_interval) + 1;
+		table->error_bound = error_bound;
+		status = mb_mallocd(verbose, __FILE__, __LINE__, table->ndepth * sizeof(struct rt_table_bin *),
+		                    (void **)&table->bin, error);
+		if (status == MB_SUCCESS)
+			memset(table->bin, 0, table->ndepth * sizeof(struct rt_table_bin *));
+		else
+			mb_freed(verbose, __FILE__, __LINE__, tableptr, error);
+	}
+
+	if (verbose >= 2) {
+		fprintf(stderr, "\ndbg2  MBIO function <%s> completed\n", __func__);
+		fprintf(stderr, "dbg2  Return values:\n");
+		fprintf(stderr, "dbg2       tableptr:   %p\n", (void *)*tableptr);
+		fprintf(stderr, "dbg2       error:      %d\n", *error);
+		fprintf(stderr, "dbg2  Return status:\n");
+		fprintf(stderr, "dbg2       status:     %d\n", status);
+	}
+
+	return (status);
+}
+/*--------------------------------------------------------------------------*/
+static void mb_rt_table_free_bin(int verbose, struct rt_table *table, int ibin, int *error) {
+	struct rt_table_bin *bin = table->bin[ibin];
+	if (bin == NULL)
+		return;
+	mb_freed(verbose, __FILE__, __LINE__, (void **)&bin->x, error);
+	mb_freed(verbose, __FILE__, __LINE__, (void **)&bin->z, error);
+	mb_freed(verbose, __FILE__, __LINE__, (void **)&bin->ray_status, error);
+	mb_freed(verbose, __FILE__, __LINE__, (void **)&bin->cell_ok, error);
+	mb_freed(verbose, __FILE__, __LINE__, (void **)&bin->ray, error);
+	mb_freed(verbose, __FILE__, __LINE__, (void **)&table->bin[ibin], error);
+	table->nbin--;
+}
+/*--------------------------------------------------------------------------*/
+int mb_rt_table_deall(int verbose, void **tableptr, int *error) {
+	if (verbose >= 2) {
+		fprintf(stderr, "\ndbg2  MBIO function <%s> called\n", __func__);
+		fprintf(stderr, "dbg2  Input arguments:\n");
+		fprintf(stderr, "dbg2       verbose:          %d\n", verbose);
+		fprintf(stderr, "dbg2       tableptr:         %p\n", (void *)tableptr);
+	}
+
+	int status = MB_SUCCESS;
+
+	struct rt_table *table = (struct rt_table *)*tableptr;
+	if (table != NULL) {
+		if (verbose >= 1) {
+			fprintf(stderr, "\nRaytracing table: %ld rays interpolated, %ld rays traced\n", table->ninterpolated,
+			        table->nexact);
+		}
+		for (int ibin = 0; ibin < table->ndepth; ibin++)
+			mb_rt_table_free_bin(verbose, table, ibin, error);
+		mb_freed(verbose, __FILE__, __LINE__, (void **)&table->bin, error);
+		mb_freed(verbose, __FILE__, __LINE__, (void **)&table->work_ray, error);
+		mb_freed(verbose, __FILE__, __LINE__, (void **)&table->work_wa, error);
+		mb_freed(verbose, __FILE__, __LINE__, (void **)&table->work_wt, error);
+		mb_freed(verbose, __FILE__, __LINE__, (void **)&table->work_wd, error);
+		mb_freed(verbose, __FILE__, __LINE__, (void **)&table->work_x, error);
+		mb_freed(verbose, __FILE__, __LINE__, (void **)&table->work_z, error);
+		status = mb_freed(verbose, __FILE__, __LINE__, tableptr, error);
+	}
+
+	if (verbose >= 2) {
+		fprintf(stderr, "\ndbg2  MBIO function <%s> completed\n", __func__);
+		fprintf(stderr, "dbg2  Return values:\n");
+		fprintf(stderr, "dbg2       error:      %d\n", *error);
+		fprintf(stderr, "dbg2  Return status:\n");
+		fprintf(stderr, "dbg2       status:     %d\n", status);
+	}
+
+	return (status);
+}
+/*--------------------------------------------------------------------------*/
+/* Traces the table ray for angle iangle from its saved state through the
+   time nodes itime_start to itime_end - 1. */
+static int mb_rt_table_trace(int verbose, struct rt_table *table, struct rt_table_bin *bin, int iangle, int itime_start,
+                             int itime_end, int *error) {
+	struct velocity_model *model = table->model;
+	struct rt_table_ray *ray = &bin->ray[iangle];
+
+	model->xx = ray->xx;
+	model->zz = ray->zz;
+	model->tt = ray->tt;
+	model->pp = ray->pp;
+	model->layer = ray->layer;
+	model->turned = ray->turned;
+	model->ray_status = ray->ray_status;
+	model->outofbounds = ray->outofbounds;
+	model->sign_x = 1;
+	model->plot_mode = MB_RT_PLOT_MODE_OFF;
+	model->number_plot_max = 0;
+	model->number_plot = 0;
+
+	int status = MB_SUCCESS;
+	for (int itime = itime_start; itime < itime_end; itime++) {
+		const double ttime = itime * table->ttime_interval;
+		const int k = itime * table->nangle + iangle;
+		double xx = model->xx;
+		double zz = model->zz;
+		int ray_status = model->ray_status;
+
+		/* trace whole layers until the time node falls in the current
+		   layer, then trace to the node without leaving the layer boundary */
+		while (!model->outofbounds && model->tt < ttime) {
+			const double xx_save = model->xx;
+			const double zz_save = model->zz;
+			const double tt_save = model->tt;
+			const int layer_save = model->layer;
+			const int turned_save = model->turned;
+			const int ray_status_save = model->ray_status;
+
+			model->tt_left = ttime - model->tt;
+			model->done = false;
+			status = mb_rt_layer(verbose, model, error);
+			xx = model->xf;
+			zz = model->zf;
+			ray_status = model->ray_status;
+			if (model->outofbounds) {
+				model->xx = model->xf;
+				model->zz = model->zf;
+			}
+			else if (model->done) {
+				model->xx = xx_save;
+				model->zz = zz_save;
+				model->tt = tt_save;
+				model->layer = layer_save;
+				model->turned = turned_save;
+				model->ray_status = ray_status_save;
+				break;
+			}
+			else {
+				model->xx = model->xf;
+				model->zz = model->zf;
+			}
+		}
+		bin->x[k] = xx;
+		bin->z[k] = zz;
+		bin->ray_status[k] = (char)ray_status;
+	}
+
+	ray->xx = model->xx;
+	ray->zz = model->zz;
+	ray->tt = model->tt;
+	ray->layer = model->layer;
+	ray->turned = model->turned;
+	ray->ray_status = model->ray_status;
+	ray->outofbounds = model->outofbounds;
+
+	return (status);
+}
+/*--------------------------------------------------------------------------*/
+/* Returns the larger of the second differences of x and z about node k,
+   using the neighbours at k - step and k + step. */
+static double mb_rt_table_curvature(const struct rt_table_bin *bin, int k, int step) {
+	if (bin->ray_status[k - step] >= MB_RT_OUT_BOTTOM || bin->ray_status[k] >= MB_RT_OUT_BOTTOM ||
+	    bin->ray_status[k + step] >= MB_RT_OUT_BOTTOM)
+		return (INFINITY);
+	const double d2x = fabs(bin->x[k - step] - 2.0 * bin->x[k] + bin->x[k + step]);
+	const double d2z = fabs(bin->z[k - step] - 2.0 * bin->z[k] + bin->z[k + step]);
+	return (MAX(d2x, d2z));
+}
+/*--------------------------------------------------------------------------*/
+/* Flags the cells of a bin whose bilinear interpolation error, estimated
+   from the second differences at the cell corners, is within the error
+   bound. */
+static void mb_rt_table_check_cells(struct rt_table *table, struct rt_table_bin *bin) {
+	const int nangle = table->nangle;
+	const int ntime = bin->ntime;
+	for (int itime = 0; itime < ntime - 1; itime++) {
+		for (int iangle = 0; iangle < nangle - 1; iangle++) {
+			double curvature_angle = 0.0;
+			double curvature_time = 0.0;
+			for (int jtime = itime; jtime <= itime + 1; jtime++) {
+				for (int jangle = iangle; jangle <= iangle + 1; jangle++) {
+					const int kangle = MIN(MAX(jangle, 1), nangle - 2);
+					const int ktime = MIN(MAX(jtime, 1), ntime - 2);
+					curvature_angle = MAX(curvature_angle, mb_rt_table_curvature(bin, jtime * nangle + kangle, 1));
+					curvature_time = MAX(curvature_time, mb_rt_table_curvature(bin, ktime * nangle + jangle, nangle));
+				}
+			}
+			bin->cell_ok[itime * (nangle - 1) + iangle] = (0.125 * (curvature_angle + curvature_time) <= table->error_bound);
+		}
+	}
+}
+/*--------------------------------------------------------------------------*/
+/* Returns the table for depth bin ibin with at least ntime time nodes,
+   building or extending it as needed. The least recently used bin other
+   than ibin_keep is released if too many bins are held. */
+static struct rt_table_bin *mb_rt_table_get_bin(int verbose, struct rt_table *table, int ibin, int ntime, int ibin_keep,
+                                                 int *error) {
+	struct velocity_model *model = table->model;
+	const int nangle = table->nangle;
+	struct rt_table_bin *bin = table->bin[ibin];
+
+	/* start a new bin */
+	if (bin == NULL) {
+		if (table->nbin >= MB_RT_TABLE_BIN_MAX) {
+			int ibin_old = -1;
+			for (int jbin = 0; jbin < table->ndepth; jbin++) {
+				if (table->bin[jbin] != NULL && jbin != ibin_keep &&
+				    (ibin_old < 0 || table->bin[jbin]->used < table->bin[ibin_old]->used))
+					ibin_old = jbin;
+			}
+			mb_rt_table_free_bin(verbose, table, ibin_old, error);
+		}
+
+		if (mb_mallocd(verbose, __FILE__, __LINE__, sizeof(struct rt_table_bin), (void **)&table->bin[ibin], error) !=
+		    MB_SUCCESS)
+			return (NULL);
+		bin = table->bin[ibin];
+		memset(bin, 0, sizeof(struct rt_table_bin));
+		table->nbin++;
+		if (mb_mallocd(verbose, __FILE__, __LINE__, nangle * sizeof(struct rt_table_ray), (void **)&bin->ray, error) !=
+		    MB_SUCCESS) {
+			mb_rt_table_free_bin(verbose, table, ibin, error);
+			return (NULL);
+		}
+
+		/* start the table rays at the source depth */
+		bin->source_depth = table->depth_min + ibin * table->depth_interval;
+		const int layer = mb_rt_find_layer(model, bin->source_depth);
+		double vv_source = 0.0;
+		if (layer >= 0)
+			vv_source = model->layer_vel_top[layer] +
+			            model->layer_gradient[layer] * (bin->source_depth - model->layer_depth_top[layer]);
+		for (int iangle = 0; iangle < nangle; iangle++) {
+			struct rt_table_ray *ray = &bin->ray[iangle];
+			ray->xx = 0.0;
+			ray->zz = bin->source_depth;
+			ray->tt = 0.0;
+			ray->pp = layer >= 0 ? sin(DTR * iangle * table->angle_interval) / vv_source : 0.0;
+			ray->layer = layer;
+			ray->turned = false;
+			ray->ray_status = layer >= 0 ? MB_RT_DOWN : MB_RT_OUT_BOTTOM;
+			ray->outofbounds = layer < 0;
+		}
+	}
+	bin->used = ++table->clock;
+
+	/* extend the bin in travel time */
+	if (bin->ntime < ntime) {
+		const int ntime_old = bin->ntime;
+		ntime = MIN(table->ntime_max, MAX(MAX(ntime + ntime / 4, 3 * ntime_old / 2), MB_RT_TABLE_NTIME_MIN));
+		const size_t nnode = (size_t)ntime * nangle;
+		if (mb_reallocd(verbose, __FILE__, __LINE__, nnode * sizeof(double), (void **)&bin->x, error) != MB_SUCCESS ||
+		    mb_reallocd(verbose, __FILE__, __LINE__, nnode * sizeof(double), (void **)&bin->z, error) != MB_SUCCESS ||
+		    mb_reallocd(verbose, __FILE__, __LINE__, nnode * sizeof(char), (void **)&bin->ray_status, error) != MB_SUCCESS ||
+		    mb_reallocd(verbose, __FILE__, __LINE__, (size_t)(ntime - 1) * (nangle - 1) * sizeof(char),
+		                (void **)&bin->cell_ok, error) != MB_SUCCESS) {
+			mb_rt_table_free_bin(verbose, table, ibin, error);
+			return (NULL);
+		}
+		for (int iangle = 0; iangle < nangle; iangle++)
+			mb_rt_table_trace(verbose, table, bin, iangle, ntime_old, ntime, error);
+		bin->ntime = ntime;
+		mb_rt_table_check_cells(table, bin);
+	}
+
+	return (bin);
+}
+/*--------------------------------------------------------------------------*/
+int mb_rt_table(int verbose, void *tableptr, int nray, double *source_depth, double *source_angle, double *end_time,
+                int ssv_mode, double surface_vel, double *null_angle, double *x, double *z, double *travel_time,
+                int *ray_stat, int *error) {
+	if (verbose >= 2) {
+		fprintf(stderr, "\ndbg2  MBIO function <%s> called\n", __func__);
+		fprintf(stderr, "dbg2  Input arguments:\n");
+		fprintf(stderr, "dbg2       verbose:          %d\n", verbose);
+		fprintf(stderr, "dbg2       tableptr:         %p\n", tableptr);
+		fprintf(stderr, "dbg2       nray:             %d\n", nray);
+		fprintf(stderr, "dbg2       ssv_mode:         %d\n", ssv_mode);
+		fprintf(stderr, "dbg2       surface_vel:      %f\n", surface_vel);
+		fprintf(stderr, "dbg2       ray source_depth source_angle end_time null_angle:\n");
+		for (int iray = 0; iray < nray; iray++)
+			fprintf(stderr, "dbg2       %d %f %f %f %f\n", iray, source_depth[iray], source_angle[iray], end_time[iray],
+			        null_angle[iray]);
+	}
+
+	struct rt_table *table = (struct rt_table *)tableptr;
+	struct velocity_model *model = table->model;
+	const int nangle = table->nangle;
+
+	int status = MB_SUCCESS;
+
+	/* make sure the work arrays are large enough */
+	if (table->nwork_alloc < nray) {
+		if (mb_reallocd(verbose, __FILE__, __LINE__, nray * sizeof(int), (void **)&table->work_ray, error) != MB_SUCCESS ||
+		    mb_reallocd(verbose, __FILE__, __LINE__, nray * sizeof(double), (void **)&table->work_wa, error) != MB_SUCCESS ||
+		    mb_reallocd(verbose, __FILE__, __LINE__, nray * sizeof(double), (void **)&table->work_wt, error) != MB_SUCCESS ||
+		    mb_reallocd(verbose, __FILE__, __LINE__, nray * sizeof(double), (void **)&table->work_wd, error) != MB_SUCCESS ||
+		    mb_reallocd(verbose, __FILE__, __LINE__, 8 * nray * sizeof(double), (void **)&table->work_x, error) != MB_SUCCESS ||
+		    mb_reallocd(verbose, __FILE__, __LINE__, 8 * nray * sizeof(double), (void **)&table->work_z, error) != MB_SUCCESS) {
+			table->nwork_alloc = 0;
+			return (MB_FAILURE);
+		}
+		table->nwork_alloc = nray;
+	}
+
+	/* locate each ray in the table and gather the corners of its cell in
+	   the two bracketing depth bins, tracing the rays outside the table */
+	int nwork = 0;
+	for (int iray = 0; iray < nray; iray++) {
+		bool use_table = false;
+		const int layer = mb_rt_find_layer(model, source_depth[iray]);
+		const double fdepth = (source_depth[iray] - table->depth_min) / table->depth_interval;
+		const int ibin = (int)floor(fdepth);
+		if (layer >= 0 && end_time[iray] >= 0.0 && end_time[iray] <= table->ttime_max && ibin >= 0 &&
+		    ibin < table->ndepth - 1) {
+			const double vv_source = model->layer_vel_top[layer] +
+			                         model->layer_gradient[layer] * (source_depth[iray] - model->layer_depth_top[layer]);
+			const double angle =
+			    mb_rt_ssv_angle(vv_source, source_angle[iray], ssv_mode, surface_vel, null_angle[iray]);
+			if (fabs(angle) <= table->angle_max) {
+				const double fangle = fabs(angle) / table->angle_interval;
+				const double ftime = end_time[iray] / table->ttime_interval;
+				const int iangle = MIN((int)fangle, nangle - 2);
+				const int itime = MIN((int)ftime, table->ntime_max - 2);
+				struct rt_table_bin *bin0 = mb_rt_table_get_bin(verbose, table, ibin, itime + 2, ibin + 1, error);
+				struct rt_table_bin *bin1 =
+				    bin0 != NULL ? mb_rt_table_get_bin(verbose, table, ibin + 1, itime + 2, ibin, error) : NULL;
+				const int kcell = itime * (nangle - 1) + iangle;
+				if (bin0 != NULL && bin1 != NULL && bin0->cell_ok[kcell] && bin1->cell_ok[kcell]) {
+					use_table = true;
+					const int k = itime * nangle + iangle;
+					const int corner[4] = {k, k + 1, k + nangle, k + nangle + 1};
+					for (int icorner = 0; icorner < 4; icorner++) {
+						table->work_x[8 * nwork + icorner] = bin0->x[corner[icorner]];
+						table->work_z[8 * nwork + icorner] = bin0->z[corner[icorner]];
+						table->work_x[8 * nwork + 4 + icorner] = bin1->x[corner[icorner]];
+						table->work_z[8 * nwork + 4 + icorner] = bin1->z[corner[icorner]];
+					}
+					table->work_ray[nwork] = iray;
+					table->work_wa[nwork] = fangle - iangle;
+					table->work_wt[nwork] = ftime - itime;
+					table->work_wd[nwork] = fdepth - ibin;
+					if (ray_stat != NULL) {
+						const int knear = (ftime - itime < 0.5 ? k : k + nangle) + (fangle - iangle < 0.5 ? 0 : 1);
+						ray_stat[iray] = bin0->ray_status[knear];
+					}
+					nwork++;
+				}
+			}
+		}
+
+		if (!use_table) {
+			double ttime;
+			int rstat;
+			if (mb_rt(verbose, model, source_depth[iray], source_angle[iray], end_time[iray], ssv_mode, surface_vel,
+			          null_angle[iray], 0, NULL, NULL, NULL, NULL, &x[iray], &z[iray], &ttime, &rstat, error) != MB_SUCCESS) {
+				status = MB_FAILURE;
+				x[iray] = 0.0;
+				z[iray] = source_depth[iray];
+				ttime = 0.0;
+				rstat = MB_RT_OUT_BOTTOM;
+			}
+			if (travel_time != NULL)
+				travel_time[iray] = ttime;
+			if (ray_stat != NULL)
+				ray_stat[iray] = rstat;
+			table->nexact++;
+		}
+	}
+
+	/* interpolate the gathered rays */
+	const double *work_x = table->work_x;
+	const double *work_z = table->work_z;
+	for (int iwork = 0; iwork < nwork; iwork++) {
+		const double wa = table->work_wa[iwork];
+		const double wt = table->work_wt[iwork];
+		const double wd = table->work_wd[iwork];
+		const double w[8] = {(1.0 - wd) * (1.0 - wt) * (1.0 - wa), (1.0 - wd) * (1.0 - wt) * wa,
+		                     (1.0 - wd) * wt * (1.0 - wa),         (1.0 - wd) * wt * wa,
+		                     wd * (1.0 - wt) * (1.0 - wa),         wd * (1.0 - wt) * wa,
+		                     wd * wt * (1.0 - wa),                 wd * wt * wa};
+		double xsum = 0.0;
+		double zsum = 0.0;
+		for (int icorner = 0; icorner < 8; icorner++) {
+			xsum += w[icorner] * work_x[8 * iwork + icorner];
+			zsum += w[icorner] * work_z[8 * iwork + icorner];
+		}
+		const int iray = table->work_ray[iwork];
+		x[iray] = xsum;
+		z[iray] = zsum;
+		if (travel_time != NULL)
+			travel_time[iray] = end_time[iray];
+	}
+	table->ninterpolated += nwork;
+
+	if (verbose >= 2) {
+		fprintf(stderr, "\ndbg2  MBIO function <%s> completed\n", __func__);
+		fprintf(stderr, "dbg2  Return values:\n");
+		fprintf(stderr, "dbg2       ray x z ray_stat:\n");
+		for (int iray = 0; iray < nray; iray++)
+			fprintf(stderr, "dbg2       %d %f %f %d\n", iray, x[iray], z[iray], ray_stat != NULL ? ray_stat[iray] : 0);
+		fprintf(stderr, "dbg2       error:      %d\n", *error);
+		fprintf(stderr, "dbg2  Return status:\n");
+		fprintf(stderr, "dbg2       status:     %d\n", status);
+	}
+
+	return (status);
+}
+/*--------------------------------------------------------------------------*/
+int mb_rt_table_stats(int verbose, void *tableptr, int *nbin, long *ninterpolated, long *nexact, int *error) {
+	if (verbose >= 2) {
+		fprintf(stderr, "\ndbg2  MBIO function <%s> called\n", __func__);
+		fprintf(stderr, "dbg2  Input arguments:\n");
+		fprintf(stderr, "dbg2       verbose:          %d\n", verbose);
+		fprintf(stderr, "dbg2       tableptr:         %p\n", tableptr);
+	}
+
+	struct rt_table *table = (struct rt_table *)tableptr;
+	*nbin = table->nbin;
+	*ninterpolated = table->ninterpolated;
+	*nexact = table->nexact;
+
+	const int status = MB_SUCCESS;
+
+	if (verbose >= 2) {
+		fprintf(stderr, "\ndbg2  MBIO function <%s> completed\n", __func__);
+		fprintf(stderr, "dbg2  Return values:\n");
+		fprintf(stderr, "dbg2       nbin:          %d\n", *nbin);
+		fprintf(stderr, "dbg2       ninterpolated: %ld\n", *ninterpolated);
+		fprintf(stderr, "dbg2       nexact:        %ld\n", *nexact);
+		fprintf(stderr, "dbg2       error:         %d\n", *error);
+		fprintf(stderr, "dbg2  Return status:\n");
+		fprintf(stderr, "dbg2       status:     %d\n", status);
+	}
+
+	return (status);
+}
+/*--------------------------------------------------------------------------*/
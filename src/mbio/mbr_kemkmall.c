@@ -4011,6 +4011,7 @@ int mbr_kemkmall_index_data(int verbose, void *mbio_ptr, void *store_ptr, int *e
   int iip_location = -1;
   const int HEADER_SKIP = 8;
   unsigned short pingCnt = 0;
+  int fileio_error = MB_ERROR_NO_ERROR;
 
   if (verbose >= 2) {
     fprintf(stderr, "\ndbg2  MBIO function <%s> called\n", __func__);
@@ -4041,9 +4042,45 @@ int mbr_kemkmall_index_data(int verbose, void *mbio_ptr, void *store_ptr, int *e
   file_indexed = (int *)&mb_io_ptr->save2;
   *file_indexed = false;
 
-  /* set file position to the start */
-  fseek(mb_io_ptr->mbfp, 0, SEEK_SET);
-  mb_io_ptr->file_pos = ftell(mb_io_ptr->mbfp);
+  /* if a current sidecar index (file.idx) holds the sorted datagram index
+     table from an earlier scan, use it rather than scanning the file again */
+  void *blob = NULL;
+  size_t blob_size = 0;
+  int blob_error = MB_ERROR_NO_ERROR;
+  if (mb_index_get_blob(verbose, mbio_ptr, &blob, &blob_size, &blob_error) == MB_SUCCESS
+      && blob_size % sizeof(struct mbsys_kmbes_index) == 0) {
+    const size_t dgm_count = blob_size / sizeof(struct mbsys_kmbes_index);
+    int status = mb_reallocd(verbose, __FILE__, __LINE__, blob_size,
+                             (void **)(&dgm_index_table->indextable), error);
+    if (status == MB_SUCCESS) {
+      memcpy(dgm_index_table->indextable, blob, blob_size);
+      dgm_index_table->dgm_count = dgm_count;
+      dgm_index_table->num_alloc = dgm_count;
+      for (size_t i = 0; i < dgm_count; i++) {
+        if (dgm_index_table->indextable[i].emdgm_type == MWC)
+          store->xmb.watercolumn = 1;
+      }
+      *file_indexed = true;
+      mb_io_ptr->index_blob = (void *)dgm_index_table->indextable;
+      mb_io_ptr->index_blob_size = blob_size;
+      mb_fileio_seek(verbose, mbio_ptr, 0, SEEK_SET, &fileio_error);
+
+      if (verbose >= 2) {
+        fprintf(stderr, "\ndbg2  MBIO function <%s> completed\n", __func__);
+        fprintf(stderr, "dbg2  Return values:\n");
+        fprintf(stderr, "dbg2       dgm_count:  %zu\n", dgm_count);
+        fprintf(stderr, "dbg2       error:      %d\n", *error);
+        fprintf(stderr, "dbg2  Return status:\n");
+        fprintf(stderr, "dbg2       status:  %d\n", status);
+      }
+      return (status);
+    }
+  }
+
+  /* set file position to the start - the file is positioned only through
+     mb_fileio_seek() so that memory mapped input can be used */
+  mb_fileio_seek(verbose, mbio_ptr, 0, SEEK_SET, &fileio_error);
+  mb_fileio_tell(verbose, mbio_ptr, &mb_io_ptr->file_pos, &fileio_error);
 
   /* set status */
   int status = MB_SUCCESS;
@@ -4072,6 +4109,8 @@ int mbr_kemkmall_index_data(int verbose, void *mbio_ptr, void *store_ptr, int *e
 
     /* report problem */
     if (status == MB_SUCCESS && skip > 0 && verbose >= 0) {
+      long skip_pos = 0;
+      mb_fileio_tell(verbose, mbio_ptr, &skip_pos, &fileio_error);
       fprintf(stderr, "\nThe MBF_KEMKMALL module skipped data between identified\n"
               "data records. Something is broken, most likely the data...\n"
               "However, the data may include a data record type that we\n"
@@ -4082,7 +4121,7 @@ int mbr_kemkmall_index_data(int verbose, void *mbio_ptr, void *store_ptr, int *e
               "and make a data sample available. \n"
               "Have a nice day...\n");
       fprintf(stderr, "MBF_KEMKMALL skipped %d bytes before record %.4s at file pos %ld\n",
-                      skip, header.dgmType, ftell(mb_io_ptr->mbfp));
+                      skip, header.dgmType, skip_pos);
     }
 
     /* now parse the header and index the datagram */
@@ -4090,9 +4129,10 @@ int mbr_kemkmall_index_data(int verbose, void *mbio_ptr, void *store_ptr, int *e
 
       /* verify datagram is intact - seek to end of the datagram and read last int
          - make survey mb_io_ptr->file_pos records the position of the start of the datagram */
-      mb_io_ptr->file_pos = ftell(mb_io_ptr->mbfp) - MBSYS_KMBES_HEADER_SIZE;
+      mb_fileio_tell(verbose, mbio_ptr, &mb_io_ptr->file_pos, &fileio_error);
+      mb_io_ptr->file_pos -= MBSYS_KMBES_HEADER_SIZE;
       offset = (header.numBytesDgm - MBSYS_KMBES_HEADER_SIZE - sizeof(int));
-      fseek(mb_io_ptr->mbfp, offset, SEEK_CUR);
+      mb_fileio_seek(verbose, mbio_ptr, offset, SEEK_CUR, &fileio_error);
 
       read_len = sizeof(int);
       status = mb_fileio_get(verbose, mbio_ptr, (void *)&buffer[0], &read_len, error);
@@ -4111,7 +4151,7 @@ int mbr_kemkmall_index_data(int verbose, void *mbio_ptr, void *store_ptr, int *e
                 header.dgmType, mb_io_ptr->file_pos, header.numBytesDgm, num_bytes_dgm_end);
 #endif
           mb_io_ptr->file_pos += HEADER_SKIP;
-          fseek(mb_io_ptr->mbfp, mb_io_ptr->file_pos, SEEK_SET);
+          mb_fileio_seek(verbose, mbio_ptr, mb_io_ptr->file_pos, SEEK_SET, &fileio_error);
           emdgm_type = UNKNOWN;
           // valid_id = false;
         }
@@ -4138,7 +4178,7 @@ int mbr_kemkmall_index_data(int verbose, void *mbio_ptr, void *store_ptr, int *e
             /* get ping info */
             /* skip past the header and the 2 shorts that make up the dgm partition part */
             offset = (mb_io_ptr->file_pos + MBSYS_KMBES_HEADER_SIZE + sizeof(int));
-            fseek(mb_io_ptr->mbfp, offset, SEEK_SET);
+            mb_fileio_seek(verbose, mbio_ptr, offset, SEEK_SET, &fileio_error);
 
             read_len = 12;
             status = mb_fileio_get(verbose, mbio_ptr, (void *)&buffer[0], &read_len, error);
@@ -4192,7 +4232,7 @@ int mbr_kemkmall_index_data(int verbose, void *mbio_ptr, void *store_ptr, int *e
 
             if (status == MB_SUCCESS) {
               offset = (size_t) (mb_io_ptr->file_pos + header.numBytesDgm);
-              fseek(mb_io_ptr->mbfp, offset, SEEK_SET);
+              mb_fileio_seek(verbose, mbio_ptr, offset, SEEK_SET, &fileio_error);
             }
             // TODO: what happens if alloc fails - while condition?
             break;
@@ -4205,7 +4245,7 @@ int mbr_kemkmall_index_data(int verbose, void *mbio_ptr, void *store_ptr, int *e
             /* get ping info */
             /* skip past the header and the 2 shorts that make up the dgm partition part */
             offset = (mb_io_ptr->file_pos + MBSYS_KMBES_HEADER_SIZE + sizeof(int));
-            fseek(mb_io_ptr->mbfp, offset, SEEK_SET);
+            mb_fileio_seek(verbose, mbio_ptr, offset, SEEK_SET, &fileio_error);
 
             read_len = 12;
             status = mb_fileio_get(verbose, mbio_ptr, (void *)&buffer[0], &read_len, error);
@@ -4259,7 +4299,7 @@ int mbr_kemkmall_index_data(int verbose, void *mbio_ptr, void *store_ptr, int *e
 
             if (status == MB_SUCCESS) {
               offset = (size_t) (mb_io_ptr->file_pos + header.numBytesDgm);
-              fseek(mb_io_ptr->mbfp, offset, SEEK_SET);
+              mb_fileio_seek(verbose, mbio_ptr, offset, SEEK_SET, &fileio_error);
             }
             // TODO: what happens if alloc fails - while condition?
             break;
@@ -4272,7 +4312,7 @@ int mbr_kemkmall_index_data(int verbose, void *mbio_ptr, void *store_ptr, int *e
             /* get ping info */
             /* skip past the header and the 2 shorts that make up the dgm partition part */
             offset = (mb_io_ptr->file_pos + MBSYS_KMBES_HEADER_SIZE + sizeof(int));
-            fseek(mb_io_ptr->mbfp, offset, SEEK_SET);
+            mb_fileio_seek(verbose, mbio_ptr, offset, SEEK_SET, &fileio_error);
 
             read_len = 12;
             status = mb_fileio_get(verbose, mbio_ptr, (void *)&buffer[0], &read_len, error);
@@ -4307,7 +4347,7 @@ int mbr_kemkmall_index_data(int verbose, void *mbio_ptr, void *store_ptr, int *e
 
             if (status == MB_SUCCESS) {
               offset = (size_t) (mb_io_ptr->file_pos + header.numBytesDgm);
-              fseek(mb_io_ptr->mbfp, offset, SEEK_SET);
+              mb_fileio_seek(verbose, mbio_ptr, offset, SEEK_SET, &fileio_error);
             }
             // TODO: what happens if alloc fails - while condition?
             break;
@@ -4340,13 +4380,13 @@ int mbr_kemkmall_index_data(int verbose, void *mbio_ptr, void *store_ptr, int *e
 
             if (status == MB_SUCCESS) {
               offset = (size_t) (mb_io_ptr->file_pos + header.numBytesDgm);
-              fseek(mb_io_ptr->mbfp, offset, SEEK_SET);
+              mb_fileio_seek(verbose, mbio_ptr, offset, SEEK_SET, &fileio_error);
             }
             break;
         }
 
         /* update file position */
-        mb_io_ptr->file_pos = ftell(mb_io_ptr->mbfp);
+        mb_fileio_tell(verbose, mbio_ptr, &mb_io_ptr->file_pos, &fileio_error);
       }
     }
   }
@@ -4377,6 +4417,10 @@ int mbr_kemkmall_index_data(int verbose, void *mbio_ptr, void *store_ptr, int *e
 
     qsort((void *)dgm_index_table->indextable, dgm_index_table->dgm_count,
         sizeof(struct mbsys_kmbes_index), (void *)mbr_kemkmall_indextable_compare);
+
+    /* offer the sorted table for saving in a sidecar index */
+    mb_io_ptr->index_blob = (void *)dgm_index_table->indextable;
+    mb_io_ptr->index_blob_size = dgm_index_table->dgm_count * sizeof(struct mbsys_kmbes_index);
   }
 
 #ifdef MBR_KEMKMALL_DEBUG
@@ -4397,7 +4441,7 @@ int mbr_kemkmall_index_data(int verbose, void *mbio_ptr, void *store_ptr, int *e
 #endif
 
   /* set file position back to the start */
-  fseek(mb_io_ptr->mbfp, 0, SEEK_SET);
+  mb_fileio_seek(verbose, mbio_ptr, 0, SEEK_SET, &fileio_error);
 
     if (verbose >= 2) {
         fprintf(stderr, "\ndbg2  MBIO function <%s> completed\n", __func__);
@@ -4429,6 +4473,7 @@ int mbr_kemkmall_rd_data(int verbose, void *mbio_ptr, void *store_ptr, int *erro
   char *buffer = NULL;
   size_t *bufferalloc = NULL;
   unsigned int *dgm_id = NULL;
+  int fileio_error = MB_ERROR_NO_ERROR;
   int jmrz;
   int jmwc;
   int jxmt, isounding;
@@ -4491,11 +4536,12 @@ int mbr_kemkmall_rd_data(int verbose, void *mbio_ptr, void *store_ptr, int *erro
         }
       }
 
-      /* read the next datagram */
+      /* read the next datagram - if the file is memory mapped the datagram
+         is parsed in place rather than copied into the buffer */
       if (status == MB_SUCCESS) {
-        fseek(mb_io_ptr->mbfp, dgm_index->file_pos, SEEK_SET);
-        status = mb_fileio_get(verbose, mbio_ptr, (void *)&buffer[0], &read_len, error);
-        mb_io_ptr->file_pos = ftell(mb_io_ptr->mbfp);
+        mb_fileio_seek(verbose, mbio_ptr, dgm_index->file_pos, SEEK_SET, &fileio_error);
+        status = mb_fileio_getptr(verbose, mbio_ptr, (char *)*bufferptr, &buffer, &read_len, error);
+        mb_fileio_tell(verbose, mbio_ptr, &mb_io_ptr->file_pos, &fileio_error);
       }
 
       // check for partitioned datagrams (i.e. multiple UDP packets that have
@@ -4869,7 +4915,7 @@ numOfDgms, dgmNum, header.numBytesDgm, dgm_index->index_org, dgm_index->ping_num
 
   /* get file position */
   if (mb_io_ptr->mbfp != NULL)
-    mb_io_ptr->file_bytes = ftell(mb_io_ptr->mbfp);
+    mb_fileio_tell(verbose, mbio_ptr, &mb_io_ptr->file_bytes, &fileio_error);
 
   if (verbose >= 2) {
     fprintf(stderr, "\ndbg2  MBIO function <%s> completed\n", __func__);
@@ -9146,6 +9192,8 @@ int mbr_register_kemkmall(int verbose, void *mbio_ptr, int *error) {
 
   /* set format and system specific function pointers */
   mb_io_ptr->mb_io_format_alloc = &mbr_alm_kemkmall;
+  mb_io_ptr->file_mmap_ok = true;
+  mb_io_ptr->readahead_ok = true;
   mb_io_ptr->mb_io_format_free = &mbr_dem_kemkmall;
   mb_io_ptr->mb_io_store_alloc = &mbsys_kmbes_alloc;
   mb_io_ptr->mb_io_store_free = &mbsys_kmbes_deall;
@@ -1317,6 +1317,7 @@ int mbr_register_mbldeoih(int verbose, void *mbio_ptr, int *error) {
 
 	/* set format and system specific function pointers */
 	mb_io_ptr->mb_io_format_alloc = &mbr_alm_mbldeoih;
+	mb_io_ptr->index_seek_ok = true;
 	mb_io_ptr->mb_io_format_free = &mbr_dem_mbldeoih;
 	mb_io_ptr->mb_io_store_alloc = &mbsys_ldeoih_alloc;
 	mb_io_ptr->mb_io_store_free = &mbsys_ldeoih_deall;
@@ -9606,6 +9606,7 @@ int mbr_reson7k3_rd_data(int verbose, void *mbio_ptr, void *store_ptr, int *erro
   s7k3_SegmentedRawDetection *SegmentedRawDetection;
   int skip;
   size_t read_len;
+  int fileio_error = MB_ERROR_NO_ERROR;
 
   if (verbose >= 2) {
     fprintf(stderr, "\ndbg2  MBIO function <%s> called\n", __func__);
@@ -9676,7 +9677,7 @@ int mbr_reson7k3_rd_data(int verbose, void *mbio_ptr, void *store_ptr, int *erro
       /* if FileCatalog has been read then set file pointer to read the next
           record header on the sorted list of records */
       if (store->FileCatalog_read.n > 0 && *icatalog < store->FileCatalog_read.n) {
-        fseek(mb_io_ptr->mbfp, store->FileCatalog_read.filecatalogdata[*icatalog].offset, SEEK_SET);
+        mb_fileio_seek(verbose, mbio_ptr, store->FileCatalog_read.filecatalogdata[*icatalog].offset, SEEK_SET, &fileio_error);
         (*icatalog)++;
       }
 
@@ -10532,10 +10533,11 @@ Have a nice day...:                              %4.4X | %d\n", store->type, sto
             && store->FileHeader.file_catalog_offset > 0
             && mb_io_ptr->mbfp != NULL) {
           // save current file location
-          int fpos_current = ftell(mb_io_ptr->mbfp);
+          long fpos_current = 0;
+          mb_fileio_tell(verbose, mbio_ptr, &fpos_current, &fileio_error);
 
           // move to start of FileCatalog record
-          /* int fstatus = */ fseek(mb_io_ptr->mbfp, store->FileHeader.file_catalog_offset, SEEK_SET);
+          mb_fileio_seek(verbose, mbio_ptr, store->FileHeader.file_catalog_offset, SEEK_SET, &fileio_error);
 
           // Most of the time the FileHeader.file_catalog_size value is the size
           // of the entire FileCatalog record as per the format spec, but sometimes
@@ -10586,7 +10588,7 @@ Have a nice day...:                              %4.4X | %d\n", store->type, sto
           store->type = R7KRECID_FileHeader;
 
           // reset file position
-          /* fstatus = */ fseek(mb_io_ptr->mbfp, fpos_current, SEEK_SET);
+          mb_fileio_seek(verbose, mbio_ptr, fpos_current, SEEK_SET, &fileio_error);
           *icatalog = 1;
 
         }
@@ -10730,10 +10732,9 @@ Have a nice day...:                              %4.4X | %d\n", store->type, sto
 
   /* get file position - check file and socket, use appropriate ftell */
   if (mb_io_ptr->mbfp != NULL) {
-       if (*save_flag)
-          mb_io_ptr->file_bytes = ftell(mb_io_ptr->mbfp) - *size;
-      else
-          mb_io_ptr->file_bytes = ftell(mb_io_ptr->mbfp);
+      mb_fileio_tell(verbose, mbio_ptr, &mb_io_ptr->file_bytes, &fileio_error);
+      if (*save_flag)
+          mb_io_ptr->file_bytes -= *size;
   }
 #ifdef MBTRN_ENABLED
   else if (mb_io_ptr->mbsp != NULL) {
@@ -21440,6 +21441,8 @@ int mbr_register_reson7k3(int verbose, void *mbio_ptr, int *error) {
 
   /* set format and system specific function pointers */
   mb_io_ptr->mb_io_format_alloc = &mbr_alm_reson7k3;
+  mb_io_ptr->file_mmap_ok = true;
+  mb_io_ptr->readahead_ok = true;
   mb_io_ptr->mb_io_format_free = &mbr_dem_reson7k3;
   mb_io_ptr->mb_io_store_alloc = &mbsys_reson7k3_alloc;
   mb_io_ptr->mb_io_store_free = &mbsys_reson7k3_deall;
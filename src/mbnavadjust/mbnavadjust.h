@@ -193,6 +193,12 @@ MBNAVADJUST_EXTERNAL struct mbna_project project;
 /* flag to reset all crossings to unanalyzed when a project is opened */
 MBNAVADJUST_EXTERNAL int mbna_reset_crossings;
 
+/* solver used for the navigation inversion */
+#define MBNA_SOLVER_LSQR 0
+#define MBNA_SOLVER_CGLS 1
+#define MBNA_SOLVER_COMPARE 2
+MBNAVADJUST_EXTERNAL int mbna_solver;
+
 /* function prototype definitions */
 void do_mbnavadjust_init(int argc, char **argv);
 void do_set_controls(void);
@@ -244,6 +250,7 @@ int mbnavadjust_naverr_checkoksettie(void);
 int mbnavadjust_naverr_skip(void);
 int mbnavadjust_naverr_unset(void);
 int mbnavadjust_crossing_load(void);
+int mbnavadjust_crossing_load_sections(void);
 int mbnavadjust_crossing_unload(void);
 int mbnavadjust_naverr_replot(void);
 int mbnavadjust_crossing_replot(void);
@@ -35,13 +35,17 @@
 /*--------------------------------------------------------------------*/
 
 #include <assert.h>
+#include <dirent.h>
 #include <math.h>
+#include <pthread.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <time.h>
 #include <unistd.h>
+#include <utime.h>
 #include <errno.h>
 
 #include "mb_aux.h"
@@ -6812,6 +6816,57 @@ int mbnavadjust_reference_unload(int verbose, void **swath_ptr, int *error) {
   return (status);
 }
 
+/*--------------------------------------------------------------------*/
+static bool mbnavadjust_section_masks_overlap(const struct mbna_section *section1, const struct mbna_section *section2) {
+  /* get coverage masks adjusted for most recent inversion solution */
+  const double lonmin1 = section1->lonmin + section1->snav_lon_offset[section1->num_snav / 2];
+  const double latmin1 = section1->latmin + section1->snav_lat_offset[section1->num_snav / 2];
+  const double dx1 = (section1->lonmax - section1->lonmin) / (MBNA_MASK_DIM - 1);
+  const double dy1 = (section1->latmax - section1->latmin) / (MBNA_MASK_DIM - 1);
+  const double lonmin2 = section2->lonmin + section2->snav_lon_offset[section2->num_snav / 2];
+  const double latmin2 = section2->latmin + section2->snav_lat_offset[section2->num_snav / 2];
+  const double dx2 = (section2->lonmax - section2->lonmin) / (MBNA_MASK_DIM - 1);
+  const double dy2 = (section2->latmax - section2->latmin) / (MBNA_MASK_DIM - 1);
+
+  /* list the covered cells of the first mask once rather than once per covered cell of the second */
+  int ncell1 = 0;
+  int cell1[MBNA_MASK_DIM * MBNA_MASK_DIM];
+  for (int kk1 = 0; kk1 < MBNA_MASK_DIM * MBNA_MASK_DIM; kk1++) {
+    if (section1->coverage[kk1] == 1)
+      cell1[ncell1++] = kk1;
+  }
+
+  /* loop over the coverage mask cells looking for overlap */
+  for (int ii2 = 0; ii2 < MBNA_MASK_DIM; ii2++) {
+    for (int jj2 = 0; jj2 < MBNA_MASK_DIM; jj2++) {
+      const int kk2 = ii2 + jj2 * MBNA_MASK_DIM;
+      if (section2->coverage[kk2] == 1) {
+        const double cell2lonmin = lonmin2 + ii2 * dx2;
+        const double cell2lonmax = lonmin2 + (ii2 + 1) * dx2;
+        const double cell2latmin = latmin2 + jj2 * dy2;
+        const double cell2latmax = latmin2 + (jj2 + 1) * dy2;
+
+        for (int icell1 = 0; icell1 < ncell1; icell1++) {
+          const int ii1 = cell1[icell1] % MBNA_MASK_DIM;
+          const int jj1 = cell1[icell1] / MBNA_MASK_DIM;
+          const double cell1lonmin = lonmin1 + ii1 * dx1;
+          const double cell1lonmax = lonmin1 + (ii1 + 1) * dx1;
+          const double cell1latmin = latmin1 + jj1 * dy2;
+          const double cell1latmax = latmin1 + (jj1 + 1) * dy1;
+
+          /* check if these two cells overlap */
+          if (cell2lonmin < cell1lonmax && cell2lonmax > cell1lonmin &&
+              cell2latmin < cell1latmax && cell2latmax > cell1latmin) {
+            return (true);
+          }
+        }
+      }
+    }
+  }
+
+  return (false);
+}
+
 /*--------------------------------------------------------------------*/
 int mbnavadjust_findcrossings(int verbose, struct mbna_project *project, int *error) {
   if (verbose >= 2) {
@@ -6825,9 +6880,8 @@ int mbnavadjust_findcrossings(int verbose, struct mbna_project *project, int *er
   /* loop over files looking for new crossings */
   if (project->open && project->num_files > 0) {
     /* look for new crossings through all files */
-    for (int ifile = 0; ifile < project->num_files; ifile++) {
-      status = mbnavadjust_findcrossingsfile(verbose, project, ifile, error);
-    }
+    const int nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    status = mbnavadjust_findcrossingsall(verbose, project, nthreads, error);
 
     /* resort crossings */
     if (project->num_crossings > 1)
@@ -6912,8 +6966,6 @@ int mbnavadjust_findcrossingsfile(int verbose, struct mbna_project *project, int
       const double lonmax2 = section2->lonmax + lonoffset2;
       const double latmin2 = section2->latmin + latoffset2;
       const double latmax2 = section2->latmax + latoffset2;
-      const double dx2 = (section2->lonmax - section2->lonmin) / (MBNA_MASK_DIM - 1);
-      const double dy2 = (section2->latmax - section2->latmin) / (MBNA_MASK_DIM - 1);
 
       /* now loop over all previous sections looking for crossings */
       for (int jfile = 0; jfile <= ifile; jfile++) {
@@ -6929,8 +6981,6 @@ int mbnavadjust_findcrossingsfile(int verbose, struct mbna_project *project, int
           const double lonmax1 = section1->lonmax + lonoffset1;
           const double latmin1 = section1->latmin + latoffset1;
           const double latmax1 = section1->latmax + latoffset1;
-          const double dx1 = (section1->lonmax - section1->lonmin) / (MBNA_MASK_DIM - 1);
-          const double dy1 = (section1->latmax - section1->latmin) / (MBNA_MASK_DIM - 1);
 
           /* check if there is overlap given the current navigation model */
           int overlap = 0;
@@ -6944,34 +6994,8 @@ int mbnavadjust_findcrossingsfile(int verbose, struct mbna_project *project, int
             disqualify = true;
           } else {
             /* loop over the coverage mask cells looking for overlap */
-            for (int ii2 = 0; ii2 < MBNA_MASK_DIM && overlap == 0; ii2++)
-              for (int jj2 = 0; jj2 < MBNA_MASK_DIM && overlap == 0; jj2++) {
-                const int kk2 = ii2 + jj2 * MBNA_MASK_DIM;
-                if (section2->coverage[kk2] == 1) {
-                  const double cell2lonmin = lonmin2 + ii2 * dx2;
-                  const double cell2lonmax = lonmin2 + (ii2 + 1) * dx2;
-                  const double cell2latmin = latmin2 + jj2 * dy2;
-                  const double cell2latmax = latmin2 + (jj2 + 1) * dy2;
-
-                  for (int ii1 = 0; ii1 < MBNA_MASK_DIM && overlap == 0; ii1++) {
-                    for (int jj1 = 0; jj1 < MBNA_MASK_DIM && overlap == 0; jj1++) {
-                      const int kk1 = ii1 + jj1 * MBNA_MASK_DIM;
-                      if (section1->coverage[kk1] == 1) {
-                        const double cell1lonmin = lonmin1 + ii1 * dx1;
-                        const double cell1lonmax = lonmin1 + (ii1 + 1) * dx1;
-                        const double cell1latmin = latmin1 + jj1 * dy2;
-                        const double cell1latmax = latmin1 + (jj1 + 1) * dy1;
-
-                        /* check if these two cells overlap */
-                        if (cell2lonmin < cell1lonmax && cell2lonmax > cell1lonmin &&
-                            cell2latmin < cell1latmax && cell2latmax > cell1latmin) {
-                          overlap++;
-                        }
-                      }
-                    }
-                  }
-                }
-              }
+            if (mbnavadjust_section_masks_overlap(section1, section2))
+              overlap++;
           }
 
           /* if not disqualified and overlap found, then this is a crossing */
@@ -7042,6 +7066,424 @@ int mbnavadjust_findcrossingsfile(int verbose, struct mbna_project *project, int
   return (status);
 }
 /*--------------------------------------------------------------------*/
+/* Indexed crossing search. Sections are numbered globally in (file, section)
+   order and binned by their navigation adjusted bounds into a uniform grid,
+   so each section is only compared with the earlier sections sharing a grid
+   cell. Files are searched in parallel and the new crossings are appended
+   in the same order as the serial search in mbnavadjust_findcrossingsfile(). */
+
+struct mbna_section_grid {
+  int num_sections;   /* sections in the project */
+  int *file_start;    /* global id of the first section of each file */
+  int *gfile;         /* file of each global section id */
+  int *gsection;      /* section within its file of each global section id */
+  double *bounds;     /* lonmin, lonmax, latmin, latmax of each section */
+  int nx;
+  int ny;
+  double lonmin;
+  double latmin;
+  double dlon;
+  double dlat;
+  int *cell_start;    /* nx * ny + 1 offsets into cell_sections */
+  int *cell_sections; /* ascending global section ids binned in each cell */
+};
+
+struct mbna_crossing_candidate {
+  int jfile;
+  int jsection;
+  int isection;
+};
+
+struct mbna_findcrossings_work {
+  struct mbna_project *project;
+  struct mbna_section_grid *grid;
+  pthread_mutex_t mutex;
+  int next_file;
+  bool memory_fail;
+  int *num_found;
+  int *num_found_alloc;
+  struct mbna_crossing_candidate **found;
+};
+
+static void mbnavadjust_section_grid_range(const struct mbna_section_grid *grid, const double *bounds, int *ix0,
+                                           int *ix1, int *iy0, int *iy1) {
+  *ix0 = MAX(0, MIN(grid->nx - 1, (int)floor((bounds[0] - grid->lonmin) / grid->dlon)));
+  *ix1 = MAX(0, MIN(grid->nx - 1, (int)floor((bounds[1] - grid->lonmin) / grid->dlon)));
+  *iy0 = MAX(0, MIN(grid->ny - 1, (int)floor((bounds[2] - grid->latmin) / grid->dlat)));
+  *iy1 = MAX(0, MIN(grid->ny - 1, (int)floor((bounds[3] - grid->latmin) / grid->dlat)));
+}
+
+static void mbnavadjust_section_grid_free(struct mbna_section_grid *grid) {
+  free(grid->file_start);
+  free(grid->gfile);
+  free(grid->gsection);
+  free(grid->bounds);
+  free(grid->cell_start);
+  free(grid->cell_sections);
+  memset(grid, 0, sizeof(struct mbna_section_grid));
+}
+
+static bool mbnavadjust_section_grid_init(struct mbna_project *project, struct mbna_section_grid *grid) {
+  memset(grid, 0, sizeof(struct mbna_section_grid));
+  for (int ifile = 0; ifile < project->num_files; ifile++)
+    grid->num_sections += project->files[ifile].num_sections;
+  const int nsections = grid->num_sections;
+
+  grid->file_start = (int *)malloc(sizeof(int) * (project->num_files + 1));
+  grid->gfile = (int *)malloc(sizeof(int) * MAX(nsections, 1));
+  grid->gsection = (int *)malloc(sizeof(int) * MAX(nsections, 1));
+  grid->bounds = (double *)malloc(sizeof(double) * 4 * MAX(nsections, 1));
+  if (grid->file_start == NULL || grid->gfile == NULL || grid->gsection == NULL || grid->bounds == NULL) {
+    mbnavadjust_section_grid_free(grid);
+    return (false);
+  }
+
+  /* get section bounds adjusted for most recent inversion solution */
+  double lonmin = 0.0;
+  double lonmax = 0.0;
+  double latmin = 0.0;
+  double latmax = 0.0;
+  int gsection = 0;
+  for (int ifile = 0; ifile < project->num_files; ifile++) {
+    struct mbna_file *file = &(project->files[ifile]);
+    grid->file_start[ifile] = gsection;
+    for (int isection = 0; isection < file->num_sections; isection++, gsection++) {
+      struct mbna_section *section = &(file->sections[isection]);
+      const double lonoffset = section->snav_lon_offset[section->num_snav / 2];
+      const double latoffset = section->snav_lat_offset[section->num_snav / 2];
+      double *bounds = &grid->bounds[4 * gsection];
+      bounds[0] = section->lonmin + lonoffset;
+      bounds[1] = section->lonmax + lonoffset;
+      bounds[2] = section->latmin + latoffset;
+      bounds[3] = section->latmax + latoffset;
+      grid->gfile[gsection] = ifile;
+      grid->gsection[gsection] = isection;
+      if (gsection == 0) {
+        lonmin = bounds[0];
+        lonmax = bounds[1];
+        latmin = bounds[2];
+        latmax = bounds[3];
+      }
+      else {
+        lonmin = MIN(lonmin, bounds[0]);
+        lonmax = MAX(lonmax, bounds[1]);
+        latmin = MIN(latmin, bounds[2]);
+        latmax = MAX(latmax, bounds[3]);
+      }
+    }
+  }
+  grid->file_start[project->num_files] = gsection;
+
+  /* size the grid for about one section per cell */
+  const int ndim = MAX(1, MIN(MBNA_CROSSING_GRID_MAX, (int)sqrt((double)nsections)));
+  grid->nx = ndim;
+  grid->ny = ndim;
+  grid->lonmin = lonmin;
+  grid->latmin = latmin;
+  grid->dlon = lonmax > lonmin ? (lonmax - lonmin) / ndim : 1.0;
+  grid->dlat = latmax > latmin ? (latmax - latmin) / ndim : 1.0;
+
+  /* bin the sections, counting first and then filling in global id order */
+  grid->cell_start = (int *)calloc(grid->nx * grid->ny + 1, sizeof(int));
+  if (grid->cell_start == NULL) {
+    mbnavadjust_section_grid_free(grid);
+    return (false);
+  }
+  for (int g = 0; g < nsections; g++) {
+    int ix0, ix1, iy0, iy1;
+    mbnavadjust_section_grid_range(grid, &grid->bounds[4 * g], &ix0, &ix1, &iy0, &iy1);
+    for (int ix = ix0; ix <= ix1; ix++)
+      for (int iy = iy0; iy <= iy1; iy++)
+        grid->cell_start[ix + iy * grid->nx + 1]++;
+  }
+  for (int icell = 0; icell < grid->nx * grid->ny; icell++)
+    grid->cell_start[icell + 1] += grid->cell_start[icell];
+  grid->cell_sections = (int *)malloc(sizeof(int) * MAX(grid->cell_start[grid->nx * grid->ny], 1));
+  int *cell_fill = (int *)malloc(sizeof(int) * grid->nx * grid->ny);
+  if (grid->cell_sections == NULL || cell_fill == NULL) {
+    free(cell_fill);
+    mbnavadjust_section_grid_free(grid);
+    return (false);
+  }
+  memcpy(cell_fill, grid->cell_start, sizeof(int) * grid->nx * grid->ny);
+  for (int g = 0; g < nsections; g++) {
+    int ix0, ix1, iy0, iy1;
+    mbnavadjust_section_grid_range(grid, &grid->bounds[4 * g], &ix0, &ix1, &iy0, &iy1);
+    for (int ix = ix0; ix <= ix1; ix++)
+      for (int iy = iy0; iy <= iy1; iy++)
+        grid->cell_sections[cell_fill[ix + iy * grid->nx]++] = g;
+  }
+  free(cell_fill);
+
+  return (true);
+}
+
+static int mbnavadjust_int_compare(const void *a, const void *b) {
+  const int ia = *((const int *)a);
+  const int ib = *((const int *)b);
+  return (ia < ib ? -1 : (ia > ib ? 1 : 0));
+}
+
+static void *mbnavadjust_findcrossings_worker(void *arg) {
+  struct mbna_findcrossings_work *work = (struct mbna_findcrossings_work *)arg;
+  struct mbna_project *project = work->project;
+  const struct mbna_section_grid *grid = work->grid;
+
+  /* stamp marks the sections already considered for the current section */
+  int *stamp = (int *)malloc(sizeof(int) * MAX(grid->num_sections, 1));
+  int num_candidates_alloc = ALLOC_NUM;
+  int *candidates = (int *)malloc(sizeof(int) * num_candidates_alloc);
+  if (stamp == NULL || candidates == NULL) {
+    pthread_mutex_lock(&work->mutex);
+    work->memory_fail = true;
+    pthread_mutex_unlock(&work->mutex);
+    free(stamp);
+    free(candidates);
+    return (NULL);
+  }
+  for (int g = 0; g < grid->num_sections; g++)
+    stamp[g] = -1;
+
+  bool done = false;
+  while (!done) {
+    pthread_mutex_lock(&work->mutex);
+    const int ifile = work->next_file++;
+    done = ifile >= project->num_files || work->memory_fail;
+    pthread_mutex_unlock(&work->mutex);
+    if (done)
+      break;
+
+    struct mbna_file *file2 = &(project->files[ifile]);
+    for (int isection = 0; isection < file2->num_sections && !done; isection++) {
+      struct mbna_section *section2 = &(file2->sections[isection]);
+      const int g2 = grid->file_start[ifile] + isection;
+      const double *bounds2 = &grid->bounds[4 * g2];
+
+      /* get the earlier sections whose bounds overlap this one */
+      int num_candidates = 0;
+      int ix0, ix1, iy0, iy1;
+      mbnavadjust_section_grid_range(grid, bounds2, &ix0, &ix1, &iy0, &iy1);
+      for (int ix = ix0; ix <= ix1 && !done; ix++) {
+        for (int iy = iy0; iy <= iy1 && !done; iy++) {
+          const int icell = ix + iy * grid->nx;
+          for (int k = grid->cell_start[icell]; k < grid->cell_start[icell + 1]; k++) {
+            const int g1 = grid->cell_sections[k];
+            if (g1 >= g2)
+              break;
+            if (stamp[g1] == g2)
+              continue;
+            stamp[g1] = g2;
+            const double *bounds1 = &grid->bounds[4 * g1];
+            if (bounds2[0] < bounds1[1] && bounds2[1] > bounds1[0] && bounds2[2] < bounds1[3] &&
+                bounds2[3] > bounds1[2]) {
+              if (num_candidates >= num_candidates_alloc) {
+                num_candidates_alloc *= 2;
+                int *tmp = (int *)realloc(candidates, sizeof(int) * num_candidates_alloc);
+                if (tmp == NULL) {
+                  done = true;
+                  break;
+                }
+                candidates = tmp;
+              }
+              candidates[num_candidates++] = g1;
+            }
+          }
+        }
+      }
+      if (num_candidates > 1)
+        qsort(candidates, num_candidates, sizeof(int), mbnavadjust_int_compare);
+
+      /* check the coverage masks in the same order as the serial search */
+      for (int icandidate = 0; icandidate < num_candidates && !done; icandidate++) {
+        const int jfile = grid->gfile[candidates[icandidate]];
+        const int jsection = grid->gsection[candidates[icandidate]];
+        struct mbna_file *file1 = &(project->files[jfile]);
+        struct mbna_section *section1 = &(file1->sections[jsection]);
+        if (jfile == ifile && jsection == isection - 1 && section2->continuity)
+          continue;
+        if (jfile == ifile - 1 && jsection == file1->num_sections - 1 && isection == 0 && section2->continuity)
+          continue;
+        if (!mbnavadjust_section_masks_overlap(section1, section2))
+          continue;
+
+        /* each file's results are only touched by the thread searching that file */
+        if (work->num_found[ifile] >= work->num_found_alloc[ifile]) {
+          const int num_alloc = work->num_found_alloc[ifile] + ALLOC_NUM;
+          struct mbna_crossing_candidate *tmp = (struct mbna_crossing_candidate *)realloc(
+              work->found[ifile], sizeof(struct mbna_crossing_candidate) * num_alloc);
+          if (tmp == NULL) {
+            done = true;
+            break;
+          }
+          work->found[ifile] = tmp;
+          work->num_found_alloc[ifile] = num_alloc;
+        }
+        struct mbna_crossing_candidate *found = &work->found[ifile][work->num_found[ifile]++];
+        found->jfile = jfile;
+        found->jsection = jsection;
+        found->isection = isection;
+      }
+    }
+    if (done) {
+      pthread_mutex_lock(&work->mutex);
+      work->memory_fail = true;
+      pthread_mutex_unlock(&work->mutex);
+    }
+  }
+
+  free(stamp);
+  free(candidates);
+  return (NULL);
+}
+
+static int mbnavadjust_crossing_key_compare(const void *a, const void *b) {
+  const long long ka = *((const long long *)a);
+  const long long kb = *((const long long *)b);
+  return (ka < kb ? -1 : (ka > kb ? 1 : 0));
+}
+
+static long long mbnavadjust_crossing_key(const struct mbna_section_grid *grid, int g1, int g2) {
+  if (g1 > g2) {
+    const int g = g1;
+    g1 = g2;
+    g2 = g;
+  }
+  return ((long long)g1 * grid->num_sections + g2);
+}
+
+/*--------------------------------------------------------------------*/
+int mbnavadjust_findcrossingsall(int verbose, struct mbna_project *project, int nthreads, int *error) {
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> called\n", __func__);
+    fprintf(stderr, "dbg2       verbose:    %d\n", verbose);
+    fprintf(stderr, "dbg2       project:    %p\n", project);
+    fprintf(stderr, "dbg2       nthreads:   %d\n", nthreads);
+  }
+
+  int status = MB_SUCCESS;
+
+  if (project->open && project->num_files > 0) {
+    struct mbna_section_grid grid;
+    struct mbna_findcrossings_work work;
+    memset(&work, 0, sizeof(struct mbna_findcrossings_work));
+    work.project = project;
+    work.grid = &grid;
+    bool ok = mbnavadjust_section_grid_init(project, &grid);
+    if (ok) {
+      work.num_found = (int *)calloc(project->num_files, sizeof(int));
+      work.num_found_alloc = (int *)calloc(project->num_files, sizeof(int));
+      work.found = (struct mbna_crossing_candidate **)calloc(project->num_files, sizeof(struct mbna_crossing_candidate *));
+      ok = work.num_found != NULL && work.num_found_alloc != NULL && work.found != NULL;
+    }
+
+    /* search the files in parallel */
+    if (ok) {
+      nthreads = MAX(1, MIN(MIN(nthreads, MB_THREAD_MAX), project->num_files));
+      pthread_t threads[MB_THREAD_MAX];
+      pthread_mutex_init(&work.mutex, NULL);
+      int nstarted = 1;
+      for (int ithread = 1; ithread < nthreads; ithread++) {
+        if (pthread_create(&threads[ithread], NULL, mbnavadjust_findcrossings_worker, &work) == 0)
+          nstarted++;
+        else
+          break;
+      }
+      mbnavadjust_findcrossings_worker(&work);
+      for (int ithread = 1; ithread < nstarted; ithread++)
+        pthread_join(threads[ithread], NULL);
+      pthread_mutex_destroy(&work.mutex);
+      ok = !work.memory_fail;
+    }
+
+    /* get the existing crossings so that they are not added twice */
+    long long *keys = NULL;
+    int num_keys = 0;
+    if (ok && project->num_crossings > 0) {
+      keys = (long long *)malloc(sizeof(long long) * project->num_crossings);
+      if (keys != NULL) {
+        for (int icrossing = 0; icrossing < project->num_crossings; icrossing++) {
+          struct mbna_crossing *crossing = &(project->crossings[icrossing]);
+          if (crossing->file_id_1 >= 0 && crossing->file_id_1 < project->num_files && crossing->file_id_2 >= 0 &&
+              crossing->file_id_2 < project->num_files)
+            keys[num_keys++] = mbnavadjust_crossing_key(&grid, grid.file_start[crossing->file_id_1] + crossing->section_1,
+                                                        grid.file_start[crossing->file_id_2] + crossing->section_2);
+        }
+        qsort(keys, num_keys, sizeof(long long), mbnavadjust_crossing_key_compare);
+      }
+      else
+        ok = false;
+    }
+
+    /* add the new crossings in file order */
+    for (int ifile = 0; ok && ifile < project->num_files; ifile++) {
+      struct mbna_file *file2 = &(project->files[ifile]);
+      for (int ifound = 0; ok && ifound < work.num_found[ifile]; ifound++) {
+        const struct mbna_crossing_candidate *found = &work.found[ifile][ifound];
+        struct mbna_file *file1 = &(project->files[found->jfile]);
+        const long long key = mbnavadjust_crossing_key(&grid, grid.file_start[found->jfile] + found->jsection,
+                                                       grid.file_start[ifile] + found->isection);
+        if (num_keys > 0 && bsearch(&key, keys, num_keys, sizeof(long long), mbnavadjust_crossing_key_compare) != NULL)
+          continue;
+
+        /* allocate mbna_crossing array if needed */
+        if (project->num_crossings_alloc <= project->num_crossings) {
+          struct mbna_crossing *crossings = (struct mbna_crossing *)realloc(
+            project->crossings, sizeof(struct mbna_crossing) * (project->num_crossings_alloc + ALLOC_NUM));
+          if (crossings != NULL) {
+            project->crossings = crossings;
+            project->num_crossings_alloc += ALLOC_NUM;
+          }
+          else {
+            ok = false;
+            break;
+          }
+        }
+
+        /* add crossing to list */
+        struct mbna_crossing *crossing = (struct mbna_crossing *)&project->crossings[project->num_crossings];
+        crossing->status = MBNA_CROSSING_STATUS_NONE;
+        crossing->truecrossing = false;
+        crossing->overlap = 0;
+        crossing->file_id_1 = file1->id;
+        crossing->section_1 = found->jsection;
+        crossing->file_id_2 = file2->id;
+        crossing->section_2 = found->isection;
+        crossing->num_ties = 0;
+        project->num_crossings++;
+
+        fprintf(stderr, "added crossing: %d  %4d %4d   %4d %4d\n", project->num_crossings - 1,
+          crossing->file_id_1, crossing->section_1, crossing->file_id_2, crossing->section_2);
+      }
+    }
+
+    if (!ok) {
+      status = MB_FAILURE;
+      *error = MB_ERROR_MEMORY_FAIL;
+    }
+
+    free(keys);
+    if (work.found != NULL) {
+      for (int ifile = 0; ifile < project->num_files; ifile++)
+        free(work.found[ifile]);
+    }
+    free(work.found);
+    free(work.num_found);
+    free(work.num_found_alloc);
+    if (grid.cell_start != NULL || grid.file_start != NULL)
+      mbnavadjust_section_grid_free(&grid);
+  }
+
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBnavadjust function <%s> completed\n", __func__);
+    fprintf(stderr, "dbg2  Return values:\n");
+    fprintf(stderr, "dbg2       error:       %d\n", *error);
+    fprintf(stderr, "dbg2  Return status:\n");
+    fprintf(stderr, "dbg2       status:      %d\n", status);
+  }
+
+  return (status);
+}
+/*--------------------------------------------------------------------*/
 int mbnavadjust_addcrossing(int verbose, struct mbna_project *project, int ifile1, int isection1, int ifile2, int isection2, int *error) {
   if (verbose >= 2) {
     fprintf(stderr, "\ndbg2  MBIO function <%s> called\n", __func__);
@@ -7331,3 +7773,811 @@ int mbnavadjust_info_add(int verbose, struct mbna_project *project, char *info,
 }
 
 /*--------------------------------------------------------------------*/
+/* Misfit grid engine. The misfit at each lateral offset is the sum over the
+   overlapping cells of the squared depth difference, evaluated at every z
+   offset. For a given lateral offset the overlapping cells do not depend on
+   the z offset, so the sums over cells are taken once and each z offset is
+   evaluated from the mean and spread of the depth differences:
+     sum((d + zoff)^2) = sum((d - dmean)^2) + n * (dmean + zoff)^2
+   Rows of lateral offsets are shared out between threads. Finished misfit
+   grids are cached in the project data directory keyed by a hash of the
+   section files and the offset parameters, so that revisiting a crossing
+   skips loading and gridding the sections as well as the misfit calculation.
+   The cache is trimmed to MBNA_MISFIT_CACHE_SIZE_MAX bytes, least recently
+   used grids first. */
+
+#define MBNA_MISFIT_CACHE_MAGIC "MBNAMF01"
+
+struct mbna_misfit_work {
+  int grid_nx;
+  int grid_ny;
+  const double *grid1;  /* gridded bathymetry, zero where empty */
+  const double *grid2;
+  const double *mask1;  /* 1 where the cell has soundings, 0 otherwise */
+  const double *mask2;
+  int gridm_nx;
+  int gridm_ny;
+  int nz;
+  double zmin;
+  double zoff_dz;
+  double offset_z;
+  double *gridm;
+  int *gridnm;
+  int jc_start;
+  int jc_end;
+};
+
+static void *mbnavadjust_misfit_worker(void *arg) {
+  struct mbna_misfit_work *work = (struct mbna_misfit_work *)arg;
+  const int grid_nx = work->grid_nx;
+  const double *grid1 = work->grid1;
+  const double *grid2 = work->grid2;
+  const double *mask1 = work->mask1;
+  const double *mask2 = work->mask2;
+
+  for (int jc = work->jc_start; jc < work->jc_end; jc++) {
+    for (int ic = 0; ic < work->gridm_nx; ic++) {
+      const int ioff = (work->gridm_nx / 2) - ic;
+      const int joff = (work->gridm_ny / 2) - jc;
+      const int istart = MAX(-ioff, 0);
+      const int iend = grid_nx - MAX(0, ioff);
+      const int jstart = MAX(-joff, 0);
+      const int jend = work->grid_ny - MAX(0, joff);
+
+      /* count the overlapping cells and sum the depth differences, in four
+         independent partial sums so that the inner loop can be vectorized */
+      double n[4] = {0.0, 0.0, 0.0, 0.0};
+      double s1[4] = {0.0, 0.0, 0.0, 0.0};
+      for (int j1 = jstart; j1 < jend; j1++) {
+        const int k1 = j1 * grid_nx;
+        const int k2 = (j1 + joff) * grid_nx + ioff;
+        int i1 = istart;
+        for (; i1 + 3 < iend; i1 += 4) {
+          for (int l = 0; l < 4; l++) {
+            const double w = mask1[k1 + i1 + l] * mask2[k2 + i1 + l];
+            n[l] += w;
+            s1[l] += w * (grid2[k2 + i1 + l] - grid1[k1 + i1 + l]);
+          }
+        }
+        for (; i1 < iend; i1++) {
+          const double w = mask1[k1 + i1] * mask2[k2 + i1];
+          n[0] += w;
+          s1[0] += w * (grid2[k2 + i1] - grid1[k1 + i1]);
+        }
+      }
+      const int nm = (int)(n[0] + n[1] + n[2] + n[3]);
+      const double mean = nm > 0 ? (s1[0] + s1[1] + s1[2] + s1[3]) / nm : 0.0;
+
+      /* sum the squared deviations from the mean difference */
+      double s2[4] = {0.0, 0.0, 0.0, 0.0};
+      if (nm > 0) {
+        for (int j1 = jstart; j1 < jend; j1++) {
+          const int k1 = j1 * grid_nx;
+          const int k2 = (j1 + joff) * grid_nx + ioff;
+          int i1 = istart;
+          for (; i1 + 3 < iend; i1 += 4) {
+            for (int l = 0; l < 4; l++) {
+              const double dd = grid2[k2 + i1 + l] - grid1[k1 + i1 + l] - mean;
+              s2[l] += mask1[k1 + i1 + l] * mask2[k2 + i1 + l] * dd * dd;
+            }
+          }
+          for (; i1 < iend; i1++) {
+            const double dd = grid2[k2 + i1] - grid1[k1 + i1] - mean;
+            s2[0] += mask1[k1 + i1] * mask2[k2 + i1] * dd * dd;
+          }
+        }
+      }
+      const double ss = s2[0] + s2[1] + s2[2] + s2[3];
+
+      /* evaluate each z offset */
+      for (int kc = 0; kc < work->nz; kc++) {
+        const int lc = kc + work->nz * (ic + jc * work->gridm_nx);
+        if (nm > 0) {
+          const double dz = mean + work->zmin + work->zoff_dz * kc - work->offset_z;
+          work->gridm[lc] = ss + nm * dz * dz;
+        }
+        else
+          work->gridm[lc] = 0.0;
+        work->gridnm[lc] = nm;
+      }
+    }
+  }
+
+  return (NULL);
+}
+
+static uint64_t mbnavadjust_hash(uint64_t hash, const void *data, size_t size) {
+  /* 64 bit FNV-1a */
+  const unsigned char *bytes = (const unsigned char *)data;
+  for (size_t i = 0; i < size; i++) {
+    hash ^= bytes[i];
+    hash *= 1099511628211ULL;
+  }
+  return (hash);
+}
+
+static void mbnavadjust_misfit_cachefile(struct mbna_project *project, uint64_t key, char *path, size_t size) {
+  snprintf(path, size, "%s/misfit/%016llx.mfg", project->datadir, (unsigned long long)key);
+}
+
+struct mbna_misfit_cacheentry {
+  mb_pathplus path;
+  off_t size;
+  time_t mtime;
+};
+
+static int mbnavadjust_misfit_cacheentry_compare(const void *a, const void *b) {
+  const struct mbna_misfit_cacheentry *entry_a = (const struct mbna_misfit_cacheentry *)a;
+  const struct mbna_misfit_cacheentry *entry_b = (const struct mbna_misfit_cacheentry *)b;
+  return (entry_a->mtime < entry_b->mtime ? -1 : (entry_a->mtime > entry_b->mtime ? 1 : 0));
+}
+
+static void mbnavadjust_misfit_cache_trim(int verbose, struct mbna_project *project) {
+  /* once the cache exceeds its size bound remove the least recently used
+     misfit grids until it is back down to three quarters of the bound */
+  mb_pathplus dirpath;
+  snprintf(dirpath, sizeof(dirpath), "%s/misfit", project->datadir);
+  DIR *dir = opendir(dirpath);
+  if (dir == NULL)
+    return;
+  struct mbna_misfit_cacheentry *entries = NULL;
+  int nentries = 0;
+  int nentries_alloc = 0;
+  long long total = 0;
+  struct dirent *dirent;
+  while ((dirent = readdir(dir)) != NULL) {
+    const size_t len = strlen(dirent->d_name);
+    if (len < 4 || strcmp(&dirent->d_name[len - 4], ".mfg") != 0)
+      continue;
+    if (nentries >= nentries_alloc) {
+      nentries_alloc += 256;
+      struct mbna_misfit_cacheentry *tmp = (struct mbna_misfit_cacheentry *)realloc(entries,
+                                              sizeof(struct mbna_misfit_cacheentry) * nentries_alloc);
+      if (tmp == NULL)
+        break;
+      entries = tmp;
+    }
+    struct mbna_misfit_cacheentry *entry = &entries[nentries];
+    snprintf(entry->path, sizeof(entry->path), "%s/%s", dirpath, dirent->d_name);
+    struct stat statbuf;
+    if (stat(entry->path, &statbuf) == 0) {
+      entry->size = statbuf.st_size;
+      entry->mtime = statbuf.st_mtime;
+      total += statbuf.st_size;
+      nentries++;
+    }
+  }
+  closedir(dir);
+
+  if (total > MBNA_MISFIT_CACHE_SIZE_MAX) {
+    qsort(entries, nentries, sizeof(struct mbna_misfit_cacheentry), mbnavadjust_misfit_cacheentry_compare);
+    int nremoved = 0;
+    for (int i = 0; i < nentries && total > MBNA_MISFIT_CACHE_SIZE_MAX / 4 * 3; i++) {
+      if (remove(entries[i].path) == 0) {
+        total -= entries[i].size;
+        nremoved++;
+      }
+    }
+    if (verbose > 0)
+      fprintf(stderr, "Removed %d least recently used misfit grids from %s\n", nremoved, dirpath);
+  }
+  free(entries);
+}
+
+/*--------------------------------------------------------------------*/
+int mbnavadjust_misfit_cachekey(int verbose, struct mbna_project *project, int file_id_1, int section_1,
+                                int file_id_2, int section_2, int nparameters, double *parameters,
+                                uint64_t *key, int *error) {
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> called\n", __func__);
+    fprintf(stderr, "dbg2       verbose:      %d\n", verbose);
+    fprintf(stderr, "dbg2       project:      %p\n", project);
+    fprintf(stderr, "dbg2       file_id_1:    %d\n", file_id_1);
+    fprintf(stderr, "dbg2       section_1:    %d\n", section_1);
+    fprintf(stderr, "dbg2       file_id_2:    %d\n", file_id_2);
+    fprintf(stderr, "dbg2       section_2:    %d\n", section_2);
+    fprintf(stderr, "dbg2       nparameters:  %d\n", nparameters);
+    for (int i = 0; i < nparameters; i++)
+      fprintf(stderr, "dbg2       parameters[%d]: %f\n", i, parameters[i]);
+  }
+
+  int status = MB_SUCCESS;
+  *error = MB_ERROR_NO_ERROR;
+
+  /* the key identifies the misfit grid by its sources - the section files
+     (or reference grid) as they stand on disk, the per file biases applied
+     when translating soundings, and the grid geometry and offsets searched -
+     so that it can be found before any section is loaded or gridded */
+  uint64_t hash = 14695981039346656037ULL;
+  if (project == NULL || !project->open || strlen(project->datadir) == 0) {
+    *error = MB_ERROR_BAD_PARAMETER;
+    status = MB_FAILURE;
+  }
+  const int file_ids[2] = {file_id_1, file_id_2};
+  const int section_ids[2] = {section_1, section_2};
+  for (int i = 0; i < 2 && status == MB_SUCCESS; i++) {
+    mb_pathplus path;
+    if (file_ids[i] >= 0) {
+      struct mbna_file *file = &project->files[file_ids[i]];
+      snprintf(path, sizeof(path), "%s/nvs_%4.4d_%4.4d.mb71", project->datadir, file_ids[i], section_ids[i]);
+      hash = mbnavadjust_hash(hash, &file->heading_bias, sizeof(file->heading_bias));
+      hash = mbnavadjust_hash(hash, &file->roll_bias, sizeof(file->roll_bias));
+    }
+    else if (project->refgrid_select >= 0) {
+      struct mbna_section *reference = &project->reference_section;
+      snprintf(path, sizeof(path), "%s/%s", project->datadir, project->refgrid_names[project->refgrid_select]);
+      const double bounds[4] = {reference->lonmin, reference->lonmax, reference->latmin, reference->latmax};
+      hash = mbnavadjust_hash(hash, bounds, sizeof(bounds));
+    }
+    else {
+      *error = MB_ERROR_BAD_PARAMETER;
+      status = MB_FAILURE;
+      break;
+    }
+    struct stat statbuf;
+    if (stat(path, &statbuf) != 0) {
+      *error = MB_ERROR_OPEN_FAIL;
+      status = MB_FAILURE;
+      break;
+    }
+    const long long stamp[2] = {(long long)statbuf.st_size, (long long)statbuf.st_mtime};
+    hash = mbnavadjust_hash(hash, path, strlen(path));
+    hash = mbnavadjust_hash(hash, stamp, sizeof(stamp));
+  }
+  if (status == MB_SUCCESS) {
+    hash = mbnavadjust_hash(hash, &nparameters, sizeof(nparameters));
+    hash = mbnavadjust_hash(hash, parameters, sizeof(double) * nparameters);
+    *key = hash;
+  }
+
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBnavadjust function <%s> completed\n", __func__);
+    fprintf(stderr, "dbg2  Return values:\n");
+    fprintf(stderr, "dbg2       key:         %016llx\n", (unsigned long long)*key);
+    fprintf(stderr, "dbg2       error:       %d\n", *error);
+    fprintf(stderr, "dbg2  Return status:\n");
+    fprintf(stderr, "dbg2       status:      %d\n", status);
+  }
+
+  return (status);
+}
+
+/*--------------------------------------------------------------------*/
+int mbnavadjust_misfit_cache_read(int verbose, struct mbna_project *project, uint64_t key, int nxyz, double *gridm,
+                                  int *gridnm, int *error) {
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> called\n", __func__);
+    fprintf(stderr, "dbg2       verbose:      %d\n", verbose);
+    fprintf(stderr, "dbg2       project:      %p\n", project);
+    fprintf(stderr, "dbg2       key:          %016llx\n", (unsigned long long)key);
+    fprintf(stderr, "dbg2       nxyz:         %d\n", nxyz);
+  }
+
+  int status = MB_SUCCESS;
+  *error = MB_ERROR_NO_ERROR;
+
+  mb_pathplus path;
+  mbnavadjust_misfit_cachefile(project, key, path, sizeof(path));
+  FILE *fp = fopen(path, "rb");
+  if (fp == NULL) {
+    *error = MB_ERROR_OPEN_FAIL;
+    status = MB_FAILURE;
+  }
+  else {
+    char magic[8];
+    uint64_t filekey = 0;
+    int filenxyz = 0;
+    if (!(fread(magic, sizeof(magic), 1, fp) == 1 && memcmp(magic, MBNA_MISFIT_CACHE_MAGIC, sizeof(magic)) == 0 &&
+          fread(&filekey, sizeof(filekey), 1, fp) == 1 && filekey == key &&
+          fread(&filenxyz, sizeof(filenxyz), 1, fp) == 1 && filenxyz == nxyz &&
+          fread(gridm, sizeof(double), nxyz, fp) == (size_t)nxyz &&
+          fread(gridnm, sizeof(int), nxyz, fp) == (size_t)nxyz)) {
+      *error = MB_ERROR_BAD_FORMAT;
+      status = MB_FAILURE;
+    }
+    fclose(fp);
+
+    /* mark the grid as recently used so that it is the last to be trimmed */
+    if (status == MB_SUCCESS)
+      utime(path, NULL);
+  }
+
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBnavadjust function <%s> completed\n", __func__);
+    fprintf(stderr, "dbg2  Return values:\n");
+    fprintf(stderr, "dbg2       error:       %d\n", *error);
+    fprintf(stderr, "dbg2  Return status:\n");
+    fprintf(stderr, "dbg2       status:      %d\n", status);
+  }
+
+  return (status);
+}
+
+/*--------------------------------------------------------------------*/
+int mbnavadjust_misfit_cache_write(int verbose, struct mbna_project *project, uint64_t key, int nxyz,
+                                   double *gridm, int *gridnm, int *error) {
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> called\n", __func__);
+    fprintf(stderr, "dbg2       verbose:      %d\n", verbose);
+    fprintf(stderr, "dbg2       project:      %p\n", project);
+    fprintf(stderr, "dbg2       key:          %016llx\n", (unsigned long long)key);
+    fprintf(stderr, "dbg2       nxyz:         %d\n", nxyz);
+  }
+
+  int status = MB_SUCCESS;
+  *error = MB_ERROR_NO_ERROR;
+
+  /* write to a temporary file and rename so that readers never see a partial file */
+  mb_pathplus dir;
+  snprintf(dir, sizeof(dir), "%s/misfit", project->datadir);
+  struct stat statbuf;
+  if (stat(dir, &statbuf) != 0) {
+#ifdef _WIN32
+    if (mkdir(dir) != 0) {
+#else
+    if (mkdir(dir, 00775) != 0) {
+#endif
+      *error = MB_ERROR_OPEN_FAIL;
+      status = MB_FAILURE;
+    }
+  }
+  mb_pathplus path;
+  mb_pathplusplus tmppath;
+  FILE *fp = NULL;
+  if (status == MB_SUCCESS) {
+    mbnavadjust_misfit_cachefile(project, key, path, sizeof(path));
+    snprintf(tmppath, sizeof(tmppath), "%s.%d.tmp", path, (int)getpid());
+    if ((fp = fopen(tmppath, "wb")) == NULL) {
+      *error = MB_ERROR_OPEN_FAIL;
+      status = MB_FAILURE;
+    }
+  }
+  if (status == MB_SUCCESS) {
+    bool ok = fwrite(MBNA_MISFIT_CACHE_MAGIC, 8, 1, fp) == 1 && fwrite(&key, sizeof(key), 1, fp) == 1 &&
+              fwrite(&nxyz, sizeof(nxyz), 1, fp) == 1 && fwrite(gridm, sizeof(double), nxyz, fp) == (size_t)nxyz &&
+              fwrite(gridnm, sizeof(int), nxyz, fp) == (size_t)nxyz;
+    if (fclose(fp) != 0)
+      ok = false;
+    if (!ok || rename(tmppath, path) != 0) {
+      remove(tmppath);
+      *error = MB_ERROR_WRITE_FAIL;
+      status = MB_FAILURE;
+    }
+  }
+
+  /* keep the cache within its size bound */
+  if (status == MB_SUCCESS)
+    mbnavadjust_misfit_cache_trim(verbose, project);
+
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBnavadjust function <%s> completed\n", __func__);
+    fprintf(stderr, "dbg2  Return values:\n");
+    fprintf(stderr, "dbg2       error:       %d\n", *error);
+    fprintf(stderr, "dbg2  Return status:\n");
+    fprintf(stderr, "dbg2       status:      %d\n", status);
+  }
+
+  return (status);
+}
+
+/*--------------------------------------------------------------------*/
+int mbnavadjust_misfit_grid(int verbose, int nthreads, int grid_nx, int grid_ny,
+                            double *grid1, int *gridn1, double *grid2, int *gridn2, int gridm_nx, int gridm_ny,
+                            int nzmisfitcalc, double zmin, double zoff_dz, double offset_z, double *gridm, int *gridnm,
+                            int *error) {
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> called\n", __func__);
+    fprintf(stderr, "dbg2       verbose:      %d\n", verbose);
+    fprintf(stderr, "dbg2       nthreads:     %d\n", nthreads);
+    fprintf(stderr, "dbg2       grid_nx:      %d\n", grid_nx);
+    fprintf(stderr, "dbg2       grid_ny:      %d\n", grid_ny);
+    fprintf(stderr, "dbg2       gridm_nx:     %d\n", gridm_nx);
+    fprintf(stderr, "dbg2       gridm_ny:     %d\n", gridm_ny);
+    fprintf(stderr, "dbg2       nzmisfitcalc: %d\n", nzmisfitcalc);
+    fprintf(stderr, "dbg2       zmin:         %f\n", zmin);
+    fprintf(stderr, "dbg2       zoff_dz:      %f\n", zoff_dz);
+    fprintf(stderr, "dbg2       offset_z:     %f\n", offset_z);
+  }
+
+  int status = MB_SUCCESS;
+  *error = MB_ERROR_NO_ERROR;
+  const int grid_nxy = grid_nx * grid_ny;
+
+  double *mask1 = (double *)malloc(sizeof(double) * grid_nxy);
+  double *mask2 = (double *)malloc(sizeof(double) * grid_nxy);
+  if (mask1 == NULL || mask2 == NULL) {
+    free(mask1);
+    free(mask2);
+    *error = MB_ERROR_MEMORY_FAIL;
+    status = MB_FAILURE;
+  }
+  else {
+    for (int k = 0; k < grid_nxy; k++) {
+      mask1[k] = gridn1[k] > 0 ? 1.0 : 0.0;
+      mask2[k] = gridn2[k] > 0 ? 1.0 : 0.0;
+    }
+
+    nthreads = MAX(1, MIN(MIN(nthreads, MB_THREAD_MAX), gridm_ny));
+    struct mbna_misfit_work work[MB_THREAD_MAX];
+    pthread_t threads[MB_THREAD_MAX];
+    bool started[MB_THREAD_MAX];
+    for (int ithread = 0; ithread < nthreads; ithread++) {
+      struct mbna_misfit_work *w = &work[ithread];
+      w->grid_nx = grid_nx;
+      w->grid_ny = grid_ny;
+      w->grid1 = grid1;
+      w->grid2 = grid2;
+      w->mask1 = mask1;
+      w->mask2 = mask2;
+      w->gridm_nx = gridm_nx;
+      w->gridm_ny = gridm_ny;
+      w->nz = nzmisfitcalc;
+      w->zmin = zmin;
+      w->zoff_dz = zoff_dz;
+      w->offset_z = offset_z;
+      w->gridm = gridm;
+      w->gridnm = gridnm;
+      w->jc_start = ithread * gridm_ny / nthreads;
+      w->jc_end = (ithread + 1) * gridm_ny / nthreads;
+    }
+    for (int ithread = 1; ithread < nthreads; ithread++)
+      started[ithread] = pthread_create(&threads[ithread], NULL, mbnavadjust_misfit_worker, &work[ithread]) == 0;
+    mbnavadjust_misfit_worker(&work[0]);
+    for (int ithread = 1; ithread < nthreads; ithread++) {
+      if (started[ithread])
+        pthread_join(threads[ithread], NULL);
+      else
+        mbnavadjust_misfit_worker(&work[ithread]);
+    }
+    free(mask1);
+    free(mask2);
+  }
+
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBnavadjust function <%s> completed\n", __func__);
+    fprintf(stderr, "dbg2  Return values:\n");
+    fprintf(stderr, "dbg2       error:       %d\n", *error);
+    fprintf(stderr, "dbg2  Return status:\n");
+    fprintf(stderr, "dbg2       status:      %d\n", status);
+  }
+
+  return (status);
+}
+/*--------------------------------------------------------------------*/
+/* Column scaled CGLS solver for the navigation inversion. The matrix is
+   copied into compressed sparse row form together with its transpose, with
+   each column scaled to unit norm, so that both A*x and A'*y are row-wise
+   gathers that can be shared out between threads without write conflicts.
+   The stopping rules and termination codes follow those of LSQR so that the
+   two solvers can be compared directly. */
+
+struct mbna_csr {
+  int nrows;
+  int ncols;
+  int *row_start;
+  int *col;
+  double *val;
+};
+
+struct mbna_cgls_pool;
+
+struct mbna_cgls_thread {
+  struct mbna_cgls_pool *pool;
+  int ithread;
+  pthread_t thread;
+};
+
+struct mbna_cgls_pool {
+  int nthreads;
+  struct mbna_cgls_thread threads[MB_THREAD_MAX];
+  pthread_mutex_t mutex;
+  pthread_cond_t start;
+  pthread_cond_t done;
+  int generation;
+  int pending;
+  bool quit;
+  const struct mbna_csr *csr;
+  const double *in;
+  double *out;
+};
+
+static void mbnavadjust_csr_free(struct mbna_csr *csr) {
+  free(csr->row_start);
+  free(csr->col);
+  free(csr->val);
+  memset(csr, 0, sizeof(struct mbna_csr));
+}
+
+static bool mbnavadjust_csr_init(const struct mbna_matrix *matrix, double *scale, struct mbna_csr *a,
+                                 struct mbna_csr *at) {
+  memset(a, 0, sizeof(struct mbna_csr));
+  memset(at, 0, sizeof(struct mbna_csr));
+  const int m = matrix->m;
+  const int n = matrix->n;
+  int nnz = 0;
+  for (int i = 0; i < m; i++)
+    nnz += matrix->nia[i];
+
+  a->nrows = m;
+  a->ncols = n;
+  a->row_start = (int *)malloc(sizeof(int) * (m + 1));
+  a->col = (int *)malloc(sizeof(int) * MAX(nnz, 1));
+  a->val = (double *)malloc(sizeof(double) * MAX(nnz, 1));
+  at->nrows = n;
+  at->ncols = m;
+  at->row_start = (int *)calloc(n + 1, sizeof(int));
+  at->col = (int *)malloc(sizeof(int) * MAX(nnz, 1));
+  at->val = (double *)malloc(sizeof(double) * MAX(nnz, 1));
+  int *fill = (int *)malloc(sizeof(int) * MAX(n, 1));
+  if (a->row_start == NULL || a->col == NULL || a->val == NULL || at->row_start == NULL || at->col == NULL ||
+      at->val == NULL || fill == NULL) {
+    free(fill);
+    mbnavadjust_csr_free(a);
+    mbnavadjust_csr_free(at);
+    return (false);
+  }
+
+  /* get the column norms */
+  for (int j = 0; j < n; j++)
+    scale[j] = 0.0;
+  for (int i = 0; i < m; i++) {
+    for (int l = 0; l < matrix->nia[i]; l++) {
+      const double value = matrix->a[matrix->ia_dim * i + l];
+      scale[matrix->ia[matrix->ia_dim * i + l]] += value * value;
+    }
+  }
+  for (int j = 0; j < n; j++)
+    scale[j] = scale[j] > 0.0 ? 1.0 / sqrt(scale[j]) : 1.0;
+
+  /* copy the scaled matrix, counting the entries of each column */
+  int k = 0;
+  for (int i = 0; i < m; i++) {
+    a->row_start[i] = k;
+    for (int l = 0; l < matrix->nia[i]; l++, k++) {
+      const int j = matrix->ia[matrix->ia_dim * i + l];
+      a->col[k] = j;
+      a->val[k] = matrix->a[matrix->ia_dim * i + l] * scale[j];
+      at->row_start[j + 1]++;
+    }
+  }
+  a->row_start[m] = k;
+
+  /* then the transpose */
+  for (int j = 0; j < n; j++)
+    at->row_start[j + 1] += at->row_start[j];
+  memcpy(fill, at->row_start, sizeof(int) * n);
+  for (int i = 0; i < m; i++) {
+    for (int k = a->row_start[i]; k < a->row_start[i + 1]; k++) {
+      const int l = fill[a->col[k]]++;
+      at->col[l] = i;
+      at->val[l] = a->val[k];
+    }
+  }
+  free(fill);
+
+  return (true);
+}
+
+static void mbnavadjust_csr_multiply(const struct mbna_csr *csr, const double *in, double *out, int ithread,
+                                     int nthreads) {
+  /* out = csr * in for this thread's share of the rows */
+  const int row_end = (int)((long)(ithread + 1) * csr->nrows / nthreads);
+  for (int i = (int)((long)ithread * csr->nrows / nthreads); i < row_end; i++) {
+    double sum = 0.0;
+    for (int k = csr->row_start[i]; k < csr->row_start[i + 1]; k++)
+      sum += csr->val[k] * in[csr->col[k]];
+    out[i] = sum;
+  }
+}
+
+static void *mbnavadjust_cgls_worker(void *arg) {
+  struct mbna_cgls_pool *pool = ((struct mbna_cgls_thread *)arg)->pool;
+  const int ithread = ((struct mbna_cgls_thread *)arg)->ithread;
+  int generation = 0;
+  while (true) {
+    pthread_mutex_lock(&pool->mutex);
+    while (pool->generation == generation && !pool->quit)
+      pthread_cond_wait(&pool->start, &pool->mutex);
+    if (pool->quit) {
+      pthread_mutex_unlock(&pool->mutex);
+      break;
+    }
+    generation = pool->generation;
+    const struct mbna_csr *csr = pool->csr;
+    const double *in = pool->in;
+    double *out = pool->out;
+    pthread_mutex_unlock(&pool->mutex);
+
+    mbnavadjust_csr_multiply(csr, in, out, ithread, pool->nthreads);
+
+    pthread_mutex_lock(&pool->mutex);
+    if (--pool->pending == 0)
+      pthread_cond_signal(&pool->done);
+    pthread_mutex_unlock(&pool->mutex);
+  }
+  return (NULL);
+}
+
+static void mbnavadjust_cgls_multiply(struct mbna_cgls_pool *pool, const struct mbna_csr *csr, const double *in,
+                                      double *out) {
+  if (pool->nthreads <= 1) {
+    mbnavadjust_csr_multiply(csr, in, out, 0, 1);
+    return;
+  }
+  pthread_mutex_lock(&pool->mutex);
+  pool->csr = csr;
+  pool->in = in;
+  pool->out = out;
+  pool->pending = pool->nthreads - 1;
+  pool->generation++;
+  pthread_cond_broadcast(&pool->start);
+  pthread_mutex_unlock(&pool->mutex);
+
+  mbnavadjust_csr_multiply(csr, in, out, 0, pool->nthreads);
+
+  pthread_mutex_lock(&pool->mutex);
+  while (pool->pending > 0)
+    pthread_cond_wait(&pool->done, &pool->mutex);
+  pthread_mutex_unlock(&pool->mutex);
+}
+
+static double mbnavadjust_dot(int n, const double *a, const double *b) {
+  double sum = 0.0;
+  for (int i = 0; i < n; i++)
+    sum += a[i] * b[i];
+  return (sum);
+}
+
+/*--------------------------------------------------------------------*/
+int mbnavadjust_solve_cgls(int verbose, struct mbna_matrix *matrix, double *b, double *x, int nthreads, double atol,
+                           double btol, int itnlim, int *istop_out, int *itn_out, double *rnorm_out,
+                           double *arnorm_out, int *error) {
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> called\n", __func__);
+    fprintf(stderr, "dbg2       verbose:    %d\n", verbose);
+    fprintf(stderr, "dbg2       matrix:     %p\n", matrix);
+    fprintf(stderr, "dbg2       m:          %d\n", matrix->m);
+    fprintf(stderr, "dbg2       n:          %d\n", matrix->n);
+    fprintf(stderr, "dbg2       nthreads:   %d\n", nthreads);
+    fprintf(stderr, "dbg2       atol:       %g\n", atol);
+    fprintf(stderr, "dbg2       btol:       %g\n", btol);
+    fprintf(stderr, "dbg2       itnlim:     %d\n", itnlim);
+  }
+
+  int status = MB_SUCCESS;
+  *error = MB_ERROR_NO_ERROR;
+  *istop_out = 0;
+  *itn_out = 0;
+  *rnorm_out = 0.0;
+  *arnorm_out = 0.0;
+
+  const int m = matrix->m;
+  const int n = matrix->n;
+  struct mbna_csr a;
+  struct mbna_csr at;
+  double *scale = (double *)malloc(sizeof(double) * MAX(n, 1));
+  double *r = (double *)malloc(sizeof(double) * MAX(m, 1));
+  double *q = (double *)malloc(sizeof(double) * MAX(m, 1));
+  double *s = (double *)malloc(sizeof(double) * MAX(n, 1));
+  double *p = (double *)malloc(sizeof(double) * MAX(n, 1));
+  if (scale == NULL || r == NULL || q == NULL || s == NULL || p == NULL ||
+      !mbnavadjust_csr_init(matrix, scale, &a, &at)) {
+    free(scale);
+    free(r);
+    free(q);
+    free(s);
+    free(p);
+    *error = MB_ERROR_MEMORY_FAIL;
+    return (MB_FAILURE);
+  }
+
+  /* start the threads for the matrix products */
+  struct mbna_cgls_pool pool;
+  memset(&pool, 0, sizeof(struct mbna_cgls_pool));
+  pool.nthreads = MAX(1, MIN(MIN(nthreads, MB_THREAD_MAX), m / 1000 + 1));
+  pthread_mutex_init(&pool.mutex, NULL);
+  pthread_cond_init(&pool.start, NULL);
+  pthread_cond_init(&pool.done, NULL);
+  for (int ithread = 1; ithread < pool.nthreads; ithread++) {
+    pool.threads[ithread].pool = &pool;
+    pool.threads[ithread].ithread = ithread;
+    if (pthread_create(&pool.threads[ithread].thread, NULL, mbnavadjust_cgls_worker, &pool.threads[ithread]) != 0) {
+      pool.nthreads = ithread;
+      break;
+    }
+  }
+
+  /* the Frobenius norm of the scaled matrix is the root of the number of nonzero columns */
+  int ncols_nonzero = 0;
+  for (int j = 0; j < n; j++) {
+    if (at.row_start[j + 1] > at.row_start[j])
+      ncols_nonzero++;
+  }
+  const double anorm = sqrt((double)ncols_nonzero);
+
+  /* solve for the scaled model y = x / scale starting from zero */
+  for (int j = 0; j < n; j++)
+    x[j] = 0.0;
+  memcpy(r, b, sizeof(double) * m);
+  const double bnorm = sqrt(mbnavadjust_dot(m, b, b));
+  mbnavadjust_cgls_multiply(&pool, &at, r, s);
+  memcpy(p, s, sizeof(double) * n);
+  double gamma = mbnavadjust_dot(n, s, s);
+  double rnorm = bnorm;
+  int istop = 0;
+  int itn = 0;
+  if (bnorm == 0.0 || gamma == 0.0)
+    istop = bnorm == 0.0 ? 1 : 2;
+  while (istop == 0) {
+    if (itn >= itnlim) {
+      istop = 7;
+      break;
+    }
+    itn++;
+    mbnavadjust_cgls_multiply(&pool, &a, p, q);
+    const double qq = mbnavadjust_dot(m, q, q);
+    if (qq <= 0.0) {
+      istop = 2;
+      break;
+    }
+    const double alpha = gamma / qq;
+    for (int j = 0; j < n; j++)
+      x[j] += alpha * p[j];
+    for (int i = 0; i < m; i++)
+      r[i] -= alpha * q[i];
+    mbnavadjust_cgls_multiply(&pool, &at, r, s);
+    const double gamma_new = mbnavadjust_dot(n, s, s);
+    rnorm = sqrt(mbnavadjust_dot(m, r, r));
+    if (rnorm <= btol * bnorm)
+      istop = 1;
+    else if (sqrt(gamma_new) <= atol * anorm * rnorm)
+      istop = 2;
+    const double beta = gamma_new / gamma;
+    gamma = gamma_new;
+    for (int j = 0; j < n; j++)
+      p[j] = s[j] + beta * p[j];
+  }
+
+  /* unscale the solution */
+  for (int j = 0; j < n; j++)
+    x[j] *= scale[j];
+
+  /* stop the threads */
+  pthread_mutex_lock(&pool.mutex);
+  pool.quit = true;
+  pthread_cond_broadcast(&pool.start);
+  pthread_mutex_unlock(&pool.mutex);
+  for (int ithread = 1; ithread < pool.nthreads; ithread++)
+    pthread_join(pool.threads[ithread].thread, NULL);
+  pthread_mutex_destroy(&pool.mutex);
+  pthread_cond_destroy(&pool.start);
+  pthread_cond_destroy(&pool.done);
+
+  *istop_out = istop;
+  *itn_out = itn;
+  *rnorm_out = rnorm;
+  *arnorm_out = sqrt(gamma);
+
+  mbnavadjust_csr_free(&a);
+  mbnavadjust_csr_free(&at);
+  free(scale);
+  free(r);
+  free(q);
+  free(s);
+  free(p);
+
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBnavadjust function <%s> completed\n", __func__);
+    fprintf(stderr, "dbg2  Return values:\n");
+    fprintf(stderr, "dbg2       istop:       %d\n", *istop_out);
+    fprintf(stderr, "dbg2       itn:         %d\n", *itn_out);
+    fprintf(stderr, "dbg2       rnorm:       %g\n", *rnorm_out);
+    fprintf(stderr, "dbg2       arnorm:      %g\n", *arnorm_out);
+    fprintf(stderr, "dbg2       error:       %d\n", *error);
+    fprintf(stderr, "dbg2  Return status:\n");
+    fprintf(stderr, "dbg2       status:      %d\n", status);
+  }
+
+  return (status);
+}
+/*--------------------------------------------------------------------*/
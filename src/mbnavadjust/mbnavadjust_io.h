@@ -124,11 +124,13 @@
 #define MBNA_PLOT_MODE_ZOOMFIRST 2
 #define MBNA_PLOT_MODE_ZOOM 3
 #define MBNA_MASK_DIM 25
+#define MBNA_CROSSING_GRID_MAX 1024
 #define MBNA_MISFIT_ZEROCENTER 0
 #define MBNA_MISFIT_AUTOCENTER 1
 #define MBNA_MISFIT_DIMXY 61
 #define MBNA_MISFIT_NTHRESHOLD (MBNA_MISFIT_DIMXY * MBNA_MISFIT_DIMXY / 36)
 #define MBNA_MISFIT_DIMZ 51
+#define MBNA_MISFIT_CACHE_SIZE_MAX 536870912
 #define MBNA_BIAS_SAME 0
 #define MBNA_BIAS_DIFFERENT 1
 #define MBNA_MEDIOCREOVERLAP_THRESHOLD 10
@@ -518,6 +520,7 @@ int mbnavadjust_coverage_mask(int verbose, struct mbna_project *project,
 int mbnavadjust_import_reference(int verbose, struct mbna_project *project, char *path, int *error);
 int mbnavadjust_findcrossings(int verbose, struct mbna_project *project, int *error);
 int mbnavadjust_findcrossingsfile(int verbose, struct mbna_project *project, int ifile, int *error);
+int mbnavadjust_findcrossingsall(int verbose, struct mbna_project *project, int nthreads, int *error);
 int mbnavadjust_addcrossing(int verbose, struct mbna_project *project, int ifile1, int isection1, int ifile2, int isection2, int *error);
 bool mbnavadjust_sections_intersect(int verbose, struct mbna_project *project, int crossing_id, int *error);
 int mbnavadjust_bin_bathymetry(int verbose, struct mbna_project *project,
@@ -525,6 +528,20 @@ int mbnavadjust_bin_bathymetry(int verbose, struct mbna_project *project,
                                double *bathalongtrack, int mbna_bin_beams_bath, double mbna_bin_pseudobeamwidth,
                                double mbna_bin_swathwidth, char *bin_beamflag, double *bin_bath, double *bin_bathacrosstrack,
                                double *bin_bathalongtrack, int *error);
+int mbnavadjust_misfit_cachekey(int verbose, struct mbna_project *project, int file_id_1, int section_1,
+                                int file_id_2, int section_2, int nparameters, double *parameters,
+                                uint64_t *key, int *error);
+int mbnavadjust_misfit_cache_read(int verbose, struct mbna_project *project, uint64_t key, int nxyz, double *gridm,
+                                  int *gridnm, int *error);
+int mbnavadjust_misfit_cache_write(int verbose, struct mbna_project *project, uint64_t key, int nxyz,
+                                   double *gridm, int *gridnm, int *error);
+int mbnavadjust_misfit_grid(int verbose, int nthreads, int grid_nx, int grid_ny,
+                            double *grid1, int *gridn1, double *grid2, int *gridn2, int gridm_nx, int gridm_ny,
+                            int nzmisfitcalc, double zmin, double zoff_dz, double offset_z, double *gridm, int *gridnm,
+                            int *error);
+int mbnavadjust_solve_cgls(int verbose, struct mbna_matrix *matrix, double *b, double *x, int nthreads, double atol,
+                           double btol, int itnlim, int *istop_out, int *itn_out, double *rnorm_out,
+                           double *arnorm_out, int *error);
 int mbnavadjust_crossing_compare(const void *a, const void *b);
 int mbnavadjust_tie_compare(const void *a, const void *b);
 int mbnavadjust_globaltie_compare(const void *a, const void *b);
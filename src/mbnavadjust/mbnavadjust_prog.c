@@ -93,7 +93,7 @@ struct swathraw {
 /* id variables */
 static const char program_name[] = "mbnavadjust";
 static const char help_message[] = "mbnavadjust is an interactive navigation adjustment package for swath sonar data.\n";
-static const char usage_message[] = "mbnavadjust [-Iproject -V -H]";
+static const char usage_message[] = "mbnavadjust [-Iproject -Slsqr|cgls|compare -V -H]";
 
 /* status variables */
 int error = MB_ERROR_NO_ERROR;
@@ -151,6 +151,13 @@ struct swath *swath1 = NULL;
 struct swath *swath2 = NULL;
 struct ping *ping = NULL;
 
+/* true while the sections of an autopicked crossing have not been loaded
+   because every misfit grid so far came from the misfit cache */
+bool swath_load_deferred = false;
+
+/* z offset applied to the soundings of swath2 when last translated */
+double swath2_zoffset = 0.0;
+
 /* misfit grid parameters */
 int grid_nx = 0;
 int grid_ny = 0;
@@ -281,6 +288,7 @@ int mbnavadjust_init_globals() {
   mbna_block_select1 = MBNA_SELECT_NONE;
   mbna_block_select2 = MBNA_SELECT_NONE;
   mbna_reset_crossings = false;
+  mbna_solver = MBNA_SOLVER_LSQR;
   mbna_bin_swathwidth = 160.0;
   mbna_bin_pseudobeamwidth = 1.0;
   mbna_bin_beams_bath = mbna_bin_swathwidth / mbna_bin_pseudobeamwidth + 1;
@@ -341,7 +349,7 @@ int mbnavadjust_init(int argc, char **argv) {
   // bool flag = false;
 
   /* process argument list */
-  while ((c = getopt(argc, argv, "VvHhDdI:i:Rr")) != -1)
+  while ((c = getopt(argc, argv, "VvHhDdI:i:RrS:s:")) != -1)
     switch (c) {
     case 'H':
     case 'h':
@@ -366,6 +374,17 @@ int mbnavadjust_init(int argc, char **argv) {
     case 'r':
       mbna_reset_crossings = true;
       break;
+    case 'S':
+    case 's':
+      if (strncmp(optarg, "cgls", 4) == 0)
+        mbna_solver = MBNA_SOLVER_CGLS;
+      else if (strncmp(optarg, "compare", 7) == 0)
+        mbna_solver = MBNA_SOLVER_COMPARE;
+      else if (strncmp(optarg, "lsqr", 4) == 0)
+        mbna_solver = MBNA_SOLVER_LSQR;
+      else
+        errflg = true;
+      break;
     case '?':
       errflg = true;
     }
@@ -388,6 +407,7 @@ int mbnavadjust_init(int argc, char **argv) {
     fprintf(stderr, "dbg2       mbna_verbose:         %d\n", mbna_verbose);
     fprintf(stderr, "dbg2       help:            %d\n", help);
     fprintf(stderr, "dbg2       input file:      %s\n", ifile);
+    fprintf(stderr, "dbg2       solver:          %d\n", mbna_solver);
   }
 
   if (help) {
@@ -3802,23 +3822,14 @@ int mbnavadjust_crossing_load() {
 // __FILE__, __LINE__, __FUNCTION__, mbna_plot_lon_min, mbna_plot_lon_max, mbna_plot_lat_min, mbna_plot_lat_max);
     mb_coor_scale(mbna_verbose, 0.5 * (mbna_lat_min + mbna_lat_max), &mbna_mtodeglon, &mbna_mtodeglat);
 
-    /* load sections */
-    snprintf(message, sizeof(message), "Loading section 1 of crossing %d...", mbna_current_crossing);
-    do_message_update(message);
-    status = mbnavadjust_section_load(mbna_verbose, &project, mbna_file_id_1, mbna_section_1,
-                                          (void **)&swathraw1, (void **)&swath1, &error);
-    snprintf(message, sizeof(message), "Loading section 2 of crossing %d...", mbna_current_crossing);
-    do_message_update(message);
-    status = mbnavadjust_section_load(mbna_verbose, &project, mbna_file_id_2, mbna_section_2,
-                                          (void **)&swathraw2, (void **)&swath2, &error);
-
-    /* get lon lat positions for soundings */
-    snprintf(message, sizeof(message), "Transforming section 1 of crossing %d...", mbna_current_crossing);
-    do_message_update(message);
-    status = mbnavadjust_section_translate(mbna_verbose, &project, mbna_file_id_1, swathraw1, swath1, 0.0, &error);
-    snprintf(message, sizeof(message), "Transforming section 2 of crossing %d...", mbna_current_crossing);
-    do_message_update(message);
-    status = mbnavadjust_section_translate(mbna_verbose, &project, mbna_file_id_2, swathraw2, swath2, mbna_offset_z, &error);
+    /* load sections - when autopicking nothing is plotted, so loading is
+       left to mbnavadjust_get_misfit() and skipped if the misfit grids
+       are all found in the misfit cache */
+    swath2_zoffset = mbna_offset_z;
+    if (mbna_status == MBNA_STATUS_AUTOPICK)
+      swath_load_deferred = true;
+    else
+      status = mbnavadjust_crossing_load_sections();
 
     /* generate contour data */
     if (mbna_status != MBNA_STATUS_AUTOPICK) {
@@ -3871,6 +3882,43 @@ int mbnavadjust_crossing_load() {
   return (status);
 }
 /*--------------------------------------------------------------------*/
+int mbnavadjust_crossing_load_sections() {
+  if (mbna_verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBIO function <%s> called\n", __func__);
+  }
+
+  int status = MB_SUCCESS;
+
+  /* load sections */
+  snprintf(message, sizeof(message), "Loading section 1 of crossing %d...", mbna_current_crossing);
+  do_message_update(message);
+  status = mbnavadjust_section_load(mbna_verbose, &project, mbna_file_id_1, mbna_section_1,
+                                        (void **)&swathraw1, (void **)&swath1, &error);
+  snprintf(message, sizeof(message), "Loading section 2 of crossing %d...", mbna_current_crossing);
+  do_message_update(message);
+  status = mbnavadjust_section_load(mbna_verbose, &project, mbna_file_id_2, mbna_section_2,
+                                        (void **)&swathraw2, (void **)&swath2, &error);
+
+  /* get lon lat positions for soundings */
+  snprintf(message, sizeof(message), "Transforming section 1 of crossing %d...", mbna_current_crossing);
+  do_message_update(message);
+  status = mbnavadjust_section_translate(mbna_verbose, &project, mbna_file_id_1, swathraw1, swath1, 0.0, &error);
+  snprintf(message, sizeof(message), "Transforming section 2 of crossing %d...", mbna_current_crossing);
+  do_message_update(message);
+  status = mbnavadjust_section_translate(mbna_verbose, &project, mbna_file_id_2, swathraw2, swath2, swath2_zoffset, &error);
+  swath_load_deferred = false;
+
+  if (mbna_verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBnavadjust function <%s> completed\n", __func__);
+    fprintf(stderr, "dbg2  Return values:\n");
+    fprintf(stderr, "dbg2       error:       %d\n", error);
+    fprintf(stderr, "dbg2  Return status:\n");
+    fprintf(stderr, "dbg2       status:      %d\n", status);
+  }
+
+  return (status);
+}
+/*--------------------------------------------------------------------*/
 int mbnavadjust_crossing_unload() {
   if (mbna_verbose >= 2) {
     fprintf(stderr, "\ndbg2  MBIO function <%s> called\n", __func__);
@@ -3880,8 +3928,11 @@ int mbnavadjust_crossing_unload() {
 
   /* unload loaded crossing */
   if (mbna_naverr_mode == MBNA_NAVERR_MODE_CROSSING) {
-    status = mbnavadjust_section_unload(mbna_verbose, (void **)&swathraw1, (void **)&swath1, &error);
-    status = mbnavadjust_section_unload(mbna_verbose, (void **)&swathraw2, (void **)&swath2, &error);
+    if (!swath_load_deferred) {
+      status = mbnavadjust_section_unload(mbna_verbose, (void **)&swathraw1, (void **)&swath1, &error);
+      status = mbnavadjust_section_unload(mbna_verbose, (void **)&swathraw2, (void **)&swath2, &error);
+    }
+    swath_load_deferred = false;
 
     if (mbna_contour1.vector != NULL && mbna_contour1.nvector_alloc > 0) {
       free(mbna_contour1.vector);
@@ -3985,9 +4036,13 @@ int mbnavadjust_crossing_replot() {
 
   /* replot loaded crossing */
   if ((mbna_status == MBNA_STATUS_NAVERR || mbna_status == MBNA_STATUS_AUTOPICK) && mbna_naverr_mode != MBNA_NAVERR_MODE_UNLOADED) {
-    /* get lon lat positions for soundings */
-    status = mbnavadjust_section_translate(mbna_verbose, &project, mbna_file_id_1, swathraw1, swath1, 0.0, &error);
-    status = mbnavadjust_section_translate(mbna_verbose, &project, mbna_file_id_2, swathraw2, swath2, mbna_offset_z, &error);
+    /* get lon lat positions for soundings - sections not yet loaded will be
+       translated with this z offset when they are */
+    swath2_zoffset = mbna_offset_z;
+    if (!swath_load_deferred) {
+      status = mbnavadjust_section_translate(mbna_verbose, &project, mbna_file_id_1, swathraw1, swath1, 0.0, &error);
+      status = mbnavadjust_section_translate(mbna_verbose, &project, mbna_file_id_2, swathraw2, swath2, swath2_zoffset, &error);
+    }
 
     /* generate contour data */
     if (mbna_status != MBNA_STATUS_AUTOPICK) {
@@ -4020,7 +4075,8 @@ int mbnavadjust_referencesection_replot() {
   if ((mbna_status == MBNA_STATUS_NAVERR || mbna_status == MBNA_STATUS_AUTOPICK)
     && mbna_naverr_mode == MBNA_NAVERR_MODE_SECTION) {
     /* get lon lat positions for soundings */
-    status = mbnavadjust_section_translate(mbna_verbose, &project, mbna_file_id_2, swathraw2, swath2, mbna_offset_z, &error);
+    swath2_zoffset = mbna_offset_z;
+    status = mbnavadjust_section_translate(mbna_verbose, &project, mbna_file_id_2, swathraw2, swath2, swath2_zoffset, &error);
 
     /* generate contour data */
     if (mbna_status != MBNA_STATUS_AUTOPICK) {
@@ -4163,7 +4219,8 @@ int mbnavadjust_referenceplussection_load() {
                                           (void **)&swathraw2, (void **)&swath2, &error);
     snprintf(message, sizeof(message), "Transforming file %d section %d...", mbna_current_file, mbna_current_section);
     do_message_update(message);
-    status = mbnavadjust_section_translate(mbna_verbose, &project, mbna_file_id_2, swathraw2, swath2, mbna_offset_z, &error);
+    swath2_zoffset = mbna_offset_z;
+    status = mbnavadjust_section_translate(mbna_verbose, &project, mbna_file_id_2, swathraw2, swath2, swath2_zoffset, &error);
 
     mbna_lon_min = section2->lonmin + mbna_offset_x;
     mbna_lon_max = section2->lonmax + mbna_offset_x;
@@ -4527,7 +4584,6 @@ int mbnavadjust_get_misfit() {
 
   int status = MB_SUCCESS;
   double dinterval;
-  double zoff;
   double minmisfitthreshold, dotproduct;
   double x, y, z, r;
   double dotproductsave2;
@@ -4537,8 +4593,6 @@ int mbnavadjust_get_misfit() {
   bool found;
   int igx, igy;
   int lc;
-  int ioff, joff, istart, iend, jstart, jend;
-  int i2, j2, k1, k2;
   int k, ll;
   void *tptr;
 
@@ -4693,89 +4747,97 @@ int mbnavadjust_get_misfit() {
       }
     }
 
-    /* loop over all beams */
-    for (int i = 0; i < swath1->npings; i++) {
-      for (int j = 0; j < swath1->pings[i].beams_bath; j++) {
-        if (mb_beam_ok(swath1->pings[i].beamflag[j])) {
-          x = (swath1->pings[i].bathlon[j] - grid_olon);
-          y = (swath1->pings[i].bathlat[j] - grid_olat);
-          igx = (int)(x / grid_dx);
-          igy = (int)(y / grid_dy);
-          k = igx + igy * grid_nx;
-          if (igx >= 0 && igx < grid_nx && igy >= 0 && igy < grid_ny) {
-            grid1[k] += swath1->pings[i].bath[j];
-            gridn1[k]++;
-          }
+    /* look for the misfit grid in the cache before loading or gridding the
+       sections - it is keyed by the section files as they stand on disk,
+       the grid geometry and the offsets applied and searched */
+    uint64_t cache_key = 0;
+    bool use_cache = false;
+    bool cached = false;
+    if (status == MB_SUCCESS) {
+      int cache_error = MB_ERROR_NO_ERROR;
+      double cache_parameters[14] = {grid_nx, grid_ny, grid_dx, grid_dy, grid_olon, grid_olat, gridm_nx,
+                                     nzmisfitcalc, mbna_misfit_offset_x, mbna_misfit_offset_y, zmin, zoff_dz,
+                                     mbna_offset_z, swath2_zoffset};
+      use_cache = mbnavadjust_misfit_cachekey(mbna_verbose, &project,
+                                              (mbna_naverr_mode == MBNA_NAVERR_MODE_SECTION ? -1 : mbna_file_id_1),
+                                              mbna_section_1, mbna_file_id_2, mbna_section_2, 14, cache_parameters,
+                                              &cache_key, &cache_error) == MB_SUCCESS;
+      if (use_cache && mbnavadjust_misfit_cache_read(mbna_verbose, &project, cache_key, gridm_nxyz, gridm, gridnm,
+                                                     &cache_error) == MB_SUCCESS) {
+        cached = true;
+        if (mbna_verbose > 0)
+          fprintf(stderr, "Misfit grid read from cache %016llx\n", (unsigned long long)cache_key);
+      }
+    }
+
+    /* load the sections if that was deferred, then grid the bathymetry */
+    if (status == MB_SUCCESS && !cached) {
+      if (swath_load_deferred)
+        mbnavadjust_crossing_load_sections();
+
+      /* loop over all beams */
+      for (int i = 0; i < swath1->npings; i++) {
+        for (int j = 0; j < swath1->pings[i].beams_bath; j++) {
+          if (mb_beam_ok(swath1->pings[i].beamflag[j])) {
+            x = (swath1->pings[i].bathlon[j] - grid_olon);
+            y = (swath1->pings[i].bathlat[j] - grid_olat);
+            igx = (int)(x / grid_dx);
+            igy = (int)(y / grid_dy);
+            k = igx + igy * grid_nx;
+            if (igx >= 0 && igx < grid_nx && igy >= 0 && igy < grid_ny) {
+              grid1[k] += swath1->pings[i].bath[j];
+              gridn1[k]++;
+            }
 //else
 //fprintf(stderr,"DEBUG %s %d: BAD swath1: %d %d  %.10f %.10f  %f %f  %d %d\n",
 //__FILE__,__LINE__,
 //i, j, swath1->pings[i].bathlon[j], swath1->pings[i].bathlat[j], x, y, igx, igy);
+          }
         }
       }
-    }
 
-    /* loop over all beams */
-    for (int i = 0; i < swath2->npings; i++) {
-      for (int j = 0; j < swath2->pings[i].beams_bath; j++) {
-        if (mb_beam_ok(swath2->pings[i].beamflag[j])) {
-          x = (swath2->pings[i].bathlon[j] + mbna_misfit_offset_x - grid_olon);
-          y = (swath2->pings[i].bathlat[j] + mbna_misfit_offset_y - grid_olat);
-          igx = (int)(x / grid_dx);
-          igy = (int)(y / grid_dy);
-          k = igx + igy * grid_nx;
-          if (igx >= 0 && igx < grid_nx && igy >= 0 && igy < grid_ny) {
-            grid2[k] += swath2->pings[i].bath[j];
-            gridn2[k]++;
-          }
+      /* loop over all beams */
+      for (int i = 0; i < swath2->npings; i++) {
+        for (int j = 0; j < swath2->pings[i].beams_bath; j++) {
+          if (mb_beam_ok(swath2->pings[i].beamflag[j])) {
+            x = (swath2->pings[i].bathlon[j] + mbna_misfit_offset_x - grid_olon);
+            y = (swath2->pings[i].bathlat[j] + mbna_misfit_offset_y - grid_olat);
+            igx = (int)(x / grid_dx);
+            igy = (int)(y / grid_dy);
+            k = igx + igy * grid_nx;
+            if (igx >= 0 && igx < grid_nx && igy >= 0 && igy < grid_ny) {
+              grid2[k] += swath2->pings[i].bath[j];
+              gridn2[k]++;
+            }
 //else
 //fprintf(stderr,"DEBUG %s %d: BAD swath2: %d %d  %.10f %.10f  %f %f  %d %d\n",
 //__FILE__,__LINE__,
 //i, j, swath2->pings[i].bathlon[j], swath2->pings[i].bathlat[j], x, y, igx, igy);
+          }
         }
       }
-    }
 
-    /* calculate gridded bath */
-    for (int k = 0; k < grid_nxy; k++) {
-      if (gridn1[k] > 0) {
-        grid1[k] = (grid1[k] / gridn1[k]);
-      }
-      if (gridn2[k] > 0) {
-        grid2[k] = (grid2[k] / gridn2[k]);
+      /* calculate gridded bath */
+      for (int k = 0; k < grid_nxy; k++) {
+        if (gridn1[k] > 0) {
+          grid1[k] = (grid1[k] / gridn1[k]);
+        }
+        if (gridn2[k] > 0) {
+          grid2[k] = (grid2[k] / gridn2[k]);
+        }
+        /* fprintf(stderr,"GRIDDED BATH: k:%d 1:%d %f   2:%d %f\n",
+        k,gridn1[k],grid1[k],gridn2[k],grid2[k]); */
       }
-      /* fprintf(stderr,"GRIDDED BATH: k:%d 1:%d %f   2:%d %f\n",
-      k,gridn1[k],grid1[k],gridn2[k],grid2[k]); */
-    }
 
-    /* calculate gridded misfit over lateral and z offsets */
-    for (int ic = 0; ic < gridm_nx; ic++)
-      for (int jc = 0; jc < gridm_ny; jc++)
-        for (int kc = 0; kc < nzmisfitcalc; kc++) {
-          lc = kc + nzmisfitcalc * (ic + jc * gridm_nx);
-          gridm[lc] = 0.0;
-          gridnm[lc] = 0;
-
-          ioff = (gridm_nx / 2) - ic;
-          joff = (gridm_ny / 2) - jc;
-          zoff = zmin + zoff_dz * kc;
-
-          istart = MAX(-ioff, 0);
-          iend = grid_nx - MAX(0, ioff);
-          jstart = MAX(-joff, 0);
-          jend = grid_ny - MAX(0, joff);
-          for (int i1 = istart; i1 < iend; i1++)
-            for (int j1 = jstart; j1 < jend; j1++) {
-              i2 = i1 + ioff;
-              j2 = j1 + joff;
-              k1 = i1 + j1 * grid_nx;
-              k2 = i2 + j2 * grid_nx;
-              if (gridn1[k1] > 0 && gridn2[k2] > 0) {
-                gridm[lc] += (grid2[k2] - grid1[k1] + zoff - mbna_offset_z) *
-                             (grid2[k2] - grid1[k1] + zoff - mbna_offset_z);
-                gridnm[lc]++;
-              }
-            }
-        }
+      /* calculate gridded misfit over lateral and z offsets */
+      int error = MB_ERROR_NO_ERROR;
+      const int nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+      status = mbnavadjust_misfit_grid(mbna_verbose, nthreads, grid_nx, grid_ny, grid1, gridn1, grid2, gridn2,
+                                       gridm_nx, gridm_ny, nzmisfitcalc, zmin, zoff_dz, mbna_offset_z, gridm, gridnm,
+                                       &error);
+      if (status == MB_SUCCESS && use_cache)
+        mbnavadjust_misfit_cache_write(mbna_verbose, &project, cache_key, gridm_nxyz, gridm, gridnm, &error);
+    }
     misfit_min = 0.0;
     misfit_max = 0.0;
     mbna_minmisfit = 0.0;
@@ -7794,6 +7856,25 @@ int mbnavadjust_unsetskipped() {
   return (status);
 }
 /*--------------------------------------------------------------------*/
+/* Wall clock time in seconds, used to time the inversion solvers. */
+static double mbnavadjust_seconds(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return ((double)now.tv_sec + 1.0e-9 * (double)now.tv_nsec);
+}
+/*--------------------------------------------------------------------*/
+/* Returns the norm of the inversion residual Ax - b. */
+static double mbnavadjust_matrix_residual(struct mbna_matrix *matrix, double *b, double *x) {
+  double sum = 0.0;
+  for (int i = 0; i < matrix->m; i++) {
+    double r = -b[i];
+    for (int l = 0; l < matrix->nia[i]; l++)
+      r += matrix->a[matrix->ia_dim * i + l] * x[matrix->ia[matrix->ia_dim * i + l]];
+    sum += r * r;
+  }
+  return (sqrt(sum));
+}
+/*--------------------------------------------------------------------*/
 void mb_aprod(int mode, int m, int n, double x[], double y[], void *UsrWrk) {
   (void)n;  // Unused parameter
   // mode == 1 : compute y = y + A*x
@@ -10531,17 +10612,61 @@ fprintf(stderr, "\nGlobal ties Z %d:\n", nglobaltiez);
       //  fprintf(stderr," | b:%10.6f\n",u[i]);
       //  }
 
-      mblsqr_lsqr(matrix.m, matrix.n, &mb_aprod, damp, &matrix, u, v, w, x, se, atol, btol, conlim, itnlim, stderr, &istop_out,
-                  &itn_out, &anorm_out, &acond_out, &rnorm_out, &arnorm_out, &xnorm_out);
-
-      fprintf(stderr, "\nInversion by LSQR completed\n");
-      fprintf(stderr, "\tReason for termination:       %d\n", istop_out);
-      fprintf(stderr, "\tNumber of iterations:         %d\n", itn_out);
-      fprintf(stderr, "\tFrobenius norm:               %f\n (expected to be about %f)\n", anorm_out, sqrt((double)matrix.n));
-      fprintf(stderr, "\tCondition number of A:        %f\n", acond_out);
-      fprintf(stderr, "\tRbar norm:                    %f\n", rnorm_out);
-      fprintf(stderr, "\tResidual norm:                %f\n", arnorm_out);
-      fprintf(stderr, "\tSolution norm:                %f\n", xnorm_out);
+      double lsqr_seconds = 0.0;
+      if (mbna_solver != MBNA_SOLVER_CGLS) {
+        const double start = mbnavadjust_seconds();
+        mblsqr_lsqr(matrix.m, matrix.n, &mb_aprod, damp, &matrix, u, v, w, x, se, atol, btol, conlim, itnlim, stderr, &istop_out,
+                    &itn_out, &anorm_out, &acond_out, &rnorm_out, &arnorm_out, &xnorm_out);
+        lsqr_seconds = mbnavadjust_seconds() - start;
+
+        fprintf(stderr, "\nInversion by LSQR completed\n");
+        fprintf(stderr, "\tReason for termination:       %d\n", istop_out);
+        fprintf(stderr, "\tNumber of iterations:         %d\n", itn_out);
+        fprintf(stderr, "\tFrobenius norm:               %f\n (expected to be about %f)\n", anorm_out, sqrt((double)matrix.n));
+        fprintf(stderr, "\tCondition number of A:        %f\n", acond_out);
+        fprintf(stderr, "\tRbar norm:                    %f\n", rnorm_out);
+        fprintf(stderr, "\tResidual norm:                %f\n", arnorm_out);
+        fprintf(stderr, "\tSolution norm:                %f\n", xnorm_out);
+        fprintf(stderr, "\tElapsed time:                 %f seconds\n", lsqr_seconds);
+      }
+
+      /* the column scaled CGLS solver either replaces LSQR or is run alongside it for comparison */
+      if (mbna_solver != MBNA_SOLVER_LSQR) {
+        double *x_cgls = x;
+        if (mbna_solver == MBNA_SOLVER_COMPARE)
+          status = mb_mallocd(mbna_verbose, __FILE__, __LINE__, matrix.n * sizeof(double), (void **)&x_cgls, &error);
+        if (x_cgls != NULL) {
+          const int nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+          int cgls_istop = 0;
+          int cgls_itn = 0;
+          double cgls_rnorm = 0.0;
+          double cgls_arnorm = 0.0;
+          const double start = mbnavadjust_seconds();
+          status = mbnavadjust_solve_cgls(mbna_verbose, &matrix, b, x_cgls, nthreads, atol, btol, itnlim, &cgls_istop,
+                                          &cgls_itn, &cgls_rnorm, &cgls_arnorm, &error);
+          const double cgls_seconds = mbnavadjust_seconds() - start;
+
+          fprintf(stderr, "\nInversion by CGLS completed\n");
+          fprintf(stderr, "\tReason for termination:       %d\n", cgls_istop);
+          fprintf(stderr, "\tNumber of iterations:         %d\n", cgls_itn);
+          fprintf(stderr, "\tRbar norm:                    %f\n", cgls_rnorm);
+          fprintf(stderr, "\tResidual norm:                %f\n", cgls_arnorm);
+          fprintf(stderr, "\tElapsed time:                 %f seconds\n", cgls_seconds);
+
+          if (mbna_solver == MBNA_SOLVER_COMPARE) {
+            double dxmax = 0.0;
+            for (int i = 0; i < matrix.n; i++)
+              dxmax = MAX(dxmax, fabs(x_cgls[i] - x[i]));
+            fprintf(stderr, "\nComparison of LSQR and CGLS solutions (LSQR solution used)\n");
+            fprintf(stderr, "\tLSQR |Ax-b|:                  %f  time: %f seconds\n",
+                    mbnavadjust_matrix_residual(&matrix, b, x), lsqr_seconds);
+            fprintf(stderr, "\tCGLS |Ax-b|:                  %f  time: %f seconds\n",
+                    mbnavadjust_matrix_residual(&matrix, b, x_cgls), cgls_seconds);
+            fprintf(stderr, "\tMaximum solution difference:  %f\n", dxmax);
+            mb_freed(mbna_verbose, __FILE__, __LINE__, (void **)&x_cgls, &error);
+          }
+        }
+      }
 
       /* interpolate solution */
       itielast = -1;
@@ -251,6 +251,7 @@ mb1r_reader_t *mb1r_reader_new(const char *host, int port, uint32_t capacity)
             self->state=ME_ECREATE;
         }
         self->stats=mstats_new(MB1R_EV_COUNT, MB1R_STA_COUNT, MB1R_MET_COUNT, mb1r_stats_labels);
+        self->frame_hist=mstats_hist_new("mb1r_frame_xt", MSTATS_HIST_SUB_BITS_DFL, MSTATS_HIST_MAX_EXP_DFL, 1, MSTATS_HIST_UNIT_NSEC);
     }
 
     return self;
@@ -286,6 +287,7 @@ mb1r_reader_t *mb1r_freader_new(mfile_file_t *file, uint32_t capacity)
         self->state=MB1R_INITIALIZED;
 
         self->stats=mstats_new(MB1R_EV_COUNT, MB1R_STA_COUNT, MB1R_MET_COUNT, mb1r_stats_labels);
+        self->frame_hist=mstats_hist_new("mb1r_frame_xt", MSTATS_HIST_SUB_BITS_DFL, MSTATS_HIST_MAX_EXP_DFL, 1, MSTATS_HIST_UNIT_NSEC);
     }
 
     return self;
@@ -310,6 +312,9 @@ void mb1r_reader_destroy(mb1r_reader_t **pself)
             if (self->stats) {
                 mstats_destroy(&self->stats);
             }
+            if (self->frame_hist) {
+                mstats_hist_destroy(&self->frame_hist);
+            }
 
             free(self);
             *pself = NULL;
@@ -408,6 +413,20 @@ mstats_t *mb1r_reader_get_stats(mb1r_reader_t *self)
 }
 // End function mb1r_reader_get_stats
 
+/// @fn mstats_hist_t *mb1r_reader_get_hist(mb1r_reader_t *self)
+/// @brief get frame read time histogram for mb1r_reader
+/// @param[in] self mb1r_reader reference
+/// @return mstats_hist_t reference on success, NULL otherwise
+mstats_hist_t *mb1r_reader_get_hist(mb1r_reader_t *self)
+{
+    mstats_hist_t *retval=NULL;
+    if (NULL!=self) {
+        retval=self->frame_hist;
+    }
+    return retval;
+}
+// End function mb1r_reader_get_hist
+
 /// @fn const char ***mb1r_reader_get_statlabels()
 /// @brief get statistics labels
 /// @return stats label array reference
@@ -1222,6 +1241,7 @@ int64_t mb1r_read_frame(mb1r_reader_t *self,
     pctx->read_len = 0;
 
     msock_socket_t *sockif = mb1r_reader_sockif(self);
+    double read_start = mtime_dtime();
 
     if (NULL!=self && NULL!=dest &&
         NULL!=sockif && sockif->fd>0
@@ -1266,6 +1286,7 @@ int64_t mb1r_read_frame(mb1r_reader_t *self,
                     retval = pctx->frame_bytes;
                     MX_LPRINT(MB1R, 2, "read_frame Frame valid - returning[%"PRId64"]\n", retval);
                     MST_COUNTER_ADD(self->stats->status[MB1R_STA_FRAME_VAL_BYTES],pctx->frame_bytes);
+                    MST_HIST_LAP(self->frame_hist, read_start, mtime_dtime());
 
                     //                    MST_COUNTER_INC(self->stats->events[MB1R_EV_FRAME_VALID]);
                     //                    mb1_nf_show((mb1_nf_t *)dest,false,5);
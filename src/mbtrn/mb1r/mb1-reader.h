@@ -248,6 +248,9 @@ typedef struct mb1r_reader_s
     /// @var mb1r_reader_s::stats
     /// @brief reader statistics
     mstats_t *stats;
+    /// @var mb1r_reader_s::frame_hist
+    /// @brief frame read time histogram
+    mstats_hist_t *frame_hist;
     /// @var mb1r_reader_s::watch
     /// @brief timing stopwatch
     mtime_stopwatch_t *watch;
@@ -312,6 +315,7 @@ int mb1r_reader_connect(mb1r_reader_t *self, bool replace_socket);
 void mb1r_reader_set_log(mb1r_reader_t *self, mlog_id_t id);
 void mb1r_reader_set_logstream(mb1r_reader_t *self, FILE *log);
 mstats_t *mb1r_reader_get_stats(mb1r_reader_t *self);
+mstats_hist_t *mb1r_reader_get_hist(mb1r_reader_t *self);
 const char ***mb1r_reader_get_statlabels();
 
 msock_socket_t *mb1r_reader_sockif(mb1r_reader_t *self);
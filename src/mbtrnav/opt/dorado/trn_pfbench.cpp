@@ -0,0 +1,230 @@
+/****************************************************************************/
+/* Copyright (c) 2017 MBARI                                                 */
+/* MBARI Proprietary Information. All rights reserved.                      */
+/****************************************************************************/
+/* Summary  : Replay a logged TRN session and time the filter updates       */
+/* Filename : trn_pfbench.cpp                                               */
+/* Project  : Iceberg AUV                                                   */
+/* Version  : 1.0                                                           */
+/* Created  : 10/17/2026                                                    */
+/* Archived :                                                               */
+/****************************************************************************/
+/* Modification History:                                                    */
+/* Began with a copy of trn_replay. The log directory is replayed through a */
+/* native TerrainNav once for each particle count requested, and the        */
+/* latency of the motion and measurement updates is reported.               */
+/****************************************************************************/
+
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "Replay.h"
+#include "matrixArrayCalcs.h"
+#include "TNavConfig.h"
+#include "TerrainNav.h"
+
+#define PFBENCH_MAX_COUNTS 32
+
+// Latency summary of one kind of update, in milliseconds
+//
+struct LatencyStats
+{
+  long   n;
+  double mean, median, p95, max;
+};
+
+static LatencyStats summarize(std::vector<double> &t)
+{
+  LatencyStats s = {0, 0., 0., 0., 0.};
+  s.n = (long)t.size();
+  if (s.n == 0) return s;
+
+  std::sort(t.begin(), t.end());
+  double sum = 0.;
+  for (size_t i = 0; i < t.size(); i++) sum += t[i];
+  s.mean   = sum / s.n;
+  s.median = t[t.size() / 2];
+  s.p95    = t[std::min(t.size() - 1, (size_t)(0.95 * t.size()))];
+  s.max    = t.back();
+  return s;
+}
+
+static double msSince(std::chrono::steady_clock::time_point t0)
+{
+  return std::chrono::duration<double, std::milli>(
+           std::chrono::steady_clock::now() - t0).count();
+}
+
+// Replay the log directory once with the given filter size. The update
+// latencies are appended to motion and meas. Returns the number of
+// record sets replayed, or -1 if TRN could not be started.
+//
+static long replayOnce(const char *logdir, const char *map, long maxRecords,
+                       std::vector<double> &motion, std::vector<double> &meas)
+{
+  char native[] = "native";
+  Replay *r = new Replay(logdir, map, native, 0);
+  TerrainNav *_tercom = r->connectTRN();
+  if (NULL == _tercom)
+  {
+    delete r;
+    return -1;
+  }
+
+  poseT pt;
+  measT mt;
+  mt.numMeas    = 4;
+  mt.ranges     = (double *)malloc(TRN_MAX_BEAMS*sizeof(double));
+  mt.crossTrack = (double *)malloc(TRN_MAX_BEAMS*sizeof(double));
+  mt.alongTrack = (double *)malloc(TRN_MAX_BEAMS*sizeof(double));
+  mt.beamNums   = (int *)malloc(TRN_MAX_BEAMS*sizeof(int));
+  mt.altitudes  = (double *)malloc(TRN_MAX_BEAMS*sizeof(double));
+  mt.alphas     = (double *)malloc(TRN_MAX_BEAMS*sizeof(double));
+  mt.measStatus = (bool *)malloc(TRN_MAX_BEAMS*sizeof(bool));
+
+  long nu = 0;
+  int s;
+  while ((maxRecords <= 0 || nu < maxRecords) &&
+         (s = r->getNextRecordSet(&pt, &mt)) != 0)
+  {
+    if (s < 0) continue;
+    nu++;
+
+    // Same ordering as trn_replay
+    //
+    std::chrono::steady_clock::time_point t0;
+    if (pt.time <= mt.time)
+    {
+      t0 = std::chrono::steady_clock::now();
+      _tercom->motionUpdate(&pt);
+      motion.push_back(msSince(t0));
+      t0 = std::chrono::steady_clock::now();
+      _tercom->measUpdate(&mt, mt.dataType);
+      meas.push_back(msSince(t0));
+    }
+    else
+    {
+      t0 = std::chrono::steady_clock::now();
+      _tercom->measUpdate(&mt, mt.dataType);
+      meas.push_back(msSince(t0));
+      t0 = std::chrono::steady_clock::now();
+      _tercom->motionUpdate(&pt);
+      motion.push_back(msSince(t0));
+    }
+  }
+
+  free(mt.ranges);
+  free(mt.crossTrack);
+  free(mt.alongTrack);
+  free(mt.beamNums);
+  free(mt.altitudes);
+  free(mt.alphas);
+  free(mt.measStatus);
+  delete _tercom;
+  delete r;
+  return nu;
+}
+
+int main(int argc, char* argv[])
+{
+  char *map = 0, *logdir = 0;
+  int counts[PFBENCH_MAX_COUNTS] = {0};
+  int ncounts = 0;
+  int threads = TNavConfig::instance()->getFilterThreads();
+  long maxRecords = 0;
+  unsigned int seed = 27;
+  int c;
+
+  while ( (c = getopt(argc, argv, "l:m:n:t:k:s:")) != EOF )
+  {
+    if (c == 'l')
+    {
+      free(logdir);
+      logdir = strdup(optarg);     // Log directory
+    }
+    else if (c == 'm')
+    {
+      free(map);
+      map = strdup(optarg);        // TRN map overrides map in config file
+    }
+    else if (c == 'n')
+    {
+      // Comma separated list of particle counts
+      char *list = strdup(optarg);
+      for (char *tok = strtok(list, ","); tok && ncounts < PFBENCH_MAX_COUNTS;
+           tok = strtok(NULL, ","))
+      {
+        if (atoi(tok) > 0) counts[ncounts++] = atoi(tok);
+      }
+      free(list);
+    }
+    else if (c == 't')
+      threads = atoi(optarg);
+    else if (c == 'k')
+      maxRecords = atol(optarg);
+    else if (c == 's')
+      seed = (unsigned int)strtoul(optarg, NULL, 0);
+  }
+
+  if (!logdir)
+  {
+    fprintf(stderr," No log directory specified.\n"
+                  "Usage:\n  trn_pfbench -l dir [-m map -n n1,n2,... -t threads -k records -s seed]\n"
+                  "    -l dir      The Dorado log directory created by the mission you want to replay\n"
+                  "    -m map      Alternate map name to override the map specified in terrainAid.cfg\n"
+                  "    -n list     Particle counts to time, e.g. 1000,2500,5000,%d (default %d)\n"
+                  "    -t threads  Particle filter threads (default TRN_PF_THREADS or 1)\n"
+                  "    -k records  Stop each replay after this many record sets (default all)\n"
+                  "    -s seed     Random seed used for every replay (default 27)\n",
+                  MAX_PARTICLES, MAX_PARTICLES);
+    free(map);
+    return 1;
+  }
+
+  if (ncounts == 0) counts[ncounts++] = MAX_PARTICLES;
+
+  tl_mconfig(TL_TNAV_PARTICLE_FILTER, TL_SERR, TL_NC);
+  tl_mconfig(TL_TNAV_FILTER, TL_SERR, TL_NC);
+
+  fprintf(stdout, "\n%9s %7s %7s | %9s %9s %9s %9s | %9s %9s %9s %9s\n",
+          "particles", "threads", "updates",
+          "mot mean", "mot med", "mot p95", "mot max",
+          "meas mean", "meas med", "meas p95", "meas max");
+
+  for (int i = 0; i < ncounts; i++)
+  {
+    // The filter reads its size and thread count from TNavConfig
+    // when it is constructed
+    TNavConfig::instance()->setNumParticles(counts[i]);
+    TNavConfig::instance()->setFilterThreads(threads);
+    seed_randn(&seed);
+
+    std::vector<double> motion, meas;
+    long nu = replayOnce(logdir, map, maxRecords, motion, meas);
+    if (nu < 0)
+    {
+      fprintf(stderr," TRN initialization failed for %d particles.\n", counts[i]);
+      continue;
+    }
+
+    LatencyStats ms = summarize(motion);
+    LatencyStats ss = summarize(meas);
+    fprintf(stdout, "%9d %7d %7ld | %9.3f %9.3f %9.3f %9.3f | %9.3f %9.3f %9.3f %9.3f\n",
+            std::min(counts[i], MAX_PARTICLES), threads, nu,
+            ms.mean, ms.median, ms.p95, ms.max,
+            ss.mean, ss.median, ss.p95, ss.max);
+    fflush(stdout);
+  }
+  fprintf(stdout, "(latencies in ms)\n");
+
+  free(logdir);
+  free(map);
+  TNavConfig::instance(true);
+  return 0;
+}
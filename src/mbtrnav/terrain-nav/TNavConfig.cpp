@@ -27,6 +27,11 @@ TNavConfig::TNavConfig()
 {
 
    _ignoreGps = 0;  // Pay heed unless told not to
+   _numParticles = 0;
+   _filterThreads = 1;
+   char *threads = getenv("TRN_PF_THREADS");
+   if (threads && atoi(threads) > 0)
+      _filterThreads = atoi(threads);
 }
 
 TNavConfig::~TNavConfig()
@@ -62,6 +67,26 @@ char TNavConfig::getIgnoreGps()
   return _ignoreGps;
 }
 
+void TNavConfig::setNumParticles(int n)
+{
+  _numParticles = n > 0 ? n : 0;
+}
+
+int TNavConfig::getNumParticles()
+{
+  return _numParticles;
+}
+
+void TNavConfig::setFilterThreads(int n)
+{
+  _filterThreads = n > 1 ? n : 1;
+}
+
+int TNavConfig::getFilterThreads()
+{
+  return _filterThreads;
+}
+
 void TNavConfig::setMapFile(char *filename)
 {
    if (filename)
@@ -70,6 +70,15 @@ public:
    void setIgnoreGps(char flag);
    char getIgnoreGps();
 
+   // Particle filter sizing. A particle count of zero (the default) uses
+   // MAX_PARTICLES. The thread count defaults to 1 (serial updates) and may
+   // be overridden with the TRN_PF_THREADS environment variable.
+   //
+   void setNumParticles(int n);
+   int  getNumParticles();
+   void setFilterThreads(int n);
+   int  getFilterThreads();
+
 protected:
    char *_vehicleSpecsFile;
    char *_particlesFile;
@@ -78,6 +87,8 @@ protected:
    char *_logDir;
 
    char _ignoreGps;   // flag indicates whether to ignore gpsValid
+   int  _numParticles;  // particle filter size (0 => MAX_PARTICLES)
+   int  _filterThreads; // threads used for particle filter updates
 };
 
 #endif
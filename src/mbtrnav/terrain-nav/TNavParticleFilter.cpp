@@ -12,8 +12,17 @@
 #include "TNavConfig.h"
 #include "TNavParticleFilter.h"
 #include "TNavPFLog.h"
+#include "TerrainMapDEM.h"
 #include "mapio.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <thread>
+
 #define _STR(x) #x
 #define STR(x) _STR(x)
 
@@ -27,6 +36,314 @@
 //Alternative to cross beam comparison; only one of the two should be on at any given time
 #define USE_SUBCLOUD_COMPARISON 0
 
+//Number of particles handed to a thread at a time by the threaded updates.
+//The chunking is independent of the thread count, which keeps the threaded
+//motion update repeatable for a given seed.
+#define PF_PARTICLE_CHUNK 256
+
+//Upper limit on the particle filter thread count
+#define PF_MAX_THREADS 64
+
+
+/*!
+ * Class: PFThreadPool
+ *
+ * A small pool of persistent worker threads used by the particle filter
+ * updates. run() hands out chunk indices from a shared counter to the
+ * workers and to the calling thread, and returns when every chunk is done.
+ * An exception thrown by a chunk is passed back to the caller of run().
+ */
+class PFThreadPool
+{
+ public:
+	explicit PFThreadPool(int nThreads);
+	~PFThreadPool();
+
+	void run(int nChunks, const std::function<void(int)>& work);
+
+ private:
+	void worker();
+	void drain();
+
+	std::vector<std::thread> threads;
+	std::mutex mtx;
+	std::condition_variable startCv;
+	std::condition_variable doneCv;
+	const std::function<void(int)>* job;
+	std::atomic<int> nextChunk;
+	int nChunks;
+	int busy;
+	unsigned long generation;
+	bool quit;
+	std::exception_ptr error;
+};
+
+PFThreadPool::
+PFThreadPool(int nThreads) :
+job(NULL), nextChunk(0), nChunks(0), busy(0), generation(0), quit(false)
+{
+	// the calling thread works too, so start one fewer
+	for(int i = 1; i < nThreads; i++) {
+		threads.push_back(std::thread(&PFThreadPool::worker, this));
+	}
+}
+
+PFThreadPool::
+~PFThreadPool() {
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		quit = true;
+	}
+	startCv.notify_all();
+	for(size_t i = 0; i < threads.size(); i++) {
+		threads[i].join();
+	}
+}
+
+void
+PFThreadPool::
+run(int n, const std::function<void(int)>& work) {
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		job = &work;
+		nChunks = n;
+		nextChunk = 0;
+		busy = (int)threads.size();
+		error = std::exception_ptr();
+		generation++;
+	}
+	startCv.notify_all();
+
+	drain();
+
+	std::exception_ptr err;
+	{
+		std::unique_lock<std::mutex> lock(mtx);
+		doneCv.wait(lock, [this] { return busy == 0; });
+		job = NULL;
+		err = error;
+	}
+	if(err) {
+		std::rethrow_exception(err);
+	}
+}
+
+void
+PFThreadPool::
+worker() {
+	unsigned long seen = 0;
+	for(;;) {
+		{
+			std::unique_lock<std::mutex> lock(mtx);
+			startCv.wait(lock, [&] { return quit || generation != seen; });
+			if(quit) {
+				return;
+			}
+			seen = generation;
+		}
+
+		drain();
+
+		std::lock_guard<std::mutex> lock(mtx);
+		if(--busy == 0) {
+			doneCv.notify_one();
+		}
+	}
+}
+
+void
+PFThreadPool::
+drain() {
+	for(;;) {
+		int chunk = nextChunk++;
+		if(chunk >= nChunks) {
+			return;
+		}
+		try {
+			(*job)(chunk);
+		} catch(...) {
+			std::lock_guard<std::mutex> lock(mtx);
+			if(!error) {
+				error = std::current_exception();
+			}
+		}
+	}
+}
+
+//********************************************************************************
+
+//particleT is the interchange type for a particle of a particleSetT
+static_assert(NIS_WINDOW_LENGTH <= 20, "particleT::windowedNis is too short");
+
+particleSetT::
+particleSetT() :
+size(0), weight(NULL), compassBias(NULL), psiBerg(NULL), dvlScaleFactor(NULL),
+windowedNis(NULL), windowIndex(NULL), storage(NULL), nColumns(0)
+{
+	for(int j = 0; j < 3; j++) {
+		position[j] = NULL;
+		attitude[j] = NULL;
+		terrainState[j] = NULL;
+		alignState[j] = NULL;
+		gyroBias[j] = NULL;
+		dvlBias[j] = NULL;
+	}
+}
+
+particleSetT::
+~particleSetT() {
+	release();
+}
+
+void
+particleSetT::
+release() {
+	delete [] storage;
+	delete [] windowIndex;
+	storage = NULL;
+	windowIndex = NULL;
+	nColumns = 0;
+	size = 0;
+}
+
+void
+particleSetT::
+allocate(int n) {
+	int j;
+
+	release();
+
+	//weight, position and attitude, then the optional states
+	int nStates = 7;
+	if(MOVING_TERRAIN) {
+		nStates += 3;
+	}
+	if(SEARCH_ALIGN_STATE) {
+		nStates += 3;
+	}
+	if(SEARCH_GYRO_BIAS) {
+		nStates += 3;
+	}
+	if(SEARCH_COMPASS_BIAS) {
+		nStates += 1;
+	}
+	if(SEARCH_PSI_BERG) {
+		nStates += 1;
+	}
+	if(SEARCH_DVL_ERRORS) {
+		nStates += 4;
+	}
+
+	size = n;
+	storage = new double[(nStates + NIS_WINDOW_LENGTH) * n]();
+	windowIndex = new unsigned int[n]();
+
+	double* next = storage;
+	auto column = [&]() {
+		double* c = next;
+		next += n;
+		columns[nColumns++] = c;
+		return c;
+	};
+
+	weight = column();
+	for(j = 0; j < 3; j++) {
+		position[j] = column();
+	}
+	for(j = 0; j < 3; j++) {
+		attitude[j] = column();
+	}
+	for(j = 0; j < 3; j++) {
+		terrainState[j] = MOVING_TERRAIN ? column() : NULL;
+		alignState[j] = SEARCH_ALIGN_STATE ? column() : NULL;
+		gyroBias[j] = SEARCH_GYRO_BIAS ? column() : NULL;
+		dvlBias[j] = SEARCH_DVL_ERRORS ? column() : NULL;
+	}
+	compassBias = SEARCH_COMPASS_BIAS ? column() : NULL;
+	psiBerg = SEARCH_PSI_BERG ? column() : NULL;
+	dvlScaleFactor = SEARCH_DVL_ERRORS ? column() : NULL;
+
+	//the NIS window is kept per particle, not per state
+	windowedNis = next;
+}
+
+void
+particleSetT::
+getParticle(int i, particleT& particle) const {
+	particle.weight = weight[i];
+	for(int j = 0; j < 3; j++) {
+		particle.position[j] = position[j][i];
+		particle.attitude[j] = attitude[j][i];
+		particle.terrainState[j] = terrainState[j] ? terrainState[j][i] : 0.0;
+		particle.alignState[j] = alignState[j] ? alignState[j][i] : 0.0;
+		particle.gyroBias[j] = gyroBias[j] ? gyroBias[j][i] : 0.0;
+		particle.dvlBias[j] = dvlBias[j] ? dvlBias[j][i] : 0.0;
+	}
+	particle.compassBias = compassBias ? compassBias[i] : 0.0;
+	particle.psiBerg = psiBerg ? psiBerg[i] : 0.0;
+	particle.dvlScaleFactor = dvlScaleFactor ? dvlScaleFactor[i] : 0.0;
+	for(int w = 0; w < NIS_WINDOW_LENGTH; w++) {
+		particle.windowedNis[w] = windowedNis[i * NIS_WINDOW_LENGTH + w];
+	}
+	particle.windowIndex = windowIndex[i];
+}
+
+void
+particleSetT::
+setParticle(int i, const particleT& particle) {
+	weight[i] = particle.weight;
+	for(int j = 0; j < 3; j++) {
+		position[j][i] = particle.position[j];
+		attitude[j][i] = particle.attitude[j];
+		if(terrainState[j]) {
+			terrainState[j][i] = particle.terrainState[j];
+		}
+		if(alignState[j]) {
+			alignState[j][i] = particle.alignState[j];
+		}
+		if(gyroBias[j]) {
+			gyroBias[j][i] = particle.gyroBias[j];
+		}
+		if(dvlBias[j]) {
+			dvlBias[j][i] = particle.dvlBias[j];
+		}
+	}
+	if(compassBias) {
+		compassBias[i] = particle.compassBias;
+	}
+	if(psiBerg) {
+		psiBerg[i] = particle.psiBerg;
+	}
+	if(dvlScaleFactor) {
+		dvlScaleFactor[i] = particle.dvlScaleFactor;
+	}
+	for(int w = 0; w < NIS_WINDOW_LENGTH; w++) {
+		windowedNis[i * NIS_WINDOW_LENGTH + w] = particle.windowedNis[w];
+	}
+	windowIndex[i] = particle.windowIndex;
+}
+
+void
+particleSetT::
+gather(const particleSetT& src, const int* index, int n) {
+	int m;
+
+	//both sets are allocated the same way, so their columns correspond
+	for(int c = 0; c < nColumns; c++) {
+		double* dst = columns[c];
+		const double* from = src.columns[c];
+		for(m = 0; m < n; m++) {
+			dst[m] = from[index[m]];
+		}
+	}
+	for(m = 0; m < n; m++) {
+		memcpy(&windowedNis[m * NIS_WINDOW_LENGTH],
+			   &src.windowedNis[index[m] * NIS_WINDOW_LENGTH],
+			   NIS_WINDOW_LENGTH * sizeof(double));
+		windowIndex[m] = src.windowIndex[index[m]];
+	}
+}
+
 
 //TNavParticleFilter:: //Reload Map Issue
 //TNavParticleFilter(char* mapName, char* vehicleSpecs, char* directory, const double* windowVar,
@@ -34,6 +351,7 @@
 TNavParticleFilter::
 TNavParticleFilter(TerrainMap* terrainMap, char* vehicleSpecs, char* directory, const double* windowVar, const int& mapType) :
 TNavFilter(terrainMap, vehicleSpecs, directory, windowVar, mapType),
+measDiffStride(0), nThreads(1), threadPool(NULL), rngSeed(0), nMotionUpdates(0),
 navData_x_(0.), navData_y_(0.)
 {
     int i=0;
@@ -44,6 +362,17 @@ navData_x_(0.), navData_y_(0.)
 	this->tempUseBeam = new bool[TRN_MAX_BEAMS];
 	this->useBeam     = new bool[TRN_MAX_BEAMS];
 	this->pfLog = new TNavPFLog(DataLog::BinaryFormat);
+
+	//Start the update threads if more than one was asked for
+	this->nThreads = TNavConfig::instance()->getFilterThreads();
+	if(this->nThreads > PF_MAX_THREADS) {
+		this->nThreads = PF_MAX_THREADS;
+	}
+	if(this->nThreads > 1) {
+		logs(TL_OMASK(TL_TNAV_PARTICLE_FILTER, TL_LOG),
+			"TNavPF::Using %d threads for particle updates\n", this->nThreads);
+		this->threadPool = new PFThreadPool(this->nThreads);
+	}
 }
 
 
@@ -61,6 +390,7 @@ TNavParticleFilter::
 	delete [] tempUseBeam;
 	delete [] useBeam;
   delete pfLog;
+  delete threadPool;
 }
 
 //********************************************************************************
@@ -210,75 +540,77 @@ measUpdate(measT& currMeas) {
 			{
 				this->useBeam[i]=true;
 			}
-			for(i = 0; i < nParticles; i++) {
-				if(!ALLOW_ATTITUDE_SEARCH && SEARCH_PSI_BERG)
-				{
-					//
-					// tempBeamsVF stores beamsVF so that each particle does its own rotation.
-					tempAttitude[0] = attitude[0];
-					tempAttitude[1] = attitude[1];
-					tempAttitude[2] = attitude[2] - allParticles[i].psiBerg;
-
-					beamsVF = applyRotation(tempAttitude, tempBeamsVF);
+			measDiffStride = beamsVF.Ncols();
+			measDiff.resize(nParticles * measDiffStride);
+			TerrainMapDEM* batchMap = batchMeasMap();
+			if(batchMap != NULL) {
+				measMapVar.resize(measDiff.size());
+			}
+			int badParticle = -1;
+			if(threadPool != NULL && nParticles > PF_PARTICLE_CHUNK) {
+				badParticle = expectedMeasDiffParallel(beamsVF, tempBeamsVF, attitude, currMeas, beamIndices, mapVar);
+			} else {
+				if(batchMap != NULL) {
+					expectedMeasDiffBatch(batchMap, 0, nParticles, beamsVF, currMeas.ranges, beamIndices);
 				}
-				//Edit to allow using only one beam from a measurement
-				// sets this->tempUseBeam
+				for(i = 0; i < nParticles; i++) {
+					if(!ALLOW_ATTITUDE_SEARCH && SEARCH_PSI_BERG)
+					{
+						//
+						// tempBeamsVF stores beamsVF so that each particle does its own rotation.
+						tempAttitude[0] = attitude[0];
+						tempAttitude[1] = attitude[1];
+						tempAttitude[2] = attitude[2] - allParticles->psiBerg[i];
+
+						beamsVF = applyRotation(tempAttitude, tempBeamsVF);
+					}
+					//Edit to allow using only one beam from a measurement
+					// sets this->tempUseBeam
 
 
-				getExpectedMeasDiffParticle(allParticles[i], beamsVF, currMeas.ranges, beamIndices, mapVar);
+					if(batchMap != NULL) {
+						getBatchedMeasDiffParticle(i, mapVar, this->tempUseBeam);
+					} else {
+						getExpectedMeasDiffParticle(i, beamsVF, currMeas.ranges, beamIndices, mapVar, this->tempUseBeam);
+					}
 
-				for( int indx=0; indx < beamsVF.Ncols(); indx++ )
-				{
-					this->useBeam[indx] = this->useBeam[indx] && this->tempUseBeam[indx];
-				}
+					for( int indx=0; indx < beamsVF.Ncols(); indx++ )
+					{
+						this->useBeam[indx] = this->useBeam[indx] && this->tempUseBeam[indx];
+					}
 
-				//
-				// Check for this particular particle:
-				nBeamsUsed = 0;
-				for(int j = 0; j < beamsVF.Ncols(); j++) {
-					if(this->tempUseBeam[j]){
-						nBeamsUsed++;
+					//
+					// Check for this particular particle:
+					nBeamsUsed = 0;
+					for(int j = 0; j < beamsVF.Ncols(); j++) {
+						if(this->tempUseBeam[j]){
+							nBeamsUsed++;
+						}
 					}
-				}
 
-				pfLog->setUsedBeams(nBeamsUsed);
+					pfLog->setUsedBeams(nBeamsUsed);
 
-				bool atLeastOneBeamGood = nBeamsUsed > 0;
+					bool atLeastOneBeamGood = nBeamsUsed > 0;
 
-				//if(!getExpectedMeasDiffParticle(allParticles[i], beamsVF, currMeas.ranges, beamIndices, mapVar)) {
-				//if any of the measurement projections fail due to falling in NaN region of map!
+					//if(!getExpectedMeasDiffParticle(i, beamsVF, currMeas.ranges, beamIndices, mapVar)) {
+					//if any of the measurement projections fail due to falling in NaN region of map!
 
 
-				//if(!atLeastOneBeamGood && !USE_SUBCLOUD_COMPARISON){
-				if(!atLeastOneBeamGood && (TRN_WT_SUBCL != this->useModifiedWeighting  && TRN_FORCE_SUBCL != this->useModifiedWeighting)){
-					//none of the beams was good for this particular particle.
-					logs(TL_OMASK(TL_TNAV_PARTICLE_FILTER, TL_LOG),
-						"TNavPF::Measurement from time = %.2f sec. not included.",currMeas.time);
-					//"encountered NaN values in the correlation map segment for all beams on one particle.\n",
-					logs(TL_OMASK(TL_TNAV_PARTICLE_FILTER, TL_LOG),
-						"Particle[%d] has NaN for all beam ranges, with roll = %.1f, "
-						"pitch = %.1f, yaw = %.1f degrees.\n",
-						i, allParticles[i].attitude[0]*180./PI,
-						allParticles[i].attitude[1]*180./PI,
-						allParticles[i].attitude[2]*180./PI);
-					logs(TL_OMASK(TL_TNAV_PARTICLE_FILTER, TL_LOG),
-						"x = %.1f, y = %.1f z = %.1f.\n",
-						allParticles[i].position[0],
-						allParticles[i].position[1],
-						allParticles[i].position[2]);
-					logs(TL_OMASK(TL_TNAV_PARTICLE_FILTER, TL_LOG),
-						"[ %.1f  %.1f  %.1f  %.3f  %.3f  %.3f];\n",
-						allParticles[i].position[0],
-						allParticles[i].position[1],
-						allParticles[i].position[2],
-						allParticles[i].attitude[0],
-						allParticles[i].attitude[1],
-						allParticles[i].attitude[2]);
-					return false;
+					//if(!atLeastOneBeamGood && !USE_SUBCLOUD_COMPARISON){
+					if(!atLeastOneBeamGood && (TRN_WT_SUBCL != this->useModifiedWeighting  && TRN_FORCE_SUBCL != this->useModifiedWeighting)){
+						//none of the beams was good for this particular particle.
+						badParticle = i;
+						break;
+					}
+					// release resources allocated in call to
+					// getExpectedMeasDiffParticle(), above
+					//if( (i+1) != nParticles) delete [] useBeam;
 				}
-				// release resources allocated in call to
-				// getExpectedMeasDiffParticle(), above
-				//if( (i+1) != nParticles) delete [] useBeam;
+			}
+
+			if(badParticle >= 0) {
+				logBadParticle(badParticle, currMeas.time);
+				return false;
 			}
 
 			bool temp = false;
@@ -313,7 +645,7 @@ measUpdate(measT& currMeas) {
 				double tempWindowedNis[nParticles];
 				int numBeamsForEachParticle[nParticles];
 				for(int indexP = 0; indexP < nParticles; indexP++) {
-					tempWeights[indexP] = allParticles[indexP].weight;
+					tempWeights[indexP] = allParticles->weight[indexP];
 					tempWindowedNis[indexP] = 0.0;
 					numBeamsForEachParticle[indexP] = 0;
 				}
@@ -337,9 +669,9 @@ measUpdate(measT& currMeas) {
 					double sumWeightsInSubcloud = 0.0;
 
 					for(int indexP = 0; indexP < nParticles; indexP++){
-						if(!ISNIN(allParticles[indexP].expectedMeasDiff[indexM])){
+						if(!ISNIN(particleMeasDiff(indexP)[indexM])){
 							particleIndicies[numParticlesWithBeamM] = indexP;
-							tempSubcloudWeights[numParticlesWithBeamM] = allParticles[indexP].weight;
+							tempSubcloudWeights[numParticlesWithBeamM] = allParticles->weight[indexP];
 							sumWeightsInSubcloud += tempSubcloudWeights[numParticlesWithBeamM];
 							numParticlesWithBeamM++;
 							numBeamsForEachParticle[indexP]++;
@@ -370,21 +702,21 @@ measUpdate(measT& currMeas) {
 
 					for(int indexS = 0; indexS < numParticlesWithBeamM; indexS++){
 						//weight update
-						weightUpdatesForSubcloud[indexS] = exp(-0.5 * pow(allParticles[particleIndicies[indexS]].expectedMeasDiff[indexM],2) / totalVariance);
+						weightUpdatesForSubcloud[indexS] = exp(-0.5 * pow(particleMeasDiff(particleIndicies[indexS])[indexM],2) / totalVariance);
 
 						//normalize subcloud weights
 						tempSubcloudWeights[indexS] = tempSubcloudWeights[indexS]/sumWeightsInSubcloud;
 
 						//delta_rms_squared calculations
-						meanExpectedMeasurementDifference += allParticles[particleIndicies[indexS]].expectedMeasDiff[indexM] * tempSubcloudWeights[indexS];
-						partialDeltaRmsComputation += allParticles[particleIndicies[indexS]].expectedMeasDiff[indexM] * allParticles[particleIndicies[indexS]].expectedMeasDiff[indexM] * tempSubcloudWeights[indexS];
+						meanExpectedMeasurementDifference += particleMeasDiff(particleIndicies[indexS])[indexM] * tempSubcloudWeights[indexS];
+						partialDeltaRmsComputation += particleMeasDiff(particleIndicies[indexS])[indexM] * particleMeasDiff(particleIndicies[indexS])[indexM] * tempSubcloudWeights[indexS];
 						partialOneMinusSumSquareWeights -= tempSubcloudWeights[indexS] * tempSubcloudWeights[indexS];
 
 						//for particle NIS calculations; part of Subcloud NIS
-						subcloudInnovationVariance += pow(allParticles[particleIndicies[indexS]].expectedMeasDiff[indexM], 2) * allParticles[particleIndicies[indexS]].weight -
-							pow(allParticles[particleIndicies[indexS]].expectedMeasDiff[indexM] * allParticles[particleIndicies[indexS]].weight, 2);
+						subcloudInnovationVariance += pow(particleMeasDiff(particleIndicies[indexS])[indexM], 2) * allParticles->weight[particleIndicies[indexS]] -
+							pow(particleMeasDiff(particleIndicies[indexS])[indexM] * allParticles->weight[particleIndicies[indexS]], 2);
 
-						tempWindowedNis[particleIndicies[indexS]] += pow(allParticles[particleIndicies[indexS]].expectedMeasDiff[indexM],2) / (totalVariance + subcloudInnovationVariance);
+						tempWindowedNis[particleIndicies[indexS]] += pow(particleMeasDiff(particleIndicies[indexS])[indexM],2) / (totalVariance + subcloudInnovationVariance);
 					}
 
 					double alpha;
@@ -411,8 +743,8 @@ measUpdate(measT& currMeas) {
 					double etaNumerator = 0;
 					double etaDenominator = 0;
 					for(int indexS = 0; indexS < numParticlesWithBeamM; indexS++){
-						etaDenominator += allParticles[particleIndicies[indexS]].weight * weightUpdatesForSubcloud[indexS];
-						etaNumerator += allParticles[particleIndicies[indexS]].weight;
+						etaDenominator += allParticles->weight[particleIndicies[indexS]] * weightUpdatesForSubcloud[indexS];
+						etaNumerator += allParticles->weight[particleIndicies[indexS]];
 					}
 
 					//apply weight updates to tempWeights in subcloud
@@ -431,16 +763,17 @@ measUpdate(measT& currMeas) {
 				this->SubcloudNIS = 0;
 				for(int indexP = 0; indexP < nParticles; indexP++){
 					if(numBeamsForEachParticle[indexP] > 0){
-						allParticles[indexP].windowedNis[allParticles[indexP].windowIndex] = tempWindowedNis[indexP] / numBeamsForEachParticle[indexP];
-						allParticles[indexP].windowIndex = (allParticles[indexP].windowIndex + 1) % 20;
+						double* windowedNis = &allParticles->windowedNis[indexP * NIS_WINDOW_LENGTH];
+						windowedNis[allParticles->windowIndex[indexP]] = tempWindowedNis[indexP] / numBeamsForEachParticle[indexP];
+						allParticles->windowIndex[indexP] = (allParticles->windowIndex[indexP] + 1) % NIS_WINDOW_LENGTH;
 					}
 
 					double particleNisValue = 0;
-					for(int indexW = 0; indexW < 20; indexW ++){
-						particleNisValue += allParticles[indexP].windowedNis[indexW];
+					for(int indexW = 0; indexW < NIS_WINDOW_LENGTH; indexW ++){
+						particleNisValue += allParticles->windowedNis[indexP * NIS_WINDOW_LENGTH + indexW];
 					}
 
-					this->SubcloudNIS += allParticles[indexP].weight * particleNisValue/20.0;
+					this->SubcloudNIS += allParticles->weight[indexP] * particleNisValue/NIS_WINDOW_LENGTH;
 
 				}
 				logs(TL_OMASK(TL_TNAV_PARTICLE_FILTER, TL_LOG),
@@ -469,7 +802,7 @@ measUpdate(measT& currMeas) {
 					return false;
 				} else{
 					for(int indexP = 0; indexP < nParticles; indexP++) {
-						allParticles[indexP].weight = tempWeights[indexP];
+						allParticles->weight[indexP] = tempWeights[indexP];
 					}
 				}
 
@@ -515,8 +848,8 @@ measUpdate(measT& currMeas) {
 					for(int indexM=0; indexM < beamsVF.Ncols(); indexM++){
 
 						// No nan beams, and no beams which can be used normally
-						// if(!(isnan(allParticles[indexP].expectedMeasDiff[indexM]) || useBeam[indexM])){
-						if(!(ISNIN(allParticles[indexP].expectedMeasDiff[indexM]) || useBeam[indexM])){
+						// if(!(isnan(particleMeasDiff(indexP)[indexM]) || useBeam[indexM])){
+						if(!(ISNIN(particleMeasDiff(indexP)[indexM]) || useBeam[indexM])){
 							goodBeamIndicies[indexP * MAX_CROSS_BEAM_COMPARISONS + numGoodBeamsParticle[indexP]] = indexM;
 
 							numGoodBeamsParticle[indexP] += 1;
@@ -533,7 +866,7 @@ measUpdate(measT& currMeas) {
 				//tempWeights allows reverting (ignoring this measirement) if it results in Nan values somehow
 				double tempWeights[nParticles];
 				for(int indexP = 0; indexP < nParticles; indexP++) {
-					tempWeights[indexP] = allParticles[indexP].weight;
+					tempWeights[indexP] = allParticles->weight[indexP];
 				}
 
 				//compute the weight updates
@@ -557,13 +890,13 @@ measUpdate(measT& currMeas) {
 							maxSensorVar = currMeas.covariance[beamIndices[goodBeamIndicies[indexP * MAX_CROSS_BEAM_COMPARISONS + beamNumber]]];
 						}
 
-						tempWeightUpdate[indexP] = exp(-0.5 * pow(allParticles[indexP].expectedMeasDiff[goodBeamIndicies[indexP * MAX_CROSS_BEAM_COMPARISONS + beamNumber]],2) / totalVariance);
+						tempWeightUpdate[indexP] = exp(-0.5 * pow(particleMeasDiff(indexP)[goodBeamIndicies[indexP * MAX_CROSS_BEAM_COMPARISONS + beamNumber]],2) / totalVariance);
 						double beamEndpointTerrainDepth = 0;
-						beamEndpointTerrainDepth = allParticles[indexP].position[2] + beamsVF(3, goodBeamIndicies[indexP * MAX_CROSS_BEAM_COMPARISONS + beamNumber] + 1);
+						beamEndpointTerrainDepth = allParticles->position[2][indexP] + beamsVF(3, goodBeamIndicies[indexP * MAX_CROSS_BEAM_COMPARISONS + beamNumber] + 1);
 
-						partialDeltaRmsComputation += beamEndpointTerrainDepth * beamEndpointTerrainDepth * allParticles[indexP].weight;
-						partialMeanTerrainDepth += beamEndpointTerrainDepth * allParticles[indexP].weight;
-						partialOneMinusSumSquareWeights -= allParticles[indexP].weight * allParticles[indexP].weight;
+						partialDeltaRmsComputation += beamEndpointTerrainDepth * beamEndpointTerrainDepth * allParticles->weight[indexP];
+						partialMeanTerrainDepth += beamEndpointTerrainDepth * allParticles->weight[indexP];
+						partialOneMinusSumSquareWeights -= allParticles->weight[indexP] * allParticles->weight[indexP];
 
 					}
 
@@ -602,7 +935,7 @@ measUpdate(measT& currMeas) {
 				}
 				else{
 					for(int indexP = 0; indexP < nParticles; indexP++) {
-						allParticles[indexP].weight = tempWeights[indexP];
+						allParticles->weight[indexP] = tempWeights[indexP];
 					}
 				}
 			}
@@ -653,8 +986,8 @@ measUpdate(measT& currMeas) {
 					if(this->useBeam[beamInd]){	//edit to allow using any good beams from measurement
 						for(i = 0; i < nParticles; i++) {
 							//As we already have the expected measurement difference, compute mean and square of measurement difference
-							mapSquared[beamInd] += pow(allParticles[i].expectedMeasDiff[beamInd], 2) * allParticles[i].weight;
-							mapMean[beamInd] += allParticles[i].expectedMeasDiff[beamInd] * allParticles[i].weight;
+							mapSquared[beamInd] += pow(particleMeasDiff(i)[beamInd], 2) * allParticles->weight[i];
+							mapMean[beamInd] += particleMeasDiff(i)[beamInd] * allParticles->weight[i];
 						}
 					}
 				}
@@ -721,6 +1054,7 @@ measUpdate(measT& currMeas) {
 //		for (int beamInd = 0; beamInd < beamsVF.Ncols(); beamInd++) sumInvVar += (1.0/(totalVar[beamInd]));
 
 			for(i = 0; i < nParticles; i++) {
+				double* diff = particleMeasDiff(i);
 				sumSquaredError = 0.;
 				sumWeightedError = 0.;
 				sumInvVar = 0.;
@@ -731,8 +1065,8 @@ measUpdate(measT& currMeas) {
 					if(this->useBeam[beamInd]){	//edit to allow using any good beams from measurement
 
 						//As we already have the expected measurement difference, just apply the measurement model to it
-						sumWeightedError += (1.0 / (totalVar[beamInd])) * allParticles[i].expectedMeasDiff[beamInd]; //Weighted mean error
-						sumSquaredError += (1.0 / (totalVar[beamInd])) * pow(allParticles[i].expectedMeasDiff[beamInd], 2); //Weighted Squared Error
+						sumWeightedError += (1.0 / (totalVar[beamInd])) * diff[beamInd]; //Weighted mean error
+						sumSquaredError += (1.0 / (totalVar[beamInd])) * pow(diff[beamInd], 2); //Weighted Squared Error
 						sumInvVar += (1.0 / (totalVar[beamInd]));		//Beam Variance
 						//					logs(TL_OMASK(TL_TNAV_PARTICLE_FILTER, TL_LOG),"TNavPF:totalVar[%i] is %f\n",beamInd,totalVar[beamInd]);
 						if(ISNIN(sumSquaredError))
@@ -743,7 +1077,7 @@ measUpdate(measT& currMeas) {
 
 							return false;
 							//		     logs(TL_OMASK(TL_TNAV_PARTICLE_FILTER, TL_LOG),"TNavPF:totalVar[%i] is %f\n",beamInd,totalVar[beamInd]);
-							//		     logs(TL_OMASK(TL_TNAV_PARTICLE_FILTER, TL_LOG),"TNavPF:expectedMeasDiff[%i] is %f \n",beamInd,allParticles[i].expectedMeasDiff[beamInd]);
+							//		     logs(TL_OMASK(TL_TNAV_PARTICLE_FILTER, TL_LOG),"TNavPF:expectedMeasDiff[%i] is %f \n",beamInd,diff[beamInd]);
 						}
 					}
 				}
@@ -751,10 +1085,10 @@ measUpdate(measT& currMeas) {
 				//Compute new measurement weight
 				if(USE_CONTOUR_MATCHING && !USE_RANGE_CORR) {
 					currDepthBias = (1.0 / sumInvVar) * sumWeightedError;
-					allParticles[i].position[2] -= currDepthBias;
+					allParticles->position[2][i] -= currDepthBias;
 					for(int beamInd = 0; beamInd < beamsVF.Ncols(); beamInd++) {
 						if(this->useBeam[beamInd]){	//edit to allow using any good beams from measurement
-							allParticles[i].expectedMeasDiff[beamInd] -= currDepthBias;
+							diff[beamInd] -= currDepthBias;
 						}
 					}
 
@@ -766,7 +1100,7 @@ measUpdate(measT& currMeas) {
 					currMeasWeights[i] = exp(-0.5 * sumSquaredError);
 				}
 
-				sumWeights += allParticles[i].weight * currMeasWeights[i];
+				sumWeights += allParticles->weight[i] * currMeasWeights[i];
 				sumMeasWeights += currMeasWeights[i];
 			}
 
@@ -780,7 +1114,7 @@ measUpdate(measT& currMeas) {
 
 			SymmetricMatrix mapMeasVarMat(beamsVF.Ncols());  			//Variance in expected map measurements
 			ColumnVector measDiffMean(beamsVF.Ncols());						//Mean difference between actual and expected measurements
-			computeInnovationsMatrices(allParticles, mapMeasVarMat, measDiffMean);  //Compute variance matrix for expected measurements
+			computeInnovationsMatrices(mapMeasVarMat, measDiffMean);  //Compute variance matrix for expected measurements
 
 //		logs(TL_OMASK(TL_TNAV_PARTICLE_FILTER, TL_LOG),"TNavPF::Current number of measurements is: %i \n",currMeas.numMeas);
 //		logs(TL_OMASK(TL_TNAV_PARTICLE_FILTER, TL_LOG),"TNavPF::Size of measurement matrix is: %i \n",beamsVF.Ncols());
@@ -818,13 +1152,18 @@ measUpdate(measT& currMeas) {
 				logs(TL_OMASK(TL_TNAV_PARTICLE_FILTER, TL_LOG),"\nParticle Weights not updated because current NIS >= %f\n",NIS_WINDOW_LENGTH*1.4);
 			}
 			else{
+				//Normalize the weight array on its own, so the loop streams
+				//through the two arrays
+				double* weight = allParticles->weight;
 				for(i = 0; i < nParticles; i++) {
-					allParticles[i].weight *= currMeasWeights[i] / sumWeights;
+					weight[i] *= currMeasWeights[i] / sumWeights;
 					//TODO if inovations are too large, particle weights go nan.
 					//currMeasWeight was not nan for the particular failure I examined.
 					//sumWeights == 0.0
 
-					sumSquaresWeights += pow(allParticles[i].weight, 2);
+					sumSquaresWeights += weight[i] * weight[i];
+				}
+				for(i = 0; i < nParticles; i++) {
 					//compute variance of measurement weights
 					currMeasWeights[i] /= sumMeasWeights;
 					measVariance += pow(currMeasWeights[i] - 1.0 / nParticles, 2) / nParticles;
@@ -863,7 +1202,7 @@ measUpdate(measT& currMeas) {
 			  "title('Sub-Map and Particle Distribution: Prior to Resampling');",
 			  "figure(2)");
 
-	    plotParticleDistMatlab(allParticles, "figure(2)");
+	    plotParticleDistMatlab(*allParticles, "figure(2)");
 #endif
 
 				//resample particle distribution
@@ -883,7 +1222,7 @@ measUpdate(measT& currMeas) {
    plotMapMatlab(mapForPloting.depths, mapForPloting.xpts,
 		 mapForPloting.ypts, "title('Sub-Map and Post-Resampling Particle Distribution');", "figure(1)");
    mapPlotted = 1;
-   plotParticleDistMatlab(allParticles, "figure(1)");
+   plotParticleDistMatlab(*allParticles, "figure(1)");
 #endif
 
    //if measurement successfully added, recheck estimator convergence
@@ -898,10 +1237,137 @@ measUpdate(measT& currMeas) {
 
 //********************************************************************************
 
+int
+TNavParticleFilter::
+expectedMeasDiffParallel(Matrix& beamsVF, const Matrix& tempBeamsVF, const double* attitude, measT& currMeas, const int* beamIndices, double& mapVar) {
+	struct measChunkT {
+		std::vector<char> useBeam;  // beams usable by every particle in the chunk
+		double mapVar;              // last map variance set in the chunk
+		int nBeamsUsed;             // beams used by the last particle processed
+		int badParticle;            // first particle with no usable beams, or -1
+	};
+
+	const int nBeams = beamsVF.Ncols();
+	const int nChunks = (nParticles + PF_PARTICLE_CHUNK - 1) / PF_PARTICLE_CHUNK;
+	const bool subcloud = (TRN_WT_SUBCL == this->useModifiedWeighting ||
+						   TRN_FORCE_SUBCL == this->useModifiedWeighting);
+	const bool rotateEach = !ALLOW_ATTITUDE_SEARCH && SEARCH_PSI_BERG;
+	TerrainMapDEM* batchMap = batchMeasMap();
+	std::vector<measChunkT> chunks(nChunks);
+
+	threadPool->run(nChunks, [&](int c) {
+		measChunkT& chunk = chunks[c];
+		bool chunkUseBeam[TRN_MAX_BEAMS];
+		Matrix particleBeams;
+		double tempAttitude[3];
+
+		chunk.useBeam.assign(nBeams, 1);
+		chunk.mapVar = std::numeric_limits<double>::quiet_NaN();
+		chunk.nBeamsUsed = 0;
+		chunk.badParticle = -1;
+
+		int end = (c + 1) * PF_PARTICLE_CHUNK;
+		if(end > nParticles) {
+			end = nParticles;
+		}
+		if(batchMap != NULL) {
+			expectedMeasDiffBatch(batchMap, c * PF_PARTICLE_CHUNK, end, beamsVF, currMeas.ranges, beamIndices);
+		}
+		for(int ip = c * PF_PARTICLE_CHUNK; ip < end; ip++) {
+			//With psi berg search each particle does its own rotation
+			if(rotateEach) {
+				tempAttitude[0] = attitude[0];
+				tempAttitude[1] = attitude[1];
+				tempAttitude[2] = attitude[2] - allParticles->psiBerg[ip];
+				particleBeams = applyRotation(tempAttitude, tempBeamsVF);
+			}
+
+			if(batchMap != NULL) {
+				getBatchedMeasDiffParticle(ip, chunk.mapVar, chunkUseBeam);
+			} else {
+				getExpectedMeasDiffParticle(ip, rotateEach ? particleBeams : beamsVF,
+											currMeas.ranges, beamIndices, chunk.mapVar, chunkUseBeam);
+			}
+
+			int nUsed = 0;
+			for(int j = 0; j < nBeams; j++) {
+				chunk.useBeam[j] = chunk.useBeam[j] && chunkUseBeam[j];
+				if(chunkUseBeam[j]) {
+					nUsed++;
+				}
+			}
+			chunk.nBeamsUsed = nUsed;
+
+			if(nUsed == 0 && !subcloud) {
+				chunk.badParticle = ip;
+				break;
+			}
+		}
+	});
+
+	//Merge the chunks in particle order, stopping where the serial loop would
+	int badParticle = -1;
+	int nBeamsUsed = 0;
+	for(int c = 0; c < nChunks; c++) {
+		for(int j = 0; j < nBeams; j++) {
+			this->useBeam[j] = this->useBeam[j] && chunks[c].useBeam[j];
+		}
+		if(!ISNIN(chunks[c].mapVar)) {
+			mapVar = chunks[c].mapVar;
+		}
+		nBeamsUsed = chunks[c].nBeamsUsed;
+		if(chunks[c].badParticle >= 0) {
+			badParticle = chunks[c].badParticle;
+			break;
+		}
+	}
+	pfLog->setUsedBeams(nBeamsUsed);
+
+	//Leave beamsVF as the serial loop does, rotated for the last particle
+	if(rotateEach && badParticle < 0 && nParticles > 0) {
+		double tempAttitude[3] = {attitude[0], attitude[1],
+			attitude[2] - allParticles->psiBerg[nParticles - 1]
+		};
+		beamsVF = applyRotation(tempAttitude, tempBeamsVF);
+	}
+
+	return badParticle;
+}
+
+//********************************************************************************
+
+void
+TNavParticleFilter::
+logBadParticle(int i, double measTime) {
+	logs(TL_OMASK(TL_TNAV_PARTICLE_FILTER, TL_LOG),
+		"TNavPF::Measurement from time = %.2f sec. not included.",measTime);
+	//"encountered NaN values in the correlation map segment for all beams on one particle.\n",
+	logs(TL_OMASK(TL_TNAV_PARTICLE_FILTER, TL_LOG),
+		"Particle[%d] has NaN for all beam ranges, with roll = %.1f, "
+		"pitch = %.1f, yaw = %.1f degrees.\n",
+		i, allParticles->attitude[0][i]*180./PI,
+		allParticles->attitude[1][i]*180./PI,
+		allParticles->attitude[2][i]*180./PI);
+	logs(TL_OMASK(TL_TNAV_PARTICLE_FILTER, TL_LOG),
+		"x = %.1f, y = %.1f z = %.1f.\n",
+		allParticles->position[0][i],
+		allParticles->position[1][i],
+		allParticles->position[2][i]);
+	logs(TL_OMASK(TL_TNAV_PARTICLE_FILTER, TL_LOG),
+		"[ %.1f  %.1f  %.1f  %.3f  %.3f  %.3f];\n",
+		allParticles->position[0][i],
+		allParticles->position[1][i],
+		allParticles->position[2][i],
+		allParticles->attitude[0][i],
+		allParticles->attitude[1][i],
+		allParticles->attitude[2][i]);
+}
+
+//********************************************************************************
+
 void
 TNavParticleFilter::
 motionUpdate(poseT& currNavPose) {
-	int i;
 	double velocity_sf_sigma[3];
 	poseT diffPose;
 	double gyroStddev;
@@ -952,8 +1418,23 @@ motionUpdate(poseT& currNavPose) {
 	}
 
 	//Update each particle's position individually
-	for(i = 0; i < nParticles; i++) {
-		motionUpdateParticle(allParticles[i], diffPose, velocity_sf_sigma, gyroStddev);
+	if(threadPool != NULL && nParticles > PF_PARTICLE_CHUNK) {
+		//Each chunk of particles draws its noise from its own generator,
+		//seeded from the chunk index and update count, so the result does
+		//not depend on the number of threads or on their scheduling.
+		const uint64_t updateSeed = rngSeed + (++nMotionUpdates << 24);
+		const int nChunks = (nParticles + PF_PARTICLE_CHUNK - 1) / PF_PARTICLE_CHUNK;
+		threadPool->run(nChunks, [&](int chunk) {
+			trnRandState rng;
+			trn_rand_seed(&rng, updateSeed + chunk);
+			int end = (chunk + 1) * PF_PARTICLE_CHUNK;
+			if(end > nParticles) {
+				end = nParticles;
+			}
+			motionUpdateParticles(chunk * PF_PARTICLE_CHUNK, end, diffPose, velocity_sf_sigma, gyroStddev, &rng);
+		});
+	} else {
+		motionUpdateParticles(0, nParticles, diffPose, velocity_sf_sigma, gyroStddev, NULL);
 	}
 
 	//Apply attitude measurement update if integrating for phi/theta states
@@ -963,7 +1444,7 @@ motionUpdate(poseT& currNavPose) {
 
 
 	//if(saveDirectory != NULL)
-	//   writeParticlesToFile(allParticles, allParticlesFile);
+	//   writeParticlesToFile(*allParticles, allParticlesFile);
 
 	//Pass position to terrainMap.
 	navData_x_ = currNavPose.x;
@@ -979,7 +1460,7 @@ motionUpdate(poseT& currNavPose) {
 				  "title('Sub-Map and Particle Distribution: After motion update');",
 				  "figure(3)");
 
-	plotParticleDistMatlab(allParticles, "figure(3)");
+	plotParticleDistMatlab(*allParticles, "figure(3)");
 #endif
 
 	return;
@@ -993,16 +1474,14 @@ void
 TNavParticleFilter::
 computeMLE(poseT* mlePose) {
 	int i;
-	particleT mleParticle;
+	int mleParticle = 0;
 	double maxWeight = 0;
 
-	mleParticle = allParticles[0];
-
 	//Find the particle with the highest weight
 	for(i = 0; i < nParticles; i++) {
-		if(allParticles[i].weight > maxWeight) {
-			maxWeight = allParticles[i].weight;
-			mleParticle = allParticles[i];
+		if(allParticles->weight[i] > maxWeight) {
+			maxWeight = allParticles->weight[i];
+			mleParticle = i;
 		}
 	}
 
@@ -1025,33 +1504,33 @@ computeMMSE(poseT* mmsePose) {
 	poseT tempPose;
 
 	for(i = 0; i < nParticles; i++) {
-        double weight = allParticles[i].weight;
+        double weight = allParticles->weight[i];
 		sumWeights += weight;
 
-		tempPose.x += weight * allParticles[i].position[0];
-		tempPose.y += weight * allParticles[i].position[1];
-		tempPose.z += weight * allParticles[i].position[2];
-		tempPose.phi += weight * allParticles[i].attitude[0];
-		tempPose.theta += weight * allParticles[i].attitude[1];
+		tempPose.x += weight * allParticles->position[0][i];
+		tempPose.y += weight * allParticles->position[1][i];
+		tempPose.z += weight * allParticles->position[2][i];
+		tempPose.phi += weight * allParticles->attitude[0][i];
+		tempPose.theta += weight * allParticles->attitude[1][i];
 		//
 		// Psi is in the berg frame (same as vehicle if the
 		// SEARCH_PSI_BERG flag is not set) so we didn't change
 		// anything here.
 		if(SEARCH_COMPASS_BIAS) {
-			tempPose.psi += weight * (allParticles[i].attitude[2] + allParticles[i].compassBias);
+			tempPose.psi += weight * (allParticles->attitude[2][i] + allParticles->compassBias[i]);
 		} else {
-			tempPose.psi += weight * allParticles[i].attitude[2];
+			tempPose.psi += weight * allParticles->attitude[2][i];
 		}
 		if(SEARCH_PSI_BERG)
 		{
-		   tempPose.psi_berg += weight * allParticles[i].psiBerg;
+		   tempPose.psi_berg += weight * allParticles->psiBerg[i];
 		   //
 		   // Reports x,y,z in berg relative. Reports phi, theta, psi
 		   // of the vehicle wrto inertial, and reports psi_berg.
 		}
 		if(SEARCH_GYRO_BIAS) {
-			tempPose.wy += weight * allParticles[i].gyroBias[0];
-			tempPose.wz += weight * allParticles[i].gyroBias[1];
+			tempPose.wy += weight * allParticles->gyroBias[0][i];
+			tempPose.wz += weight * allParticles->gyroBias[1][i];
 		}
 	}
 
@@ -1073,34 +1552,34 @@ computeMMSE(poseT* mmsePose) {
 	}
 
 	for(i = 0; i < nParticles; i++) {
-        double weight = allParticles[i].weight;
+        double weight = allParticles->weight[i];
 		double alpha = weight / sumWeights;
-        double temp1 = allParticles[i].position[0] - tempPose.x;
+        double temp1 = allParticles->position[0][i] - tempPose.x;
 		tempPose.covariance[0] += temp1 * temp1 * alpha;
-        double temp2 = allParticles[i].position[1] - tempPose.y;
+        double temp2 = allParticles->position[1][i] - tempPose.y;
 		tempPose.covariance[2] += temp2 * temp2 * alpha;
 		tempPose.covariance[1] += temp1 * temp2 * alpha;
-		temp1 = allParticles[i].position[2] - tempPose.z;
+		temp1 = allParticles->position[2][i] - tempPose.z;
 		tempPose.covariance[5] += temp1 * temp1 * alpha;
-		temp1 = allParticles[i].attitude[0] - tempPose.phi;
+		temp1 = allParticles->attitude[0][i] - tempPose.phi;
 		tempPose.covariance[9] += temp1 * temp1 * alpha;
-		temp1 = allParticles[i].attitude[1] - tempPose.theta;
+		temp1 = allParticles->attitude[1][i] - tempPose.theta;
 		tempPose.covariance[14] += temp1 * temp1 * alpha;
 		if(SEARCH_COMPASS_BIAS) {
-			temp1 = allParticles[i].attitude[2] + allParticles[i].compassBias - tempPose.psi;
+			temp1 = allParticles->attitude[2][i] + allParticles->compassBias[i] - tempPose.psi;
 		} else {
-			temp1 = allParticles[i].attitude[2] - tempPose.psi;
+			temp1 = allParticles->attitude[2][i] - tempPose.psi;
 		}
 		tempPose.covariance[20] += temp1 * temp1 * alpha;
 		if(SEARCH_GYRO_BIAS) {
-			temp1 = allParticles[i].gyroBias[0] - tempPose.wy;
+			temp1 = allParticles->gyroBias[0][i] - tempPose.wy;
 			tempPose.covariance[27] += temp1 * temp1 * alpha;
-			temp1 = allParticles[i].gyroBias[1] - tempPose.wz;
+			temp1 = allParticles->gyroBias[1][i] - tempPose.wz;
 			tempPose.covariance[35] += temp1 * temp1 * alpha;
 		}
 		if( SEARCH_PSI_BERG)
 		{
-		   temp1 = allParticles[i].psiBerg - tempPose.psi_berg;
+		   temp1 = allParticles->psiBerg[i] - tempPose.psi_berg;
 		   tempPose.covariance[44] += temp1 * temp1 * alpha;
 		}
 	}
@@ -1220,9 +1699,9 @@ saveCurrDistrib(ofstream& outputFile) {
 	}
 
 	if (PARTICLESTOFILE == _distribType) {
-		writeParticlesToFile(allParticles, outputFile);
+		writeParticlesToFile(*allParticles, outputFile);
 	} else {
-		writeHistDistribToFile(allParticles, outputFile);
+		writeHistDistribToFile(*allParticles, outputFile);
 	}
 }
 
@@ -1230,7 +1709,12 @@ saveCurrDistrib(ofstream& outputFile) {
 particleT*
 TNavParticleFilter::
 getParticles() {
-	return this->allParticles;
+	particleExport.resize(nParticles);
+	for(int i = 0; i < nParticles; i++) {
+		allParticles->getParticle(i, particleExport[i]);
+		particleExport[i].expectedMeasDiff.assign(particleMeasDiff(i), particleMeasDiff(i) + measDiffStride);
+	}
+	return particleExport.data();
 }
 
 //********************************************************************************
@@ -1245,7 +1729,7 @@ saveCurrParticles(ofstream& outputFile) {
 		return;
 	}
 
-	writeParticlesToFile(allParticles, outputFile);
+	writeParticlesToFile(*allParticles, outputFile);
 }
 
 //********************************************************************************
@@ -1254,12 +1738,20 @@ saveCurrParticles(ofstream& outputFile) {
 void
 TNavParticleFilter::
 initVariables() {
-	//initialize particle array pointers
-	allParticles = particleArray1;
-	resampParticles = particleArray2;
+	//initialize particle set pointers
+	allParticles = &particleSet1;
+	resampParticles = &particleSet2;
 
 	//The particle filter will start out with the maximum number of particles
+	//unless a smaller filter has been configured
 	nParticles = MAX_PARTICLES;
+	int nConfigured = TNavConfig::instance()->getNumParticles();
+	if(nConfigured > 0 && nConfigured < MAX_PARTICLES) {
+		nParticles = nConfigured;
+	}
+	allParticles->allocate(nParticles);
+	resampParticles->allocate(nParticles);
+	resampIndex.resize(nParticles);
 
 	//Initialize counter for soundings used in correlation
 	nSoundings = 0;
@@ -1299,6 +1791,13 @@ void
 TNavParticleFilter::
 initParticleDist(const particleT& initialGuess) {
     int i=0;
+
+	//Seed the generators of the threaded motion update from the global
+	//generator, so that seed_randn() still makes a run repeatable
+	if(threadPool != NULL) {
+		rngSeed = ((uint64_t)rand() << 32) ^ (uint64_t)rand();
+		nMotionUpdates = 0;
+	}
 	SymmetricMatrix tempCov(9);
 	SymmetricMatrix tempCovSqrt(9);
 	tempCovSqrt = 0.0;
@@ -1353,6 +1852,11 @@ initParticleDist(const particleT& initialGuess) {
 			if(nParticles > MAX_PARTICLES){
 				nParticles = MAX_PARTICLES;
 			}
+			if(nParticles > allParticles->size){
+				allParticles->allocate(nParticles);
+				resampParticles->allocate(nParticles);
+				resampIndex.resize(nParticles);
+			}
 
 			//Read the number of states the file is giving
 			particleFile.getline(temp,10);
@@ -1360,28 +1864,28 @@ initParticleDist(const particleT& initialGuess) {
 
 			for(i = 0; i < nParticles; i++) {
 				//The file is structured such that the states are specified in the file as North, East, Down (optional), psiBerg (optional)
-				allParticles[i] = initialGuess;
-				allParticles[i].weight = 1.0 / nParticles;
+				allParticles->setParticle(i, initialGuess);
+				allParticles->weight[i] = 1.0 / nParticles;
 
 				particleFile.getline(temp,20,',');
-				this->allParticles[i].position[0] = atof(temp);
+				allParticles->position[0][i] = atof(temp);
 
 				particleFile.getline(temp,20,',');
-				this->allParticles[i].position[1] = atof(temp);
+				allParticles->position[1][i] = atof(temp);
 				if(nStates > 2){
 					particleFile.getline(temp,20, ',');
-					this->allParticles[i].position[2] = atof(temp);
+					allParticles->position[2][i] = atof(temp);
 				}
 				// Estimation of psiBerg
 				if(nStates > 3){
 					particleFile.getline(temp,20); //particleFile.getline(temp,20, ','); //If not the final state specified
 					double psiVehInBergFrame = atof(temp);
-					this->allParticles[i].psiBerg = this->allParticles[i].attitude[2] - psiVehInBergFrame;
+					allParticles->psiBerg[i] = allParticles->attitude[2][i] - psiVehInBergFrame;
 				}
 				/*To add another state to the file
 				if(nStates > 3){
 					particleFile.getline(temp,20); //particleFile.getline(temp,20, ','); //If not the final state specified
-					this->allParticles[i].newState = atof(temp);
+					this->allParticles->newState[i] = atof(temp);
 				}
 				*/
 
@@ -1401,80 +1905,80 @@ initParticleDist(const particleT& initialGuess) {
 		//Initialize the particle distribution to a gaussian around the initial guess
 		//Variances defined in particleFilterDefs.h
 		for(i = 0; i < nParticles; i++) {
-			allParticles[i] = initialGuess;
-			allParticles[i].weight = 1.0 / nParticles;
+			allParticles->setParticle(i, initialGuess);
+			allParticles->weight[i] = 1.0 / nParticles;
 
 			//initialize positions with uniform distribution (or reinitialize with gaussian)
             double tempX = (*pt2randFunction)(1.0);
             double tempY = (*pt2randFunction)(1.0);
 
-			this->allParticles[i].position[0] += tempX * tempCovSqrt(1, 1) +
+			allParticles->position[0][i] += tempX * tempCovSqrt(1, 1) +
 												 tempY * tempCovSqrt(1, 2);
-			this->allParticles[i].position[1] += tempX * tempCovSqrt(2, 1) +
+			allParticles->position[1][i] += tempX * tempCovSqrt(2, 1) +
 												 tempY * tempCovSqrt(2, 2);
 
 
 			if(!USE_CONTOUR_MATCHING) {
-				this->allParticles[i].position[2] += (*pt2randFunction)(tempCovSqrt(3, 3));
+				allParticles->position[2][i] += (*pt2randFunction)(tempCovSqrt(3, 3));
 			}
 
 			//initialize angles with gaussian distribution
 			if(ALLOW_ATTITUDE_SEARCH) {
-				this->allParticles[i].attitude[0] += (*pt2randFunction)(tempCovSqrt(4, 4));
-				this->allParticles[i].attitude[1] += (*pt2randFunction)(tempCovSqrt(5, 5));
-				this->allParticles[i].attitude[2] += (*pt2randFunction)(tempCovSqrt(6, 6));
+				allParticles->attitude[0][i] += (*pt2randFunction)(tempCovSqrt(4, 4));
+				allParticles->attitude[1][i] += (*pt2randFunction)(tempCovSqrt(5, 5));
+				allParticles->attitude[2][i] += (*pt2randFunction)(tempCovSqrt(6, 6));
 			}
 
 			//initialize moving terrain states if used
 			if(MOVING_TERRAIN) {
-				this->allParticles[i].terrainState[0] += randn_zeroMean(TERRAIN_DXDT_STDDEV_INIT);
-				this->allParticles[i].terrainState[1] += randn_zeroMean(TERRAIN_DYDT_STDDEV_INIT);
-				this->allParticles[i].terrainState[2] += randn_zeroMean(TERRAIN_DHDT_STDDEV_INIT);
+				allParticles->terrainState[0][i] += randn_zeroMean(TERRAIN_DXDT_STDDEV_INIT);
+				allParticles->terrainState[1][i] += randn_zeroMean(TERRAIN_DYDT_STDDEV_INIT);
+				allParticles->terrainState[2][i] += randn_zeroMean(TERRAIN_DHDT_STDDEV_INIT);
 			}
 
 			//initialize compass bias if used
 			if(SEARCH_COMPASS_BIAS) {
-				this->allParticles[i].compassBias += unif_zeroMean(COMPASS_BIAS_STDDEV_INIT);
+				allParticles->compassBias[i] += unif_zeroMean(COMPASS_BIAS_STDDEV_INIT);
 			}
 
 			//initialize alignment states if used
 			if(SEARCH_ALIGN_STATE) {
-				this->allParticles[i].alignState[0] += unif_zeroMean(PHI_ALIGN_ERROR_STDDEV_INIT);
-				this->allParticles[i].alignState[1] += unif_zeroMean(THETA_ALIGN_ERROR_STDDEV_INIT);
-				this->allParticles[i].alignState[2] += unif_zeroMean(PSI_ALIGN_ERROR_STDDEV_INIT);
+				allParticles->alignState[0][i] += unif_zeroMean(PHI_ALIGN_ERROR_STDDEV_INIT);
+				allParticles->alignState[1][i] += unif_zeroMean(THETA_ALIGN_ERROR_STDDEV_INIT);
+				allParticles->alignState[2][i] += unif_zeroMean(PSI_ALIGN_ERROR_STDDEV_INIT);
 			}
 
 			//initialize psiBerg if used
 			if(SEARCH_PSI_BERG) {
-				this->allParticles[i].psiBerg += unif_zeroMean(PSI_BERG_STDDEV_INIT);
+				allParticles->psiBerg[i] += unif_zeroMean(PSI_BERG_STDDEV_INIT);
 			}
 
 			//initialize gyro bias states if used
 			if(SEARCH_GYRO_BIAS) {
 				if(SEARCH_GYRO_Y) {
-					this->allParticles[i].gyroBias[0] += (*pt2randFunction)(tempCovSqrt(7, 7));
+					allParticles->gyroBias[0][i] += (*pt2randFunction)(tempCovSqrt(7, 7));
 				}
-				this->allParticles[i].gyroBias[1] += (*pt2randFunction)(tempCovSqrt(8, 8));
+				allParticles->gyroBias[1][i] += (*pt2randFunction)(tempCovSqrt(8, 8));
 				if(INTEG_PHI_THETA) {
-					this->allParticles[i].gyroBias[2] += (*pt2randFunction)(tempCovSqrt(8, 8));
+					allParticles->gyroBias[2][i] += (*pt2randFunction)(tempCovSqrt(8, 8));
 				}
 			}
 
 			//initialize DVL scale factor and bias if used
 			if(SEARCH_DVL_ERRORS) {
-				this->allParticles[i].dvlScaleFactor += unif_zeroMean(DVL_SF_STDDEV_INIT);
+				allParticles->dvlScaleFactor[i] += unif_zeroMean(DVL_SF_STDDEV_INIT);
                 int j=0;
 				for(j = 0; j < 3; j++) {
-					this->allParticles[i].dvlBias[j] += unif_zeroMean(DVL_BIAS_STDDEV_INIT);
+					allParticles->dvlBias[j][i] += unif_zeroMean(DVL_BIAS_STDDEV_INIT);
 				}
 			}
 		}
 	}
 
 	for(i = 0; i < nParticles; i++) {
-		this->allParticles[i].windowIndex = 0;
-		for(int indexW = 0; indexW < 20; indexW ++){
-			this->allParticles[i].windowedNis[indexW] = 0;
+		allParticles->windowIndex[i] = 0;
+		for(int indexW = 0; indexW < NIS_WINDOW_LENGTH; indexW ++){
+			allParticles->windowedNis[i * NIS_WINDOW_LENGTH + indexW] = 0;
 		}
 	}
 
@@ -1499,17 +2003,17 @@ attitudeMeasUpdate(const poseT& currPose) {
 
 	//Loop through & apply measurement update to all particles
 	for(i = 0; i < nParticles; i++) {
-		sumSquaredError = (1.0 / phiVar) * pow(allParticles[i].attitude[0] - currPose.phi, 2)
-						  + (1.0 / thetaVar) * pow(allParticles[i].attitude[1] - currPose.theta, 2);
+		sumSquaredError = (1.0 / phiVar) * pow(allParticles->attitude[0][i] - currPose.phi, 2)
+						  + (1.0 / thetaVar) * pow(allParticles->attitude[1][i] - currPose.theta, 2);
 		measProb = pow(2 * PI, -1.0) * pow(thetaVar * phiVar, -0.5) *
 				   exp(-0.5 * sumSquaredError);
-		allParticles[i].weight *= measProb;
-		sumWeights += allParticles[i].weight;
+		allParticles->weight[i] *= measProb;
+		sumWeights += allParticles->weight[i];
 	}
 	//Normalize the distribution
 	for(i = 0; i < nParticles; i++) {
-		allParticles[i].weight /= sumWeights;
-		sumSquaresWeights += pow(allParticles[i].weight, 2);
+		allParticles->weight[i] /= sumWeights;
+		sumSquaresWeights += pow(allParticles->weight[i], 2);
 	}
 	effSampSize = 1.0 / sumSquaresWeights;
 
@@ -1536,7 +2040,7 @@ attitudeMeasUpdate(const poseT& currPose) {
 					  "title('Sub-Map and Particle Distribution: Prior to Resampling');",
 					  "figure(2)");
 
-		plotParticleDistMatlab(allParticles, "figure(2)");
+		plotParticleDistMatlab(*allParticles, "figure(2)");
 #endif
 
 		//resample particle distribution
@@ -1577,16 +2081,18 @@ homerMeasUpdate(const measT& currMeas) {
 		currHomerPose(3, 1) = homerRelPose[2] + randn_zeroMean(range_stddev[2]);
 
 		//rotate rel pose into inertial coordinates
-		homerInertPose = applyRotation(allParticles[i].attitude, currHomerPose);
+		double attitude[3] = {allParticles->attitude[0][i], allParticles->attitude[1][i],
+							  allParticles->attitude[2][i]};
+		homerInertPose = applyRotation(attitude, currHomerPose);
 
 		//fill in homer pose based on particle vehicle pose estimate
-		homerPoseN[i] = allParticles[i].position[0] + homerInertPose(1, 1);
-		homerPoseE[i] = allParticles[i].position[1] + homerInertPose(2, 1);
+		homerPoseN[i] = allParticles->position[0][i] + homerInertPose(1, 1);
+		homerPoseE[i] = allParticles->position[1][i] + homerInertPose(2, 1);
 	}
 
 	//Compute mean and variance of current homer pose estimate
 	for(i = 0; i < nParticles; i++) {
-        double weight = allParticles[i].weight;
+        double weight = allParticles->weight[i];
 		sumWeights += weight;
 
 		homerPoseMu[0] += weight * homerPoseN[i];
@@ -1598,7 +2104,7 @@ homerMeasUpdate(const measT& currMeas) {
 		homerPoseMu[1] /= sumWeights;
 	}
 	for(i = 0; i < nParticles; i++) {
-        double weight = allParticles[i].weight;
+        double weight = allParticles->weight[i];
         double alpha = weight / sumWeights;
         double temp1 = homerPoseN[i] - homerPoseMu[0];
 		homerPoseCov[0] += temp1 * temp1 * alpha;
@@ -1617,7 +2123,7 @@ homerMeasUpdate(const measT& currMeas) {
 	} else {
 		if(SAVE_PARTICLES) {
 			for(i = 0; i < nParticles; i++)
-				homerParticlesFile << setprecision(15) << i << "\t" << allParticles[i].weight << "\t"
+				homerParticlesFile << setprecision(15) << i << "\t" << allParticles->weight[i] << "\t"
 								   << homerPoseN[i] << "\t" << homerPoseE[i] << endl;
 		}
 	}
@@ -1643,9 +2149,41 @@ homerMeasUpdate(const measT& currMeas) {
 bool
 TNavParticleFilter::
 getExpectedMeasDiffParticle(particleT& particle, const Matrix& beamsSF, double* beamRanges, const int* beamIndices, double& mapVar) {
+	return getExpectedMeasDiffParticle(particle, beamsSF, beamRanges, beamIndices, mapVar, this->tempUseBeam);
+}
+
+bool
+TNavParticleFilter::
+getExpectedMeasDiffParticle(particleT& particle, const Matrix& beamsSF, double* beamRanges, const int* beamIndices, double& mapVar, bool* useBeamOut) {
+	particle.expectedMeasDiff.assign(beamsSF.Ncols(), 0);
+	return computeMeasDiff(particle.position, particle.attitude, particle.alignState,
+						   particle.compassBias, beamsSF, beamRanges, beamIndices, mapVar,
+						   particle.expectedMeasDiff.data(), useBeamOut);
+}
+
+bool
+TNavParticleFilter::
+getExpectedMeasDiffParticle(int i, const Matrix& beamsSF, double* beamRanges, const int* beamIndices, double& mapVar, bool* useBeamOut) {
+	double position[3], attitude[3], alignState[3] = {0, 0, 0};
+	for(int j = 0; j < 3; j++) {
+		position[j] = allParticles->position[j][i];
+		attitude[j] = allParticles->attitude[j][i];
+		if(SEARCH_ALIGN_STATE) {
+			alignState[j] = allParticles->alignState[j][i];
+		}
+	}
+	double compassBias = SEARCH_COMPASS_BIAS ? allParticles->compassBias[i] : 0.0;
+
+	return computeMeasDiff(position, attitude, alignState, compassBias, beamsSF,
+						   beamRanges, beamIndices, mapVar, particleMeasDiff(i), useBeamOut);
+}
+
+bool
+TNavParticleFilter::
+computeMeasDiff(const double* position, const double* attitude, const double* alignState, double compassBias, const Matrix& beamsSF, double* beamRanges, const int* beamIndices, double& mapVar, double* measDiffOut, bool* useBeamOut) {
 //Update Expected Measurement Differences
-// This function takes in a particle (particle) and the beams in the ??? frame
-// (beamsSF), and the ranges (beamRanges)
+// This function takes in a particle's states (position, attitude, ...) and
+// the beams in the ??? frame (beamsSF), and the ranges (beamRanges)
 //
 // It extracts the difference between the measurement and expected measurement
 // for the particle, using either and octree map (this->mapType==2), or a DEM with either
@@ -1658,14 +2196,15 @@ getExpectedMeasDiffParticle(particleT& particle, const Matrix& beamsSF, double*
 	int i;
 	//!double beamN, beamE, beamZ, mapZ;
 //  double mapVar = 1;
-	Matrix beamsMF;
-	Matrix beamsVF;
+	Matrix rotatedMF;
+	Matrix rotatedVF;
+	//the beams are only copied when a rotation is applied
+	const Matrix* beamsMF = &beamsSF;
 
 	//!double beamU[3];		//Used for octree, range
 	double beamVector[3];
 	//float estRange;
 	//!double r_pred;		//range
-	std::vector<double> tempExpectedMeasDiff(beamsSF.Ncols(), 0);
 
 
 	//If searching over alignment state, first bring beams into vehicle frame
@@ -1673,26 +2212,24 @@ getExpectedMeasDiffParticle(particleT& particle, const Matrix& beamsSF, double*
         double currDvlAttitude[3] = {dvlAttitude[0], dvlAttitude[1],
             dvlAttitude[2]
         };
-		currDvlAttitude[0] += particle.alignState[0];
-		currDvlAttitude[1] += particle.alignState[1];
-		currDvlAttitude[2] += particle.alignState[2];
-		beamsVF = applyRotation(currDvlAttitude, beamsSF);
-	} else {
-		beamsVF = beamsSF;
+		currDvlAttitude[0] += alignState[0];
+		currDvlAttitude[1] += alignState[1];
+		currDvlAttitude[2] += alignState[2];
+		rotatedVF = applyRotation(currDvlAttitude, beamsSF);
+		beamsMF = &rotatedVF;
 	}
 
 	//Rotate the beams from the vehicle frame to the map frame
 	if(ALLOW_ATTITUDE_SEARCH) {
-        double currAttitude[3] = {particle.attitude[0], particle.attitude[1],
-            particle.attitude[2]
+        double currAttitude[3] = {attitude[0], attitude[1],
+            attitude[2]
         };
 		if(SEARCH_COMPASS_BIAS) {
-			currAttitude[2] += particle.compassBias;
+			currAttitude[2] += compassBias;
 		}
 
-		beamsMF = applyRotation(currAttitude, beamsVF);
-	} else {
-		beamsMF = beamsVF;
+		rotatedMF = applyRotation(currAttitude, *beamsMF);
+		beamsMF = &rotatedMF;
 	}
 
 
@@ -1700,18 +2237,18 @@ getExpectedMeasDiffParticle(particleT& particle, const Matrix& beamsSF, double*
 	//
 	bool goodBeams = false;
 
-	for(i = 0; i < beamsMF.Ncols(); i++) {
-		beamVector[0] = beamsMF(1, i + 1);//the directionVector
-		beamVector[1] = beamsMF(2, i + 1);
-		beamVector[2] = beamsMF(3, i + 1);
+	for(i = 0; i < beamsMF->Ncols(); i++) {
+		beamVector[0] = (*beamsMF)(1, i + 1);//the directionVector
+		beamVector[1] = (*beamsMF)(2, i + 1);
+		beamVector[2] = (*beamsMF)(3, i + 1);
 
-		tempExpectedMeasDiff[i] =
-				terrainMap->GetRangeError(mapVar, particle.position, beamVector, beamRanges[beamIndices[i]]);
+		measDiffOut[i] =
+				terrainMap->GetRangeError(mapVar, position, beamVector, beamRanges[beamIndices[i]]);
 
-		// if(isnan(tempExpectedMeasDiff[i])){
-		if(ISNIN(tempExpectedMeasDiff[i])){
-			//tempExpectedMeasDiff[i] = 0;
-			this->tempUseBeam[i] = false; //beam hit map hole or missed -> don't use this beam to compare particles
+		// if(isnan(measDiffOut[i])){
+		if(ISNIN(measDiffOut[i])){
+			//measDiffOut[i] = 0;
+			useBeamOut[i] = false; //beam hit map hole or missed -> don't use this beam to compare particles
 			/*if(!USE_MAP_NAN){
 				return false;
 			}
@@ -1719,23 +2256,144 @@ getExpectedMeasDiffParticle(particleT& particle, const Matrix& beamsSF, double*
 		}
 		else
 		{
-			this->tempUseBeam[i] = true;
+			useBeamOut[i] = true;
 			goodBeams = true;            // OK, at least one beam is good
 		}
 
 	}
 
-	particle.expectedMeasDiff = tempExpectedMeasDiff;
+	return goodBeams;
+}
+
+TerrainMapDEM*
+TNavParticleFilter::
+batchMeasMap() {
+	if(this->mapType != 1 || ALLOW_ATTITUDE_SEARCH || SEARCH_ALIGN_STATE || SEARCH_PSI_BERG) {
+		return NULL;
+	}
+	return dynamic_cast<TerrainMapDEM*>(terrainMap);
+}
+
+void
+TNavParticleFilter::
+expectedMeasDiffBatch(TerrainMapDEM* dem, int begin, int end, const Matrix& beamsMF, const double* beamRanges, const int* beamIndices) {
+	double beamN[TRN_MAX_BEAMS], beamE[TRN_MAX_BEAMS], beamZ[TRN_MAX_BEAMS];
+	double ranges[TRN_MAX_BEAMS];
+	const int nBeams = beamsMF.Ncols();
+
+	for(int j = 0; j < nBeams; j++) {
+		beamN[j] = beamsMF(1, j + 1);
+		beamE[j] = beamsMF(2, j + 1);
+		beamZ[j] = beamsMF(3, j + 1);
+		ranges[j] = beamRanges[beamIndices[j]];
+	}
+
+	//the particle positions are already laid out as the map wants them
+	dem->GetRangeErrors(end - begin, allParticles->position[0] + begin,
+						allParticles->position[1] + begin, allParticles->position[2] + begin,
+						nBeams, beamN, beamE, beamZ, ranges,
+						particleMeasDiff(begin), &measMapVar[begin * nBeams]);
+}
+
+bool
+TNavParticleFilter::
+getBatchedMeasDiffParticle(int i, double& mapVar, bool* useBeamOut) {
+	const double* diff = particleMeasDiff(i);
+	bool goodBeams = false;
+
+	for(int j = 0; j < measDiffStride; j++) {
+		useBeamOut[j] = !ISNIN(diff[j]);
+		goodBeams = goodBeams || useBeamOut[j];
+	}
+
+	//as for the per particle query, the map variance of the last beam
+	if(measDiffStride > 0 && !ISNIN(measMapVar[i * measDiffStride + measDiffStride - 1])) {
+		mapVar = measMapVar[i * measDiffStride + measDiffStride - 1];
+	}
 	return goodBeams;
 }
 
 //********************************************************************************
 
+double
+TNavParticleFilter::
+motionDriftStddev(const poseT& diffPose) {
+	double cep = (this->vehicle->driftRate / 100.0) * (sqrt(diffPose.x * diffPose.x + diffPose.y * diffPose.y));
+
+#ifdef WITH_TNAVPF_CEP_CORRECTION
+	// k headley per Rock 2022-12-05
+	// removes sqrt (error)
+	// divides by sqrt of time since last sample (b/c it is discrete time)
+	// Without these, it is expected that changes to sample interval will
+	// introduce disproportionate amounts of noise, giving unreliable results.
+	return MOTION_NOISE_MULTIPLIER * (cep / sqrt(-2 * (log(1 - 0.5))))/sqrt(diffPose.time);
+#else
+	// original, thought to be incorrect
+	//TODO:  check conversion from CEP to Stddev, I don't feel like there should be a sqrt outside the CEP
+	return MOTION_NOISE_MULTIPLIER * sqrt(cep / sqrt(-2 * (log(1 - 0.5))));
+#endif
+}
+
+//********************************************************************************
+
+void
+TNavParticleFilter::
+motionUpdateParticles(int begin, int end, const poseT& diffPose, double* velocity_sf_sigma, const double& gyroStddev, trnRandState* rng) {
+	int i;
+
+	//Without optional states the particles differ only in their noise
+	if(!MOVING_TERRAIN && !ALLOW_ATTITUDE_SEARCH && !SEARCH_GYRO_BIAS && !SEARCH_ALIGN_STATE &&
+	   !SEARCH_PSI_BERG && !SEARCH_DVL_ERRORS && !INTEG_PHI_THETA &&
+	   (diffPose.gpsValid || !DEAD_RECKON || !lastNavPose->dvlValid)) {
+		const double driftStddev = motionDriftStddev(diffPose);
+		double noise[3][PF_PARTICLE_CHUNK];
+
+		for(int block = begin; block < end; block += PF_PARTICLE_CHUNK) {
+			const int n = std::min(PF_PARTICLE_CHUNK, end - block);
+
+			//draw in the same order as motionUpdateParticle()
+			for(i = 0; i < n; i++) {
+				noise[2][i] = USE_CONTOUR_MATCHING ? 0.0 : randn_zeroMean(DZ_STDDEV, rng);
+				noise[0][i] = randn_zeroMean(driftStddev, rng);
+				noise[1][i] = randn_zeroMean(driftStddev, rng);
+			}
+
+			double* x = allParticles->position[0] + block;
+			double* y = allParticles->position[1] + block;
+			double* z = allParticles->position[2] + block;
+			for(i = 0; i < n; i++) {
+				x[i] += diffPose.x + noise[0][i];
+				y[i] += diffPose.y + noise[1][i];
+				z[i] += diffPose.z + noise[2][i];
+			}
+
+			double* phi = allParticles->attitude[0] + block;
+			double* theta = allParticles->attitude[1] + block;
+			double* psi = allParticles->attitude[2] + block;
+			for(i = 0; i < n; i++) {
+				psi[i] += diffPose.psi;
+				phi[i] += diffPose.phi;
+				theta[i] += diffPose.theta;
+			}
+		}
+		return;
+	}
+
+	particleT particle;
+	for(i = begin; i < end; i++) {
+		allParticles->getParticle(i, particle);
+		motionUpdateParticle(particle, diffPose, velocity_sf_sigma, gyroStddev, rng);
+		allParticles->setParticle(i, particle);
+	}
+}
+
+//********************************************************************************
+
 // Assume that diffPose is inertially referenced.  diffPose.psi is inertial heading change.
 
 void
 TNavParticleFilter::
-motionUpdateParticle(particleT& particle, const poseT& diffPose, double* velocity_sf_sigma, const double& gyroStddev) {
+motionUpdateParticle(particleT& particle, const poseT& diffPose, double* velocity_sf_sigma, const double& gyroStddev, trnRandState* rng) {
 	double vehicleDisp[3];
 	Matrix velocity_sf(3, 1);
 	Matrix velocity_vf(3, 1);
@@ -1751,7 +2409,7 @@ motionUpdateParticle(particleT& particle, const poseT& diffPose, double* velocit
 	//Depth update is given by INS delta z
 	vehicleDisp[2] = diffPose.z;
 	if(!USE_CONTOUR_MATCHING) {
-		vehicleDisp[2] += randn_zeroMean(DZ_STDDEV);
+		vehicleDisp[2] += randn_zeroMean(DZ_STDDEV, rng);
 	}
 
 	//If there is valid GPS data, use the stored INS pose information to perform
@@ -1761,25 +2419,11 @@ motionUpdateParticle(particleT& particle, const poseT& diffPose, double* velocit
 	if(diffPose.gpsValid || !DEAD_RECKON || !lastNavPose->dvlValid) {
 		//Add Gaussian noise to account for uncertainty in the inertial disp.
 		//measurement
-        double cep = (this->vehicle->driftRate / 100.0) * (sqrt(diffPose.x * diffPose.x + diffPose.y * diffPose.y));
-
-
-#ifdef WITH_TNAVPF_CEP_CORRECTION
-        // k headley per Rock 2022-12-05
-        // removes sqrt (error)
-        // divides by sqrt of time since last sample (b/c it is discrete time)
-        // Without these, it is expected that changes to sample interval will
-        // introduce disproportionate amounts of noise, giving unreliable results.
-        double driftStddev = MOTION_NOISE_MULTIPLIER * (cep / sqrt(-2 * (log(1 - 0.5))))/sqrt(diffPose.time);
-#else
-        // original, thought to be incorrect
-        //TODO:  check conversion from CEP to Stddev, I don't feel like there should be a sqrt outside the CEP
-        double driftStddev = MOTION_NOISE_MULTIPLIER * sqrt(cep / sqrt(-2 * (log(1 - 0.5))));
-#endif
+        double driftStddev = motionDriftStddev(diffPose);
 
 		//logs(TL_OMASK(TL_TNAV_PARTICLE_FILTER, TL_LOG),"MOTION UPDATE: CEP = %f\n",this->vehicle->driftRate/100.0); //TODO: Remove this (when no longer needed)
-		vehicleDisp[0] = diffPose.x + randn_zeroMean(driftStddev);
-		vehicleDisp[1] = diffPose.y + randn_zeroMean(driftStddev);
+		vehicleDisp[0] = diffPose.x + randn_zeroMean(driftStddev, rng);
+		vehicleDisp[1] = diffPose.y + randn_zeroMean(driftStddev, rng);
 		//logs(TL_OMASK(TL_TNAV_PARTICLE_FILTER, TL_LOG),"standard navigation update...\n");
 	} else {
 
@@ -1807,13 +2451,13 @@ motionUpdateParticle(particleT& particle, const poseT& diffPose, double* velocit
 
 		//Add uniform noise if velocity is water based and gaussian otherwise
 		if(!lastNavPose->bottomLock) {
-			velocity_sf(1, 1) += unif_zeroMean(velocity_sf_sigma[0]);
-			velocity_sf(2, 1) += unif_zeroMean(velocity_sf_sigma[1]);
-			velocity_sf(3, 1) += unif_zeroMean(velocity_sf_sigma[2]);
+			velocity_sf(1, 1) += unif_zeroMean(velocity_sf_sigma[0], rng);
+			velocity_sf(2, 1) += unif_zeroMean(velocity_sf_sigma[1], rng);
+			velocity_sf(3, 1) += unif_zeroMean(velocity_sf_sigma[2], rng);
 		} else {
-			velocity_sf(1, 1) += randn_zeroMean(velocity_sf_sigma[0]);
-			velocity_sf(2, 1) += randn_zeroMean(velocity_sf_sigma[1]);
-			velocity_sf(3, 1) += randn_zeroMean(velocity_sf_sigma[2]);
+			velocity_sf(1, 1) += randn_zeroMean(velocity_sf_sigma[0], rng);
+			velocity_sf(2, 1) += randn_zeroMean(velocity_sf_sigma[1], rng);
+			velocity_sf(3, 1) += randn_zeroMean(velocity_sf_sigma[2], rng);
 		}
 
 		//Transform sensor frame velocities to vehicle frame:
@@ -1846,11 +2490,11 @@ motionUpdateParticle(particleT& particle, const poseT& diffPose, double* velocit
 		if(USE_ACCEL) {
 			//estimate current constant acceleration
 			accel_sf(1, 1) = lastNavPose->ax +
-							 randn_zeroMean(2.0 * velocity_sf_sigma[0] * diffPose.time * diffPose.time);
+							 randn_zeroMean(2.0 * velocity_sf_sigma[0] * diffPose.time * diffPose.time, rng);
 			accel_sf(2, 1) = lastNavPose->ay +
-							 randn_zeroMean(2.0 * velocity_sf_sigma[1] * diffPose.time * diffPose.time);
+							 randn_zeroMean(2.0 * velocity_sf_sigma[1] * diffPose.time * diffPose.time, rng);
 			accel_sf(3, 1) = lastNavPose->az +
-							 randn_zeroMean(2.0 * velocity_sf_sigma[2] * diffPose.time * diffPose.time);
+							 randn_zeroMean(2.0 * velocity_sf_sigma[2] * diffPose.time * diffPose.time, rng);
 
 			accel_vf = applyRotation(currDvlAttitude, accel_sf);
 			accel_if = applyRotation(currAttitude, accel_vf);
@@ -1876,7 +2520,7 @@ motionUpdateParticle(particleT& particle, const poseT& diffPose, double* velocit
 
 	   // Add process noise to particle psi berg estimate.
 
-	   particle.psiBerg += PSI_BERG_PROCESS_STD*randn_zeroMean(1);
+	   particle.psiBerg += PSI_BERG_PROCESS_STD*randn_zeroMean(1, rng);
 	   // To Do:  check/fix this line.
 
 	}
@@ -1915,7 +2559,7 @@ motionUpdateParticle(particleT& particle, const poseT& diffPose, double* velocit
 		particle.position[1] = finalPos(2, 1);
 		particle.position[2] = finalPos(3, 1);
 		particle.attitude[2] += diffPose.psi -
-								diffPose.time * particle.terrainState[2] + randn_zeroMean(DPSI_STDDEV);
+								diffPose.time * particle.terrainState[2] + randn_zeroMean(DPSI_STDDEV, rng);
 	} else {
 		particle.position[0] += vehicleDisp[0];
 		particle.position[1] += vehicleDisp[1];
@@ -1955,11 +2599,11 @@ motionUpdateParticle(particleT& particle, const poseT& diffPose, double* velocit
 		//Update gyro bias terms with random noise to allow slight drift
 		if(diffPose.time > 0) {
 			if(SEARCH_GYRO_Y) {
-				particle.gyroBias[0] += randn_zeroMean(gyroStddev);
+				particle.gyroBias[0] += randn_zeroMean(gyroStddev, rng);
 			}
-			particle.gyroBias[1] += randn_zeroMean(gyroStddev);
+			particle.gyroBias[1] += randn_zeroMean(gyroStddev, rng);
 			if(INTEG_PHI_THETA) {
-				particle.gyroBias[2] += randn_zeroMean(gyroStddev);
+				particle.gyroBias[2] += randn_zeroMean(gyroStddev, rng);
 			}
 		}
 	} else {
@@ -1977,28 +2621,28 @@ motionUpdateParticle(particleT& particle, const poseT& diffPose, double* velocit
 	//if searching over attitude states
 	if(ALLOW_ATTITUDE_SEARCH) {
 		if(!INTEG_PHI_THETA) {
-			particle.attitude[0] += randn_zeroMean(DPHI_STDDEV);
-			particle.attitude[1] += randn_zeroMean(DTHETA_STDDEV);
+			particle.attitude[0] += randn_zeroMean(DPHI_STDDEV, rng);
+			particle.attitude[1] += randn_zeroMean(DTHETA_STDDEV, rng);
 		}
 
 		if(!SEARCH_GYRO_BIAS) {
-			particle.attitude[2] += randn_zeroMean(DPSI_STDDEV);
+			particle.attitude[2] += randn_zeroMean(DPSI_STDDEV, rng);
 		}
 	}
 
 	//Add randomness to alignState
 	if(SEARCH_ALIGN_STATE) {
-		particle.alignState[0] += randn_zeroMean(DALIGN_STDDEV);
-		particle.alignState[1] += randn_zeroMean(DALIGN_STDDEV);
-		particle.alignState[2] += randn_zeroMean(DALIGN_STDDEV);
+		particle.alignState[0] += randn_zeroMean(DALIGN_STDDEV, rng);
+		particle.alignState[1] += randn_zeroMean(DALIGN_STDDEV, rng);
+		particle.alignState[2] += randn_zeroMean(DALIGN_STDDEV, rng);
 	}
 
 	//Add randomness to DVL error states
 	if(SEARCH_DVL_ERRORS) {
-		particle.dvlScaleFactor += randn_zeroMean(DDVLSF_STDDEV);
+		particle.dvlScaleFactor += randn_zeroMean(DDVLSF_STDDEV, rng);
         int i=0;
 		for(i = 0; i < 3; i++) {
-			particle.dvlBias[i] += randn_zeroMean(DDVLBIAS_STDDEV);
+			particle.dvlBias[i] += randn_zeroMean(DDVLBIAS_STDDEV, rng);
 		}
 	}
 
@@ -2032,8 +2676,7 @@ resampParticleDist() {
 		//logs(TL_OMASK(TL_TNAV_PARTICLE_FILTER, TL_LOG),"number of random samples to generate: %i\n", M);
 		computeMMSE(&mmseEst);
 		for(m = 0; m < M; m++) {
-			resampParticles[m] = allParticles[0];
-			resampParticles[m].weight = 1.0 / nParticles;
+			resampIndex[m] = 0;
 		}
 	}
 	N = nParticles - M;
@@ -2042,22 +2685,26 @@ resampParticleDist() {
 	//"Probabilistic Robotics" by Thrun, Burgard, Fox - pg. 110
 	step = 1.0 / N;
 	r = (rand() + 1) * (1.0 / (RAND_MAX + 1.0)) * 1.0 / nParticles;
-	c = allParticles[0].weight;
+	c = allParticles->weight[0];
 	for(m = 0; m < N; m++) {
 		double U = r + m * step;
 
 		while(c < U) {
 			i++;
-			c += allParticles[i].weight;
+			c += allParticles->weight[i];
 		}
 
-		//copy state of current particles to resampled particles
-		resampParticles[m + M] = allParticles[i];
-		resampParticles[m + M].weight = 1.0 / nParticles;
+		resampIndex[m + M] = i;
+	}
+
+	//copy state of the chosen particles to resampled particles
+	resampParticles->gather(*allParticles, resampIndex.data(), nParticles);
+	for(m = 0; m < nParticles; m++) {
+		resampParticles->weight[m] = 1.0 / nParticles;
 	}
 
 	//if(saveDirectory != NULL)
-	//   writeParticlesToFile(resampParticles, resampParticlesFile);
+	//   writeParticlesToFile(*resampParticles, resampParticlesFile);
 
 	//swap in resampled distribution
 	updateParticleDist();
@@ -2070,16 +2717,16 @@ TNavParticleFilter::
 getDistBounds(double& Nmin, double& Nmax, double& Emin, double& Emax) {
 	int i;
 
-	Nmin = allParticles[0].position[0];
+	Nmin = allParticles->position[0][0];
 	Nmax = Nmin;
-	Emin = allParticles[0].position[1];
+	Emin = allParticles->position[1][0];
 	Emax = Emin;
 
 	for(i = 0; i < nParticles; i++) {
-		Nmin = min(Nmin, allParticles[i].position[0]);
-		Nmax = max(Nmax, allParticles[i].position[0]);
-		Emin = min(Emin, allParticles[i].position[1]);
-		Emax = max(Emax, allParticles[i].position[1]);
+		Nmin = min(Nmin, allParticles->position[0][i]);
+		Nmax = max(Nmax, allParticles->position[0][i]);
+		Emin = min(Emin, allParticles->position[1][i]);
+		Emax = max(Emax, allParticles->position[1][i]);
 	}
 	return;
 }
@@ -2090,22 +2737,22 @@ getDistBounds(double& Nmin, double& Nmax, double& Emin, double& Emax) {
 
 void
 TNavParticleFilter::
-getParticlePose(const particleT& particle, poseT* particlePose) {
-	particlePose->x = particle.position[0];
-	particlePose->y = particle.position[1];
-	particlePose->z = particle.position[2];
+getParticlePose(int i, poseT* particlePose) {
+	particlePose->x = allParticles->position[0][i];
+	particlePose->y = allParticles->position[1][i];
+	particlePose->z = allParticles->position[2][i];
 
-	particlePose->phi = particle.attitude[0];
-	particlePose->theta = particle.attitude[1];
-	particlePose->psi = particle.attitude[2];
+	particlePose->phi = allParticles->attitude[0][i];
+	particlePose->theta = allParticles->attitude[1][i];
+	particlePose->psi = allParticles->attitude[2][i];
 
 	if(SEARCH_COMPASS_BIAS) {
-		particlePose->psi += particle.compassBias;
+		particlePose->psi += allParticles->compassBias[i];
 	}
 
 	if(SEARCH_PSI_BERG)
 	{
-	   particlePose->psi_berg = particle.psiBerg;
+	   particlePose->psi_berg = allParticles->psiBerg[i];
 	}
 
 	particlePose->time = this->lastNavPose->time;
@@ -2119,7 +2766,7 @@ void
 TNavParticleFilter::
 updateParticleDist() {
 	//temporary pointer
-	particleT* tempPointer;
+	particleSetT* tempPointer;
 
 	tempPointer = resampParticles;
 
@@ -2161,16 +2808,16 @@ computeKLdiv_gaussian_particles() {
 
 	//sum KL over all entries
 	for(i = 0; i < nParticles; i++) {
-		dx(1) = allParticles[i].position[0] - mu[0];
-		dx(2) = allParticles[i].position[1] - mu[1];
+		dx(1) = allParticles->position[0][i] - mu[0];
+		dx(2) = allParticles->position[1][i] - mu[1];
 
 		//compute current gaussian probability
 		Value = dx.t() * A * dx;
 		double q = eta * exp(Value.AsScalar() * -0.5);
 
 		//add current kl entry
-		if(allParticles[i].weight / q > 1e-50 && allParticles[i].weight / q < 1e50) {
-			kl += allParticles[i].weight * log(allParticles[i].weight / q);
+		if(allParticles->weight[i] / q > 1e-50 && allParticles->weight[i] / q < 1e50) {
+			kl += allParticles->weight[i] * log(allParticles->weight[i] / q);
 		}
 	}
 
@@ -2182,7 +2829,7 @@ computeKLdiv_gaussian_particles() {
 
 void
 TNavParticleFilter::
-computeInnovationsMatrices(particleT* particles, SymmetricMatrix& measVarMat, ColumnVector& measDiffMean) {
+computeInnovationsMatrices(SymmetricMatrix& measVarMat, ColumnVector& measDiffMean) {
 	//This function computes the mean and variance matrices of the expected measurements
 	//This is passed back in measVarMat and measDiffMean
 
@@ -2193,17 +2840,19 @@ computeInnovationsMatrices(particleT* particles, SymmetricMatrix& measVarMat, Co
 
 	//Calculate mean expected measurement difference
 	for(i = 0; i < nParticles; i++) {
+		const double* diff = particleMeasDiff(i);
 		for(j = 0; j < measVarMat.Ncols(); j++) {
-			measDiffMean(j + 1) += particles[i].expectedMeasDiff[j] * particles[i].weight;
+			measDiffMean(j + 1) += diff[j] * allParticles->weight[i];
 		}
 	}
 
 	//Calculate Variance of expected measurement differences from the map
 	for(i = 0; i < nParticles; i++) {
+		const double* diff = particleMeasDiff(i);
 		for(j = 0; j < measVarMat.Ncols(); j++) {
 			for(k = j; k < measVarMat.Ncols(); k++) {
-				measVarMat(k + 1, j + 1) += (particles[i].expectedMeasDiff[j] - measDiffMean(j + 1)) * (particles[i].expectedMeasDiff[k] -
-											measDiffMean(k + 1)) * particles[i].weight;
+				measVarMat(k + 1, j + 1) += (diff[j] - measDiffMean(j + 1)) * (diff[k] -
+											measDiffMean(k + 1)) * allParticles->weight[i];
 			}
 		}
 	}
@@ -2272,7 +2921,7 @@ plotMapMatlab(const Matrix& Surf, double* xpts, double* ypts, const char* plotTi
 
 void
 TNavParticleFilter::
-plotParticleDistMatlab(particleT* particles, const char* figureNum) {
+plotParticleDistMatlab(const particleSetT& particles, const char* figureNum) {
 #ifdef USE_MATLAB
 	mxArray* matlabPart = NULL;
 	int i;
@@ -2280,9 +2929,9 @@ plotParticleDistMatlab(particleT* particles, const char* figureNum) {
 
 	//fill Matrix with particle pose and weight information
 	for(i = 0; i < nParticles; i++) {
-		allPart(i + 1, 1) = particles[i].position[0] - lastNavPose->x;
-		allPart(i + 1, 2) = particles[i].position[1] - lastNavPose->y;
-		allPart(i + 1, 3) = particles[i].weight;
+		allPart(i + 1, 1) = particles.position[0][i] - lastNavPose->x;
+		allPart(i + 1, 2) = particles.position[1][i] - lastNavPose->y;
+		allPart(i + 1, 3) = particles.weight[i];
 	}
 
 	//put matrix into matlab
@@ -2341,44 +2990,44 @@ plotBeamMatlab(const double& npos, const double& epos, const double& zpos, const
 
 void
 TNavParticleFilter::
-writeParticlesToFile(particleT* particles, ofstream& particlesFile) {
+writeParticlesToFile(const particleSetT& particles, ofstream& particlesFile) {
 	int i;
 
 	//write particle information to file for all particles
 	for(i = 0; i < nParticles; i++) {
-		particlesFile << setprecision(15) << i << "\t" << particles[i].weight << "\t"
-					  << particles[i].position[0] << "\t" << particles[i].position[1]
-					  << "\t" << particles[i].position[2];
+		particlesFile << setprecision(15) << i << "\t" << particles.weight[i] << "\t"
+					  << particles.position[0][i] << "\t" << particles.position[1][i]
+					  << "\t" << particles.position[2][i];
 		if(ALLOW_ATTITUDE_SEARCH)
-			particlesFile << setprecision(15) << "\t" << particles[i].attitude[0]
-						  << "\t" << particles[i].attitude[1]
-						  << "\t" << particles[i].attitude[2];
+			particlesFile << setprecision(15) << "\t" << particles.attitude[0][i]
+						  << "\t" << particles.attitude[1][i]
+						  << "\t" << particles.attitude[2][i];
 		if(MOVING_TERRAIN)
-			particlesFile << setprecision(15) << "\t" << particles[i].terrainState[0]
-						  << "\t" << particles[i].terrainState[1]
-						  << "\t" << particles[i].terrainState[2];
+			particlesFile << setprecision(15) << "\t" << particles.terrainState[0][i]
+						  << "\t" << particles.terrainState[1][i]
+						  << "\t" << particles.terrainState[2][i];
 		if(SEARCH_COMPASS_BIAS) {
-			particlesFile << setprecision(15) << "\t" << particles[i].compassBias;
+			particlesFile << setprecision(15) << "\t" << particles.compassBias[i];
 		}
 		if(SEARCH_PSI_BERG) {
-			particlesFile << setprecision(15) << "\t" << particles[i].psiBerg;
+			particlesFile << setprecision(15) << "\t" << particles.psiBerg[i];
 		}
 		if(SEARCH_ALIGN_STATE)
-			particlesFile << setprecision(15) << "\t" << particles[i].alignState[0]
-						  << "\t" << particles[i].alignState[1]
-						  << "\t" << particles[i].alignState[2];
+			particlesFile << setprecision(15) << "\t" << particles.alignState[0][i]
+						  << "\t" << particles.alignState[1][i]
+						  << "\t" << particles.alignState[2][i];
 		if(SEARCH_GYRO_BIAS) {
-			particlesFile << setprecision(15) << "\t" << particles[i].gyroBias[0]
-						  << "\t" << particles[i].gyroBias[1];
+			particlesFile << setprecision(15) << "\t" << particles.gyroBias[0][i]
+						  << "\t" << particles.gyroBias[1][i];
 			if(INTEG_PHI_THETA) {
-				particlesFile << setprecision(15) << "\t" << particles[i].gyroBias[2];
+				particlesFile << setprecision(15) << "\t" << particles.gyroBias[2][i];
 			}
 		}
 		if(SEARCH_DVL_ERRORS)
-			particlesFile << setprecision(15) << "\t" << particles[i].dvlScaleFactor
-						  << "\t" << particles[i].dvlBias[0]
-						  << "\t" << particles[i].dvlBias[1]
-						  << "\t" << particles[i].dvlBias[2];
+			particlesFile << setprecision(15) << "\t" << particles.dvlScaleFactor[i]
+						  << "\t" << particles.dvlBias[0][i]
+						  << "\t" << particles.dvlBias[1][i]
+						  << "\t" << particles.dvlBias[2][i];
 
 		particlesFile << endl;
 
@@ -2389,7 +3038,7 @@ writeParticlesToFile(particleT* particles, ofstream& particlesFile) {
 
 void
 TNavParticleFilter::
-writeHistDistribToFile(particleT* particles, ofstream& particlesFile) {
+writeHistDistribToFile(const particleSetT& particles, ofstream& particlesFile) {
 	int i;
 	double Nmin, Nmax, Emin, Emax, Zmin, Zmax, Phmin, Phmax, Tmin, Tmax, Pmin, Pmax;
 	double dN, dE, dZ, dPh, dT, dP;
@@ -2401,37 +3050,37 @@ writeHistDistribToFile(particleT* particles, ofstream& particlesFile) {
 	getDistBounds(Nmin, Nmax, Emin, Emax);
 
 	//find minimum/maximum particle Depth and Heading
-	Zmin = allParticles[0].position[2];
+	Zmin = allParticles->position[2][0];
 	Zmax = Zmin;
-	Pmin = allParticles[0].attitude[2];
+	Pmin = allParticles->attitude[2][0];
 	if(SEARCH_COMPASS_BIAS) {
-		Pmin += allParticles[0].compassBias;
+		Pmin += allParticles->compassBias[0];
 	}
 	if(SEARCH_PSI_BERG) {
-		Pmin -= allParticles[0].psiBerg;
+		Pmin -= allParticles->psiBerg[0];
 	}
 	Pmax = Pmin;
-	Phmin = allParticles[0].attitude[0];
+	Phmin = allParticles->attitude[0][0];
 	Phmax = Phmin;
-	Tmin = allParticles[0].attitude[1];
+	Tmin = allParticles->attitude[1][0];
 	Tmax = Tmin;
 
 	for(i = 0; i < nParticles; i++) {
-		Zmin = min(Zmin, allParticles[i].position[2]);
-		Zmax = max(Zmax, allParticles[i].position[2]);
-		Phmin = min(Phmin, allParticles[i].attitude[0]);
-		Phmax = max(Phmax, allParticles[i].attitude[0]);
-		Tmin = min(Tmin, allParticles[i].attitude[1]);
-		Tmax = max(Tmax, allParticles[i].attitude[1]);
+		Zmin = min(Zmin, allParticles->position[2][i]);
+		Zmax = max(Zmax, allParticles->position[2][i]);
+		Phmin = min(Phmin, allParticles->attitude[0][i]);
+		Phmax = max(Phmax, allParticles->attitude[0][i]);
+		Tmin = min(Tmin, allParticles->attitude[1][i]);
+		Tmax = max(Tmax, allParticles->attitude[1][i]);
 		if(SEARCH_COMPASS_BIAS) {
-			Pmin = min(Pmin, allParticles[i].attitude[2] + allParticles[i].compassBias);
-			Pmax = max(Pmax, allParticles[i].attitude[2] + allParticles[i].compassBias);
+			Pmin = min(Pmin, allParticles->attitude[2][i] + allParticles->compassBias[i]);
+			Pmax = max(Pmax, allParticles->attitude[2][i] + allParticles->compassBias[i]);
 		} else if(SEARCH_PSI_BERG) {
-			Pmin = min(Pmin, allParticles[i].attitude[2] - allParticles[i].psiBerg);
-			Pmax = max(Pmax, allParticles[i].attitude[2] - allParticles[i].psiBerg);
+			Pmin = min(Pmin, allParticles->attitude[2][i] - allParticles->psiBerg[i]);
+			Pmax = max(Pmax, allParticles->attitude[2][i] - allParticles->psiBerg[i]);
 		} else {
-			Pmin = min(Pmin, allParticles[i].attitude[2]);
-			Pmax = max(Pmax, allParticles[i].attitude[2]);
+			Pmin = min(Pmin, allParticles->attitude[2][i]);
+			Pmax = max(Pmax, allParticles->attitude[2][i]);
 		}
 	}
 
@@ -2468,49 +3117,49 @@ writeHistDistribToFile(particleT* particles, ofstream& particlesFile) {
 	//fill in histogram vectors
 	for(i = 0; i < nParticles; i++) {
 		//fill in likeN
-		int idx = closestPtUniformArray(particles[i].position[0], Nmin, Nmax,
+		int idx = closestPtUniformArray(particles.position[0][i], Nmin, Nmax,
 									numN);
-		likeN(idx + 1) += particles[i].weight;
+		likeN(idx + 1) += particles.weight[i];
 
 		//fill in likeE
-		idx = closestPtUniformArray(particles[i].position[1], Emin, Emax,
+		idx = closestPtUniformArray(particles.position[1][i], Emin, Emax,
 									numE);
-		likeE(idx + 1) += particles[i].weight;
+		likeE(idx + 1) += particles.weight[i];
 
 		//fill in likeZ
-		idx = closestPtUniformArray(particles[i].position[2], Zmin, Zmax,
+		idx = closestPtUniformArray(particles.position[2][i], Zmin, Zmax,
 									numZ);
-		likeZ(idx + 1) += particles[i].weight;
+		likeZ(idx + 1) += particles.weight[i];
 
 		//fill in likePh
-		idx = closestPtUniformArray(particles[i].attitude[0], Phmin, Phmax,
+		idx = closestPtUniformArray(particles.attitude[0][i], Phmin, Phmax,
 									numPh);
-		likePh(idx + 1) += particles[i].weight;
+		likePh(idx + 1) += particles.weight[i];
 
 		//fill in likeT
-		idx = closestPtUniformArray(particles[i].attitude[1], Tmin, Tmax,
+		idx = closestPtUniformArray(particles.attitude[1][i], Tmin, Tmax,
 									numT);
-		likeT(idx + 1) += particles[i].weight;
+		likeT(idx + 1) += particles.weight[i];
 
 		//fill in likeP
 		if(SEARCH_COMPASS_BIAS)
 		{
-			idx = closestPtUniformArray(particles[i].attitude[2]
-						    + particles[i].compassBias, Pmin, Pmax,
+			idx = closestPtUniformArray(particles.attitude[2][i]
+						    + particles.compassBias[i], Pmin, Pmax,
 						    numP);
 		}
 	        else if(SEARCH_PSI_BERG)
 		{
-			idx = closestPtUniformArray(particles[i].attitude[2]
-						    - particles[i].psiBerg, Pmin, Pmax,
+			idx = closestPtUniformArray(particles.attitude[2][i]
+						    - particles.psiBerg[i], Pmin, Pmax,
 						    numP);
 		}
 		else
 		{
-			idx = closestPtUniformArray(particles[i].attitude[2], Pmin, Pmax,
+			idx = closestPtUniformArray(particles.attitude[2][i], Pmin, Pmax,
 										numP);
 		}
-		likeP(idx + 1) += particles[i].weight;
+		likeP(idx + 1) += particles.weight[i];
 	}
 
 	//write histogram information to file
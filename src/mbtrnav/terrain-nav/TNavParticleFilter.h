@@ -36,9 +36,12 @@
 #include <fstream>
 #include <iomanip>
 #include <time.h>
+#include <stdint.h>
 #include <vector>
 
 //class TNavPFLog;
+class PFThreadPool;
+class TerrainMapDEM;
 
 
 
@@ -128,6 +131,52 @@ struct particleT {
 
 };
 
+/*!particleSetT holds a whole particle distribution as one contiguous array
+ * per state, so the filter loops stream through memory rather than striding
+ * over particleT records. weight, position and attitude are always present.
+ * The optional states are only allocated when the genFilterDefs.h switch
+ * that enables them is set, and are NULL otherwise. particleT remains the
+ * type used to pass single particles in and out of the set.*/
+struct particleSetT {
+  int size;                    //number of particles allocated
+  double* weight;
+  double* position[3];         //N,E,D
+  double* attitude[3];         //phi, theta, psi
+  double* terrainState[3];     //MOVING_TERRAIN
+  double* alignState[3];       //SEARCH_ALIGN_STATE
+  double* gyroBias[3];         //SEARCH_GYRO_BIAS
+  double* compassBias;         //SEARCH_COMPASS_BIAS
+  double* psiBerg;             //SEARCH_PSI_BERG
+  double* dvlScaleFactor;      //SEARCH_DVL_ERRORS
+  double* dvlBias[3];          //SEARCH_DVL_ERRORS
+  double* windowedNis;         //NIS_WINDOW_LENGTH values per particle
+  unsigned int* windowIndex;
+
+  particleSetT();
+  ~particleSetT();
+
+  //!(Re)allocates the arrays for n particles, all states set to zero
+  void allocate(int n);
+
+  //!Copies particle i into/out of a particleT; absent states read as zero
+  void getParticle(int i, particleT& particle) const;
+  void setParticle(int i, const particleT& particle);
+
+  /*!Sets particle m to particle index[m] of src for m = 0..n-1, one state
+   * array at a time*/
+  void gather(const particleSetT& src, const int* index, int n);
+
+ private:
+  void release();
+
+  double* storage;
+  int nColumns;
+  double* columns[32];
+
+  particleSetT(const particleSetT&);
+  particleSetT& operator=(const particleSetT&);
+};
+
 /*!
  * Class: TNavParticleFilter
  * 
@@ -220,6 +269,21 @@ class TNavParticleFilter : public TNavFilter
 	bool getExpectedMeasDiffParticle(particleT& particle, const Matrix& beamsSF, 
 								double* beamRanges, const int* beamIndices, double& mapVar);
 
+	/*! As above, but the per-beam usable flags are written to useBeamOut
+	 * rather than to this->tempUseBeam, so that several particles may be
+	 * processed at once.
+	 */
+	bool getExpectedMeasDiffParticle(particleT& particle, const Matrix& beamsSF,
+								double* beamRanges, const int* beamIndices, double& mapVar,
+								bool* useBeamOut);
+
+	/*! As above, for particle i of the current distribution. The differences
+	 * are written to its row of measDiff.
+	 */
+	bool getExpectedMeasDiffParticle(int i, const Matrix& beamsSF,
+								double* beamRanges, const int* beamIndices, double& mapVar,
+								bool* useBeamOut);
+
 
   /* Function: motionUpdate
    * Usage: motionUpdate(currNavPose);
@@ -272,7 +336,9 @@ class TNavParticleFilter : public TNavFilter
   /* Function: getParticles()
    * Usage: getParticles(curParticles)
    * -------------------------------------------------------------------------*/
-  /*! Extracts the current particle distribution for access by outside functions
+  /*! Extracts the current particle distribution for access by outside functions.
+   * The particles are copied out of the filter's particle set, so the array is
+   * only valid until the next call.
    */
   particleT* getParticles();
     
@@ -340,7 +406,105 @@ class TNavParticleFilter : public TNavFilter
    * Uses terrain motion information stored by the particle.
    */
   void motionUpdateParticle(particleT& particle, const poseT& diffPose,
-			    double* velocity_sf_sigma, const double& gyroStddev);   
+			    double* velocity_sf_sigma, const double& gyroStddev,
+			    trnRandState* rng = NULL);
+
+  /* Function: motionUpdateParticles
+   * Usage: motionUpdateParticles(0, nParticles, diffPose, velocity_sf_sigma,
+   * gyroStddev, rng);
+   * -------------------------------------------------------------------------*/
+  /*! Applies the motion update to particles begin..end-1 of allParticles.
+   * When none of the optional states are searched over, every particle moves
+   * by the same displacement plus noise. The noise is then drawn in the order
+   * motionUpdateParticle() draws it and applied to whole state arrays at
+   * once; otherwise each particle goes through motionUpdateParticle().
+   */
+  void motionUpdateParticles(int begin, int end, const poseT& diffPose,
+			     double* velocity_sf_sigma, const double& gyroStddev,
+			     trnRandState* rng);
+
+  /* Function: motionDriftStddev
+   * Usage: driftStddev = motionDriftStddev(diffPose);
+   * -------------------------------------------------------------------------*/
+  /*! Standard deviation of the position noise added to an inertial
+   * displacement, from the vehicle INS drift rate.
+   */
+  double motionDriftStddev(const poseT& diffPose);
+
+  /* Function: computeMeasDiff
+   * Usage: goodBeams = computeMeasDiff(position, attitude, alignState,
+   * compassBias, beamsSF, beamRanges, beamIndices, mapVar, measDiffOut,
+   * useBeamOut);
+   * -------------------------------------------------------------------------*/
+  /*! The expected measurement difference calculation shared by the
+   * getExpectedMeasDiffParticle() variants, for a particle with the given
+   * states. alignState is only read when SEARCH_ALIGN_STATE is set.
+   */
+  bool computeMeasDiff(const double* position, const double* attitude,
+		       const double* alignState, double compassBias,
+		       const Matrix& beamsSF, double* beamRanges,
+		       const int* beamIndices, double& mapVar,
+		       double* measDiffOut, bool* useBeamOut);
+
+  /* Function: particleMeasDiff
+   * Usage: diff = particleMeasDiff(i);
+   * -------------------------------------------------------------------------*/
+  /*! The expected measurement differences of particle i from the last
+   * measurement update, one per beam used.
+   */
+  double* particleMeasDiff(int i) { return &measDiff[i * measDiffStride]; }
+
+  /* Function: batchMeasMap
+   * Usage: dem = batchMeasMap();
+   * -------------------------------------------------------------------------*/
+  /*! The DEM to use with expectedMeasDiffBatch(), or NULL when the expected
+   * measurements have to be computed one particle at a time. Batching needs
+   * a DEM and the same map frame beams for every particle, i.e. no attitude,
+   * alignment or psi berg search.
+   */
+  TerrainMapDEM* batchMeasMap();
+
+  /* Function: expectedMeasDiffBatch
+   * Usage: expectedMeasDiffBatch(dem, begin, end, beamsMF, beamRanges,
+   * beamIndices);
+   * -------------------------------------------------------------------------*/
+  /*! Fills the measDiff rows of particles begin..end-1 with a single batched
+   * map query per block of particles, and the map variance of each
+   * difference into measMapVar.
+   */
+  void expectedMeasDiffBatch(TerrainMapDEM* dem, int begin, int end,
+			     const Matrix& beamsMF, const double* beamRanges,
+			     const int* beamIndices);
+
+  /* Function: getBatchedMeasDiffParticle
+   * Usage: goodBeams = getBatchedMeasDiffParticle(i, mapVar, useBeamOut);
+   * -------------------------------------------------------------------------*/
+  /*! Counterpart of getExpectedMeasDiffParticle() for a particle whose
+   * differences came from expectedMeasDiffBatch(): sets the per-beam usable
+   * flags and mapVar, and returns false if none of the beams can be used.
+   */
+  bool getBatchedMeasDiffParticle(int i, double& mapVar, bool* useBeamOut);
+
+  /* Function: expectedMeasDiffParallel
+   * Usage: badParticle = expectedMeasDiffParallel(beamsVF, tempBeamsVF,
+   * attitude, currMeas, beamIndices, mapVar);
+   * -------------------------------------------------------------------------*/
+  /*! Threaded version of the expected measurement difference loop in
+   * measUpdate(). Particles are processed in fixed size chunks by the thread
+   * pool and the per-chunk beam usage and map variance are merged in particle
+   * order, so the outcome matches the serial loop. Returns the index of the
+   * first particle with no usable beams, or -1.
+   */
+  int expectedMeasDiffParallel(Matrix& beamsVF, const Matrix& tempBeamsVF,
+			       const double* attitude, measT& currMeas, const int* beamIndices,
+			       double& mapVar);
+
+  /* Function: logBadParticle
+   * Usage: logBadParticle(i, currMeas.time);
+   * -------------------------------------------------------------------------*/
+  /*! Logs the state of a particle for which no beam could be used.
+   */
+  void logBadParticle(int i, double measTime);
 
   /* Function: resampParticleDist
    * Usage: resampParticleDist();
@@ -368,10 +532,10 @@ class TNavParticleFilter : public TNavFilter
   /* Function: getParticlePose
    * Usage: getParticlePose(particle, particlePose);
    * -------------------------------------------------------------------------*/
-  /*! Fills in the poseT object, particlePose, with the pose of the particle
-   * pointed to by particle.  Pose particle particle pose pose particle pose.
+  /*! Fills in the poseT object, particlePose, with the pose of particle i
+   * of the current distribution.
    */
-  void getParticlePose(const particleT& particle, poseT* particlePose);
+  void getParticlePose(int i, poseT* particlePose);
 
 
   /* Function: updateParticleDist()
@@ -396,9 +560,9 @@ class TNavParticleFilter : public TNavFilter
   /* Function: computeInnovationsMatrices()
    * Usage: computeInnovationsMatrices();
    * -------------------------------------------------------------------------*/
-  /*! Computes the innovations matrix and mean innovation based on expectedMeasDiff.  
+  /*! Computes the innovations matrix and mean innovation based on measDiff.
    */
-  void computeInnovationsMatrices(particleT* particles, SymmetricMatrix &measVarMat, ColumnVector &measDiff);
+  void computeInnovationsMatrices(SymmetricMatrix &measVarMat, ColumnVector &measDiffMean);
 
 
   /* Function: plotMapMatlab
@@ -424,7 +588,7 @@ class TNavParticleFilter : public TNavFilter
    * Matlab commands that would be typed into the command window, 
    * i.e. "figure(1);".
    */
-  void plotParticleDistMatlab(particleT* particles, const char* figureNum);
+  void plotParticleDistMatlab(const particleSetT& particles, const char* figureNum);
 
   
   /* Function: plotBeamMatlab
@@ -451,7 +615,7 @@ class TNavParticleFilter : public TNavFilter
    * This function thus adds a data block of size Mx11 to the end of the 
    * current file stream, where M is the size of the "particles" array.
    */
-  void writeParticlesToFile(particleT* particles, ofstream &particlesFile);
+  void writeParticlesToFile(const particleSetT& particles, ofstream &particlesFile);
 
 
   /* Function: writeHistDistribToFile
@@ -468,7 +632,7 @@ class TNavParticleFilter : public TNavFilter
    * This function thus adds a data block of size 4xN to the end of the 
    * current file stream, where N is the number of histogram bins.
    */
-  void writeHistDistribToFile(particleT* particles, ofstream &particlesFile);
+  void writeHistDistribToFile(const particleSetT& particles, ofstream &particlesFile);
 
   
 		//TODO: Are we still going to do all this submap stuff?
@@ -491,15 +655,29 @@ class TNavParticleFilter : public TNavFilter
   //Private structures and components of a TNavParticleFilter object:
   /*********************************************************/
  
-  //! particle array for swapping during resampling
-  particleT particleArray1[MAX_PARTICLES];
-  
-  //!resampled particle array
-  particleT particleArray2[MAX_PARTICLES];
+  //! particle set for swapping during resampling
+  particleSetT particleSet1;
+
+  //!resampled particle set
+  particleSetT particleSet2;
+
+  //!pointers to particle and resampled particle sets
+  particleSetT* allParticles;
+  particleSetT* resampParticles;
+
+  /*!expected measurement differences of the last measurement update,
+   * measDiffStride (the number of beams used) values per particle*/
+  std::vector<double> measDiff;
+  int measDiffStride;
 
-  //!pointers to particle and resampled particle arrays
-  particleT* allParticles;
-  particleT* resampParticles;
+  //!map variance of each entry of measDiff when computed in a batch
+  std::vector<double> measMapVar;
+
+  //!particles resampled into each slot of resampParticles
+  std::vector<int> resampIndex;
+
+  //!copy of the distribution handed out by getParticles()
+  std::vector<particleT> particleExport;
   
   //!int keeping track of how many particles the filter is using
   int nParticles;
@@ -537,6 +715,17 @@ class TNavParticleFilter : public TNavFilter
   bool* tempUseBeam;
   bool* useBeam;
 
+  //!number of threads used for the measurement and motion updates
+  int nThreads;
+
+  //!thread pool for the particle updates (NULL when running serially)
+  PFThreadPool* threadPool;
+
+  /*!base seed for the per-chunk random number generators used by the
+   * threaded motion update, and the count of motion updates mixed into it*/
+  uint64_t rngSeed;
+  uint64_t nMotionUpdates;
+
   double navData_x_, navData_y_;
 
   TNavPFLog  *pfLog;
@@ -1,11 +1,16 @@
 #include "TerrainMapDEM.h"
 
+#include <algorithm>
 #include <iostream>
 #include <cmath>
+#include <limits>
 #include "mapio.h"
 #include "genFilterDefs.h"
 #include "trn_log.h"
 
+//number of points interpolated together by interpolateDepths()
+#define MAP_BATCH_SIZE 256
+
 
 double
 TerrainMapDEM::
@@ -64,6 +69,64 @@ GetRangeError(double& mapVariance, const double* const startPoint, const double*
 	}
     return rangeError;
 }
+
+void
+TerrainMapDEM::
+GetRangeErrors(int nStarts, const double* startN, const double* startE, const double* startZ, int nBeams, const double* beamN, const double* beamE, const double* beamZ, const double* ranges, double* rangeErrors, double* mapVariances) {
+	int i, j, k;
+
+	//Ray tracing is done one beam at a time
+	if(USE_RANGE_CORR) {
+		for(i = 0; i < nStarts; i++) {
+			double startPoint[3] = {startN[i], startE[i], startZ[i]};
+			for(j = 0; j < nBeams; j++) {
+				double directionVector[3] = {beamN[j], beamE[j], beamZ[j]};
+				k = i * nBeams + j;
+				rangeErrors[k] = GetRangeError(mapVariances[k], startPoint, directionVector, ranges[j]);
+			}
+		}
+		return;
+	}
+
+	// Projection Method, as in GetRangeError()
+	double queryN[MAP_BATCH_SIZE], queryE[MAP_BATCH_SIZE], queryZ[MAP_BATCH_SIZE];
+	double mapZ[MAP_BATCH_SIZE];
+	int nQueries = 0;
+	int first = 0;
+
+	auto flush = [&]() {
+		interpolateDepths(nQueries, queryN, queryE, mapZ, &mapVariances[first]);
+		for(int q = 0; q < nQueries; q++) {
+			double rangeError;
+			if(!ISNIN(mapZ[q]) && !ISNIN(queryZ[q])) {
+				rangeError = queryZ[q] - mapZ[q];
+			} else {
+				rangeError = 0;
+				if(!USE_MAP_NAN) {
+					rangeError = ISNIN(mapZ[q]) ? mapZ[q] : queryZ[q];
+				}
+			}
+			rangeErrors[first + q] = rangeError;
+		}
+		first += nQueries;
+		nQueries = 0;
+	};
+
+	for(i = 0; i < nStarts; i++) {
+		for(j = 0; j < nBeams; j++) {
+			queryN[nQueries] = startN[i] + beamN[j];
+			queryE[nQueries] = startE[i] + beamE[j];
+			queryZ[nQueries] = startZ[i] + beamZ[j];
+			if(++nQueries == MAP_BATCH_SIZE) {
+				flush();
+			}
+		}
+	}
+	if(nQueries > 0) {
+		flush();
+	}
+}
+
 /*
 double
 TerrainMapDEM::
@@ -412,6 +475,175 @@ interpolateDepth(double xi, double yi, double& zi, double& var) {
 	return;
 }
 
+void
+TerrainMapDEM::
+interpolateDepths(int n, const double* north, const double* east, double* depths, double* variances) {
+	int i, k;
+
+	//Check that a map has been extracted
+	if(this->map.xpts == NULL) {
+		logs(TL_OMASK(TL_TERRAIN_MAP_DEM, TL_LOG),"ERROR: tried to access map values without first extracting map"
+			   " information");
+		for(i = 0; i < n; i++) {
+			depths[i] = std::numeric_limits<double>::quiet_NaN();
+			variances[i] = std::numeric_limits<double>::quiet_NaN();
+		}
+		return;
+	}
+
+	//Only nearest-neighbor and bilinear interpolation use the tile grid
+	if(this->tileGrid.numCellX == 0 ||
+	   (this->interpMapMethod != 0 && this->interpMapMethod != 1)) {
+		for(i = 0; i < n; i++) {
+			interpolateDepth(north[i], east[i], depths[i], variances[i]);
+		}
+		return;
+	}
+
+	const mapTileGridT& grid = this->tileGrid;
+	const double* xpts = this->map.xpts;
+	const double* ypts = this->map.ypts;
+	const int numX = this->map.numX;
+	const int numY = this->map.numY;
+
+	//points of the current block that the tile grid can not answer
+	bool fallback[MAP_BATCH_SIZE];
+	int offset[MAP_BATCH_SIZE];
+
+	for(int block = 0; block < n; block += MAP_BATCH_SIZE) {
+		const int m = std::min(MAP_BATCH_SIZE, n - block);
+		const double* xi = north + block;
+		const double* yi = east + block;
+		double* zi = depths + block;
+		double* var = variances + block;
+
+		if(this->interpMapMethod == 0) {
+			for(i = 0; i < m; i++) {
+				int x = closestPtUniformArray(xi[i], xpts[0], xpts[numX - 1], numX);
+				int y = closestPtUniformArray(yi[i], ypts[0], ypts[numY - 1], numY);
+				offset[i] = grid.pointOffset(x, y);
+				zi[i] = grid.depths[offset[i]];
+				fallback[i] = ISNIN(zi[i]);
+				if(!fallback[i]) {
+					//weight variance based on distance of nearest point to
+					//the interpolation point
+					double h_sq = pow(xpts[x] - xi[i], 2) + pow(ypts[y] - yi[i], 2);
+					var[i] = grid.variances[offset[i]] + evalVariogram(sqrt(h_sq));
+				}
+			}
+		} else {
+			double t[MAP_BATCH_SIZE], u[MAP_BATCH_SIZE];
+			double z[4][MAP_BATCH_SIZE], v[4][MAP_BATCH_SIZE];
+
+			//find the cell holding each point, as bilinearInterp() does
+			for(i = 0; i < m; i++) {
+				int x1 = lowerBound(xi[i], xpts, numX);
+				int y1 = lowerBound(yi[i], ypts, numY);
+				fallback[i] = (x1 >= numX - 1) || (x1 < 0) || (y1 >= numY - 1) || (y1 < 0);
+				if(fallback[i]) {
+					x1 = 0;
+					y1 = 0;
+				}
+				offset[i] = grid.cellOffset(x1, y1);
+				t[i] = (xi[i] - xpts[x1]) / (xpts[x1 + 1] - xpts[x1]);
+				u[i] = (yi[i] - ypts[y1]) / (ypts[y1 + 1] - ypts[y1]);
+			}
+
+			//gather the cell corners
+			for(i = 0; i < m; i++) {
+				for(k = 0; k < 4; k++) {
+					z[k][i] = grid.depths[offset[i] + k];
+					v[k][i] = grid.variances[offset[i] + k];
+				}
+			}
+
+			//interpolate the depths and their variance, as bilinearInterp()
+			//and computeInterpDepthVariance() do
+			for(i = 0; i < m; i++) {
+				double w0 = (1 - t[i]) * (1 - u[i]);
+				double w1 = t[i] * (1 - u[i]);
+				double w2 = t[i] * u[i];
+				double w3 = (1 - t[i]) * u[i];
+
+				double z0 = z[0][i], z1 = z[1][i], z2 = z[2][i], z3 = z[3][i];
+				double depth = w0 * z0;
+				depth += w1 * z1;
+				depth += w2 * z2;
+				depth += w3 * z3;
+				zi[i] = depth;
+
+				double pointVar = w0 * v[0][i] + w1 * v[1][i] + w2 * v[2][i] + w3 * v[3][i];
+				double crossVar =
+					w0 * w1 * (0.5 * (z0 - z1) * (z0 - z1) - grid.variogramX) +
+					w0 * w2 * (0.5 * (z0 - z2) * (z0 - z2) - grid.variogramXY) +
+					w0 * w3 * (0.5 * (z0 - z3) * (z0 - z3) - grid.variogramY) +
+					w1 * w2 * (0.5 * (z1 - z2) * (z1 - z2) - grid.variogramY) +
+					w1 * w3 * (0.5 * (z1 - z3) * (z1 - z3) - grid.variogramXY) +
+					w2 * w3 * (0.5 * (z2 - z3) * (z2 - z3) - grid.variogramX);
+				double totalVar = pointVar + 2.0 * crossVar;
+
+				//check that the variance is positive and finite
+				var[i] = (ISNIN(totalVar) || totalVar < 0) ? pointVar : totalVar;
+			}
+
+			for(i = 0; i < m; i++) {
+				fallback[i] = fallback[i] || ISNIN(zi[i]);
+			}
+		}
+
+		//NaN searches and the low resolution map go the long way
+		for(i = 0; i < m; i++) {
+			if(fallback[i]) {
+				interpolateDepth(xi[i], yi[i], zi[i], var[i]);
+			}
+		}
+	}
+}
+
+void
+mapTileGridT::
+build(const mapT& map) {
+	int x, y;
+
+	clear();
+	if(map.xpts == NULL || map.numX < 2 || map.numY < 2 ||
+	   map.depths.Nrows() != map.numX || map.depths.Ncols() != map.numY ||
+	   map.depthVariance.Nrows() != map.numX || map.depthVariance.Ncols() != map.numY) {
+		return;
+	}
+
+	numCellX = map.numX - 1;
+	numCellY = map.numY - 1;
+	numTileY = (numCellY + MAP_TILE_DIM - 1) >> MAP_TILE_SHIFT;
+	int numTileX = (numCellX + MAP_TILE_DIM - 1) >> MAP_TILE_SHIFT;
+	size_t size = 4 * size_t(numTileX * numTileY) << (2 * MAP_TILE_SHIFT);
+	depths.assign(size, std::numeric_limits<float>::quiet_NaN());
+	variances.assign(size, 0.0);
+
+	//the depths and variances are stored row major, one row per north point
+	const double* z = map.depths.Store();
+	const double* v = map.depthVariance.Store();
+	for(x = 0; x < numCellX; x++) {
+		for(y = 0; y < numCellY; y++) {
+			int offset = cellOffset(x, y);
+			int corner[4] = {x * map.numY + y, (x + 1) * map.numY + y,
+							 (x + 1) * map.numY + y + 1, x * map.numY + y + 1};
+			for(int k = 0; k < 4; k++) {
+				depths[offset + k] = float(z[corner[k]]);
+				variances[offset + k] = v[corner[k]];
+			}
+		}
+	}
+
+	//variogram between the corners of a cell, which only depends on the
+	//grid spacing
+	double dx = map.xpts[1] - map.xpts[0];
+	double dy = map.ypts[1] - map.ypts[0];
+	variogramX = evalVariogram(sqrt(dx * dx));
+	variogramY = evalVariogram(sqrt(dy * dy));
+	variogramXY = evalVariogram(sqrt(dx * dx + dy * dy));
+}
+
 double
 TerrainMapDEM::
 getNearestLowResMapPoint(const double north, const double east, double& nearestNorth, double& nearestEast) {
@@ -510,6 +742,7 @@ extractSubMap(const double north, const double east, double* mapParams) {
 		//load variance map data
 		extractVarMap(north, east, mapParams);
 	}
+	this->tileGrid.build(this->map);
 
 	mapdata_free(data, 1);
 	return statusCode;
@@ -636,82 +869,20 @@ interpolateDepthMat(double* xi, double* yi, Matrix& zi, Matrix& var) {
 
 	int N = zi.Nrows();
 	int M = zi.Ncols();
-	int numPts, i, j;
-	ColumnVector W;
-	int* xIndices = NULL;
-	int* yIndices = NULL;
-	double h_sq;
-
-	//define pointer to an interpolation function
-	void (*pt2interpFunction)(double*, double*, const Matrix&, double, double,
-							  double&, int*, int*, ColumnVector&) = NULL;
-
-	//determine number of interpolation points and proper interpolation function
-	switch(this->interpMapMethod) {
-		case 0:
-			numPts = 1;
-			pt2interpFunction = &nearestInterp;
-			break;
-
-		case 1:
-			numPts = 4;
-			pt2interpFunction = &bilinearInterp;
-			break;
-
-		case 2:
-			numPts = 16;
-			pt2interpFunction = &bicubicInterp;
-			break;
-
-		case 3:
-			numPts = 16;
-			pt2interpFunction = &splineInterp;
-			break;
-
-		default:
-			numPts = 1;
-			pt2interpFunction = &nearestInterp;
-			break;
-	}
-
-	//initialize indices arrays and Weights matrix
-	xIndices = new int[numPts];
-	yIndices = new int[numPts];
-	W.ReSize(numPts);
+	int i, j;
+	std::vector<double> north(M), depths(M), variances(M);
 
+	//interpolate one row of hypotheses at a time
 	for(i = 0; i < N; i++) {
 		for(j = 0; j < M; j++) {
-			(*pt2interpFunction)(this->map.xpts, this->map.ypts,
-								 this->map.depths, xi[i], yi[j], zi(i + 1, j + 1)
-								 , xIndices, yIndices, W);
-			//If returned depth is NaN, extract data from low resolution map
-			// if(isnan(zi(i + 1, j + 1)) && this->refMap->lowResSrc != NULL) {
-			if(ISNIN(zi(i + 1, j + 1)) && this->refMap->lowResSrc != NULL) {
-				double xPt, yPt;
-				zi(i + 1, j + 1) = this->getNearestLowResMapPoint(xi[i], yi[j],
-								   xPt, yPt);
-				h_sq = pow(xPt - xi[i], 2) + pow(yPt - yi[j], 2);
-				var(i + 1, j + 1) = this->map.depthVariance(xIndices[0] + 1,
-									yIndices[0] + 1) +
-									evalVariogram(sqrt(h_sq));
-			} else {
-				//Compute variance associated with interpolation method
-				if(W.Nrows() == 1) {
-					//If only using nearest neighbor, weight variance based on
-					//distance of nearest point to the interpolation point
-					h_sq = pow(this->map.xpts[xIndices[0]] - xi[i], 2) +
-						   pow(this->map.ypts[yIndices[0]] - yi[j], 2);
-					var(i + 1, j + 1) = this->map.depthVariance(xIndices[0] + 1,
-										yIndices[0] + 1)
-										+ evalVariogram(sqrt(h_sq));
-				} else {
-					var(i + 1, j + 1) = computeInterpDepthVariance(xIndices, yIndices, W);
-				}
-			}
+			north[j] = xi[i];
+		}
+		interpolateDepths(M, north.data(), yi, depths.data(), variances.data());
+		for(j = 0; j < M; j++) {
+			zi(i + 1, j + 1) = depths[j];
+			var(i + 1, j + 1) = variances[j];
 		}
 	}
-	delete [] xIndices;
-	delete [] yIndices;
 
 	return;
 }
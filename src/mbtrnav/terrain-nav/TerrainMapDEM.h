@@ -1,5 +1,7 @@
 #ifndef TerrainMapDEM_H
 
+#include <vector>
+
 #include "TerrainMap.h"
 #include "mapio.h"
 
@@ -41,6 +43,55 @@ struct refMapT{
 };
 
 
+/*
+mapTileGridT is a copy of the extracted sub-map laid out for batched
+interpolation. Each grid cell keeps the depths and variances of its four
+corners together, in the order used by bilinearInterp(): (x, y), (x+1, y),
+(x+1, y+1), (x, y+1). The cells are stored in square tiles of MAP_TILE_DIM
+cells a side so that the queries of a compact particle cloud touch few cache
+lines. Depths are kept as float, the precision of the source grid.
+*/
+#define MAP_TILE_SHIFT 3
+#define MAP_TILE_DIM (1 << MAP_TILE_SHIFT)
+
+struct mapTileGridT{
+	std::vector<float> depths;
+	std::vector<double> variances;
+	int numCellX, numCellY;
+	int numTileY;
+	double variogramX, variogramY, variogramXY;
+
+	mapTileGridT(){
+		numCellX = 0;
+		numCellY = 0;
+		numTileY = 0;
+		variogramX = variogramY = variogramXY = 0.;
+	}
+
+	void build(const mapT& map);
+	void clear(){
+		depths.clear();
+		variances.clear();
+		numCellX = numCellY = numTileY = 0;
+	}
+
+	//offset of the four corners of cell (x, y)
+	int cellOffset(int x, int y) const{
+		int tile = (x >> MAP_TILE_SHIFT) * numTileY + (y >> MAP_TILE_SHIFT);
+		int cell = ((x & (MAP_TILE_DIM - 1)) << MAP_TILE_SHIFT) + (y & (MAP_TILE_DIM - 1));
+		return 4 * ((tile << (2 * MAP_TILE_SHIFT)) + cell);
+	}
+
+	//offset of grid point (x, y) as a corner of one of its cells
+	int pointOffset(int x, int y) const{
+		int cx = x < numCellX ? x : x - 1;
+		int cy = y < numCellY ? y : y - 1;
+		static const int corner[2][2] = {{0, 3}, {1, 2}};
+		return cellOffset(cx, cy) + corner[x - cx][y - cy];
+	}
+};
+
+
 /*
 TerrainMapDEM pulls together the functionality written for DEM maps into a single class and makes 
 it work through the same interface as the Octree version of TerrainMap.
@@ -70,6 +121,33 @@ class TerrainMapDEM : public TerrainMap{
 		
 		double Getdx(void){return refMap->bounds->dx;}
 		double Getdy(void){return refMap->bounds->dy;}
+
+		/* Function: interpolateDepths
+		 * Usage: interpolateDepths(n, north, east, depths, variances)
+		 * ----------------------------------------------------------------*/
+		/*! Batch version of interpolateDepth() for the n points
+		 * (north[i], east[i]). Nearest-neighbor and bilinear interpolation
+		 * are done from the tiled copy of the sub-map; points that need a
+		 * NaN search or the low resolution map, and the other
+		 * interpolation methods, go through interpolateDepth().
+		 */
+		void interpolateDepths(int n, const double* north, const double* east,
+							   double* depths, double* variances);
+
+		/* Function: GetRangeErrors
+		 * Usage: GetRangeErrors(nStarts, startN, startE, startZ, nBeams,
+		 *                       beamN, beamE, beamZ, ranges, errors, vars)
+		 * ----------------------------------------------------------------*/
+		/*! GetRangeError() for every combination of the nStarts start
+		 * points and the nBeams direction vectors. The range error and map
+		 * variance of start i and beam j are written to element
+		 * i * nBeams + j of rangeErrors and mapVariances. ranges holds the
+		 * measured distance of each beam.
+		 */
+		void GetRangeErrors(int nStarts, const double* startN, const double* startE,
+							const double* startZ, int nBeams, const double* beamN,
+							const double* beamE, const double* beamZ, const double* ranges,
+							double* rangeErrors, double* mapVariances);
 		
 	private:
 		bool computeMapRayIntersection(const double* position, double *u, double& r, double &var);   
@@ -86,6 +164,7 @@ class TerrainMapDEM : public TerrainMap{
 		//were public
 		mapT map;
 		refMapT* refMap;
+		mapTileGridT tileGrid;
 		
 		
 		
@@ -8,6 +8,11 @@
 // Documentation is formatted for HeaderDoc or HeaderBrowser
 
 #include "mapio.h"
+#include <mutex>
+
+// The netCDF library is not thread safe. Point lookups may come from
+// several particle filter threads at once, so they are serialized here.
+static std::mutex mapsrc_nc_mutex;
 
 
 //TODO this function fails to print which file or directory doesn't exist, making its error message near useless.
@@ -154,7 +159,10 @@ float mapsrc_find(struct mapsrc* src, double x, double y) {
             count[XI] = 1;
             count[YI] = 1;
             float *z = (float*) malloc(count[YI] * count[XI] * sizeof(float));
-            check_error(nc_get_vara_float(src->ncid, src->zid, start, count, z), src);
+            {
+                std::lock_guard<std::mutex> lock(mapsrc_nc_mutex);
+                check_error(nc_get_vara_float(src->ncid, src->zid, start, count, z), src);
+            }
             z_out = *z;
             free(z);
         }
@@ -19,6 +19,7 @@
 
 #include "math.h"
 #include "string.h"
+#include <stdint.h>
 #include <fstream>
 
 #include <newmatap.h>
@@ -408,6 +409,108 @@ inline double randn_zeroMean(const double& stddev)
 }
 
 
+/* Struct: trnRandState
+ * -------------------------------------------------------------------------*/
+/*! Private generator state for the reentrant random number functions below.
+ *  Each thread drawing random numbers owns one of these, so that the
+ *  sequence it sees depends only on its seed and not on how the work is
+ *  shared among threads. The generator is xorshift64*.
+ */
+struct trnRandState
+{
+   uint64_t s;
+   bool use_last;
+   double gauss2;
+};
+
+
+/* Function: trn_rand_seed
+ * Usage: trn_rand_seed(&state, seed);
+ * -------------------------------------------------------------------------*/
+/*! Seeds a trnRandState. The seed is passed through a splitmix64 step so
+ *  that nearby seeds (e.g. consecutive chunk indices) give unrelated
+ *  sequences.
+ */
+inline void trn_rand_seed(trnRandState* state, uint64_t seed)
+{
+   uint64_t z = seed + 0x9E3779B97F4A7C15ULL;
+   z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+   z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+   z = z ^ (z >> 31);
+   state->s = (z != 0) ? z : 0x9E3779B97F4A7C15ULL;
+   state->use_last = false;
+   state->gauss2 = 0.;
+}
+
+
+/* Function: trn_rand_unif
+ * Usage: trn_rand_unif(&state);
+ * -------------------------------------------------------------------------*/
+/*! Generates a pseudorandom number on the interval (0,1] from a private
+ *  generator state.
+ */
+inline double trn_rand_unif(trnRandState* state)
+{
+   state->s ^= state->s >> 12;
+   state->s ^= state->s << 25;
+   state->s ^= state->s >> 27;
+   uint64_t r = state->s * 0x2545F4914F6CDD1DULL;
+   return ((r >> 11) + 1)*(1.0/9007199254740992.0);
+}
+
+
+/* Function: unif_zeroMean
+ * Usage: unif_zeroMean(halfInterval, &state);
+ * -------------------------------------------------------------------------*/
+/*! Reentrant version of unif_zeroMean(halfInterval) drawing from a private
+ *  generator state. A NULL state uses the global generator.
+ */
+inline double unif_zeroMean(const double& halfInterval, trnRandState* state)
+{
+   if (state == NULL)
+      return unif_zeroMean(halfInterval);
+
+   return 2.0*halfInterval*trn_rand_unif(state) - halfInterval;
+}
+
+
+/* Function: randn_zeroMean
+ * Usage: randn_zeroMean(stddev, &state);
+ * -------------------------------------------------------------------------*/
+/*! Reentrant version of randn_zeroMean(stddev) drawing from a private
+ *  generator state. The spare gaussian variable is kept in the state
+ *  rather than in a static. A NULL state uses the global generator.
+ */
+inline double randn_zeroMean(const double& stddev, trnRandState* state)
+{
+   if (state == NULL)
+      return randn_zeroMean(stddev);
+
+   double gauss1;
+   if (state->use_last)
+   {
+      gauss1 = state->gauss2;
+      state->use_last = false;
+   }
+   else
+   {
+      double rand1, rand2, w;
+      do {
+         rand1 = 2.0*trn_rand_unif(state) - 1.0;
+         rand2 = 2.0*trn_rand_unif(state) - 1.0;
+         w = rand1*rand1 + rand2*rand2;
+      } while ( w >= 1.0 || w == 0.0 );
+
+      w = sqrt(-2.0*log(w)/w);
+      gauss1 = rand1 * w;
+      state->gauss2 = rand2 * w;
+      state->use_last = true;
+   }
+
+   return (stddev*gauss1);
+}
+
+
 /* Function: charCat
  * Usage: fileName = charCat(fileName, directory, file)
  * -------------------------------------------------------------------------*/
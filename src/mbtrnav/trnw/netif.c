@@ -266,6 +266,7 @@ static bool s_peer_idval_cmp(void *item, void *value)
                 }
 
                 MST_METRIC_LAP(self->profile->stats->metrics[NETIF_CH_HANDLE_XT], mtime_dtime());
+                MST_HIST_LAP(self->hist, self->profile->stats->metrics[NETIF_CH_HANDLE_XT].start, mtime_dtime());
             }
 
             break;
@@ -511,6 +512,7 @@ int netif_reqres(netif_t *self)
                 }// else handle msg OK
 
                 MST_METRIC_LAP(self->profile->stats->metrics[NETIF_CH_HANDLE_XT], mtime_dtime());
+                MST_HIST_LAP(self->hist, self->profile->stats->metrics[NETIF_CH_HANDLE_XT].start, mtime_dtime());
 
             }
 
@@ -580,6 +582,7 @@ int netif_pub(netif_t *self, char *output_buffer, size_t len, size_t *r_iobytes)
         }// not UDPM
         retval=0;
         MST_METRIC_LAP(self->profile->stats->metrics[NETIF_CH_PUB_XT], mtime_dtime());
+        MST_HIST_LAP(self->hist, self->profile->stats->metrics[NETIF_CH_PUB_XT].start, mtime_dtime());
     }//  invalid arg
 
     return retval;
@@ -739,6 +742,9 @@ netif_t *netif_new_dfl(char *name, char *host, int port,
         mlist_autofree(instance->list,msock_connection_free);
 
         instance->profile = mstats_profile_new(NETIF_EV_COUNT, NETIF_STA_COUNT, NETIF_CH_COUNT, prof_stats_labels, mtime_dtime(), netif_profile_interval_sec);
+        char hist_label[MSTATS_HIST_LABEL_LEN]={0};
+        snprintf(hist_label,MSTATS_HIST_LABEL_LEN,"%s_svc_xt",instance->port_name);
+        instance->hist = mstats_hist_new(hist_label, MSTATS_HIST_SUB_BITS_DFL, MSTATS_HIST_MAX_EXP_DFL, 1, MSTATS_HIST_UNIT_NSEC);
         instance->mlog_id = MLOG_ID_INVALID;
         instance->log_dir=strdup(NETIF_LOG_DIR_DFL);
         instance->cmdline=NULL;
@@ -830,6 +836,7 @@ void netif_destroy(netif_t **pself)
             if(NULL!=self->profile){
             	mstats_profile_destroy(&self->profile);
             }
+            mstats_hist_destroy(&self->hist);
             if(self->mlog_id!=MLOG_ID_INVALID){
                 mlog_close(self->mlog_id);
                  mlog_delete_instance(self->mlog_id);
@@ -1053,6 +1060,14 @@ mstats_t *netif_stats(netif_t *self)
     }
     return retval;
 }
+mstats_hist_t *netif_hist(netif_t *self)
+{
+    mstats_hist_t *retval=NULL;
+    if(NULL!=self){
+        retval = self->hist;
+    }
+    return retval;
+}
 mlog_id_t netif_log(netif_t *self)
 {
     mlog_id_t retval=MLOG_ID_INVALID;
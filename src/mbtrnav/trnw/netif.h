@@ -182,6 +182,8 @@ struct netif_s{
     int ttl;
     netif_mode_t mode;
     mstats_profile_t *profile;
+    // message service time histogram (request handling or publish)
+    mstats_hist_t *hist;
     mlog_id_t mlog_id;
     bool stop;
     msock_socket_ctype ctype;
@@ -318,6 +320,7 @@ extern "C" {
     void netif_init_mmd();
 
     mstats_t *netif_stats(netif_t *self);
+    mstats_hist_t *netif_hist(netif_t *self);
     mlog_id_t netif_log(netif_t *self);
 
 #ifdef __cplusplus
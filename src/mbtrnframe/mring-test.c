@@ -0,0 +1,97 @@
+///
+/// @file mring-test.c
+/// @date 17 oct 2026
+
+/// Unit test wrapper for mring
+
+/// Compile test (in src directory) using
+/// gcc -DWITH_MRING_TEST -o mring-test mring-test.c mring.c mcbuf.c mthread.c mtime.c -lpthread -lm
+/// or build mframe using
+/// WITH_MRING_TEST=1 make clean all
+///
+/// mring-test [--bench[=count]]
+///   runs unit and stress tests; with --bench, also runs throughput
+///   benchmarks (count elements per benchmark, default 10000000)
+
+/////////////////////////
+// Terms of use
+/////////////////////////
+/*
+ Copyright Information
+
+ Copyright 2002-2026 MBARI
+ Monterey Bay Aquarium Research Institute, all rights reserved.
+
+ Terms of Use
+
+ This program is free software; you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation; either version 3 of the License, or
+ (at your option) any later version. You can access the GPLv3 license at
+ http://www.gnu.org/licenses/gpl-3.0.html
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details
+ (http://www.gnu.org/licenses/gpl-3.0.html)
+
+ MBARI provides the documentation and software code "as is", with no warranty,
+ express or implied, as to the software, title, non-infringement of third party
+ rights, merchantability, or fitness for any particular purpose, the accuracy of
+ the code, or the performance or results which you may obtain from its use. You
+ assume the entire risk associated with use of the code, and you agree to be
+ responsible for the entire cost of repair or servicing of the program with
+ which you are using the code.
+
+ In no event shall MBARI be liable for any damages, whether general, special,
+ incidental or consequential damages, arising out of your use of the software,
+ including, but not limited to, the loss or corruption of your data or damages
+ of any kind resulting from use of the software, any prohibited use, or your
+ inability to use the software. You agree to defend, indemnify and hold harmless
+ MBARI and its officers, directors, and employees against any claim, loss,
+ liability or expense, including attorneys' fees, resulting from loss of or
+ damage to property or the injury to or death of any person arising out of the
+ use of the software.
+
+ The MBARI software is provided without obligation on the part of the
+ Monterey Bay Aquarium Research Institute to assist in its use, correction,
+ modification, or enhancement.
+
+ MBARI assumes no responsibility or liability for any third party and/or
+ commercial software required for the database or applications. Licensee agrees
+ to obtain and maintain valid licenses for any additional third party software
+ required.
+ */
+
+/////////////////////////
+// Headers
+/////////////////////////
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include "mring.h"
+
+int main(int argc, char **argv)
+{
+    // C89 declarations (for QNX portability)
+    int retval=-1;
+#ifdef WITH_MRING_TEST
+    int i=0;
+    retval = mring_test();
+    for (i=1; i<argc; i++) {
+        if (strncmp(argv[i],"--bench",7)==0) {
+            unsigned int count=10000000;
+            sscanf(argv[i],"--bench=%u",&count);
+            if (mring_bench(count)!=0) {
+                retval=-1;
+            }
+        }
+    }
+#else
+    fprintf(stderr,"mring_test not implemented - compile using -DWITH_MRING_TEST (WITH_MRING_TEST=1 make...)\r\n");
+#endif
+
+    return retval;
+}
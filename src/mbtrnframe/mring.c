@@ -0,0 +1,865 @@
+///
+/// @file mring.c
+/// @date 17 oct 2026
+
+/// Lock-free ring buffer implementation
+
+/////////////////////////
+// Terms of use
+/////////////////////////
+/*
+Copyright Information
+
+Copyright 2000-2026 MBARI
+Monterey Bay Aquarium Research Institute, all rights reserved.
+
+Terms of Use
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version. You can access the GPLv3 license at
+http://www.gnu.org/licenses/gpl-3.0.html
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details
+(http://www.gnu.org/licenses/gpl-3.0.html)
+
+ MBARI provides the documentation and software code "as is", with no warranty,
+ express or implied, as to the software, title, non-infringement of third party
+ rights, merchantability, or fitness for any particular purpose, the accuracy of
+ the code, or the performance or results which you may obtain from its use. You
+ assume the entire risk associated with use of the code, and you agree to be
+ responsible for the entire cost of repair or servicing of the program with
+ which you are using the code.
+
+ In no event shall MBARI be liable for any damages, whether general, special,
+ incidental or consequential damages, arising out of your use of the software,
+ including, but not limited to, the loss or corruption of your data or damages
+ of any kind resulting from use of the software, any prohibited use, or your
+ inability to use the software. You agree to defend, indemnify and hold harmless
+ MBARI and its officers, directors, and employees against any claim, loss,
+ liability or expense, including attorneys' fees, resulting from loss of or
+ damage to property or the injury to or death of any person arising out of the
+ use of the software.
+
+ The MBARI software is provided without obligation on the part of the
+ Monterey Bay Aquarium Research Institute to assist in its use, correction,
+ modification, or enhancement.
+
+ MBARI assumes no responsibility or liability for any third party and/or
+ commercial software required for the database or applications. Licensee agrees
+ to obtain and maintain valid licenses for any additional third party software
+ required.
+*/
+/////////////////////////
+// Headers
+/////////////////////////
+
+#include <assert.h>
+#include <sched.h>
+#include "mring.h"
+#include "mcbuf.h"
+#include "mthread.h"
+#include "mtime.h"
+
+/////////////////////////
+// Macros
+/////////////////////////
+
+// atomic access (GCC/clang builtins)
+#define MRING_LOAD(p)        __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define MRING_LOAD_RELAXED(p) __atomic_load_n((p), __ATOMIC_RELAXED)
+#define MRING_STORE(p,v)     __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define MRING_CAS(p,pexp,v)  __atomic_compare_exchange_n((p), (pexp), (v), true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)
+
+/// @def MRING_SPIN_COUNT
+/// @brief polls before a blocked push/pop starts sleeping
+#define MRING_SPIN_COUNT 64
+/// @def MRING_YIELD_COUNT
+/// @brief polls before a blocked push/pop stops yielding and sleeps
+#define MRING_YIELD_COUNT 4096
+/// @def MRING_WAIT_NSEC
+/// @brief blocked push/pop sleep interval (nsec)
+#define MRING_WAIT_NSEC 20000
+
+/////////////////////////
+// Declarations
+/////////////////////////
+
+// wait state for blocking push/pop
+typedef struct mring_wait_s{
+    uint32_t wait_msec;
+    uint32_t polls;
+    double timeout;
+}mring_wait_t;
+
+/////////////////////////
+// Function Definitions
+/////////////////////////
+
+// round up to a power of 2 (0 if too large)
+static uint32_t s_mring_pow2(uint32_t n)
+{
+    uint32_t retval = 1;
+    while (retval < n && retval != 0) {
+        retval <<= 1;
+    }
+    return retval;
+}
+
+// allocate a cache line aligned, zeroed block
+static void *s_mring_alloc(size_t size)
+{
+    void *retval = NULL;
+    if (posix_memalign(&retval, MRING_CACHE_LINE, size) == 0) {
+        memset(retval, 0, size);
+    } else {
+        retval = NULL;
+    }
+    return retval;
+}
+
+static void s_mring_wait_init(mring_wait_t *self, uint32_t wait_msec)
+{
+    self->wait_msec = wait_msec;
+    self->polls = 0;
+    self->timeout = 0.0;
+}
+
+// returns true if the caller should poll again (after spinning or
+// sleeping), false when the wait has timed out
+static bool s_mring_wait(mring_wait_t *self)
+{
+    if (self->wait_msec == MRING_NOWAIT) {
+        return false;
+    }
+    if (self->polls++ < MRING_SPIN_COUNT) {
+        return true;
+    }
+    if (self->wait_msec != MRING_FOREVER) {
+        double now = mtime_dtime();
+        if (self->timeout == 0.0) {
+            self->timeout = now + self->wait_msec / 1000.0;
+        } else if (now >= self->timeout) {
+            return false;
+        }
+    }
+    if (self->polls < MRING_YIELD_COUNT) {
+        sched_yield();
+    } else {
+        mtime_delay_ns(MRING_WAIT_NSEC);
+    }
+    return true;
+}
+
+/// @fn mring_spsc_t * mring_spsc_new(uint32_t capacity, uint32_t elem_size)
+/// @brief return new SPSC ring instance reference.
+/// caller should release using mring_spsc_destroy();
+/// @param[in] capacity ring capacity (elements, rounded up to a power of 2)
+/// @param[in] elem_size element size (bytes)
+/// @return instance reference on success, NULL otherwise
+mring_spsc_t *mring_spsc_new(uint32_t capacity, uint32_t elem_size)
+{
+    mring_spsc_t *self = NULL;
+    uint32_t cap = s_mring_pow2(capacity);
+
+    if (cap > 0 && elem_size > 0) {
+        self = (mring_spsc_t *)s_mring_alloc(sizeof(mring_spsc_t));
+        if (NULL != self) {
+            self->capacity = cap;
+            self->mask = cap - 1;
+            self->elem_size = elem_size;
+            self->data = (byte *)malloc((size_t)cap * elem_size);
+            if (NULL == self->data) {
+                fprintf(stderr, "malloc failed (%p)\n", self->data);
+                free(self);
+                self = NULL;
+            }
+        } else {
+            fprintf(stderr, "malloc failed (%p)\n", self);
+        }
+    } else {
+        fprintf(stderr, "invalid argument cap[%u] esz[%u]\n", capacity, elem_size);
+    }
+    return self;
+}
+// End function mring_spsc_new
+
+/// @fn void mring_spsc_destroy(mring_spsc_t ** pself)
+/// @brief release SPSC ring resources.
+/// @param[in] pself pointer to instance reference
+/// @return none
+void mring_spsc_destroy(mring_spsc_t **pself)
+{
+    if (NULL != pself) {
+        mring_spsc_t *self = *pself;
+        if (NULL != self) {
+            free(self->data);
+            free(self);
+            *pself = NULL;
+        }
+    }
+}
+// End function mring_spsc_destroy
+
+/// @fn int mring_spsc_push(mring_spsc_t * self, const void * src, uint32_t count, uint32_t wait_msec)
+/// @brief write elements to SPSC ring (producer thread only).
+/// @param[in] self ring reference
+/// @param[in] src source elements
+/// @param[in] count number of elements
+/// @param[in] wait_msec MRING_NOWAIT: write what fits and return,
+/// MRING_FOREVER: block until all are written, otherwise block up to wait_msec
+/// @return number of elements written on success, -1 otherwise
+int mring_spsc_push(mring_spsc_t *self, const void *src, uint32_t count, uint32_t wait_msec)
+{
+    int retval = -1;
+
+    if (NULL != self && NULL != src) {
+        const byte *psrc = (const byte *)src;
+        uint32_t done = 0;
+        mring_wait_t wait;
+        s_mring_wait_init(&wait, wait_msec);
+
+        while (done < count) {
+            uint32_t head = self->head;
+            uint32_t space = self->capacity - (head - self->tail_cache);
+            if (space < count - done) {
+                // refresh consumer position
+                self->tail_cache = MRING_LOAD(&self->tail);
+                space = self->capacity - (head - self->tail_cache);
+            }
+            if (space == 0) {
+                if (s_mring_wait(&wait))
+                    continue;
+                break;
+            }
+
+            // copy in up to two runs (before and after the wrap)
+            uint32_t n = (count - done < space ? count - done : space);
+            uint32_t i = head & self->mask;
+            uint32_t n1 = (n < self->capacity - i ? n : self->capacity - i);
+            memcpy(self->data + (size_t)i * self->elem_size, psrc, (size_t)n1 * self->elem_size);
+            if (n > n1) {
+                memcpy(self->data, psrc + (size_t)n1 * self->elem_size, (size_t)(n - n1) * self->elem_size);
+            }
+            // publish
+            MRING_STORE(&self->head, head + n);
+            psrc += (size_t)n * self->elem_size;
+            done += n;
+        }
+        retval = (int)done;
+    } else {
+        fprintf(stderr, "invalid argument\n");
+    }
+    return retval;
+}
+// End function mring_spsc_push
+
+/// @fn int mring_spsc_pop(mring_spsc_t * self, void * dest, uint32_t count, uint32_t wait_msec)
+/// @brief read elements from SPSC ring (consumer thread only).
+/// @param[in] self ring reference
+/// @param[in] dest destination buffer (count elements)
+/// @param[in] count maximum number of elements to read
+/// @param[in] wait_msec MRING_NOWAIT: read what is available and return,
+/// MRING_FOREVER: block until at least one is available, otherwise block up to wait_msec
+/// @return number of elements read on success, -1 otherwise
+int mring_spsc_pop(mring_spsc_t *self, void *dest, uint32_t count, uint32_t wait_msec)
+{
+    int retval = -1;
+
+    if (NULL != self && NULL != dest) {
+        byte *pdest = (byte *)dest;
+        uint32_t n = 0;
+        mring_wait_t wait;
+        s_mring_wait_init(&wait, wait_msec);
+
+        while (count > 0) {
+            uint32_t tail = self->tail;
+            uint32_t avail = self->head_cache - tail;
+            if (avail < count) {
+                // refresh producer position
+                self->head_cache = MRING_LOAD(&self->head);
+                avail = self->head_cache - tail;
+            }
+            if (avail == 0) {
+                if (s_mring_wait(&wait))
+                    continue;
+                break;
+            }
+
+            n = (count < avail ? count : avail);
+            uint32_t i = tail & self->mask;
+            uint32_t n1 = (n < self->capacity - i ? n : self->capacity - i);
+            memcpy(pdest, self->data + (size_t)i * self->elem_size, (size_t)n1 * self->elem_size);
+            if (n > n1) {
+                memcpy(pdest + (size_t)n1 * self->elem_size, self->data, (size_t)(n - n1) * self->elem_size);
+            }
+            // release the elements to the producer
+            MRING_STORE(&self->tail, tail + n);
+            break;
+        }
+        retval = (int)n;
+    } else {
+        fprintf(stderr, "invalid argument\n");
+    }
+    return retval;
+}
+// End function mring_spsc_pop
+
+/// @fn uint32_t mring_spsc_available(mring_spsc_t * self)
+/// @brief number of elements in SPSC ring (a snapshot when
+/// called from other threads).
+/// @param[in] self ring reference
+/// @return number of elements
+uint32_t mring_spsc_available(mring_spsc_t *self)
+{
+    uint32_t retval = 0;
+    if (NULL != self) {
+        uint32_t tail = MRING_LOAD(&self->tail);
+        retval = MRING_LOAD(&self->head) - tail;
+    }
+    return retval;
+}
+// End function mring_spsc_available
+
+/// @fn uint32_t mring_spsc_space(mring_spsc_t * self)
+/// @brief free elements in SPSC ring (a snapshot when called
+/// from other threads).
+/// @param[in] self ring reference
+/// @return number of free elements
+uint32_t mring_spsc_space(mring_spsc_t *self)
+{
+    uint32_t retval = 0;
+    if (NULL != self) {
+        retval = self->capacity - mring_spsc_available(self);
+    }
+    return retval;
+}
+// End function mring_spsc_space
+
+// MPMC cell sequence number
+#define MRING_CELL_SEQ(r,i) ((uint32_t *)((r)->cells + (size_t)(i) * (r)->cell_size))
+// MPMC cell element
+#define MRING_CELL_DATA(r,i) ((r)->cells + (size_t)(i) * (r)->cell_size + sizeof(uint64_t))
+
+/// @fn mring_mpmc_t * mring_mpmc_new(uint32_t capacity, uint32_t elem_size)
+/// @brief return new MPMC ring instance reference.
+/// caller should release using mring_mpmc_destroy();
+/// @param[in] capacity ring capacity (elements, rounded up to a power of 2, at least 2)
+/// @param[in] elem_size element size (bytes)
+/// @return instance reference on success, NULL otherwise
+mring_mpmc_t *mring_mpmc_new(uint32_t capacity, uint32_t elem_size)
+{
+    mring_mpmc_t *self = NULL;
+    uint32_t cap = s_mring_pow2(capacity < 2 ? 2 : capacity);
+
+    if (cap > 0 && elem_size > 0) {
+        self = (mring_mpmc_t *)s_mring_alloc(sizeof(mring_mpmc_t));
+        if (NULL != self) {
+            self->capacity = cap;
+            self->mask = cap - 1;
+            self->elem_size = elem_size;
+            // sequence number, then element, 8-byte aligned
+            self->cell_size = (uint32_t)((sizeof(uint64_t) + elem_size + 7) & ~((size_t)7));
+            self->cells = (byte *)malloc((size_t)cap * self->cell_size);
+            if (NULL != self->cells) {
+                uint32_t i = 0;
+                for (i = 0; i < cap; i++) {
+                    *MRING_CELL_SEQ(self, i) = i;
+                }
+            } else {
+                fprintf(stderr, "malloc failed (%p)\n", self->cells);
+                free(self);
+                self = NULL;
+            }
+        } else {
+            fprintf(stderr, "malloc failed (%p)\n", self);
+        }
+    } else {
+        fprintf(stderr, "invalid argument cap[%u] esz[%u]\n", capacity, elem_size);
+    }
+    return self;
+}
+// End function mring_mpmc_new
+
+/// @fn void mring_mpmc_destroy(mring_mpmc_t ** pself)
+/// @brief release MPMC ring resources.
+/// @param[in] pself pointer to instance reference
+/// @return none
+void mring_mpmc_destroy(mring_mpmc_t **pself)
+{
+    if (NULL != pself) {
+        mring_mpmc_t *self = *pself;
+        if (NULL != self) {
+            free(self->cells);
+            free(self);
+            *pself = NULL;
+        }
+    }
+}
+// End function mring_mpmc_destroy
+
+/// @fn int mring_mpmc_push(mring_mpmc_t * self, const void * src, uint32_t count, uint32_t wait_msec)
+/// @brief write elements to MPMC ring (any thread). Each element is
+/// claimed separately, so elements of concurrent batches may interleave.
+/// @param[in] self ring reference
+/// @param[in] src source elements
+/// @param[in] count number of elements
+/// @param[in] wait_msec MRING_NOWAIT: write what fits and return,
+/// MRING_FOREVER: block until all are written, otherwise block up to wait_msec
+/// @return number of elements written on success, -1 otherwise
+int mring_mpmc_push(mring_mpmc_t *self, const void *src, uint32_t count, uint32_t wait_msec)
+{
+    int retval = -1;
+
+    if (NULL != self && NULL != src) {
+        const byte *psrc = (const byte *)src;
+        uint32_t done = 0;
+        mring_wait_t wait;
+        s_mring_wait_init(&wait, wait_msec);
+
+        while (done < count) {
+            uint32_t pos = MRING_LOAD_RELAXED(&self->head);
+            uint32_t *pseq = NULL;
+            bool full = false;
+            for (;;) {
+                pseq = MRING_CELL_SEQ(self, pos & self->mask);
+                int32_t diff = (int32_t)(MRING_LOAD(pseq) - pos);
+                if (diff == 0) {
+                    // cell free for this lap; claim it
+                    if (MRING_CAS(&self->head, &pos, pos + 1))
+                        break;
+                } else if (diff < 0) {
+                    // cell still holds last lap's element
+                    full = true;
+                    break;
+                } else {
+                    pos = MRING_LOAD_RELAXED(&self->head);
+                }
+            }
+            if (full) {
+                if (s_mring_wait(&wait))
+                    continue;
+                break;
+            }
+            memcpy(MRING_CELL_DATA(self, pos & self->mask), psrc, self->elem_size);
+            // mark full for consumers
+            MRING_STORE(pseq, pos + 1);
+            psrc += self->elem_size;
+            done++;
+        }
+        retval = (int)done;
+    } else {
+        fprintf(stderr, "invalid argument\n");
+    }
+    return retval;
+}
+// End function mring_mpmc_push
+
+/// @fn int mring_mpmc_pop(mring_mpmc_t * self, void * dest, uint32_t count, uint32_t wait_msec)
+/// @brief read elements from MPMC ring (any thread).
+/// @param[in] self ring reference
+/// @param[in] dest destination buffer (count elements)
+/// @param[in] count maximum number of elements to read
+/// @param[in] wait_msec MRING_NOWAIT: read what is available and return,
+/// MRING_FOREVER: block until at least one is available, otherwise block up to wait_msec
+/// @return number of elements read on success, -1 otherwise
+int mring_mpmc_pop(mring_mpmc_t *self, void *dest, uint32_t count, uint32_t wait_msec)
+{
+    int retval = -1;
+
+    if (NULL != self && NULL != dest) {
+        byte *pdest = (byte *)dest;
+        uint32_t done = 0;
+        mring_wait_t wait;
+        s_mring_wait_init(&wait, wait_msec);
+
+        while (done < count) {
+            uint32_t pos = MRING_LOAD_RELAXED(&self->tail);
+            uint32_t *pseq = NULL;
+            bool empty = false;
+            for (;;) {
+                pseq = MRING_CELL_SEQ(self, pos & self->mask);
+                int32_t diff = (int32_t)(MRING_LOAD(pseq) - (pos + 1));
+                if (diff == 0) {
+                    // cell full for this lap; claim it
+                    if (MRING_CAS(&self->tail, &pos, pos + 1))
+                        break;
+                } else if (diff < 0) {
+                    empty = true;
+                    break;
+                } else {
+                    pos = MRING_LOAD_RELAXED(&self->tail);
+                }
+            }
+            if (empty) {
+                // wait only for the first element
+                if (done == 0 && s_mring_wait(&wait))
+                    continue;
+                break;
+            }
+            memcpy(pdest, MRING_CELL_DATA(self, pos & self->mask), self->elem_size);
+            // mark free for producers on the next lap
+            MRING_STORE(pseq, pos + self->capacity);
+            pdest += self->elem_size;
+            done++;
+        }
+        retval = (int)done;
+    } else {
+        fprintf(stderr, "invalid argument\n");
+    }
+    return retval;
+}
+// End function mring_mpmc_pop
+
+/// @fn uint32_t mring_mpmc_available(mring_mpmc_t * self)
+/// @brief approximate number of elements in MPMC ring
+/// (elements being written or read may be counted).
+/// @param[in] self ring reference
+/// @return number of elements
+uint32_t mring_mpmc_available(mring_mpmc_t *self)
+{
+    uint32_t retval = 0;
+    if (NULL != self) {
+        uint32_t tail = MRING_LOAD(&self->tail);
+        uint32_t head = MRING_LOAD(&self->head);
+        int32_t n = (int32_t)(head - tail);
+        retval = (n < 0 ? 0 : (n > (int32_t)self->capacity ? self->capacity : (uint32_t)n));
+    }
+    return retval;
+}
+// End function mring_mpmc_available
+
+/////////////////////////
+// Test and benchmark
+/////////////////////////
+
+// ring under test
+typedef enum {MRING_T_SPSC=0, MRING_T_MPMC, MRING_T_MCBUF} mring_type_t;
+
+typedef struct mring_worker_s{
+    mring_type_t type;
+    void *ring;
+    uint32_t count;
+    uint32_t batch;
+    uint32_t id;
+    uint32_t nthreads;
+    // consumer results
+    uint64_t sum;
+    uint32_t received;
+    uint32_t errors;
+}mring_worker_t;
+
+static int s_mring_tpush(mring_worker_t *w, const uint64_t *src, uint32_t n)
+{
+    int retval = -1;
+    int status = 0;
+    switch (w->type) {
+        case MRING_T_SPSC:
+            retval = mring_spsc_push((mring_spsc_t *)w->ring, src, n, MRING_FOREVER);
+            break;
+        case MRING_T_MPMC:
+            retval = mring_mpmc_push((mring_mpmc_t *)w->ring, src, n, MRING_FOREVER);
+            break;
+        case MRING_T_MCBUF:
+            // mcbuf doesn't block, poll like its users do
+            while ((retval = mcbuf_write((mcbuffer_t *)w->ring, (byte *)src, n * sizeof(uint64_t), MCB_NONE, &status)) < 0) {
+                sched_yield();
+            }
+            retval /= sizeof(uint64_t);
+            break;
+    }
+    return retval;
+}
+
+static int s_mring_tpop(mring_worker_t *w, uint64_t *dest, uint32_t n)
+{
+    int retval = -1;
+    int status = 0;
+    switch (w->type) {
+        case MRING_T_SPSC:
+            retval = mring_spsc_pop((mring_spsc_t *)w->ring, dest, n, MRING_FOREVER);
+            break;
+        case MRING_T_MPMC:
+            retval = mring_mpmc_pop((mring_mpmc_t *)w->ring, dest, n, MRING_FOREVER);
+            break;
+        case MRING_T_MCBUF:
+            while ((retval = mcbuf_read((mcbuffer_t *)w->ring, (byte *)dest, n * sizeof(uint64_t), MCB_NONE, &status)) < 0) {
+                sched_yield();
+            }
+            retval /= sizeof(uint64_t);
+            break;
+    }
+    return retval;
+}
+
+// producer: sends count values, tagged with the producer id
+static void *s_mring_producer(void *arg)
+{
+    mring_worker_t *w = (mring_worker_t *)arg;
+    uint64_t buf[64];
+    uint32_t i = 0;
+    while (i < w->count) {
+        uint32_t n = (w->count - i < w->batch ? w->count - i : w->batch);
+        uint32_t k = 0;
+        for (k = 0; k < n; k++) {
+            buf[k] = ((uint64_t)w->id << 32) | (i + k);
+        }
+        if (s_mring_tpush(w, buf, n) != (int)n) {
+            w->errors++;
+        }
+        i += n;
+    }
+    return NULL;
+}
+
+// consumer: receives count values, checking each producer's values
+// arrive in order
+static void *s_mring_consumer(void *arg)
+{
+    mring_worker_t *w = (mring_worker_t *)arg;
+    uint64_t buf[64];
+    uint32_t next[8] = {0};
+    while (w->received < w->count) {
+        uint32_t n = (w->count - w->received < w->batch ? w->count - w->received : w->batch);
+        int got = s_mring_tpop(w, buf, n);
+        int k = 0;
+        for (k = 0; k < got; k++) {
+            uint32_t id = (uint32_t)(buf[k] >> 32);
+            uint32_t seq = (uint32_t)(buf[k] & 0xFFFFFFFF);
+            // with one consumer, each producer's values must be in order
+            if (id >= 8 || (w->nthreads == 1 && seq != next[id])) {
+                w->errors++;
+            }
+            if (id < 8)
+                next[id] = seq + 1;
+            w->sum += buf[k];
+        }
+        if (got > 0)
+            w->received += got;
+    }
+    return NULL;
+}
+
+// run nprod producers and ncons consumers moving count values per
+// producer through a ring of the given type.
+// returns elapsed time (s), and error count in *errors
+static double s_mring_run(mring_type_t type, uint32_t nprod, uint32_t ncons, uint32_t count, uint32_t batch,
+                          uint32_t capacity, uint32_t *errors)
+{
+    mring_worker_t prod[8];
+    mring_worker_t cons[8];
+    mthread_thread_t *tprod[8];
+    mthread_thread_t *tcons[8];
+    void *ring = NULL;
+    uint32_t i = 0;
+    uint64_t expected = 0;
+    uint64_t sum = 0;
+    uint32_t received = 0;
+
+    switch (type) {
+        case MRING_T_SPSC:
+            ring = mring_spsc_new(capacity, sizeof(uint64_t));
+            break;
+        case MRING_T_MPMC:
+            ring = mring_mpmc_new(capacity, sizeof(uint64_t));
+            break;
+        case MRING_T_MCBUF:
+            ring = mcbuf_new(capacity * sizeof(uint64_t));
+            break;
+    }
+
+    *errors = 0;
+    memset(prod, 0, sizeof(prod));
+    memset(cons, 0, sizeof(cons));
+    for (i = 0; i < nprod; i++) {
+        prod[i].type = type;
+        prod[i].ring = ring;
+        prod[i].count = count;
+        prod[i].batch = batch;
+        prod[i].id = i;
+        expected += ((uint64_t)i << 32) * count + ((uint64_t)count * (count - 1)) / 2;
+    }
+    for (i = 0; i < ncons; i++) {
+        cons[i].type = type;
+        cons[i].ring = ring;
+        // split the values across the consumers
+        cons[i].count = (nprod * count) / ncons + (i == 0 ? (nprod * count) % ncons : 0);
+        cons[i].batch = batch;
+        cons[i].nthreads = ncons;
+    }
+
+    double start = mtime_dtime();
+    for (i = 0; i < ncons; i++) {
+        tcons[i] = mthread_thread_new();
+        mthread_thread_start(tcons[i], s_mring_consumer, &cons[i]);
+    }
+    for (i = 0; i < nprod; i++) {
+        tprod[i] = mthread_thread_new();
+        mthread_thread_start(tprod[i], s_mring_producer, &prod[i]);
+    }
+    for (i = 0; i < nprod; i++) {
+        mthread_thread_join(tprod[i]);
+        mthread_thread_destroy(&tprod[i]);
+        *errors += prod[i].errors;
+    }
+    for (i = 0; i < ncons; i++) {
+        mthread_thread_join(tcons[i]);
+        mthread_thread_destroy(&tcons[i]);
+        *errors += cons[i].errors;
+        sum += cons[i].sum;
+        received += cons[i].received;
+    }
+    double elapsed = mtime_dtime() - start;
+
+    // every value arrives exactly once
+    if (sum != expected || received != nprod * count) {
+        (*errors)++;
+    }
+
+    switch (type) {
+        case MRING_T_SPSC:
+            mring_spsc_destroy((mring_spsc_t **)&ring);
+            break;
+        case MRING_T_MPMC:
+            mring_mpmc_destroy((mring_mpmc_t **)&ring);
+            break;
+        case MRING_T_MCBUF:
+            mcbuf_destroy((mcbuffer_t **)&ring);
+            break;
+    }
+    return elapsed;
+}
+
+/// @fn int mring_test()
+/// @brief ring buffer unit test(s), and stress tests of the lock-free
+/// rings alongside the mutex-protected mcbuf.
+/// @return 0 on success, -1 otherwise
+int mring_test()
+{
+    int retval = 0;
+    uint32_t errors = 0;
+    int ret = 0;
+    uint32_t i = 0;
+    uint32_t wdata[32];
+    uint32_t rdata[32];
+
+    fprintf(stderr, "test start:\n");
+    for (i = 0; i < 32; i++) {
+        wdata[i] = i + 0x20;
+    }
+
+    // SPSC: capacity rounds up to a power of 2
+    mring_spsc_t *s = mring_spsc_new(10, sizeof(uint32_t));
+    assert(NULL != s);
+    assert(s->capacity == 16);
+    assert(mring_spsc_available(s) == 0);
+    assert(mring_spsc_space(s) == 16);
+
+    // read empty ring
+    ret = mring_spsc_pop(s, rdata, 5, MRING_NOWAIT);
+    assert(ret == 0);
+    // read empty ring, with timeout
+    double start = mtime_dtime();
+    ret = mring_spsc_pop(s, rdata, 5, 20);
+    assert(ret == 0);
+    assert(mtime_dtime() - start >= 0.015);
+
+    // batch write, partial when full
+    ret = mring_spsc_push(s, wdata, 10, MRING_NOWAIT);
+    assert(ret == 10);
+    ret = mring_spsc_push(s, wdata + 10, 10, MRING_NOWAIT);
+    assert(ret == 6);
+    assert(mring_spsc_available(s) == 16);
+    assert(mring_spsc_space(s) == 0);
+    ret = mring_spsc_push(s, wdata, 1, MRING_NOWAIT);
+    assert(ret == 0);
+
+    // batch read, then wrap
+    ret = mring_spsc_pop(s, rdata, 12, MRING_NOWAIT);
+    assert(ret == 12);
+    assert(memcmp(rdata, wdata, 12 * sizeof(uint32_t)) == 0);
+    ret = mring_spsc_push(s, wdata + 16, 12, MRING_NOWAIT);
+    assert(ret == 12);
+    ret = mring_spsc_pop(s, rdata, 32, MRING_NOWAIT);
+    assert(ret == 16);
+    assert(memcmp(rdata, wdata + 12, 16 * sizeof(uint32_t)) == 0);
+    assert(mring_spsc_available(s) == 0);
+    mring_spsc_destroy(&s);
+    assert(NULL == s);
+
+    // MPMC
+    mring_mpmc_t *m = mring_mpmc_new(8, sizeof(uint32_t));
+    assert(NULL != m);
+    ret = mring_mpmc_pop(m, rdata, 5, MRING_NOWAIT);
+    assert(ret == 0);
+    ret = mring_mpmc_push(m, wdata, 12, MRING_NOWAIT);
+    assert(ret == 8);
+    assert(mring_mpmc_available(m) == 8);
+    ret = mring_mpmc_pop(m, rdata, 5, MRING_NOWAIT);
+    assert(ret == 5);
+    assert(memcmp(rdata, wdata, 5 * sizeof(uint32_t)) == 0);
+    ret = mring_mpmc_push(m, wdata + 8, 12, MRING_NOWAIT);
+    assert(ret == 5);
+    ret = mring_mpmc_pop(m, rdata, 32, MRING_NOWAIT);
+    assert(ret == 8);
+    assert(memcmp(rdata, wdata + 5, 8 * sizeof(uint32_t)) == 0);
+    mring_mpmc_destroy(&m);
+
+    // stress: values arrive once, and in order per producer
+    s_mring_run(MRING_T_MCBUF, 1, 1, 200000, 7, 64, &errors);
+    fprintf(stderr, "mcbuf 1/1 errors %u\n", errors);
+    retval = (errors ? -1 : retval);
+    s_mring_run(MRING_T_SPSC, 1, 1, 2000000, 7, 64, &errors);
+    fprintf(stderr, "spsc  1/1 errors %u\n", errors);
+    retval = (errors ? -1 : retval);
+    s_mring_run(MRING_T_SPSC, 1, 1, 200000, 1, 2, &errors);
+    fprintf(stderr, "spsc  1/1 (cap 2) errors %u\n", errors);
+    retval = (errors ? -1 : retval);
+    s_mring_run(MRING_T_MPMC, 1, 1, 2000000, 7, 64, &errors);
+    fprintf(stderr, "mpmc  1/1 errors %u\n", errors);
+    retval = (errors ? -1 : retval);
+    s_mring_run(MRING_T_MPMC, 4, 4, 500000, 5, 64, &errors);
+    fprintf(stderr, "mpmc  4/4 errors %u\n", errors);
+    retval = (errors ? -1 : retval);
+
+    fprintf(stderr, "test end: %s\n", (retval == 0 ? "OK" : "FAILED"));
+    return retval;
+}
+// End function mring_test
+
+/// @fn int mring_bench(uint32_t count)
+/// @brief ring buffer microbenchmarks: throughput of the lock-free
+/// rings and the mutex-protected mcbuf, moving 8-byte elements
+/// between threads, one at a time and in batches.
+/// @param[in] count elements per producer
+/// @return 0 on success, -1 otherwise
+int mring_bench(uint32_t count)
+{
+    int retval = 0;
+    const char *names[] = {"spsc", "mpmc", "mcbuf"};
+    uint32_t batches[] = {1, 16};
+    uint32_t t = 0;
+    uint32_t b = 0;
+
+    fprintf(stderr, "%-6s %5s %6s %12s %10s\n", "ring", "p/c", "batch", "Melem/s", "errors");
+    for (b = 0; b < 2; b++) {
+        for (t = MRING_T_SPSC; t <= MRING_T_MCBUF; t++) {
+            uint32_t errors = 0;
+            double elapsed = s_mring_run((mring_type_t)t, 1, 1, count, batches[b], 1024, &errors);
+            fprintf(stderr, "%-6s %5s %6u %12.2lf %10u\n", names[t], "1/1", batches[b],
+                    (elapsed > 0.0 ? count / elapsed / 1.0e6 : 0.0), errors);
+            retval = (errors ? -1 : retval);
+        }
+    }
+    // contended MPMC
+    uint32_t errors = 0;
+    double elapsed = s_mring_run(MRING_T_MPMC, 4, 4, count / 4, 1, 1024, &errors);
+    fprintf(stderr, "%-6s %5s %6u %12.2lf %10u\n", "mpmc", "4/4", 1, (elapsed > 0.0 ? count / elapsed / 1.0e6 : 0.0), errors);
+    retval = (errors ? -1 : retval);
+    return retval;
+}
+// End function mring_bench
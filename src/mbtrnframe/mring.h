@@ -0,0 +1,191 @@
+///
+/// @file mring.h
+/// @date 17 oct 2026
+
+/// Lock-free ring buffers: single-producer/single-consumer (SPSC)
+/// and bounded multi-producer/multi-consumer (MPMC)
+
+/// @sa doxygen-examples.c for more examples of Doxygen markup
+
+
+/////////////////////////
+// Terms of use
+/////////////////////////
+/*
+Copyright Information
+
+Copyright 2000-2026 MBARI
+Monterey Bay Aquarium Research Institute, all rights reserved.
+
+Terms of Use
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version. You can access the GPLv3 license at
+http://www.gnu.org/licenses/gpl-3.0.html
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details
+(http://www.gnu.org/licenses/gpl-3.0.html)
+
+ MBARI provides the documentation and software code "as is", with no warranty,
+ express or implied, as to the software, title, non-infringement of third party
+ rights, merchantability, or fitness for any particular purpose, the accuracy of
+ the code, or the performance or results which you may obtain from its use. You
+ assume the entire risk associated with use of the code, and you agree to be
+ responsible for the entire cost of repair or servicing of the program with
+ which you are using the code.
+
+ In no event shall MBARI be liable for any damages, whether general, special,
+ incidental or consequential damages, arising out of your use of the software,
+ including, but not limited to, the loss or corruption of your data or damages
+ of any kind resulting from use of the software, any prohibited use, or your
+ inability to use the software. You agree to defend, indemnify and hold harmless
+ MBARI and its officers, directors, and employees against any claim, loss,
+ liability or expense, including attorneys' fees, resulting from loss of or
+ damage to property or the injury to or death of any person arising out of the
+ use of the software.
+
+ The MBARI software is provided without obligation on the part of the
+ Monterey Bay Aquarium Research Institute to assist in its use, correction,
+ modification, or enhancement.
+
+ MBARI assumes no responsibility or liability for any third party and/or
+ commercial software required for the database or applications. Licensee agrees
+ to obtain and maintain valid licenses for any additional third party software
+ required.
+*/
+
+// include guard
+#ifndef MRING_H
+/// @def MRING_H
+/// @brief include guard
+#define MRING_H
+
+/////////////////////////
+// Includes
+/////////////////////////
+
+#include "mframe.h"
+
+/////////////////////////
+// Macros
+/////////////////////////
+
+/// @def MRING_CACHE_LINE
+/// @brief cache line size (bytes); producer and consumer
+/// indices are kept on separate lines to avoid false sharing
+#define MRING_CACHE_LINE 64
+/// @def MRING_ALIGNED
+/// @brief start a structure member on a new cache line
+#define MRING_ALIGNED __attribute__((aligned(MRING_CACHE_LINE)))
+/// @def MRING_NOWAIT
+/// @brief push/pop wait: return immediately (non-blocking)
+#define MRING_NOWAIT 0
+/// @def MRING_FOREVER
+/// @brief push/pop wait: block until the request completes
+#define MRING_FOREVER 0xFFFFFFFF
+
+/////////////////////////
+// Type Definitions
+/////////////////////////
+
+/// @typedef struct mring_spsc_s mring_spsc_t
+/// @brief lock-free single-producer/single-consumer ring of fixed size
+/// elements. Exactly one thread may push and one (other) thread may pop.
+/// Indices run free and are masked, so capacity is a power of two.
+/// Instances are cache line aligned (use mring_spsc_new).
+typedef struct mring_spsc_s{
+    /// @var mring_spsc_s::capacity
+    /// @brief capacity (elements, power of 2)
+    uint32_t capacity;
+    /// @var mring_spsc_s::mask
+    /// @brief index mask (capacity-1)
+    uint32_t mask;
+    /// @var mring_spsc_s::elem_size
+    /// @brief element size (bytes)
+    uint32_t elem_size;
+    /// @var mring_spsc_s::data
+    /// @brief element memory
+    byte *data;
+
+    /// @var mring_spsc_s::head
+    /// @brief next element to write (producer)
+    uint32_t head MRING_ALIGNED;
+    /// @var mring_spsc_s::tail_cache
+    /// @brief producer copy of tail (refreshed when ring appears full)
+    uint32_t tail_cache;
+
+    /// @var mring_spsc_s::tail
+    /// @brief next element to read (consumer)
+    uint32_t tail MRING_ALIGNED;
+    /// @var mring_spsc_s::head_cache
+    /// @brief consumer copy of head (refreshed when ring appears empty)
+    uint32_t head_cache;
+}mring_spsc_t;
+
+/// @typedef struct mring_mpmc_s mring_mpmc_t
+/// @brief lock-free bounded multi-producer/multi-consumer ring of fixed
+/// size elements. Each cell carries a sequence number that tells
+/// producers and consumers whether it is free or full for the current
+/// lap, so threads claim cells with a single compare-and-swap.
+typedef struct mring_mpmc_s{
+    /// @var mring_mpmc_s::capacity
+    /// @brief capacity (elements, power of 2)
+    uint32_t capacity;
+    /// @var mring_mpmc_s::mask
+    /// @brief index mask (capacity-1)
+    uint32_t mask;
+    /// @var mring_mpmc_s::elem_size
+    /// @brief element size (bytes)
+    uint32_t elem_size;
+    /// @var mring_mpmc_s::cell_size
+    /// @brief cell size (sequence number and element, bytes)
+    uint32_t cell_size;
+    /// @var mring_mpmc_s::cells
+    /// @brief cell memory
+    byte *cells;
+
+    /// @var mring_mpmc_s::head
+    /// @brief next cell to write (producers)
+    uint32_t head MRING_ALIGNED;
+
+    /// @var mring_mpmc_s::tail
+    /// @brief next cell to read (consumers)
+    uint32_t tail MRING_ALIGNED;
+}mring_mpmc_t;
+
+/////////////////////////
+// Exports
+/////////////////////////
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// SPSC ring API
+mring_spsc_t *mring_spsc_new(uint32_t capacity, uint32_t elem_size);
+void mring_spsc_destroy(mring_spsc_t **pself);
+int mring_spsc_push(mring_spsc_t *self, const void *src, uint32_t count, uint32_t wait_msec);
+int mring_spsc_pop(mring_spsc_t *self, void *dest, uint32_t count, uint32_t wait_msec);
+uint32_t mring_spsc_available(mring_spsc_t *self);
+uint32_t mring_spsc_space(mring_spsc_t *self);
+
+// MPMC ring API
+mring_mpmc_t *mring_mpmc_new(uint32_t capacity, uint32_t elem_size);
+void mring_mpmc_destroy(mring_mpmc_t **pself);
+int mring_mpmc_push(mring_mpmc_t *self, const void *src, uint32_t count, uint32_t wait_msec);
+int mring_mpmc_pop(mring_mpmc_t *self, void *dest, uint32_t count, uint32_t wait_msec);
+uint32_t mring_mpmc_available(mring_mpmc_t *self);
+
+int mring_test();
+int mring_bench(uint32_t count);
+
+#ifdef __cplusplus
+}
+#endif
+
+// include guard
+#endif
@@ -34,7 +34,10 @@ int main(int argc, char **argv)
     sigaction(SIGINT, &saStruct, NULL);
     
 #if defined(WITH_MSTATS_TEST)
-    retval = mstats_test();
+    retval = mstats_hist_test();
+    if (retval==0) {
+        retval = mstats_test();
+    }
 #else
     fprintf(stderr,"mstats_test not implemented - compile using -DWITH_MSTATS_TEST (WITH_MSTATS_TEST=1 make...)\n");
     fprintf(stderr,"i.e. WITH_MSTATS_TEST=1 make\n");
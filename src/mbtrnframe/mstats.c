@@ -64,12 +64,22 @@
 // Headers 
 /////////////////////////
 
+#include <stdlib.h>
+#include <unistd.h>
 #include "mstats.h"
+#include "mthread.h"
 
 /////////////////////////
 // Macros
 /////////////////////////
 
+// histogram counters are updated using GCC/clang atomic builtins
+#define MSTATS_LOAD(p)           __atomic_load_n((p), __ATOMIC_RELAXED)
+#define MSTATS_STORE(p,v)        __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#define MSTATS_ADD(p,v)          __atomic_fetch_add((p), (v), __ATOMIC_RELAXED)
+#define MSTATS_XCHG(p,v)         __atomic_exchange_n((p), (v), __ATOMIC_RELAXED)
+#define MSTATS_CAS(p,pexp,v)     __atomic_compare_exchange_n((p), (pexp), (v), true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)
+
 // These macros should only be defined for 
 // application main files rather than general C files
 /*
@@ -101,6 +111,9 @@
 // Module Global Variables
 /////////////////////////
 bool g_mstat_test_quit=false;
+// histogram thread numbering (shard selection)
+static uint32_t s_hist_thread_seq=0;
+static __thread int32_t s_hist_thread_id=-1;
 
 /////////////////////////
 // Function Definitions
@@ -356,6 +369,477 @@ void mstats_profile_destroy(mstats_profile_t **pself)
 }
 // End function mstats_profile_destroy
 
+/// @fn uint32_t s_hist_index(uint32_t sub_bits, uint64_t value)
+/// @brief histogram bucket index for value.
+/// Values < 2^sub_bits have one bucket each; above that, each power
+/// of 2 is split into 2^sub_bits buckets.
+/// @param[in] sub_bits log2 of sub-buckets per power of 2
+/// @param[in] value value (units)
+/// @return bucket index (may exceed bucket count if value is out of range)
+static uint32_t s_hist_index(uint32_t sub_bits, uint64_t value)
+{
+    uint64_t sub_n = ((uint64_t)1<<sub_bits);
+    if (value < sub_n) {
+        return (uint32_t)value;
+    }
+    uint32_t shift = (63 - __builtin_clzll(value)) - sub_bits;
+    return (uint32_t)((shift+1)*sub_n + ((value>>shift) - sub_n));
+}
+// End function s_hist_index
+
+/// @fn uint64_t s_hist_lower(uint32_t sub_bits, uint32_t index)
+/// @brief lowest value counted in a histogram bucket
+/// @param[in] sub_bits log2 of sub-buckets per power of 2
+/// @param[in] index bucket index
+/// @return bucket lower bound (units)
+static uint64_t s_hist_lower(uint32_t sub_bits, uint32_t index)
+{
+    uint64_t sub_n = ((uint64_t)1<<sub_bits);
+    if (index < sub_n) {
+        return index;
+    }
+    uint32_t shift = (uint32_t)(index/sub_n) - 1;
+    return (sub_n + (index%sub_n))<<shift;
+}
+// End function s_hist_lower
+
+/// @fn uint64_t s_hist_upper(uint32_t sub_bits, uint32_t index)
+/// @brief highest value counted in a histogram bucket
+/// @param[in] sub_bits log2 of sub-buckets per power of 2
+/// @param[in] index bucket index
+/// @return bucket upper bound (units)
+static uint64_t s_hist_upper(uint32_t sub_bits, uint32_t index)
+{
+    uint64_t sub_n = ((uint64_t)1<<sub_bits);
+    if (index < sub_n) {
+        return index;
+    }
+    uint32_t shift = (uint32_t)(index/sub_n) - 1;
+    return ((sub_n + (index%sub_n) + 1)<<shift) - 1;
+}
+// End function s_hist_upper
+
+/// @fn uint32_t s_hist_shard(mstats_hist_t *self)
+/// @brief shard for the calling thread.
+/// Threads are numbered on their first call; threads share a shard
+/// only if there are more of them than shards.
+/// @param[in] self histogram reference
+/// @return shard index
+static uint32_t s_hist_shard(mstats_hist_t *self)
+{
+    if (s_hist_thread_id < 0) {
+        s_hist_thread_id = (int32_t)(MSTATS_ADD(&s_hist_thread_seq, 1) & 0x7FFFFFFF);
+    }
+    return (uint32_t)s_hist_thread_id % self->shard_n;
+}
+// End function s_hist_shard
+
+/// @fn mstats_hist_t *mstats_hist_new(const char *label, uint32_t sub_bits, uint32_t max_exp, uint32_t shards, double unit)
+/// @brief create new histogram
+/// @param[in] label histogram label (truncated to MSTATS_HIST_LABEL_LEN-1)
+/// @param[in] sub_bits log2 of sub-buckets per power of 2 (1-16)
+/// @param[in] max_exp values < 2^max_exp units are in range (sub_bits < max_exp < 64)
+/// @param[in] shards number of shards (typically, the number of recording threads)
+/// @param[in] unit value unit (seconds), e.g. MSTATS_HIST_UNIT_NSEC
+/// @return mstats_hist_t on success, NULL otherwise
+mstats_hist_t *mstats_hist_new(const char *label, uint32_t sub_bits, uint32_t max_exp, uint32_t shards, double unit)
+{
+    mstats_hist_t *self = NULL;
+
+    if (sub_bits<1 || sub_bits>16 || max_exp<=sub_bits || max_exp>63 || shards<1 || unit<=0.0) {
+        fprintf(stderr,"%s - ERR invalid argument sub_bits[%"PRIu32"] max_exp[%"PRIu32"] shards[%"PRIu32"] unit[%g]\n",
+                __func__, sub_bits, max_exp, shards, unit);
+        return NULL;
+    }
+
+    self = (mstats_hist_t *)malloc(sizeof(mstats_hist_t));
+    if (NULL!=self) {
+        void *shard_mem=NULL;
+        uint32_t i=0;
+        memset(self,0,sizeof(mstats_hist_t));
+        snprintf(self->label,MSTATS_HIST_LABEL_LEN,"%s",(NULL!=label?label:""));
+        self->sub_bits = sub_bits;
+        self->max_exp = max_exp;
+        self->bucket_n = (max_exp-sub_bits+1)*((uint32_t)1<<sub_bits);
+        self->shard_n = shards;
+        self->unit = unit;
+
+        // shards on separate cache lines, so recording threads don't share
+        if (posix_memalign(&shard_mem, MSTATS_CACHE_LINE, shards*sizeof(mstats_hshard_t))==0) {
+            self->shards = (mstats_hshard_t *)shard_mem;
+            memset(self->shards,0,shards*sizeof(mstats_hshard_t));
+            for (i=0; i<shards; i++) {
+                self->shards[i].min = UINT64_MAX;
+                self->shards[i].counts = (uint64_t *)calloc(self->bucket_n,sizeof(uint64_t));
+                if (NULL==self->shards[i].counts) {
+                    break;
+                }
+            }
+        }
+        if (NULL==self->shards || i<shards) {
+            mstats_hist_destroy(&self);
+        }
+    }
+    return self;
+}
+// End function mstats_hist_new
+
+/// @fn void mstats_hist_destroy(mstats_hist_t **pself)
+/// @brief release histogram resources.
+/// Caller must ensure no thread is recording.
+/// @param[in] pself pointer to instance pointer
+/// @return none
+void mstats_hist_destroy(mstats_hist_t **pself)
+{
+    if (NULL!=pself && NULL!=*pself) {
+        mstats_hist_t *self=(*pself);
+        if (NULL!=self->shards) {
+            uint32_t i=0;
+            for (i=0; i<self->shard_n; i++) {
+                free(self->shards[i].counts);
+            }
+            free(self->shards);
+        }
+        free(self);
+        *pself=NULL;
+    }
+}
+// End function mstats_hist_destroy
+
+/// @fn void mstats_hist_record(mstats_hist_t *self, uint64_t value)
+/// @brief record a value (lock-free; safe to call from any thread).
+/// Values >= 2^max_exp are counted in the last bucket (and as overflow).
+/// @param[in] self histogram reference
+/// @param[in] value value (units)
+/// @return none
+void mstats_hist_record(mstats_hist_t *self, uint64_t value)
+{
+    if (NULL!=self) {
+        mstats_hshard_t *shard = &self->shards[s_hist_shard(self)];
+        uint32_t index = s_hist_index(self->sub_bits, value);
+        uint64_t cur = 0;
+
+        if (index >= self->bucket_n) {
+            index = self->bucket_n-1;
+            MSTATS_ADD(&shard->overflow, 1);
+        }
+        MSTATS_ADD(&shard->counts[index], 1);
+        MSTATS_ADD(&shard->sum, value);
+
+        cur = MSTATS_LOAD(&shard->min);
+        while (value<cur && !MSTATS_CAS(&shard->min, &cur, value));
+        cur = MSTATS_LOAD(&shard->max);
+        while (value>cur && !MSTATS_CAS(&shard->max, &cur, value));
+    }
+}
+// End function mstats_hist_record
+
+/// @fn void mstats_hist_record_sec(mstats_hist_t *self, double sec)
+/// @brief record a time interval (lock-free; safe to call from any thread)
+/// @param[in] self histogram reference
+/// @param[in] sec interval (decimal seconds); negative values are recorded as 0
+/// @return none
+void mstats_hist_record_sec(mstats_hist_t *self, double sec)
+{
+    if (NULL!=self) {
+        double value = (sec>0.0 ? (sec/self->unit + 0.5) : 0.0);
+        mstats_hist_record(self, (value < (double)UINT64_MAX ? (uint64_t)value : UINT64_MAX));
+    }
+}
+// End function mstats_hist_record_sec
+
+/// @fn int mstats_hist_snapshot(mstats_hist_t *self, mstats_hsnap_t *dest, bool reset)
+/// @brief merge histogram shards into a snapshot.
+/// May be called while other threads record; with reset, each count is
+/// moved to the snapshot atomically, so no values are lost (though a value
+/// recorded during the snapshot may appear in its bucket count before its
+/// sum/min/max, or vice versa).
+/// @param[in] self histogram reference
+/// @param[in] dest snapshot (from mstats_hsnap_new)
+/// @param[in] reset if true, reset the histogram
+/// @return 0 on success, -1 otherwise
+int mstats_hist_snapshot(mstats_hist_t *self, mstats_hsnap_t *dest, bool reset)
+{
+    int retval=-1;
+
+    if (NULL!=self && NULL!=dest && NULL!=dest->counts && dest->bucket_n==self->bucket_n) {
+        uint32_t i=0;
+        uint32_t j=0;
+        uint64_t min = UINT64_MAX;
+        uint64_t max = 0;
+
+        memcpy(dest->label,self->label,MSTATS_HIST_LABEL_LEN);
+        dest->sub_bits = self->sub_bits;
+        dest->max_exp = self->max_exp;
+        dest->unit = self->unit;
+        dest->n = 0;
+        dest->sum = 0;
+        dest->overflow = 0;
+        memset(dest->counts,0,dest->bucket_n*sizeof(uint64_t));
+
+        for (i=0; i<self->shard_n; i++) {
+            mstats_hshard_t *shard = &self->shards[i];
+            uint64_t smin = (reset ? MSTATS_XCHG(&shard->min,UINT64_MAX) : MSTATS_LOAD(&shard->min));
+            uint64_t smax = (reset ? MSTATS_XCHG(&shard->max,0) : MSTATS_LOAD(&shard->max));
+
+            for (j=0; j<self->bucket_n; j++) {
+                uint64_t count = 0;
+                // skip (cheap) reads of empty buckets before swapping
+                if (MSTATS_LOAD(&shard->counts[j])==0) {
+                    continue;
+                }
+                count = (reset ? MSTATS_XCHG(&shard->counts[j],0) : MSTATS_LOAD(&shard->counts[j]));
+                dest->counts[j] += count;
+                dest->n += count;
+            }
+            dest->sum += (reset ? MSTATS_XCHG(&shard->sum,0) : MSTATS_LOAD(&shard->sum));
+            dest->overflow += (reset ? MSTATS_XCHG(&shard->overflow,0) : MSTATS_LOAD(&shard->overflow));
+            min = (smin<min ? smin : min);
+            max = (smax>max ? smax : max);
+        }
+        dest->min = (dest->n>0 ? min : 0);
+        dest->max = (dest->n>0 ? max : 0);
+        retval=0;
+    }
+    return retval;
+}
+// End function mstats_hist_snapshot
+
+/// @fn void mstats_hist_reset(mstats_hist_t *self)
+/// @brief reset histogram (clear all values)
+/// @param[in] self histogram reference
+/// @return none
+void mstats_hist_reset(mstats_hist_t *self)
+{
+    if (NULL!=self) {
+        uint32_t i=0;
+        uint32_t j=0;
+        for (i=0; i<self->shard_n; i++) {
+            mstats_hshard_t *shard = &self->shards[i];
+            for (j=0; j<self->bucket_n; j++) {
+                MSTATS_STORE(&shard->counts[j],0);
+            }
+            MSTATS_STORE(&shard->sum,0);
+            MSTATS_STORE(&shard->overflow,0);
+            MSTATS_STORE(&shard->min,UINT64_MAX);
+            MSTATS_STORE(&shard->max,0);
+        }
+    }
+}
+// End function mstats_hist_reset
+
+/// @fn mstats_hsnap_t *mstats_hsnap_new(mstats_hist_t *hist)
+/// @brief create new snapshot sized for a histogram
+/// @param[in] hist histogram reference
+/// @return mstats_hsnap_t on success, NULL otherwise
+mstats_hsnap_t *mstats_hsnap_new(mstats_hist_t *hist)
+{
+    mstats_hsnap_t *self = NULL;
+    if (NULL!=hist) {
+        self = (mstats_hsnap_t *)malloc(sizeof(mstats_hsnap_t));
+        if (NULL!=self) {
+            memset(self,0,sizeof(mstats_hsnap_t));
+            memcpy(self->label,hist->label,MSTATS_HIST_LABEL_LEN);
+            self->sub_bits = hist->sub_bits;
+            self->max_exp = hist->max_exp;
+            self->bucket_n = hist->bucket_n;
+            self->unit = hist->unit;
+            self->counts = (uint64_t *)calloc(hist->bucket_n,sizeof(uint64_t));
+            if (NULL==self->counts) {
+                free(self);
+                self=NULL;
+            }
+        }
+    }
+    return self;
+}
+// End function mstats_hsnap_new
+
+/// @fn void mstats_hsnap_destroy(mstats_hsnap_t **pself)
+/// @brief release snapshot resources
+/// @param[in] pself pointer to instance pointer
+/// @return none
+void mstats_hsnap_destroy(mstats_hsnap_t **pself)
+{
+    if (NULL!=pself && NULL!=*pself) {
+        mstats_hsnap_t *self=(*pself);
+        free(self->counts);
+        free(self);
+        *pself=NULL;
+    }
+}
+// End function mstats_hsnap_destroy
+
+/// @fn uint64_t mstats_hsnap_percentile(mstats_hsnap_t *self, double pct)
+/// @brief value at percentile: upper bound of the bucket containing
+/// the value of that rank, limited to the snapshot min/max
+/// (the max, for ranks in the last bucket if values overflowed)
+/// @param[in] self snapshot reference
+/// @param[in] pct percentile (0-100)
+/// @return value (units), 0 if snapshot is empty
+uint64_t mstats_hsnap_percentile(mstats_hsnap_t *self, double pct)
+{
+    uint64_t retval=0;
+    if (NULL!=self && self->n>0) {
+        uint64_t rank = (uint64_t)ceil((pct/100.0)*(double)self->n);
+        uint64_t cum = 0;
+        uint32_t i=0;
+
+        rank = (rank<1 ? 1 : (rank>self->n ? self->n : rank));
+        for (i=0; i<self->bucket_n; i++) {
+            cum += self->counts[i];
+            if (cum>=rank) {
+                // the last bucket includes out of range values
+                retval = ((i==self->bucket_n-1 && self->overflow>0) ? self->max : s_hist_upper(self->sub_bits,i));
+                break;
+            }
+        }
+        retval = (retval>self->max ? self->max : retval);
+        retval = (retval<self->min ? self->min : retval);
+    }
+    return retval;
+}
+// End function mstats_hsnap_percentile
+
+/// @fn double mstats_hsnap_percentile_sec(mstats_hsnap_t *self, double pct)
+/// @brief value at percentile (seconds)
+/// @param[in] self snapshot reference
+/// @param[in] pct percentile (0-100)
+/// @return value (decimal seconds), 0 if snapshot is empty
+double mstats_hsnap_percentile_sec(mstats_hsnap_t *self, double pct)
+{
+    return (NULL!=self ? (double)mstats_hsnap_percentile(self,pct)*self->unit : 0.0);
+}
+// End function mstats_hsnap_percentile_sec
+
+/// @fn double mstats_hsnap_avg_sec(mstats_hsnap_t *self)
+/// @brief average value (seconds)
+/// @param[in] self snapshot reference
+/// @return average (decimal seconds), 0 if snapshot is empty
+double mstats_hsnap_avg_sec(mstats_hsnap_t *self)
+{
+    return ((NULL!=self && self->n>0) ? ((double)self->sum/(double)self->n)*self->unit : 0.0);
+}
+// End function mstats_hsnap_avg_sec
+
+/// @fn int mstats_log_hist(mlog_id_t log_id, mstats_hsnap_t *snap, double timestamp, char *type_str)
+/// @brief log histogram summary:
+/// time,type,label,n,min,p50,p90,p99,p999,max,avg (seconds)
+/// @param[in] log_id log ID
+/// @param[in] snap snapshot reference
+/// @param[in] timestamp time
+/// @param[in] type_str channel type string
+/// @return 0 on success, -1 otherwise
+int mstats_log_hist(mlog_id_t log_id, mstats_hsnap_t *snap, double timestamp, char *type_str)
+{
+    int retval=-1;
+    if (NULL!=snap) {
+        mlog_tprintf(log_id,"%.3lf,%s,%s,%"PRIu64",%1.3g,%1.3g,%1.3g,%1.3g,%1.3g,%1.3g,%1.3g\n",
+                     timestamp,
+                     type_str,
+                     snap->label,
+                     snap->n,
+                     (double)snap->min*snap->unit,
+                     mstats_hsnap_percentile_sec(snap,50.0),
+                     mstats_hsnap_percentile_sec(snap,90.0),
+                     mstats_hsnap_percentile_sec(snap,99.0),
+                     mstats_hsnap_percentile_sec(snap,99.9),
+                     (double)snap->max*snap->unit,
+                     mstats_hsnap_avg_sec(snap));
+        retval=0;
+    }
+    return retval;
+}
+// End function mstats_log_hist
+
+/// @fn int mstats_hsnap_export(mfile_file_t *dest, mstats_hsnap_t *snap, double timestamp, mstats_hfmt_t fmt)
+/// @brief write histogram snapshot to a file (appends at the current position).
+/// CSV (values in seconds), a summary line then one line per non-empty bucket:
+///   time,hs,label,n,overflow,min,p50,p90,p99,p999,max,avg
+///   time,hb,label,lower,upper,count
+/// binary (host byte order, packed):
+///   uint32 magic (MSTATS_HIST_MAGIC), sub_bits, max_exp, bucket_n, nz_n, reserved
+///   double time, unit
+///   uint64 n, sum, min, max, overflow (units)
+///   char label[MSTATS_HIST_LABEL_LEN]
+///   nz_n x { uint32 index, uint64 count } (non-empty buckets)
+/// Bucket bounds follow from index, sub_bits (see mstats.c s_hist_lower/upper).
+/// @param[in] dest open file
+/// @param[in] snap snapshot reference
+/// @param[in] timestamp time
+/// @param[in] fmt format (MSH_FMT_CSV or MSH_FMT_BIN)
+/// @return 0 on success, -1 otherwise
+int mstats_hsnap_export(mfile_file_t *dest, mstats_hsnap_t *snap, double timestamp, mstats_hfmt_t fmt)
+{
+    int retval=-1;
+
+    if (NULL!=dest && NULL!=snap) {
+        uint32_t i=0;
+
+        if (fmt==MSH_FMT_CSV) {
+            retval=0;
+            if (mfile_fprintf(dest,"%.3lf,hs,%s,%"PRIu64",%"PRIu64",%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g\n",
+                              timestamp, snap->label, snap->n, snap->overflow,
+                              (double)snap->min*snap->unit,
+                              mstats_hsnap_percentile_sec(snap,50.0),
+                              mstats_hsnap_percentile_sec(snap,90.0),
+                              mstats_hsnap_percentile_sec(snap,99.0),
+                              mstats_hsnap_percentile_sec(snap,99.9),
+                              (double)snap->max*snap->unit,
+                              mstats_hsnap_avg_sec(snap))<0) {
+                retval=-1;
+            }
+            for (i=0; i<snap->bucket_n && retval==0; i++) {
+                if (snap->counts[i]>0 &&
+                    mfile_fprintf(dest,"%.3lf,hb,%s,%.9g,%.9g,%"PRIu64"\n",
+                                  timestamp, snap->label,
+                                  (double)s_hist_lower(snap->sub_bits,i)*snap->unit,
+                                  (double)s_hist_upper(snap->sub_bits,i)*snap->unit,
+                                  snap->counts[i])<0) {
+                    retval=-1;
+                }
+            }
+        } else if (fmt==MSH_FMT_BIN) {
+            uint32_t hdr32[6]={MSTATS_HIST_MAGIC, snap->sub_bits, snap->max_exp, snap->bucket_n, 0, 0};
+            double hdrd[2]={timestamp, snap->unit};
+            uint64_t hdr64[5]={snap->n, snap->sum, snap->min, snap->max, snap->overflow};
+            size_t hdr_len = sizeof(hdr32)+sizeof(hdrd)+sizeof(hdr64)+MSTATS_HIST_LABEL_LEN;
+            size_t rec_len = sizeof(uint32_t)+sizeof(uint64_t);
+            byte *buf = NULL;
+
+            for (i=0; i<snap->bucket_n; i++) {
+                hdr32[4] += (snap->counts[i]>0 ? 1 : 0);
+            }
+            buf = (byte *)malloc(hdr_len+hdr32[4]*rec_len);
+            if (NULL!=buf) {
+                byte *bp = buf;
+                memcpy(bp,hdr32,sizeof(hdr32));
+                bp += sizeof(hdr32);
+                memcpy(bp,hdrd,sizeof(hdrd));
+                bp += sizeof(hdrd);
+                memcpy(bp,hdr64,sizeof(hdr64));
+                bp += sizeof(hdr64);
+                memcpy(bp,snap->label,MSTATS_HIST_LABEL_LEN);
+                bp += MSTATS_HIST_LABEL_LEN;
+                for (i=0; i<snap->bucket_n; i++) {
+                    if (snap->counts[i]>0) {
+                        memcpy(bp,&i,sizeof(uint32_t));
+                        bp += sizeof(uint32_t);
+                        memcpy(bp,&snap->counts[i],sizeof(uint64_t));
+                        bp += sizeof(uint64_t);
+                    }
+                }
+                if (mfile_write(dest,buf,(uint32_t)(bp-buf))==(int64_t)(bp-buf)) {
+                    retval=0;
+                }
+                free(buf);
+            }
+        }
+    }
+    return retval;
+}
+// End function mstats_hsnap_export
+
 #if defined(WITH_MSTATS_TEST)
 /// @typedef enum mstats_event_id mstats_event_id
 /// @brief diagnostic event IDs
@@ -490,6 +974,126 @@ static void s_app_update_stats(mstats_t *stats, mlog_id_t log_id, mstats_flags f
 #define UPDATE_STATS(pstats,log_id,flags)
 #endif // MST_STATS_EN
 
+// histogram test recorder thread count, values per thread
+#define MSAPP_HIST_THREADS 4
+#define MSAPP_HIST_VALUES  250000
+
+// histogram test recorder thread: records 1..MSAPP_HIST_VALUES
+static void *s_hist_test_worker(void *arg)
+{
+    mstats_hist_t *hist = (mstats_hist_t *)arg;
+    uint64_t i=0;
+    for (i=1; i<=MSAPP_HIST_VALUES; i++) {
+        mstats_hist_record(hist,i);
+    }
+    return NULL;
+}
+
+/// @fn int mstats_hist_test()
+/// @brief histogram unit test
+/// @return 0 on success, -1 otherwise
+int mstats_hist_test()
+{
+    int retval=0;
+    uint32_t i=0;
+    uint64_t v=0;
+    mthread_thread_t *workers[MSAPP_HIST_THREADS]={0};
+
+    fprintf(stderr,"hist test start:\n");
+
+    // bucket mapping: exact below 2^sub_bits, bounded width above
+    for (v=0; v<(1<<20); v+=(v<64 ? 1 : 997)) {
+        uint32_t index = s_hist_index(5,v);
+        assert(s_hist_lower(5,index)<=v && v<=s_hist_upper(5,index));
+        assert(v<32 ? s_hist_upper(5,index)==v : (s_hist_upper(5,index)-s_hist_lower(5,index)+1)<=(v/32+1));
+        assert(index==0 || s_hist_upper(5,index-1)+1==s_hist_lower(5,index));
+    }
+
+    mstats_hist_t *hist = mstats_hist_new("test", MSTATS_HIST_SUB_BITS_DFL, MSTATS_HIST_MAX_EXP_DFL, MSAPP_HIST_THREADS, MSTATS_HIST_UNIT_NSEC);
+    mstats_hsnap_t *snap = mstats_hsnap_new(hist);
+    assert(NULL!=hist && NULL!=snap);
+
+    // concurrent recording
+    for (i=0; i<MSAPP_HIST_THREADS; i++) {
+        workers[i]=mthread_thread_new();
+        mthread_thread_start(workers[i], s_hist_test_worker, hist);
+    }
+    for (i=0; i<MSAPP_HIST_THREADS; i++) {
+        mthread_thread_join(workers[i]);
+        mthread_thread_destroy(&workers[i]);
+    }
+
+    // nothing lost; percentiles within bucket width (~3%)
+    mstats_hist_snapshot(hist, snap, true);
+    fprintf(stderr,"n[%"PRIu64"] min[%"PRIu64"] p50[%"PRIu64"] p99[%"PRIu64"] p999[%"PRIu64"] max[%"PRIu64"]\n",
+            snap->n, snap->min, mstats_hsnap_percentile(snap,50.0), mstats_hsnap_percentile(snap,99.0),
+            mstats_hsnap_percentile(snap,99.9), snap->max);
+    if (snap->n!=(uint64_t)MSAPP_HIST_THREADS*MSAPP_HIST_VALUES || snap->min!=1 || snap->max!=MSAPP_HIST_VALUES ||
+        fabs((double)mstats_hsnap_percentile(snap,50.0)/(MSAPP_HIST_VALUES*0.5)-1.0)>0.035 ||
+        fabs((double)mstats_hsnap_percentile(snap,99.0)/(MSAPP_HIST_VALUES*0.99)-1.0)>0.035 ||
+        mstats_hsnap_percentile(snap,100.0)!=MSAPP_HIST_VALUES) {
+        fprintf(stderr,"ERR - hist snapshot\n");
+        retval=-1;
+    }
+
+    // reset by snapshot
+    mstats_hist_snapshot(hist, snap, false);
+    if (snap->n!=0 || mstats_hsnap_percentile(snap,50.0)!=0) {
+        fprintf(stderr,"ERR - hist reset\n");
+        retval=-1;
+    }
+
+    // seconds, overflow
+    mstats_hist_record_sec(hist, 0.0025);
+    mstats_hist_record_sec(hist, 1.0e6);
+    mstats_hist_snapshot(hist, snap, false);
+    if (snap->n!=2 || snap->overflow!=1 || fabs(mstats_hsnap_percentile_sec(snap,50.0)/0.0025-1.0)>0.035) {
+        fprintf(stderr,"ERR - hist record_sec\n");
+        retval=-1;
+    }
+
+    // export (to temp files, removed when checked)
+    char csv_path[]="/tmp/mstats-hist-csv-XXXXXX";
+    char bin_path[]="/tmp/mstats-hist-bin-XXXXXX";
+    int csv_fd=mkstemp(csv_path);
+    int bin_fd=mkstemp(bin_path);
+    if (csv_fd<0 || bin_fd<0) {
+        fprintf(stderr,"ERR - hist export temp files\n");
+        retval=-1;
+    } else {
+        close(csv_fd);
+        close(bin_fd);
+        mfile_file_t *csv = mfile_file_new(csv_path);
+        mfile_file_t *bin = mfile_file_new(bin_path);
+        mfile_flags_t flags = MFILE_RDWR|MFILE_CREATE|MFILE_TRUNC;
+        mfile_mode_t mode = MFILE_RU|MFILE_WU|MFILE_RG|MFILE_WG;
+        if (mfile_mopen(csv,flags,mode)<=0 || mstats_hsnap_export(csv, snap, mtime_dtime(), MSH_FMT_CSV)!=0 ||
+            mfile_mopen(bin,flags,mode)<=0 || mstats_hsnap_export(bin, snap, mtime_dtime(), MSH_FMT_BIN)!=0) {
+            fprintf(stderr,"ERR - hist export\n");
+            retval=-1;
+        }
+        mfile_close(csv);
+        mfile_close(bin);
+        if (mfile_fsize(csv)<=0 || mfile_fsize(bin)<=0) {
+            fprintf(stderr,"ERR - hist export empty\n");
+            retval=-1;
+        }
+        mfile_file_destroy(&csv);
+        mfile_file_destroy(&bin);
+    }
+    if (csv_fd>=0)
+        unlink(csv_path);
+    if (bin_fd>=0)
+        unlink(bin_path);
+
+    mstats_hsnap_destroy(&snap);
+    mstats_hist_destroy(&hist);
+    assert(NULL==snap && NULL==hist);
+
+    fprintf(stderr,"hist test %s\n",(retval==0?"OK":"FAILED"));
+    return retval;
+}
+
 int mstats_test()
 {
     int retval=-1;
@@ -528,7 +1132,8 @@ int mstats_test()
     mstats_set_period(stats,mtime_dtime(),stats_period_s);
     
 	// get log handle (not an OS file handle)
-    MLOG_ID = mlog_get_instance("mstats.log",mlog_conf,"mstats test log");
+    // log under /tmp, not the working directory (e.g. the source tree)
+    MLOG_ID = mlog_get_instance("/tmp/mstats.log",mlog_conf,"mstats test log");
 
     // open log file
     mlog_open(MLOG_ID, log_flags, log_mode);
@@ -31,6 +31,16 @@
 ///   to update periodic stats, and direct output
 /// - in application code, use the macros to gather statistics, and call the update function(s)
 
+/// Latency histograms (mstats_hist_t) complement the min/max/avg metrics
+/// with percentiles. Values are counted in log-linear (HDR style) buckets:
+/// each power of two is split into 2^sub_bits linear sub-buckets, so the
+/// relative bucket width is bounded (about 3% for sub_bits=5) over the
+/// whole range. Recording is lock-free: each thread records into its own
+/// shard (threads share a shard only if there are more threads than shards),
+/// using relaxed atomic adds. A reader takes a snapshot (mstats_hsnap_t),
+/// optionally resetting the histogram, and may log its percentiles via mlog
+/// or export the buckets to a CSV or binary file.
+
 /// @sa doxygen-examples.c for more examples of Doxygen markup
 /// @sa mlog, mfile, mthread, mtime, mdebug
 
@@ -95,6 +105,7 @@
 /////////////////////////
 #include "mframe.h"
 #include "mlog.h"
+#include "mfile.h"
 #include "mtime.h"
 
 /////////////////////////
@@ -169,6 +180,16 @@
 /// @brief stats - average (or DBL_MAX if N<=0)
 #define MST_STATS_AVG(v)           ( (v.n>0 ? (double)(v.sum)/(v.n) : DBL_MAX) )
 
+/// @def MST_HIST_REC
+/// @brief histogram - record value (histogram units)
+#define MST_HIST_REC(h,v)          (mstats_hist_record(h,v))
+/// @def MST_HIST_REC_SEC
+/// @brief histogram - record time interval (decimal seconds)
+#define MST_HIST_REC_SEC(h,t)      (mstats_hist_record_sec(h,t))
+/// @def MST_HIST_LAP
+/// @brief histogram - record time since start (decimal seconds)
+#define MST_HIST_LAP(h,start,t)    (mstats_hist_record_sec(h,(t-start)))
+
 #else
 // disable (compile out) stats macros
 #define MST_METRIC_START(w,t)
@@ -188,8 +209,36 @@
 #define MST_STATS_SMAX(v,a)        0.0
 #define MST_STATS_SMIN(v,a)        0.0
 #define MST_STATS_AVG(v)           0.0
+#define MST_HIST_REC(h,v)
+#define MST_HIST_REC_SEC(h,t)
+#define MST_HIST_LAP(h,start,t)
 #endif //MST_STATS_EN
 
+/// @def MSTATS_HIST_SUB_BITS_DFL
+/// @brief default histogram sub-bucket bits (32 sub-buckets per power of 2, ~3%)
+#define MSTATS_HIST_SUB_BITS_DFL 5
+/// @def MSTATS_HIST_MAX_EXP_DFL
+/// @brief default histogram range (values < 2^max_exp units; 2^40 ns ~ 18 min)
+#define MSTATS_HIST_MAX_EXP_DFL  40
+/// @def MSTATS_HIST_SHARDS_DFL
+/// @brief default histogram shard (recording thread) count
+#define MSTATS_HIST_SHARDS_DFL   8
+/// @def MSTATS_HIST_UNIT_NSEC
+/// @brief histogram unit: nanoseconds
+#define MSTATS_HIST_UNIT_NSEC    1.0e-9
+/// @def MSTATS_HIST_UNIT_USEC
+/// @brief histogram unit: microseconds
+#define MSTATS_HIST_UNIT_USEC    1.0e-6
+/// @def MSTATS_HIST_LABEL_LEN
+/// @brief max histogram label length (including NUL)
+#define MSTATS_HIST_LABEL_LEN    32
+/// @def MSTATS_CACHE_LINE
+/// @brief cache line size (bytes); histogram shards start on separate lines
+#define MSTATS_CACHE_LINE        64
+/// @def MSTATS_HIST_MAGIC
+/// @brief binary histogram export record magic ("MSH1")
+#define MSTATS_HIST_MAGIC        0x3148534D
+
 /////////////////////////
 // Type Definitions
 /////////////////////////
@@ -282,6 +331,98 @@ typedef struct mstats_s{
     const char ***labels;
 }mstats_t;
 
+/// @typedef struct mstats_hshard_s mstats_hshard_t
+/// @brief histogram shard (counts recorded by one or more threads).
+/// Updated using atomic operations only.
+typedef struct mstats_hshard_s
+{
+    /// @var mstats_hshard_s::counts
+    /// @brief bucket counts
+    uint64_t *counts __attribute__((aligned(MSTATS_CACHE_LINE)));
+    /// @var mstats_hshard_s::sum
+    /// @brief sum of recorded values (units)
+    uint64_t sum;
+    /// @var mstats_hshard_s::min
+    /// @brief min recorded value (units)
+    uint64_t min;
+    /// @var mstats_hshard_s::max
+    /// @brief max recorded value (units)
+    uint64_t max;
+    /// @var mstats_hshard_s::overflow
+    /// @brief values out of range (counted in the last bucket)
+    uint64_t overflow;
+}mstats_hshard_t;
+
+/// @typedef struct mstats_hist_s mstats_hist_t
+/// @brief log-bucketed histogram with lock-free, per-thread recording
+typedef struct mstats_hist_s
+{
+    /// @var mstats_hist_s::label
+    /// @brief histogram label
+    char label[MSTATS_HIST_LABEL_LEN];
+    /// @var mstats_hist_s::sub_bits
+    /// @brief log2 of sub-buckets per power of 2
+    uint32_t sub_bits;
+    /// @var mstats_hist_s::max_exp
+    /// @brief values < 2^max_exp units are in range
+    uint32_t max_exp;
+    /// @var mstats_hist_s::bucket_n
+    /// @brief number of buckets
+    uint32_t bucket_n;
+    /// @var mstats_hist_s::shard_n
+    /// @brief number of shards
+    uint32_t shard_n;
+    /// @var mstats_hist_s::unit
+    /// @brief value unit (seconds), e.g. MSTATS_HIST_UNIT_NSEC
+    double unit;
+    /// @var mstats_hist_s::shards
+    /// @brief recording shards
+    mstats_hshard_t *shards;
+}mstats_hist_t;
+
+/// @typedef struct mstats_hsnap_s mstats_hsnap_t
+/// @brief histogram snapshot (merged shards)
+typedef struct mstats_hsnap_s
+{
+    /// @var mstats_hsnap_s::label
+    /// @brief histogram label
+    char label[MSTATS_HIST_LABEL_LEN];
+    /// @var mstats_hsnap_s::sub_bits
+    /// @brief log2 of sub-buckets per power of 2
+    uint32_t sub_bits;
+    /// @var mstats_hsnap_s::max_exp
+    /// @brief values < 2^max_exp units are in range
+    uint32_t max_exp;
+    /// @var mstats_hsnap_s::bucket_n
+    /// @brief number of buckets
+    uint32_t bucket_n;
+    /// @var mstats_hsnap_s::unit
+    /// @brief value unit (seconds)
+    double unit;
+    /// @var mstats_hsnap_s::n
+    /// @brief number of values
+    uint64_t n;
+    /// @var mstats_hsnap_s::sum
+    /// @brief sum of values (units)
+    uint64_t sum;
+    /// @var mstats_hsnap_s::min
+    /// @brief min value (units)
+    uint64_t min;
+    /// @var mstats_hsnap_s::max
+    /// @brief max value (units)
+    uint64_t max;
+    /// @var mstats_hsnap_s::overflow
+    /// @brief values out of range
+    uint64_t overflow;
+    /// @var mstats_hsnap_s::counts
+    /// @brief bucket counts
+    uint64_t *counts;
+}mstats_hsnap_t;
+
+/// @typedef enum mstats_hfmt_t mstats_hfmt_t
+/// @brief histogram export formats
+typedef enum {MSH_FMT_CSV=0x1, MSH_FMT_BIN=0x2}mstats_hfmt_t;
+
 /// @typedef struct mstats_profile_s mstats_profile_t
 /// @brief structure for (application) stats
 typedef struct mstats_profile_s{
@@ -312,8 +453,24 @@ extern "C" {
     mstats_profile_t *mstats_profile_new(uint32_t ev_counters, uint32_t status_counters, uint32_t tm_channels, const char ***channel_labels, double pstart, double psec);
 void mstats_profile_destroy(mstats_profile_t **pself);
 
+    // latency histogram API
+    mstats_hist_t *mstats_hist_new(const char *label, uint32_t sub_bits, uint32_t max_exp, uint32_t shards, double unit);
+    void mstats_hist_destroy(mstats_hist_t **pself);
+    void mstats_hist_record(mstats_hist_t *self, uint64_t value);
+    void mstats_hist_record_sec(mstats_hist_t *self, double sec);
+    int mstats_hist_snapshot(mstats_hist_t *self, mstats_hsnap_t *dest, bool reset);
+    void mstats_hist_reset(mstats_hist_t *self);
+    mstats_hsnap_t *mstats_hsnap_new(mstats_hist_t *hist);
+    void mstats_hsnap_destroy(mstats_hsnap_t **pself);
+    uint64_t mstats_hsnap_percentile(mstats_hsnap_t *self, double pct);
+    double mstats_hsnap_percentile_sec(mstats_hsnap_t *self, double pct);
+    double mstats_hsnap_avg_sec(mstats_hsnap_t *self);
+    int mstats_log_hist(mlog_id_t log_id, mstats_hsnap_t *snap, double timestamp, char *type_str);
+    int mstats_hsnap_export(mfile_file_t *dest, mstats_hsnap_t *snap, double timestamp, mstats_hfmt_t fmt);
+
 #if defined(WITH_MSTATS_TEST)
     int mstats_test();
+    int mstats_hist_test();
 #endif
 
 #ifdef __cplusplus
@@ -65,6 +65,8 @@
 #include "mlist.h"
 #include "mlog.h"
 #include "mbbuf.h"
+#include "mring.h"
+#include "mthread.h"
 #include "mstats.h"
 #include "mkvconf.h"
 #include "mxdebug.h"
@@ -100,6 +102,7 @@ struct mbtrnpp_ping_struct {
   double roll;
   double pitch;
   double heave;
+  double read_time;
   int beams_bath;
   int beams_amp;
   int pixels_ss;
@@ -288,6 +291,12 @@ typedef struct mbtrnpp_opts_s{
     // opt "trn-dev"
     int trn_dev;
 
+    // opt "trn-pipeline"
+    int trn_pipeline;
+
+    // opt "stats-hist"
+    int stats_hist;
+
     // opt "help"
     bool help;
 
@@ -515,6 +524,12 @@ typedef struct mbtrnpp_cfg_s{
     // TRN device enum
     int trn_dev;
 
+    // TRN pipeline queue depth (MB1 records), 0 to disable
+    int trn_pipeline;
+
+    // latency histogram export format (mstats_hfmt_t), 0 to disable
+    int stats_hist;
+
 }mbtrnpp_cfg_t;
 
 // ping buffer size default
@@ -561,6 +576,8 @@ s=NULL;\
 #define CFG_MNEM_TRN_GROUP     "TRN_GROUP"
 #define CFG_TRN_LOG_DIR_DFL    "."
 #define CFG_TRN_DEV_DFL        R7KC_DEV_T50
+#define CFG_TRN_PIPELINE_DFL   0
+#define CFG_STATS_HIST_DFL     0
 
 #define OPT_VERBOSE_DFL                   0
 #define OPT_INPUT_DFL                     CFG_INPUT_DFL
@@ -617,6 +634,13 @@ s=NULL;\
 #define OPT_RANDOM_OFFSET_ENABLE_DFL      false
 #define OPT_HELP_DFL                      false
 #define OPT_TRN_DEV_DFL                   R7KC_DEV_T50
+#define OPT_TRN_PIPELINE_DFL              0
+#define OPT_STATS_HIST_DFL                0
+
+// TRN pipeline queue depth if trn-pipeline is given without a value
+#define MBTRNPP_PIPE_DEPTH_DFL 16
+// TRN pipeline worker wait for records before checking for stop
+#define MBTRNPP_PIPE_WAIT_MSEC 100
 
 #define MNEM_MAX_LEN 64
 #define HOSTNAME_BUF_LEN 256
@@ -656,6 +680,8 @@ s=NULL;\
 #define MB1R_BLOG_NAME    "mb1rbin"
 #define MB1R_BLOG_DESC    "mb1r log (binary)"
 #define MBTRNPP_LOG_EXT   ".log"
+#define MBTRNPP_HIST_NAME "mbtrnpp-hist"
+#define MBTRNPP_HIST_FMTSTR(f) ((f)==MSH_FMT_CSV ? "csv" : ((f)==MSH_FMT_BIN ? "bin" : "none"))
 #ifdef WITH_MBTNAV
 #define UTM_MONTEREY_BAY 10L
 #define UTM_AXIAL        12L
@@ -735,6 +761,8 @@ char *reson_blog_path = NULL;
 char *trnu_alog_path = NULL;
 char *trnu_blog_path = NULL;
 char *mb1r_blog_path = NULL;
+char *mbtrnpp_hist_path = NULL;
+mfile_file_t *mbtrnpp_hist_file = NULL;
 
 mfile_flags_t flags = MFILE_RDWR | MFILE_APPEND | MFILE_CREATE;
 mfile_mode_t mode = MFILE_RU | MFILE_WU | MFILE_RG | MFILE_WG;
@@ -840,6 +868,7 @@ typedef enum {
     MBTPP_EV_EMBSOCKET,
     MBTPP_EV_EMBCON,
     MBTPP_EV_EMBPUB,
+    MBTPP_EV_MB_PIPE_DROP,
 #ifdef WITH_MBTNAV
     MBTPP_EV_TRN_PROCN,
 
@@ -870,6 +899,8 @@ typedef enum {
   MBTPP_CH_MB_CYCLE_XT,
   MBTPP_CH_MB_FWRITE_XT,
   MBTPP_CH_MB_PROC_MB1_XT,
+  MBTPP_CH_MB_PIPE_DEPTH,
+  MBTPP_CH_MB_PIPE_LAT_XT,
 #ifdef WITH_MBTNAV
     MBTPP_CH_TRN_UPDATE_XT,
     MBTPP_CH_TRN_BIASEST_XT,
@@ -891,7 +922,7 @@ typedef enum {
 const char *mbtrnpp_stevent_labels[] = {
     "mb_cycles", "mb_con", "mb_dis", "mb_pub_n", "mb_reinit", "mb_gain_lo", "mb_file",
     "mb_xyoffset", "mb_offset_z", "mb_trnucli_reset", "mb_eof", "mb_nonsurvey", "e_mbgetall", "e_mbfailure",
-    "e_mb_frame_rd", "e_mb_log_wr", "e_mbsocket", "e_mbcon", "e_mbpub"
+    "e_mb_frame_rd", "e_mb_log_wr", "e_mbsocket", "e_mbcon", "e_mbpub", "mb_pipe_drop"
 #ifdef WITH_MBTNAV
     ,"trn_proc_n","trnu_pub_n","trnu_pubempty_n","e_trnu_pub","e_trnu_pubempty"
 #endif
@@ -907,7 +938,7 @@ const char *mbtrnpp_ststatus_labels[] = {
 const char *mbtrnpp_stchan_labels[] = {
     "mb_getall_xt",  "mb_ping_xt", "mb_log_xt", "mb_dtime_xt",
     "mb_getfail_xt", "mb_post_xt", "mb_stats_xt", "mb_cycle_xt", "mb_fwrite_xt",
-    "mb_proc_mb1_xt"
+    "mb_proc_mb1_xt", "mb_pipe_depth", "mb_pipe_lat_xt"
 #ifdef WITH_MBTNAV
     , "trn_update_xt", "trn_biasest_xt", "trn_nreinits_xt",
     "trn_trnu_pub_xt", "trn_trnums_pub_xt", "trn_trnu_log_xt", "trn_trnu_blog_xt", "trn_proc_xt",
@@ -917,7 +948,18 @@ const char *mbtrnpp_stchan_labels[] = {
 
 const char **mbtrnpp_stats_labels[MSLABEL_COUNT] = {mbtrnpp_stevent_labels, mbtrnpp_ststatus_labels, mbtrnpp_stchan_labels};
 mstats_profile_t *app_stats = NULL;
+// TRN update and output stats: app_stats, or the TRN pipeline worker's own
+// profile while the pipeline runs, so that each thread updates and resets
+// only the stats it writes
+mstats_profile_t *trn_stats = NULL;
+// serializes periodic stats logging and histogram export
+mthread_mutex_t *stats_log_mutex = NULL;
 mstats_t *reader_stats = NULL;
+// ping to TRN output latency (mb_get_all return to MB1/TRN output complete)
+mstats_hist_t *app_lat_hist = NULL;
+mstats_hist_t *reader_hist = NULL;
+// histogram snapshot (all histograms use the default buckets)
+mstats_hsnap_t *app_hsnap = NULL;
 // stats interval end
 static double stats_prev_end = 0.0;
 // stats interval start
@@ -1068,6 +1110,60 @@ double use_offset_n = 0.0;
 double use_offset_z = 0.0;
 double use_covariance[4] = {0.0, 0.0, 0.0, 0.0};
 
+// TRN pipeline
+// With trn-pipeline set, the main loop reads, filters and packs MB1 records
+// and queues them for a worker thread that does the TRN update and publishes
+// the MB1 and TRN output, so a slow TRN update delays the queue rather than
+// the sonar input. The worker owns the TRN state (reinit_flag, offsets)
+// while the pipeline runs. The queue is a lock-free SPSC ring of fixed size
+// slots; records are dropped (and counted) when it is full.
+
+// TRN pipeline record header; the MB1 record follows in the queue slot
+typedef struct mbtrnpp_pipe_hdr_s{
+    // MB1 record size (bytes)
+    uint32_t mb1_size;
+    // TRN reinit requested by the reader (e.g. at file break)
+    bool reinit;
+    // no MB1 record; publish an empty TRN update (e.g. no survey data)
+    bool empty;
+    // sonar transmit gain
+    double transmit_gain;
+    // ping time, position and sensor depth
+    double time_d;
+    double navlat;
+    double navlon;
+    double sensordepth;
+    // time the record was queued (for queue latency)
+    double queue_time;
+    // time the ping was read (for ping to output latency)
+    double read_time;
+}mbtrnpp_pipe_hdr_t;
+
+typedef struct mbtrnpp_pipe_s{
+    // record queue (header, MB1 record per slot)
+    mring_spsc_t *queue;
+    // TRN worker thread
+    mthread_thread_t *worker;
+    // protects stop
+    mthread_mutex_t *mutex;
+    // stop the worker once the queue is empty
+    bool stop;
+    // transmit gain threshold for TRN updates
+    double transmit_gain_threshold;
+    // TRN reinit request, sent with the next record (reader only)
+    bool reinit_pending;
+    // TRN update and output stats (worker only)
+    mstats_profile_t *stats;
+    // reader slot buffer
+    byte *slot;
+    // record counts (reader only)
+    uint32_t n_queued;
+    uint32_t n_dropped;
+    uint32_t max_depth;
+}mbtrnpp_pipe_t;
+
+static mbtrnpp_pipe_t *mbtrnpp_pipe = NULL;
+
 char mRecordBuf[MBSYS_KMBES_MAX_NUM_MRZ_DGMS][64*1024];
 /*--------------------------------------------------------------------*/
 
@@ -1523,6 +1619,8 @@ static int s_mbtrnpp_init_cfg(mbtrnpp_cfg_t *cfg)
         cfg->reinit_zoffset_max = 0.0;
         cfg->random_offset_enable = false;
         cfg->trn_dev = CFG_TRN_DEV_DFL;
+        cfg->trn_pipeline = CFG_TRN_PIPELINE_DFL;
+        cfg->stats_hist = CFG_STATS_HIST_DFL;
         retval=0;
     }
     return retval;
@@ -1585,6 +1683,8 @@ static int s_mbtrnpp_init_opts(mbtrnpp_opts_t *opts)
         opts->reinit_zoffset_max = OPT_REINIT_ZOFFSET_MAX_DFL;
         opts->random_offset_enable = OPT_RANDOM_OFFSET_ENABLE_DFL;
         opts->trn_dev = OPT_TRN_DEV_DFL;
+        opts->trn_pipeline = OPT_TRN_PIPELINE_DFL;
+        opts->stats_hist = OPT_STATS_HIST_DFL;
         opts->help=OPT_HELP_DFL;
         retval=0;
     }
@@ -1679,6 +1779,8 @@ static int s_mbtrnpp_cfgstr(char **pdest, size_t olen, mbtrnpp_cfg_t *self, cons
     mbb_printf(optr, "%s%*s%*s%s%*.2lf%s", pre, indent, (indent>0?" ":""), wkey, "trn_status_interval_sec", sep, wval, self->trn_status_interval_sec, del);
     mbb_printf(optr, "%s%*s%*s%s%*X%s", pre, indent, (indent>0?" ":""), wkey, "mbtrnpp_stat_flags", sep, wval, self->mbtrnpp_stat_flags, del);
     mbb_printf(optr, "%s%*s%*s%s%*s/%d%s", pre, indent, (indent>0?" ":""), wkey, "trn_dev", sep, wval, r7k_devidstr(self->trn_dev), self->trn_dev, del);
+    mbb_printf(optr, "%s%*s%*s%s%*d%s", pre, indent, (indent>0?" ":""), wkey, "trn_pipeline", sep, wval, self->trn_pipeline, del);
+    mbb_printf(optr, "%s%*s%*s%s%*s%s", pre, indent, (indent>0?" ":""), wkey, "stats_hist", sep, wval, MBTRNPP_HIST_FMTSTR(self->stats_hist), del);
     mbb_printf(optr, "%s%*s%*s%s%*c%s", pre, indent, (indent>0?" ":""), wkey, "trn_enable", sep, wval, BOOL2YNC(self->trn_enable), del);
     mbb_printf(optr, "%s%*s%*s%s%*ld%s", pre, indent, (indent>0?" ":""), wkey, "trn_utm_zone", sep, wval, self->trn_utm_zone, del);
     mbb_printf(optr, "%s%*s%*s%s%*d%s", pre, indent, (indent>0?" ":""), wkey, "trn_mtype", sep, wval, self->trn_mtype, del);
@@ -1763,6 +1865,8 @@ static int s_mbtrnpp_optstr(char **pdest, size_t olen, mbtrnpp_opts_t *self, con
     mbb_printf(optr, "%s%*s%*s%s%*X/%s%s", pre, indent, (indent>0?" ":""), wkey, "statflags", sep, wval, self->statflags, self->statflags_str, del);
     mbb_printf(optr, "%s%*s%*s%s%*c%s", pre, indent, (indent>0?" ":""), wkey, "trn-en", sep, wval, BOOL2YNC(self->trn_en), del);
     mbb_printf(optr, "%s%*s%*s%s%*s/%d%s", pre, indent, (indent>0?" ":""), wkey, "trn-dev", sep, wval, r7k_devidstr(self->trn_dev), self->trn_dev, del);
+    mbb_printf(optr, "%s%*s%*s%s%*d%s", pre, indent, (indent>0?" ":""), wkey, "trn-pipeline", sep, wval, self->trn_pipeline, del);
+    mbb_printf(optr, "%s%*s%*s%s%*s%s", pre, indent, (indent>0?" ":""), wkey, "stats-hist", sep, wval, MBTRNPP_HIST_FMTSTR(self->stats_hist), del);
     mbb_printf(optr, "%s%*s%*s%s%*ld%s", pre, indent, (indent>0?" ":""), wkey, "trn-utm", sep, wval, self->trn_utm, del);
     mbb_printf(optr, "%s%*s%*s%s%*s%s", pre, indent, (indent>0?" ":""), wkey, "trn-map", sep, wval, self->trn_map, del);
     mbb_printf(optr, "%s%*s%*s%s%*s%s", pre, indent, (indent>0?" ":""), wkey, "trn-cfg", sep, wval, self->trn_cfg, del);
@@ -2553,6 +2657,21 @@ static int s_mbtrnpp_kvparse_fn(char *key, char *val, void *cfg)
                     opts->trn_dev = test;
                 }
                 retval=0;
+            } else if(strcmp(key,"trn-pipeline")==0 ){
+                if(sscanf(val,"%d",&opts->trn_pipeline)==1 && opts->trn_pipeline>=0){
+                    retval=0;
+                }
+            } else if(strcmp(key,"stats-hist")==0 ){
+                if(strcasecmp(val,"csv")==0){
+                    opts->stats_hist = MSH_FMT_CSV;
+                    retval=0;
+                } else if(strcasecmp(val,"bin")==0){
+                    opts->stats_hist = MSH_FMT_BIN;
+                    retval=0;
+                } else if(strcasecmp(val,"none")==0){
+                    opts->stats_hist = 0;
+                    retval=0;
+                }
             } else if(strcmp(key,"config")==0 ){
                 retval=0;
             } else {
@@ -2573,6 +2692,12 @@ static int s_mbtrnpp_kvparse_fn(char *key, char *val, void *cfg)
             } else if(strcmp(key,"random-offset")==0 ){
                 opts->random_offset_enable = true;
                 retval=0;
+            } else if(strcmp(key,"trn-pipeline")==0 ){
+                opts->trn_pipeline = MBTRNPP_PIPE_DEPTH_DFL;
+                retval=0;
+            } else if(strcmp(key,"stats-hist")==0 ){
+                opts->stats_hist = MSH_FMT_CSV;
+                retval=0;
             } else if(strcmp(key,"config")==0 ){
                 retval=0;
             } else if(strcmp(key,"help")==0 ){
@@ -2784,6 +2909,10 @@ static int s_mbtrnpp_configure(mbtrnpp_cfg_t *cfg, mbtrnpp_opts_t *opts)
         }
         // device
         cfg->trn_dev=opts->trn_dev;
+        // TRN pipeline
+        cfg->trn_pipeline=opts->trn_pipeline;
+        // latency histogram export
+        cfg->stats_hist=opts->stats_hist;
         retval=0;
     } else {
         fprintf(stderr, "ERR - invalid argument (NULL opts)\n");
@@ -2947,8 +3076,292 @@ static int s_mbtrnpp_validate_config(mbtrnpp_cfg_t *cfg)
     return retval;
 }
 
+/*--------------------------------------------------------------------*/
+// TRN update and MB1/TRN output for one packed MB1 record
+// called from the main loop, or from the TRN pipeline worker
+static void s_mbtrnpp_output_mb1(char *mb1, size_t mb1_size, double transmit_gain, double transmit_gain_threshold,
+                                 double time_d, double navlat, double navlon, double sensordepth, double read_time)
+{
+#ifdef WITH_MBTNAV
+
+    bool update_trn = true;
+
+    // if gain thresholding applied and gain too low, do not process and set reinit flag
+    if (mbtrn_cfg->reinit_gain_enable && (transmit_gain < transmit_gain_threshold)) {
+      update_trn = false;
+      if (!reinit_flag) {
+        fprintf(stderr, "--Reinit set due to transmit gain %f < threshold %f\n",
+                transmit_gain, transmit_gain_threshold);
+        mlog_tprintf(mbtrnpp_mlog_id,"i,set reinit due to transmit gain [%.2lf] lower than threshold [%.2lf]\n",
+                      transmit_gain, transmit_gain_threshold);
+        MST_COUNTER_INC(trn_stats->stats->events[MBTPP_EV_MB_GAIN_LO]);
+        reinit_flag = true;
+      }
+    }
+    // if ok pass filtered ping to TRN for processing
+    if (update_trn) {
+
+      // if reinit_flag set then reinit the TRN filter
+      if (reinit_flag) {
+        reinitialized = true;
+        // TRN reinit function options are:
+        //
+        //   (1) reinit w/ zero offset and default standard deviations
+        //       which correspond to the particle filter distribution widths
+        //   wtnav_reinit_filter(trn_instance, true);
+        //
+        //   (2) Reinit w/ offset set to last good offset estimate and
+        //       default standard deviations
+        //   wtnav_reinit_filter_offset(trn_instance, true, use_offset_n, use_offset_e, use_offset_z);
+        //
+        //   (3) Reinit w/ offset set to last good offset estimate and
+        //       specified standard deviations (here set to default values)
+        //   d_triplet_t xyz_sdev={0., 0., 0.};
+        //   wtnav_get_init_stddev_xyz(trn_instance, &xyz_sdev);
+        //   wtnav_reinit_filter_box(trn_instance, true, use_offset_n, use_offset_e, use_offset_z,
+        //                                              xyz_sdev.x, xyz_sdev.y, xyz_sdev.z);
+        //
+        d_triplet_t xyz_sdev={0., 0., 0.};
+        xyz_sdev.x = MIN((n_reinit_since_use + 1), 10) * mbtrn_cfg->reinit_search_xy;
+        xyz_sdev.y = xyz_sdev.x;
+        xyz_sdev.z = mbtrn_cfg->reinit_search_z;
+        //wtnav_get_init_stddev_xyz(trn_instance, &xyz_sdev);
+        fprintf(stderr, "--reinit time_d:%.6f centered on offset: %f %f %f  sd: %f %f %f\n",
+                      time_d, use_offset_e, use_offset_n, use_offset_z,
+                      xyz_sdev.x, xyz_sdev.y, xyz_sdev.z);
+        wtnav_reinit_filter_box(trn_instance, true, use_offset_n, use_offset_e, use_offset_z,
+                                  xyz_sdev.x, xyz_sdev.y, xyz_sdev.z);
+
+        mlog_tprintf(mbtrnpp_mlog_id, "i,trn filter reinit time_d:%.6f centered on offset: %f %f %f\n",
+                      time_d, use_offset_e, use_offset_n, use_offset_z);
+        MST_COUNTER_INC(trn_stats->stats->events[MBTPP_EV_MB_REINIT]);
+        reinit_flag = false;
+        n_reinit++;
+        n_reinit_since_use++;
+        reinit_time = time_d;
+      }
+
+      MST_METRIC_START(trn_stats->stats->metrics[MBTPP_CH_TRN_PROC_TRN_XT], mtime_dtime());
+
+      // do TRN processing, output, and tests for reinitializing TRN
+      mbtrnpp_trn_process_mb1(trn_instance, (mb1_t *)mb1, trn_cfg);
+
+      MST_METRIC_LAP(trn_stats->stats->metrics[MBTPP_CH_TRN_PROC_TRN_XT], mtime_dtime());
+
+    }
+
+    else {
+        int time_i[7];
+        mb_get_date(0, time_d, time_i);
+        fprintf(stderr, "%4.4d/%2.2d/%2.2d-%2.2d:%2.2d:%2.2d.%6.6d %.6f "
+                        "| %11.6f %11.6f %8.3f | Ping not processed - low gain condition\n",
+        time_i[0], time_i[1], time_i[2], time_i[3], time_i[4], time_i[5], time_i[6], time_d,
+        navlon, navlat, sensordepth);
+        mbtrnpp_trnu_pubempty_osocket(time_d, navlat, navlon, sensordepth, trnusvr);
+    }
+
+#endif // WITH_MBTNAV
+
+    // begin: move after TRN update for sim sync
+    MST_METRIC_START(trn_stats->stats->metrics[MBTPP_CH_MB_PROC_MB1_XT], mtime_dtime());
+
+    // do MB1 processing/output
+    // after TRN processing/update to enable synchronization, e.g. with sim
+    // i.e. when MB1 record is published, TRN processing has completed
+    mbtrnpp_process_mb1(mb1, mb1_size, trn_cfg);
+
+    MST_METRIC_LAP(trn_stats->stats->metrics[MBTPP_CH_MB_PROC_MB1_XT], mtime_dtime());
+    // end: move after TRN update for sim sync
+
+    MST_HIST_LAP(app_lat_hist, read_time, mtime_dtime());
+
+    MBTRNPP_UPDATE_STATS(trn_stats, mbtrnpp_mlog_id, mbtrn_cfg->mbtrnpp_stat_flags);
+}
+
+/*--------------------------------------------------------------------*/
+// TRN pipeline worker: takes records off the queue and outputs them,
+// until stopped and the queue is empty
+static void *s_mbtrnpp_pipe_worker(void *arg)
+{
+    mbtrnpp_pipe_t *self = (mbtrnpp_pipe_t *)arg;
+    byte *slot = (byte *)malloc(self->queue->elem_size);
+    mbtrnpp_pipe_hdr_t hdr;
+
+    while (NULL != slot) {
+        // records queued before stop was set are still read below
+        mthread_mutex_lock(self->mutex);
+        bool stop = self->stop;
+        mthread_mutex_unlock(self->mutex);
+
+        if (mring_spsc_pop(self->queue, slot, 1, MBTRNPP_PIPE_WAIT_MSEC) != 1) {
+            if (stop)
+                break;
+            continue;
+        }
+
+        memcpy(&hdr, slot, sizeof(hdr));
+        char *mb1 = (char *)(slot + sizeof(hdr));
+
+        if (hdr.empty) {
+            mbtrnpp_trnu_pubempty_osocket(hdr.time_d, hdr.navlat, hdr.navlon, hdr.sensordepth, trnusvr);
+            continue;
+        }
+
+        MST_METRIC_SET(trn_stats->stats->metrics[MBTPP_CH_MB_PIPE_LAT_XT], (mtime_dtime() - hdr.queue_time));
+
+        // force a reinit requested by the reader
+        if (hdr.reinit && !reinit_flag) {
+            fprintf(stderr, "--Reinit set due to closing input swath file\n");
+            MST_COUNTER_INC(trn_stats->stats->events[MBTPP_EV_MB_EOF]);
+            reinit_flag = true;
+        }
+
+        s_mbtrnpp_output_mb1(mb1, hdr.mb1_size, hdr.transmit_gain, self->transmit_gain_threshold,
+                             hdr.time_d, hdr.navlat, hdr.navlon, hdr.sensordepth, hdr.read_time);
+    }
+
+    free(slot);
+    return NULL;
+}
+
+/*--------------------------------------------------------------------*/
+// create a TRN pipeline holding up to depth (rounded up to a power of 2)
+// records of up to mb1_max bytes, and start its worker
+static mbtrnpp_pipe_t *s_mbtrnpp_pipe_new(int depth, uint32_t mb1_max, double transmit_gain_threshold)
+{
+    mbtrnpp_pipe_t *self = (mbtrnpp_pipe_t *)malloc(sizeof(mbtrnpp_pipe_t));
+    if (NULL != self) {
+        memset(self, 0, sizeof(mbtrnpp_pipe_t));
+        self->transmit_gain_threshold = transmit_gain_threshold;
+        self->queue = mring_spsc_new(depth, sizeof(mbtrnpp_pipe_hdr_t) + mb1_max);
+        self->mutex = mthread_mutex_new();
+        self->worker = mthread_thread_new();
+        self->stats = mstats_profile_new(MBTPP_EV_COUNT, MBTPP_STA_COUNT, MBTPP_CH_COUNT, mbtrnpp_stats_labels,
+                                         mtime_dtime(), mbtrn_cfg->trn_status_interval_sec);
+        if (NULL != self->queue)
+            self->slot = (byte *)malloc(self->queue->elem_size);
+        // the worker keeps its stats apart from the main loop's
+        if (NULL != self->stats)
+            trn_stats = self->stats;
+        if (NULL == self->queue || NULL == self->slot || NULL == self->mutex || NULL == self->worker ||
+            NULL == self->stats || mthread_thread_start(self->worker, s_mbtrnpp_pipe_worker, self) != 0) {
+            fprintf(stderr, "%s:%d - ERR TRN pipeline start failed\n", __FUNCTION__, __LINE__);
+            trn_stats = app_stats;
+            mstats_profile_destroy(&self->stats);
+            mring_spsc_destroy(&self->queue);
+            mthread_mutex_destroy(&self->mutex);
+            mthread_thread_destroy(&self->worker);
+            free(self->slot);
+            free(self);
+            self = NULL;
+        }
+    }
+    return self;
+}
+
+/*--------------------------------------------------------------------*/
+// stop the TRN pipeline worker once the queued records are processed,
+// and release the pipeline
+static void s_mbtrnpp_pipe_destroy(mbtrnpp_pipe_t **pself)
+{
+    if (NULL != pself && NULL != *pself) {
+        mbtrnpp_pipe_t *self = *pself;
+
+        mthread_mutex_lock(self->mutex);
+        self->stop = true;
+        mthread_mutex_unlock(self->mutex);
+        mthread_thread_join(self->worker);
+        trn_stats = app_stats;
+
+        mstats_profile_destroy(&self->stats);
+        mthread_thread_destroy(&self->worker);
+        mthread_mutex_destroy(&self->mutex);
+        mring_spsc_destroy(&self->queue);
+        free(self->slot);
+        free(self);
+        *pself = NULL;
+    }
+}
+
+/*--------------------------------------------------------------------*/
+// queue an MB1 record for the TRN pipeline worker
+// returns 0 on success, -1 if the queue is full and the record was dropped
+static int s_mbtrnpp_pipe_push(mbtrnpp_pipe_t *self, char *mb1, size_t mb1_size, double transmit_gain,
+                               double time_d, double navlat, double navlon, double sensordepth, double read_time)
+{
+    int retval = -1;
+
+    if (sizeof(mbtrnpp_pipe_hdr_t) + mb1_size <= self->queue->elem_size) {
+        mbtrnpp_pipe_hdr_t hdr;
+        memset(&hdr, 0, sizeof(hdr));
+        hdr.mb1_size = mb1_size;
+        hdr.reinit = self->reinit_pending;
+        hdr.transmit_gain = transmit_gain;
+        hdr.time_d = time_d;
+        hdr.navlat = navlat;
+        hdr.navlon = navlon;
+        hdr.sensordepth = sensordepth;
+        hdr.queue_time = mtime_dtime();
+        hdr.read_time = read_time;
+        memcpy(self->slot, &hdr, sizeof(hdr));
+        memcpy(self->slot + sizeof(hdr), mb1, mb1_size);
+
+        if (mring_spsc_push(self->queue, self->slot, 1, MRING_NOWAIT) == 1) {
+            uint32_t depth = mring_spsc_available(self->queue);
+            self->reinit_pending = false;
+            self->n_queued++;
+            if (depth > self->max_depth)
+                self->max_depth = depth;
+            MST_METRIC_SET(app_stats->stats->metrics[MBTPP_CH_MB_PIPE_DEPTH], depth);
+            retval = 0;
+        }
+    }
+
+    if (retval != 0) {
+        self->n_dropped++;
+        MST_COUNTER_INC(app_stats->stats->events[MBTPP_EV_MB_PIPE_DROP]);
+    }
+    return retval;
+}
+
+/*--------------------------------------------------------------------*/
+// queue an empty TRN update for the TRN pipeline worker to publish,
+// so that only the worker writes TRN output while the pipeline runs
+// returns 0 on success, -1 if the queue is full and the update was dropped
+static int s_mbtrnpp_pipe_push_empty(mbtrnpp_pipe_t *self, double time_d, double navlat, double navlon,
+                                     double sensordepth)
+{
+    int retval = -1;
+
+    mbtrnpp_pipe_hdr_t hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.empty = true;
+    hdr.time_d = time_d;
+    hdr.navlat = navlat;
+    hdr.navlon = navlon;
+    hdr.sensordepth = sensordepth;
+    hdr.queue_time = mtime_dtime();
+    hdr.read_time = hdr.queue_time;
+    memcpy(self->slot, &hdr, sizeof(hdr));
+
+    if (mring_spsc_push(self->queue, self->slot, 1, MRING_NOWAIT) == 1) {
+        uint32_t depth = mring_spsc_available(self->queue);
+        if (depth > self->max_depth)
+            self->max_depth = depth;
+        MST_METRIC_SET(app_stats->stats->metrics[MBTPP_CH_MB_PIPE_DEPTH], depth);
+        retval = 0;
+    }
+    else {
+        self->n_dropped++;
+        MST_COUNTER_INC(app_stats->stats->events[MBTPP_EV_MB_PIPE_DROP]);
+    }
+    return retval;
+}
+
 static void s_mbtrnpp_release_resources()
 {
+    // stop the TRN pipeline before releasing what it uses
+    s_mbtrnpp_pipe_destroy(&mbtrnpp_pipe);
 
     fprintf(stderr,"release output servers...\n");
     // release output servers
@@ -2966,6 +3379,14 @@ static void s_mbtrnpp_release_resources()
     fprintf(stderr,"release stats instance...\n");
    // release stats instance
     mstats_profile_destroy(&app_stats);
+    trn_stats = NULL;
+    mthread_mutex_destroy(&stats_log_mutex);
+    mstats_hist_destroy(&app_lat_hist);
+    mstats_hsnap_destroy(&app_hsnap);
+    if (NULL != mbtrnpp_hist_file) {
+        mfile_close(mbtrnpp_hist_file);
+        mfile_file_destroy(&mbtrnpp_hist_file);
+    }
 
     fprintf(stderr,"release log instances...\n");
 	// release log instances
@@ -2982,6 +3403,7 @@ static void s_mbtrnpp_release_resources()
     // release log paths
     MEM_CHKFREE(mb1_blog_path);
     MEM_CHKFREE(mbtrnpp_mlog_path);
+    MEM_CHKFREE(mbtrnpp_hist_path);
     MEM_CHKFREE(reson_blog_path);
     MEM_CHKFREE(trnu_alog_path);
     MEM_CHKFREE(trnu_blog_path);
@@ -3034,6 +3456,8 @@ int main(int argc, char **argv) {
                          "\t--delay=n\n"
                          "\t--trn-en\n"
                          "\t--trn-dev=s\n"
+                         "\t--trn-pipeline[=n]\n"
+                         "\t--stats-hist[=csv|bin|none]\n"
                          "\t--trn-utm\n"
                          "\t--trn-map\n"
                          "\t--trn-par\n"
@@ -3692,6 +4116,26 @@ int main(int argc, char **argv) {
   int n_ping_process = mbtrn_cfg->n_buffer_max / 2;
   int idataread = 0;
 
+  // start the TRN pipeline, if enabled
+  if (mbtrn_cfg->trn_pipeline > 0 && !OUTPUT_FLAGS_ZERO()) {
+    uint32_t mb1_max = MBTRNPREPROCESS_MB1_HEADER_SIZE + mbtrn_cfg->n_output_soundings * MBTRNPREPROCESS_MB1_SOUNDING_SIZE +
+                       MBTRNPREPROCESS_MB1_CHECKSUM_SIZE;
+    if ((mbtrnpp_pipe = s_mbtrnpp_pipe_new(mbtrn_cfg->trn_pipeline, mb1_max, transmit_gain_threshold)) != NULL) {
+      fprintf(stderr, "TRN pipeline enabled - queue depth %d\n", mbtrn_cfg->trn_pipeline);
+      mlog_tprintf(mbtrnpp_mlog_id, "i,TRN pipeline enabled depth[%d]\n", mbtrn_cfg->trn_pipeline);
+    }
+    else {
+      fprintf(stderr, "\nUnable to start TRN pipeline\n");
+      fprintf(stderr, "\nProgram <%s> Terminated\n", program_name);
+      mlog_tprintf(mbtrnpp_mlog_id, "e,unable to start TRN pipeline\n");
+      s_mbtrnpp_exit(MB_ERROR_MEMORY_FAIL);
+    }
+  }
+
+  // MB1 records output, for the replay summary
+  unsigned int n_output_records = 0;
+  double replay_start_time = mtime_dtime();
+
     /* loop over all files to be read */
   while (read_data == true) {
       char log_message[LOG_MSG_BUF_SZ];
@@ -4051,6 +4495,7 @@ int main(int argc, char **argv) {
       }
       if (status == MB_SUCCESS && kind == MB_DATA_DATA) {
         ping[idataread].count = ndata;
+        ping[idataread].read_time = mtime_dtime();
         ndata++;
         n_pings_read++;
         n_soundings_read += ping[idataread].beams_bath;
@@ -4356,100 +4801,23 @@ int main(int argc, char **argv) {
 //                MST_METRIC_LAP(app_stats->stats->metrics[MBTPP_CH_MB_PROC_MB1_XT], mtime_dtime());
                 // end: move after TRN update for sim sync
 
-#ifdef WITH_MBTNAV
+                if (NULL != mbtrnpp_pipe) {
+                    // queue for TRN update and output by the pipeline worker
+                    s_mbtrnpp_pipe_push(mbtrnpp_pipe, output_buffer, mb1_size, transmit_gain,
+                                        ping[i_ping_process].time_d, ping[i_ping_process].navlat,
+                                        ping[i_ping_process].navlon, ping[i_ping_process].sensordepth,
+                                        ping[i_ping_process].read_time);
 
-                bool update_trn = true;
-
-                // if gain thresholding applied and gain too low, do not process and set reinit flag
-                if (mbtrn_cfg->reinit_gain_enable && (transmit_gain < transmit_gain_threshold)) {
-                  update_trn = false;
-                  if (!reinit_flag) {
-                    fprintf(stderr, "--Reinit set due to transmit gain %f < threshold %f\n",
-                            transmit_gain, transmit_gain_threshold);
-                    mlog_tprintf(mbtrnpp_mlog_id,"i,set reinit due to transmit gain [%.2lf] lower than threshold [%.2lf]\n",
-                                  transmit_gain, transmit_gain_threshold);
-                    MST_COUNTER_INC(app_stats->stats->events[MBTPP_EV_MB_GAIN_LO]);
-                    reinit_flag = true;
-                  }
-                }
-                // if ok pass filtered ping to TRN for processing
-                if (update_trn) {
-
-                  // if reinit_flag set then reinit the TRN filter
-                  if (reinit_flag) {
-                    reinitialized = true;
-                    // TRN reinit function options are:
-                    //
-                    //   (1) reinit w/ zero offset and default standard deviations
-                    //       which correspond to the particle filter distribution widths
-                    //   wtnav_reinit_filter(trn_instance, true);
-                    //
-                    //   (2) Reinit w/ offset set to last good offset estimate and
-                    //       default standard deviations
-                    //   wtnav_reinit_filter_offset(trn_instance, true, use_offset_n, use_offset_e, use_offset_z);
-                    //
-                    //   (3) Reinit w/ offset set to last good offset estimate and
-                    //       specified standard deviations (here set to default values)
-                    //   d_triplet_t xyz_sdev={0., 0., 0.};
-                    //   wtnav_get_init_stddev_xyz(trn_instance, &xyz_sdev);
-                    //   wtnav_reinit_filter_box(trn_instance, true, use_offset_n, use_offset_e, use_offset_z,
-                    //                                              xyz_sdev.x, xyz_sdev.y, xyz_sdev.z);
-                    //
-                    d_triplet_t xyz_sdev={0., 0., 0.};
-                    xyz_sdev.x = MIN((n_reinit_since_use + 1), 10) * mbtrn_cfg->reinit_search_xy;
-                    xyz_sdev.y = xyz_sdev.x;
-                    xyz_sdev.z = mbtrn_cfg->reinit_search_z;
-                    //wtnav_get_init_stddev_xyz(trn_instance, &xyz_sdev);
-                    fprintf(stderr, "--reinit time_d:%.6f centered on offset: %f %f %f  sd: %f %f %f\n",
-                                  ping[i_ping_process].time_d, use_offset_e, use_offset_n, use_offset_z,
-                                  xyz_sdev.x, xyz_sdev.y, xyz_sdev.z);
-                    wtnav_reinit_filter_box(trn_instance, true, use_offset_n, use_offset_e, use_offset_z,
-                                              xyz_sdev.x, xyz_sdev.y, xyz_sdev.z);
-
-                    mlog_tprintf(mbtrnpp_mlog_id, "i,trn filter reinit time_d:%.6f centered on offset: %f %f %f\n",
-                                  ping[i_ping_process].time_d, use_offset_e, use_offset_n, use_offset_z);
-                    MST_COUNTER_INC(app_stats->stats->events[MBTPP_EV_MB_REINIT]);
-                    reinit_flag = false;
-                    n_reinit++;
-                    n_reinit_since_use++;
-                    reinit_time = ping[i_ping_process].time_d;
-                  }
-
-                  MST_METRIC_START(app_stats->stats->metrics[MBTPP_CH_TRN_PROC_TRN_XT], mtime_dtime());
-
-                  // do TRN processing, output, and tests for reinitializing TRN
-                  mbtrnpp_trn_process_mb1(trn_instance, (mb1_t *)output_buffer, trn_cfg);
-
-                  MST_METRIC_LAP(app_stats->stats->metrics[MBTPP_CH_TRN_PROC_TRN_XT], mtime_dtime());
-
-                }
-
-                else {
-                    int time_i[7];
-                    mb_get_date(0, ping[i_ping_process].time_d, time_i);
-                    fprintf(stderr, "%4.4d/%2.2d/%2.2d-%2.2d:%2.2d:%2.2d.%6.6d %.6f "
-                                    "| %11.6f %11.6f %8.3f | Ping not processed - low gain condition\n",
-                    time_i[0], time_i[1], time_i[2], time_i[3], time_i[4], time_i[5], time_i[6], ping[i_ping_process].time_d,
-                    ping[i_ping_process].navlon, ping[i_ping_process].navlat, ping[i_ping_process].sensordepth);
-                    mbtrnpp_trnu_pubempty_osocket(ping[i_ping_process].time_d, ping[i_ping_process].navlat,
-                      ping[i_ping_process].navlon, ping[i_ping_process].sensordepth,trnusvr);
+                    // the worker updates its own stats; update the reader's here
+                    MBTRNPP_UPDATE_STATS(app_stats, mbtrnpp_mlog_id, mbtrn_cfg->mbtrnpp_stat_flags);
+                } else {
+                    // do TRN update and output
+                    s_mbtrnpp_output_mb1(output_buffer, mb1_size, transmit_gain, transmit_gain_threshold,
+                                         ping[i_ping_process].time_d, ping[i_ping_process].navlat,
+                                         ping[i_ping_process].navlon, ping[i_ping_process].sensordepth,
+                                         ping[i_ping_process].read_time);
                 }
-
-#endif // WITH_MBTNAV
-
-                // begin: move after TRN update for sim sync
-                MST_METRIC_START(app_stats->stats->metrics[MBTPP_CH_MB_PROC_MB1_XT], mtime_dtime());
-
-                // do MB1 processing/output
-                // after TRN processing/update to enable synchronization, e.g. with sim
-                // i.e. when MB1 record is published, TRN processing has completed
-                mbtrnpp_process_mb1(output_buffer, mb1_size, trn_cfg);
-
-                MST_METRIC_LAP(app_stats->stats->metrics[MBTPP_CH_MB_PROC_MB1_XT], mtime_dtime());
-                // end: move after TRN update for sim sync
-
-
-                MBTRNPP_UPDATE_STATS(app_stats, mbtrnpp_mlog_id, mbtrn_cfg->mbtrnpp_stat_flags);
+                n_output_records++;
 
             } // end MBTRNPREPROCESS_OUTPUT_TRN
 
@@ -4541,7 +4909,12 @@ int main(int argc, char **argv) {
               }
             }
             double dzero = 0.0;
-            mbtrnpp_trnu_pubempty_osocket(ping[idataread].time_d, dzero, dzero, dzero, trnusvr);
+            if (NULL != mbtrnpp_pipe) {
+              // the TRN pipeline worker owns TRN output
+              s_mbtrnpp_pipe_push_empty(mbtrnpp_pipe, ping[idataread].time_d, dzero, dzero, dzero);
+            } else {
+              mbtrnpp_trnu_pubempty_osocket(ping[idataread].time_d, dzero, dzero, dzero, trnusvr);
+            }
           }
         }
         MST_METRIC_LAP(app_stats->stats->metrics[MBTPP_CH_MB_GETFAIL_XT], mtime_dtime());
@@ -4582,7 +4955,12 @@ int main(int argc, char **argv) {
       fprintf(stderr, "%s\n", log_message);
 
       // force a reinit when data from the next file is opened
-      if (mbtrn_cfg->reinit_file_enable && !reinit_flag) {
+      // (the TRN pipeline worker owns reinit_flag, so pass it the request)
+      if (mbtrn_cfg->reinit_file_enable && NULL != mbtrnpp_pipe) {
+        mlog_tprintf(mbtrnpp_mlog_id,"i,mbtrnpp: request reinit due to closing input swath file [%s]\n", ifile);
+        mbtrnpp_pipe->reinit_pending = true;
+      }
+      else if (mbtrn_cfg->reinit_file_enable && !reinit_flag) {
         fprintf(stderr, "--Reinit set due to closing input swath file\n");
           mlog_tprintf(mbtrnpp_mlog_id,"i,mbtrnpp: set reinit due to closing input swath file [%s]\n", ifile);
         MST_COUNTER_INC(app_stats->stats->events[MBTPP_EV_MB_EOF]);
@@ -4614,6 +4992,28 @@ int main(int argc, char **argv) {
 
   fprintf(stderr, "\nDone reading data\n");
   mlog_tprintf(mbtrnpp_mlog_id,"i,closing data list - OK\n");
+
+  // finish the queued TRN updates
+  uint32_t n_pipe_dropped = 0;
+  uint32_t n_pipe_max_depth = 0;
+  if (NULL != mbtrnpp_pipe) {
+    n_pipe_dropped = mbtrnpp_pipe->n_dropped;
+    n_pipe_max_depth = mbtrnpp_pipe->max_depth;
+    s_mbtrnpp_pipe_destroy(&mbtrnpp_pipe);
+  }
+
+  // replay summary - reading files, input runs as fast as processing allows
+  if (mbtrn_cfg->input_mode == INPUT_MODE_FILE && n_output_records > 0) {
+    double replay_time = mtime_dtime() - replay_start_time;
+    fprintf(stderr, "Replay: %u MB1 records in %.3lf s (%.1lf records/s)\n", n_output_records, replay_time,
+            (replay_time > 0.0 ? n_output_records / replay_time : 0.0));
+    if (mbtrn_cfg->trn_pipeline > 0) {
+      fprintf(stderr, "Replay: TRN pipeline depth %d max queued %u dropped %u\n", mbtrn_cfg->trn_pipeline,
+              n_pipe_max_depth, n_pipe_dropped);
+    }
+    mlog_tprintf(mbtrnpp_mlog_id, "i,replay records[%u] time[%.3lf] pipeline[%d] max_queued[%u] dropped[%u]\n",
+                 n_output_records, replay_time, mbtrn_cfg->trn_pipeline, n_pipe_max_depth, n_pipe_dropped);
+  }
   if (read_datalist == true) {
     mb_datalist_close(mbtrn_cfg->verbose, &datalist, &error);
     fprintf(stderr, "Closed input datalist\n");
@@ -5011,6 +5411,20 @@ int mbtrnpp_logstatistics(int verbose, FILE *logfp, int n_pings_read, int n_soun
   return (status);
 }
 
+/*--------------------------------------------------------------------*/
+// snapshot and reset a latency histogram; log its percentiles and
+// append it to the histogram export file (if enabled)
+static void s_mbtrnpp_emit_hist(mstats_hist_t *hist, mlog_id_t log_id, double now)
+{
+    if (NULL != hist && mstats_hist_snapshot(hist, app_hsnap, true) == 0) {
+        mstats_log_hist(log_id, app_hsnap, now, "h");
+        if (NULL != mbtrnpp_hist_file &&
+            mstats_hsnap_export(mbtrnpp_hist_file, app_hsnap, now, (mstats_hfmt_t)mbtrn_cfg->stats_hist) != 0) {
+            fprintf(stderr, "%s:%d - ERR histogram export failed [%s]\n", __FUNCTION__, __LINE__, hist->label);
+        }
+    }
+}
+
 /*--------------------------------------------------------------------*/
 
 int mbtrnpp_update_stats(mstats_profile_t *stats, mlog_id_t log_id, mstats_flags flags) {
@@ -5019,53 +5433,67 @@ int mbtrnpp_update_stats(mstats_profile_t *stats, mlog_id_t log_id, mstats_flags
       double stats_now = mtime_etime();
       double stats_nowd = mtime_dtime();
 
-    if (log_clock_res) {
-      // log the timing clock resolution (once)
-      struct timespec res;
-      clock_getres(CLOCK_MONOTONIC, &res);
-      mlog_tprintf(mbtrnpp_mlog_id, "%.3lf,i,clkres_mono,s[%ld] ns[%ld]\n", stats_now, res.tv_sec, res.tv_nsec);
-      log_clock_res = false;
-    }
+    // the main loop owns app_stats, the cycle timing and the reader stats;
+    // the thread doing TRN updates and output owns trn_stats, the server
+    // stats and the latency histogram. Without the TRN pipeline both are
+    // the main loop, and app_stats and trn_stats are the same profile.
+    bool update_input = (stats == app_stats);
+    bool update_output = (stats == trn_stats);
+
+    if (update_input) {
+      if (log_clock_res) {
+        // log the timing clock resolution (once)
+        struct timespec res;
+        clock_getres(CLOCK_MONOTONIC, &res);
+        mlog_tprintf(mbtrnpp_mlog_id, "%.3lf,i,clkres_mono,s[%ld] ns[%ld]\n", stats_now, res.tv_sec, res.tv_nsec);
+        log_clock_res = false;
+      }
 
-    // we can only measure the previous stats cycle...
-    if (stats->stats->per_stats[MBTPP_CH_MB_CYCLE_XT].n > 0) {
-      // get the timing of the last cycle
-      MST_METRIC_START(app_stats->stats->metrics[MBTPP_CH_MB_STATS_XT], stats_prev_start);
-      MST_METRIC_LAP(app_stats->stats->metrics[MBTPP_CH_MB_STATS_XT], stats_prev_end);
-    }
-    else {
-      // seed the first cycle
-      MST_METRIC_START(app_stats->stats->metrics[MBTPP_CH_MB_STATS_XT], (stats_nowd - 0.0001));
-      MST_METRIC_LAP(app_stats->stats->metrics[MBTPP_CH_MB_STATS_XT], stats_nowd);
-    }
+      // we can only measure the previous stats cycle...
+      if (stats->stats->per_stats[MBTPP_CH_MB_CYCLE_XT].n > 0) {
+        // get the timing of the last cycle
+        MST_METRIC_START(app_stats->stats->metrics[MBTPP_CH_MB_STATS_XT], stats_prev_start);
+        MST_METRIC_LAP(app_stats->stats->metrics[MBTPP_CH_MB_STATS_XT], stats_prev_end);
+      }
+      else {
+        // seed the first cycle
+        MST_METRIC_START(app_stats->stats->metrics[MBTPP_CH_MB_STATS_XT], (stats_nowd - 0.0001));
+        MST_METRIC_LAP(app_stats->stats->metrics[MBTPP_CH_MB_STATS_XT], stats_nowd);
+      }
 
-    // end the cycle timer here
-    // [start at the end if this function]
-    MST_METRIC_LAP(app_stats->stats->metrics[MBTPP_CH_MB_CYCLE_XT], stats_nowd);
+      // end the cycle timer here
+      // [start at the end if this function]
+      MST_METRIC_LAP(app_stats->stats->metrics[MBTPP_CH_MB_CYCLE_XT], stats_nowd);
 
-    // measure dtime execution time (twice), while we're at it
-    MST_METRIC_START(app_stats->stats->metrics[MBTPP_CH_MB_DTIME_XT], mtime_dtime());
-    MST_METRIC_LAP(app_stats->stats->metrics[MBTPP_CH_MB_DTIME_XT], mtime_dtime());
-    MST_METRIC_DIV(app_stats->stats->metrics[MBTPP_CH_MB_DTIME_XT], 2.0);
+      // measure dtime execution time (twice), while we're at it
+      MST_METRIC_START(app_stats->stats->metrics[MBTPP_CH_MB_DTIME_XT], mtime_dtime());
+      MST_METRIC_LAP(app_stats->stats->metrics[MBTPP_CH_MB_DTIME_XT], mtime_dtime());
+      MST_METRIC_DIV(app_stats->stats->metrics[MBTPP_CH_MB_DTIME_XT], 2.0);
+    }
 
     // update uptime
     stats->uptime = stats_now - stats->session_start;
 
+    if (update_input) {
       MX_LPRINT(MBTRNPP, 4, "cycle_xt: stat_now[%.4lf] stat_nowd[%.4lf] start[%.4lf] stop[%.4lf] value[%.4lf]\n", stats_now,stats_nowd,
              app_stats->stats->metrics[MBTPP_CH_MB_CYCLE_XT].start, app_stats->stats->metrics[MBTPP_CH_MB_CYCLE_XT].stop,
              app_stats->stats->metrics[MBTPP_CH_MB_CYCLE_XT].value);
+    }
 
     // update stats
     mstats_update_stats(stats->stats, MBTPP_CH_COUNT, flags);
     mstats_t *mb1svr_stats = netif_stats(mb1svr);
-    mstats_update_stats(mb1svr_stats, NETIF_CH_COUNT, flags);
     mstats_t *trnsvr_stats = netif_stats(trnsvr);
-    mstats_update_stats(trnsvr_stats, NETIF_CH_COUNT, flags);
     mstats_t *trnusvr_stats = netif_stats(trnusvr);
-    mstats_update_stats(trnusvr_stats, NETIF_CH_COUNT, flags);
     mstats_t *trnumsvr_stats = netif_stats(trnumsvr);
-    mstats_update_stats(trnumsvr_stats, NETIF_CH_COUNT, flags);
+    if (update_output) {
+      mstats_update_stats(mb1svr_stats, NETIF_CH_COUNT, flags);
+      mstats_update_stats(trnsvr_stats, NETIF_CH_COUNT, flags);
+      mstats_update_stats(trnusvr_stats, NETIF_CH_COUNT, flags);
+      mstats_update_stats(trnumsvr_stats, NETIF_CH_COUNT, flags);
+    }
 
+    if (update_input) {
       MX_LPRINT(MBTRNPP, 4, "cycle_xt.p: N[%"PRId64"] sum[%.3lf] min[%.3lf] max[%.3lf] avg[%.3lf]\n",
              app_stats->stats->per_stats[MBTPP_CH_MB_CYCLE_XT].n, app_stats->stats->per_stats[MBTPP_CH_MB_CYCLE_XT].sum,
              app_stats->stats->per_stats[MBTPP_CH_MB_CYCLE_XT].min, app_stats->stats->per_stats[MBTPP_CH_MB_CYCLE_XT].max,
@@ -5076,8 +5504,9 @@ int mbtrnpp_update_stats(mstats_profile_t *stats, mlog_id_t log_id, mstats_flags
              app_stats->stats->agg_stats[MBTPP_CH_MB_CYCLE_XT].min, app_stats->stats->agg_stats[MBTPP_CH_MB_CYCLE_XT].max,
              app_stats->stats->agg_stats[MBTPP_CH_MB_CYCLE_XT].avg);
 
-    if (flags & MSF_READER) {
-      mstats_update_stats(reader_stats, R7KR_MET_COUNT, flags);
+      if (flags & MSF_READER) {
+        mstats_update_stats(reader_stats, R7KR_MET_COUNT, flags);
+      }
     }
 
     //        fprintf(stderr,"stat period sec[%.3lf] start[%.3lf] now[%.3lf] elapsed[%.3lf]\n",
@@ -5091,40 +5520,65 @@ int mbtrnpp_update_stats(mstats_profile_t *stats, mlog_id_t log_id, mstats_flags
         ((stats_now - stats->stats->stat_period_start) > stats->stats->stat_period_sec)) {
 
       // start log execution timer
-      MST_METRIC_START(app_stats->stats->metrics[MBTPP_CH_MB_LOG_XT], mtime_dtime());
+      MST_METRIC_START(stats->stats->metrics[MBTPP_CH_MB_LOG_XT], mtime_dtime());
+
+      // the TRN pipeline worker and main loop share the logs and histogram snapshot
+      mthread_mutex_lock(stats_log_mutex);
 
       mlog_tprintf(mbtrnpp_mlog_id, "%.3lf,i,uptime,%0.3lf\n", stats_now, stats->uptime);
       mstats_log_stats(stats->stats, stats_now, log_id, flags);
-      mstats_log_stats(mb1svr_stats, stats_now, netif_log(mb1svr), flags);
-      mstats_log_stats(trnsvr_stats, stats_now, netif_log(trnsvr), flags);
-      mstats_log_stats(trnusvr_stats, stats_now, netif_log(trnusvr), flags);
-      mstats_log_stats(trnumsvr_stats, stats_now, netif_log(trnumsvr), flags);
+      if (update_output) {
+        mstats_log_stats(mb1svr_stats, stats_now, netif_log(mb1svr), flags);
+        mstats_log_stats(trnsvr_stats, stats_now, netif_log(trnsvr), flags);
+        mstats_log_stats(trnusvr_stats, stats_now, netif_log(trnusvr), flags);
+        mstats_log_stats(trnumsvr_stats, stats_now, netif_log(trnumsvr), flags);
+      }
 
-      if (flags & MSF_READER) {
+      if (update_input && (flags & MSF_READER)) {
         mstats_log_stats(reader_stats, stats_now, log_id, flags);
       }
 
+      // log/export period latency histograms
+      if (update_output) {
+        s_mbtrnpp_emit_hist(app_lat_hist, log_id, stats_now);
+        s_mbtrnpp_emit_hist(netif_hist(mb1svr), netif_log(mb1svr), stats_now);
+        s_mbtrnpp_emit_hist(netif_hist(trnsvr), netif_log(trnsvr), stats_now);
+        s_mbtrnpp_emit_hist(netif_hist(trnusvr), netif_log(trnusvr), stats_now);
+        s_mbtrnpp_emit_hist(netif_hist(trnumsvr), netif_log(trnumsvr), stats_now);
+      }
+      if (update_input && (flags & MSF_READER)) {
+        s_mbtrnpp_emit_hist(reader_hist, log_id, stats_now);
+      }
+
+      mthread_mutex_unlock(stats_log_mutex);
+
       // reset period stats
       mstats_reset_pstats(stats->stats, MBTPP_CH_COUNT);
-      mstats_reset_pstats(reader_stats, R7KR_MET_COUNT);
-      mstats_reset_pstats(mb1svr_stats, NETIF_CH_COUNT);
-      mstats_reset_pstats(trnsvr_stats, NETIF_CH_COUNT);
-      mstats_reset_pstats(trnusvr_stats, NETIF_CH_COUNT);
-      mstats_reset_pstats(trnumsvr_stats, NETIF_CH_COUNT);
+      if (update_input) {
+        mstats_reset_pstats(reader_stats, R7KR_MET_COUNT);
+      }
+      if (update_output) {
+        mstats_reset_pstats(mb1svr_stats, NETIF_CH_COUNT);
+        mstats_reset_pstats(trnsvr_stats, NETIF_CH_COUNT);
+        mstats_reset_pstats(trnusvr_stats, NETIF_CH_COUNT);
+        mstats_reset_pstats(trnumsvr_stats, NETIF_CH_COUNT);
+      }
 
       // reset period timer
       stats->stats->stat_period_start = stats_now;
 
       // stop log execution timer
-      MST_METRIC_LAP(app_stats->stats->metrics[MBTPP_CH_MB_LOG_XT], mtime_dtime());
+      MST_METRIC_LAP(stats->stats->metrics[MBTPP_CH_MB_LOG_XT], mtime_dtime());
     }
 
-    // start cycle timer
-    MST_METRIC_START(app_stats->stats->metrics[MBTPP_CH_MB_CYCLE_XT], mtime_dtime());
+    if (update_input) {
+      // start cycle timer
+      MST_METRIC_START(app_stats->stats->metrics[MBTPP_CH_MB_CYCLE_XT], mtime_dtime());
 
-    // update stats execution time variables
-    stats_prev_start = stats_nowd;
-    stats_prev_end = mtime_dtime();
+      // update stats execution time variables
+      stats_prev_start = stats_nowd;
+      stats_prev_end = mtime_dtime();
+    }
   }
   else {
     fprintf(stderr, "mbtrnpp_update_stats: invalid argument\n");
@@ -5298,6 +5752,26 @@ int mbtrnpp_init_debug(int verbose) {
 
     app_stats = mstats_profile_new(MBTPP_EV_COUNT, MBTPP_STA_COUNT, MBTPP_CH_COUNT, mbtrnpp_stats_labels, mtime_dtime(),
                                    mbtrn_cfg->trn_status_interval_sec);
+    trn_stats = app_stats;
+    stats_log_mutex = mthread_mutex_new();
+
+    // latency histogram: recorded by the main loop or TRN pipeline worker
+    app_lat_hist = mstats_hist_new("mb_ping_trn_xt", MSTATS_HIST_SUB_BITS_DFL, MSTATS_HIST_MAX_EXP_DFL, 2, MSTATS_HIST_UNIT_NSEC);
+    app_hsnap = mstats_hsnap_new(app_lat_hist);
+
+    // open latency histogram export file
+    if (mbtrn_cfg->stats_hist != 0) {
+        mbtrnpp_hist_path = (char *)malloc(512);
+        sprintf(mbtrnpp_hist_path, "%s//%s-%s.%s", mbtrn_cfg->trn_log_dir, MBTRNPP_HIST_NAME,
+                s_mbtrnpp_session_str(NULL,0,RF_NONE), MBTRNPP_HIST_FMTSTR(mbtrn_cfg->stats_hist));
+        mbtrnpp_hist_file = mfile_file_new(mbtrnpp_hist_path);
+        if (mfile_mopen(mbtrnpp_hist_file, flags, mode) > 0) {
+            fprintf(stderr,"mbtrnpp histogram export [%s]\n",mbtrnpp_hist_path);
+        } else {
+            fprintf(stderr,"ERR - could not open histogram export [%s]\n",mbtrnpp_hist_path);
+            mfile_file_destroy(&mbtrnpp_hist_file);
+        }
+    }
 
     return 0;
 }
@@ -5541,9 +6015,9 @@ int mbtrnpp_trnu_pub_osocket(trn_update_t *update,
         size_t iobytes = 0;
         if( netif_pub(netif,(char *)&pub_data, sizeof(pub_data), &iobytes) == 0){
             retval = iobytes;
-            MST_COUNTER_INC(app_stats->stats->events[MBTPP_EV_TRNU_PUBN]);
+            MST_COUNTER_INC(trn_stats->stats->events[MBTPP_EV_TRNU_PUBN]);
         } else {
-            MST_COUNTER_INC(app_stats->stats->events[MBTPP_EV_ETRNUPUB]);
+            MST_COUNTER_INC(trn_stats->stats->events[MBTPP_EV_ETRNUPUB]);
         }
 
     }
@@ -5601,9 +6075,9 @@ int mbtrnpp_trnu_pubempty_osocket(double time, double lat, double lon, double de
             size_t iobytes = 0;
             if( netif_pub(netif,(char *)&pub_data, sizeof(pub_data), &iobytes) == 0){
                 retval=iobytes;
-                MST_COUNTER_INC(app_stats->stats->events[MBTPP_EV_TRNU_PUBEMPTYN]);
+                MST_COUNTER_INC(trn_stats->stats->events[MBTPP_EV_TRNU_PUBEMPTYN]);
             } else {
-                MST_COUNTER_INC(app_stats->stats->events[MBTPP_EV_ETRNUPUBEMPTY]);
+                MST_COUNTER_INC(trn_stats->stats->events[MBTPP_EV_ETRNUPUBEMPTY]);
             }
     }
     return retval;
@@ -5743,8 +6217,8 @@ int s_mbtrnpp_trnu_reset_callback()
                  reset_time, use_offset_e, use_offset_n, use_offset_z,
                  xyz_sdev.x, xyz_sdev.y, xyz_sdev.z);
 
-    MST_COUNTER_INC(app_stats->stats->events[MBTPP_EV_MB_REINIT]);
-    MST_COUNTER_INC(app_stats->stats->events[MBTPP_EV_MB_TRNUCLI_RESET]);
+    MST_COUNTER_INC(trn_stats->stats->events[MBTPP_EV_MB_REINIT]);
+    MST_COUNTER_INC(trn_stats->stats->events[MBTPP_EV_MB_TRNUCLI_RESET]);
 
 //    reinit_flag = false;
     n_reinit++;
@@ -5783,8 +6257,8 @@ int s_mbtrnpp_trnu_reset_ofs_callback(double ofs_x, double ofs_y, double ofs_z)
                  reset_time, ofs_x, ofs_y, ofs_z,
                  xyz_sdev.x, xyz_sdev.y, xyz_sdev.z);
 
-    MST_COUNTER_INC(app_stats->stats->events[MBTPP_EV_MB_REINIT]);
-    MST_COUNTER_INC(app_stats->stats->events[MBTPP_EV_MB_TRNUCLI_RESET]);
+    MST_COUNTER_INC(trn_stats->stats->events[MBTPP_EV_MB_REINIT]);
+    MST_COUNTER_INC(trn_stats->stats->events[MBTPP_EV_MB_TRNUCLI_RESET]);
 
     //    reinit_flag = false;
     n_reinit++;
@@ -5815,8 +6289,8 @@ int s_mbtrnpp_trnu_reset_box_callback(double ofs_x, double ofs_y, double ofs_z,
     mlog_tprintf(mbtrnpp_mlog_id, "i,trn filter reinit_box.cli systime:%.6f centered on offset: %lf %lf %lf %lf %lf %lf\n",
                  reset_time, ofs_x, ofs_y, ofs_z, sx, sy, sz);
 
-    MST_COUNTER_INC(app_stats->stats->events[MBTPP_EV_MB_REINIT]);
-    MST_COUNTER_INC(app_stats->stats->events[MBTPP_EV_MB_TRNUCLI_RESET]);
+    MST_COUNTER_INC(trn_stats->stats->events[MBTPP_EV_MB_REINIT]);
+    MST_COUNTER_INC(trn_stats->stats->events[MBTPP_EV_MB_TRNUCLI_RESET]);
 
     //    reinit_flag = false;
     n_reinit++;
@@ -5994,7 +6468,7 @@ int mbtrnpp_check_reinit(trn_update_t *pstate, trn_config_t *cfg)
                       xyoffsetmag, mbtrn_cfg->reinit_xyoffset_max);
               mlog_tprintf(mbtrnpp_mlog_id,"i,reinit due to xyoffset magnitude [%.3lf] > threshold [%.3lf]\n",
                           xyoffsetmag, mbtrn_cfg->reinit_xyoffset_max);
-              MST_COUNTER_INC(app_stats->stats->events[MBTPP_EV_MB_xyoffset]);
+              MST_COUNTER_INC(trn_stats->stats->events[MBTPP_EV_MB_xyoffset]);
               reinit_flag = true;
             }
           }
@@ -6007,7 +6481,7 @@ int mbtrnpp_check_reinit(trn_update_t *pstate, trn_config_t *cfg)
                       offset_z, mbtrn_cfg->reinit_zoffset_min, mbtrn_cfg->reinit_zoffset_max);
               mlog_tprintf(mbtrnpp_mlog_id,"i,reinit due to offset_z [%.3lf] outside of allowed range: [%.3lf] to [%.3lf]\n",
                             offset_z, mbtrn_cfg->reinit_zoffset_min, mbtrn_cfg->reinit_zoffset_max);
-              MST_COUNTER_INC(app_stats->stats->events[MBTPP_EV_MB_offset_z]);
+              MST_COUNTER_INC(trn_stats->stats->events[MBTPP_EV_MB_offset_z]);
               reinit_flag = true;
             }
           }
@@ -6028,19 +6502,19 @@ int mbtrnpp_trn_publish(trn_update_t *pstate, trn_config_t *cfg)
         // publish to selected outputs
         if( OUTPUT_FLAG_SET(OUTPUT_TRNU_SVR_EN) ){
 
-            MST_METRIC_START(app_stats->stats->metrics[MBTPP_CH_TRN_TRNU_PUB_XT], mtime_dtime());
+            MST_METRIC_START(trn_stats->stats->metrics[MBTPP_CH_TRN_TRNU_PUB_XT], mtime_dtime());
 
             mbtrnpp_trnu_pub_osocket(pstate, trnusvr);
 
-            MST_METRIC_LAP(app_stats->stats->metrics[MBTPP_CH_TRN_TRNU_PUB_XT], mtime_dtime());
+            MST_METRIC_LAP(trn_stats->stats->metrics[MBTPP_CH_TRN_TRNU_PUB_XT], mtime_dtime());
         }
         if( OUTPUT_FLAG_SET(OUTPUT_TRNUM_SVR_EN) ){
 
-            MST_METRIC_START(app_stats->stats->metrics[MBTPP_CH_TRN_TRNUM_PUB_XT], mtime_dtime());
+            MST_METRIC_START(trn_stats->stats->metrics[MBTPP_CH_TRN_TRNUM_PUB_XT], mtime_dtime());
 
             mbtrnpp_trnu_pub_osocket(pstate, trnumsvr);
 
-            MST_METRIC_LAP(app_stats->stats->metrics[MBTPP_CH_TRN_TRNUM_PUB_XT], mtime_dtime());
+            MST_METRIC_LAP(trn_stats->stats->metrics[MBTPP_CH_TRN_TRNUM_PUB_XT], mtime_dtime());
         }
 // fprintf(stderr, "%s:%d:%s: pt_dat: %f  %f %f %f  %f %f %f %f  mle_dat: %f  %f %f %f  %f %f %f %f  mse_dat: %f  %f %f %f  %f %f %f %f"
 // " %d %f %d %d %d %d %d %d %f %f\n",
@@ -6054,18 +6528,18 @@ int mbtrnpp_trn_publish(trn_update_t *pstate, trn_config_t *cfg)
 // pstate->reinit_count, pstate->reinit_tlast, pstate->filter_state, pstate->success, pstate->is_converged,
 // pstate->is_valid, pstate->mb1_cycle, pstate->ping_number, pstate->mb1_time, pstate->update_time);
         if( OUTPUT_FLAG_SET(OUTPUT_TRNU_ASC) ){
-            MST_METRIC_START(app_stats->stats->metrics[MBTPP_CH_TRN_TRNU_LOG_XT], mtime_dtime());
+            MST_METRIC_START(trn_stats->stats->metrics[MBTPP_CH_TRN_TRNU_LOG_XT], mtime_dtime());
 
             mbtrnpp_trn_pub_olog(pstate, trnu_alog_id);
 
-            MST_METRIC_LAP(app_stats->stats->metrics[MBTPP_CH_TRN_TRNU_LOG_XT], mtime_dtime());
+            MST_METRIC_LAP(trn_stats->stats->metrics[MBTPP_CH_TRN_TRNU_LOG_XT], mtime_dtime());
         }
         if( OUTPUT_FLAG_SET(OUTPUT_TRNU_BIN) ){
-            MST_METRIC_START(app_stats->stats->metrics[MBTPP_CH_TRN_TRNU_BLOG_XT], mtime_dtime());
+            MST_METRIC_START(trn_stats->stats->metrics[MBTPP_CH_TRN_TRNU_BLOG_XT], mtime_dtime());
 
             mbtrnpp_trn_pub_blog(pstate, trnu_blog_id);
 
-            MST_METRIC_LAP(app_stats->stats->metrics[MBTPP_CH_TRN_TRNU_BLOG_XT], mtime_dtime());
+            MST_METRIC_LAP(trn_stats->stats->metrics[MBTPP_CH_TRN_TRNU_BLOG_XT], mtime_dtime());
         }
         if( OUTPUT_FLAG_SET(OUTPUT_TRNU_DEBUG) ){
             mbtrnpp_trn_pub_odebug(pstate);
@@ -6218,7 +6692,7 @@ int mbtrnpp_trn_process_mb1(wtnav_t *tnav, mb1_t *mb1, trn_config_t *cfg)
             do_process=true;
         }
 
-        MST_METRIC_START(app_stats->stats->metrics[MBTPP_CH_TRN_TRNSVR_XT], mtime_dtime());
+        MST_METRIC_START(trn_stats->stats->metrics[MBTPP_CH_TRN_TRNSVR_XT], mtime_dtime());
 
         // server: update (trn_server) client connections
         netif_update_connections(trnsvr);
@@ -6226,57 +6700,57 @@ int mbtrnpp_trn_process_mb1(wtnav_t *tnav, mb1_t *mb1, trn_config_t *cfg)
         // server: service (trn_server) client requests
         netif_reqres(trnsvr);
 
-        MST_METRIC_LAP(app_stats->stats->metrics[MBTPP_CH_TRN_TRNSVR_XT], mtime_dtime());
+        MST_METRIC_LAP(trn_stats->stats->metrics[MBTPP_CH_TRN_TRNSVR_XT], mtime_dtime());
 
-        MST_METRIC_START(app_stats->stats->metrics[MBTPP_CH_TRN_TRNUSVR_XT], mtime_dtime());
+        MST_METRIC_START(trn_stats->stats->metrics[MBTPP_CH_TRN_TRNUSVR_XT], mtime_dtime());
 
        // server: update (trnu server) client connections
         netif_update_connections(trnusvr);
         // server: service (trnu server) client requests
         netif_reqres(trnusvr);
 
-        MST_METRIC_LAP(app_stats->stats->metrics[MBTPP_CH_TRN_TRNUSVR_XT], mtime_dtime());
+        MST_METRIC_LAP(trn_stats->stats->metrics[MBTPP_CH_TRN_TRNUSVR_XT], mtime_dtime());
 
-        MST_METRIC_START(app_stats->stats->metrics[MBTPP_CH_TRN_TRNUMSVR_XT], mtime_dtime());
+        MST_METRIC_START(trn_stats->stats->metrics[MBTPP_CH_TRN_TRNUMSVR_XT], mtime_dtime());
        // server: update (trnum server) client connections
         netif_update_connections(trnumsvr);
         // server: service (trnum server) client requests
         netif_reqres(trnumsvr);
-        MST_METRIC_LAP(app_stats->stats->metrics[MBTPP_CH_TRN_TRNUMSVR_XT], mtime_dtime());
+        MST_METRIC_LAP(trn_stats->stats->metrics[MBTPP_CH_TRN_TRNUMSVR_XT], mtime_dtime());
 
         if (do_process) {
-            MST_COUNTER_INC(app_stats->stats->events[MBTPP_EV_TRN_PROCN]);
+            MST_COUNTER_INC(trn_stats->stats->events[MBTPP_EV_TRN_PROCN]);
 
             if(NULL!=tnav && NULL!=mb1 && NULL!=cfg){
                 static int process_count=0;
 
                 mlog_tprintf(trnu_alog_id,"trn_update_start,%lf,%lf,%d\n",mtime_etime(),mb1->ts,++process_count);
-                MST_METRIC_START(app_stats->stats->metrics[MBTPP_CH_TRN_PROC_XT], mtime_dtime());
+                MST_METRIC_START(trn_stats->stats->metrics[MBTPP_CH_TRN_PROC_XT], mtime_dtime());
 
                 wmeast_t *mt = NULL;
                 wposet_t *pt = NULL;
                 trn_update_t trn_state={NULL,NULL,NULL,0,0,0,0,0.0,0.0},*pstate=&trn_state;
 
                 // get TRN update
-                MST_METRIC_START(app_stats->stats->metrics[MBTPP_CH_TRN_UPDATE_XT], mtime_dtime());
+                MST_METRIC_START(trn_stats->stats->metrics[MBTPP_CH_TRN_UPDATE_XT], mtime_dtime());
 
                 int test=mbtrnpp_trn_update(tnav, mb1, &pt, &mt,cfg);
 
-                MST_METRIC_LAP(app_stats->stats->metrics[MBTPP_CH_TRN_UPDATE_XT], mtime_dtime());
+                MST_METRIC_LAP(trn_stats->stats->metrics[MBTPP_CH_TRN_UPDATE_XT], mtime_dtime());
 
                 if( test==0){
                     // get TRN bias estimates
-                    MST_METRIC_START(app_stats->stats->metrics[MBTPP_CH_TRN_BIASEST_XT], mtime_dtime());
+                    MST_METRIC_START(trn_stats->stats->metrics[MBTPP_CH_TRN_BIASEST_XT], mtime_dtime());
 
                     test=mbtrnpp_trn_get_bias_estimates(tnav, pt, pstate);
 
-                    MST_METRIC_LAP(app_stats->stats->metrics[MBTPP_CH_TRN_BIASEST_XT], mtime_dtime());
+                    MST_METRIC_LAP(trn_stats->stats->metrics[MBTPP_CH_TRN_BIASEST_XT], mtime_dtime());
 
                   if( test==0){
                         if(NULL!=pstate->pt_dat &&  NULL!= pstate->mle_dat && NULL!=pstate->mse_dat ){
 
                             // get number of reinits
-                            MST_METRIC_START(app_stats->stats->metrics[MBTPP_CH_TRN_NREINITS_XT], mtime_dtime());
+                            MST_METRIC_START(trn_stats->stats->metrics[MBTPP_CH_TRN_NREINITS_XT], mtime_dtime());
 
                             // check if reinit will be required on next processing
                             mbtrnpp_check_reinit(pstate, cfg);
@@ -6296,7 +6770,7 @@ int mbtrnpp_trn_process_mb1(wtnav_t *tnav, mb1_t *mb1, trn_config_t *cfg)
                             pstate->mb1_time=mb1->ts;
                             pstate->update_time=mtime_etime();
 
-                            MST_METRIC_LAP(app_stats->stats->metrics[MBTPP_CH_TRN_NREINITS_XT], mtime_dtime());
+                            MST_METRIC_LAP(trn_stats->stats->metrics[MBTPP_CH_TRN_NREINITS_XT], mtime_dtime());
 
                             // publish to selected outputs
                             mbtrnpp_trn_publish(pstate, cfg);
@@ -6347,7 +6821,7 @@ int mbtrnpp_trn_process_mb1(wtnav_t *tnav, mb1_t *mb1, trn_config_t *cfg)
                 if(NULL!=pstate->mle_dat)
                 free(pstate->mle_dat);
 
-                MST_METRIC_LAP(app_stats->stats->metrics[MBTPP_CH_TRN_PROC_XT], mtime_dtime());
+                MST_METRIC_LAP(trn_stats->stats->metrics[MBTPP_CH_TRN_PROC_XT], mtime_dtime());
             }// if tnav, mb1,cfg != NULL
             mlog_tprintf(trnu_alog_id,"trn_update_end,%lf,%d\n",mtime_etime(),retval);
         }// if do_process
@@ -6384,12 +6858,12 @@ int mbtrnpp_process_mb1(char *src, size_t len, trn_config_t *cfg)
             netif_reqres(mb1svr);
            // publish mb1 sounding to all clients
             if(netif_pub(mb1svr,(char *)src, len, NULL) == 0){
-	            MST_COUNTER_INC(app_stats->stats->events[MBTPP_EV_MB_PUBN]);
+	            MST_COUNTER_INC(trn_stats->stats->events[MBTPP_EV_MB_PUBN]);
             } else {
-                MST_COUNTER_INC(app_stats->stats->events[MBTPP_EV_EMBPUB]);
+                MST_COUNTER_INC(trn_stats->stats->events[MBTPP_EV_EMBPUB]);
             }
         }
-        MST_COUNTER_INC(app_stats->stats->events[MBTPP_EV_MB_CYCLES]);
+        MST_COUNTER_INC(trn_stats->stats->events[MBTPP_EV_MB_CYCLES]);
 
         //                struct timeval stv={0};
         //                gettimeofday(&stv,NULL);
@@ -8761,6 +9235,7 @@ int mbtrnpp_mb1r_input_open(int verbose, void *mbio_ptr, char *definition, int *
 
         // get global reader performance profile
         reader_stats = mb1r_reader_get_stats(reader);
+        reader_hist = mb1r_reader_get_hist(reader);
         mstats_set_period(reader_stats, app_stats->stats->stat_period_start, app_stats->stats->stat_period_sec);
 
         // configure reader data log
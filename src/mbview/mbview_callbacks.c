@@ -42,6 +42,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "mb_define.h"
 #include "mb_status.h"
@@ -118,6 +119,7 @@ int mbview_startup(int verbose, Widget parent, XtAppContext app, int *error) {
 	/* set global work function parameters */
 	work_function_enabled = true;
 	work_function_set = false;
+	mbv_nthreads = MAX(1, MIN((int)sysconf(_SC_NPROCESSORS_ONLN), MB_THREAD_MAX));
 	timer_timeout_time = 100;
 	timer_timeout_count = 10;
 	timer_count = 0;
@@ -8352,15 +8354,11 @@ int do_mbview_workfunction(XtPointer client_data) {
 		if (mode == MBV_BACKGROUND_ZSCALE) {
 			/*fprintf(stderr,"do_mbview_workfunction: recalculating zscale in background %d of %d...\n",
 			view->zscaledonecount,data->primary_nxy);*/
-			/* recalculate zscale for MBV_NUMBACKGROUNDCALC cells */
-			int ncalc = 0;
-			for (int k = view->zscaledonecount; k < data->primary_nxy && ncalc < MBV_NUMBACKGROUNDCALC; k++) {
-				if (!(data->primary_stat_z[k / 8] & statmask[k % 8])) {
-					mbview_zscalegridpoint(instance, k);
-					ncalc++;
-				}
-				view->zscaledonecount = k;
-			}
+			/* recalculate zscale for the next block of columns, one block per thread */
+			const int column_start = view->zscaledonecount > 0 ? (view->zscaledonecount + 1) / data->primary_n_rows : 0;
+			const int column_end = MIN(column_start + mbv_nthreads * MBV_GRIDPASS_COLUMNS, data->primary_n_columns) - 1;
+			mbview_gridpass(instance, MBV_GRIDPASS_ZSCALE, column_start, column_end, 0, data->primary_n_rows - 1, 1, NULL);
+			view->zscaledonecount = (column_end + 1) * data->primary_n_rows - 1;
 		}
 
 		/* then work on color */
@@ -8380,17 +8378,11 @@ int do_mbview_workfunction(XtPointer client_data) {
 				histogram = view->secondary_histogram;
 			}
 
-			/* recalculate color for MBV_NUMBACKGROUNDCALC cells */
-			int ncalc = 0;
-			for (int k = view->colordonecount; k < data->primary_nxy && ncalc < MBV_NUMBACKGROUNDCALC; k++) {
-				if (!(data->primary_stat_color[k / 8] & statmask[k % 8])) {
-					const int i = k / data->primary_n_columns;
-					const int j = k % data->primary_n_rows;
-					mbview_colorpoint(view, data, histogram, i, j, k);
-					ncalc++;
-				}
-				view->colordonecount = k;
-			}
+			/* recalculate color for the next block of columns, one block per thread */
+			const int column_start = view->colordonecount > 0 ? (view->colordonecount + 1) / data->primary_n_rows : 0;
+			const int column_end = MIN(column_start + mbv_nthreads * MBV_GRIDPASS_COLUMNS, data->primary_n_columns) - 1;
+			mbview_gridpass(instance, MBV_GRIDPASS_COLOR, column_start, column_end, 0, data->primary_n_rows - 1, 1, histogram);
+			view->colordonecount = (column_end + 1) * data->primary_n_rows - 1;
 		}
 
 		/* finally do the full rez plot */
@@ -233,6 +233,13 @@ int mbview_drawdata(size_t instance, int rez) {
 
 	/*fprintf(stderr,"mbview_drawdata: %d %d stride:%d\n", instance,rez,stride);*/
 
+	/* scale and color the vertices to be drawn in parallel before drawing them */
+	int gridpass_mode = MBV_GRIDPASS_ZSCALE | MBV_GRIDPASS_COLOR | MBV_GRIDPASS_VALIDONLY | MBV_GRIDPASS_INTERRUPT;
+	if (data->grid_mode == MBV_GRID_VIEW_SECONDARY && stride == 1)
+		gridpass_mode |= MBV_GRIDPASS_FORCE;
+	mbview_gridpass(instance, gridpass_mode, data->viewbounds[0], data->viewbounds[1], data->viewbounds[2], data->viewbounds[3],
+	                stride, histogram);
+
 	/* draw the data as triangle strips */
 	if (data->grid_mode != MBV_GRID_VIEW_SECONDARY) {
 		for (int i = data->viewbounds[0]; i <= data->viewbounds[1] - stride; i += stride) {
@@ -373,14 +380,14 @@ int mbview_drawdata(size_t instance, int rez) {
 							flip = true;
 					}
           // TODO: 8 March 2020 D W Caress
-          // The addition of "stride == 1" below forces the code to recolor all
-          // vertices when plotting at full resolution. If not, sometimes the
+          // All vertices are recolored when plotting at full resolution (the
+          // grid pass above is forced when stride == 1). If not, sometimes the
           // secondary data are partly mislocated - this bug is not understood
           // - somehow the color grids are being written or overwritten incorrectly
           // before.
-					if (stride == 1 || !(data->primary_stat_z[kk / 8] & statmask[kk % 8]))
+					if (!(data->primary_stat_z[kk / 8] & statmask[kk % 8]))
 						mbview_zscalegridpoint(instance, kk);
-					if (stride == 1 || !(data->primary_stat_color[kk / 8] & statmask[kk % 8])) {
+					if (!(data->primary_stat_color[kk / 8] & statmask[kk % 8])) {
 						mbview_colorpoint(view, data, histogram, ikk, j, kk);
 					}
 					glColor3f(data->primary_r[kk], data->primary_g[kk], data->primary_b[kk]);
@@ -414,14 +421,14 @@ int mbview_drawdata(size_t instance, int rez) {
 							flip = true;
 					}
           // TODO: 8 March 2020 D W Caress
-          // The addition of "stride == 1" below forces the code to recolor all
-          // vertices when plotting at full resolution. If not, sometimes the
+          // All vertices are recolored when plotting at full resolution (the
+          // grid pass above is forced when stride == 1). If not, sometimes the
           // secondary data are partly mislocated - this bug is not understood
           // - somehow the color grids are being written or overwritten incorrectly
           // before.
-					if (stride == 1 || !(data->primary_stat_z[ll / 8] & statmask[ll % 8]))
+					if (!(data->primary_stat_z[ll / 8] & statmask[ll % 8]))
 						mbview_zscalegridpoint(instance, ll);
-					if (stride == 1 || !(data->primary_stat_color[ll / 8] & statmask[ll % 8])) {
+					if (!(data->primary_stat_color[ll / 8] & statmask[ll % 8])) {
 						mbview_colorpoint(view, data, histogram, ill, j, ll);
 					}
 					glColor3f(data->primary_r[ll], data->primary_g[ll], data->primary_b[ll]);
@@ -31,6 +31,7 @@
 
 #include <ctype.h>
 #include <math.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -79,9 +80,8 @@
 int mbview_projectdata(size_t instance) {
 	int error = MB_ERROR_NO_ERROR;
 	int proj_status = MB_SUCCESS;
-	double xgrid, ygrid, xlon, ylat, xdisplay, ydisplay, zdisplay;
+	double zdisplay;
 	double xlonmin, xlonmax, ylatmin, ylatmax;
-	int i, j, k;
 	char *message;
 
 	if (mbv_verbose >= 2) {
@@ -295,64 +295,31 @@ __FILE__, __LINE__, __FUNCTION__, xlonmin, xlonmax, ylatmin, ylatmax);
 	fprintf(stderr,"  Display origin: %f %f %f\n", view->xorigin, view->yorigin, view->zorigin);
 	fprintf(stderr,"  Display scale: %f\n", view->scale);*/
 
-	/* set x and y arrays */
-	for (i = 0; i < data->primary_n_columns; i++) {
-		for (j = 0; j < data->primary_n_rows; j++) {
-			/* get raw values in grid */
-			k = i * data->primary_n_rows + j;
-			xgrid = data->primary_xmin + i * data->primary_dx;
-			ygrid = data->primary_ymin + j * data->primary_dy;
-
-			/* reproject positions into display coordinates */
-			mbview_projectforward(instance, false, xgrid, ygrid, data->primary_data[k], &xlon, &ylat, &xdisplay, &ydisplay,
-			                      &zdisplay);
-
-			/* insert into plotting arrays */
-			data->primary_x[k] = (float)xdisplay;
-			data->primary_y[k] = (float)ydisplay;
-			data->primary_z[k] = (float)zdisplay;
-		}
-
-		/* set projection for secondary grid if needed */
-		if (data->secondary_nxy > 0 && data->secondary_grid_projection_mode == MBV_PROJECTION_PROJECTED) {
-			/* set projection for getting lon lat */
-			proj_status = mb_proj_init(mbv_verbose, data->secondary_grid_projection_id, &(view->secondary_pjptr), &error);
-			if (proj_status == MB_SUCCESS)
-				view->secondary_pj_init = true;
+	/* set projection for secondary grid if needed */
+	if (data->secondary_nxy > 0 && data->secondary_grid_projection_mode == MBV_PROJECTION_PROJECTED) {
+		/* set projection for getting lon lat */
+		proj_status = mb_proj_init(mbv_verbose, data->secondary_grid_projection_id, &(view->secondary_pjptr), &error);
+		if (proj_status == MB_SUCCESS)
+			view->secondary_pj_init = true;
 
-			/* quit if projection fails */
-			if (proj_status != MB_SUCCESS) {
-				mb_error(mbv_verbose, error, &message);
-				fprintf(stderr, "\nMBIO Error initializing projection:\n%s\n", message);
-				fprintf(stderr, "\nProgram terminated in <%s>\n", __func__);
-				mb_memory_clear(mbv_verbose, &error);
-				exit(error);
-			}
+		/* quit if projection fails */
+		if (proj_status != MB_SUCCESS) {
+			mb_error(mbv_verbose, error, &message);
+			fprintf(stderr, "\nMBIO Error initializing projection:\n%s\n", message);
+			fprintf(stderr, "\nProgram terminated in <%s>\n", __func__);
+			mb_memory_clear(mbv_verbose, &error);
+			exit(error);
 		}
-
-		/* check for pending event */
-		if (!view->plot_done && view->plot_interrupt_allowed && i % MBV_EVENTCHECKCOARSENESS == 0)
-			do_mbview_xevents();
-
-		/* dump out of loop if plotting already done at a higher recursion */
-		if (view->plot_done)
-			i = data->primary_n_columns;
 	}
 
-	/* calculate derivatives of primary data */
-	for (i = 0; i < data->primary_n_columns; i++) {
-		for (j = 0; j < data->primary_n_rows; j++) {
-			mbview_derivative(instance, i, j);
-		}
-
-		/* check for pending event */
-		if (!view->plot_done && view->plot_interrupt_allowed && i % MBV_EVENTCHECKCOARSENESS == 0)
-			do_mbview_xevents();
+	/* set x and y arrays */
+	mbview_gridpass(instance, MBV_GRIDPASS_PROJECT | MBV_GRIDPASS_INTERRUPT, 0, data->primary_n_columns - 1, 0,
+	                data->primary_n_rows - 1, 1, NULL);
 
-		/* dump out of loop if plotting already done at a higher recursion */
-		if (view->plot_done)
-			i = data->primary_n_columns;
-	}
+	/* calculate derivatives of primary data */
+	if (!view->plot_done)
+		mbview_gridpass(instance, MBV_GRIDPASS_DERIVATIVE | MBV_GRIDPASS_INTERRUPT, 0, data->primary_n_columns - 1, 0,
+		                data->primary_n_rows - 1, 1, NULL);
 
 	/* clear zscale for grid */
 	mbview_zscaleclear(instance);
@@ -725,6 +692,273 @@ int mbview_zscalegridpoint(size_t instance, int k) {
 	return (status);
 }
 
+/*------------------------------------------------------------------------------*/
+/* shared state for a pass over the primary grid */
+struct mbview_gridpass_work {
+	size_t instance;
+	int mode;
+	int column_start;
+	int column_end;
+	int row_start;
+	int row_end;
+	int stride;
+	float *histogram;
+	pthread_mutex_t mutex;
+	int next_block;
+	int end_block;
+};
+
+/* per thread state - the projection objects are not thread safe, so threads
+   other than the calling one work from a copy of the view holding clones */
+struct mbview_gridpass_thread {
+	struct mbview_gridpass_work *work;
+	struct mbview_world_struct *view;
+	struct mbview_world_struct view_copy;
+	void *primary_ctx;
+	void *secondary_ctx;
+	void *display_ctx;
+};
+
+/*------------------------------------------------------------------------------*/
+/* project a grid node into display coordinates as mbview_projectforward() does,
+   but using the projections of the view passed in */
+static void mbview_gridpass_projectnode(size_t instance, struct mbview_world_struct *view, int i, int j, int k) {
+	int error = MB_ERROR_NO_ERROR;
+	struct mbview_struct *data = &(view->data);
+	const double xgrid = data->primary_xmin + i * data->primary_dx;
+	const double ygrid = data->primary_ymin + j * data->primary_dy;
+	const double zdata = data->primary_data[k];
+	double xlon = xgrid;
+	double ylat = ygrid;
+	double xx, yy, zz;
+
+	if (data->primary_grid_projection_mode == MBV_PROJECTION_ALREADYPROJECTED) {
+		xx = xgrid;
+		yy = ygrid;
+		zz = data->exageration * zdata;
+	}
+	else {
+		if (data->primary_grid_projection_mode == MBV_PROJECTION_PROJECTED)
+			mb_proj_inverse(mbv_verbose, view->primary_pjptr, xgrid, ygrid, &xlon, &ylat, &error);
+		if (data->display_projection_mode == MBV_PROJECTION_PROJECTED ||
+		    data->display_projection_mode == MBV_PROJECTION_ALREADYPROJECTED) {
+			mb_proj_forward(mbv_verbose, view->display_pjptr, xlon, ylat, &xx, &yy, &error);
+			zz = data->exageration * zdata;
+		}
+		else if (data->display_projection_mode == MBV_PROJECTION_GEOGRAPHIC) {
+			xx = xlon / view->mtodeglon;
+			yy = ylat / view->mtodeglat;
+			zz = data->exageration * zdata;
+		}
+		else /*if (data->display_projection_mode == MBV_PROJECTION_SPHEROID) */
+		{
+			mbview_sphere_forward(instance, xlon, ylat, &xx, &yy, &zz);
+			const double effective_topography = data->exageration * (zdata - 0.5 * (data->primary_min + data->primary_max)) +
+			                                    0.5 * (data->primary_min + data->primary_max);
+			xx += (effective_topography * xx / MBV_SPHEROID_RADIUS) - view->sphere_refx;
+			yy += (effective_topography * yy / MBV_SPHEROID_RADIUS) - view->sphere_refy;
+			zz += (effective_topography * zz / MBV_SPHEROID_RADIUS) - view->sphere_refz;
+		}
+	}
+
+	data->primary_x[k] = (float)(view->scale * (xx - view->xorigin));
+	data->primary_y[k] = (float)(view->scale * (yy - view->yorigin));
+	data->primary_z[k] = (float)(view->scale * (zz - view->zorigin));
+}
+
+/*------------------------------------------------------------------------------*/
+static void *mbview_gridpass_worker(void *arg) {
+	struct mbview_gridpass_thread *thread = (struct mbview_gridpass_thread *)arg;
+	struct mbview_gridpass_work *work = thread->work;
+	struct mbview_world_struct *view = thread->view;
+	struct mbview_struct *data = &(view->data);
+	const int mode = work->mode;
+	const int stride = work->stride;
+
+	while (true) {
+		pthread_mutex_lock(&work->mutex);
+		const int iblock = work->next_block++;
+		pthread_mutex_unlock(&work->mutex);
+		if (iblock >= work->end_block)
+			break;
+
+		/* get the columns of the pass falling within this block */
+		const int i0 = MAX(work->column_start, iblock * MBV_GRIDPASS_COLUMNS);
+		const int i1 = MIN(work->column_end, (iblock + 1) * MBV_GRIDPASS_COLUMNS - 1);
+		const int istart = work->column_start + ((i0 - work->column_start + stride - 1) / stride) * stride;
+		for (int i = istart; i <= i1; i += stride) {
+			for (int j = work->row_start; j <= work->row_end; j += stride) {
+				const int k = i * data->primary_n_rows + j;
+				if (mode & MBV_GRIDPASS_PROJECT)
+					mbview_gridpass_projectnode(work->instance, view, i, j, k);
+				if (mode & MBV_GRIDPASS_DERIVATIVE)
+					mbview_derivative(work->instance, i, j);
+				if ((mode & MBV_GRIDPASS_VALIDONLY) && data->primary_data[k] == data->primary_nodatavalue)
+					continue;
+				if ((mode & MBV_GRIDPASS_ZSCALE) &&
+				    ((mode & MBV_GRIDPASS_FORCE) || !(data->primary_stat_z[k / 8] & statmask[k % 8]))) {
+					if (data->display_projection_mode == MBV_PROJECTION_SPHEROID)
+						mbview_gridpass_projectnode(work->instance, view, i, j, k);
+					else
+						data->primary_z[k] = (float)(view->scale * (data->exageration * data->primary_data[k] - view->zorigin));
+					data->primary_stat_z[k / 8] = data->primary_stat_z[k / 8] | statmask[k % 8];
+				}
+				if ((mode & MBV_GRIDPASS_COLOR) &&
+				    ((mode & MBV_GRIDPASS_FORCE) || !(data->primary_stat_color[k / 8] & statmask[k % 8])))
+					mbview_colorpoint(view, data, work->histogram, i, j, k);
+			}
+		}
+	}
+
+	return (NULL);
+}
+
+/*------------------------------------------------------------------------------*/
+int mbview_gridpass(size_t instance, int mode, int column_start, int column_end, int row_start, int row_end, int stride,
+                    float *histogram) {
+	int error = MB_ERROR_NO_ERROR;
+
+	if (mbv_verbose >= 2) {
+		fprintf(stderr, "\ndbg2  MBIO function <%s> called\n", __func__);
+		fprintf(stderr, "dbg2  MB-system Version %s\n", MB_VERSION);
+		fprintf(stderr, "dbg2  Input arguments:\n");
+		fprintf(stderr, "dbg2       instance:         %zu\n", instance);
+		fprintf(stderr, "dbg2       mode:             %d\n", mode);
+		fprintf(stderr, "dbg2       column_start:     %d\n", column_start);
+		fprintf(stderr, "dbg2       column_end:       %d\n", column_end);
+		fprintf(stderr, "dbg2       row_start:        %d\n", row_start);
+		fprintf(stderr, "dbg2       row_end:          %d\n", row_end);
+		fprintf(stderr, "dbg2       stride:           %d\n", stride);
+		fprintf(stderr, "dbg2       histogram:        %p\n", histogram);
+	}
+
+	/* get view */
+	struct mbview_world_struct *view = &(mbviews[instance]);
+	struct mbview_struct *data = &(view->data);
+
+	int status = MB_SUCCESS;
+
+	stride = MAX(stride, 1);
+	column_start = MAX(column_start, 0);
+	column_end = MIN(column_end, data->primary_n_columns - 1);
+	row_start = MAX(row_start, 0);
+	row_end = MIN(row_end, data->primary_n_rows - 1);
+	if (data->primary_nxy > 0 && column_start <= column_end && row_start <= row_end) {
+		struct mbview_gridpass_work work;
+		work.instance = instance;
+		work.mode = mode;
+		work.column_start = column_start;
+		work.column_end = column_end;
+		work.row_start = row_start;
+		work.row_end = row_end;
+		work.stride = stride;
+		work.histogram = histogram;
+
+		/* use only as many threads as the size of the pass justifies */
+		const int ncolumns = (column_end - column_start) / stride + 1;
+		const int nrows = (row_end - row_start) / stride + 1;
+		int nthreads = (int)MIN((double)mbv_nthreads, ((double)ncolumns) * nrows / MBV_GRIDPASS_MINNODES);
+		nthreads = MAX(1, MIN(MIN(nthreads, MB_THREAD_MAX), ncolumns));
+		struct mbview_gridpass_thread *threads = NULL;
+		if (nthreads > 1)
+			threads = (struct mbview_gridpass_thread *)calloc(nthreads, sizeof(struct mbview_gridpass_thread));
+		if (threads == NULL) {
+			nthreads = 1;
+			threads = (struct mbview_gridpass_thread *)calloc(1, sizeof(struct mbview_gridpass_thread));
+			if (threads == NULL) {
+				error = MB_ERROR_MEMORY_FAIL;
+				status = MB_FAILURE;
+			}
+		}
+
+		/* the calling thread works with the view itself, the others with clones */
+		for (int ithread = 0; status == MB_SUCCESS && ithread < nthreads; ithread++) {
+			struct mbview_gridpass_thread *thread = &threads[ithread];
+			thread->work = &work;
+			if (ithread == 0) {
+				thread->view = view;
+				continue;
+			}
+			thread->view_copy = *view;
+			thread->view = &thread->view_copy;
+			thread->view_copy.primary_pjptr = NULL;
+			thread->view_copy.secondary_pjptr = NULL;
+			thread->view_copy.display_pjptr = NULL;
+			int proj_status = MB_SUCCESS;
+			if (view->primary_pjptr != NULL)
+				proj_status = mb_proj_clone(mbv_verbose, view->primary_pjptr, &thread->primary_ctx,
+				                            &thread->view_copy.primary_pjptr, &error);
+			if (proj_status == MB_SUCCESS && view->secondary_pjptr != NULL)
+				proj_status = mb_proj_clone(mbv_verbose, view->secondary_pjptr, &thread->secondary_ctx,
+				                            &thread->view_copy.secondary_pjptr, &error);
+			if (proj_status == MB_SUCCESS && view->display_pjptr != NULL)
+				proj_status = mb_proj_clone(mbv_verbose, view->display_pjptr, &thread->display_ctx,
+				                            &thread->view_copy.display_pjptr, &error);
+			if (proj_status != MB_SUCCESS) {
+				mb_proj_clone_free(mbv_verbose, &thread->primary_ctx, &thread->view_copy.primary_pjptr, &error);
+				mb_proj_clone_free(mbv_verbose, &thread->secondary_ctx, &thread->view_copy.secondary_pjptr, &error);
+				mb_proj_clone_free(mbv_verbose, &thread->display_ctx, &thread->view_copy.display_pjptr, &error);
+				nthreads = ithread;
+			}
+		}
+
+		/* work through the blocks of columns in chunks, checking for
+		   pending events between chunks if the pass may be interrupted */
+		if (status == MB_SUCCESS) {
+			pthread_mutex_init(&work.mutex, NULL);
+			const int block_start = column_start / MBV_GRIDPASS_COLUMNS;
+			const int block_end = column_end / MBV_GRIDPASS_COLUMNS + 1;
+			const int block_nodes = MAX(1, MBV_GRIDPASS_COLUMNS * nrows / stride);
+			const int chunk = MAX(nthreads, nthreads * MBV_GRIDPASS_MINNODES / block_nodes);
+			for (int iblock = block_start; iblock < block_end; iblock += chunk) {
+				work.next_block = iblock;
+				work.end_block = MIN(iblock + chunk, block_end);
+				pthread_t thread_ids[MB_THREAD_MAX];
+				int nstarted = 1;
+				for (int ithread = 1; ithread < nthreads; ithread++) {
+					if (pthread_create(&thread_ids[ithread], NULL, mbview_gridpass_worker, &threads[ithread]) == 0)
+						nstarted++;
+					else
+						break;
+				}
+				mbview_gridpass_worker(&threads[0]);
+				for (int ithread = 1; ithread < nstarted; ithread++)
+					pthread_join(thread_ids[ithread], NULL);
+
+				if (mode & MBV_GRIDPASS_INTERRUPT) {
+					/* check for pending event */
+					if (!view->plot_done && view->plot_interrupt_allowed)
+						do_mbview_xevents();
+
+					/* dump out of loop if plotting already done at a higher recursion */
+					if (view->plot_done)
+						break;
+				}
+			}
+			pthread_mutex_destroy(&work.mutex);
+		}
+
+		/* release the cloned projections */
+		for (int ithread = 1; status == MB_SUCCESS && ithread < nthreads; ithread++) {
+			struct mbview_gridpass_thread *thread = &threads[ithread];
+			mb_proj_clone_free(mbv_verbose, &thread->primary_ctx, &thread->view_copy.primary_pjptr, &error);
+			mb_proj_clone_free(mbv_verbose, &thread->secondary_ctx, &thread->view_copy.secondary_pjptr, &error);
+			mb_proj_clone_free(mbv_verbose, &thread->display_ctx, &thread->view_copy.display_pjptr, &error);
+		}
+		free(threads);
+	}
+
+	if (mbv_verbose >= 2) {
+		fprintf(stderr, "\ndbg2  MBIO function <%s> completed\n", __func__);
+		fprintf(stderr, "dbg2  Return values:\n");
+		fprintf(stderr, "dbg2       error:   %d\n", error);
+		fprintf(stderr, "dbg2  Return status:\n");
+		fprintf(stderr, "dbg2       status:  %d\n", status);
+	}
+
+	return (status);
+}
+
 /*------------------------------------------------------------------------------*/
 int mbview_zscalepoint(size_t instance, int globalview, double offset_factor, struct mbview_point_struct *point) {
 	if (mbv_verbose >= 2) {
@@ -60,12 +60,24 @@
 #define MBV_BOUNDSFREQUENCY 25
 #define MBV_EVENTCHECKCOARSENESS 5
 
-#define MBV_NUMBACKGROUNDCALC 500
 #define MBV_BACKGROUND_NONE 0
 #define MBV_BACKGROUND_ZSCALE 1
 #define MBV_BACKGROUND_COLOR 2
 #define MBV_BACKGROUND_FULLPLOT 3
 
+/* passes over the primary grid are divided between threads in blocks of whole
+   columns starting at multiples of MBV_GRIDPASS_COLUMNS so that no two threads
+   set bits in the same byte of the status bit arrays */
+#define MBV_GRIDPASS_COLUMNS 8
+#define MBV_GRIDPASS_MINNODES 16384
+#define MBV_GRIDPASS_PROJECT 0x01
+#define MBV_GRIDPASS_DERIVATIVE 0x02
+#define MBV_GRIDPASS_ZSCALE 0x04
+#define MBV_GRIDPASS_COLOR 0x08
+#define MBV_GRIDPASS_FORCE 0x10
+#define MBV_GRIDPASS_VALIDONLY 0x20
+#define MBV_GRIDPASS_INTERRUPT 0x40
+
 #define MBV_PICK_IDIVISION 15
 #define MBV_PICK_DIVISION ((double)MBV_PICK_IDIVISION)
 #define MBV_PICK_DOWN 1
@@ -299,6 +311,7 @@ struct mbview_world_struct {
 /* general library global variables */
 MBVIEW_EXTERNAL int mbv_verbose;
 MBVIEW_EXTERNAL int mbv_ninstance;
+MBVIEW_EXTERNAL int mbv_nthreads;
 MBVIEW_EXTERNAL Widget parent_widget;
 MBVIEW_EXTERNAL XtAppContext app_context;
 MBVIEW_EXTERNAL int work_function_enabled;
@@ -561,6 +574,8 @@ int mbview_projectdata(size_t instance);
 int mbview_derivative(size_t instance, int i, int j);
 int mbview_projectglobaldata(size_t instance);
 int mbview_zscalegridpoint(size_t instance, int k);
+int mbview_gridpass(size_t instance, int mode, int column_start, int column_end, int row_start, int row_end, int stride,
+                    float *histogram);
 int mbview_zscalepoint(size_t instance, int globalview, double offset_factor, struct mbview_point_struct *point);
 int mbview_zscalepointw(size_t instance, int globalview, double offset_factor, struct mbview_pointw_struct *pointw);
 int mbview_updatepointw(size_t instance, struct mbview_pointw_struct *pointw);
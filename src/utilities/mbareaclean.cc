@@ -55,6 +55,9 @@
 #include <unistd.h>
 
 #include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
 
 #include "mb_define.h"
 #include "mb_format.h"
@@ -67,7 +70,8 @@
 /* allocation */
 constexpr int FILEALLOCNUM = 16;
 constexpr int PINGALLOCNUM = 128;
-constexpr int SNDGALLOCNUM = 128;
+constexpr int SNDGALLOCNUM = 16384;
+constexpr int BINBLOCKNUM = 256;
 
 struct mbareaclean_file_struct {
 	char filelist[MB_PATH_MAXLINE];
@@ -83,77 +87,66 @@ struct mbareaclean_file_struct {
 	int *pingmultiplicity;
 	double *ping_altitude;
 	int nsndg;
-	int nsndg_alloc;
 	int sndg_countstart;
 	int beams_bath;
-	struct mbareaclean_sndg_struct *sndg;
 };
+
+/* sounding record - kept to 32 bytes, with the soundings of all files held
+   in one array in the order read so that those of each file are contiguous */
 struct mbareaclean_sndg_struct {
+	double sndg_depth;
 	int sndg_file;
 	int sndg_ping;
 	int sndg_beam;
-	double sndg_depth;
-	double sndg_x;
-	double sndg_y;
+	int sndg_bin;
 	char sndg_beamflag_org;
 	char sndg_beamflag_esf;
 	char sndg_beamflag;
 	bool sndg_edit;
 };
 
-/* sounding storage values and arrays */
+/* statistical test settings */
+struct mbareaclean_test_struct {
+	int verbose;
+	int nx;
+	int ny;
+	double xmin;
+	double ymin;
+	double dx;
+	double dy;
+	bool median_filter;
+	double median_filter_threshold;
+	int median_filter_nmin;
+	bool mediandensity_filter;
+	int mediandensity_filter_nmax;
+	bool std_dev_filter;
+	double std_dev_threshold;
+	int std_dev_nmin;
+	bool output_bad;
+	bool output_good;
+};
+
+/* sounding storage values and arrays - the soundings in bin kgrid are
+   sndg[gsndg[gsndgstart[kgrid]]] to sndg[gsndg[gsndgstart[kgrid + 1] - 1]] */
 int nfile = 0;
 int nfile_alloc = 0;
 struct mbareaclean_file_struct *files = nullptr;
 int nsndg = 0;
 int nsndg_alloc = 0;
-int sndg_countstart = 0;
-int **gsndg = nullptr;
-int *gsndgnum = nullptr;
-int *gsndgnum_alloc = nullptr;
 struct mbareaclean_sndg_struct *sndg = nullptr;
+int *gsndg = nullptr;
+int *gsndgstart = nullptr;
 
 constexpr char program_name[] = "MBAREACLEAN";
 constexpr char help_message[] = "MBAREACLEAN identifies and flags artifacts in swath bathymetry data";
 constexpr char usage_message[] =
     "mbareaclean [-Fformat -Iinfile -Rwest/east/south/north -B -G -Sbinsize\n"
-    "\t -Mthreshold/nmin -Dthreshold[/nmin[/nmax]] -Ttype -N[-]minbeam/maxbeam]";
-
-/*--------------------------------------------------------------------*/
-int getsoundingptr(int verbose, int soundingid, struct mbareaclean_sndg_struct **sndgptr, int *error) {
-	if (verbose >= 2) {
-		fprintf(stderr, "\ndbg2  MBIO function <%s> called\n", __func__);
-		fprintf(stderr, "dbg2  Input arguments:\n");
-		fprintf(stderr, "dbg2       verbose:         %d\n", verbose);
-		fprintf(stderr, "dbg2       soundingid:      %d\n", soundingid);
-		fprintf(stderr, "dbg2       sndgptr:         %p\n", (void *)sndgptr);
-	}
-
-	/* loop over the files until the sounding is found */
-	*sndgptr = nullptr;
-	for (int i = 0; i < nfile && *sndgptr == nullptr; i++) {
-		if (soundingid >= files[i].sndg_countstart && soundingid < files[i].sndg_countstart + files[i].nsndg) {
-			const int j = soundingid - files[i].sndg_countstart;
-			*sndgptr = &(files[i].sndg[j]);
-		}
-	}
-
-	const int status = MB_SUCCESS;
+    "\t -Mthreshold/nmin -Dthreshold[/nmin[/nmax]] -Ttype -N[-]minbeam/maxbeam --threads=nthreads]";
 
-	if (verbose >= 2) {
-		fprintf(stderr, "\ndbg2  MBIO function <%s> completed\n", __func__);
-		fprintf(stderr, "dbg2  Return values:\n");
-		fprintf(stderr, "dbg2       *sndgptr:        %p\n", (void *)sndgptr);
-		fprintf(stderr, "dbg2       error:           %d\n", *error);
-		fprintf(stderr, "dbg2  Return status:\n");
-		fprintf(stderr, "dbg2       status:          %d\n", status);
-	}
-
-	return (status);
-}
 /*--------------------------------------------------------------------*/
 
-int flag_sounding(int verbose, bool flag, bool output_bad, bool output_good, struct mbareaclean_sndg_struct *sndg, int *error) {
+int flag_sounding(int verbose, bool flag, bool output_bad, bool output_good, struct mbareaclean_sndg_struct *sndg,
+                  int *nflagged, int *nunflagged, int *error) {
 	if (verbose >= 2) {
 		fprintf(stderr, "\ndbg2  MBIO function <%s> called\n", __func__);
 		fprintf(stderr, "dbg2  Input arguments:\n");
@@ -169,12 +162,12 @@ int flag_sounding(int verbose, bool flag, bool output_bad, bool output_good, str
 	if (sndg->sndg_edit) {
 		if (output_bad && mb_beam_ok(sndg->sndg_beamflag) && flag) {
 			sndg->sndg_beamflag = MB_FLAG_FLAG + MB_FLAG_FILTER;
-			files[sndg->sndg_file].nflagged++;
+			nflagged[sndg->sndg_file]++;
 		}
 
 		else if (output_good && !mb_beam_ok(sndg->sndg_beamflag) && sndg->sndg_beamflag != MB_FLAG_NULL && !flag) {
 			sndg->sndg_beamflag = MB_FLAG_NONE;
-			files[sndg->sndg_file].nunflagged++;
+			nunflagged[sndg->sndg_file]++;
 		}
 
 		else if (output_good && !mb_beam_ok(sndg->sndg_beamflag) && sndg->sndg_beamflag != MB_FLAG_NULL && flag) {
@@ -197,6 +190,126 @@ int flag_sounding(int verbose, bool flag, bool output_bad, bool output_good, str
 	return (status);
 }
 
+/*--------------------------------------------------------------------*/
+/* apply the statistical tests to blocks of BINBLOCKNUM bins taken in turn
+   from next_block until none remain - each sounding belongs to one bin so
+   threads never share soundings, and the flagging counts of each thread are
+   kept separately in nflagged and nunflagged */
+void test_bins(const struct mbareaclean_test_struct *test, std::atomic<int> *next_block, int *nflagged, int *nunflagged,
+               int *error) {
+	const int verbose = test->verbose;
+	const int nbin = test->nx * test->ny;
+	std::vector<double> bindepths;
+
+	for (int iblock = (*next_block)++; iblock * BINBLOCKNUM < nbin; iblock = (*next_block)++) {
+		const int kgrid_end = std::min(nbin, (iblock + 1) * BINBLOCKNUM);
+		for (int kgrid = iblock * BINBLOCKNUM; kgrid < kgrid_end; kgrid++) {
+			const int isndg_start = gsndgstart[kgrid];
+			const int isndg_end = gsndgstart[kgrid + 1];
+			if (isndg_start == isndg_end)
+				continue;
+
+			/* deal with median filter */
+			if (test->median_filter) {
+				/* load up array */
+				bindepths.clear();
+				for (int i = isndg_start; i < isndg_end; i++) {
+					const struct mbareaclean_sndg_struct *sndgptr = &sndg[gsndg[i]];
+					if (mb_beam_ok(sndgptr->sndg_beamflag))
+						bindepths.push_back(sndgptr->sndg_depth);
+				}
+				const int binnum = bindepths.size();
+
+				/* apply median filter only if there are enough soundings - the
+				   median and density limits are found by selection, the depths
+				   below and above the median being left on either side of it */
+				if (binnum >= test->median_filter_nmin && binnum > 0) {
+					double *depths = bindepths.data();
+					const int kmedian = binnum / 2;
+					std::nth_element(depths, depths + kmedian, depths + binnum);
+					const double median_depth = depths[kmedian];
+					double median_depth_low = median_depth;
+					double median_depth_high = median_depth;
+					if (test->mediandensity_filter) {
+						int klow = 0;
+						int khigh = binnum - 1;
+						if (kmedian - test->mediandensity_filter_nmax / 2 >= 0)
+							klow = kmedian - test->mediandensity_filter_nmax / 2;
+						if (kmedian + test->mediandensity_filter_nmax / 2 < binnum)
+							khigh = kmedian + test->mediandensity_filter_nmax / 2;
+						if (klow < kmedian)
+							std::nth_element(depths, depths + klow, depths + kmedian);
+						if (khigh > kmedian)
+							std::nth_element(depths + kmedian + 1, depths + khigh, depths + binnum);
+						median_depth_low = depths[klow];
+						median_depth_high = depths[khigh];
+					}
+
+					/* process the soundings */
+					for (int i = isndg_start; i < isndg_end; i++) {
+						struct mbareaclean_sndg_struct *sndgptr = &sndg[gsndg[i]];
+						const double threshold =
+						    fabs(test->median_filter_threshold * files[sndgptr->sndg_file].ping_altitude[sndgptr->sndg_ping]);
+						bool flagsounding = false;
+						if (fabs(sndgptr->sndg_depth - median_depth) > threshold)
+							flagsounding = true;
+						if (test->mediandensity_filter &&
+						    (sndgptr->sndg_depth > median_depth_high || sndgptr->sndg_depth < median_depth_low))
+							flagsounding = true;
+						flag_sounding(verbose, flagsounding, test->output_bad, test->output_good, sndgptr, nflagged,
+						              nunflagged, error);
+					}
+				}
+			}
+
+			/* deal with standard deviation filter */
+			if (test->std_dev_filter) {
+				/* get mean */
+				double mean = 0.0;
+				int binnum = 0;
+				for (int i = isndg_start; i < isndg_end; i++) {
+					const struct mbareaclean_sndg_struct *sndgptr = &sndg[gsndg[i]];
+					if (mb_beam_ok(sndgptr->sndg_beamflag)) {
+						mean += sndgptr->sndg_depth;
+						binnum++;
+					}
+				}
+				mean /= binnum;
+
+				/* get standard deviation */
+				double std_dev = 0.0;
+				for (int i = isndg_start; i < isndg_end; i++) {
+					const struct mbareaclean_sndg_struct *sndgptr = &sndg[gsndg[i]];
+					if (mb_beam_ok(sndgptr->sndg_beamflag))
+						std_dev += (sndgptr->sndg_depth - mean) * (sndgptr->sndg_depth - mean);
+				}
+				std_dev = sqrt(std_dev / binnum);
+
+				const double threshold = std_dev * test->std_dev_threshold;
+
+				if (verbose >= 1 && binnum > 0) {
+					const int ix = kgrid / test->ny;
+					const int iy = kgrid % test->ny;
+					const double xx = test->xmin + 0.5 * test->dx + ix * test->dx;
+					const double yy = test->ymin + 0.5 * test->dy + iy * test->dy;
+					fprintf(stderr, "bin: %d %d %d  pos: %f %f  nsoundings:%d / %d mean:%f std_dev:%f\n", ix, iy, kgrid, xx, yy,
+					        binnum, isndg_end - isndg_start, mean, std_dev);
+				}
+
+				/* apply standard deviation threshold only if there are enough soundings */
+				if (binnum >= test->std_dev_nmin) {
+					/* process the soundings */
+					for (int i = isndg_start; i < isndg_end; i++) {
+						struct mbareaclean_sndg_struct *sndgptr = &sndg[gsndg[i]];
+						flag_sounding(verbose, fabs(sndgptr->sndg_depth - mean) > threshold, test->output_bad,
+						              test->output_good, sndgptr, nflagged, nunflagged, error);
+					}
+				}
+			}
+		}
+	}
+}
+
 /*--------------------------------------------------------------------*/
 int main(int argc, char **argv) {
 	int verbose = 0;
@@ -259,14 +372,27 @@ int main(int argc, char **argv) {
 	bool binsizeset = false;
 	int flag_detect = MB_DETECT_AMPLITUDE;
 	bool use_detect = false;
+	int n_threads = 1;
 
 	{
+		static struct option options[] = {{"threads", required_argument, nullptr, 0},
+		                                  {nullptr, 0, nullptr, 0}};
+
 		bool errflg = false;
 		int c;
 		bool help = false;
-		while ((c = getopt(argc, argv, "VvHhBbGgD:d:F:f:I:i:M:m:N:n:P:p:S:sT:t::R:r:")) != -1)
+		int option_index;
+		while ((c = getopt_long(argc, argv, "VvHhBbGgD:d:F:f:I:i:M:m:N:n:P:p:S:sT:t::R:r:", options, &option_index)) != -1)
 		{
 			switch (c) {
+			/* long options */
+			case 0:
+				if (strcmp("threads", options[option_index].name) == 0) {
+					sscanf(optarg, "%d", &n_threads);
+				}
+				break;
+
+			/* short options */
 			case 'H':
 			case 'h':
 				help = true;
@@ -439,6 +565,7 @@ int main(int argc, char **argv) {
 			fprintf(stderr, "dbg2       areabounds[3]:  %f\n", areabounds[3]);
 			fprintf(stderr, "dbg2       binsizeset:     %d\n", binsizeset);
 			fprintf(stderr, "dbg2       binsize:        %f\n", binsize);
+			fprintf(stderr, "dbg2       n_threads:      %d\n", n_threads);
 		}
 
 		if (help) {
@@ -486,11 +613,7 @@ int main(int argc, char **argv) {
 	/* allocate grid arrays */
 	nsndg = 0;
 	nsndg_alloc = 0;
-	status &= mb_mallocd(verbose, __FILE__, __LINE__, nx * ny * sizeof(int *), (void **)&gsndg, &error);
-	if (status == MB_SUCCESS)
-		status &= mb_mallocd(verbose, __FILE__, __LINE__, nx * ny * sizeof(int), (void **)&gsndgnum, &error);
-	if (status == MB_SUCCESS)
-		status &= mb_mallocd(verbose, __FILE__, __LINE__, nx * ny * sizeof(int), (void **)&gsndgnum_alloc, &error);
+	status &= mb_mallocd(verbose, __FILE__, __LINE__, (nx * ny + 1) * sizeof(int), (void **)&gsndgstart, &error);
 
 	/* if error initializing memory then quit */
 	if (error != MB_ERROR_NO_ERROR || status != MB_SUCCESS) {
@@ -501,12 +624,9 @@ int main(int argc, char **argv) {
 		exit(error);
 	}
 
-	/* if error initializing memory then quit */
-	for (int i = 0; i < nx * ny; i++) {
-		gsndg[i] = nullptr;
-		gsndgnum[i] = 0;
-		gsndgnum_alloc[i] = 0;
-	}
+	/* initialize the bin sounding counts */
+	for (int i = 0; i <= nx * ny; i++)
+		gsndgstart[i] = 0;
 
 	/* give the statistics */
 	if (verbose >= 0) {
@@ -515,6 +635,7 @@ int main(int argc, char **argv) {
 		fprintf(stderr, "     Minimum Latitude:  %.6f Maximum Latitude:  %.6f\n", areabounds[2], areabounds[3]);
 		fprintf(stderr, "     Bin Size:   %f\n", binsize);
 		fprintf(stderr, "     Dimensions: %d %d\n", nx, ny);
+		fprintf(stderr, "     Threads:    %d\n", n_threads);
 		fprintf(stderr, "Cleaning algorithms:\n");
 		if (median_filter) {
 			fprintf(stderr, "     Median filter: ON\n");
@@ -753,10 +874,8 @@ int main(int argc, char **argv) {
 		files[nfile].pingmultiplicity = nullptr;
 		files[nfile].ping_altitude = nullptr;
 		files[nfile].nsndg = 0;
-		files[nfile].nsndg_alloc = SNDGALLOCNUM;
 		files[nfile].sndg_countstart = nsndg;
 		files[nfile].beams_bath = beams_bath;
-		files[nfile].sndg = nullptr;
 		status &= mb_mallocd(verbose, __FILE__, __LINE__, files[nfile].nping_alloc * sizeof(double),
 		                    (void **)&(files[nfile].ping_time_d), &error);
 		if (status == MB_SUCCESS)
@@ -765,9 +884,6 @@ int main(int argc, char **argv) {
 		if (status == MB_SUCCESS)
 			status &= mb_mallocd(verbose, __FILE__, __LINE__, files[nfile].nping_alloc * sizeof(double),
 			                    (void **)&(files[nfile].ping_altitude), &error);
-		if (status == MB_SUCCESS)
-			status &= mb_mallocd(verbose, __FILE__, __LINE__, files[nfile].nsndg_alloc * sizeof(struct mbareaclean_sndg_struct),
-			                    (void **)&(files[nfile].sndg), &error);
 		if (error != MB_ERROR_NO_ERROR) {
 			char *message = nullptr;
 			mb_error(verbose, error, &message);
@@ -903,25 +1019,11 @@ int main(int argc, char **argv) {
 
 						/* add sounding */
 						if (ix >= 0 && ix < nx && iy >= 0 && iy < ny) {
-							if (files[nfile - 1].nsndg >= files[nfile - 1].nsndg_alloc) {
-								files[nfile - 1].nsndg_alloc += SNDGALLOCNUM;
+							if (nsndg >= nsndg_alloc) {
+								nsndg_alloc = std::max(SNDGALLOCNUM, 2 * nsndg_alloc);
 								status = mb_reallocd(verbose, __FILE__, __LINE__,
-								                     files[nfile - 1].nsndg_alloc * sizeof(struct mbareaclean_sndg_struct),
-								                     (void **)&files[nfile - 1].sndg, &error);
-								if (error != MB_ERROR_NO_ERROR) {
-									char *message = nullptr;
-									mb_error(verbose, error, &message);
-									fprintf(stderr, "\nMBIO Error allocating sounding arrays:\n%s\n", message);
-									fprintf(stderr, "\nProgram <%s> Terminated\n", program_name);
-									exit(error);
-								}
-							}
-
-							/* allocate space for sounding if needed */
-							if (gsndgnum[kgrid] >= gsndgnum_alloc[kgrid]) {
-								gsndgnum_alloc[kgrid] += SNDGALLOCNUM;
-								status = mb_reallocd(verbose, __FILE__, __LINE__, gsndgnum_alloc[kgrid] * sizeof(int),
-								                     (void **)&gsndg[kgrid], &error);
+								                     nsndg_alloc * sizeof(struct mbareaclean_sndg_struct),
+								                     (void **)&sndg, &error);
 								if (error != MB_ERROR_NO_ERROR) {
 									char *message = nullptr;
 									mb_error(verbose, error, &message);
@@ -932,33 +1034,31 @@ int main(int argc, char **argv) {
 							}
 
 							/* store sounding data */
-							sndg = &(files[nfile - 1].sndg[files[nfile - 1].nsndg]);
-							sndg->sndg_file = nfile - 1;
-							sndg->sndg_ping = files[nfile - 1].nping - 1;
-							sndg->sndg_beam = ib;
-							sndg->sndg_depth = bath[ib];
-							sndg->sndg_x = bathlon[ib];
-							sndg->sndg_y = bathlat[ib];
-							sndg->sndg_beamflag_org = beamflag[ib];
-							sndg->sndg_beamflag_esf = beamflagorg[ib];
-							sndg->sndg_beamflag = beamflagorg[ib];
-							sndg->sndg_edit = true;
+							struct mbareaclean_sndg_struct *sndgptr = &sndg[nsndg];
+							sndgptr->sndg_depth = bath[ib];
+							sndgptr->sndg_file = nfile - 1;
+							sndgptr->sndg_ping = files[nfile - 1].nping - 1;
+							sndgptr->sndg_beam = ib;
+							sndgptr->sndg_bin = kgrid;
+							sndgptr->sndg_beamflag_org = beamflag[ib];
+							sndgptr->sndg_beamflag_esf = beamflagorg[ib];
+							sndgptr->sndg_beamflag = beamflagorg[ib];
+							sndgptr->sndg_edit = true;
 							if (use_detect && detect[ib] != flag_detect)
-								sndg->sndg_edit = false;
+								sndgptr->sndg_edit = false;
 							if (limit_beams) {
 								if (min_beam <= ib && ib <= max_beam) {
 									if (!beam_in)
-										sndg->sndg_edit = false;
+										sndgptr->sndg_edit = false;
 								}
 								else {
 									if (beam_in)
-										sndg->sndg_edit = false;
+										sndgptr->sndg_edit = false;
 								}
 							}
 							files[nfile - 1].nsndg++;
 							nsndg++;
-							gsndg[kgrid][gsndgnum[kgrid]] = files[nfile - 1].sndg_countstart + files[nfile - 1].nsndg - 1;
-							gsndgnum[kgrid]++;
+							gsndgstart[kgrid + 1]++;
 						}
 					}
 				}
@@ -1003,26 +1103,10 @@ int main(int argc, char **argv) {
 		mb_datalist_close(verbose, &datalist, &error);
 
 
-	/* median filter parameters */
-	double *bindepths;
-	double threshold;
-
-	/* counting parameters */
-
-	/* loop over grid cells to find maximum number of soundings */
-	int binnummax = 0;
-	// double xx;
-	// double yy;
-	for (int ix = 0; ix < nx; ix++) {
-		for (int iy = 0; iy < ny; iy++) {
-			/* get cell id */
-			const int kgrid = ix * ny + iy;
-			// xx = areabounds[0] + 0.5 * dx + ix * dx;
-			// yy = areabounds[3] + 0.5 * dy + iy * dy;
-			binnummax = std::max(binnummax, gsndgnum[kgrid]);
-		}
-        }
-	/* status = */ mb_mallocd(verbose, __FILE__, __LINE__, binnummax * sizeof(double), (void **)&(bindepths), &error);
+	/* list the soundings of each bin together, in the order read */
+	for (int kgrid = 0; kgrid < nx * ny; kgrid++)
+		gsndgstart[kgrid + 1] += gsndgstart[kgrid];
+	status = mb_mallocd(verbose, __FILE__, __LINE__, std::max(nsndg, 1) * sizeof(int), (void **)&gsndg, &error);
 	if (error != MB_ERROR_NO_ERROR) {
 		char *message = nullptr;
 		mb_error(verbose, error, &message);
@@ -1030,109 +1114,50 @@ int main(int argc, char **argv) {
 		fprintf(stderr, "\nProgram <%s> Terminated\n", program_name);
 		exit(error);
 	}
-
-	/* deal with median filter */
-	if (median_filter) {
-		/* loop over grid cells applying median filter test */
-		for (int ix = 0; ix < nx; ix++)
-			for (int iy = 0; iy < ny; iy++) {
-				/* get cell id */
-				const int kgrid = ix * ny + iy;
-				// xx = areabounds[0] + 0.5 * dx + ix * dx;
-				// yy = areabounds[3] + 0.5 * dy + iy * dy;
-
-				/* load up array */
-				int binnum = 0;
-				for (int i = 0; i < gsndgnum[kgrid]; i++) {
-					getsoundingptr(verbose, gsndg[kgrid][i], &sndg, &error);
-					if (mb_beam_ok(sndg->sndg_beamflag)) {
-						bindepths[binnum] = sndg->sndg_depth;
-						binnum++;
-					}
-				}
-
-				/* apply median filter only if there are enough soundings */
-				if (binnum >= median_filter_nmin) {
-					/* run qsort */
-					qsort((void *)bindepths, binnum, sizeof(double), mb_double_compare);
-					const double median_depth = bindepths[binnum / 2];
-					double median_depth_low;
-					double median_depth_high;
-					if (mediandensity_filter && binnum / 2 - mediandensity_filter_nmax / 2 >= 0)
-						median_depth_low = bindepths[binnum / 2 + mediandensity_filter_nmax / 2];
-					else
-						median_depth_low = bindepths[0];
-					if (mediandensity_filter && binnum / 2 + mediandensity_filter_nmax / 2 < binnum)
-						median_depth_high = bindepths[binnum / 2 + mediandensity_filter_nmax / 2];
-					else
-						median_depth_high = bindepths[binnum - 1];
-
-					/* process the soundings */
-					for (int i = 0; i < gsndgnum[kgrid]; i++) {
-						getsoundingptr(verbose, gsndg[kgrid][i], &sndg, &error);
-						threshold = fabs(median_filter_threshold * files[sndg->sndg_file].ping_altitude[sndg->sndg_ping]);
-						bool flagsounding = false;
-						if (fabs(sndg->sndg_depth - median_depth) > threshold)
-							flagsounding = true;
-						if (mediandensity_filter &&
-						    (sndg->sndg_depth > median_depth_high || sndg->sndg_depth < median_depth_low))
-							flagsounding = true;
-						flag_sounding(verbose, flagsounding, output_bad, output_good, sndg, &error);
-					}
-				}
-			}
-	}
-
-	/* deal with standard deviation filter */
-	if (std_dev_filter) {
-		/* loop over grid cells applying std dev filter test */
-		for (int ix = 0; ix < nx; ix++)
-			for (int iy = 0; iy < ny; iy++) {
-				/* get cell id */
-				const int kgrid = ix * ny + iy;
-				const double xx = areabounds[0] + 0.5 * dx + ix * dx;
-				const double yy = areabounds[3] + 0.5 * dy + iy * dy;
-
-				/* get mean */
-				double mean = 0.0;
-				int binnum = 0;
-				for (int i = 0; i < gsndgnum[kgrid]; i++) {
-					getsoundingptr(verbose, gsndg[kgrid][i], &sndg, &error);
-					if (mb_beam_ok(sndg->sndg_beamflag)) {
-						mean += sndg->sndg_depth;
-						binnum++;
-					}
-				}
-				mean /= binnum;
-
-				/* get standard deviation */
-				double std_dev = 0.0;
-				for (int i = 0; i < gsndgnum[kgrid]; i++) {
-					getsoundingptr(verbose, gsndg[kgrid][i], &sndg, &error);
-					if (mb_beam_ok(sndg->sndg_beamflag))
-						std_dev += (sndg->sndg_depth - mean) * (sndg->sndg_depth - mean);
-				}
-				std_dev = sqrt(std_dev / binnum);
-
-				threshold = std_dev * std_dev_threshold;
-
-				if (binnum > 0)
-					fprintf(stderr, "bin: %d %d %d  pos: %f %f  nsoundings:%d / %d mean:%f std_dev:%f\n", ix, iy, kgrid, xx, yy,
-					        binnum, gsndgnum[kgrid], mean, std_dev);
-
-				/* apply standard deviation threshold only if there are enough soundings */
-				if (binnum >= std_dev_nmin) {
-
-					/* process the soundings */
-					for (int i = 0; i < gsndgnum[kgrid]; i++) {
-						getsoundingptr(verbose, gsndg[kgrid][i], &sndg, &error);
-						flag_sounding(verbose, fabs(sndg->sndg_depth - mean) > threshold, output_bad, output_good, sndg, &error);
-					}
-				}
-			}
+	for (int isndg = 0; isndg < nsndg; isndg++)
+		gsndg[gsndgstart[sndg[isndg].sndg_bin]++] = isndg;
+	for (int kgrid = nx * ny; kgrid > 0; kgrid--)
+		gsndgstart[kgrid] = gsndgstart[kgrid - 1];
+	gsndgstart[0] = 0;
+
+	/* apply the statistical tests to the bins using n_threads threads */
+	struct mbareaclean_test_struct test;
+	test.verbose = verbose;
+	test.nx = nx;
+	test.ny = ny;
+	test.xmin = areabounds[0];
+	test.ymin = areabounds[2];
+	test.dx = dx;
+	test.dy = dy;
+	test.median_filter = median_filter;
+	test.median_filter_threshold = median_filter_threshold;
+	test.median_filter_nmin = median_filter_nmin;
+	test.mediandensity_filter = mediandensity_filter;
+	test.mediandensity_filter_nmax = mediandensity_filter_nmax;
+	test.std_dev_filter = std_dev_filter;
+	test.std_dev_threshold = std_dev_threshold;
+	test.std_dev_nmin = std_dev_nmin;
+	test.output_bad = output_bad;
+	test.output_good = output_good;
+	n_threads = std::max(1, std::min(n_threads, MB_THREAD_MAX));
+	n_threads = std::min(n_threads, (nx * ny + BINBLOCKNUM - 1) / BINBLOCKNUM);
+	std::vector<std::vector<int>> nflagged(n_threads, std::vector<int>(nfile, 0));
+	std::vector<std::vector<int>> nunflagged(n_threads, std::vector<int>(nfile, 0));
+	std::vector<int> thread_error(n_threads, MB_ERROR_NO_ERROR);
+	std::atomic<int> next_block(0);
+	std::thread workers[MB_THREAD_MAX];
+	for (int ithread = 0; ithread < n_threads; ithread++)
+		workers[ithread] = std::thread(test_bins, &test, &next_block, nflagged[ithread].data(), nunflagged[ithread].data(),
+		                               &thread_error[ithread]);
+	for (int ithread = 0; ithread < n_threads; ithread++)
+		workers[ithread].join();
+	for (int ithread = 0; ithread < n_threads; ithread++) {
+		for (int i = 0; i < nfile; i++) {
+			files[i].nflagged += nflagged[ithread][i];
+			files[i].nunflagged += nunflagged[ithread][i];
+		}
 	}
 
-
 	/* loop over files checking for changed soundings */
 	for (int i = 0; i < nfile; i++) {
 		/* open esf file */
@@ -1146,23 +1171,23 @@ int main(int argc, char **argv) {
 		}
 		// TODO(schwehr): What about status == MB_FAILURE && error != MB_ERROR_OPEN_FAIL?
 
-		/* loop over all of the soundings */
-		for (int j = 0; j < files[i].nsndg; j++) {
-			sndg = &(files[i].sndg[j]);
-			if (sndg->sndg_beamflag != sndg->sndg_beamflag_org) {
+		/* loop over all of the soundings of this file */
+		for (int j = files[i].sndg_countstart; j < files[i].sndg_countstart + files[i].nsndg; j++) {
+			const struct mbareaclean_sndg_struct *sndgptr = &sndg[j];
+			if (sndgptr->sndg_beamflag != sndgptr->sndg_beamflag_org) {
 				int action = 0;
-				if (mb_beam_ok(sndg->sndg_beamflag)) {
+				if (mb_beam_ok(sndgptr->sndg_beamflag)) {
 					action = MBP_EDIT_UNFLAG;
 				}
-				else if (mb_beam_check_flag_manual(sndg->sndg_beamflag)) {
+				else if (mb_beam_check_flag_manual(sndgptr->sndg_beamflag)) {
 					action = MBP_EDIT_FLAG;
 				}
-				else if (mb_beam_check_flag_filter(sndg->sndg_beamflag)) {
+				else if (mb_beam_check_flag_filter(sndgptr->sndg_beamflag)) {
 					action = MBP_EDIT_FILTER;
 				}
-				mb_esf_save(verbose, &esf, files[i].ping_time_d[sndg->sndg_ping],
-				            sndg->sndg_beam + files[i].pingmultiplicity[sndg->sndg_ping] * MB_ESF_MULTIPLICITY_FACTOR, action,
-				            &error);
+				mb_esf_save(verbose, &esf, files[i].ping_time_d[sndgptr->sndg_ping],
+				            sndgptr->sndg_beam + files[i].pingmultiplicity[sndgptr->sndg_ping] * MB_ESF_MULTIPLICITY_FACTOR,
+				            action, &error);
 			}
 		}
 
@@ -1191,19 +1216,14 @@ int main(int argc, char **argv) {
 		}
 	}
 
-	mb_freed(verbose, __FILE__, __LINE__, (void **)&bindepths, &error);
-	for (int i = 0; i < nx * ny; i++)
-		if (gsndg[i] != nullptr)
-			mb_freed(verbose, __FILE__, __LINE__, (void **)&gsndg[i], &error);
 	mb_freed(verbose, __FILE__, __LINE__, (void **)&gsndg, &error);
-	mb_freed(verbose, __FILE__, __LINE__, (void **)&gsndgnum, &error);
-	mb_freed(verbose, __FILE__, __LINE__, (void **)&gsndgnum_alloc, &error);
+	mb_freed(verbose, __FILE__, __LINE__, (void **)&gsndgstart, &error);
+	mb_freed(verbose, __FILE__, __LINE__, (void **)&sndg, &error);
 
 	for (int i = 0; i < nfile; i++) {
-		mb_freed(verbose, __FILE__, __LINE__, (void **)&(files[nfile - 1].ping_time_d), &error);
-		mb_freed(verbose, __FILE__, __LINE__, (void **)&(files[nfile - 1].pingmultiplicity), &error);
-		mb_freed(verbose, __FILE__, __LINE__, (void **)&(files[nfile - 1].ping_altitude), &error);
-		mb_freed(verbose, __FILE__, __LINE__, (void **)&(files[nfile - 1].sndg), &error);
+		mb_freed(verbose, __FILE__, __LINE__, (void **)&(files[i].ping_time_d), &error);
+		mb_freed(verbose, __FILE__, __LINE__, (void **)&(files[i].pingmultiplicity), &error);
+		mb_freed(verbose, __FILE__, __LINE__, (void **)&(files[i].ping_altitude), &error);
 	}
 	mb_freed(verbose, __FILE__, __LINE__, (void **)&files, &error);
 
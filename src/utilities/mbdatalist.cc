@@ -31,12 +31,17 @@
  */
 
 #include <assert.h>
+#include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <getopt.h>
+#include <sys/stat.h>
+#include <thread>
 #include <unistd.h>
+#include <vector>
 
 #include "mb_define.h"
 #include "mb_format.h"
@@ -48,7 +53,30 @@ constexpr char help_message[] =
     "mbdatalist parses recursive datalist files and outputs the\n"
     "complete list of data files and formats. The results are dumped to stdout.";
 constexpr char usage_message[] =
-    "mbdatalist [-C -D -Fformat -Ifile -N -O -P -Q -Rw/e/s/n -S -U -Y -Z -V -H]";
+    "mbdatalist [-C -D -Fformat -Ifile -N -O -P -Q -Rw/e/s/n -S -Tthreads -U -Y -Z -V -H]";
+
+/* swath file needing ancillary files generated */
+struct mbdatalist_job_struct {
+	mb_path file;
+	int format;
+	off_t filesize;
+	int status;
+	int error;
+};
+
+/*--------------------------------------------------------------------*/
+/* ancillary file thread - keep taking the next file from the shared queue
+   until the queue is empty, so that no thread idles while another works
+   through a large file */
+void make_info_files(int verbose, bool force_update, std::vector<struct mbdatalist_job_struct> *jobs,
+                     std::atomic<size_t> *next_job)
+{
+	for (size_t ijob = (*next_job)++; ijob < jobs->size(); ijob = (*next_job)++) {
+		struct mbdatalist_job_struct *job = &(*jobs)[ijob];
+		job->error = MB_ERROR_NO_ERROR;
+		job->status = mb_make_info(verbose, force_update, job->file, job->format, &job->error);
+	}
+}
 
 /*--------------------------------------------------------------------*/
 
@@ -77,6 +105,7 @@ int main(int argc, char **argv) {
 	bool remove_locks = false;
 	bool make_datalistp = false;
 	bool reportdatalists = false;
+	unsigned int n_threads = 1;
 	FILE *output = nullptr;
 
 	{
@@ -98,12 +127,13 @@ int main(int argc, char **argv) {
 	                {"raw", no_argument, nullptr, 0},
 	                {"unlock", no_argument, nullptr, 0},
 	                {"datalistp", no_argument, nullptr, 0},
+	                {"threads", required_argument, nullptr, 0},
 	                {nullptr, 0, nullptr, 0}};
 
 		bool errflg = false;
 		int c;
 		bool help = false;
-		while ((c = getopt_long(argc, argv, "VvHhCcDdF:f:I:i:NnOoPpQqR:r:SsUuYyZz", options, &option_index)) != -1)
+		while ((c = getopt_long(argc, argv, "VvHhCcDdF:f:I:i:NnOoPpQqR:r:SsT:t:UuYyZz", options, &option_index)) != -1)
 		{
 			switch (c) {
 			/* long options */
@@ -155,6 +185,9 @@ int main(int argc, char **argv) {
 				else if (strcmp("datalistp", options[option_index].name) == 0) {
 					make_datalistp = true;
 				}
+				else if (strcmp("threads", options[option_index].name) == 0) {
+					sscanf(optarg, "%u", &n_threads);
+				}
 
 				break;
 
@@ -205,6 +238,10 @@ int main(int argc, char **argv) {
 			case 's':
 				status_report = true;
 				break;
+			case 'T':
+			case 't':
+				sscanf(optarg, "%u", &n_threads);
+				break;
 			case 'U':
 			case 'u':
 				look_processed = MB_DATALIST_LOOK_NO;
@@ -259,6 +296,7 @@ int main(int argc, char **argv) {
 			fprintf(output, "dbg2       problem_report:      %d\n", problem_report);
 			fprintf(output, "dbg2       make_datalistp:      %d\n", make_datalistp);
 			fprintf(output, "dbg2       remove_locks:        %d\n", remove_locks);
+			fprintf(output, "dbg2       n_threads:           %u\n", n_threads);
 			fprintf(output, "dbg2       pings:               %d\n", pings);
 			fprintf(output, "dbg2       lonflip:             %d\n", lonflip);
 			fprintf(output, "dbg2       bounds[0]:           %f\n", bounds[0]);
@@ -323,6 +361,10 @@ int main(int argc, char **argv) {
 	if (format == 0)
 		mb_get_format(verbose, read_file, nullptr, &format, &error);
 
+	/* get number of threads to use for generating ancillary files */
+	n_threads = std::max(1u, std::min(n_threads, std::min(std::thread::hardware_concurrency(), (unsigned int)MB_THREAD_MAX)));
+	std::vector<struct mbdatalist_job_struct> jobs;
+
 	void *datalist;
 	double file_weight = 1.0;
 	mb_command command;
@@ -443,8 +485,19 @@ int main(int argc, char **argv) {
 			mb_get_relative_path(verbose, file, pwd, &error);
 			mb_get_relative_path(verbose, dfile, pwd, &error);
 
-			/* generate inf fnv fbt files */
-			if (make_inf) {
+			/* generate inf fnv fbt files, queueing the files to be done
+			    concurrently if more than one thread is to be used */
+			if (make_inf && n_threads > 1) {
+				struct mbdatalist_job_struct job;
+				strcpy(job.file, file);
+				job.format = format;
+				struct stat file_status;
+				job.filesize = stat(file, &file_status) == 0 ? file_status.st_size : 0;
+				job.status = MB_SUCCESS;
+				job.error = MB_ERROR_NO_ERROR;
+				jobs.push_back(job);
+			}
+			else if (make_inf) {
 				status = mb_make_info(verbose, force_update, file, format, &error);
 			}
 
@@ -563,6 +616,28 @@ int main(int argc, char **argv) {
 			}
 		}
 		mb_datalist_close(verbose, &datalist, &error);
+
+		/* generate the queued ancillary files, largest first so that the long
+		    running files start early and the small files fill in around them -
+		    each file is read in a separate mbinfo process */
+		if (!jobs.empty()) {
+			std::stable_sort(jobs.begin(), jobs.end(),
+			                 [](const mbdatalist_job_struct &a, const mbdatalist_job_struct &b) { return a.filesize > b.filesize; });
+			const unsigned int n_workers = std::min(n_threads, (unsigned int)jobs.size());
+			std::atomic<size_t> next_job(0);
+			std::thread workers[MB_THREAD_MAX];
+			for (unsigned int ithread = 0; ithread < n_workers; ithread++)
+				workers[ithread] = std::thread(make_info_files, verbose, force_update, &jobs, &next_job);
+			for (unsigned int ithread = 0; ithread < n_workers; ithread++)
+				workers[ithread].join();
+			for (const mbdatalist_job_struct &job : jobs) {
+				if (job.status != MB_SUCCESS) {
+					fprintf(stderr, "Unable to generate ancillary files for %s\n", job.file);
+					status = job.status;
+					error = job.error;
+				}
+			}
+		}
 	}
 
 	/* set program status */
@@ -71,7 +71,7 @@ constexpr char help_message[] =
     "file exists one will be created.";
 constexpr char usage_message[] =
     "mbdefaults [-Bfileiobuffer -Dpsdisplay -Ffbtversion -Iimagedisplay -Llonflip\n"
-    "    -Mmbviewsettings\n\t-Ttimegap -Wproject -V -H]";
+    "    -Mmbviewsettings\n\t-Rreadahead -Ttimegap -Wproject -V -H]";
 
 /*--------------------------------------------------------------------*/
 
@@ -123,13 +123,16 @@ int main(int argc, char **argv) {
 	int fileiobuffer = 0;
 	status &= mb_fileiobuffer(verbose, &fileiobuffer);
 
+	int readahead = 0;
+	status &= mb_readahead(verbose, &readahead);
+
 	bool flag = false;
 
 	{
 		bool errflg = false;
 		bool help = false;
 		int c;
-		while ((c = getopt(argc, argv, "B:b:D:d:F:f:HhI:i:L:l:M:m:T:t:U:u:VvW:w:")) != -1)
+		while ((c = getopt(argc, argv, "B:b:D:d:F:f:HhI:i:L:l:M:m:R:r:T:t:U:u:VvW:w:")) != -1)
 		{
 			switch (c) {
 			case 'B':
@@ -199,6 +202,11 @@ int main(int argc, char **argv) {
 				flag = true;
 				break;
 			}
+			case 'R':
+			case 'r':
+				sscanf(optarg, "%d", &readahead);
+				flag = true;
+				break;
 			case 'T':
 			case 't':
 				sscanf(optarg, "%lf", &timegap);
@@ -279,6 +287,7 @@ int main(int argc, char **argv) {
 			fprintf(stderr, "dbg2       fbtversion:                 %d\n", fbtversion);
 			fprintf(stderr, "dbg2       uselockfiles:               %d\n", uselockfiles);
 			fprintf(stderr, "dbg2       fileiobuffer:               %d\n", fileiobuffer);
+			fprintf(stderr, "dbg2       readahead:                  %d\n", readahead);
 			fprintf(stderr, "dbg2       primary_colortable:         %d\n", primary_colortable);
 			fprintf(stderr, "dbg2       primary_colortable_mode:    %d\n", primary_colortable_mode);
 			fprintf(stderr, "dbg2       primary_shade_mode:         %d\n", primary_shade_mode);
@@ -318,6 +327,7 @@ int main(int argc, char **argv) {
 		fprintf(fp, "fbtversion: %d\n", fbtversion);
 		fprintf(fp, "uselockfiles:%d\n", uselockfiles);
 		fprintf(fp, "fileiobuffer:%d\n", fileiobuffer);
+		fprintf(fp, "readahead:%d\n", readahead);
 		fprintf(fp, "mbview_primary_colortable:        %d\n", primary_colortable);
 		fprintf(fp, "mbview_primary_colortable_mode:   %d\n", primary_colortable_mode);
 		fprintf(fp, "mbview_primary_shade_mode:        %d\n", primary_shade_mode);
@@ -349,7 +359,11 @@ int main(int argc, char **argv) {
 		else if (fileiobuffer > 0)
 			printf("fileiobuffer: %d (use %d kB buffer for fread() & fwrite())\n", fileiobuffer, fileiobuffer);
 		else
-			printf("fileiobuffer: %d (use mmap for file i/o)\n", fileiobuffer);
+			printf("fileiobuffer: %d (use mmap for file input where supported)\n", fileiobuffer);
+		if (readahead > 0)
+			printf("readahead: %d (read up to %d records ahead in a separate thread where supported)\n", readahead, readahead);
+		else
+			printf("readahead: %d (read records when requested)\n", readahead);
 		if (primary_colortable == MBV_COLORTABLE_HAXBY)
 			printf("mbview primary colortable:    %d  (Haxby)\n", primary_colortable);
 		else if (primary_colortable == MBV_COLORTABLE_BRIGHT)
@@ -439,7 +453,11 @@ int main(int argc, char **argv) {
 		else if (fileiobuffer > 0)
 			printf("fileiobuffer: %d (use %d kB buffer for fread() & fwrite())\n", fileiobuffer, fileiobuffer);
 		else
-			printf("fileiobuffer: %d (use mmap for file i/o)\n", fileiobuffer);
+			printf("fileiobuffer: %d (use mmap for file input where supported)\n", fileiobuffer);
+		if (readahead > 0)
+			printf("readahead: %d (read up to %d records ahead in a separate thread where supported)\n", readahead, readahead);
+		else
+			printf("readahead: %d (read records when requested)\n", readahead);
 		if (primary_colortable == MBV_COLORTABLE_HAXBY)
 			printf("mbview primary colortable:         %d  (Haxby)\n", primary_colortable);
 		else if (primary_colortable == MBV_COLORTABLE_BRIGHT)
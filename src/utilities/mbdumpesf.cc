@@ -57,7 +57,7 @@ constexpr char help_message[] =
     "contents as an ascii table to stdout.";
 constexpr char usage_message[] =
     "mbdumpesf --input=esffile\n"
-    "\t[--output=esffile --ignore-unflag --ignore-flag\n"
+    "\t[--output=esffile --compact --ignore-unflag --ignore-flag\n"
     "\t--ignore-filter --ignore-zero\n"
     "\t--verbose --help]";
 
@@ -73,6 +73,7 @@ int main(int argc, char **argv) {
 	FILE *iesffp = nullptr;
 	FILE *oesffp = nullptr;
 
+	bool compact = false;
 	bool ignore_unflag = false;
 	bool ignore_flag = false;
 	bool ignore_filter = false;
@@ -85,6 +86,7 @@ int main(int argc, char **argv) {
 			{"help", no_argument, nullptr, 0},
 			{"input", required_argument, nullptr, 0},
 			{"output", required_argument, nullptr, 0},
+			{"compact", no_argument, nullptr, 0},
 			{"ignore-unflag", no_argument, nullptr, 0},
 			{"ignore-flag", no_argument, nullptr, 0},
 			{"ignore-filter", no_argument, nullptr, 0},
@@ -112,6 +114,9 @@ int main(int argc, char **argv) {
 					strcpy(oesffile, optarg);
 					omode = OUTPUT_ESF;
 				}
+				else if (strcmp("compact", options[option_index].name) == 0) {
+					compact = true;
+				}
 				else if (strcmp("ignore-unflag", options[option_index].name) == 0) {
 					ignore_unflag = true;
 				}
@@ -170,6 +175,7 @@ int main(int argc, char **argv) {
 			fprintf(stderr, "dbg2       omode:            %d\n", omode);
 			if (omode == OUTPUT_ESF)
 				fprintf(stderr, "dbg2       output esf file:  %s\n", oesffile);
+			fprintf(stderr, "dbg2       compact:          %d\n", compact);
 			fprintf(stderr, "dbg2       ignore_unflag:    %d\n", ignore_unflag);
 			fprintf(stderr, "dbg2       ignore_flag:      %d\n", ignore_flag);
 			fprintf(stderr, "dbg2       ignore_filter:    %d\n", ignore_filter);
@@ -194,6 +200,15 @@ int main(int argc, char **argv) {
 
 	int error = MB_ERROR_NO_ERROR;
 
+	/* if compacting load the edits sorted and with superseded edits removed */
+	struct mb_esf_struct esf;
+	memset(&esf, 0, sizeof(struct mb_esf_struct));
+	if (compact && mb_esf_open(verbose, program_name, iesffile, true, MBP_ESF_NOWRITE, &esf, &error) != MB_SUCCESS) {
+		fprintf(stderr, "\nUnable to load edit save file <%s>\n", iesffile);
+		fprintf(stderr, "\nProgram <%s> Terminated\n", program_name);
+		exit(error);
+	}
+
 	/* check that esf file exists */
 	struct stat file_status;
 	const int fstat = stat(iesffile, &file_status);
@@ -219,14 +234,15 @@ int main(int argc, char **argv) {
 		if (fread(esf_header, MB_PATH_MAXLINE, 1, iesffp) == 1 && strncmp(esf_header, "ESFVERSION", 10) == 0) {
 			nedit = (file_status.st_size - MB_PATH_MAXLINE) / (sizeof(double) + 2 * sizeof(int));
 
+			/* compacted files are version 4 */
 			if (omode == OUTPUT_ESF && oesffp != nullptr) {
 				memset(esf_header, 0, MB_PATH_MAXLINE);
-				const int esf_mode = MB_ESF_MODE_EXPLICIT;
+				const int esf_mode = compact ? esf.mode : MB_ESF_MODE_EXPLICIT;
         char user[256], host[256], date[32];
         status = mb_user_host_date(verbose, user, host, date, &error);
 				snprintf(esf_header, sizeof(esf_header),
-				        "ESFVERSION03\nESF Mode: %d\nMB-System Version %s\nProgram: %s\nUser: %s\nCPU: %s\nDate: %s\n",
-				        esf_mode, MB_VERSION, program_name, user, host, date);
+				        "ESFVERSION%2.2d\nESF Mode: %d\nMB-System Version %s\nProgram: %s\nUser: %s\nCPU: %s\nDate: %s\n",
+				        compact ? 4 : 3, esf_mode, MB_VERSION, program_name, user, host, date);
 				if (fwrite(esf_header, MB_PATH_MAXLINE, 1, oesffp) != 1) {
 					status = MB_FAILURE;
 					error = MB_ERROR_WRITE_FAIL;
@@ -237,11 +253,18 @@ int main(int argc, char **argv) {
 			rewind(iesffp);
 			nedit = file_status.st_size / (sizeof(double) + 2 * sizeof(int));
 		}
+		if (compact)
+			nedit = esf.nedit;
 
 		/* loop over reading edit events and printing them out */
 		for (int i = 0; i < nedit && error == MB_ERROR_NO_ERROR; i++) {
 			bool ignore = false;
-			if (fread(&(time_d), sizeof(double), 1, iesffp) != 1 || fread(&(beam), sizeof(int), 1, iesffp) != 1 ||
+			if (compact) {
+				time_d = esf.edit[i].time_d;
+				beam = esf.edit[i].beam;
+				action = esf.edit[i].action;
+			}
+			else if (fread(&(time_d), sizeof(double), 1, iesffp) != 1 || fread(&(beam), sizeof(int), 1, iesffp) != 1 ||
 			    fread(&(action), sizeof(int), 1, iesffp) != 1) {
 				ignore = true;
 				status = MB_FAILURE;
@@ -333,6 +356,8 @@ int main(int argc, char **argv) {
 		if (omode == OUTPUT_ESF)
 			fclose(oesffp);
 	}
+	if (compact)
+		mb_esf_close(verbose, &esf, &error);
 
 	/* give the statistics */
 	if (verbose >= 1) {
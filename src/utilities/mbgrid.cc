@@ -47,12 +47,17 @@
 
 #include <algorithm>
 #include <cmath>
+#include <condition_variable>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <ctime>
+#include <fcntl.h>
 #include <getopt.h>
 #include <limits>
+#include <mutex>
+#include <sys/mman.h>
+#include <thread>
 #include <unistd.h>
 
 #include "mb_aux.h"
@@ -121,16 +126,16 @@ constexpr double MBGRID_TINY = 0.00000001;
 constexpr double FOOT_THETA_MAX = 85.0;
 
 /* interpolation algorithm
-    The code is set to use either of two
+    The code can use either of two
     algorithms for 2D thin plate spline
-    interpolation. If the USESURFACE preprocessor
-    define is defined then
-    the code will use the surface algorithm
-    from GMT. If not, then the zgrid
-    algorithm will be used.
-    - The default is to use zgrid - to
-    change this uncomment the define below. */
-/* #define USESURFACE */
+    interpolation. The default is the zgrid
+    algorithm; the --surface option selects
+    the surface algorithm from GMT instead,
+    which is solved in parallel when
+    --threads is also given. */
+
+/* default spline tension of the surface algorithm */
+constexpr double MBGRID_SURFACE_TENSION = 0.35;
 
 /* output stream for basic stuff (stdout if verbose <= 1,
     stderr if verbose > 1) */
@@ -150,7 +155,9 @@ constexpr char usage_message[] =
     "mbgrid   -Ifilelist -Oroot [-Adatatype -Bborder -Cclip[/mode] -Dxdim/ydim\n"
     "          -Edx/dy/units[!]  -Fmode[/threshold] -Ggridkind -Jprojection\n"
     "          -Kbackground -Llonflip -M -N -Ppings -Q  -Rwest/east/south/north\n"
-    "          -Rfactor  -Sspeed  -Ttension  -Utime  -V -Wscale -Xextend]";
+    "          -Rfactor  -Sspeed  -Ttension  -Utime  -V -Wscale -Xextend\n"
+    "          --threads=nthreads --tile-size=ncells --percentiles=p1/p2/...\n"
+    "          --median-cap=nvalues --surface]";
 
 /*--------------------------------------------------------------------*/
 /* approximate error function altered from numerical recipes */
@@ -430,10 +437,18 @@ int mbgrid_weight(int verbose, double foot_a, double foot_b, double pcx, double
 }
 
 /*--------------------------------------------------------------------*/
-
-int main(int argc, char **argv) {
-  int verbose = 0;
-  int format;
+/*
+ * Parallel read-and-bin pipeline used by the weighted mean, minimum filter
+ * and maximum filter algorithms when the --threads option is given.
+ *
+ * Each datalist entry is read by a worker thread and binned into a partial
+ * accumulator that covers only the window of grid cells touched by that
+ * file. The main thread merges the partial accumulators into the full grid
+ * strictly in datalist order, so the output grids do not depend on the
+ * number of threads used.
+ */
+struct mbgrid_bin_par_struct {
+  int verbose;
   int pings;
   int lonflip;
   double bounds[4];
@@ -441,245 +456,1932 @@ int main(int argc, char **argv) {
   int etime_i[7];
   double speedmin;
   double timegap;
-  int status = mb_defaults(verbose, &format, &pings, &lonflip, bounds, btime_i, etime_i, &speedmin, &timegap);
+  grid_data_t datatype;
+  grid_alg_t grid_mode;
+  bool use_projection;
+  char projection_id[MB_PATH_MAXLINE];
+  void *pjptr; /* projection of the main thread, which workers must not use */
+  double wbnd[4];
+  double dx;
+  double dy;
+  int gxdim;
+  int gydim;
+  int xtradim;
+  double factor;
+  double topofactor;
+};
+
+struct mbgrid_partial_struct {
+  /* datalist entry */
+  char path[MB_PATH_MAXLINE];
+  char ppath[MB_PATH_MAXLINE];
+  char apath[MB_PATH_MAXLINE];
+  char file[MB_PATH_MAXLINE];
+  int pstatus;
+  int astatus;
+  int format;
+  double file_weight;
 
-  grid_data_t datatype = MBGRID_DATA_BATHYMETRY;
-  double border = 0.0;
-  bool setborder = false;
-  char gridkindstring[MB_PATH_MAXLINE] = "";
-  int clip = 0;
-  int xdim = 101;
-  int ydim = 101;
-  char fileroot[MB_PATH_MAXLINE] = "grid";
-  char projection_id[MB_PATH_MAXLINE] = "Geographic";
-  double gbnd[4] = {0.0, 0.0, 0.0, 0.0};
-  bool gbndset = false;
-  double scale = 1.0;
-  double extend = 0.0;
-  double shift_x = 0.0;
-  double shift_y = 0.0;
-  bool shift = false;
-  bool first_in_stays = true;
-  bool check_time = false;
-  double timediff = 300.0;
-#ifdef USESURFACE
-  double tension = 0.35;
-#else
-  double tension = 0.0;
-#endif
+  /* partial accumulator covering grid cells
+      ix0 <= ix < ix0 + nx, iy0 <= iy < iy0 + ny */
+  int ix0;
+  int iy0;
+  int nx;
+  int ny;
+  double *grid;
+  double *norm;
+  double *sigma;
+  int *num;
+  int *cnt;
+
+  /* results */
+  bool file_in_bounds;
+  int ndatafile;
+  double dmin;
+  double dmax;
+  int status;
+  int error;
+  bool done;
+};
 
-  double boundsfactor = 0.0;
-  bool bathy_in_feet = false;
-  bool more = false;
-  bool use_NaN = false;
-  int grdrasterid = 0;
-  char projection_pars[MB_PATH_MAXLINE] = "";
-  bool projection_pars_f = false;
-  char filelist[MB_PATH_MAXLINE] = "datalist.mb-1";
-  char backgroundfile[MB_PATH_MAXLINE] = "";
-  grid_type_t gridkind = MBGRID_GMTGRD;
-  double minormax_weighted_mean_threshold = 1.0;
-  grid_alg_t grid_mode = MBGRID_WEIGHTED_MEAN;
-  bool set_spacing = false;
-  char units[MB_PATH_MAXLINE] = "";
-  double dx_set = 0.0;
-  double dy_set = 0.0;
-  bool spacing_priority = false;
-  bool set_dimensions = false;
-  grid_interp_t clipmode = MBGRID_INTERP_NONE;
+/*--------------------------------------------------------------------*/
+/*
+ * function mbgrid_read_soundings reads the soundings of one datalist entry
+ * into a buffer of projected (x, y, value) triples, using a projection
+ * object that belongs to the calling thread
+ */
+int mbgrid_read_soundings(const struct mbgrid_bin_par_struct *par, void *pjptr, struct mbgrid_partial_struct *partial,
+                          int *nsndg, double **sndg) {
+  const int verbose = par->verbose;
+  int status = MB_SUCCESS;
+  int error = MB_ERROR_NO_ERROR;
+  partial->file_in_bounds = false;
 
-  {
-    bool errflg = false;
-    int c;
-    bool help = false;
-    while ((c = getopt(argc, argv, "A:a:B:b:C:c:D:d:E:e:F:f:G:g:HhI:i:J:j:K:k:L:l:MmNnO:o:P:p:QqR:r:S:s:T:t:U:u:VvW:w:X:x:Y:y:")) !=
-           -1)
-    {
-      switch (c) {
-      case 'A':
-      case 'a':
-      {
-        int tmp;
-        sscanf(optarg, "%d", &tmp);
-        datatype = (grid_data_t)tmp;
-        break;
-      }
-      case 'B':
-      case 'b':
-        sscanf(optarg, "%lf", &border);
-        setborder = true;
-        break;
-      case 'C':
-      case 'c':
-      {
-        const int n = sscanf(optarg, "%d/%d", &clip, (int *)&clipmode);
-        if (n < 1)
-          clipmode = MBGRID_INTERP_NONE;
-        else if (n == 1 && clip > 0)
-          clipmode = MBGRID_INTERP_GAP;
-        else if (n == 1)
-          clipmode = MBGRID_INTERP_NONE;
-        else if (clip > 0 && clipmode < 0)
-          clipmode = MBGRID_INTERP_GAP;
-        else if (clipmode >= 3)
-          clipmode = MBGRID_INTERP_ALL;
-        break;
+  /* buffer of (x, y, value) triples */
+  int nsndg_alloc = 0;
+  *nsndg = 0;
+  *sndg = nullptr;
+
+  if (partial->format > 0) {
+    /* apply pstatus */
+    if (partial->pstatus == MB_PROCESSED_USE)
+      strcpy(partial->file, partial->ppath);
+    else
+      strcpy(partial->file, partial->path);
+
+    /* check for mbinfo file - get file bounds if possible */
+    int rformat = partial->format;
+    double bounds[4] = {par->bounds[0], par->bounds[1], par->bounds[2], par->bounds[3]};
+    int btime_i[7];
+    int etime_i[7];
+    for (int i = 0; i < 7; i++) {
+      btime_i[i] = par->btime_i[i];
+      etime_i[i] = par->etime_i[i];
+    }
+    status = mb_check_info(verbose, partial->file, par->lonflip, bounds, &partial->file_in_bounds, &error);
+    if (status == MB_FAILURE) {
+      partial->file_in_bounds = true;
+      status = MB_SUCCESS;
+      error = MB_ERROR_NO_ERROR;
+    }
+
+    if (partial->file_in_bounds) {
+      /* check for "fast bathymetry" or "fbt" file */
+      if (par->datatype == MBGRID_DATA_TOPOGRAPHY || par->datatype == MBGRID_DATA_BATHYMETRY)
+        mb_get_fbt(verbose, partial->file, &rformat, &error);
+
+      void *mbio_ptr = nullptr;
+      double btime_d;
+      double etime_d;
+      int beams_bath;
+      int beams_amp;
+      int pixels_ss;
+      if (mb_read_init_altnav(verbose, partial->file, rformat, par->pings, par->lonflip, bounds, btime_i, etime_i,
+                              par->speedmin, par->timegap, partial->astatus, partial->apath, &mbio_ptr, &btime_d,
+                              &etime_d, &beams_bath, &beams_amp, &pixels_ss, &error) != MB_SUCCESS) {
+        partial->status = MB_FAILURE;
+        partial->error = error;
+        return (MB_FAILURE);
       }
-      case 'D':
-      case 'd':
-      {
-        const int n = sscanf(optarg, "%d/%d", &xdim, &ydim);
-        if (n == 2)
-          set_dimensions = true;
-        break;
+
+      char *beamflag = nullptr;
+      double *bath = nullptr;
+      double *bathlon = nullptr;
+      double *bathlat = nullptr;
+      double *amp = nullptr;
+      double *ss = nullptr;
+      double *sslon = nullptr;
+      double *sslat = nullptr;
+      if (error == MB_ERROR_NO_ERROR)
+        status = mb_register_array(verbose, mbio_ptr, MB_MEM_TYPE_BATHYMETRY, sizeof(char), (void **)&beamflag, &error);
+      if (error == MB_ERROR_NO_ERROR)
+        status = mb_register_array(verbose, mbio_ptr, MB_MEM_TYPE_BATHYMETRY, sizeof(double), (void **)&bath, &error);
+      if (error == MB_ERROR_NO_ERROR)
+        status = mb_register_array(verbose, mbio_ptr, MB_MEM_TYPE_AMPLITUDE, sizeof(double), (void **)&amp, &error);
+      if (error == MB_ERROR_NO_ERROR)
+        status = mb_register_array(verbose, mbio_ptr, MB_MEM_TYPE_BATHYMETRY, sizeof(double), (void **)&bathlon, &error);
+      if (error == MB_ERROR_NO_ERROR)
+        status = mb_register_array(verbose, mbio_ptr, MB_MEM_TYPE_BATHYMETRY, sizeof(double), (void **)&bathlat, &error);
+      if (error == MB_ERROR_NO_ERROR)
+        status = mb_register_array(verbose, mbio_ptr, MB_MEM_TYPE_SIDESCAN, sizeof(double), (void **)&ss, &error);
+      if (error == MB_ERROR_NO_ERROR)
+        status = mb_register_array(verbose, mbio_ptr, MB_MEM_TYPE_SIDESCAN, sizeof(double), (void **)&sslon, &error);
+      if (error == MB_ERROR_NO_ERROR)
+        status = mb_register_array(verbose, mbio_ptr, MB_MEM_TYPE_SIDESCAN, sizeof(double), (void **)&sslat, &error);
+      if (error != MB_ERROR_NO_ERROR) {
+        partial->status = MB_FAILURE;
+        partial->error = error;
+        mb_close(verbose, &mbio_ptr, &error);
+        return (MB_FAILURE);
       }
-      case 'E':
-      case 'e':
-      {
-        if (optarg[strlen(optarg) - 1] == '!') {
-          spacing_priority = true;
-          optarg[strlen(optarg) - 1] = '\0';
+
+      /* loop over reading */
+      int kind;
+      int rpings;
+      int time_i[7];
+      double time_d;
+      double navlon;
+      double navlat;
+      double speed;
+      double heading;
+      double distance;
+      double altitude;
+      double sensordepth;
+      char comment[MB_COMMENT_MAXLINE];
+      while (error <= MB_ERROR_NO_ERROR) {
+        status = mb_read(verbose, mbio_ptr, &kind, &rpings, time_i, &time_d, &navlon, &navlat, &speed, &heading,
+                         &distance, &altitude, &sensordepth, &beams_bath, &beams_amp, &pixels_ss, beamflag, bath, amp,
+                         bathlon, bathlat, ss, sslon, sslat, comment, &error);
+
+        /* time gaps are not a problem here */
+        if (error == MB_ERROR_TIME_GAP) {
+          error = MB_ERROR_NO_ERROR;
+          status = MB_SUCCESS;
         }
-        const int n = sscanf(optarg, "%lf/%lf/%1023s", &dx_set, &dy_set, units);
-        if (n > 1)
-          set_spacing = true;
-        if (n < 3)
-          strcpy(units, "meters");
-        break;
-      }
-      case 'F':
-      case 'f':
-      {
-        int tmp;
-        double dvalue;
-        const int n = sscanf(optarg, "%d/%lf", &tmp, &dvalue);
-        grid_mode = (grid_alg_t)tmp;
-        if (n == 2) {
-          if (grid_mode == MBGRID_MINIMUM_FILTER) {
-            minormax_weighted_mean_threshold = dvalue;
-            grid_mode = MBGRID_MINIMUM_WEIGHTED_MEAN;
-          } else if (grid_mode == MBGRID_MAXIMUM_FILTER) {
-            minormax_weighted_mean_threshold = dvalue;
-            grid_mode = MBGRID_MAXIMUM_WEIGHTED_MEAN;
-          } else {
-            minormax_weighted_mean_threshold = dvalue;
-          }
+        if (error != MB_ERROR_NO_ERROR)
+          continue;
+
+        /* select the values to be gridded */
+        int nvalue = 0;
+        double *value = nullptr;
+        double *vlon = nullptr;
+        double *vlat = nullptr;
+        double vfactor = 1.0;
+        if (par->datatype == MBGRID_DATA_BATHYMETRY || par->datatype == MBGRID_DATA_TOPOGRAPHY) {
+          nvalue = beams_bath;
+          value = bath;
+          vlon = bathlon;
+          vlat = bathlat;
+          vfactor = par->topofactor;
         }
-        break;
-      }
-      case 'G':
-      case 'g':
-        if (optarg[0] == '=') {
-          gridkind = MBGRID_GMTGRD;
-          strcpy(gridkindstring, optarg);
+        else if (par->datatype == MBGRID_DATA_AMPLITUDE) {
+          nvalue = beams_amp;
+          value = amp;
+          vlon = bathlon;
+          vlat = bathlat;
         }
-        else {
-          int tmp;
-          int nscan = sscanf(optarg, "%d", &tmp);
-          // Range check
-          if (nscan == 1 && tmp >= 1 && tmp <= 4) {
-            gridkind = (grid_type_t)tmp;
-            if (gridkind == MBGRID_CDFGRD) {
-              gridkind = MBGRID_GMTGRD;
-              gridkindstring[0] = '\0';
-            }
-          } else if (optarg[0] == 'n' || optarg[0] == 'c' || optarg[0] == 'b'
-                    || optarg[0] == 'r' || optarg[0] == 's' || optarg[0] == 'a'
-                    || optarg[0] == 'e' || optarg[0] == 'g'){
-            snprintf(gridkindstring, sizeof(gridkindstring), "=%s", optarg);
-            gridkind = MBGRID_GMTGRD;
-          } else {
-            fprintf(stdout, "Invalid gridkind option: -G%s\n\n", optarg);
-            errflg = true;
-          }
+        else if (par->datatype == MBGRID_DATA_SIDESCAN) {
+          nvalue = pixels_ss;
+          value = ss;
+          vlon = sslon;
+          vlat = sslat;
         }
-        break;
-      case 'H':
-      case 'h':
-        help = true;
-        break;
-      case 'I':
-      case 'i':
-        sscanf(optarg, "%1023s", filelist);
-        break;
-      case 'J':
-      case 'j':
-        sscanf(optarg, "%1023s", projection_pars);
-        projection_pars_f = true;
-        break;
-      case 'K':
-      case 'k':
-        sscanf(optarg, "%1023s", backgroundfile);
-        if ((grdrasterid = (int)strtol(backgroundfile, NULL, 10)) <= 0)
-          grdrasterid = -1;
-        break;
-      case 'L':
-      case 'l':
-        sscanf(optarg, "%d", &lonflip);
-        break;
-      case 'M':
-      case 'm':
-        more = true;
-        break;
-      case 'N':
-      case 'n':
-        use_NaN = true;
-        break;
-      case 'O':
-      case 'o':
-        sscanf(optarg, "%1023s", fileroot);
-        break;
-      case 'P':
-      case 'p':
-        sscanf(optarg, "%d", &pings);
-        break;
-      case 'Q':
-      case 'q':
-        bathy_in_feet = true;
-        break;
-      case 'R':
-      case 'r':
-        if (strchr(optarg, '/') == nullptr) {
-          sscanf(optarg, "%lf", &boundsfactor);
-          if (boundsfactor <= 1.0)
-            boundsfactor = 0.0;
+
+        /* make sure the sounding buffer can hold this ping */
+        if (*nsndg + nvalue > nsndg_alloc) {
+          nsndg_alloc = std::max(2 * nsndg_alloc, *nsndg + nvalue + REALLOC_STEP_SIZE);
+          status = mb_reallocd(verbose, __FILE__, __LINE__, 3 * nsndg_alloc * sizeof(double), (void **)sndg, &error);
+          if (status != MB_SUCCESS) {
+            partial->status = MB_FAILURE;
+            partial->error = error;
+            mb_close(verbose, &mbio_ptr, &error);
+            return (MB_FAILURE);
+          }
         }
-        else {
-          mb_get_bounds(optarg, gbnd);
-          gbndset = true;
+
+        for (int ib = 0; ib < nvalue; ib++) {
+          const bool ok = par->datatype == MBGRID_DATA_SIDESCAN ? value[ib] > MB_SIDESCAN_NULL : mb_beam_ok(beamflag[ib]);
+          if (ok) {
+            double x = vlon[ib];
+            double y = vlat[ib];
+            if (par->use_projection)
+              mb_proj_forward(verbose, pjptr, x, y, &x, &y, &error);
+            (*sndg)[3 * *nsndg] = x;
+            (*sndg)[3 * *nsndg + 1] = y;
+            (*sndg)[3 * *nsndg + 2] = vfactor * value[ib];
+            (*nsndg)++;
+          }
         }
-        break;
-      case 'S':
-      case 's':
-        sscanf(optarg, "%lf", &speedmin);
-        break;
-      case 'T':
-      case 't':
-        sscanf(optarg, "%lf", &tension);
-        break;
-      case 'U':
-      case 'u':
-        sscanf(optarg, "%lf", &timediff);
-        timediff = 60 * timediff;
-        check_time = true;
-        if (timediff < 0.0) {
-          timediff = fabs(timediff);
-          first_in_stays = false;
+        error = MB_ERROR_NO_ERROR;
+      }
+      mb_close(verbose, &mbio_ptr, &error);
+      status = MB_SUCCESS;
+      error = MB_ERROR_NO_ERROR;
+    }
+  }
+  else if (partial->format == 0) {
+    /* lon,lat,value triples file */
+    strcpy(partial->file, partial->path);
+    FILE *rfp = fopen(partial->path, "r");
+    if (rfp == nullptr) {
+      partial->status = MB_FAILURE;
+      partial->error = MB_ERROR_OPEN_FAIL;
+      return (MB_FAILURE);
+    }
+    partial->file_in_bounds = true;
+    double tlon;
+    double tlat;
+    double tvalue;
+    while (fscanf(rfp, "%lf %lf %lf", &tlon, &tlat, &tvalue) != EOF) {
+      if (*nsndg + 1 > nsndg_alloc) {
+        nsndg_alloc = std::max(2 * nsndg_alloc, *nsndg + REALLOC_STEP_SIZE);
+        status = mb_reallocd(verbose, __FILE__, __LINE__, 3 * nsndg_alloc * sizeof(double), (void **)sndg, &error);
+        if (status != MB_SUCCESS) {
+          partial->status = MB_FAILURE;
+          partial->error = error;
+          fclose(rfp);
+          return (MB_FAILURE);
         }
-        break;
-      case 'V':
-      case 'v':
-        verbose++;
-        if (verbose >= 2)
-          outfp = stderr;
-        break;
-      case 'W':
-      case 'w':
-        sscanf(optarg, "%lf", &scale);
-        break;
-      case 'X':
-      case 'x':
-        sscanf(optarg, "%lf", &extend);
+      }
+      if (par->use_projection)
+        mb_proj_forward(verbose, pjptr, tlon, tlat, &tlon, &tlat, &error);
+      (*sndg)[3 * *nsndg] = tlon;
+      (*sndg)[3 * *nsndg + 1] = tlat;
+      (*sndg)[3 * *nsndg + 2] = par->topofactor * tvalue;
+      (*nsndg)++;
+    }
+    fclose(rfp);
+  }
+  return (status);
+}
+
+/*--------------------------------------------------------------------*/
+/*
+ * function mbgrid_partial_read reads the soundings of one datalist entry
+ * and bins them into a partial accumulator sized to the cells touched
+ * by the file
+ */
+void mbgrid_partial_read(const struct mbgrid_bin_par_struct *par, void *pjptr, struct mbgrid_partial_struct *partial) {
+  const int verbose = par->verbose;
+  int status = MB_SUCCESS;
+  int error = MB_ERROR_NO_ERROR;
+
+  partial->ix0 = 0;
+  partial->iy0 = 0;
+  partial->nx = 0;
+  partial->ny = 0;
+  partial->grid = nullptr;
+  partial->norm = nullptr;
+  partial->sigma = nullptr;
+  partial->num = nullptr;
+  partial->cnt = nullptr;
+  partial->file_in_bounds = false;
+  partial->ndatafile = 0;
+  partial->dmin = 0.0;
+  partial->dmax = 0.0;
+
+  /* read the soundings */
+  int nsndg = 0;
+  double *sndg = nullptr;
+  if (mbgrid_read_soundings(par, pjptr, partial, &nsndg, &sndg) != MB_SUCCESS) {
+    if (sndg != nullptr)
+      mb_freed(verbose, __FILE__, __LINE__, (void **)&sndg, &error);
+    return;
+  }
+
+  /* the weighted mean accepts triples data just outside the grid */
+  const int xtra = (partial->format == 0 && par->grid_mode == MBGRID_WEIGHTED_MEAN) ? par->xtradim : 0;
+
+  /* get the window of grid cells touched by this file */
+  int ixmin = par->gxdim;
+  int ixmax = -1;
+  int iymin = par->gydim;
+  int iymax = -1;
+  for (int i = 0; i < nsndg; i++) {
+    const int ix = (sndg[3 * i] - par->wbnd[0] + 0.5 * par->dx) / par->dx;
+    const int iy = (sndg[3 * i + 1] - par->wbnd[2] + 0.5 * par->dy) / par->dy;
+    if (ix >= -xtra && ix < par->gxdim + xtra && iy >= -xtra && iy < par->gydim + xtra) {
+      ixmin = std::min(ixmin, ix);
+      ixmax = std::max(ixmax, ix);
+      iymin = std::min(iymin, iy);
+      iymax = std::max(iymax, iy);
+    }
+  }
+  if (par->grid_mode == MBGRID_WEIGHTED_MEAN) {
+    ixmin -= par->xtradim;
+    ixmax += par->xtradim;
+    iymin -= par->xtradim;
+    iymax += par->xtradim;
+  }
+  ixmin = std::max(ixmin, 0);
+  ixmax = std::min(ixmax, par->gxdim - 1);
+  iymin = std::max(iymin, 0);
+  iymax = std::min(iymax, par->gydim - 1);
+
+  /* allocate and initialize the partial accumulator */
+  if (ixmax >= ixmin && iymax >= iymin) {
+    partial->ix0 = ixmin;
+    partial->iy0 = iymin;
+    partial->nx = ixmax - ixmin + 1;
+    partial->ny = iymax - iymin + 1;
+    const size_t nwindow = (size_t)partial->nx * (size_t)partial->ny;
+    status = mb_mallocd(verbose, __FILE__, __LINE__, nwindow * sizeof(double), (void **)&partial->grid, &error);
+    if (status == MB_SUCCESS)
+      status = mb_mallocd(verbose, __FILE__, __LINE__, nwindow * sizeof(double), (void **)&partial->norm, &error);
+    if (status == MB_SUCCESS)
+      status = mb_mallocd(verbose, __FILE__, __LINE__, nwindow * sizeof(double), (void **)&partial->sigma, &error);
+    if (status == MB_SUCCESS)
+      status = mb_mallocd(verbose, __FILE__, __LINE__, nwindow * sizeof(int), (void **)&partial->num, &error);
+    if (status == MB_SUCCESS)
+      status = mb_mallocd(verbose, __FILE__, __LINE__, nwindow * sizeof(int), (void **)&partial->cnt, &error);
+    if (status != MB_SUCCESS) {
+      partial->status = MB_FAILURE;
+      partial->error = error;
+      mb_freed(verbose, __FILE__, __LINE__, (void **)&sndg, &error);
+      return;
+    }
+    memset(partial->grid, 0, nwindow * sizeof(double));
+    memset(partial->norm, 0, nwindow * sizeof(double));
+    memset(partial->sigma, 0, nwindow * sizeof(double));
+    memset(partial->num, 0, nwindow * sizeof(int));
+    memset(partial->cnt, 0, nwindow * sizeof(int));
+  }
+
+  /* bin the soundings into the partial accumulator */
+  for (int i = 0; i < nsndg && partial->nx > 0; i++) {
+    const double x = sndg[3 * i];
+    const double y = sndg[3 * i + 1];
+    const double v = sndg[3 * i + 2];
+    const int ix = (x - par->wbnd[0] + 0.5 * par->dx) / par->dx;
+    const int iy = (y - par->wbnd[2] + 0.5 * par->dy) / par->dy;
+    if (par->grid_mode == MBGRID_WEIGHTED_MEAN && ix >= -xtra && ix < par->gxdim + xtra && iy >= -xtra &&
+        iy < par->gydim + xtra) {
+      const int ix1 = std::max(ix - par->xtradim, 0);
+      const int ix2 = std::min(ix + par->xtradim, par->gxdim - 1);
+      const int iy1 = std::max(iy - par->xtradim, 0);
+      const int iy2 = std::min(iy + par->xtradim, par->gydim - 1);
+      for (int ii = ix1; ii <= ix2; ii++)
+        for (int jj = iy1; jj <= iy2; jj++) {
+          const int kpart = (ii - partial->ix0) * partial->ny + (jj - partial->iy0);
+          const double xx = par->wbnd[0] + ii * par->dx - x;
+          const double yy = par->wbnd[2] + jj * par->dy - y;
+          const double weight = partial->file_weight * exp(-(xx * xx + yy * yy) * par->factor);
+          partial->norm[kpart] += weight;
+          partial->grid[kpart] += weight * v;
+          partial->sigma[kpart] += weight * v * v;
+          partial->num[kpart]++;
+          if (ii == ix && jj == iy)
+            partial->cnt[kpart]++;
+        }
+    }
+    else if (ix >= 0 && ix < par->gxdim && iy >= 0 && iy < par->gydim) {
+      const int kpart = (ix - partial->ix0) * partial->ny + (iy - partial->iy0);
+      if ((partial->num[kpart] > 0 && par->grid_mode == MBGRID_MINIMUM_FILTER && partial->grid[kpart] > v) ||
+          (partial->num[kpart] > 0 && par->grid_mode == MBGRID_MAXIMUM_FILTER && partial->grid[kpart] < v) ||
+          partial->num[kpart] <= 0) {
+        partial->norm[kpart] = 1.0;
+        partial->grid[kpart] = v;
+        partial->sigma[kpart] = v * v;
+        partial->num[kpart] = 1;
+        partial->cnt[kpart] = 1;
+      }
+    }
+    else {
+      continue;
+    }
+    if (partial->ndatafile == 0) {
+      partial->dmin = v;
+      partial->dmax = v;
+    }
+    else {
+      partial->dmin = std::min(v, partial->dmin);
+      partial->dmax = std::max(v, partial->dmax);
+    }
+    partial->ndatafile++;
+  }
+
+  mb_freed(verbose, __FILE__, __LINE__, (void **)&sndg, &error);
+  partial->status = MB_SUCCESS;
+  partial->error = MB_ERROR_NO_ERROR;
+}
+
+/*--------------------------------------------------------------------*/
+/*
+ * function mbgrid_partial_merge adds a partial accumulator into the full
+ * grid arrays
+ */
+void mbgrid_partial_merge(int verbose, grid_alg_t grid_mode, int gydim, struct mbgrid_partial_struct *partial,
+                          double *grid, double *norm, double *sigma, int *num, int *cnt) {
+  for (int i = 0; i < partial->nx; i++)
+    for (int j = 0; j < partial->ny; j++) {
+      const int kpart = i * partial->ny + j;
+      const int kgrid = (partial->ix0 + i) * gydim + (partial->iy0 + j);
+      if (grid_mode == MBGRID_WEIGHTED_MEAN) {
+        norm[kgrid] += partial->norm[kpart];
+        grid[kgrid] += partial->grid[kpart];
+        sigma[kgrid] += partial->sigma[kpart];
+        num[kgrid] += partial->num[kpart];
+        cnt[kgrid] += partial->cnt[kpart];
+      }
+      else if (partial->num[kpart] > 0
+               && ((num[kgrid] > 0 && grid_mode == MBGRID_MINIMUM_FILTER && grid[kgrid] > partial->grid[kpart]) ||
+                   (num[kgrid] > 0 && grid_mode == MBGRID_MAXIMUM_FILTER && grid[kgrid] < partial->grid[kpart]) ||
+                   num[kgrid] <= 0)) {
+        norm[kgrid] = partial->norm[kpart];
+        grid[kgrid] = partial->grid[kpart];
+        sigma[kgrid] = partial->sigma[kpart];
+        num[kgrid] = partial->num[kpart];
+        cnt[kgrid] = partial->cnt[kpart];
+      }
+    }
+}
+
+/*--------------------------------------------------------------------*/
+/*
+ * function mbgrid_partial_free releases a partial accumulator
+ */
+void mbgrid_partial_free(int verbose, struct mbgrid_partial_struct *partial) {
+  int error = MB_ERROR_NO_ERROR;
+  if (partial->grid != nullptr)
+    mb_freed(verbose, __FILE__, __LINE__, (void **)&partial->grid, &error);
+  if (partial->norm != nullptr)
+    mb_freed(verbose, __FILE__, __LINE__, (void **)&partial->norm, &error);
+  if (partial->sigma != nullptr)
+    mb_freed(verbose, __FILE__, __LINE__, (void **)&partial->sigma, &error);
+  if (partial->num != nullptr)
+    mb_freed(verbose, __FILE__, __LINE__, (void **)&partial->num, &error);
+  if (partial->cnt != nullptr)
+    mb_freed(verbose, __FILE__, __LINE__, (void **)&partial->cnt, &error);
+  partial->nx = 0;
+  partial->ny = 0;
+}
+
+/*--------------------------------------------------------------------*/
+/*
+ * function mbgrid_partial_worker is run by each worker thread - it claims
+ * datalist entries in order, but never runs more than nahead entries
+ * ahead of the merge so that the memory held in partial accumulators
+ * stays bounded
+ */
+struct mbgrid_queue_struct {
+  std::mutex mutex;
+  std::condition_variable cond;
+  int nentry;
+  int next;
+  int merged;
+  int nahead;
+  struct mbgrid_partial_struct *entries;
+};
+
+void mbgrid_partial_worker(const struct mbgrid_bin_par_struct *par, void *pjptr, struct mbgrid_queue_struct *queue) {
+  while (true) {
+    int ientry;
+    {
+      std::unique_lock<std::mutex> lock(queue->mutex);
+      queue->cond.wait(lock, [queue] { return queue->next >= queue->nentry || queue->next < queue->merged + queue->nahead; });
+      if (queue->next >= queue->nentry)
+        return;
+      ientry = queue->next++;
+    }
+
+    mbgrid_partial_read(par, pjptr, &queue->entries[ientry]);
+
+    {
+      std::lock_guard<std::mutex> lock(queue->mutex);
+      queue->entries[ientry].done = true;
+    }
+    queue->cond.notify_all();
+  }
+}
+
+/*--------------------------------------------------------------------*/
+/*
+ * function mbgrid_read_parallel reads and bins all of the datalist entries
+ * using n_threads worker threads, merging the results into the full grid
+ * arrays in datalist order
+ */
+int mbgrid_read_parallel(const struct mbgrid_bin_par_struct *par, int n_threads, char *filelist, FILE *dfp,
+                         double *grid, double *norm, double *sigma, int *num, int *cnt, int *ndata, int *error) {
+  const int verbose = par->verbose;
+  int status = MB_SUCCESS;
+
+  /* read the whole datalist up front */
+  struct mbgrid_queue_struct queue;
+  queue.nentry = 0;
+  queue.next = 0;
+  queue.merged = 0;
+  queue.nahead = 2 * n_threads;
+  queue.entries = nullptr;
+  int nentry_alloc = 0;
+  void *datalist = nullptr;
+  const int look_processed = MB_DATALIST_LOOK_UNSET;
+  if (mb_datalist_open(verbose, &datalist, filelist, look_processed, error) != MB_SUCCESS) {
+    *error = MB_ERROR_OPEN_FAIL;
+    fprintf(outfp, "\nUnable to open data list file: %s\n", filelist);
+    return (MB_FAILURE);
+  }
+  struct mbgrid_partial_struct entry;
+  memset(&entry, 0, sizeof(struct mbgrid_partial_struct));
+  char dpath[MB_PATH_MAXLINE] = "";
+  while (mb_datalist_read3(verbose, datalist, &entry.pstatus, entry.path, entry.ppath, &entry.astatus, entry.apath,
+                           dpath, &entry.format, &entry.file_weight, error) == MB_SUCCESS) {
+    if (entry.format < 0 || entry.path[0] == '#')
+      continue;
+    if (queue.nentry >= nentry_alloc) {
+      nentry_alloc += REALLOC_STEP_SIZE;
+      status = mb_reallocd(verbose, __FILE__, __LINE__, nentry_alloc * sizeof(struct mbgrid_partial_struct),
+                           (void **)&queue.entries, error);
+      if (status != MB_SUCCESS) {
+        mb_datalist_close(verbose, &datalist, error);
+        return (status);
+      }
+    }
+    queue.entries[queue.nentry] = entry;
+    queue.entries[queue.nentry].done = false;
+    queue.nentry++;
+  }
+  mb_datalist_close(verbose, &datalist, error);
+  *error = MB_ERROR_NO_ERROR;
+
+  /* give each worker thread its own copy of the projection with its own
+      context - PROJ objects and the default context are not thread safe.
+      The copies are made here because the main thread owns the original.
+      If the projection cannot be copied then a single worker uses the
+      original, which the main thread does not touch while merging. */
+  n_threads = std::max(1, std::min(n_threads, queue.nentry));
+  void **thread_ctx = new void *[n_threads];
+  void **thread_pjptr = new void *[n_threads];
+  for (int ithread = 0; ithread < n_threads; ithread++) {
+    thread_ctx[ithread] = nullptr;
+    thread_pjptr[ithread] = nullptr;
+  }
+  bool shared_pjptr = false;
+  if (par->pjptr != nullptr) {
+    int proj_error = MB_ERROR_NO_ERROR;
+    for (int ithread = 0; ithread < n_threads && !shared_pjptr; ithread++) {
+      if (mb_proj_clone(verbose, par->pjptr, &thread_ctx[ithread], &thread_pjptr[ithread], &proj_error) != MB_SUCCESS)
+        shared_pjptr = true;
+    }
+    if (shared_pjptr) {
+      for (int ithread = 0; ithread < n_threads; ithread++)
+        mb_proj_clone_free(verbose, &thread_ctx[ithread], &thread_pjptr[ithread], &proj_error);
+      if (verbose > 0 && n_threads > 1)
+        fprintf(outfp, "Unable to copy projection %s for each thread - reading with one thread\n", par->projection_id);
+      n_threads = 1;
+      thread_pjptr[0] = par->pjptr;
+    }
+  }
+
+  /* start the worker threads */
+  std::thread *workers = new std::thread[n_threads];
+  for (int ithread = 0; ithread < n_threads; ithread++)
+    workers[ithread] = std::thread(mbgrid_partial_worker, par, thread_pjptr[ithread], &queue);
+
+  /* merge the partial accumulators in datalist order */
+  *ndata = 0;
+  for (int ientry = 0; ientry < queue.nentry && status == MB_SUCCESS; ientry++) {
+    struct mbgrid_partial_struct *partial = &queue.entries[ientry];
+    {
+      std::unique_lock<std::mutex> lock(queue.mutex);
+      queue.cond.wait(lock, [partial] { return partial->done; });
+    }
+
+    if (partial->status != MB_SUCCESS) {
+      char *message = nullptr;
+      mb_error(verbose, partial->error, &message);
+      if (partial->format > 0) {
+        fprintf(outfp, "\nMBIO Error returned from function <mb_read_init_altnav>:\n%s\n", message);
+        fprintf(outfp, "\nMultibeam File <%s> not initialized for reading\n", partial->file);
+      }
+      else {
+        fprintf(outfp, "\nUnable to open lon,lat,value triples data file1: %s\n", partial->path);
+      }
+      status = MB_FAILURE;
+      *error = partial->error;
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      queue.next = queue.nentry;
+      break;
+    }
+
+    mbgrid_partial_merge(verbose, par->grid_mode, par->gydim, partial, grid, norm, sigma, num, cnt);
+    mbgrid_partial_free(verbose, partial);
+    *ndata += partial->ndatafile;
+    if (verbose >= 2)
+      fprintf(outfp, "\n");
+    if (verbose > 0 || partial->file_in_bounds)
+      fprintf(outfp, "%d data points processed in %s (minmax: %f %f)\n", partial->ndatafile, partial->file,
+              partial->dmin, partial->dmax);
+
+    /* add to datalist if data actually contributed */
+    if (partial->ndatafile > 0 && dfp != nullptr) {
+      if (partial->pstatus == MB_PROCESSED_USE && partial->astatus == MB_ALTNAV_USE)
+        fprintf(dfp, "A:%s %d %f %s\n", partial->path, partial->format, partial->file_weight, partial->apath);
+      else if (partial->pstatus == MB_PROCESSED_USE)
+        fprintf(dfp, "P:%s %d %f\n", partial->path, partial->format, partial->file_weight);
+      else
+        fprintf(dfp, "R:%s %d %f\n", partial->path, partial->format, partial->file_weight);
+      fflush(dfp);
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      queue.merged = ientry + 1;
+    }
+    queue.cond.notify_all();
+  }
+
+  /* wait for the workers - on failure any partials not yet merged are discarded */
+  queue.cond.notify_all();
+  for (int ithread = 0; ithread < n_threads; ithread++)
+    workers[ithread].join();
+  delete[] workers;
+  int tmp_error = MB_ERROR_NO_ERROR;
+  if (!shared_pjptr) {
+    for (int ithread = 0; ithread < n_threads; ithread++)
+      mb_proj_clone_free(verbose, &thread_ctx[ithread], &thread_pjptr[ithread], &tmp_error);
+  }
+  delete[] thread_ctx;
+  delete[] thread_pjptr;
+  for (int ientry = 0; ientry < queue.nentry; ientry++)
+    mbgrid_partial_free(verbose, &queue.entries[ientry]);
+  if (queue.entries != nullptr)
+    mb_freed(verbose, __FILE__, __LINE__, (void **)&queue.entries, &tmp_error);
+
+  return (status);
+}
+
+/*--------------------------------------------------------------------*/
+/*
+ * Value pool used by the median filter algorithm. The values binned into
+ * each cell are held in a chain of fixed size blocks drawn from a single
+ * contiguous pool, rather than in a separately reallocated array per cell,
+ * which avoids the per cell allocation overhead and slack. The median and
+ * any requested percentiles of each cell are then found by selection on a
+ * gathered copy of the cell values rather than by sorting.
+ *
+ * The storage of each cell is bounded by a cap. A cell holds all of its
+ * values, and so yields exact results, until it has received cap values;
+ * after that it holds a uniform random sample of cap of them (reservoir
+ * sampling), from which its median and percentiles are estimated. A full
+ * cell is moved into consecutive blocks, and the blocks it leaves are
+ * reused by other cells, so the pool never holds more than about twice
+ * the cap for any cell. A cap of zero keeps every value, as earlier
+ * versions did.
+ */
+
+/* number of values held in each block of the median filter value pool */
+constexpr int MBGRID_MEDIAN_BLOCK = 16;
+
+/* default maximum number of values held for a single cell */
+constexpr int MBGRID_MEDIAN_CAP = 4096;
+
+/* maximum number of percentile grids that can be requested */
+constexpr int MBGRID_PERCENTILE_MAX = 8;
+
+struct mbgrid_median_struct {
+  int ncell;
+  int cap;             /* maximum values held per cell, 0 for no limit */
+  unsigned int seed;   /* state of the reservoir sampling generator */
+  int nsampled;        /* number of times a cell has exceeded the cap */
+  int *head;  /* first block of each cell, -1 if none */
+  int *tail;  /* block holding the most recent value of each cell */
+  int nblock;
+  int nblock_alloc;
+  double *value;
+  int *next;  /* next block in the chain, -1 if none */
+  int freeblock;  /* first block of the free list, -1 if none */
+  int nwork;
+  double *work;
+};
+
+/*--------------------------------------------------------------------*/
+/*
+ * function mbgrid_median_init initializes an empty value pool for ncell
+ * cells holding at most cap values each
+ */
+int mbgrid_median_init(int verbose, struct mbgrid_median_struct *median, int ncell, int cap, int *error) {
+  memset(median, 0, sizeof(struct mbgrid_median_struct));
+  median->ncell = ncell;
+  median->cap = cap;
+  median->seed = 2463534242U;
+  median->freeblock = -1;
+  int status = mb_mallocd(verbose, __FILE__, __LINE__, ncell * sizeof(int), (void **)&median->head, error);
+  if (status == MB_SUCCESS)
+    status = mb_mallocd(verbose, __FILE__, __LINE__, ncell * sizeof(int), (void **)&median->tail, error);
+  if (status == MB_SUCCESS) {
+    for (int k = 0; k < ncell; k++) {
+      median->head[k] = -1;
+      median->tail[k] = -1;
+    }
+  }
+  return (status);
+}
+
+/*--------------------------------------------------------------------*/
+/*
+ * function mbgrid_median_blocks takes n consecutive unused blocks from the
+ * end of the pool, enlarging it as needed, and returns the first of them
+ * or -1 if memory cannot be allocated
+ */
+int mbgrid_median_blocks(int verbose, struct mbgrid_median_struct *median, int n, int *error) {
+  if (median->nblock + n > median->nblock_alloc) {
+    median->nblock_alloc = std::max(2 * median->nblock_alloc, median->ncell / 4 + REALLOC_STEP_SIZE);
+    median->nblock_alloc = std::max(median->nblock_alloc, median->nblock + n);
+    if (mb_reallocd(verbose, __FILE__, __LINE__, (size_t)median->nblock_alloc * MBGRID_MEDIAN_BLOCK * sizeof(double),
+                    (void **)&median->value, error) != MB_SUCCESS
+        || mb_reallocd(verbose, __FILE__, __LINE__, median->nblock_alloc * sizeof(int), (void **)&median->next,
+                       error) != MB_SUCCESS)
+      return (-1);
+  }
+  const int block = median->nblock;
+  median->nblock += n;
+  for (int i = 0; i < n; i++)
+    median->next[block + i] = (i < n - 1) ? block + i + 1 : -1;
+  return (block);
+}
+
+/*--------------------------------------------------------------------*/
+/*
+ * function mbgrid_median_add stores a value in cell kgrid, which has
+ * currently received count values - when a cell count has been reset to
+ * zero the blocks already chained to the cell are reused, and once a cell
+ * has received cap values each further value replaces a randomly chosen
+ * held value with probability cap / (count + 1)
+ */
+int mbgrid_median_add(int verbose, struct mbgrid_median_struct *median, int kgrid, int count, double value,
+                      int *error) {
+  if (median->cap > 0 && count >= median->cap) {
+    /* when a cell first fills, move its values into consecutive blocks
+        so that any held value can be replaced without walking the chain,
+        and put the blocks it used on the free list */
+    if (count == median->cap) {
+      median->nsampled++;
+      const int nblock = (median->cap + MBGRID_MEDIAN_BLOCK - 1) / MBGRID_MEDIAN_BLOCK;
+      bool consecutive = true;
+      for (int i = 0; i < nblock - 1 && consecutive; i++)
+        consecutive = median->next[median->head[kgrid] + i] == median->head[kgrid] + i + 1;
+      if (!consecutive) {
+        const int first = mbgrid_median_blocks(verbose, median, nblock, error);
+        if (first < 0)
+          return (MB_FAILURE);
+        int block = median->head[kgrid];
+        for (int i = 0; i < nblock; i++) {
+          memcpy(&median->value[(size_t)(first + i) * MBGRID_MEDIAN_BLOCK],
+                 &median->value[(size_t)block * MBGRID_MEDIAN_BLOCK], MBGRID_MEDIAN_BLOCK * sizeof(double));
+          const int next = median->next[block];
+          median->next[block] = median->freeblock;
+          median->freeblock = block;
+          block = next;
+        }
+        median->head[kgrid] = first;
+        median->tail[kgrid] = first + nblock - 1;
+      }
+    }
+
+    /* xorshift generator, seeded identically for every run so that
+        the grids are reproducible */
+    median->seed ^= median->seed << 13;
+    median->seed ^= median->seed >> 17;
+    median->seed ^= median->seed << 5;
+    const int slot = (int)(median->seed % ((unsigned int)count + 1));
+    if (slot < median->cap)
+      median->value[(size_t)median->head[kgrid] * MBGRID_MEDIAN_BLOCK + slot] = value;
+    return (MB_SUCCESS);
+  }
+  if (count % MBGRID_MEDIAN_BLOCK == 0) {
+    int block = (count == 0) ? median->head[kgrid] : median->next[median->tail[kgrid]];
+    if (block < 0) {
+      if (median->freeblock >= 0) {
+        block = median->freeblock;
+        median->freeblock = median->next[block];
+        median->next[block] = -1;
+      }
+      else if ((block = mbgrid_median_blocks(verbose, median, 1, error)) < 0)
+        return (MB_FAILURE);
+      if (count == 0)
+        median->head[kgrid] = block;
+      else
+        median->next[median->tail[kgrid]] = block;
+    }
+    median->tail[kgrid] = block;
+  }
+  median->value[(size_t)median->tail[kgrid] * MBGRID_MEDIAN_BLOCK + count % MBGRID_MEDIAN_BLOCK] = value;
+  return (MB_SUCCESS);
+}
+
+/*--------------------------------------------------------------------*/
+/*
+ * function mbgrid_median_gather copies the values held for cell kgrid, which
+ * has received count values, into the work buffer of the pool and returns a
+ * pointer to them - nvalue returns the number held, which is count unless
+ * the cell has exceeded the cap
+ */
+double *mbgrid_median_gather(int verbose, struct mbgrid_median_struct *median, int kgrid, int count, int *nvalue,
+                             int *error) {
+  if (median->cap > 0)
+    count = std::min(count, median->cap);
+  *nvalue = count;
+  if (count > median->nwork) {
+    median->nwork = count;
+    if (mb_reallocd(verbose, __FILE__, __LINE__, median->nwork * sizeof(double), (void **)&median->work, error)
+        != MB_SUCCESS)
+      return (nullptr);
+  }
+  int n = 0;
+  for (int block = median->head[kgrid]; n < count; block = median->next[block]) {
+    const int m = std::min(MBGRID_MEDIAN_BLOCK, count - n);
+    memcpy(&median->work[n], &median->value[(size_t)block * MBGRID_MEDIAN_BLOCK], m * sizeof(double));
+    n += m;
+  }
+  return (median->work);
+}
+
+/*--------------------------------------------------------------------*/
+/*
+ * function mbgrid_median_select returns the value at the given percentile
+ * of the count values, using the same upper median convention as the median
+ * filter so that the 50th percentile is the median - the values are
+ * partially reordered in place
+ */
+double mbgrid_median_select(double *values, int count, double percentile) {
+  const int k = std::min(std::max((int)(0.01 * percentile * count), 0), count - 1);
+  std::nth_element(values, values + k, values + count);
+  return (values[k]);
+}
+
+/*--------------------------------------------------------------------*/
+/*
+ * function mbgrid_median_free releases the value pool
+ */
+void mbgrid_median_free(int verbose, struct mbgrid_median_struct *median) {
+  int error = MB_ERROR_NO_ERROR;
+  mb_freed(verbose, __FILE__, __LINE__, (void **)&median->head, &error);
+  mb_freed(verbose, __FILE__, __LINE__, (void **)&median->tail, &error);
+  if (median->value != nullptr)
+    mb_freed(verbose, __FILE__, __LINE__, (void **)&median->value, &error);
+  if (median->next != nullptr)
+    mb_freed(verbose, __FILE__, __LINE__, (void **)&median->next, &error);
+  if (median->work != nullptr)
+    mb_freed(verbose, __FILE__, __LINE__, (void **)&median->work, &error);
+  median->nblock = 0;
+  median->nblock_alloc = 0;
+  median->nwork = 0;
+}
+
+/*--------------------------------------------------------------------*/
+/*
+ * Out-of-core tiled gridding engine used by the weighted mean, minimum
+ * filter and maximum filter algorithms when the --tile-size option is given.
+ *
+ * The soundings are read in a single pass and spilled in chunks to a
+ * scratch file, each chunk belonging to one square tile of the grid.
+ * Soundings near a tile edge are copied to the neighbouring tiles so that
+ * each tile can be gridded and spline interpolated independently over its
+ * own cells plus an overlap margin. The scratch file is memory mapped when
+ * the tiles are processed, and the tile results are stitched into memory
+ * mapped output grids, so that peak memory scales with the tile size
+ * rather than the grid size.
+ */
+
+/* number of soundings buffered per tile before a chunk is spilled */
+constexpr int MBGRID_TILE_BUFFER = 512;
+
+struct mbgrid_tile_sndg_struct {
+  double x;
+  double y;
+  double value;
+  float weight;
+  int xtra;
+};
+
+struct mbgrid_tile_chunk_struct {
+  size_t offset;
+  int count;
+};
+
+struct mbgrid_tile_struct {
+  /* soundings not yet spilled */
+  int nbuffer;
+  struct mbgrid_tile_sndg_struct *buffer;
+
+  /* chunks already spilled to the scratch file */
+  int nchunk;
+  int nchunk_alloc;
+  struct mbgrid_tile_chunk_struct *chunks;
+
+  /* results */
+  int nbinset;
+  int nbinspline;
+  bool zset;
+  double zmin;
+  double zmax;
+  int nmax;
+  bool sset;
+  double smin;
+  double smax;
+};
+
+struct mbgrid_tiling_struct {
+  /* tile geometry */
+  int tile_size;
+  int overlap;
+  int ntx;
+  int nty;
+  struct mbgrid_tile_struct *tiles;
+
+  /* scratch files, which are made in the directory of the output grid */
+  char scratchdir[MB_PATH_MAXLINE];
+  FILE *spillfp;
+  size_t spillsize;
+  char *spill;
+
+  /* interpolation controls */
+  bool surface;
+  grid_interp_t clipmode;
+  int clip;
+  bool setborder;
+  double border;
+  double tension;
+  double clipvalue;
+  double bdata_origin_x;
+  double bdata_origin_y;
+
+  /* output grids */
+  int xdim;
+  int ydim;
+  int offx;
+  int offy;
+  bool more;
+  bool ascii;
+  float outclipvalue;
+  float *zout;
+  float *nout;
+  float *sout;
+
+  /* work distribution between threads */
+  std::mutex mutex;
+  int next;
+};
+
+/*--------------------------------------------------------------------*/
+/*
+ * function mbgrid_scratch_open creates a uniquely named scratch file in
+ * directory dir and unlinks it at once, so that concurrent runs cannot
+ * collide and nothing is left behind however the program ends - returns
+ * the open file descriptor, or -1 on failure
+ */
+int mbgrid_scratch_open(const char *dir, const char *name, int *error) {
+  char path[2 * MB_PATH_MAXLINE];
+  snprintf(path, sizeof(path), "%s/tmpmbgrid_%s_XXXXXX", dir, name);
+  const int fd = mkstemp(path);
+  if (fd < 0) {
+    *error = MB_ERROR_OPEN_FAIL;
+    fprintf(outfp, "\nUnable to open scratch file: %s\n", path);
+    return (-1);
+  }
+  unlink(path);
+  *error = MB_ERROR_NO_ERROR;
+  return (fd);
+}
+
+/*--------------------------------------------------------------------*/
+/*
+ * function mbgrid_mmap_alloc allocates an array backed by a memory mapped
+ * scratch file, so the operating system can page it out as needed
+ */
+int mbgrid_mmap_alloc(int verbose, const char *dir, const char *name, size_t size, void **ptr, int *error) {
+  *ptr = nullptr;
+  const int fd = mbgrid_scratch_open(dir, name, error);
+  if (fd < 0)
+    return (MB_FAILURE);
+  if (ftruncate(fd, size) != 0) {
+    close(fd);
+    *error = MB_ERROR_MEMORY_FAIL;
+    return (MB_FAILURE);
+  }
+  void *map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    *error = MB_ERROR_MEMORY_FAIL;
+    return (MB_FAILURE);
+  }
+  *ptr = map;
+  *error = MB_ERROR_NO_ERROR;
+
+  if (verbose >= 2) {
+    fprintf(outfp, "\ndbg2  Memory mapped scratch array <%s> of %zu bytes allocated at %p\n", name, size, *ptr);
+  }
+
+  return (MB_SUCCESS);
+}
+
+/*--------------------------------------------------------------------*/
+/*
+ * function mbgrid_tile_spill writes the buffered soundings of a tile to
+ * the scratch file as a new chunk
+ */
+int mbgrid_tile_spill(int verbose, struct mbgrid_tiling_struct *tiling, struct mbgrid_tile_struct *tile, int *error) {
+  if (tile->nbuffer <= 0)
+    return (MB_SUCCESS);
+
+  if (tile->nchunk >= tile->nchunk_alloc) {
+    tile->nchunk_alloc += REALLOC_STEP_SIZE;
+    if (mb_reallocd(verbose, __FILE__, __LINE__, tile->nchunk_alloc * sizeof(struct mbgrid_tile_chunk_struct),
+                    (void **)&tile->chunks, error) != MB_SUCCESS)
+      return (MB_FAILURE);
+  }
+  const size_t nbytes = tile->nbuffer * sizeof(struct mbgrid_tile_sndg_struct);
+  if (fwrite(tile->buffer, 1, nbytes, tiling->spillfp) != nbytes) {
+    *error = MB_ERROR_WRITE_FAIL;
+    return (MB_FAILURE);
+  }
+  tile->chunks[tile->nchunk].offset = tiling->spillsize;
+  tile->chunks[tile->nchunk].count = tile->nbuffer;
+  tile->nchunk++;
+  tiling->spillsize += nbytes;
+  tile->nbuffer = 0;
+
+  return (MB_SUCCESS);
+}
+
+/*--------------------------------------------------------------------*/
+/*
+ * function mbgrid_floordiv is integer division rounding toward minus infinity
+ */
+int mbgrid_floordiv(int a, int b) {
+  return (a >= 0 ? a / b : -((-a + b - 1) / b));
+}
+
+/*--------------------------------------------------------------------*/
+/*
+ * function mbgrid_tile_add appends a sounding to every tile whose cells,
+ * including the overlap margin, can be affected by it
+ */
+int mbgrid_tile_add(const struct mbgrid_bin_par_struct *par, struct mbgrid_tiling_struct *tiling,
+                    const struct mbgrid_tile_sndg_struct *sndg, int ix, int iy, int *error) {
+  const int verbose = par->verbose;
+  const int reach = (par->grid_mode == MBGRID_WEIGHTED_MEAN ? par->xtradim : 0) + tiling->overlap;
+  const int tx1 = std::max(mbgrid_floordiv(ix - reach, tiling->tile_size), 0);
+  const int tx2 = std::min(mbgrid_floordiv(ix + reach, tiling->tile_size), tiling->ntx - 1);
+  const int ty1 = std::max(mbgrid_floordiv(iy - reach, tiling->tile_size), 0);
+  const int ty2 = std::min(mbgrid_floordiv(iy + reach, tiling->tile_size), tiling->nty - 1);
+  for (int tx = tx1; tx <= tx2; tx++)
+    for (int ty = ty1; ty <= ty2; ty++) {
+      struct mbgrid_tile_struct *tile = &tiling->tiles[tx * tiling->nty + ty];
+      if (tile->buffer == nullptr) {
+        if (mb_mallocd(verbose, __FILE__, __LINE__, MBGRID_TILE_BUFFER * sizeof(struct mbgrid_tile_sndg_struct),
+                       (void **)&tile->buffer, error) != MB_SUCCESS)
+          return (MB_FAILURE);
+      }
+      tile->buffer[tile->nbuffer] = *sndg;
+      tile->nbuffer++;
+      if (tile->nbuffer >= MBGRID_TILE_BUFFER && mbgrid_tile_spill(verbose, tiling, tile, error) != MB_SUCCESS)
+        return (MB_FAILURE);
+    }
+
+  return (MB_SUCCESS);
+}
+
+/*--------------------------------------------------------------------*/
+/*
+ * function mbgrid_tile_process grids one tile from its spilled soundings,
+ * interpolates it over its overlap window, and writes the cells belonging
+ * to the tile into the output grids
+ */
+int mbgrid_tile_process(const struct mbgrid_bin_par_struct *par, struct mbgrid_tiling_struct *tiling, int itile,
+                        int *error) {
+  const int verbose = par->verbose;
+  struct mbgrid_tile_struct *tile = &tiling->tiles[itile];
+  const int tx = itile / tiling->nty;
+  const int ty = itile % tiling->nty;
+  const double clipvalue = tiling->clipvalue;
+  const int gxdim = par->gxdim;
+  const int gydim = par->gydim;
+  const double dx = par->dx;
+  const double dy = par->dy;
+
+  /* cells belonging to this tile */
+  const int cx0 = tx * tiling->tile_size;
+  const int cx1 = std::min(cx0 + tiling->tile_size, gxdim) - 1;
+  const int cy0 = ty * tiling->tile_size;
+  const int cy1 = std::min(cy0 + tiling->tile_size, gydim) - 1;
+
+  /* cells of the overlap window */
+  const int ex0 = std::max(cx0 - tiling->overlap, 0);
+  const int ex1 = std::min(cx1 + tiling->overlap, gxdim - 1);
+  const int ey0 = std::max(cy0 - tiling->overlap, 0);
+  const int ey1 = std::min(cy1 + tiling->overlap, gydim - 1);
+  int enx = ex1 - ex0 + 1;
+  int eny = ey1 - ey0 + 1;
+  const size_t nwindow = (size_t)enx * (size_t)eny;
+
+  tile->nbinset = 0;
+  tile->nbinspline = 0;
+  tile->zset = false;
+  tile->zmin = 0.0;
+  tile->zmax = 0.0;
+  tile->nmax = 0;
+  tile->sset = false;
+  tile->smin = 0.0;
+  tile->smax = 0.0;
+
+  /* window accumulators and interpolation arrays, all released by
+      cleanup() on every return */
+  double *grid = nullptr;
+  double *norm = nullptr;
+  double *sigma = nullptr;
+  int *num = nullptr;
+  int *cnt = nullptr;
+  float *sgrid = nullptr;
+  bool *smask = nullptr;
+  float *sxdata = nullptr;
+  float *sydata = nullptr;
+  float *szdata = nullptr;
+  float *sdata = nullptr;
+  float *work1 = nullptr;
+  int *work2 = nullptr;
+  bool *work3 = nullptr;
+  auto cleanup = [&]() {
+    int tmp_error = MB_ERROR_NO_ERROR;
+    void **arrays[] = {(void **)&grid, (void **)&norm, (void **)&sigma, (void **)&num, (void **)&cnt,
+                       (void **)&sgrid, (void **)&smask,
+                       (void **)&sxdata, (void **)&sydata, (void **)&szdata,
+                       (void **)&sdata, (void **)&work1, (void **)&work2, (void **)&work3};
+    for (void **array : arrays)
+      if (*array != nullptr)
+        mb_freed(verbose, __FILE__, __LINE__, array, &tmp_error);
+  };
+
+  /* allocate the window accumulators */
+  int status = mb_mallocd(verbose, __FILE__, __LINE__, nwindow * sizeof(double), (void **)&grid, error);
+  if (status == MB_SUCCESS)
+    status = mb_mallocd(verbose, __FILE__, __LINE__, nwindow * sizeof(double), (void **)&norm, error);
+  if (status == MB_SUCCESS)
+    status = mb_mallocd(verbose, __FILE__, __LINE__, nwindow * sizeof(double), (void **)&sigma, error);
+  if (status == MB_SUCCESS)
+    status = mb_mallocd(verbose, __FILE__, __LINE__, nwindow * sizeof(int), (void **)&num, error);
+  if (status == MB_SUCCESS)
+    status = mb_mallocd(verbose, __FILE__, __LINE__, nwindow * sizeof(int), (void **)&cnt, error);
+  if (status != MB_SUCCESS) {
+    cleanup();
+    return (status);
+  }
+  memset(grid, 0, nwindow * sizeof(double));
+  memset(norm, 0, nwindow * sizeof(double));
+  memset(sigma, 0, nwindow * sizeof(double));
+  memset(num, 0, nwindow * sizeof(int));
+  memset(cnt, 0, nwindow * sizeof(int));
+
+  /* bin the soundings of each chunk in the order they were read */
+  for (int ichunk = 0; ichunk < tile->nchunk; ichunk++) {
+    const struct mbgrid_tile_sndg_struct *sndg =
+        (const struct mbgrid_tile_sndg_struct *)(tiling->spill + tile->chunks[ichunk].offset);
+    for (int isndg = 0; isndg < tile->chunks[ichunk].count; isndg++) {
+      const double x = sndg[isndg].x;
+      const double y = sndg[isndg].y;
+      const double v = sndg[isndg].value;
+      const int xtra = sndg[isndg].xtra;
+      const int ix = (x - par->wbnd[0] + 0.5 * dx) / dx;
+      const int iy = (y - par->wbnd[2] + 0.5 * dy) / dy;
+      if (par->grid_mode == MBGRID_WEIGHTED_MEAN) {
+        if (ix >= -xtra && ix < gxdim + xtra && iy >= -xtra && iy < gydim + xtra) {
+          const int ix1 = std::max(ix - par->xtradim, ex0);
+          const int ix2 = std::min(ix + par->xtradim, ex1);
+          const int iy1 = std::max(iy - par->xtradim, ey0);
+          const int iy2 = std::min(iy + par->xtradim, ey1);
+          for (int ii = ix1; ii <= ix2; ii++)
+            for (int jj = iy1; jj <= iy2; jj++) {
+              const int kwin = (ii - ex0) * eny + (jj - ey0);
+              const double xx = par->wbnd[0] + ii * dx - x;
+              const double yy = par->wbnd[2] + jj * dy - y;
+              const double weight = sndg[isndg].weight * exp(-(xx * xx + yy * yy) * par->factor);
+              norm[kwin] += weight;
+              grid[kwin] += weight * v;
+              sigma[kwin] += weight * v * v;
+              num[kwin]++;
+              if (ii == ix && jj == iy)
+                cnt[kwin]++;
+            }
+        }
+      }
+      else if (ix >= ex0 && ix <= ex1 && iy >= ey0 && iy <= ey1) {
+        const int kwin = (ix - ex0) * eny + (iy - ey0);
+        if ((num[kwin] > 0 && par->grid_mode == MBGRID_MINIMUM_FILTER && grid[kwin] > v) ||
+            (num[kwin] > 0 && par->grid_mode == MBGRID_MAXIMUM_FILTER && grid[kwin] < v) || num[kwin] <= 0) {
+          norm[kwin] = 1.0;
+          grid[kwin] = v;
+          sigma[kwin] = v * v;
+          num[kwin] = 1;
+          cnt[kwin] = 1;
+        }
+      }
+    }
+  }
+
+  /* make the raw grid over the window */
+  int ndata = 0;
+  for (int i = ex0; i <= ex1; i++)
+    for (int j = ey0; j <= ey1; j++) {
+      const int kwin = (i - ex0) * eny + (j - ey0);
+      if (cnt[kwin] > 0) {
+        grid[kwin] = grid[kwin] / norm[kwin];
+        const double factor = sigma[kwin] / norm[kwin] - grid[kwin] * grid[kwin];
+        sigma[kwin] = sqrt(fabs(factor));
+        ndata++;
+        if (i >= cx0 && i <= cx1 && j >= cy0 && j <= cy1)
+          tile->nbinset++;
+      }
+      else {
+        grid[kwin] = clipvalue;
+        sigma[kwin] = 0.0;
+      }
+    }
+
+  /* if clip set do smooth interpolation over the window */
+  if (tiling->clipmode != MBGRID_INTERP_NONE && tiling->clip > 0 && ndata > 0) {
+    /* border points are only set along the edges of the full grid */
+    if (tiling->setborder)
+      ndata += 2 * enx + 2 * eny;
+    else
+      ndata += 8;
+
+    if (tiling->surface) {
+      status = mb_mallocd(verbose, __FILE__, __LINE__, ndata * sizeof(float), (void **)&sxdata, error);
+      if (status == MB_SUCCESS)
+        status = mb_mallocd(verbose, __FILE__, __LINE__, ndata * sizeof(float), (void **)&sydata, error);
+      if (status == MB_SUCCESS)
+        status = mb_mallocd(verbose, __FILE__, __LINE__, ndata * sizeof(float), (void **)&szdata, error);
+    }
+    else {
+      status = mb_mallocd(verbose, __FILE__, __LINE__, 3 * ndata * sizeof(float), (void **)&sdata, error);
+      if (status == MB_SUCCESS)
+        status = mb_mallocd(verbose, __FILE__, __LINE__, ndata * sizeof(float), (void **)&work1, error);
+      if (status == MB_SUCCESS)
+        status = mb_mallocd(verbose, __FILE__, __LINE__, ndata * sizeof(int), (void **)&work2, error);
+      if (status == MB_SUCCESS)
+        status = mb_mallocd(verbose, __FILE__, __LINE__, (enx + eny) * sizeof(bool), (void **)&work3, error);
+    }
+    if (status == MB_SUCCESS)
+      status = mb_mallocd(verbose, __FILE__, __LINE__, nwindow * sizeof(float), (void **)&sgrid, error);
+    if (status == MB_SUCCESS)
+      status = mb_mallocd(verbose, __FILE__, __LINE__, nwindow * sizeof(bool), (void **)&smask, error);
+    if (status != MB_SUCCESS) {
+      cleanup();
+      return (status);
+    }
+    memset(sgrid, 0, nwindow * sizeof(float));
+    memset(smask, 0, nwindow * sizeof(bool));
+
+    /* get points from the window, then add border points where the
+        window lies along the edge of the full grid */
+    ndata = 0;
+    for (int pass = 0; pass < 2; pass++)
+      for (int i = ex0; i <= ex1; i++)
+        for (int j = ey0; j <= ey1; j++) {
+          const int kwin = (i - ex0) * eny + (j - ey0);
+          double zvalue;
+          if (pass == 0 && grid[kwin] < clipvalue)
+            zvalue = grid[kwin];
+          else if (pass == 1 && grid[kwin] >= clipvalue && tiling->setborder
+                   && (i == 0 || i == gxdim - 1 || j == 0 || j == gydim - 1))
+            zvalue = tiling->border;
+          else
+            continue;
+          if (tiling->surface) {
+            sxdata[ndata] = (float)(par->wbnd[0] + dx * i - tiling->bdata_origin_x);
+            sydata[ndata] = (float)(par->wbnd[2] + dy * j - tiling->bdata_origin_y);
+            szdata[ndata] = (float)zvalue;
+          }
+          else {
+            sdata[3 * ndata] = (float)(par->wbnd[0] + dx * i - tiling->bdata_origin_x);
+            sdata[3 * ndata + 1] = (float)(par->wbnd[2] + dy * j - tiling->bdata_origin_y);
+            sdata[3 * ndata + 2] = (float)zvalue;
+          }
+          ndata++;
+        }
+
+    /* do the interpolation */
+    if (tiling->surface) {
+      mb_surface(verbose, ndata, sxdata, sydata, szdata,
+                 (float)(par->wbnd[0] + dx * ex0 - tiling->bdata_origin_x),
+                 (float)(par->wbnd[0] + dx * ex1 - tiling->bdata_origin_x),
+                 (float)(par->wbnd[2] + dy * ey0 - tiling->bdata_origin_y),
+                 (float)(par->wbnd[2] + dy * ey1 - tiling->bdata_origin_y), dx, dy, tiling->tension, sgrid);
+    }
+    else {
+      float cay = (float)tiling->tension;
+      float xmin = (float)(par->wbnd[0] + dx * ex0 - 0.5 * dx - tiling->bdata_origin_x);
+      float ymin = (float)(par->wbnd[2] + dy * ey0 - 0.5 * dy - tiling->bdata_origin_y);
+      float ddx = (float)dx;
+      float ddy = (float)dy;
+      int clip = tiling->clipmode == MBGRID_INTERP_ALL ? std::max(enx, eny) : tiling->clip;
+      mb_zgrid(sgrid, &enx, &eny, &xmin, &ymin, &ddx, &ddy, sdata, &ndata, work1, work2, work3, &cay, &clip);
+    }
+
+    /* translate the interpolation into the window using the same
+        gap, proximity or fill-all rules as the untiled algorithm */
+    const float zflag = 5.0e34f;
+    const int clip_search = tiling->clip;
+    for (int i = ex0; i <= ex1; i++)
+      for (int j = ey0; j <= ey1; j++) {
+        const int kwin = (i - ex0) * eny + (j - ey0);
+        const int kint = tiling->surface ? (i - ex0) + (eny - (j - ey0) - 1) * enx : (i - ex0) + (j - ey0) * enx;
+        if (grid[kwin] < clipvalue || sgrid[kint] >= zflag)
+          continue;
+        if (i < cx0 || i > cx1 || j < cy0 || j > cy1)
+          continue;
+        if (tiling->clipmode == MBGRID_INTERP_ALL) {
+          smask[kwin] = true;
+          continue;
+        }
+
+        /* loop over rings around point, starting close, testing
+            the cells along the edges of each ring */
+        int dmask[9] = {false, false, false, false, false, false, false, false, false};
+        auto test = [&](int ii, int jj) {
+          if (grid[(ii - ex0) * eny + (jj - ey0)] >= clipvalue)
+            return;
+          if (tiling->clipmode == MBGRID_INTERP_NEAR) {
+            smask[kwin] = true;
+            return;
+          }
+          const double r = sqrt((double)((ii - i) * (ii - i) + (jj - j) * (jj - j)));
+          const int iii = rint((ii - i) / r + 1);
+          const int jjj = rint((jj - j) / r + 1);
+          dmask[iii * 3 + jjj] = true;
+          if ((dmask[0] && dmask[8]) || (dmask[3] && dmask[5]) || (dmask[6] && dmask[2]) || (dmask[1] && dmask[7]))
+            smask[kwin] = true;
+        };
+        for (int ir = 0; ir <= clip_search && !smask[kwin]; ir++) {
+          const int i1 = std::max(ex0, i - ir);
+          const int i2 = std::min(ex1, i + ir);
+          const int j1 = std::max(ey0, j - ir);
+          const int j2 = std::min(ey1, j + ir);
+          for (int ii = i1; ii <= i2 && !smask[kwin]; ii++)
+            test(ii, j1);
+          for (int ii = i1; ii <= i2 && !smask[kwin]; ii++)
+            test(ii, j2);
+          for (int jj = j1; jj <= j2 && !smask[kwin]; jj++)
+            test(i1, jj);
+          for (int jj = j1; jj <= j2 && !smask[kwin]; jj++)
+            test(i2, jj);
+        }
+      }
+    for (int i = cx0; i <= cx1; i++)
+      for (int j = cy0; j <= cy1; j++) {
+        const int kwin = (i - ex0) * eny + (j - ey0);
+        const int kint = tiling->surface ? (i - ex0) + (eny - (j - ey0) - 1) * enx : (i - ex0) + (j - ey0) * enx;
+        if (smask[kwin]) {
+          grid[kwin] = sgrid[kint];
+          tile->nbinspline++;
+        }
+      }
+  }
+
+  /* get the statistics of the tile and write its cells to the output grids */
+  for (int i = cx0; i <= cx1; i++)
+    for (int j = cy0; j <= cy1; j++) {
+      const int kwin = (i - ex0) * eny + (j - ey0);
+      if (grid[kwin] < clipvalue) {
+        if (!tile->zset) {
+          tile->zset = true;
+          tile->zmin = grid[kwin];
+          tile->zmax = grid[kwin];
+        }
+        tile->zmin = std::min(tile->zmin, grid[kwin]);
+        tile->zmax = std::max(tile->zmax, grid[kwin]);
+      }
+      tile->nmax = std::max(tile->nmax, cnt[kwin]);
+      if (cnt[kwin] > 0) {
+        if (!tile->sset) {
+          tile->sset = true;
+          tile->smin = sigma[kwin];
+          tile->smax = sigma[kwin];
+        }
+        tile->smin = std::min(tile->smin, sigma[kwin]);
+        tile->smax = std::max(tile->smax, sigma[kwin]);
+      }
+
+      const int io = i - tiling->offx;
+      const int jo = j - tiling->offy;
+      if (io < 0 || io >= tiling->xdim || jo < 0 || jo >= tiling->ydim)
+        continue;
+      const size_t kout = (size_t)io * tiling->ydim + jo;
+      tiling->zout[kout] = (float)grid[kwin];
+      if (!tiling->ascii && grid[kwin] >= clipvalue)
+        tiling->zout[kout] = tiling->outclipvalue;
+      if (tiling->more) {
+        tiling->nout[kout] = (float)std::max(cnt[kwin], 0);
+        tiling->sout[kout] = (float)std::max(sigma[kwin], 0.0);
+        if (!tiling->ascii && cnt[kwin] <= 0) {
+          tiling->nout[kout] = tiling->outclipvalue;
+          tiling->sout[kout] = tiling->outclipvalue;
+        }
+      }
+    }
+
+  cleanup();
+
+  return (MB_SUCCESS);
+}
+
+/*--------------------------------------------------------------------*/
+/*
+ * function mbgrid_tile_worker is run by each tile processing thread
+ */
+void mbgrid_tile_worker(const struct mbgrid_bin_par_struct *par, struct mbgrid_tiling_struct *tiling, int *status,
+                        int *error) {
+  *status = MB_SUCCESS;
+  *error = MB_ERROR_NO_ERROR;
+  const int ntile = tiling->ntx * tiling->nty;
+  while (*status == MB_SUCCESS) {
+    int itile;
+    {
+      std::lock_guard<std::mutex> lock(tiling->mutex);
+      if (tiling->next >= ntile)
+        return;
+      itile = tiling->next++;
+    }
+    *status = mbgrid_tile_process(par, tiling, itile, error);
+  }
+}
+
+/*--------------------------------------------------------------------*/
+/*
+ * function mbgrid_read_tiled reads all of the datalist entries in a single
+ * pass, spilling the soundings into tiles, and then grids and interpolates
+ * the tiles using n_threads threads
+ */
+int mbgrid_read_tiled(const struct mbgrid_bin_par_struct *par, struct mbgrid_tiling_struct *tiling, int n_threads,
+                      char *filelist, FILE *dfp, int *ndata, int *error) {
+  const int verbose = par->verbose;
+  int status = MB_SUCCESS;
+
+  /* set up the tiles */
+  tiling->ntx = (par->gxdim + tiling->tile_size - 1) / tiling->tile_size;
+  tiling->nty = (par->gydim + tiling->tile_size - 1) / tiling->tile_size;
+  const int ntile = tiling->ntx * tiling->nty;
+  tiling->tiles = nullptr;
+  status = mb_mallocd(verbose, __FILE__, __LINE__, ntile * sizeof(struct mbgrid_tile_struct), (void **)&tiling->tiles,
+                      error);
+  if (status != MB_SUCCESS)
+    return (status);
+  memset(tiling->tiles, 0, ntile * sizeof(struct mbgrid_tile_struct));
+
+  /* open the scratch file - it is already unlinked, so it goes away
+      when it is closed on every path below */
+  const int spillfd = mbgrid_scratch_open(tiling->scratchdir, "spill", error);
+  if (spillfd < 0)
+    return (MB_FAILURE);
+  if ((tiling->spillfp = fdopen(spillfd, "w+")) == nullptr) {
+    close(spillfd);
+    *error = MB_ERROR_OPEN_FAIL;
+    return (MB_FAILURE);
+  }
+  tiling->spillsize = 0;
+  tiling->spill = nullptr;
+
+  /* read the data in a single pass */
+  *ndata = 0;
+  void *datalist = nullptr;
+  const int look_processed = MB_DATALIST_LOOK_UNSET;
+  if (mb_datalist_open(verbose, &datalist, filelist, look_processed, error) != MB_SUCCESS) {
+    fclose(tiling->spillfp);
+    tiling->spillfp = nullptr;
+    *error = MB_ERROR_OPEN_FAIL;
+    fprintf(outfp, "\nUnable to open data list file: %s\n", filelist);
+    return (MB_FAILURE);
+  }
+  struct mbgrid_partial_struct entry;
+  memset(&entry, 0, sizeof(struct mbgrid_partial_struct));
+  char dpath[MB_PATH_MAXLINE] = "";
+  while (status == MB_SUCCESS
+         && mb_datalist_read3(verbose, datalist, &entry.pstatus, entry.path, entry.ppath, &entry.astatus, entry.apath,
+                              dpath, &entry.format, &entry.file_weight, error) == MB_SUCCESS) {
+    if (entry.format < 0 || entry.path[0] == '#')
+      continue;
+
+    int nsndg = 0;
+    double *sndg = nullptr;
+    if (mbgrid_read_soundings(par, par->pjptr, &entry, &nsndg, &sndg) != MB_SUCCESS) {
+      char *message = nullptr;
+      mb_error(verbose, entry.error, &message);
+      if (entry.format > 0) {
+        fprintf(outfp, "\nMBIO Error returned from function <mb_read_init_altnav>:\n%s\n", message);
+        fprintf(outfp, "\nMultibeam File <%s> not initialized for reading\n", entry.file);
+      }
+      else {
+        fprintf(outfp, "\nUnable to open lon,lat,value triples data file1: %s\n", entry.path);
+      }
+      *error = entry.error;
+      status = MB_FAILURE;
+      break;
+    }
+
+    /* spill the soundings that contribute to the grid */
+    const int xtra = (entry.format == 0 && par->grid_mode == MBGRID_WEIGHTED_MEAN) ? par->xtradim : 0;
+    int ndatafile = 0;
+    double dmin = 0.0;
+    double dmax = 0.0;
+    for (int i = 0; i < nsndg && status == MB_SUCCESS; i++) {
+      struct mbgrid_tile_sndg_struct tsndg;
+      tsndg.x = sndg[3 * i];
+      tsndg.y = sndg[3 * i + 1];
+      tsndg.value = sndg[3 * i + 2];
+      tsndg.weight = (float)entry.file_weight;
+      tsndg.xtra = xtra;
+      const int ix = (tsndg.x - par->wbnd[0] + 0.5 * par->dx) / par->dx;
+      const int iy = (tsndg.y - par->wbnd[2] + 0.5 * par->dy) / par->dy;
+      const bool use = par->grid_mode == MBGRID_WEIGHTED_MEAN
+                         ? (ix >= -xtra && ix < par->gxdim + xtra && iy >= -xtra && iy < par->gydim + xtra)
+                         : (ix >= 0 && ix < par->gxdim && iy >= 0 && iy < par->gydim);
+      if (!use)
+        continue;
+      status = mbgrid_tile_add(par, tiling, &tsndg, ix, iy, error);
+      if (ndatafile == 0) {
+        dmin = tsndg.value;
+        dmax = tsndg.value;
+      }
+      else {
+        dmin = std::min(tsndg.value, dmin);
+        dmax = std::max(tsndg.value, dmax);
+      }
+      ndatafile++;
+    }
+    if (sndg != nullptr)
+      mb_freed(verbose, __FILE__, __LINE__, (void **)&sndg, error);
+    *ndata += ndatafile;
+
+    if (verbose >= 2)
+      fprintf(outfp, "\n");
+    if (verbose > 0 || entry.file_in_bounds)
+      fprintf(outfp, "%d data points processed in %s (minmax: %f %f)\n", ndatafile, entry.file, dmin, dmax);
+
+    /* add to datalist if data actually contributed */
+    if (ndatafile > 0 && dfp != nullptr) {
+      if (entry.pstatus == MB_PROCESSED_USE && entry.astatus == MB_ALTNAV_USE)
+        fprintf(dfp, "A:%s %d %f %s\n", entry.path, entry.format, entry.file_weight, entry.apath);
+      else if (entry.pstatus == MB_PROCESSED_USE)
+        fprintf(dfp, "P:%s %d %f\n", entry.path, entry.format, entry.file_weight);
+      else
+        fprintf(dfp, "R:%s %d %f\n", entry.path, entry.format, entry.file_weight);
+      fflush(dfp);
+    }
+  }
+  mb_datalist_close(verbose, &datalist, error);
+  if (status == MB_SUCCESS)
+    *error = MB_ERROR_NO_ERROR;
+
+  /* spill whatever remains buffered and map the scratch file */
+  for (int itile = 0; itile < ntile && status == MB_SUCCESS; itile++) {
+    status = mbgrid_tile_spill(verbose, tiling, &tiling->tiles[itile], error);
+    if (tiling->tiles[itile].buffer != nullptr)
+      mb_freed(verbose, __FILE__, __LINE__, (void **)&tiling->tiles[itile].buffer, error);
+  }
+  if (status == MB_SUCCESS && tiling->spillsize > 0) {
+    if (fflush(tiling->spillfp) == 0) {
+      void *map = mmap(nullptr, tiling->spillsize, PROT_READ, MAP_PRIVATE, fileno(tiling->spillfp), 0);
+      if (map != MAP_FAILED)
+        tiling->spill = (char *)map;
+    }
+    if (tiling->spill == nullptr) {
+      *error = MB_ERROR_MEMORY_FAIL;
+      status = MB_FAILURE;
+    }
+  }
+  fclose(tiling->spillfp);
+  tiling->spillfp = nullptr;
+  if (status != MB_SUCCESS)
+    return (status);
+
+  /* grid and interpolate the tiles */
+  if (verbose >= 1)
+    fprintf(outfp, "\nMaking grid in %d x %d tiles of %d cells with %d cell overlap...\n", tiling->ntx, tiling->nty,
+            tiling->tile_size, tiling->overlap);
+  n_threads = std::max(1, std::min(n_threads, ntile));
+  tiling->next = 0;
+  std::thread *workers = new std::thread[n_threads];
+  int *thread_status = new int[n_threads];
+  int *thread_error = new int[n_threads];
+  for (int ithread = 0; ithread < n_threads; ithread++)
+    workers[ithread] = std::thread(mbgrid_tile_worker, par, tiling, &thread_status[ithread], &thread_error[ithread]);
+  for (int ithread = 0; ithread < n_threads; ithread++) {
+    workers[ithread].join();
+    if (thread_status[ithread] != MB_SUCCESS) {
+      status = thread_status[ithread];
+      *error = thread_error[ithread];
+    }
+  }
+  delete[] workers;
+  delete[] thread_status;
+  delete[] thread_error;
+
+  /* release the scratch file and chunk lists */
+  if (tiling->spill != nullptr)
+    munmap(tiling->spill, tiling->spillsize);
+  tiling->spill = nullptr;
+  for (int itile = 0; itile < ntile; itile++) {
+    if (tiling->tiles[itile].chunks != nullptr)
+      mb_freed(verbose, __FILE__, __LINE__, (void **)&tiling->tiles[itile].chunks, error);
+  }
+
+  return (status);
+}
+
+/*--------------------------------------------------------------------*/
+
+int main(int argc, char **argv) {
+  int verbose = 0;
+  int format;
+  int pings;
+  int lonflip;
+  double bounds[4];
+  int btime_i[7];
+  int etime_i[7];
+  double speedmin;
+  double timegap;
+  int status = mb_defaults(verbose, &format, &pings, &lonflip, bounds, btime_i, etime_i, &speedmin, &timegap);
+
+  grid_data_t datatype = MBGRID_DATA_BATHYMETRY;
+  double border = 0.0;
+  bool setborder = false;
+  char gridkindstring[MB_PATH_MAXLINE] = "";
+  int clip = 0;
+  int xdim = 101;
+  int ydim = 101;
+  char fileroot[MB_PATH_MAXLINE] = "grid";
+  char projection_id[MB_PATH_MAXLINE] = "Geographic";
+  double gbnd[4] = {0.0, 0.0, 0.0, 0.0};
+  bool gbndset = false;
+  double scale = 1.0;
+  double extend = 0.0;
+  double shift_x = 0.0;
+  double shift_y = 0.0;
+  bool shift = false;
+  bool first_in_stays = true;
+  bool check_time = false;
+  double timediff = 300.0;
+  double tension = 0.0;
+  bool set_tension = false;
+  bool use_surface = false;
+
+  double boundsfactor = 0.0;
+  bool bathy_in_feet = false;
+  bool more = false;
+  bool use_NaN = false;
+  int grdrasterid = 0;
+  char projection_pars[MB_PATH_MAXLINE] = "";
+  bool projection_pars_f = false;
+  char filelist[MB_PATH_MAXLINE] = "datalist.mb-1";
+  char backgroundfile[MB_PATH_MAXLINE] = "";
+  grid_type_t gridkind = MBGRID_GMTGRD;
+  double minormax_weighted_mean_threshold = 1.0;
+  grid_alg_t grid_mode = MBGRID_WEIGHTED_MEAN;
+  bool set_spacing = false;
+  char units[MB_PATH_MAXLINE] = "";
+  double dx_set = 0.0;
+  double dy_set = 0.0;
+  bool spacing_priority = false;
+  bool set_dimensions = false;
+  grid_interp_t clipmode = MBGRID_INTERP_NONE;
+  int n_threads = 0;
+  int tile_size = 0;
+  int npercentile = 0;
+  double percentile[MBGRID_PERCENTILE_MAX];
+  int median_cap = MBGRID_MEDIAN_CAP;
+
+  {
+    int option_index;
+    const struct option options[] = {
+        {"threads", required_argument, nullptr, 0},
+        {"tile-size", required_argument, nullptr, 0},
+        {"percentiles", required_argument, nullptr, 0},
+        {"median-cap", required_argument, nullptr, 0},
+        {"surface", no_argument, nullptr, 0},
+        {nullptr, 0, nullptr, 0}};
+
+    bool errflg = false;
+    int c;
+    bool help = false;
+    while ((c = getopt_long(argc, argv, "A:a:B:b:C:c:D:d:E:e:F:f:G:g:HhI:i:J:j:K:k:L:l:MmNnO:o:P:p:QqR:r:S:s:T:t:U:u:VvW:w:X:x:Y:y:",
+                            options, &option_index)) != -1)
+    {
+      switch (c) {
+      /* long options */
+      case 0:
+        if (strcmp("threads", options[option_index].name) == 0) {
+          sscanf(optarg, "%d", &n_threads);
+          n_threads = std::max(n_threads, 1);
+        }
+        else if (strcmp("tile-size", options[option_index].name) == 0) {
+          sscanf(optarg, "%d", &tile_size);
+          tile_size = std::max(tile_size, 0);
+        }
+        else if (strcmp("percentiles", options[option_index].name) == 0) {
+          char *saveptr;
+          npercentile = 0;
+          for (char *token = strtok_r(optarg, "/", &saveptr); token != nullptr && npercentile < MBGRID_PERCENTILE_MAX;
+               token = strtok_r(nullptr, "/", &saveptr)) {
+            if (sscanf(token, "%lf", &percentile[npercentile]) == 1
+                && percentile[npercentile] >= 0.0 && percentile[npercentile] <= 100.0)
+              npercentile++;
+          }
+        }
+        else if (strcmp("median-cap", options[option_index].name) == 0) {
+          sscanf(optarg, "%d", &median_cap);
+          median_cap = std::max(median_cap, 0);
+        }
+        else if (strcmp("surface", options[option_index].name) == 0) {
+          use_surface = true;
+        }
+        break;
+
+      /* short options */
+      case 'A':
+      case 'a':
+      {
+        int tmp;
+        sscanf(optarg, "%d", &tmp);
+        datatype = (grid_data_t)tmp;
+        break;
+      }
+      case 'B':
+      case 'b':
+        sscanf(optarg, "%lf", &border);
+        setborder = true;
+        break;
+      case 'C':
+      case 'c':
+      {
+        const int n = sscanf(optarg, "%d/%d", &clip, (int *)&clipmode);
+        if (n < 1)
+          clipmode = MBGRID_INTERP_NONE;
+        else if (n == 1 && clip > 0)
+          clipmode = MBGRID_INTERP_GAP;
+        else if (n == 1)
+          clipmode = MBGRID_INTERP_NONE;
+        else if (clip > 0 && clipmode < 0)
+          clipmode = MBGRID_INTERP_GAP;
+        else if (clipmode >= 3)
+          clipmode = MBGRID_INTERP_ALL;
+        break;
+      }
+      case 'D':
+      case 'd':
+      {
+        const int n = sscanf(optarg, "%d/%d", &xdim, &ydim);
+        if (n == 2)
+          set_dimensions = true;
+        break;
+      }
+      case 'E':
+      case 'e':
+      {
+        if (optarg[strlen(optarg) - 1] == '!') {
+          spacing_priority = true;
+          optarg[strlen(optarg) - 1] = '\0';
+        }
+        const int n = sscanf(optarg, "%lf/%lf/%1023s", &dx_set, &dy_set, units);
+        if (n > 1)
+          set_spacing = true;
+        if (n < 3)
+          strcpy(units, "meters");
+        break;
+      }
+      case 'F':
+      case 'f':
+      {
+        int tmp;
+        double dvalue;
+        const int n = sscanf(optarg, "%d/%lf", &tmp, &dvalue);
+        grid_mode = (grid_alg_t)tmp;
+        if (n == 2) {
+          if (grid_mode == MBGRID_MINIMUM_FILTER) {
+            minormax_weighted_mean_threshold = dvalue;
+            grid_mode = MBGRID_MINIMUM_WEIGHTED_MEAN;
+          } else if (grid_mode == MBGRID_MAXIMUM_FILTER) {
+            minormax_weighted_mean_threshold = dvalue;
+            grid_mode = MBGRID_MAXIMUM_WEIGHTED_MEAN;
+          } else {
+            minormax_weighted_mean_threshold = dvalue;
+          }
+        }
+        break;
+      }
+      case 'G':
+      case 'g':
+        if (optarg[0] == '=') {
+          gridkind = MBGRID_GMTGRD;
+          strcpy(gridkindstring, optarg);
+        }
+        else {
+          int tmp;
+          int nscan = sscanf(optarg, "%d", &tmp);
+          // Range check
+          if (nscan == 1 && tmp >= 1 && tmp <= 4) {
+            gridkind = (grid_type_t)tmp;
+            if (gridkind == MBGRID_CDFGRD) {
+              gridkind = MBGRID_GMTGRD;
+              gridkindstring[0] = '\0';
+            }
+          } else if (optarg[0] == 'n' || optarg[0] == 'c' || optarg[0] == 'b'
+                    || optarg[0] == 'r' || optarg[0] == 's' || optarg[0] == 'a'
+                    || optarg[0] == 'e' || optarg[0] == 'g'){
+            snprintf(gridkindstring, sizeof(gridkindstring), "=%s", optarg);
+            gridkind = MBGRID_GMTGRD;
+          } else {
+            fprintf(stdout, "Invalid gridkind option: -G%s\n\n", optarg);
+            errflg = true;
+          }
+        }
+        break;
+      case 'H':
+      case 'h':
+        help = true;
+        break;
+      case 'I':
+      case 'i':
+        sscanf(optarg, "%1023s", filelist);
+        break;
+      case 'J':
+      case 'j':
+        sscanf(optarg, "%1023s", projection_pars);
+        projection_pars_f = true;
+        break;
+      case 'K':
+      case 'k':
+        sscanf(optarg, "%1023s", backgroundfile);
+        if ((grdrasterid = (int)strtol(backgroundfile, NULL, 10)) <= 0)
+          grdrasterid = -1;
+        break;
+      case 'L':
+      case 'l':
+        sscanf(optarg, "%d", &lonflip);
+        break;
+      case 'M':
+      case 'm':
+        more = true;
+        break;
+      case 'N':
+      case 'n':
+        use_NaN = true;
+        break;
+      case 'O':
+      case 'o':
+        sscanf(optarg, "%1023s", fileroot);
+        break;
+      case 'P':
+      case 'p':
+        sscanf(optarg, "%d", &pings);
+        break;
+      case 'Q':
+      case 'q':
+        bathy_in_feet = true;
+        break;
+      case 'R':
+      case 'r':
+        if (strchr(optarg, '/') == nullptr) {
+          sscanf(optarg, "%lf", &boundsfactor);
+          if (boundsfactor <= 1.0)
+            boundsfactor = 0.0;
+        }
+        else {
+          mb_get_bounds(optarg, gbnd);
+          gbndset = true;
+        }
+        break;
+      case 'S':
+      case 's':
+        sscanf(optarg, "%lf", &speedmin);
+        break;
+      case 'T':
+      case 't':
+        sscanf(optarg, "%lf", &tension);
+        set_tension = true;
+        break;
+      case 'U':
+      case 'u':
+        sscanf(optarg, "%lf", &timediff);
+        timediff = 60 * timediff;
+        check_time = true;
+        if (timediff < 0.0) {
+          timediff = fabs(timediff);
+          first_in_stays = false;
+        }
+        break;
+      case 'V':
+      case 'v':
+        verbose++;
+        if (verbose >= 2)
+          outfp = stderr;
+        break;
+      case 'W':
+      case 'w':
+        sscanf(optarg, "%lf", &scale);
+        break;
+      case 'X':
+      case 'x':
+        sscanf(optarg, "%lf", &extend);
         break;
       case 'Y':
       case 'y':
@@ -739,6 +2441,7 @@ int main(int argc, char **argv) {
       fprintf(outfp, "dbg2       clipmode:             %d\n", clipmode);
       fprintf(outfp, "dbg2       clip:                 %d\n", clip);
       fprintf(outfp, "dbg2       tension:              %f\n", tension);
+      fprintf(outfp, "dbg2       use_surface:          %d\n", use_surface);
       fprintf(outfp, "dbg2       grdraster background: %d\n", grdrasterid);
       fprintf(outfp, "dbg2       backgroundfile:       %s\n", backgroundfile);
       fprintf(outfp, "dbg2       more:                 %d\n", more);
@@ -762,6 +2465,12 @@ int main(int argc, char **argv) {
       fprintf(outfp, "dbg2       projection_id:        %s\n", projection_id);
       // fprintf(outfp, "dbg2       utm_zone:             %d\n", utm_zone);
       fprintf(outfp, "dbg2       minormax_weighted_mean_threshold: %f\n", minormax_weighted_mean_threshold);
+      fprintf(outfp, "dbg2       n_threads:            %d\n", n_threads);
+      fprintf(outfp, "dbg2       tile_size:            %d\n", tile_size);
+      fprintf(outfp, "dbg2       npercentile:          %d\n", npercentile);
+      for (int i = 0; i < npercentile; i++)
+        fprintf(outfp, "dbg2       percentile[%d]:        %f\n", i, percentile[i]);
+      fprintf(outfp, "dbg2       median_cap:           %d\n", median_cap);
 
     }
 
@@ -775,6 +2484,42 @@ int main(int argc, char **argv) {
   int error = MB_ERROR_NO_ERROR;
   int memclear_error = MB_ERROR_NO_ERROR;
 
+  /* the parallel read-and-bin pipeline is available for the weighted mean,
+      minimum filter and maximum filter algorithms, but not with the -U
+      overlap handling because that depends on the order soundings are binned */
+  if (n_threads > 0
+      && (check_time
+          || (grid_mode != MBGRID_WEIGHTED_MEAN && grid_mode != MBGRID_MINIMUM_FILTER
+              && grid_mode != MBGRID_MAXIMUM_FILTER))) {
+    fprintf(outfp, "\nThe --threads option is not supported for this gridding mode - reading files serially\n");
+    n_threads = 0;
+  }
+
+  /* the out-of-core tiled engine is available for the same algorithms,
+      but not with the -U overlap handling or a -K background */
+  if (tile_size > 0
+      && (check_time || grdrasterid != 0
+          || (grid_mode != MBGRID_WEIGHTED_MEAN && grid_mode != MBGRID_MINIMUM_FILTER
+              && grid_mode != MBGRID_MAXIMUM_FILTER))) {
+    fprintf(outfp, "\nThe --tile-size option is not supported for this gridding mode - gridding in memory\n");
+    tile_size = 0;
+  }
+
+  /* the surface algorithm has its own default tension */
+  if (use_surface && !set_tension)
+    tension = MBGRID_SURFACE_TENSION;
+
+  /* percentile grids are only available from the median filter algorithm */
+  if (npercentile > 0 && grid_mode != MBGRID_MEDIAN_FILTER) {
+    fprintf(outfp, "\nThe --percentiles option requires the median filter algorithm (-F2) - ignored\n");
+    npercentile = 0;
+  }
+
+  /* disable keeping a list of allocated memory because the memory list
+      functionality in mb_mem.c is not thread safe */
+  if (n_threads > 0)
+    mb_mem_list_disable(verbose, &error);
+
   /* if bounds not set get bounds of input data */
   if (!gbndset || (!set_spacing && !set_dimensions)) {
     struct mb_info_struct mb_info;
@@ -865,26 +2610,24 @@ int main(int argc, char **argv) {
   double *firsttime = nullptr;
   double *gridsmall = nullptr;
   double *minormax = nullptr;
-#ifdef USESURFACE
   float *bxdata = nullptr;
   float *bydata = nullptr;
   float *bzdata = nullptr;
   float *sxdata = nullptr;
   float *sydata = nullptr;
   float *szdata = nullptr;
-#else
   float *bdata = nullptr;
   float *sdata = nullptr;
   float *work1 = nullptr;
   int *work2 = nullptr;
   bool *work3 = nullptr;
-#endif
   double bdata_origin_x, bdata_origin_y;
   float *output = nullptr;
   float *sgrid = nullptr;
   int *cnt = nullptr;
   int *num = nullptr;
-  double **data;
+  struct mbgrid_median_struct median;
+  float *pgrid[MBGRID_PERCENTILE_MAX] = {nullptr};
   double *value = nullptr;
   int ndata, ndatafile, nbackground;
   double zmin, zmax, zclip;
@@ -1446,8 +3189,22 @@ int main(int argc, char **argv) {
       fprintf(outfp, "Swath overlap handling:       First data used\n");
     if (check_time)
       fprintf(outfp, "Swath overlap time threshold: %f minutes\n", timediff / 60.);
+    if (n_threads > 0)
+      fprintf(outfp, "Files read and binned in parallel using %d threads\n", n_threads);
+    if (tile_size > 0)
+      fprintf(outfp, "Grid made out of core in tiles of %d x %d cells\n", tile_size, tile_size);
+    if (npercentile > 0) {
+      fprintf(outfp, "Percentile grids:            ");
+      for (int i = 0; i < npercentile; i++)
+        fprintf(outfp, " %g", percentile[i]);
+      fprintf(outfp, "\n");
+    }
+    if (grid_mode == MBGRID_MEDIAN_FILTER && median_cap > 0)
+      fprintf(outfp, "Median values held per bin:   %d\n", median_cap);
     if (clipmode == MBGRID_INTERP_NONE)
       fprintf(outfp, "Spline interpolation not applied\n");
+    else if (use_surface)
+      fprintf(outfp, "Spline interpolation algorithm: GMT surface\n");
     else if (clipmode == MBGRID_INTERP_GAP) {
       fprintf(outfp, "Spline interpolation applied to fill data gaps\n");
       fprintf(outfp, "Spline interpolation clipping dimension: %d\n", clip);
@@ -1507,35 +3264,36 @@ int main(int argc, char **argv) {
     int nbackground_alloc = 2 * gxdim * gydim;
 
 /* allocate and initialize background data arrays */
-#ifdef USESURFACE
-    status = mb_mallocd(verbose, __FILE__, __LINE__, nbackground_alloc * sizeof(float), (void **)&bxdata, &error);
-    if (status == MB_SUCCESS)
-      status = mb_mallocd(verbose, __FILE__, __LINE__, nbackground_alloc * sizeof(float), (void **)&bydata, &error);
-    if (status == MB_SUCCESS)
-      status = mb_mallocd(verbose, __FILE__, __LINE__, nbackground_alloc * sizeof(float), (void **)&bzdata, &error);
-    if (error != MB_ERROR_NO_ERROR) {
-      char *message = nullptr;
-      mb_error(verbose, MB_ERROR_MEMORY_FAIL, &message);
-      fprintf(outfp, "\nMBIO Error allocating background data array:\n%s\n", message);
-      fprintf(outfp, "\nProgram <%s> Terminated\n", program_name);
-      mb_memory_clear(verbose, &memclear_error);
-      exit(MB_ERROR_MEMORY_FAIL);
+    if (use_surface) {
+      status = mb_mallocd(verbose, __FILE__, __LINE__, nbackground_alloc * sizeof(float), (void **)&bxdata, &error);
+      if (status == MB_SUCCESS)
+        status = mb_mallocd(verbose, __FILE__, __LINE__, nbackground_alloc * sizeof(float), (void **)&bydata, &error);
+      if (status == MB_SUCCESS)
+        status = mb_mallocd(verbose, __FILE__, __LINE__, nbackground_alloc * sizeof(float), (void **)&bzdata, &error);
+      if (error != MB_ERROR_NO_ERROR) {
+        char *message = nullptr;
+        mb_error(verbose, MB_ERROR_MEMORY_FAIL, &message);
+        fprintf(outfp, "\nMBIO Error allocating background data array:\n%s\n", message);
+        fprintf(outfp, "\nProgram <%s> Terminated\n", program_name);
+        mb_memory_clear(verbose, &memclear_error);
+        exit(MB_ERROR_MEMORY_FAIL);
+      }
+      memset((char *)bxdata, 0, nbackground_alloc * sizeof(float));
+      memset((char *)bydata, 0, nbackground_alloc * sizeof(float));
+      memset((char *)bzdata, 0, nbackground_alloc * sizeof(float));
     }
-    memset((char *)bxdata, 0, nbackground_alloc * sizeof(float));
-    memset((char *)bydata, 0, nbackground_alloc * sizeof(float));
-    memset((char *)bzdata, 0, nbackground_alloc * sizeof(float));
-#else
-    status = mb_mallocd(verbose, __FILE__, __LINE__, 3 * nbackground_alloc * sizeof(float), (void **)&bdata, &error);
-    if (error != MB_ERROR_NO_ERROR) {
-      char *message = nullptr;
-      mb_error(verbose, MB_ERROR_MEMORY_FAIL, &message);
-      fprintf(outfp, "\nMBIO Error allocating background interpolation work arrays:\n%s\n", message);
-      fprintf(outfp, "\nProgram <%s> Terminated\n", program_name);
-      mb_memory_clear(verbose, &memclear_error);
-      exit(MB_ERROR_MEMORY_FAIL);
+    else {
+      status = mb_mallocd(verbose, __FILE__, __LINE__, 3 * nbackground_alloc * sizeof(float), (void **)&bdata, &error);
+      if (error != MB_ERROR_NO_ERROR) {
+        char *message = nullptr;
+        mb_error(verbose, MB_ERROR_MEMORY_FAIL, &message);
+        fprintf(outfp, "\nMBIO Error allocating background interpolation work arrays:\n%s\n", message);
+        fprintf(outfp, "\nProgram <%s> Terminated\n", program_name);
+        mb_memory_clear(verbose, &memclear_error);
+        exit(MB_ERROR_MEMORY_FAIL);
+      }
+      memset((char *)bdata, 0, 3 * nbackground_alloc * sizeof(float));
     }
-    memset((char *)bdata, 0, 3 * nbackground_alloc * sizeof(float));
-#endif
 
     const int pid = getpid();
 
@@ -1637,49 +3395,50 @@ int main(int argc, char **argv) {
           tlon += 360.0;
         if (use_projection)
           mb_proj_forward(verbose, pjptr, tlon, tlat, &tlon, &tlat, &error);
-#ifdef USESURFACE
-        if (nbackground >= nbackground_alloc) {
-          nbackground_alloc += 10000;
-          status =
-              mb_reallocd(verbose, __FILE__, __LINE__, nbackground_alloc * sizeof(float), (void **)&bxdata, &error);
-          if (status == MB_SUCCESS)
-            status =
-                mb_reallocd(verbose, __FILE__, __LINE__, nbackground_alloc * sizeof(float), (void **)&bydata, &error);
-          if (status == MB_SUCCESS)
+        if (use_surface) {
+          if (nbackground >= nbackground_alloc) {
+            nbackground_alloc += 10000;
             status =
-                mb_reallocd(verbose, __FILE__, __LINE__, nbackground_alloc * sizeof(float), (void **)&bzdata, &error);
-          if (error != MB_ERROR_NO_ERROR) {
-            char *message = nullptr;
-            mb_error(verbose, MB_ERROR_MEMORY_FAIL, &message);
-            fprintf(outfp, "\nMBIO Error reallocating background data array:\n%s\n", message);
-            fprintf(outfp, "\nProgram <%s> Terminated at line %d in source file %s\n", program_name, __LINE__,
-                    __FILE__);
-            mb_memory_clear(verbose, &memclear_error);
-            exit(MB_ERROR_MEMORY_FAIL);
+                mb_reallocd(verbose, __FILE__, __LINE__, nbackground_alloc * sizeof(float), (void **)&bxdata, &error);
+            if (status == MB_SUCCESS)
+              status =
+                  mb_reallocd(verbose, __FILE__, __LINE__, nbackground_alloc * sizeof(float), (void **)&bydata, &error);
+            if (status == MB_SUCCESS)
+              status =
+                  mb_reallocd(verbose, __FILE__, __LINE__, nbackground_alloc * sizeof(float), (void **)&bzdata, &error);
+            if (error != MB_ERROR_NO_ERROR) {
+              char *message = nullptr;
+              mb_error(verbose, MB_ERROR_MEMORY_FAIL, &message);
+              fprintf(outfp, "\nMBIO Error reallocating background data array:\n%s\n", message);
+              fprintf(outfp, "\nProgram <%s> Terminated at line %d in source file %s\n", program_name, __LINE__,
+                      __FILE__);
+              mb_memory_clear(verbose, &memclear_error);
+              exit(MB_ERROR_MEMORY_FAIL);
+            }
           }
+          bxdata[nbackground] = (float)(tlon - bdata_origin_x);
+          bydata[nbackground] = (float)(tlat - bdata_origin_y);
+          bzdata[nbackground] = (float)tvalue;
         }
-        bxdata[nbackground] = (float)(tlon - bdata_origin_x);
-        bydata[nbackground] = (float)(tlat - bdata_origin_y);
-        bzdata[nbackground] = (float)tvalue;
-#else
-        if (nbackground >= nbackground_alloc) {
-          nbackground_alloc += 10000;
-          status =
-              mb_reallocd(verbose, __FILE__, __LINE__, 3 * nbackground_alloc * sizeof(float), (void **)&bdata, &error);
-          if (error != MB_ERROR_NO_ERROR) {
-            char *message = nullptr;
-            mb_error(verbose, MB_ERROR_MEMORY_FAIL, &message);
-            fprintf(outfp, "\nMBIO Error allocating background interpolation work arrays:\n%s\n", message);
-            fprintf(outfp, "\nProgram <%s> Terminated at line %d in source file %s\n", program_name, __LINE__,
-                    __FILE__);
-            mb_memory_clear(verbose, &memclear_error);
-            exit(MB_ERROR_MEMORY_FAIL);
+        else {
+          if (nbackground >= nbackground_alloc) {
+            nbackground_alloc += 10000;
+            status =
+                mb_reallocd(verbose, __FILE__, __LINE__, 3 * nbackground_alloc * sizeof(float), (void **)&bdata, &error);
+            if (error != MB_ERROR_NO_ERROR) {
+              char *message = nullptr;
+              mb_error(verbose, MB_ERROR_MEMORY_FAIL, &message);
+              fprintf(outfp, "\nMBIO Error allocating background interpolation work arrays:\n%s\n", message);
+              fprintf(outfp, "\nProgram <%s> Terminated at line %d in source file %s\n", program_name, __LINE__,
+                      __FILE__);
+              mb_memory_clear(verbose, &memclear_error);
+              exit(MB_ERROR_MEMORY_FAIL);
+            }
           }
+          bdata[nbackground * 3] = (float)(tlon - bdata_origin_x);
+          bdata[nbackground * 3 + 1] = (float)(tlat - bdata_origin_y);
+          bdata[nbackground * 3 + 2] = (float)tvalue;
         }
-        bdata[nbackground * 3] = (float)(tlon - bdata_origin_x);
-        bdata[nbackground * 3 + 1] = (float)(tlat - bdata_origin_y);
-        bdata[nbackground * 3 + 2] = (float)tvalue;
-#endif
         nbackground++;
       }
       pclose(rfp);
@@ -1707,18 +3466,44 @@ int main(int argc, char **argv) {
     }
   }
 
-  /* allocate memory for grid arrays */
-  status = mb_mallocd(verbose, __FILE__, __LINE__, gxdim * gydim * sizeof(double), (void **)&grid, &error);
-  if (status == MB_SUCCESS)
-    status = mb_mallocd(verbose, __FILE__, __LINE__, gxdim * gydim * sizeof(double), (void **)&sigma, &error);
-  if (status == MB_SUCCESS)
-    status = mb_mallocd(verbose, __FILE__, __LINE__, gxdim * gydim * sizeof(double), (void **)&firsttime, &error);
-  if (status == MB_SUCCESS)
-    status = mb_mallocd(verbose, __FILE__, __LINE__, gxdim * gydim * sizeof(int), (void **)&cnt, &error);
-  if (status == MB_SUCCESS)
-    status = mb_mallocd(verbose, __FILE__, __LINE__, gxdim * gydim * sizeof(int), (void **)&num, &error);
-  if (status == MB_SUCCESS)
-    status = mb_mallocd(verbose, __FILE__, __LINE__, xdim * ydim * sizeof(float), (void **)&output, &error);
+  /* allocate memory for grid arrays - when gridding out of core in tiles
+      only the output grids are needed, and these are memory mapped */
+  struct mbgrid_tiling_struct tiling;
+  tiling.tile_size = tile_size;
+  tiling.zout = nullptr;
+  tiling.nout = nullptr;
+  tiling.sout = nullptr;
+  if (tile_size > 0) {
+    /* scratch files go next to the output grid, where there is presumably
+        room for a grid of this size */
+    strcpy(tiling.scratchdir, fileroot);
+    char *slash = strrchr(tiling.scratchdir, '/');
+    if (slash == tiling.scratchdir)
+      slash[1] = '\0';
+    else if (slash != nullptr)
+      *slash = '\0';
+    else
+      strcpy(tiling.scratchdir, ".");
+    const size_t outsize = (size_t)xdim * (size_t)ydim * sizeof(float);
+    status = mbgrid_mmap_alloc(verbose, tiling.scratchdir, "z", outsize, (void **)&tiling.zout, &error);
+    if (status == MB_SUCCESS && more)
+      status = mbgrid_mmap_alloc(verbose, tiling.scratchdir, "num", outsize, (void **)&tiling.nout, &error);
+    if (status == MB_SUCCESS && more)
+      status = mbgrid_mmap_alloc(verbose, tiling.scratchdir, "sd", outsize, (void **)&tiling.sout, &error);
+  }
+  else {
+    status = mb_mallocd(verbose, __FILE__, __LINE__, gxdim * gydim * sizeof(double), (void **)&grid, &error);
+    if (status == MB_SUCCESS)
+      status = mb_mallocd(verbose, __FILE__, __LINE__, gxdim * gydim * sizeof(double), (void **)&sigma, &error);
+    if (status == MB_SUCCESS)
+      status = mb_mallocd(verbose, __FILE__, __LINE__, gxdim * gydim * sizeof(double), (void **)&firsttime, &error);
+    if (status == MB_SUCCESS)
+      status = mb_mallocd(verbose, __FILE__, __LINE__, gxdim * gydim * sizeof(int), (void **)&cnt, &error);
+    if (status == MB_SUCCESS)
+      status = mb_mallocd(verbose, __FILE__, __LINE__, gxdim * gydim * sizeof(int), (void **)&num, &error);
+    if (status == MB_SUCCESS)
+      status = mb_mallocd(verbose, __FILE__, __LINE__, xdim * ydim * sizeof(float), (void **)&output, &error);
+  }
 
   /* if error initializing memory then quit */
   if (error != MB_ERROR_NO_ERROR) {
@@ -1744,8 +3529,111 @@ int main(int argc, char **argv) {
   bool region_ok;
   bool footprint_ok;
 
+  /* parameters shared by the parallel and tiled readers */
+  struct mbgrid_bin_par_struct bin_par;
+  bin_par.verbose = verbose;
+  bin_par.pings = pings;
+  bin_par.lonflip = lonflip;
+  for (int i = 0; i < 4; i++) {
+    bin_par.bounds[i] = bounds[i];
+    bin_par.wbnd[i] = wbnd[i];
+  }
+  for (int i = 0; i < 7; i++) {
+    bin_par.btime_i[i] = btime_i[i];
+    bin_par.etime_i[i] = etime_i[i];
+  }
+  bin_par.speedmin = speedmin;
+  bin_par.timegap = timegap;
+  bin_par.datatype = datatype;
+  bin_par.grid_mode = grid_mode;
+  bin_par.use_projection = use_projection;
+  strcpy(bin_par.projection_id, projection_id);
+  bin_par.pjptr = use_projection ? pjptr : nullptr;
+  bin_par.dx = dx;
+  bin_par.dy = dy;
+  bin_par.gxdim = gxdim;
+  bin_par.gydim = gydim;
+  bin_par.xtradim = xtradim;
+  bin_par.factor = factor;
+  bin_par.topofactor = topofactor;
+
+  /***** do weighted mean or min/max gridding out of core in tiles *****/
+  if (tile_size > 0) {
+    tiling.overlap = (clipmode != MBGRID_INTERP_NONE && clip > 0) ? std::min(clip, tile_size) : 0;
+    tiling.clipmode = clipmode;
+    tiling.clip = clip;
+    tiling.setborder = setborder;
+    tiling.border = border;
+    tiling.surface = use_surface;
+    tiling.tension = tension;
+    tiling.clipvalue = clipvalue;
+    tiling.bdata_origin_x = bdata_origin_x;
+    tiling.bdata_origin_y = bdata_origin_y;
+    tiling.xdim = xdim;
+    tiling.ydim = ydim;
+    tiling.offx = offx;
+    tiling.offy = offy;
+    tiling.more = more;
+    tiling.ascii = gridkind == MBGRID_ASCII || gridkind == MBGRID_ARCASCII;
+    tiling.outclipvalue = outclipvalue;
+    if (mbgrid_read_tiled(&bin_par, &tiling, n_threads, filelist, dfp, &ndata, &error) != MB_SUCCESS) {
+      char *message = nullptr;
+      mb_error(verbose, error, &message);
+      fprintf(outfp, "\nMBIO Error making tiled grid:\n%s\n", message);
+      fprintf(outfp, "\nProgram <%s> Terminated\n", program_name);
+      mb_memory_clear(verbose, &memclear_error);
+      exit(error);
+    }
+    fprintf(outfp, "\n%d total data points processed\n", ndata);
+
+    /* close datalist if necessary */
+    if (dfp != nullptr) {
+      fclose(dfp);
+      dfp = nullptr;
+    }
+
+    /* reduce the tile statistics in tile order */
+    const int ntile = tiling.ntx * tiling.nty;
+    bool zset = false;
+    bool sset = false;
+    nbinset = 0;
+    nbinspline = 0;
+    nbinbackground = 0;
+    nmax = 0;
+    zmin = 0.0;
+    zmax = 0.0;
+    smin = 0.0;
+    smax = 0.0;
+    for (int itile = 0; itile < ntile; itile++) {
+      const struct mbgrid_tile_struct *tile = &tiling.tiles[itile];
+      nbinset += tile->nbinset;
+      nbinspline += tile->nbinspline;
+      nmax = std::max(nmax, tile->nmax);
+      if (tile->zset) {
+        zmin = zset ? std::min(zmin, tile->zmin) : tile->zmin;
+        zmax = zset ? std::max(zmax, tile->zmax) : tile->zmax;
+        zset = true;
+      }
+      if (tile->sset) {
+        smin = sset ? std::min(smin, tile->smin) : tile->smin;
+        smax = sset ? std::max(smax, tile->smax) : tile->smax;
+        sset = true;
+      }
+    }
+    mb_freed(verbose, __FILE__, __LINE__, (void **)&tiling.tiles, &error);
+    if (clipmode == MBGRID_INTERP_GAP)
+      fprintf(outfp, "Applied spline interpolation to fill gaps of %d cells or less\n", clip);
+    else if (clipmode == MBGRID_INTERP_NEAR)
+      fprintf(outfp, "Applied spline interpolation to fill %d cells from data\n", clip);
+    else if (clipmode == MBGRID_INTERP_ALL)
+      fprintf(outfp, "Applied spline interpolation to fill all undefined cells in the tiles\n");
+
+    /***** end of tiled gridding *****/
+  }
+/* -------------------------------------------------------------------------- */
+
   /***** do weighted footprint slope gridding *****/
-  if (grid_mode == MBGRID_WEIGHTED_FOOTPRINT_SLOPE) {
+  else if (grid_mode == MBGRID_WEIGHTED_FOOTPRINT_SLOPE) {
     /* set up parameters for first cut low resolution slope grid */
     // sbnd[4]; for (int i = 0; i < 4; i++) sbnd[i] = wbnd[i];
     const double sdx = 2.0 * dx;
@@ -1982,120 +3870,118 @@ int main(int argc, char **argv) {
       }
 
 /* now fill in the low resolution grid with interpolation */
-#ifdef USESURFACE
-    /* allocate and initialize sgrid */
-    status = mb_mallocd(verbose, __FILE__, __LINE__, ndata * sizeof(float), (void **)&sxdata, &error);
-    if (status == MB_SUCCESS)
-      status = mb_mallocd(verbose, __FILE__, __LINE__, ndata * sizeof(float), (void **)&sydata, &error);
-    if (status == MB_SUCCESS)
-      status = mb_mallocd(verbose, __FILE__, __LINE__, ndata * sizeof(float), (void **)&szdata, &error);
-    if (status == MB_SUCCESS)
-      status = mb_mallocd(verbose, __FILE__, __LINE__, sxdim * sydim * sizeof(float), (void **)&sgrid, &error);
-    if (error != MB_ERROR_NO_ERROR) {
-      char *message = nullptr;
-      mb_error(verbose, MB_ERROR_MEMORY_FAIL, &message);
-      fprintf(outfp, "\nMBIO Error allocating interpolation work arrays:\n%s\n", message);
-      fprintf(outfp, "\nProgram <%s> Terminated\n", program_name);
-      mb_memory_clear(verbose, &memclear_error);
-      exit(error);
-    }
-    memset((char *)sgrid, 0, sxdim * sydim * sizeof(float));
-    memset((char *)sxdata, 0, ndata * sizeof(float));
-    memset((char *)sydata, 0, ndata * sizeof(float));
-    memset((char *)szdata, 0, ndata * sizeof(float));
-
-    /* get points from grid */
-    /* simultaneously find the depth values nearest to the grid corners and edge midpoints */
-    ndata = 0;
-    for (int i = 0; i < sxdim; i++)
-      for (int j = 0; j < sydim; j++) {
-        kgrid = i * sydim + j;
-        if (cnt[kgrid] > 0) {
-          sxdata[ndata] = (float)(wbnd[0] + sdx * i - bdata_origin_x);
-          sydata[ndata] = (float)(wbnd[2] + sdy * j - bdata_origin_y);
-          szdata[ndata] = (float)gridsmall[kgrid];
-          ndata++;
-        }
+    if (use_surface) {
+      /* allocate and initialize sgrid */
+      status = mb_mallocd(verbose, __FILE__, __LINE__, ndata * sizeof(float), (void **)&sxdata, &error);
+      if (status == MB_SUCCESS)
+        status = mb_mallocd(verbose, __FILE__, __LINE__, ndata * sizeof(float), (void **)&sydata, &error);
+      if (status == MB_SUCCESS)
+        status = mb_mallocd(verbose, __FILE__, __LINE__, ndata * sizeof(float), (void **)&szdata, &error);
+      if (status == MB_SUCCESS)
+        status = mb_mallocd(verbose, __FILE__, __LINE__, sxdim * sydim * sizeof(float), (void **)&sgrid, &error);
+      if (error != MB_ERROR_NO_ERROR) {
+        char *message = nullptr;
+        mb_error(verbose, MB_ERROR_MEMORY_FAIL, &message);
+        fprintf(outfp, "\nMBIO Error allocating interpolation work arrays:\n%s\n", message);
+        fprintf(outfp, "\nProgram <%s> Terminated\n", program_name);
+        mb_memory_clear(verbose, &memclear_error);
+        exit(error);
       }
+      memset((char *)sgrid, 0, sxdim * sydim * sizeof(float));
+      memset((char *)sxdata, 0, ndata * sizeof(float));
+      memset((char *)sydata, 0, ndata * sizeof(float));
+      memset((char *)szdata, 0, ndata * sizeof(float));
+
+      /* get points from grid */
+      /* simultaneously find the depth values nearest to the grid corners and edge midpoints */
+      ndata = 0;
+      for (int i = 0; i < sxdim; i++)
+        for (int j = 0; j < sydim; j++) {
+          kgrid = i * sydim + j;
+          if (cnt[kgrid] > 0) {
+            sxdata[ndata] = (float)(wbnd[0] + sdx * i - bdata_origin_x);
+            sydata[ndata] = (float)(wbnd[2] + sdy * j - bdata_origin_y);
+            szdata[ndata] = (float)gridsmall[kgrid];
+            ndata++;
+          }
+        }
 
-    /* do the interpolation */
-    fprintf(outfp, "\nDoing Surface spline interpolation with %d data points...\n", ndata);
-    mb_surface(verbose, ndata, sxdata, sydata, szdata, (wbnd[0] - bdata_origin_x), (wbnd[1] - bdata_origin_x),
-               (wbnd[2] - bdata_origin_y), (wbnd[3] - bdata_origin_y), sdx, sdy, tension, sgrid);
-#else
-    /* allocate and initialize sgrid */
-    status = mb_mallocd(verbose, __FILE__, __LINE__, 3 * ndata * sizeof(float), (void **)&sdata, &error);
-    if (status == MB_SUCCESS)
-      status = mb_mallocd(verbose, __FILE__, __LINE__, sxdim * sydim * sizeof(float), (void **)&sgrid, &error);
-    if (status == MB_SUCCESS)
-      status = mb_mallocd(verbose, __FILE__, __LINE__, ndata * sizeof(float), (void **)&work1, &error);
-    if (status == MB_SUCCESS)
-      status = mb_mallocd(verbose, __FILE__, __LINE__, ndata * sizeof(int), (void **)&work2, &error);
-    if (status == MB_SUCCESS)
-      status = mb_mallocd(verbose, __FILE__, __LINE__, (sxdim + sydim) * sizeof(bool), (void **)&work3, &error);
-    if (error != MB_ERROR_NO_ERROR) {
-      char *message = nullptr;
-      mb_error(verbose, MB_ERROR_MEMORY_FAIL, &message);
-      fprintf(outfp, "\nMBIO Error allocating interpolation work arrays:\n%s\n", message);
-      fprintf(outfp, "\nProgram <%s> Terminated\n", program_name);
-      mb_memory_clear(verbose, &memclear_error);
-      exit(error);
+      /* do the interpolation */
+      fprintf(outfp, "\nDoing Surface spline interpolation with %d data points...\n", ndata);
+      mb_surface(verbose, ndata, sxdata, sydata, szdata, (wbnd[0] - bdata_origin_x), (wbnd[1] - bdata_origin_x),
+                 (wbnd[2] - bdata_origin_y), (wbnd[3] - bdata_origin_y), sdx, sdy, tension, sgrid);
     }
-    memset((char *)sgrid, 0, sxdim * sydim * sizeof(float));
-    memset((char *)sdata, 0, 3 * ndata * sizeof(float));
-    memset((char *)work1, 0, ndata * sizeof(float));
-    memset((char *)work2, 0, ndata * sizeof(int));
-    memset((char *)work3, 0, (sxdim + sydim) * sizeof(bool));
-
-    /* get points from grid */
-    /* simultaneously find the depth values nearest to the grid corners and edge midpoints */
-    ndata = 0;
-    for (int i = 0; i < sxdim; i++)
-      for (int j = 0; j < sydim; j++) {
-        kgrid = i * sydim + j;
-        if (cnt[kgrid] > 0) {
-          sdata[ndata++] = (float)(wbnd[0] + sdx * i - bdata_origin_x);
-          sdata[ndata++] = (float)(wbnd[2] + sdy * j - bdata_origin_y);
-          sdata[ndata++] = (float)gridsmall[kgrid];
-        }
+    else {
+      /* allocate and initialize sgrid */
+      status = mb_mallocd(verbose, __FILE__, __LINE__, 3 * ndata * sizeof(float), (void **)&sdata, &error);
+      if (status == MB_SUCCESS)
+        status = mb_mallocd(verbose, __FILE__, __LINE__, sxdim * sydim * sizeof(float), (void **)&sgrid, &error);
+      if (status == MB_SUCCESS)
+        status = mb_mallocd(verbose, __FILE__, __LINE__, ndata * sizeof(float), (void **)&work1, &error);
+      if (status == MB_SUCCESS)
+        status = mb_mallocd(verbose, __FILE__, __LINE__, ndata * sizeof(int), (void **)&work2, &error);
+      if (status == MB_SUCCESS)
+        status = mb_mallocd(verbose, __FILE__, __LINE__, (sxdim + sydim) * sizeof(bool), (void **)&work3, &error);
+      if (error != MB_ERROR_NO_ERROR) {
+        char *message = nullptr;
+        mb_error(verbose, MB_ERROR_MEMORY_FAIL, &message);
+        fprintf(outfp, "\nMBIO Error allocating interpolation work arrays:\n%s\n", message);
+        fprintf(outfp, "\nProgram <%s> Terminated\n", program_name);
+        mb_memory_clear(verbose, &memclear_error);
+        exit(error);
       }
-    ndata = ndata / 3;
-
-    /* do the interpolation */
-    float cay = (float)tension;
-    float xmin = (float)(wbnd[0] - 0.5 * sdx - bdata_origin_x);
-    float ymin = (float)(wbnd[2] - 0.5 * sdy - bdata_origin_y);
-    float ddx = (float)sdx;
-    float ddy = (float)sdy;
-    fprintf(outfp, "\nDoing Zgrid spline interpolation with %d data points...\n", ndata);
-    mb_zgrid2(sgrid, &sxdim, &sydim, &xmin, &ymin, &ddx, &ddy, sdata, &ndata, work1, work2, work3, &cay, &sclip);
-#endif
+      memset((char *)sgrid, 0, sxdim * sydim * sizeof(float));
+      memset((char *)sdata, 0, 3 * ndata * sizeof(float));
+      memset((char *)work1, 0, ndata * sizeof(float));
+      memset((char *)work2, 0, ndata * sizeof(int));
+      memset((char *)work3, 0, (sxdim + sydim) * sizeof(bool));
+
+      /* get points from grid */
+      /* simultaneously find the depth values nearest to the grid corners and edge midpoints */
+      ndata = 0;
+      for (int i = 0; i < sxdim; i++)
+        for (int j = 0; j < sydim; j++) {
+          kgrid = i * sydim + j;
+          if (cnt[kgrid] > 0) {
+            sdata[ndata++] = (float)(wbnd[0] + sdx * i - bdata_origin_x);
+            sdata[ndata++] = (float)(wbnd[2] + sdy * j - bdata_origin_y);
+            sdata[ndata++] = (float)gridsmall[kgrid];
+          }
+        }
+      ndata = ndata / 3;
+
+      /* do the interpolation */
+      float cay = (float)tension;
+      float xmin = (float)(wbnd[0] - 0.5 * sdx - bdata_origin_x);
+      float ymin = (float)(wbnd[2] - 0.5 * sdy - bdata_origin_y);
+      float ddx = (float)sdx;
+      float ddy = (float)sdy;
+      fprintf(outfp, "\nDoing Zgrid spline interpolation with %d data points...\n", ndata);
+      mb_zgrid2(sgrid, &sxdim, &sydim, &xmin, &ymin, &ddx, &ddy, sdata, &ndata, work1, work2, work3, &cay, &sclip);
+    }
 
     // float zflag = 5.0e34f;
     for (int i = 0; i < sxdim; i++)
       for (int j = 0; j < sydim; j++) {
         kgrid = i * sydim + j;
-#ifdef USESURFACE
-        kint = i + (sydim - j - 1) * sxdim;
-#else
-        kint = i + j * sxdim;
-#endif
+        kint = use_surface ? i + (sydim - j - 1) * sxdim : i + j * sxdim;
         if (cnt[kgrid] == 0) {
           gridsmall[kgrid] = sgrid[kint];
         }
       }
 
 /* deallocate the interpolation arrays */
-#ifdef USESURFACE
-    mb_freed(verbose, __FILE__, __LINE__, (void **)&sxdata, &error);
-    mb_freed(verbose, __FILE__, __LINE__, (void **)&sydata, &error);
-    mb_freed(verbose, __FILE__, __LINE__, (void **)&szdata, &error);
-#else
-    mb_freed(verbose, __FILE__, __LINE__, (void **)&sdata, &error);
-    mb_freed(verbose, __FILE__, __LINE__, (void **)&work1, &error);
-    mb_freed(verbose, __FILE__, __LINE__, (void **)&work2, &error);
-    mb_freed(verbose, __FILE__, __LINE__, (void **)&work3, &error);
-#endif
+    if (use_surface) {
+      mb_freed(verbose, __FILE__, __LINE__, (void **)&sxdata, &error);
+      mb_freed(verbose, __FILE__, __LINE__, (void **)&sydata, &error);
+      mb_freed(verbose, __FILE__, __LINE__, (void **)&szdata, &error);
+    }
+    else {
+      mb_freed(verbose, __FILE__, __LINE__, (void **)&sdata, &error);
+      mb_freed(verbose, __FILE__, __LINE__, (void **)&work1, &error);
+      mb_freed(verbose, __FILE__, __LINE__, (void **)&work2, &error);
+      mb_freed(verbose, __FILE__, __LINE__, (void **)&work3, &error);
+    }
     mb_freed(verbose, __FILE__, __LINE__, (void **)&sgrid, &error);
 
     /* do second pass footprint gridding using slope estimates from first pass interpolated grid */
@@ -2985,7 +4871,9 @@ int main(int argc, char **argv) {
   else if (grid_mode == MBGRID_MEDIAN_FILTER) {
 
     /* allocate memory for additional arrays */
-    status = mb_mallocd(verbose, __FILE__, __LINE__, gxdim * gydim * sizeof(double *), (void **)&data, &error);
+    status = mbgrid_median_init(verbose, &median, gxdim * gydim, median_cap, &error);
+    for (int ip = 0; ip < npercentile && status == MB_SUCCESS; ip++)
+      status = mb_mallocd(verbose, __FILE__, __LINE__, gxdim * gydim * sizeof(float), (void **)&pgrid[ip], &error);
 
     /* if error initializing memory then quit */
     if (error != MB_ERROR_NO_ERROR) {
@@ -3006,7 +4894,6 @@ int main(int argc, char **argv) {
         firsttime[kgrid] = 0.0;
         cnt[kgrid] = 0;
         num[kgrid] = 0;
-        data[kgrid] = nullptr;
       }
 
     /* read in data */
@@ -3163,29 +5050,24 @@ int main(int argc, char **argv) {
                         time_ok = true;
                     }
 
-                    /* make sure there is space for the data */
-                    if (time_ok && cnt[kgrid] >= num[kgrid]) {
-                      num[kgrid] += REALLOC_STEP_SIZE;
-                      if ((data[kgrid] = (double *)realloc(data[kgrid], num[kgrid] * sizeof(double))) ==
-                          nullptr) {
-                        error = MB_ERROR_MEMORY_FAIL;
-                        char *message = nullptr;
-                        mb_error(verbose, error, &message);
-                        fprintf(outfp, "\nMBIO Error allocating data arrays:\n%s\n", message);
-                        fprintf(outfp, "The weighted mean algorithm uses much less\n");
-                        fprintf(outfp, "memory than the median filter algorithm.\n");
-                        fprintf(outfp, "You could also try using ping averaging to\n");
-                        fprintf(outfp, "reduce the number of data points to be gridded.\n");
-                        fprintf(outfp, "\nProgram <%s> Terminated\n", program_name);
-                        mb_memory_clear(verbose, &memclear_error);
-                        exit(error);
-                      }
+                    /* store the data in the value pool */
+                    if (time_ok && mbgrid_median_add(verbose, &median, kgrid, cnt[kgrid], topofactor * bath[ib],
+                                                     &error) != MB_SUCCESS) {
+                      error = MB_ERROR_MEMORY_FAIL;
+                      char *message = nullptr;
+                      mb_error(verbose, error, &message);
+                      fprintf(outfp, "\nMBIO Error allocating data arrays:\n%s\n", message);
+                      fprintf(outfp, "The weighted mean algorithm uses much less\n");
+                      fprintf(outfp, "memory than the median filter algorithm.\n");
+                      fprintf(outfp, "You could also try using ping averaging to\n");
+                      fprintf(outfp, "reduce the number of data points to be gridded.\n");
+                      fprintf(outfp, "\nProgram <%s> Terminated\n", program_name);
+                      mb_memory_clear(verbose, &memclear_error);
+                      exit(error);
                     }
 
                     /* process it */
                     if (time_ok) {
-                      value = data[kgrid];
-                      value[cnt[kgrid]] = topofactor * bath[ib];
                       cnt[kgrid]++;
                       ndata++;
                       ndatafile++;
@@ -3241,29 +5123,24 @@ int main(int argc, char **argv) {
                         time_ok = true;
                     }
 
-                    /* make sure there is space for the data */
-                    if (time_ok && cnt[kgrid] >= num[kgrid]) {
-                      num[kgrid] += REALLOC_STEP_SIZE;
-                      if ((data[kgrid] = (double *)realloc(data[kgrid], num[kgrid] * sizeof(double))) ==
-                          nullptr) {
-                        error = MB_ERROR_MEMORY_FAIL;
-                        char *message = nullptr;
-                        mb_error(verbose, error, &message);
-                        fprintf(outfp, "\nMBIO Error allocating data arrays:\n%s\n", message);
-                        fprintf(outfp, "The weighted mean algorithm uses much less\n");
-                        fprintf(outfp, "memory than the median filter algorithm.\n");
-                        fprintf(outfp, "You could also try using ping averaging to\n");
-                        fprintf(outfp, "reduce the number of data points to be gridded.\n");
-                        fprintf(outfp, "\nProgram <%s> Terminated\n", program_name);
-                        mb_memory_clear(verbose, &memclear_error);
-                        exit(error);
-                      }
+                    /* store the data in the value pool */
+                    if (time_ok && mbgrid_median_add(verbose, &median, kgrid, cnt[kgrid], amp[ib],
+                                                     &error) != MB_SUCCESS) {
+                      error = MB_ERROR_MEMORY_FAIL;
+                      char *message = nullptr;
+                      mb_error(verbose, error, &message);
+                      fprintf(outfp, "\nMBIO Error allocating data arrays:\n%s\n", message);
+                      fprintf(outfp, "The weighted mean algorithm uses much less\n");
+                      fprintf(outfp, "memory than the median filter algorithm.\n");
+                      fprintf(outfp, "You could also try using ping averaging to\n");
+                      fprintf(outfp, "reduce the number of data points to be gridded.\n");
+                      fprintf(outfp, "\nProgram <%s> Terminated\n", program_name);
+                      mb_memory_clear(verbose, &memclear_error);
+                      exit(error);
                     }
 
                     /* process it */
                     if (time_ok) {
-                      value = data[kgrid];
-                      value[cnt[kgrid]] = amp[ib];
                       cnt[kgrid]++;
                       ndata++;
                       ndatafile++;
@@ -3318,29 +5195,24 @@ int main(int argc, char **argv) {
                         time_ok = true;
                     }
 
-                    /* make sure there is space for the data */
-                    if (time_ok && cnt[kgrid] >= num[kgrid]) {
-                      num[kgrid] += REALLOC_STEP_SIZE;
-                      if ((data[kgrid] = (double *)realloc(data[kgrid], num[kgrid] * sizeof(double))) ==
-                          nullptr) {
-                        error = MB_ERROR_MEMORY_FAIL;
-                        char *message = nullptr;
-                        mb_error(verbose, error, &message);
-                        fprintf(outfp, "\nMBIO Error allocating data arrays:\n%s\n", message);
-                        fprintf(outfp, "The weighted mean algorithm uses much less\n");
-                        fprintf(outfp, "memory than the median filter algorithm.\n");
-                        fprintf(outfp, "You could also try using ping averaging to\n");
-                        fprintf(outfp, "reduce the number of data points to be gridded.\n");
-                        fprintf(outfp, "\nProgram <%s> Terminated\n", program_name);
-                        mb_memory_clear(verbose, &memclear_error);
-                        exit(error);
-                      }
+                    /* store the data in the value pool */
+                    if (time_ok && mbgrid_median_add(verbose, &median, kgrid, cnt[kgrid], ss[ib],
+                                                     &error) != MB_SUCCESS) {
+                      error = MB_ERROR_MEMORY_FAIL;
+                      char *message = nullptr;
+                      mb_error(verbose, error, &message);
+                      fprintf(outfp, "\nMBIO Error allocating data arrays:\n%s\n", message);
+                      fprintf(outfp, "The weighted mean algorithm uses much less\n");
+                      fprintf(outfp, "memory than the median filter algorithm.\n");
+                      fprintf(outfp, "You could also try using ping averaging to\n");
+                      fprintf(outfp, "reduce the number of data points to be gridded.\n");
+                      fprintf(outfp, "\nProgram <%s> Terminated\n", program_name);
+                      mb_memory_clear(verbose, &memclear_error);
+                      exit(error);
                     }
 
                     /* process it */
                     if (time_ok) {
-                      value = data[kgrid];
-                      value[cnt[kgrid]] = ss[ib];
                       cnt[kgrid]++;
                       ndata++;
                       ndatafile++;
@@ -3414,28 +5286,24 @@ int main(int argc, char **argv) {
                 time_ok = true;
             }
 
-            /* make sure there is space for the data */
-            if (time_ok && cnt[kgrid] >= num[kgrid]) {
-              num[kgrid] += REALLOC_STEP_SIZE;
-              if ((data[kgrid] = (double *)realloc(data[kgrid], num[kgrid] * sizeof(double))) == nullptr) {
-                error = MB_ERROR_MEMORY_FAIL;
-                char *message = nullptr;
-                mb_error(verbose, error, &message);
-                fprintf(outfp, "\nMBIO Error allocating data arrays:\n%s\n", message);
-                fprintf(outfp, "The weighted mean algorithm uses much less\n");
-                fprintf(outfp, "memory than the median filter algorithm.\n");
-                fprintf(outfp, "You could also try using ping averaging to\n");
-                fprintf(outfp, "reduce the number of data points to be gridded.\n");
-                fprintf(outfp, "\nProgram <%s> Terminated\n", program_name);
-                mb_memory_clear(verbose, &memclear_error);
-                exit(error);
-              }
+            /* store the data in the value pool */
+            if (time_ok && mbgrid_median_add(verbose, &median, kgrid, cnt[kgrid], topofactor * tvalue,
+                                             &error) != MB_SUCCESS) {
+              error = MB_ERROR_MEMORY_FAIL;
+              char *message = nullptr;
+              mb_error(verbose, error, &message);
+              fprintf(outfp, "\nMBIO Error allocating data arrays:\n%s\n", message);
+              fprintf(outfp, "The weighted mean algorithm uses much less\n");
+              fprintf(outfp, "memory than the median filter algorithm.\n");
+              fprintf(outfp, "You could also try using ping averaging to\n");
+              fprintf(outfp, "reduce the number of data points to be gridded.\n");
+              fprintf(outfp, "\nProgram <%s> Terminated\n", program_name);
+              mb_memory_clear(verbose, &memclear_error);
+              exit(error);
             }
 
             /* process it */
             if (time_ok) {
-              value = data[kgrid];
-              value[cnt[kgrid]] = topofactor * tvalue;
               cnt[kgrid]++;
               ndata++;
               ndatafile++;
@@ -3491,29 +5359,40 @@ int main(int argc, char **argv) {
       for (int j = 0; j < gydim; j++) {
         kgrid = i * gydim + j;
         if (cnt[kgrid] > 0) {
-          value = data[kgrid];
-          qsort((char *)value, cnt[kgrid], sizeof(double), mb_double_compare);
-          grid[kgrid] = value[cnt[kgrid] / 2];
+          int nvalue;
+          value = mbgrid_median_gather(verbose, &median, kgrid, cnt[kgrid], &nvalue, &error);
+          if (value == nullptr) {
+            char *message = nullptr;
+            mb_error(verbose, error, &message);
+            fprintf(outfp, "\nMBIO Error allocating data arrays:\n%s\n", message);
+            fprintf(outfp, "\nProgram <%s> Terminated\n", program_name);
+            mb_memory_clear(verbose, &memclear_error);
+            exit(error);
+          }
+          for (int ip = 0; ip < npercentile; ip++)
+            pgrid[ip][kgrid] = (float)mbgrid_median_select(value, nvalue, percentile[ip]);
+          grid[kgrid] = mbgrid_median_select(value, nvalue, 50.0);
           sigma[kgrid] = 0.0;
-          for (int k = 0; k < cnt[kgrid]; k++)
+          for (int k = 0; k < nvalue; k++)
             sigma[kgrid] += (value[k] - grid[kgrid]) * (value[k] - grid[kgrid]);
-          if (cnt[kgrid] > 1)
-            sigma[kgrid] = sqrt(sigma[kgrid] / (cnt[kgrid] - 1));
+          if (nvalue > 1)
+            sigma[kgrid] = sqrt(sigma[kgrid] / (nvalue - 1));
           else
             sigma[kgrid] = 0.0;
           nbinset++;
         }
-        else
+        else {
           grid[kgrid] = clipvalue;
+          for (int ip = 0; ip < npercentile; ip++)
+            pgrid[ip][kgrid] = (float)clipvalue;
+        }
       }
 
+    if (verbose >= 1 && median.nsampled > 0)
+      fprintf(outfp, "%d bins exceeded %d values and were estimated from a sample\n", median.nsampled, median_cap);
+
     /* now deallocate space for the data */
-    for (int i = 0; i < gxdim; i++)
-      for (int j = 0; j < gydim; j++) {
-        kgrid = i * gydim + j;
-        if (cnt[kgrid] > 0)
-          free(data[kgrid]);
-      }
+    mbgrid_median_free(verbose, &median);
 
     /***** end of median filter gridding *****/
   }
@@ -3552,551 +5431,562 @@ int main(int argc, char **argv) {
 
     /* read in data */
     ndata = 0;
-    const int look_processed = MB_DATALIST_LOOK_UNSET;
-    if (mb_datalist_open(verbose, &datalist, filelist, look_processed, &error) != MB_SUCCESS) {
-      error = MB_ERROR_OPEN_FAIL;
-      fprintf(outfp, "\nUnable to open data list file: %s\n", filelist);
-      fprintf(outfp, "\nProgram <%s> Terminated\n", program_name);
-      mb_memory_clear(verbose, &memclear_error);
-      exit(error);
+    if (n_threads > 0) {
+      /* read and bin the files in parallel */
+      if (mbgrid_read_parallel(&bin_par, n_threads, filelist, dfp, grid, norm, sigma, num, cnt, &ndata, &error)
+            != MB_SUCCESS) {
+        fprintf(outfp, "\nProgram <%s> Terminated\n", program_name);
+        mb_memory_clear(verbose, &memclear_error);
+        exit(error);
+      }
     }
-    while (mb_datalist_read3(verbose, datalist, &pstatus, path, ppath, &astatus, apath, dpath, &format, &file_weight, &error) ==
-           MB_SUCCESS) {
-      ndatafile = 0;
-
-      /* if format > 0 then input is swath sonar file */
-      if (format > 0 && path[0] != '#') {
-        /* apply pstatus */
-        if (pstatus == MB_PROCESSED_USE)
-          strcpy(file, ppath);
-        else
-          strcpy(file, path);
-
-        /* check for mbinfo file - get file bounds if possible */
-        rformat = format;
-        strcpy(rfile, file);
-        status = mb_check_info(verbose, rfile, lonflip, bounds, &file_in_bounds, &error);
-        if (status == MB_FAILURE) {
-          file_in_bounds = true;
-          status = MB_SUCCESS;
-          error = MB_ERROR_NO_ERROR;
-        }
-
-        /* initialize the swath sonar file */
-        bool first = true;
-        double dmin = 0.0;
-        double dmax = 0.0;
-        if (file_in_bounds) {
-          /* check for "fast bathymetry" or "fbt" file */
-          if (datatype == MBGRID_DATA_TOPOGRAPHY || datatype == MBGRID_DATA_BATHYMETRY) {
-            mb_get_fbt(verbose, rfile, &rformat, &error);
-          }
-
-          /* call mb_read_init_altnav() */
-          if (mb_read_init_altnav(verbose, rfile, rformat, pings, lonflip, bounds, btime_i, etime_i, speedmin,
-                                     timegap, astatus, apath, &mbio_ptr, &btime_d, &etime_d, 
-                                     &beams_bath, &beams_amp, &pixels_ss,
-                                     &error) != MB_SUCCESS) {
-            char *message = nullptr;
-            mb_error(verbose, error, &message);
-            fprintf(outfp, "\nMBIO Error returned from function <mb_read_init_altnav>:\n%s\n", message);
-            fprintf(outfp, "\nMultibeam File <%s> not initialized for reading\n", rfile);
-            fprintf(outfp, "\nProgram <%s> Terminated\n", program_name);
-            mb_memory_clear(verbose, &memclear_error);
-            exit(error);
-          }
-
-          /* allocate memory for reading data arrays */
-          if (error == MB_ERROR_NO_ERROR)
-            status = mb_register_array(verbose, mbio_ptr, MB_MEM_TYPE_BATHYMETRY, sizeof(char), (void **)&beamflag,
-                                       &error);
-          if (error == MB_ERROR_NO_ERROR)
-            status =
-                mb_register_array(verbose, mbio_ptr, MB_MEM_TYPE_BATHYMETRY, sizeof(double), (void **)&bath, &error);
-          if (error == MB_ERROR_NO_ERROR)
-            status =
-                mb_register_array(verbose, mbio_ptr, MB_MEM_TYPE_AMPLITUDE, sizeof(double), (void **)&amp, &error);
-          if (error == MB_ERROR_NO_ERROR)
-            status = mb_register_array(verbose, mbio_ptr, MB_MEM_TYPE_BATHYMETRY, sizeof(double), (void **)&bathlon,
-                                       &error);
-          if (error == MB_ERROR_NO_ERROR)
-            status = mb_register_array(verbose, mbio_ptr, MB_MEM_TYPE_BATHYMETRY, sizeof(double), (void **)&bathlat,
-                                       &error);
-          if (error == MB_ERROR_NO_ERROR)
-            status = mb_register_array(verbose, mbio_ptr, MB_MEM_TYPE_SIDESCAN, sizeof(double), (void **)&ss, &error);
-          if (error == MB_ERROR_NO_ERROR)
-            status =
-                mb_register_array(verbose, mbio_ptr, MB_MEM_TYPE_SIDESCAN, sizeof(double), (void **)&sslon, &error);
-          if (error == MB_ERROR_NO_ERROR)
-            status =
-                mb_register_array(verbose, mbio_ptr, MB_MEM_TYPE_SIDESCAN, sizeof(double), (void **)&sslat, &error);
-
-          /* if error initializing memory then quit */
-          if (error != MB_ERROR_NO_ERROR) {
-            char *message = nullptr;
-            mb_error(verbose, error, &message);
-            fprintf(outfp, "\nMBIO Error allocating data arrays:\n%s\n", message);
-            fprintf(outfp, "\nProgram <%s> Terminated\n", program_name);
-            mb_memory_clear(verbose, &memclear_error);
-            exit(error);
+    else {
+      const int look_processed = MB_DATALIST_LOOK_UNSET;
+      if (mb_datalist_open(verbose, &datalist, filelist, look_processed, &error) != MB_SUCCESS) {
+        error = MB_ERROR_OPEN_FAIL;
+        fprintf(outfp, "\nUnable to open data list file: %s\n", filelist);
+        fprintf(outfp, "\nProgram <%s> Terminated\n", program_name);
+        mb_memory_clear(verbose, &memclear_error);
+        exit(error);
+      }
+      while (mb_datalist_read3(verbose, datalist, &pstatus, path, ppath, &astatus, apath, dpath, &format, &file_weight, &error) ==
+             MB_SUCCESS) {
+        ndatafile = 0;
+
+        /* if format > 0 then input is swath sonar file */
+        if (format > 0 && path[0] != '#') {
+          /* apply pstatus */
+          if (pstatus == MB_PROCESSED_USE)
+            strcpy(file, ppath);
+          else
+            strcpy(file, path);
+
+          /* check for mbinfo file - get file bounds if possible */
+          rformat = format;
+          strcpy(rfile, file);
+          status = mb_check_info(verbose, rfile, lonflip, bounds, &file_in_bounds, &error);
+          if (status == MB_FAILURE) {
+            file_in_bounds = true;
+            status = MB_SUCCESS;
+            error = MB_ERROR_NO_ERROR;
           }
 
-          /* loop over reading */
-          while (error <= MB_ERROR_NO_ERROR) {
-            status = mb_read(verbose, mbio_ptr, &kind, &rpings, time_i, &time_d, &navlon, &navlat, &speed, &heading,
-                             &distance, &altitude, &sensordepth, &beams_bath, &beams_amp, &pixels_ss, beamflag, bath,
-                             amp, bathlon, bathlat, ss, sslon, sslat, comment, &error);
+          /* initialize the swath sonar file */
+          bool first = true;
+          double dmin = 0.0;
+          double dmax = 0.0;
+          if (file_in_bounds) {
+            /* check for "fast bathymetry" or "fbt" file */
+            if (datatype == MBGRID_DATA_TOPOGRAPHY || datatype == MBGRID_DATA_BATHYMETRY) {
+              mb_get_fbt(verbose, rfile, &rformat, &error);
+            }
 
-            /* time gaps are not a problem here */
-            if (error == MB_ERROR_TIME_GAP) {
-              error = MB_ERROR_NO_ERROR;
-              status = MB_SUCCESS;
+            /* call mb_read_init_altnav() */
+            if (mb_read_init_altnav(verbose, rfile, rformat, pings, lonflip, bounds, btime_i, etime_i, speedmin,
+                                       timegap, astatus, apath, &mbio_ptr, &btime_d, &etime_d, 
+                                       &beams_bath, &beams_amp, &pixels_ss,
+                                       &error) != MB_SUCCESS) {
+              char *message = nullptr;
+              mb_error(verbose, error, &message);
+              fprintf(outfp, "\nMBIO Error returned from function <mb_read_init_altnav>:\n%s\n", message);
+              fprintf(outfp, "\nMultibeam File <%s> not initialized for reading\n", rfile);
+              fprintf(outfp, "\nProgram <%s> Terminated\n", program_name);
+              mb_memory_clear(verbose, &memclear_error);
+              exit(error);
             }
 
-            if (verbose >= 2) {
-              fprintf(outfp, "\ndbg2  Ping read in program <%s>\n", program_name);
-              fprintf(outfp, "dbg2       kind:           %d\n", kind);
-              fprintf(outfp, "dbg2       beams_bath:     %d\n", beams_bath);
-              fprintf(outfp, "dbg2       beams_amp:      %d\n", beams_amp);
-              fprintf(outfp, "dbg2       pixels_ss:      %d\n", pixels_ss);
-              fprintf(outfp, "dbg2       error:          %d\n", error);
-              fprintf(outfp, "dbg2       status:         %d\n", status);
+            /* allocate memory for reading data arrays */
+            if (error == MB_ERROR_NO_ERROR)
+              status = mb_register_array(verbose, mbio_ptr, MB_MEM_TYPE_BATHYMETRY, sizeof(char), (void **)&beamflag,
+                                         &error);
+            if (error == MB_ERROR_NO_ERROR)
+              status =
+                  mb_register_array(verbose, mbio_ptr, MB_MEM_TYPE_BATHYMETRY, sizeof(double), (void **)&bath, &error);
+            if (error == MB_ERROR_NO_ERROR)
+              status =
+                  mb_register_array(verbose, mbio_ptr, MB_MEM_TYPE_AMPLITUDE, sizeof(double), (void **)&amp, &error);
+            if (error == MB_ERROR_NO_ERROR)
+              status = mb_register_array(verbose, mbio_ptr, MB_MEM_TYPE_BATHYMETRY, sizeof(double), (void **)&bathlon,
+                                         &error);
+            if (error == MB_ERROR_NO_ERROR)
+              status = mb_register_array(verbose, mbio_ptr, MB_MEM_TYPE_BATHYMETRY, sizeof(double), (void **)&bathlat,
+                                         &error);
+            if (error == MB_ERROR_NO_ERROR)
+              status = mb_register_array(verbose, mbio_ptr, MB_MEM_TYPE_SIDESCAN, sizeof(double), (void **)&ss, &error);
+            if (error == MB_ERROR_NO_ERROR)
+              status =
+                  mb_register_array(verbose, mbio_ptr, MB_MEM_TYPE_SIDESCAN, sizeof(double), (void **)&sslon, &error);
+            if (error == MB_ERROR_NO_ERROR)
+              status =
+                  mb_register_array(verbose, mbio_ptr, MB_MEM_TYPE_SIDESCAN, sizeof(double), (void **)&sslat, &error);
+
+            /* if error initializing memory then quit */
+            if (error != MB_ERROR_NO_ERROR) {
+              char *message = nullptr;
+              mb_error(verbose, error, &message);
+              fprintf(outfp, "\nMBIO Error allocating data arrays:\n%s\n", message);
+              fprintf(outfp, "\nProgram <%s> Terminated\n", program_name);
+              mb_memory_clear(verbose, &memclear_error);
+              exit(error);
             }
 
-            if ((datatype == MBGRID_DATA_BATHYMETRY || datatype == MBGRID_DATA_TOPOGRAPHY) &&
-                error == MB_ERROR_NO_ERROR) {
+            /* loop over reading */
+            while (error <= MB_ERROR_NO_ERROR) {
+              status = mb_read(verbose, mbio_ptr, &kind, &rpings, time_i, &time_d, &navlon, &navlat, &speed, &heading,
+                               &distance, &altitude, &sensordepth, &beams_bath, &beams_amp, &pixels_ss, beamflag, bath,
+                               amp, bathlon, bathlat, ss, sslon, sslat, comment, &error);
 
-              /* reproject beam positions if necessary */
-              if (use_projection) {
-                for (ib = 0; ib < beams_bath; ib++)
-                  if (mb_beam_ok(beamflag[ib]))
-                    mb_proj_forward(verbose, pjptr, bathlon[ib], bathlat[ib], &bathlon[ib], &bathlat[ib],
-                                    &error);
+              /* time gaps are not a problem here */
+              if (error == MB_ERROR_TIME_GAP) {
+                error = MB_ERROR_NO_ERROR;
+                status = MB_SUCCESS;
               }
 
-              /* deal with data */
-              for (ib = 0; ib < beams_bath; ib++)
-                if (mb_beam_ok(beamflag[ib])) {
-                  /* get position in grid */
-                  ix = (bathlon[ib] - wbnd[0] + 0.5 * dx) / dx;
-                  iy = (bathlat[ib] - wbnd[2] + 0.5 * dy) / dy;
-                  /* if (ib==beams_bath/2)fprintf(outfp, "ib:%d ix:%d iy:%d   bath: lon:%.10f lat:%.10f bath:%f
-                  dx:%.10f dy:%.10f  origin: lon:%.10f lat:%.10f\n", ib, ix, iy, bathlon[ib], bathlat[ib],
-                  bath[ib], dx, dy, wbnd[0], wbnd[1]); */
+              if (verbose >= 2) {
+                fprintf(outfp, "\ndbg2  Ping read in program <%s>\n", program_name);
+                fprintf(outfp, "dbg2       kind:           %d\n", kind);
+                fprintf(outfp, "dbg2       beams_bath:     %d\n", beams_bath);
+                fprintf(outfp, "dbg2       beams_amp:      %d\n", beams_amp);
+                fprintf(outfp, "dbg2       pixels_ss:      %d\n", pixels_ss);
+                fprintf(outfp, "dbg2       error:          %d\n", error);
+                fprintf(outfp, "dbg2       status:         %d\n", status);
+              }
 
-                  /* check if within allowed time */
-                  if (check_time) {
-                    /* if in region of interest
-                       check if time is ok */
-                    if (ix >= 0 && ix < gxdim && iy >= 0 && iy < gydim) {
-                      kgrid = ix * gydim + iy;
-                      if (firsttime[kgrid] <= 0.0) {
-                        firsttime[kgrid] = time_d;
-                        time_ok = true;
-                      }
-                      else if (fabs(time_d - firsttime[kgrid]) > timediff) {
-                        if (first_in_stays)
-                          time_ok = false;
-                        else {
-                          time_ok = true;
+              if ((datatype == MBGRID_DATA_BATHYMETRY || datatype == MBGRID_DATA_TOPOGRAPHY) &&
+                  error == MB_ERROR_NO_ERROR) {
+
+                /* reproject beam positions if necessary */
+                if (use_projection) {
+                  for (ib = 0; ib < beams_bath; ib++)
+                    if (mb_beam_ok(beamflag[ib]))
+                      mb_proj_forward(verbose, pjptr, bathlon[ib], bathlat[ib], &bathlon[ib], &bathlat[ib],
+                                      &error);
+                }
+
+                /* deal with data */
+                for (ib = 0; ib < beams_bath; ib++)
+                  if (mb_beam_ok(beamflag[ib])) {
+                    /* get position in grid */
+                    ix = (bathlon[ib] - wbnd[0] + 0.5 * dx) / dx;
+                    iy = (bathlat[ib] - wbnd[2] + 0.5 * dy) / dy;
+                    /* if (ib==beams_bath/2)fprintf(outfp, "ib:%d ix:%d iy:%d   bath: lon:%.10f lat:%.10f bath:%f
+                    dx:%.10f dy:%.10f  origin: lon:%.10f lat:%.10f\n", ib, ix, iy, bathlon[ib], bathlat[ib],
+                    bath[ib], dx, dy, wbnd[0], wbnd[1]); */
+
+                    /* check if within allowed time */
+                    if (check_time) {
+                      /* if in region of interest
+                         check if time is ok */
+                      if (ix >= 0 && ix < gxdim && iy >= 0 && iy < gydim) {
+                        kgrid = ix * gydim + iy;
+                        if (firsttime[kgrid] <= 0.0) {
                           firsttime[kgrid] = time_d;
-                          ndata = ndata - cnt[kgrid];
-                          ndatafile = ndatafile - cnt[kgrid];
-                          norm[kgrid] = 0.0;
-                          grid[kgrid] = 0.0;
-                          sigma[kgrid] = 0.0;
-                          num[kgrid] = 0;
-                          cnt[kgrid] = 0;
+                          time_ok = true;
                         }
+                        else if (fabs(time_d - firsttime[kgrid]) > timediff) {
+                          if (first_in_stays)
+                            time_ok = false;
+                          else {
+                            time_ok = true;
+                            firsttime[kgrid] = time_d;
+                            ndata = ndata - cnt[kgrid];
+                            ndatafile = ndatafile - cnt[kgrid];
+                            norm[kgrid] = 0.0;
+                            grid[kgrid] = 0.0;
+                            sigma[kgrid] = 0.0;
+                            num[kgrid] = 0;
+                            cnt[kgrid] = 0;
+                          }
+                        }
+                        else
+                          time_ok = true;
                       }
                       else
                         time_ok = true;
                     }
                     else
                       time_ok = true;
-                  }
-                  else
-                    time_ok = true;
 
-                  /* process if in region of interest */
-                  if (grid_mode == MBGRID_WEIGHTED_MEAN
-                      && ix >= 0 && ix < gxdim
-                      && iy >= 0 && iy < gydim && time_ok) {
-                    ix1 = std::max(ix - xtradim, 0);
-                    ix2 = std::min(ix + xtradim, gxdim - 1);
-                    iy1 = std::max(iy - xtradim, 0);
-                    iy2 = std::min(iy + xtradim, gydim - 1);
-                    for (int ii = ix1; ii <= ix2; ii++)
-                      for (int jj = iy1; jj <= iy2; jj++) {
-                        kgrid = ii * gydim + jj;
-                        xx = wbnd[0] + ii * dx - bathlon[ib];
-                        yy = wbnd[2] + jj * dy - bathlat[ib];
-                        weight = file_weight * exp(-(xx * xx + yy * yy) * factor);
-                        norm[kgrid] = norm[kgrid] + weight;
-                        grid[kgrid] = grid[kgrid] + weight * topofactor * bath[ib];
-                        sigma[kgrid] =
-                            sigma[kgrid] + weight * topofactor * topofactor * bath[ib] * bath[ib];
-                        num[kgrid]++;
-                        if (ii == ix && jj == iy)
-                          cnt[kgrid]++;
+                    /* process if in region of interest */
+                    if (grid_mode == MBGRID_WEIGHTED_MEAN
+                        && ix >= 0 && ix < gxdim
+                        && iy >= 0 && iy < gydim && time_ok) {
+                      ix1 = std::max(ix - xtradim, 0);
+                      ix2 = std::min(ix + xtradim, gxdim - 1);
+                      iy1 = std::max(iy - xtradim, 0);
+                      iy2 = std::min(iy + xtradim, gydim - 1);
+                      for (int ii = ix1; ii <= ix2; ii++)
+                        for (int jj = iy1; jj <= iy2; jj++) {
+                          kgrid = ii * gydim + jj;
+                          xx = wbnd[0] + ii * dx - bathlon[ib];
+                          yy = wbnd[2] + jj * dy - bathlat[ib];
+                          weight = file_weight * exp(-(xx * xx + yy * yy) * factor);
+                          norm[kgrid] = norm[kgrid] + weight;
+                          grid[kgrid] = grid[kgrid] + weight * topofactor * bath[ib];
+                          sigma[kgrid] =
+                              sigma[kgrid] + weight * topofactor * topofactor * bath[ib] * bath[ib];
+                          num[kgrid]++;
+                          if (ii == ix && jj == iy)
+                            cnt[kgrid]++;
+                        }
+                      ndata++;
+                      ndatafile++;
+                      if (first) {
+                        first = false;
+                        dmin = topofactor * bath[ib];
+                        dmax = topofactor * bath[ib];
+                      } else {
+                        dmin = std::min(topofactor * bath[ib], dmin);
+                        dmax = std::max(topofactor * bath[ib], dmax);
                       }
-                    ndata++;
-                    ndatafile++;
-                    if (first) {
-                      first = false;
-                      dmin = topofactor * bath[ib];
-                      dmax = topofactor * bath[ib];
-                    } else {
-                      dmin = std::min(topofactor * bath[ib], dmin);
-                      dmax = std::max(topofactor * bath[ib], dmax);
-                    }
-                  }
-                  else if (ix >= 0 && ix < gxdim && iy >= 0 && iy < gydim && time_ok) {
-                    kgrid = ix * gydim + iy;
-                    if ((num[kgrid] > 0 && grid_mode == MBGRID_MINIMUM_FILTER &&
-                         grid[kgrid] > topofactor * bath[ib]) ||
-                        (num[kgrid] > 0 && grid_mode == MBGRID_MAXIMUM_FILTER &&
-                         grid[kgrid] < topofactor * bath[ib]) ||
-                        num[kgrid] <= 0) {
-                      norm[kgrid] = 1.0;
-                      grid[kgrid] = topofactor * bath[ib];
-                      sigma[kgrid] = topofactor * topofactor * bath[ib] * bath[ib];
-                      num[kgrid] = 1;
-                      cnt[kgrid] = 1;
                     }
-                    ndata++;
-                    ndatafile++;
-                    if (first) {
-                      first = false;
-                      dmin = topofactor * bath[ib];
-                      dmax = topofactor * bath[ib];
-                    } else {
-                      dmin = std::min(topofactor * bath[ib], dmin);
-                      dmax = std::max(topofactor * bath[ib], dmax);
+                    else if (ix >= 0 && ix < gxdim && iy >= 0 && iy < gydim && time_ok) {
+                      kgrid = ix * gydim + iy;
+                      if ((num[kgrid] > 0 && grid_mode == MBGRID_MINIMUM_FILTER &&
+                           grid[kgrid] > topofactor * bath[ib]) ||
+                          (num[kgrid] > 0 && grid_mode == MBGRID_MAXIMUM_FILTER &&
+                           grid[kgrid] < topofactor * bath[ib]) ||
+                          num[kgrid] <= 0) {
+                        norm[kgrid] = 1.0;
+                        grid[kgrid] = topofactor * bath[ib];
+                        sigma[kgrid] = topofactor * topofactor * bath[ib] * bath[ib];
+                        num[kgrid] = 1;
+                        cnt[kgrid] = 1;
+                      }
+                      ndata++;
+                      ndatafile++;
+                      if (first) {
+                        first = false;
+                        dmin = topofactor * bath[ib];
+                        dmax = topofactor * bath[ib];
+                      } else {
+                        dmin = std::min(topofactor * bath[ib], dmin);
+                        dmax = std::max(topofactor * bath[ib], dmax);
+                      }
                     }
                   }
+              }
+              else if (datatype == MBGRID_DATA_AMPLITUDE && error == MB_ERROR_NO_ERROR) {
+
+                /* reproject beam positions if necessary */
+                if (use_projection) {
+                  for (ib = 0; ib < beams_amp; ib++)
+                    if (mb_beam_ok(beamflag[ib]))
+                      mb_proj_forward(verbose, pjptr, bathlon[ib], bathlat[ib], &bathlon[ib], &bathlat[ib],
+                                      &error);
                 }
-            }
-            else if (datatype == MBGRID_DATA_AMPLITUDE && error == MB_ERROR_NO_ERROR) {
 
-              /* reproject beam positions if necessary */
-              if (use_projection) {
+                /* deal with data */
                 for (ib = 0; ib < beams_amp; ib++)
-                  if (mb_beam_ok(beamflag[ib]))
-                    mb_proj_forward(verbose, pjptr, bathlon[ib], bathlat[ib], &bathlon[ib], &bathlat[ib],
-                                    &error);
-              }
-
-              /* deal with data */
-              for (ib = 0; ib < beams_amp; ib++)
-                if (mb_beam_ok(beamflag[ib])) {
-                  /* get position in grid */
-                  ix = (bathlon[ib] - wbnd[0] + 0.5 * dx) / dx;
-                  iy = (bathlat[ib] - wbnd[2] + 0.5 * dy) / dy;
+                  if (mb_beam_ok(beamflag[ib])) {
+                    /* get position in grid */
+                    ix = (bathlon[ib] - wbnd[0] + 0.5 * dx) / dx;
+                    iy = (bathlat[ib] - wbnd[2] + 0.5 * dy) / dy;
 
-                  /* check if within allowed time */
-                  if (check_time) {
-                    /* if in region of interest
-                       check if time is ok */
-                    if (ix >= 0 && ix < gxdim && iy >= 0 && iy < gydim) {
-                      kgrid = ix * gydim + iy;
-                      if (firsttime[kgrid] <= 0.0) {
-                        firsttime[kgrid] = time_d;
-                        time_ok = true;
-                      }
-                      else if (fabs(time_d - firsttime[kgrid]) > timediff) {
-                        if (first_in_stays)
-                          time_ok = false;
-                        else {
-                          time_ok = true;
+                    /* check if within allowed time */
+                    if (check_time) {
+                      /* if in region of interest
+                         check if time is ok */
+                      if (ix >= 0 && ix < gxdim && iy >= 0 && iy < gydim) {
+                        kgrid = ix * gydim + iy;
+                        if (firsttime[kgrid] <= 0.0) {
                           firsttime[kgrid] = time_d;
-                          ndata = ndata - cnt[kgrid];
-                          ndatafile = ndatafile - cnt[kgrid];
-                          norm[kgrid] = 0.0;
-                          grid[kgrid] = 0.0;
-                          sigma[kgrid] = 0.0;
-                          num[kgrid] = 0;
-                          cnt[kgrid] = 0;
+                          time_ok = true;
                         }
+                        else if (fabs(time_d - firsttime[kgrid]) > timediff) {
+                          if (first_in_stays)
+                            time_ok = false;
+                          else {
+                            time_ok = true;
+                            firsttime[kgrid] = time_d;
+                            ndata = ndata - cnt[kgrid];
+                            ndatafile = ndatafile - cnt[kgrid];
+                            norm[kgrid] = 0.0;
+                            grid[kgrid] = 0.0;
+                            sigma[kgrid] = 0.0;
+                            num[kgrid] = 0;
+                            cnt[kgrid] = 0;
+                          }
+                        }
+                        else
+                          time_ok = true;
                       }
                       else
                         time_ok = true;
                     }
                     else
                       time_ok = true;
-                  }
-                  else
-                    time_ok = true;
 
-                  /* process if in region of interest */
-                  if (grid_mode == MBGRID_WEIGHTED_MEAN
-                      && ix >= 0 && ix < gxdim
-                      && iy >= 0 && iy < gydim && time_ok) {
-                    ix1 = std::max(ix - xtradim, 0);
-                    ix2 = std::min(ix + xtradim, gxdim - 1);
-                    iy1 = std::max(iy - xtradim, 0);
-                    iy2 = std::min(iy + xtradim, gydim - 1);
-                    for (int ii = ix1; ii <= ix2; ii++)
-                      for (int jj = iy1; jj <= iy2; jj++) {
-                        kgrid = ii * gydim + jj;
-                        xx = wbnd[0] + ii * dx - bathlon[ib];
-                        yy = wbnd[2] + jj * dy - bathlat[ib];
-                        weight = file_weight * exp(-(xx * xx + yy * yy) * factor);
-                        norm[kgrid] = norm[kgrid] + weight;
-                        grid[kgrid] = grid[kgrid] + weight * amp[ib];
-                        sigma[kgrid] = sigma[kgrid] + weight * amp[ib] * amp[ib];
-                        num[kgrid]++;
-                        if (ii == ix && jj == iy)
-                          cnt[kgrid]++;
+                    /* process if in region of interest */
+                    if (grid_mode == MBGRID_WEIGHTED_MEAN
+                        && ix >= 0 && ix < gxdim
+                        && iy >= 0 && iy < gydim && time_ok) {
+                      ix1 = std::max(ix - xtradim, 0);
+                      ix2 = std::min(ix + xtradim, gxdim - 1);
+                      iy1 = std::max(iy - xtradim, 0);
+                      iy2 = std::min(iy + xtradim, gydim - 1);
+                      for (int ii = ix1; ii <= ix2; ii++)
+                        for (int jj = iy1; jj <= iy2; jj++) {
+                          kgrid = ii * gydim + jj;
+                          xx = wbnd[0] + ii * dx - bathlon[ib];
+                          yy = wbnd[2] + jj * dy - bathlat[ib];
+                          weight = file_weight * exp(-(xx * xx + yy * yy) * factor);
+                          norm[kgrid] = norm[kgrid] + weight;
+                          grid[kgrid] = grid[kgrid] + weight * amp[ib];
+                          sigma[kgrid] = sigma[kgrid] + weight * amp[ib] * amp[ib];
+                          num[kgrid]++;
+                          if (ii == ix && jj == iy)
+                            cnt[kgrid]++;
+                        }
+                      ndata++;
+                      ndatafile++;
+                      if (first) {
+                        first = false;
+                        dmin = topofactor * bath[ib];
+                        dmax = topofactor * bath[ib];
+                      } else {
+                        dmin = std::min(topofactor * bath[ib], dmin);
+                        dmax = std::max(topofactor * bath[ib], dmax);
                       }
-                    ndata++;
-                    ndatafile++;
-                    if (first) {
-                      first = false;
-                      dmin = topofactor * bath[ib];
-                      dmax = topofactor * bath[ib];
-                    } else {
-                      dmin = std::min(topofactor * bath[ib], dmin);
-                      dmax = std::max(topofactor * bath[ib], dmax);
-                    }
-                  }
-                  else if (ix >= 0 && ix < gxdim && iy >= 0 && iy < gydim && time_ok) {
-                    kgrid = ix * gydim + iy;
-                    if ((num[kgrid] > 0 && grid_mode == MBGRID_MINIMUM_FILTER && grid[kgrid] > amp[ib]) ||
-                        (num[kgrid] > 0 && grid_mode == MBGRID_MAXIMUM_FILTER && grid[kgrid] < amp[ib]) ||
-                        num[kgrid] <= 0) {
-                      norm[kgrid] = 1.0;
-                      grid[kgrid] = amp[ib];
-                      sigma[kgrid] = amp[ib] * amp[ib];
-                      num[kgrid] = 1;
-                      cnt[kgrid] = 1;
                     }
-                    ndata++;
-                    ndatafile++;
-                    if (first) {
-                      first = false;
-                      dmin = amp[ib];
-                      dmax = amp[ib];
-                    } else {
-                      dmin = std::min(amp[ib], dmin);
-                      dmax = std::max(amp[ib], dmax);
+                    else if (ix >= 0 && ix < gxdim && iy >= 0 && iy < gydim && time_ok) {
+                      kgrid = ix * gydim + iy;
+                      if ((num[kgrid] > 0 && grid_mode == MBGRID_MINIMUM_FILTER && grid[kgrid] > amp[ib]) ||
+                          (num[kgrid] > 0 && grid_mode == MBGRID_MAXIMUM_FILTER && grid[kgrid] < amp[ib]) ||
+                          num[kgrid] <= 0) {
+                        norm[kgrid] = 1.0;
+                        grid[kgrid] = amp[ib];
+                        sigma[kgrid] = amp[ib] * amp[ib];
+                        num[kgrid] = 1;
+                        cnt[kgrid] = 1;
+                      }
+                      ndata++;
+                      ndatafile++;
+                      if (first) {
+                        first = false;
+                        dmin = amp[ib];
+                        dmax = amp[ib];
+                      } else {
+                        dmin = std::min(amp[ib], dmin);
+                        dmax = std::max(amp[ib], dmax);
+                      }
                     }
                   }
+              }
+              else if (datatype == MBGRID_DATA_SIDESCAN && error == MB_ERROR_NO_ERROR) {
+
+                /* reproject pixel positions if necessary */
+                if (use_projection) {
+                  for (ib = 0; ib < pixels_ss; ib++)
+                    if (ss[ib] > MB_SIDESCAN_NULL)
+                      mb_proj_forward(verbose, pjptr, sslon[ib], sslat[ib], &sslon[ib], &sslat[ib], &error);
                 }
-            }
-            else if (datatype == MBGRID_DATA_SIDESCAN && error == MB_ERROR_NO_ERROR) {
 
-              /* reproject pixel positions if necessary */
-              if (use_projection) {
+                /* deal with data */
                 for (ib = 0; ib < pixels_ss; ib++)
-                  if (ss[ib] > MB_SIDESCAN_NULL)
-                    mb_proj_forward(verbose, pjptr, sslon[ib], sslat[ib], &sslon[ib], &sslat[ib], &error);
-              }
+                  if (ss[ib] > MB_SIDESCAN_NULL) {
+                    /* get position in grid */
+                    ix = (sslon[ib] - wbnd[0] + 0.5 * dx) / dx;
+                    iy = (sslat[ib] - wbnd[2] + 0.5 * dy) / dy;
 
-              /* deal with data */
-              for (ib = 0; ib < pixels_ss; ib++)
-                if (ss[ib] > MB_SIDESCAN_NULL) {
-                  /* get position in grid */
-                  ix = (sslon[ib] - wbnd[0] + 0.5 * dx) / dx;
-                  iy = (sslat[ib] - wbnd[2] + 0.5 * dy) / dy;
-
-                  /* check if within allowed time */
-                  if (check_time) {
-                    /* if in region of interest
-                       check if time is ok */
-                    if (ix >= 0 && ix < gxdim && iy >= 0 && iy < gydim) {
-                      kgrid = ix * gydim + iy;
-                      if (firsttime[kgrid] <= 0.0) {
-                        firsttime[kgrid] = time_d;
-                        time_ok = true;
-                      }
-                      else if (fabs(time_d - firsttime[kgrid]) > timediff) {
-                        if (first_in_stays)
-                          time_ok = false;
-                        else {
-                          time_ok = true;
+                    /* check if within allowed time */
+                    if (check_time) {
+                      /* if in region of interest
+                         check if time is ok */
+                      if (ix >= 0 && ix < gxdim && iy >= 0 && iy < gydim) {
+                        kgrid = ix * gydim + iy;
+                        if (firsttime[kgrid] <= 0.0) {
                           firsttime[kgrid] = time_d;
-                          ndata = ndata - cnt[kgrid];
-                          ndatafile = ndatafile - cnt[kgrid];
-                          norm[kgrid] = 0.0;
-                          grid[kgrid] = 0.0;
-                          sigma[kgrid] = 0.0;
-                          num[kgrid] = 0;
-                          cnt[kgrid] = 0;
+                          time_ok = true;
+                        }
+                        else if (fabs(time_d - firsttime[kgrid]) > timediff) {
+                          if (first_in_stays)
+                            time_ok = false;
+                          else {
+                            time_ok = true;
+                            firsttime[kgrid] = time_d;
+                            ndata = ndata - cnt[kgrid];
+                            ndatafile = ndatafile - cnt[kgrid];
+                            norm[kgrid] = 0.0;
+                            grid[kgrid] = 0.0;
+                            sigma[kgrid] = 0.0;
+                            num[kgrid] = 0;
+                            cnt[kgrid] = 0;
+                          }
                         }
+                        else
+                          time_ok = true;
                       }
                       else
                         time_ok = true;
                     }
                     else
                       time_ok = true;
-                  }
-                  else
-                    time_ok = true;
 
-                  /* process if in region of interest */
-                  if (grid_mode == MBGRID_WEIGHTED_MEAN
-                      && ix >= 0 && ix < gxdim
-                      && iy >= 0 && iy < gydim && time_ok) {
-                    ix1 = std::max(ix - xtradim, 0);
-                    ix2 = std::min(ix + xtradim, gxdim - 1);
-                    iy1 = std::max(iy - xtradim, 0);
-                    iy2 = std::min(iy + xtradim, gydim - 1);
-                    for (int ii = ix1; ii <= ix2; ii++)
-                      for (int jj = iy1; jj <= iy2; jj++) {
-                        kgrid = ii * gydim + jj;
-                        xx = wbnd[0] + ii * dx - sslon[ib];
-                        yy = wbnd[2] + jj * dy - sslat[ib];
-                        weight = file_weight * exp(-(xx * xx + yy * yy) * factor);
-                        norm[kgrid] = norm[kgrid] + weight;
-                        grid[kgrid] = grid[kgrid] + weight * ss[ib];
-                        sigma[kgrid] = sigma[kgrid] + weight * ss[ib] * ss[ib];
-                        num[kgrid]++;
-                        if (ii == ix && jj == iy)
-                          cnt[kgrid]++;
+                    /* process if in region of interest */
+                    if (grid_mode == MBGRID_WEIGHTED_MEAN
+                        && ix >= 0 && ix < gxdim
+                        && iy >= 0 && iy < gydim && time_ok) {
+                      ix1 = std::max(ix - xtradim, 0);
+                      ix2 = std::min(ix + xtradim, gxdim - 1);
+                      iy1 = std::max(iy - xtradim, 0);
+                      iy2 = std::min(iy + xtradim, gydim - 1);
+                      for (int ii = ix1; ii <= ix2; ii++)
+                        for (int jj = iy1; jj <= iy2; jj++) {
+                          kgrid = ii * gydim + jj;
+                          xx = wbnd[0] + ii * dx - sslon[ib];
+                          yy = wbnd[2] + jj * dy - sslat[ib];
+                          weight = file_weight * exp(-(xx * xx + yy * yy) * factor);
+                          norm[kgrid] = norm[kgrid] + weight;
+                          grid[kgrid] = grid[kgrid] + weight * ss[ib];
+                          sigma[kgrid] = sigma[kgrid] + weight * ss[ib] * ss[ib];
+                          num[kgrid]++;
+                          if (ii == ix && jj == iy)
+                            cnt[kgrid]++;
+                        }
+                      ndata++;
+                      ndatafile++;
+                    }
+                    else if (ix >= 0 && ix < gxdim && iy >= 0 && iy < gydim && time_ok) {
+                      kgrid = ix * gydim + iy;
+                      if ((num[kgrid] > 0 && grid_mode == MBGRID_MINIMUM_FILTER && grid[kgrid] > ss[ib]) ||
+                          (num[kgrid] > 0 && grid_mode == MBGRID_MAXIMUM_FILTER && grid[kgrid] < ss[ib]) ||
+                          num[kgrid] <= 0) {
+                        norm[kgrid] = 1.0;
+                        grid[kgrid] = ss[ib];
+                        sigma[kgrid] = ss[ib] * ss[ib];
+                        num[kgrid] = 1;
+                        cnt[kgrid] = 1;
                       }
-                    ndata++;
-                    ndatafile++;
-                  }
-                  else if (ix >= 0 && ix < gxdim && iy >= 0 && iy < gydim && time_ok) {
-                    kgrid = ix * gydim + iy;
-                    if ((num[kgrid] > 0 && grid_mode == MBGRID_MINIMUM_FILTER && grid[kgrid] > ss[ib]) ||
-                        (num[kgrid] > 0 && grid_mode == MBGRID_MAXIMUM_FILTER && grid[kgrid] < ss[ib]) ||
-                        num[kgrid] <= 0) {
-                      norm[kgrid] = 1.0;
-                      grid[kgrid] = ss[ib];
-                      sigma[kgrid] = ss[ib] * ss[ib];
-                      num[kgrid] = 1;
-                      cnt[kgrid] = 1;
+                      ndata++;
+                      ndatafile++;
                     }
-                    ndata++;
-                    ndatafile++;
                   }
-                }
+              }
             }
+            mb_close(verbose, &mbio_ptr, &error);
+            status = MB_SUCCESS;
+            error = MB_ERROR_NO_ERROR;
+          }
+          if (verbose >= 2)
+            fprintf(outfp, "\n");
+          if (verbose > 0 || file_in_bounds)
+            fprintf(outfp, "%d data points processed in %s (minmax: %f %f)\n", ndatafile, rfile, dmin, dmax);
+
+          /* add to datalist if data actually contributed */
+          if (ndatafile > 0 && dfp != nullptr) {
+            if (pstatus == MB_PROCESSED_USE && astatus == MB_ALTNAV_USE)
+              fprintf(dfp, "A:%s %d %f %s\n", path, format, file_weight, apath);
+            else if (pstatus == MB_PROCESSED_USE)
+              fprintf(dfp, "P:%s %d %f\n", path, format, file_weight);
+            else
+              fprintf(dfp, "R:%s %d %f\n", path, format, file_weight);
+            fflush(dfp);
+          }
+        } /* end if (format > 0) */
+
+        /* if format == 0 then input is lon,lat,values triples file */
+        else if (format == 0 && path[0] != '#') {
+          /* open data file */
+          if ((rfp = fopen(path, "r")) == nullptr) {
+            error = MB_ERROR_OPEN_FAIL;
+            fprintf(outfp, "\nUnable to open lon,lat,value triples data file1: %s\n", path);
+            fprintf(outfp, "\nProgram <%s> Terminated\n", program_name);
+            mb_memory_clear(verbose, &memclear_error);
+            exit(error);
           }
-          mb_close(verbose, &mbio_ptr, &error);
-          status = MB_SUCCESS;
-          error = MB_ERROR_NO_ERROR;
-        }
-        if (verbose >= 2)
-          fprintf(outfp, "\n");
-        if (verbose > 0 || file_in_bounds)
-          fprintf(outfp, "%d data points processed in %s (minmax: %f %f)\n", ndatafile, rfile, dmin, dmax);
-
-        /* add to datalist if data actually contributed */
-        if (ndatafile > 0 && dfp != nullptr) {
-          if (pstatus == MB_PROCESSED_USE && astatus == MB_ALTNAV_USE)
-            fprintf(dfp, "A:%s %d %f %s\n", path, format, file_weight, apath);
-          else if (pstatus == MB_PROCESSED_USE)
-            fprintf(dfp, "P:%s %d %f\n", path, format, file_weight);
-          else
-            fprintf(dfp, "R:%s %d %f\n", path, format, file_weight);
-          fflush(dfp);
-        }
-      } /* end if (format > 0) */
-
-      /* if format == 0 then input is lon,lat,values triples file */
-      else if (format == 0 && path[0] != '#') {
-        /* open data file */
-        if ((rfp = fopen(path, "r")) == nullptr) {
-          error = MB_ERROR_OPEN_FAIL;
-          fprintf(outfp, "\nUnable to open lon,lat,value triples data file1: %s\n", path);
-          fprintf(outfp, "\nProgram <%s> Terminated\n", program_name);
-          mb_memory_clear(verbose, &memclear_error);
-          exit(error);
-        }
-
-        /* loop over reading */
-        bool first = true;
-        double dmin = 0.0;
-        double dmax = 0.0;
-        while (fscanf(rfp, "%lf %lf %lf", &tlon, &tlat, &tvalue) != EOF) {
-          /* reproject data positions if necessary */
-          if (use_projection)
-            mb_proj_forward(verbose, pjptr, tlon, tlat, &tlon, &tlat, &error);
-
-          /* get position in grid */
-          ix = (tlon - wbnd[0] + 0.5 * dx) / dx;
-          iy = (tlat - wbnd[2] + 0.5 * dy) / dy;
 
-          /* check if overwriting */
-          if (check_time) {
-            /* if in region of interest
-               check if overwriting */
-            if (ix >= 0 && ix < gxdim && iy >= 0 && iy < gydim) {
-              kgrid = ix * gydim + iy;
-              if (firsttime[kgrid] > 0.0)
-                time_ok = false;
+          /* loop over reading */
+          bool first = true;
+          double dmin = 0.0;
+          double dmax = 0.0;
+          while (fscanf(rfp, "%lf %lf %lf", &tlon, &tlat, &tvalue) != EOF) {
+            /* reproject data positions if necessary */
+            if (use_projection)
+              mb_proj_forward(verbose, pjptr, tlon, tlat, &tlon, &tlat, &error);
+
+            /* get position in grid */
+            ix = (tlon - wbnd[0] + 0.5 * dx) / dx;
+            iy = (tlat - wbnd[2] + 0.5 * dy) / dy;
+
+            /* check if overwriting */
+            if (check_time) {
+              /* if in region of interest
+                 check if overwriting */
+              if (ix >= 0 && ix < gxdim && iy >= 0 && iy < gydim) {
+                kgrid = ix * gydim + iy;
+                if (firsttime[kgrid] > 0.0)
+                  time_ok = false;
+                else
+                  time_ok = true;
+              }
               else
                 time_ok = true;
             }
             else
               time_ok = true;
-          }
-          else
-            time_ok = true;
-
-          /* process the data */
-          if (grid_mode == MBGRID_WEIGHTED_MEAN && ix >= -xtradim && ix < gxdim + xtradim && iy >= -xtradim &&
-              iy < gydim + xtradim && time_ok) {
-            ix1 = std::max(ix - xtradim, 0);
-            ix2 = std::min(ix + xtradim, gxdim - 1);
-            iy1 = std::max(iy - xtradim, 0);
-            iy2 = std::min(iy + xtradim, gydim - 1);
-            for (int ii = ix1; ii <= ix2; ii++)
-              for (int jj = iy1; jj <= iy2; jj++) {
-                kgrid = ii * gydim + jj;
-                xx = wbnd[0] + ii * dx - tlon;
-                yy = wbnd[2] + jj * dy - tlat;
-                weight = file_weight * exp(-(xx * xx + yy * yy) * factor);
-                norm[kgrid] = norm[kgrid] + weight;
-                grid[kgrid] = grid[kgrid] + weight * topofactor * tvalue;
-                sigma[kgrid] = sigma[kgrid] + weight * topofactor * topofactor * tvalue * tvalue;
-                num[kgrid]++;
-                if (ii == ix && jj == iy)
-                  cnt[kgrid]++;
+
+            /* process the data */
+            if (grid_mode == MBGRID_WEIGHTED_MEAN && ix >= -xtradim && ix < gxdim + xtradim && iy >= -xtradim &&
+                iy < gydim + xtradim && time_ok) {
+              ix1 = std::max(ix - xtradim, 0);
+              ix2 = std::min(ix + xtradim, gxdim - 1);
+              iy1 = std::max(iy - xtradim, 0);
+              iy2 = std::min(iy + xtradim, gydim - 1);
+              for (int ii = ix1; ii <= ix2; ii++)
+                for (int jj = iy1; jj <= iy2; jj++) {
+                  kgrid = ii * gydim + jj;
+                  xx = wbnd[0] + ii * dx - tlon;
+                  yy = wbnd[2] + jj * dy - tlat;
+                  weight = file_weight * exp(-(xx * xx + yy * yy) * factor);
+                  norm[kgrid] = norm[kgrid] + weight;
+                  grid[kgrid] = grid[kgrid] + weight * topofactor * tvalue;
+                  sigma[kgrid] = sigma[kgrid] + weight * topofactor * topofactor * tvalue * tvalue;
+                  num[kgrid]++;
+                  if (ii == ix && jj == iy)
+                    cnt[kgrid]++;
+                }
+              ndata++;
+              ndatafile++;
+            }
+            else if (ix >= 0 && ix < gxdim && iy >= 0 && iy < gydim && time_ok) {
+              kgrid = ix * gydim + iy;
+              if ((num[kgrid] > 0 && grid_mode == MBGRID_MINIMUM_FILTER && grid[kgrid] > topofactor * tvalue) ||
+                  (num[kgrid] > 0 && grid_mode == MBGRID_MAXIMUM_FILTER && grid[kgrid] < topofactor * tvalue) ||
+                  num[kgrid] <= 0) {
+                norm[kgrid] = 1.0;
+                grid[kgrid] = topofactor * tvalue;
+                sigma[kgrid] = topofactor * topofactor * tvalue * tvalue;
+                num[kgrid] = 1;
+                cnt[kgrid] = 1;
               }
-            ndata++;
-            ndatafile++;
-          }
-          else if (ix >= 0 && ix < gxdim && iy >= 0 && iy < gydim && time_ok) {
-            kgrid = ix * gydim + iy;
-            if ((num[kgrid] > 0 && grid_mode == MBGRID_MINIMUM_FILTER && grid[kgrid] > topofactor * tvalue) ||
-                (num[kgrid] > 0 && grid_mode == MBGRID_MAXIMUM_FILTER && grid[kgrid] < topofactor * tvalue) ||
-                num[kgrid] <= 0) {
-              norm[kgrid] = 1.0;
-              grid[kgrid] = topofactor * tvalue;
-              sigma[kgrid] = topofactor * topofactor * tvalue * tvalue;
-              num[kgrid] = 1;
-              cnt[kgrid] = 1;
+              ndata++;
+              ndatafile++;
             }
-            ndata++;
-            ndatafile++;
           }
-        }
-        fclose(rfp);
-        status = MB_SUCCESS;
-        error = MB_ERROR_NO_ERROR;
-        if (verbose >= 2)
-          fprintf(outfp, "\n");
-        if (verbose > 0 || ndatafile > 0)
-          fprintf(outfp, "%d data points processed in %s (minmax: %f %f)\n", ndatafile, file, dmin, dmax);
-
-        /* add to datalist if data actually contributed */
-        if (ndatafile > 0 && dfp != nullptr) {
-          if (pstatus == MB_PROCESSED_USE && astatus == MB_ALTNAV_USE)
-            fprintf(dfp, "A:%s %d %f %s\n", path, format, file_weight, apath);
-          else if (pstatus == MB_PROCESSED_USE)
-            fprintf(dfp, "P:%s %d %f\n", path, format, file_weight);
-          else
-            fprintf(dfp, "R:%s %d %f\n", path, format, file_weight);
-          fflush(dfp);
-        }
-      } /* end if (format == 0) */
+          fclose(rfp);
+          status = MB_SUCCESS;
+          error = MB_ERROR_NO_ERROR;
+          if (verbose >= 2)
+            fprintf(outfp, "\n");
+          if (verbose > 0 || ndatafile > 0)
+            fprintf(outfp, "%d data points processed in %s (minmax: %f %f)\n", ndatafile, file, dmin, dmax);
+
+          /* add to datalist if data actually contributed */
+          if (ndatafile > 0 && dfp != nullptr) {
+            if (pstatus == MB_PROCESSED_USE && astatus == MB_ALTNAV_USE)
+              fprintf(dfp, "A:%s %d %f %s\n", path, format, file_weight, apath);
+            else if (pstatus == MB_PROCESSED_USE)
+              fprintf(dfp, "P:%s %d %f\n", path, format, file_weight);
+            else
+              fprintf(dfp, "R:%s %d %f\n", path, format, file_weight);
+            fflush(dfp);
+          }
+        } /* end if (format == 0) */
+      }
+      if (datalist != nullptr)
+        mb_datalist_close(verbose, &datalist, &error);
     }
-    if (datalist != nullptr)
-      mb_datalist_close(verbose, &datalist, &error);
     fprintf(outfp, "\n%d total data points processed\n", ndata);
 
     /* close datalist if necessary */
@@ -4998,7 +6888,7 @@ int main(int argc, char **argv) {
 /* -------------------------------------------------------------------------- */
 
   /* if clip set do smooth interpolation */
-  if (clipmode != MBGRID_INTERP_NONE && clip > 0 && nbinset > 0) {
+  if (tile_size == 0 && clipmode != MBGRID_INTERP_NONE && clip > 0 && nbinset > 0) {
     /* set up data vector */
     if (setborder)
       ndata = 2 * gxdim + 2 * gydim - 2;
@@ -5011,177 +6901,183 @@ int main(int argc, char **argv) {
           ndata++;
       }
 
-#ifdef USESURFACE
-    /* allocate and initialize sgrid */
-    status = mb_mallocd(verbose, __FILE__, __LINE__, ndata * sizeof(float), (void **)&sxdata, &error);
-    if (status == MB_SUCCESS)
-      status = mb_mallocd(verbose, __FILE__, __LINE__, ndata * sizeof(float), (void **)&sydata, &error);
-    if (status == MB_SUCCESS)
-      status = mb_mallocd(verbose, __FILE__, __LINE__, ndata * sizeof(float), (void **)&szdata, &error);
-    if (status == MB_SUCCESS)
-      status = mb_mallocd(verbose, __FILE__, __LINE__, gxdim * gydim * sizeof(float), (void **)&sgrid, &error);
-    if (error != MB_ERROR_NO_ERROR) {
-      char *message = nullptr;
-      mb_error(verbose, MB_ERROR_MEMORY_FAIL, &message);
-      fprintf(outfp, "\nMBIO Error allocating interpolation work arrays:\n%s\n", message);
-      fprintf(outfp, "\nProgram <%s> Terminated\n", program_name);
-      mb_memory_clear(verbose, &memclear_error);
-      exit(error);
-    }
-    memset((char *)sgrid, 0, gxdim * gydim * sizeof(float));
-    memset((char *)sxdata, 0, ndata * sizeof(float));
-    memset((char *)sydata, 0, ndata * sizeof(float));
-    memset((char *)szdata, 0, ndata * sizeof(float));
-
-    /* get points from grid */
-    /* simultaneously find the depth values nearest to the grid corners and edge midpoints */
-    ndata = 0;
-    for (int i = 0; i < gxdim; i++)
-      for (int j = 0; j < gydim; j++) {
-        kgrid = i * gydim + j;
-        if (grid[kgrid] < clipvalue) {
-          sxdata[ndata] = (float)(wbnd[0] + dx * i - bdata_origin_x);
-          sydata[ndata] = (float)(wbnd[2] + dy * j - bdata_origin_y);
-          szdata[ndata] = (float)grid[kgrid];
-          ndata++;
-        }
+    if (use_surface) {
+      /* allocate and initialize sgrid */
+      status = mb_mallocd(verbose, __FILE__, __LINE__, ndata * sizeof(float), (void **)&sxdata, &error);
+      if (status == MB_SUCCESS)
+        status = mb_mallocd(verbose, __FILE__, __LINE__, ndata * sizeof(float), (void **)&sydata, &error);
+      if (status == MB_SUCCESS)
+        status = mb_mallocd(verbose, __FILE__, __LINE__, ndata * sizeof(float), (void **)&szdata, &error);
+      if (status == MB_SUCCESS)
+        status = mb_mallocd(verbose, __FILE__, __LINE__, gxdim * gydim * sizeof(float), (void **)&sgrid, &error);
+      if (error != MB_ERROR_NO_ERROR) {
+        char *message = nullptr;
+        mb_error(verbose, MB_ERROR_MEMORY_FAIL, &message);
+        fprintf(outfp, "\nMBIO Error allocating interpolation work arrays:\n%s\n", message);
+        fprintf(outfp, "\nProgram <%s> Terminated\n", program_name);
+        mb_memory_clear(verbose, &memclear_error);
+        exit(error);
       }
-
-    /* if desired set border */
-    if (setborder) {
-      for (int i = 0; i < gxdim; i++) {
-        j = 0;
-        kgrid = i * gydim + j;
-        if (grid[kgrid] >= clipvalue) {
-          sxdata[ndata] = (float)(wbnd[0] + dx * i - bdata_origin_x);
-          sydata[ndata] = (float)(wbnd[2] + dy * j - bdata_origin_y);
-          szdata[ndata] = (float)border;
-          ndata++;
-        }
-        j = gydim - 1;
-        kgrid = i * gydim + j;
-        if (grid[kgrid] >= clipvalue) {
-          sxdata[ndata] = (float)(wbnd[0] + dx * i - bdata_origin_x);
-          sydata[ndata] = (float)(wbnd[2] + dy * j - bdata_origin_y);
-          szdata[ndata] = (float)border;
-          ndata++;
+      memset((char *)sgrid, 0, gxdim * gydim * sizeof(float));
+      memset((char *)sxdata, 0, ndata * sizeof(float));
+      memset((char *)sydata, 0, ndata * sizeof(float));
+      memset((char *)szdata, 0, ndata * sizeof(float));
+
+      /* get points from grid */
+      /* simultaneously find the depth values nearest to the grid corners and edge midpoints */
+      ndata = 0;
+      for (int i = 0; i < gxdim; i++)
+        for (int j = 0; j < gydim; j++) {
+          kgrid = i * gydim + j;
+          if (grid[kgrid] < clipvalue) {
+            sxdata[ndata] = (float)(wbnd[0] + dx * i - bdata_origin_x);
+            sydata[ndata] = (float)(wbnd[2] + dy * j - bdata_origin_y);
+            szdata[ndata] = (float)grid[kgrid];
+            ndata++;
+          }
         }
-      }
-      for (int j = 1; j < gydim - 1; j++) {
-        i = 0;
-        kgrid = i * gydim + j;
-        if (grid[kgrid] >= clipvalue) {
-          sxdata[ndata] = (float)(wbnd[0] + dx * i - bdata_origin_x);
-          sydata[ndata] = (float)(wbnd[2] + dy * j - bdata_origin_y);
-          szdata[ndata] = (float)border;
-          ndata++;
+
+      /* if desired set border */
+      if (setborder) {
+        for (int i = 0; i < gxdim; i++) {
+          int j = 0;
+          kgrid = i * gydim + j;
+          if (grid[kgrid] >= clipvalue) {
+            sxdata[ndata] = (float)(wbnd[0] + dx * i - bdata_origin_x);
+            sydata[ndata] = (float)(wbnd[2] + dy * j - bdata_origin_y);
+            szdata[ndata] = (float)border;
+            ndata++;
+          }
+          j = gydim - 1;
+          kgrid = i * gydim + j;
+          if (grid[kgrid] >= clipvalue) {
+            sxdata[ndata] = (float)(wbnd[0] + dx * i - bdata_origin_x);
+            sydata[ndata] = (float)(wbnd[2] + dy * j - bdata_origin_y);
+            szdata[ndata] = (float)border;
+            ndata++;
+          }
         }
-        i = gxdim - 1;
-        kgrid = i * gydim + j;
-        if (grid[kgrid] >= clipvalue) {
-          sxdata[ndata] = (float)(wbnd[0] + dx * i - bdata_origin_x);
-          sydata[ndata] = (float)(wbnd[2] + dy * j - bdata_origin_y);
-          szdata[ndata] = (float)border;
-          ndata++;
+        for (int j = 1; j < gydim - 1; j++) {
+          int i = 0;
+          kgrid = i * gydim + j;
+          if (grid[kgrid] >= clipvalue) {
+            sxdata[ndata] = (float)(wbnd[0] + dx * i - bdata_origin_x);
+            sydata[ndata] = (float)(wbnd[2] + dy * j - bdata_origin_y);
+            szdata[ndata] = (float)border;
+            ndata++;
+          }
+          i = gxdim - 1;
+          kgrid = i * gydim + j;
+          if (grid[kgrid] >= clipvalue) {
+            sxdata[ndata] = (float)(wbnd[0] + dx * i - bdata_origin_x);
+            sydata[ndata] = (float)(wbnd[2] + dy * j - bdata_origin_y);
+            szdata[ndata] = (float)border;
+            ndata++;
+          }
         }
       }
-    }
 
-    /* do the interpolation */
-    fprintf(outfp, "\nDoing Surface spline interpolation with %d data points...\n", ndata);
-    mb_surface(verbose, ndata, sxdata, sydata, szdata, (float)(gbnd[0] - bdata_origin_x), (float)(gbnd[1] - bdata_origin_x),
-               (float)(gbnd[2] - bdata_origin_y), (float)(gbnd[3] - bdata_origin_y), dx, dy, tension, sgrid);
-#else
-    /* allocate and initialize sgrid */
-    status = mb_mallocd(verbose, __FILE__, __LINE__, 3 * ndata * sizeof(float), (void **)&sdata, &error);
-    if (status == MB_SUCCESS)
-      status = mb_mallocd(verbose, __FILE__, __LINE__, gxdim * gydim * sizeof(float), (void **)&sgrid, &error);
-    if (status == MB_SUCCESS)
-      status = mb_mallocd(verbose, __FILE__, __LINE__, ndata * sizeof(float), (void **)&work1, &error);
-    if (status == MB_SUCCESS)
-      status = mb_mallocd(verbose, __FILE__, __LINE__, ndata * sizeof(int), (void **)&work2, &error);
-    if (status == MB_SUCCESS)
-      status = mb_mallocd(verbose, __FILE__, __LINE__, (gxdim + gydim) * sizeof(bool), (void **)&work3, &error);
-    if (error != MB_ERROR_NO_ERROR) {
-      char *message = nullptr;
-      mb_error(verbose, MB_ERROR_MEMORY_FAIL, &message);
-      fprintf(outfp, "\nMBIO Error allocating interpolation work arrays:\n%s\n", message);
-      fprintf(outfp, "\nProgram <%s> Terminated\n", program_name);
-      mb_memory_clear(verbose, &memclear_error);
-      exit(error);
+      /* do the interpolation */
+      fprintf(outfp, "\nDoing Surface spline interpolation with %d data points...\n", ndata);
+      void *surface_ptr = nullptr;
+      status = mb_surface_ctx_init(verbose, n_threads, &surface_ptr, &error);
+      if (status == MB_SUCCESS)
+        status = mb_surface_ctx_compute(verbose, surface_ptr, ndata, sxdata, sydata, szdata, (float)(wbnd[0] - bdata_origin_x),
+                                        (float)(wbnd[1] - bdata_origin_x), (float)(wbnd[2] - bdata_origin_y),
+                                        (float)(wbnd[3] - bdata_origin_y), dx, dy, tension, sgrid, &error);
+      mb_surface_ctx_deall(verbose, &surface_ptr, &error);
     }
-    memset((char *)sgrid, 0, gxdim * gydim * sizeof(float));
-    memset((char *)sdata, 0, 3 * ndata * sizeof(float));
-    memset((char *)work1, 0, ndata * sizeof(float));
-    memset((char *)work2, 0, ndata * sizeof(int));
-    memset((char *)work3, 0, (gxdim + gydim) * sizeof(bool));
-
-    /* get points from grid */
-    /* simultaneously find the depth values nearest to the grid corners and edge midpoints */
-    ndata = 0;
-    for (int i = 0; i < gxdim; i++)
-      for (int j = 0; j < gydim; j++) {
-        kgrid = i * gydim + j;
-        if (grid[kgrid] < clipvalue) {
-          sdata[ndata++] = (float)(wbnd[0] + dx * i - bdata_origin_x);
-          sdata[ndata++] = (float)(wbnd[2] + dy * j - bdata_origin_y);
-          sdata[ndata++] = (float)grid[kgrid];
-        }
+    else {
+      /* allocate and initialize sgrid */
+      status = mb_mallocd(verbose, __FILE__, __LINE__, 3 * ndata * sizeof(float), (void **)&sdata, &error);
+      if (status == MB_SUCCESS)
+        status = mb_mallocd(verbose, __FILE__, __LINE__, gxdim * gydim * sizeof(float), (void **)&sgrid, &error);
+      if (status == MB_SUCCESS)
+        status = mb_mallocd(verbose, __FILE__, __LINE__, ndata * sizeof(float), (void **)&work1, &error);
+      if (status == MB_SUCCESS)
+        status = mb_mallocd(verbose, __FILE__, __LINE__, ndata * sizeof(int), (void **)&work2, &error);
+      if (status == MB_SUCCESS)
+        status = mb_mallocd(verbose, __FILE__, __LINE__, (gxdim + gydim) * sizeof(bool), (void **)&work3, &error);
+      if (error != MB_ERROR_NO_ERROR) {
+        char *message = nullptr;
+        mb_error(verbose, MB_ERROR_MEMORY_FAIL, &message);
+        fprintf(outfp, "\nMBIO Error allocating interpolation work arrays:\n%s\n", message);
+        fprintf(outfp, "\nProgram <%s> Terminated\n", program_name);
+        mb_memory_clear(verbose, &memclear_error);
+        exit(error);
       }
-
-    /* if desired set border */
-    if (setborder) {
-      for (int i = 0; i < gxdim; i++) {
-        int j = 0;
-        kgrid = i * gydim + j;
-        if (grid[kgrid] >= clipvalue) {
-          sdata[ndata++] = (float)(wbnd[0] + dx * i - bdata_origin_x);
-          sdata[ndata++] = (float)(wbnd[2] + dy * j - bdata_origin_y);
-          sdata[ndata++] = (float)border;
-        }
-        j = gydim - 1;
-        kgrid = i * gydim + j;
-        if (grid[kgrid] >= clipvalue) {
-          sdata[ndata++] = (float)(wbnd[0] + dx * i - bdata_origin_x);
-          sdata[ndata++] = (float)(wbnd[2] + dy * j - bdata_origin_y);
-          sdata[ndata++] = (float)border;
+      memset((char *)sgrid, 0, gxdim * gydim * sizeof(float));
+      memset((char *)sdata, 0, 3 * ndata * sizeof(float));
+      memset((char *)work1, 0, ndata * sizeof(float));
+      memset((char *)work2, 0, ndata * sizeof(int));
+      memset((char *)work3, 0, (gxdim + gydim) * sizeof(bool));
+
+      /* get points from grid */
+      /* simultaneously find the depth values nearest to the grid corners and edge midpoints */
+      ndata = 0;
+      for (int i = 0; i < gxdim; i++)
+        for (int j = 0; j < gydim; j++) {
+          kgrid = i * gydim + j;
+          if (grid[kgrid] < clipvalue) {
+            sdata[ndata++] = (float)(wbnd[0] + dx * i - bdata_origin_x);
+            sdata[ndata++] = (float)(wbnd[2] + dy * j - bdata_origin_y);
+            sdata[ndata++] = (float)grid[kgrid];
+          }
         }
-      }
-      for (int j = 1; j < gydim - 1; j++) {
-        int i = 0;
-        kgrid = i * gydim + j;
-        if (grid[kgrid] >= clipvalue) {
-          sdata[ndata++] = (float)(wbnd[0] + dx * i - bdata_origin_x);
-          sdata[ndata++] = (float)(wbnd[2] + dy * j - bdata_origin_y);
-          sdata[ndata++] = (float)border;
+
+      /* if desired set border */
+      if (setborder) {
+        for (int i = 0; i < gxdim; i++) {
+          int j = 0;
+          kgrid = i * gydim + j;
+          if (grid[kgrid] >= clipvalue) {
+            sdata[ndata++] = (float)(wbnd[0] + dx * i - bdata_origin_x);
+            sdata[ndata++] = (float)(wbnd[2] + dy * j - bdata_origin_y);
+            sdata[ndata++] = (float)border;
+          }
+          j = gydim - 1;
+          kgrid = i * gydim + j;
+          if (grid[kgrid] >= clipvalue) {
+            sdata[ndata++] = (float)(wbnd[0] + dx * i - bdata_origin_x);
+            sdata[ndata++] = (float)(wbnd[2] + dy * j - bdata_origin_y);
+            sdata[ndata++] = (float)border;
+          }
         }
-        i = gxdim - 1;
-        kgrid = i * gydim + j;
-        if (grid[kgrid] >= clipvalue) {
-          sdata[ndata++] = (float)(wbnd[0] + dx * i - bdata_origin_x);
-          sdata[ndata++] = (float)(wbnd[2] + dy * j - bdata_origin_y);
-          sdata[ndata++] = (float)border;
+        for (int j = 1; j < gydim - 1; j++) {
+          int i = 0;
+          kgrid = i * gydim + j;
+          if (grid[kgrid] >= clipvalue) {
+            sdata[ndata++] = (float)(wbnd[0] + dx * i - bdata_origin_x);
+            sdata[ndata++] = (float)(wbnd[2] + dy * j - bdata_origin_y);
+            sdata[ndata++] = (float)border;
+          }
+          i = gxdim - 1;
+          kgrid = i * gydim + j;
+          if (grid[kgrid] >= clipvalue) {
+            sdata[ndata++] = (float)(wbnd[0] + dx * i - bdata_origin_x);
+            sdata[ndata++] = (float)(wbnd[2] + dy * j - bdata_origin_y);
+            sdata[ndata++] = (float)border;
+          }
         }
       }
+      ndata = ndata / 3;
+
+      /* do the interpolation */
+      float cay = (float)tension;
+      float xmin = (float)(wbnd[0] - 0.5 * dx - bdata_origin_x);
+      float ymin = (float)(wbnd[2] - 0.5 * dy - bdata_origin_y);
+      float ddx = (float)dx;
+      float ddy = (float)dy;
+      fprintf(outfp, "\nDoing Zgrid spline interpolation with %d data points...\n", ndata);
+      /*for (i=0;i<ndata/3;i++)
+      {
+      if (sdata[3*i+2]>2000.0)
+      fprintf(stderr,"%d %f\n",i,sdata[3*i+2]);
+      }*/
+      if (clipmode == MBGRID_INTERP_ALL)
+        clip = std::max(gxdim, gydim);
+      mb_zgrid(sgrid, &gxdim, &gydim, &xmin, &ymin, &ddx, &ddy, sdata, &ndata, work1, work2, work3, &cay, &clip);
     }
-    ndata = ndata / 3;
-
-    /* do the interpolation */
-    float cay = (float)tension;
-    float xmin = (float)(wbnd[0] - 0.5 * dx - bdata_origin_x);
-    float ymin = (float)(wbnd[2] - 0.5 * dy - bdata_origin_y);
-    float ddx = (float)dx;
-    float ddy = (float)dy;
-    fprintf(outfp, "\nDoing Zgrid spline interpolation with %d data points...\n", ndata);
-    /*for (i=0;i<ndata/3;i++)
-    {
-    if (sdata[3*i+2]>2000.0)
-    fprintf(stderr,"%d %f\n",i,sdata[3*i+2]);
-    }*/
-    if (clipmode == MBGRID_INTERP_ALL)
-      clip = std::max(gxdim, gydim);
-    mb_zgrid(sgrid, &gxdim, &gydim, &xmin, &ymin, &ddx, &ddy, sdata, &ndata, work1, work2, work3, &cay, &clip);
-#endif
 
     if (clipmode == MBGRID_INTERP_GAP)
       fprintf(outfp, "Applying spline interpolation to fill gaps of %d cells or less...\n", clip);
@@ -5209,11 +7105,7 @@ int main(int argc, char **argv) {
       for (int i = 0; i < gxdim; i++)
         for (int j = 0; j < gydim; j++) {
           kgrid = i * gydim + j;
-#ifdef USESURFACE
-          kint = i + (gydim - j - 1) * gxdim;
-#else
-          kint = i + j * gxdim;
-#endif
+          kint = use_surface ? i + (gydim - j - 1) * gxdim : i + j * gxdim;
           smask[kgrid] = false;
           if (grid[kgrid] >= clipvalue && sgrid[kint] < zflag) {
             /* initialize direction mask of search */
@@ -5290,11 +7182,7 @@ int main(int argc, char **argv) {
       for (int i = 0; i < gxdim; i++)
         for (int j = 0; j < gydim; j++) {
           kgrid = i * gydim + j;
-#ifdef USESURFACE
-          kint = i + (gydim - j - 1) * gxdim;
-#else
-          kint = i + j * gxdim;
-#endif
+          kint = use_surface ? i + (gydim - j - 1) * gxdim : i + j * gxdim;
           if (smask[kgrid] == true) {
             grid[kgrid] = sgrid[kint];
             nbinspline++;
@@ -5308,11 +7196,7 @@ int main(int argc, char **argv) {
       for (int i = 0; i < gxdim; i++)
         for (int j = 0; j < gydim; j++) {
           kgrid = i * gydim + j;
-#ifdef USESURFACE
-          kint = i + (gydim - j - 1) * gxdim;
-#else
-          kint = i + j * gxdim;
-#endif
+          kint = use_surface ? i + (gydim - j - 1) * gxdim : i + j * gxdim;
 
           smask[kgrid] = false;
           if (grid[kgrid] >= clipvalue && sgrid[kint] < zflag) {
@@ -5357,11 +7241,7 @@ int main(int argc, char **argv) {
       for (int i = 0; i < gxdim; i++)
         for (int j = 0; j < gydim; j++) {
           kgrid = i * gydim + j;
-#ifdef USESURFACE
-          kint = i + (gydim - j - 1) * gxdim;
-#else
-          kint = i + j * gxdim;
-#endif
+          kint = use_surface ? i + (gydim - j - 1) * gxdim : i + j * gxdim;
           if (smask[kgrid] == true) {
             grid[kgrid] = sgrid[kint];
             nbinspline++;
@@ -5375,11 +7255,7 @@ int main(int argc, char **argv) {
       for (int i = 0; i < gxdim; i++)
         for (int j = 0; j < gydim; j++) {
           kgrid = i * gydim + j;
-#ifdef USESURFACE
-          kint = i + (gydim - j - 1) * gxdim;
-#else
-          kint = i + j * gxdim;
-#endif
+          kint = use_surface ? i + (gydim - j - 1) * gxdim : i + j * gxdim;
           if (grid[kgrid] >= clipvalue && sgrid[kint] < zflag) {
             grid[kgrid] = sgrid[kint];
             nbinspline++;
@@ -5388,16 +7264,17 @@ int main(int argc, char **argv) {
     }
 
 /* deallocate the interpolation arrays */
-#ifdef USESURFACE
-    mb_freed(verbose, __FILE__, __LINE__, (void **)&sxdata, &error);
-    mb_freed(verbose, __FILE__, __LINE__, (void **)&sydata, &error);
-    mb_freed(verbose, __FILE__, __LINE__, (void **)&szdata, &error);
-#else
-    mb_freed(verbose, __FILE__, __LINE__, (void **)&sdata, &error);
-    mb_freed(verbose, __FILE__, __LINE__, (void **)&work1, &error);
-    mb_freed(verbose, __FILE__, __LINE__, (void **)&work2, &error);
-    mb_freed(verbose, __FILE__, __LINE__, (void **)&work3, &error);
-#endif
+    if (use_surface) {
+      mb_freed(verbose, __FILE__, __LINE__, (void **)&sxdata, &error);
+      mb_freed(verbose, __FILE__, __LINE__, (void **)&sydata, &error);
+      mb_freed(verbose, __FILE__, __LINE__, (void **)&szdata, &error);
+    }
+    else {
+      mb_freed(verbose, __FILE__, __LINE__, (void **)&sdata, &error);
+      mb_freed(verbose, __FILE__, __LINE__, (void **)&work1, &error);
+      mb_freed(verbose, __FILE__, __LINE__, (void **)&work2, &error);
+      mb_freed(verbose, __FILE__, __LINE__, (void **)&work3, &error);
+    }
     mb_freed(verbose, __FILE__, __LINE__, (void **)&smask, &error);
     mb_freed(verbose, __FILE__, __LINE__, (void **)&sgrid, &error);
   }
@@ -5405,58 +7282,60 @@ int main(int argc, char **argv) {
 
   /* if grdrasterid set and background data previously read in
       then interpolate it onto internal grid */
-  if (grdrasterid != 0 && nbackground > 0) {
+  if (tile_size == 0 && grdrasterid != 0 && nbackground > 0) {
 
 /* allocate and initialize grid and work arrays */
-#ifdef USESURFACE
-    status = mb_mallocd(verbose, __FILE__, __LINE__, gxdim * gydim * sizeof(float), (void **)&sgrid, &error);
-    if (error != MB_ERROR_NO_ERROR) {
-      char *message = nullptr;
-      mb_error(verbose, MB_ERROR_MEMORY_FAIL, &message);
-      fprintf(outfp, "\nMBIO Error allocating background data array:\n%s\n", message);
-      fprintf(outfp, "\nProgram <%s> Terminated\n", program_name);
-      mb_memory_clear(verbose, &memclear_error);
-      exit(error);
+    if (use_surface) {
+      status = mb_mallocd(verbose, __FILE__, __LINE__, gxdim * gydim * sizeof(float), (void **)&sgrid, &error);
+      if (error != MB_ERROR_NO_ERROR) {
+        char *message = nullptr;
+        mb_error(verbose, MB_ERROR_MEMORY_FAIL, &message);
+        fprintf(outfp, "\nMBIO Error allocating background data array:\n%s\n", message);
+        fprintf(outfp, "\nProgram <%s> Terminated\n", program_name);
+        mb_memory_clear(verbose, &memclear_error);
+        exit(error);
+      }
+      memset((char *)sgrid, 0, gxdim * gydim * sizeof(float));
     }
-    memset((char *)sgrid, 0, gxdim * gydim * sizeof(float));
-#else
-    status = mb_mallocd(verbose, __FILE__, __LINE__, gxdim * gydim * sizeof(float), (void **)&sgrid, &error);
-    if (status == MB_SUCCESS)
-      status = mb_mallocd(verbose, __FILE__, __LINE__, nbackground * sizeof(float), (void **)&work1, &error);
-    if (status == MB_SUCCESS)
-      status = mb_mallocd(verbose, __FILE__, __LINE__, nbackground * sizeof(int), (void **)&work2, &error);
-    if (status == MB_SUCCESS)
-      status = mb_mallocd(verbose, __FILE__, __LINE__, (gxdim + gydim) * sizeof(int), (void **)&work3, &error);
-    if (error != MB_ERROR_NO_ERROR) {
-      char *message = nullptr;
-      mb_error(verbose, MB_ERROR_MEMORY_FAIL, &message);
-      fprintf(outfp, "\nMBIO Error allocating background interpolation work arrays:\n%s\n", message);
-      fprintf(outfp, "\nProgram <%s> Terminated\n", program_name);
-      mb_memory_clear(verbose, &memclear_error);
-      exit(error);
+    else {
+      status = mb_mallocd(verbose, __FILE__, __LINE__, gxdim * gydim * sizeof(float), (void **)&sgrid, &error);
+      if (status == MB_SUCCESS)
+        status = mb_mallocd(verbose, __FILE__, __LINE__, nbackground * sizeof(float), (void **)&work1, &error);
+      if (status == MB_SUCCESS)
+        status = mb_mallocd(verbose, __FILE__, __LINE__, nbackground * sizeof(int), (void **)&work2, &error);
+      if (status == MB_SUCCESS)
+        status = mb_mallocd(verbose, __FILE__, __LINE__, (gxdim + gydim) * sizeof(int), (void **)&work3, &error);
+      if (error != MB_ERROR_NO_ERROR) {
+        char *message = nullptr;
+        mb_error(verbose, MB_ERROR_MEMORY_FAIL, &message);
+        fprintf(outfp, "\nMBIO Error allocating background interpolation work arrays:\n%s\n", message);
+        fprintf(outfp, "\nProgram <%s> Terminated\n", program_name);
+        mb_memory_clear(verbose, &memclear_error);
+        exit(error);
+      }
+      memset((char *)sgrid, 0, gxdim * gydim * sizeof(float));
+      memset((char *)work1, 0, nbackground * sizeof(float));
+      memset((char *)work2, 0, nbackground * sizeof(int));
+      memset((char *)work3, 0, (gxdim + gydim) * sizeof(int));
     }
-    memset((char *)sgrid, 0, gxdim * gydim * sizeof(float));
-    memset((char *)work1, 0, nbackground * sizeof(float));
-    memset((char *)work2, 0, nbackground * sizeof(int));
-    memset((char *)work3, 0, (gxdim + gydim) * sizeof(int));
-#endif
 
     /* do the interpolation */
     fprintf(outfp, "\nDoing spline interpolation with %d background points...\n", nbackground);
-#ifdef USESURFACE
-    mb_surface(verbose, nbackground, bxdata, bydata, bzdata, (float)(wbnd[0] - bdata_origin_x),
-               (float)(wbnd[1] - bdata_origin_x), (float)(wbnd[2] - bdata_origin_y), (float)(wbnd[3] - bdata_origin_y), dx,
-               dy, tension, sgrid);
-#else
-    float cay = (float)tension;
-    float xmin = (float)(wbnd[0] - 0.5 * dx - bdata_origin_x);
-    float ymin = (float)(wbnd[2] - 0.5 * dy - bdata_origin_y);
-    float ddx = (float)dx;
-    float ddy = (float)dy;
-    clip = std::max(gxdim, gydim);
-    fprintf(outfp, "\nDoing Zgrid spline interpolation with %d background points...\n", nbackground);
-    mb_zgrid(sgrid, &gxdim, &gydim, &xmin, &ymin, &ddx, &ddy, bdata, &nbackground, work1, work2, work3, &cay, &clip);
-#endif
+    if (use_surface) {
+      mb_surface(verbose, nbackground, bxdata, bydata, bzdata, (float)(wbnd[0] - bdata_origin_x),
+                 (float)(wbnd[1] - bdata_origin_x), (float)(wbnd[2] - bdata_origin_y), (float)(wbnd[3] - bdata_origin_y), dx,
+                 dy, tension, sgrid);
+    }
+    else {
+      float cay = (float)tension;
+      float xmin = (float)(wbnd[0] - 0.5 * dx - bdata_origin_x);
+      float ymin = (float)(wbnd[2] - 0.5 * dy - bdata_origin_y);
+      float ddx = (float)dx;
+      float ddy = (float)dy;
+      clip = std::max(gxdim, gydim);
+      fprintf(outfp, "\nDoing Zgrid spline interpolation with %d background points...\n", nbackground);
+      mb_zgrid(sgrid, &gxdim, &gydim, &xmin, &ymin, &ddx, &ddy, bdata, &nbackground, work1, work2, work3, &cay, &clip);
+    }
 
     /* translate the interpolation into the grid array
         - interpolate only to fill a data gap */
@@ -5464,75 +7343,76 @@ int main(int argc, char **argv) {
     for (int i = 0; i < gxdim; i++)
       for (int j = 0; j < gydim; j++) {
         kgrid = i * gydim + j;
-#ifdef USESURFACE
-        kint = i + (gydim - j - 1) * gxdim;
-#else
-        kint = i + j * gxdim;
-#endif
+        kint = use_surface ? i + (gydim - j - 1) * gxdim : i + j * gxdim;
         if (grid[kgrid] >= clipvalue && sgrid[kint] < zflag) {
           grid[kgrid] = sgrid[kint];
           nbinbackground++;
         }
       }
-#ifdef USESURFACE
-    mb_freed(verbose, __FILE__, __LINE__, (void **)&bxdata, &error);
-    mb_freed(verbose, __FILE__, __LINE__, (void **)&bydata, &error);
-    mb_freed(verbose, __FILE__, __LINE__, (void **)&bzdata, &error);
-#else
-    mb_freed(verbose, __FILE__, __LINE__, (void **)&bdata, &error);
-    mb_freed(verbose, __FILE__, __LINE__, (void **)&work1, &error);
-    mb_freed(verbose, __FILE__, __LINE__, (void **)&work2, &error);
-    mb_freed(verbose, __FILE__, __LINE__, (void **)&work3, &error);
-#endif
+    if (use_surface) {
+      mb_freed(verbose, __FILE__, __LINE__, (void **)&bxdata, &error);
+      mb_freed(verbose, __FILE__, __LINE__, (void **)&bydata, &error);
+      mb_freed(verbose, __FILE__, __LINE__, (void **)&bzdata, &error);
+    }
+    else {
+      mb_freed(verbose, __FILE__, __LINE__, (void **)&bdata, &error);
+      mb_freed(verbose, __FILE__, __LINE__, (void **)&work1, &error);
+      mb_freed(verbose, __FILE__, __LINE__, (void **)&work2, &error);
+      mb_freed(verbose, __FILE__, __LINE__, (void **)&work3, &error);
+    }
     mb_freed(verbose, __FILE__, __LINE__, (void **)&sgrid, &error);
   }
 /* -------------------------------------------------------------------------- */
 
-  /* get min max of data */
-  zclip = clipvalue;
-  zmin = zclip;
-  zmax = zclip;
-  for (int i = 0; i < gxdim; i++)
-    for (int j = 0; j < gydim; j++) {
-      kgrid = i * gydim + j;
-      if (zmin == zclip && grid[kgrid] < zclip)
-        zmin = grid[kgrid];
-      if (zmax == zclip && grid[kgrid] < zclip)
-        zmax = grid[kgrid];
-      if (grid[kgrid] < zmin && grid[kgrid] < zclip)
-        zmin = grid[kgrid];
-      if (grid[kgrid] > zmax && grid[kgrid] < zclip)
-        zmax = grid[kgrid];
-    }
-  if (zmin == zclip)
-    zmin = 0.0;
-  if (zmax == zclip)
-    zmax = 0.0;
+  /* get statistics of the grid, which are instead reduced from the tiles
+      when gridding out of core */
+  if (tile_size == 0) {
+    /* get min max of data */
+    zclip = clipvalue;
+    zmin = zclip;
+    zmax = zclip;
+    for (int i = 0; i < gxdim; i++)
+      for (int j = 0; j < gydim; j++) {
+        kgrid = i * gydim + j;
+        if (zmin == zclip && grid[kgrid] < zclip)
+          zmin = grid[kgrid];
+        if (zmax == zclip && grid[kgrid] < zclip)
+          zmax = grid[kgrid];
+        if (grid[kgrid] < zmin && grid[kgrid] < zclip)
+          zmin = grid[kgrid];
+        if (grid[kgrid] > zmax && grid[kgrid] < zclip)
+          zmax = grid[kgrid];
+      }
+    if (zmin == zclip)
+      zmin = 0.0;
+    if (zmax == zclip)
+      zmax = 0.0;
 
-  /* get min max of data distribution */
-  nmax = 0;
-  for (int i = 0; i < gxdim; i++)
-    for (int j = 0; j < gydim; j++) {
-      kgrid = i * gydim + j;
-      if (cnt[kgrid] > nmax)
-        nmax = cnt[kgrid];
-    }
-
-  /* get min max of standard deviation */
-  smin = 0.0;
-  smax = 0.0;
-  for (int i = 0; i < gxdim; i++)
-    for (int j = 0; j < gydim; j++) {
-      kgrid = i * gydim + j;
-      if (smin == 0.0 && cnt[kgrid] > 0)
-        smin = sigma[kgrid];
-      if (smax == 0.0 && cnt[kgrid] > 0)
-        smax = sigma[kgrid];
-      if (sigma[kgrid] < smin && cnt[kgrid] > 0)
-        smin = sigma[kgrid];
-      if (sigma[kgrid] > smax && cnt[kgrid] > 0)
-        smax = sigma[kgrid];
-    }
+    /* get min max of data distribution */
+    nmax = 0;
+    for (int i = 0; i < gxdim; i++)
+      for (int j = 0; j < gydim; j++) {
+        kgrid = i * gydim + j;
+        if (cnt[kgrid] > nmax)
+          nmax = cnt[kgrid];
+      }
+
+    /* get min max of standard deviation */
+    smin = 0.0;
+    smax = 0.0;
+    for (int i = 0; i < gxdim; i++)
+      for (int j = 0; j < gydim; j++) {
+        kgrid = i * gydim + j;
+        if (smin == 0.0 && cnt[kgrid] > 0)
+          smin = sigma[kgrid];
+        if (smax == 0.0 && cnt[kgrid] > 0)
+          smax = sigma[kgrid];
+        if (sigma[kgrid] < smin && cnt[kgrid] > 0)
+          smin = sigma[kgrid];
+        if (sigma[kgrid] > smax && cnt[kgrid] > 0)
+          smax = sigma[kgrid];
+      }
+  }
   nbinzero = gxdim * gydim - nbinset - nbinspline - nbinbackground;
   fprintf(outfp, "\nTotal number of bins:            %d\n", gxdim * gydim);
   fprintf(outfp, "Bins set using data:             %d\n", nbinset);
@@ -5560,15 +7440,19 @@ int main(int argc, char **argv) {
   /* write first output file */
   if (verbose > 0)
     fprintf(outfp, "\nOutputting results...\n");
-  for (int i = 0; i < xdim; i++)
-    for (int j = 0; j < ydim; j++) {
-      kgrid = (i + offx) * gydim + (j + offy);
-      kout = i * ydim + j;
-      output[kout] = (float)grid[kgrid];
-      if (gridkind != MBGRID_ASCII && gridkind != MBGRID_ARCASCII && grid[kgrid] >= clipvalue) {
-        output[kout] = outclipvalue;
+  if (tile_size == 0) {
+    for (int i = 0; i < xdim; i++)
+      for (int j = 0; j < ydim; j++) {
+        kgrid = (i + offx) * gydim + (j + offy);
+        kout = i * ydim + j;
+        output[kout] = (float)grid[kgrid];
+        if (gridkind != MBGRID_ASCII && gridkind != MBGRID_ARCASCII && grid[kgrid] >= clipvalue) {
+          output[kout] = outclipvalue;
+        }
       }
-    }
+  }
+  else
+    output = tiling.zout;
   if (gridkind == MBGRID_ASCII) {
     strcpy(ofile, fileroot);
     strcat(ofile, ".asc");
@@ -5609,16 +7493,20 @@ int main(int argc, char **argv) {
 
   /* write second output file */
   if (more) {
-    for (int i = 0; i < xdim; i++)
-      for (int j = 0; j < ydim; j++) {
-        kgrid = (i + offx) * gydim + (j + offy);
-        kout = i * ydim + j;
-        output[kout] = (float)cnt[kgrid];
-        if (output[kout] < 0.0)
-          output[kout] = 0.0;
-        if (gridkind != MBGRID_ASCII && gridkind != MBGRID_ARCASCII && cnt[kgrid] <= 0)
-          output[kout] = outclipvalue;
-      }
+    if (tile_size == 0) {
+      for (int i = 0; i < xdim; i++)
+        for (int j = 0; j < ydim; j++) {
+          kgrid = (i + offx) * gydim + (j + offy);
+          kout = i * ydim + j;
+          output[kout] = (float)cnt[kgrid];
+          if (output[kout] < 0.0)
+            output[kout] = 0.0;
+          if (gridkind != MBGRID_ASCII && gridkind != MBGRID_ARCASCII && cnt[kgrid] <= 0)
+            output[kout] = outclipvalue;
+        }
+    }
+    else
+      output = tiling.nout;
     if (gridkind == MBGRID_ASCII) {
       strcpy(ofile, fileroot);
       strcat(ofile, "_num.asc");
@@ -5656,16 +7544,20 @@ int main(int argc, char **argv) {
     }
 
     /* write third output file */
-    for (int i = 0; i < xdim; i++)
-      for (int j = 0; j < ydim; j++) {
-        kgrid = (i + offx) * gydim + (j + offy);
-        kout = i * ydim + j;
-        output[kout] = (float)sigma[kgrid];
-        if (output[kout] < 0.0)
-          output[kout] = 0.0;
-        if (gridkind != MBGRID_ASCII && gridkind != MBGRID_ARCASCII && cnt[kgrid] <= 0)
-          output[kout] = outclipvalue;
-      }
+    if (tile_size == 0) {
+      for (int i = 0; i < xdim; i++)
+        for (int j = 0; j < ydim; j++) {
+          kgrid = (i + offx) * gydim + (j + offy);
+          kout = i * ydim + j;
+          output[kout] = (float)sigma[kgrid];
+          if (output[kout] < 0.0)
+            output[kout] = 0.0;
+          if (gridkind != MBGRID_ASCII && gridkind != MBGRID_ARCASCII && cnt[kgrid] <= 0)
+            output[kout] = outclipvalue;
+        }
+    }
+    else
+      output = tiling.sout;
     if (gridkind == MBGRID_ASCII) {
       strcpy(ofile, fileroot);
       strcat(ofile, "_sd.asc");
@@ -5703,6 +7595,49 @@ int main(int argc, char **argv) {
     }
   }
 
+  /* write percentile output files */
+  for (int ip = 0; ip < npercentile; ip++) {
+    for (int i = 0; i < xdim; i++)
+      for (int j = 0; j < ydim; j++) {
+        kgrid = (i + offx) * gydim + (j + offy);
+        kout = i * ydim + j;
+        output[kout] = pgrid[ip][kgrid];
+        if (gridkind != MBGRID_ASCII && gridkind != MBGRID_ARCASCII && cnt[kgrid] <= 0)
+          output[kout] = outclipvalue;
+      }
+    if (gridkind == MBGRID_ASCII) {
+      snprintf(ofile, sizeof(ofile), "%s_p%g.asc", fileroot, percentile[ip]);
+      status = write_ascii(verbose, ofile, output, xdim, ydim, gbnd[0], gbnd[1], gbnd[2], gbnd[3], dx, dy, &error);
+    }
+    else if (gridkind == MBGRID_ARCASCII) {
+      snprintf(ofile, sizeof(ofile), "%s_p%g.asc", fileroot, percentile[ip]);
+      status = write_arcascii(verbose, ofile, output, xdim, ydim, gbnd[0], gbnd[1], gbnd[2], gbnd[3], dx, dy, outclipvalue,
+                              &error);
+    }
+    else if (gridkind == MBGRID_OLDGRD) {
+      snprintf(ofile, sizeof(ofile), "%s_p%g.grd1", fileroot, percentile[ip]);
+      status = write_oldgrd(verbose, ofile, output, xdim, ydim, gbnd[0], gbnd[1], gbnd[2], gbnd[3], dx, dy, &error);
+    }
+    else if (gridkind == MBGRID_CDFGRD) {
+      snprintf(ofile, sizeof(ofile), "%s_p%g.grd", fileroot, percentile[ip]);
+      status = mb_write_gmt_grd(verbose, ofile, output, outclipvalue, xdim, ydim, gbnd[0], gbnd[1], gbnd[2], gbnd[3], zmin,
+                                zmax, dx, dy, xlabel, ylabel, zlabel, title, projection_id, argc, argv, &error);
+    }
+    else if (gridkind == MBGRID_GMTGRD) {
+      snprintf(ofile, sizeof(ofile), "%s_p%g.grd%s", fileroot, percentile[ip], gridkindstring);
+      status = mb_write_gmt_grd(verbose, ofile, output, outclipvalue, xdim, ydim, gbnd[0], gbnd[1], gbnd[2], gbnd[3], zmin,
+                                zmax, dx, dy, xlabel, ylabel, zlabel, title, projection_id, argc, argv, &error);
+    }
+    if (status != MB_SUCCESS) {
+      char *message = nullptr;
+      mb_error(verbose, error, &message);
+      fprintf(outfp, "\nError writing output file: %s\n%s\n", ofile, message);
+      fprintf(outfp, "\nProgram <%s> Terminated\n", program_name);
+      mb_memory_clear(verbose, &memclear_error);
+      exit(error);
+    }
+  }
+
   /* deallocate arrays */
   mb_freed(verbose, __FILE__, __LINE__, (void **)&grid, &error);
   mb_freed(verbose, __FILE__, __LINE__, (void **)&norm, &error);
@@ -5710,8 +7645,20 @@ int main(int argc, char **argv) {
   mb_freed(verbose, __FILE__, __LINE__, (void **)&cnt, &error);
   mb_freed(verbose, __FILE__, __LINE__, (void **)&sigma, &error);
   mb_freed(verbose, __FILE__, __LINE__, (void **)&firsttime, &error);
-  mb_freed(verbose, __FILE__, __LINE__, (void **)&output, &error);
+  if (tile_size > 0) {
+    const size_t outsize = (size_t)xdim * (size_t)ydim * sizeof(float);
+    munmap(tiling.zout, outsize);
+    if (tiling.nout != nullptr)
+      munmap(tiling.nout, outsize);
+    if (tiling.sout != nullptr)
+      munmap(tiling.sout, outsize);
+    output = nullptr;
+  }
+  else
+    mb_freed(verbose, __FILE__, __LINE__, (void **)&output, &error);
   mb_freed(verbose, __FILE__, __LINE__, (void **)&minormax, &error);
+  for (int ip = 0; ip < npercentile; ip++)
+    mb_freed(verbose, __FILE__, __LINE__, (void **)&pgrid[ip], &error);
 
   /* deallocate projection */
   if (use_projection)
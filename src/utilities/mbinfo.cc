@@ -45,9 +45,11 @@
 #include <unistd.h>
 
 #include "mb_define.h"
+#include "mb_format.h"
 #include "mb_info.h"
 #include "mb_io.h"
 #include "mb_status.h"
+#include "mbsys_ldeoih.h"
 
 constexpr int MBINFO_MAXPINGS = 50;
 
@@ -72,8 +74,275 @@ typedef enum {
 constexpr char program_name[] = "MBINFO";
 constexpr char usage_message[] =
     "mbinfo [-Byr/mo/da/hr/mn/sc -C "
-    "-Eyr/mo/da/hr/mn/sc -Fformat -G -Ifile -Llonflip -Mnx/ny "
-    "-N -O -Ppings -Rw/e/s/n -Sspeed -W -V -H -XinfFormat]";
+    "-Eyr/mo/da/hr/mn/sc -Fformat -G -Ifile -K -Llonflip -Mnx/ny "
+    "-N -O -Ppings -Rw/e/s/n -Sspeed -W -V -H -XinfFormat -Y]";
+
+/* fnv and fbt ancillary files written from the same records read to
+   generate the statistics (-Y) */
+struct ancillary {
+  char fnvfile[MB_PATH_MAXLINE + 10];
+  char fbtfile[MB_PATH_MAXLINE + 10];
+  FILE *fnvfp;
+  void *fbtmbio_ptr;
+  char *beamflag;
+  double *bath;
+  double *amp;
+  double *bathacrosstrack;
+  double *bathalongtrack;
+  double *ss;
+  double *ssacrosstrack;
+  double *ssalongtrack;
+};
+
+/*--------------------------------------------------------------------*/
+/* open the fnv and fbt files appropriate to the format being read - the
+   files are written under temporary names and only renamed into place
+   once the whole swath file has been read */
+int mbinfo_ancillary_open(int verbose, void *mbio_ptr, const char *path, int format,
+                          struct ancillary *anc, int *error) {
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBinfo function <%s> called\n", __func__);
+    fprintf(stderr, "dbg2  Input arguments:\n");
+    fprintf(stderr, "dbg2       verbose:         %d\n", verbose);
+    fprintf(stderr, "dbg2       mbio_ptr:        %p\n", (void *)mbio_ptr);
+    fprintf(stderr, "dbg2       path:            %s\n", path);
+    fprintf(stderr, "dbg2       format:          %d\n", format);
+  }
+
+  memset(anc, 0, sizeof(struct ancillary));
+  int status = MB_SUCCESS;
+
+  if (mb_should_make_fnv(verbose, format)) {
+    snprintf(anc->fnvfile, sizeof(anc->fnvfile), "%s.fnv", path);
+    char tmpfile[MB_PATH_MAXLINE + 20];
+    snprintf(tmpfile, sizeof(tmpfile), "%s.tmp", anc->fnvfile);
+    if ((anc->fnvfp = fopen(tmpfile, "w")) == nullptr) {
+      *error = MB_ERROR_OPEN_FAIL;
+      status = MB_FAILURE;
+    }
+    else {
+      fprintf(anc->fnvfp, "## <yyyy mm dd hh mm ss.ssssss> <epoch seconds> "
+                          "<longitude (deg)> <latitude (deg)> <heading (deg)> <speed (km/hr)> "
+                          "<draft (m)> <roll (deg)> <pitch (deg)> <heave (m)> <portlon (deg)> "
+                          "<portlat (deg)> <stbdlon (deg)> <stbdlat (deg)>\n");
+    }
+  }
+
+  if (status == MB_SUCCESS && mb_should_make_fbt(verbose, format)) {
+    snprintf(anc->fbtfile, sizeof(anc->fbtfile), "%s.fbt", path);
+    char tmpfile[MB_PATH_MAXLINE + 20];
+    snprintf(tmpfile, sizeof(tmpfile), "%s.tmp", anc->fbtfile);
+    int beams_bath, beams_amp, pixels_ss;
+    status = mb_write_init(verbose, tmpfile, MBF_MBLDEOIH, &anc->fbtmbio_ptr, &beams_bath, &beams_amp, &pixels_ss, error);
+    if (status == MB_SUCCESS) {
+      /* use the fbt format version set in .mbio_defaults, as mbcopy does */
+      int fbtversion;
+      mb_fbtversion(verbose, &fbtversion);
+      ((struct mb_io_struct *)anc->fbtmbio_ptr)->save1 = fbtversion;
+    }
+  }
+
+  /* arrays for the acrosstrack and alongtrack distances that mb_read()
+      does not return */
+  if (status == MB_SUCCESS && (anc->fnvfp != nullptr || anc->fbtmbio_ptr != nullptr)) {
+    status &= mb_register_array(verbose, mbio_ptr, MB_MEM_TYPE_BATHYMETRY, sizeof(char), (void **)&anc->beamflag, error);
+    status &= mb_register_array(verbose, mbio_ptr, MB_MEM_TYPE_BATHYMETRY, sizeof(double), (void **)&anc->bath, error);
+    status &= mb_register_array(verbose, mbio_ptr, MB_MEM_TYPE_AMPLITUDE, sizeof(double), (void **)&anc->amp, error);
+    status &= mb_register_array(verbose, mbio_ptr, MB_MEM_TYPE_BATHYMETRY, sizeof(double), (void **)&anc->bathacrosstrack, error);
+    status &= mb_register_array(verbose, mbio_ptr, MB_MEM_TYPE_BATHYMETRY, sizeof(double), (void **)&anc->bathalongtrack, error);
+    status &= mb_register_array(verbose, mbio_ptr, MB_MEM_TYPE_SIDESCAN, sizeof(double), (void **)&anc->ss, error);
+    status &= mb_register_array(verbose, mbio_ptr, MB_MEM_TYPE_SIDESCAN, sizeof(double), (void **)&anc->ssacrosstrack, error);
+    status &= mb_register_array(verbose, mbio_ptr, MB_MEM_TYPE_SIDESCAN, sizeof(double), (void **)&anc->ssalongtrack, error);
+  }
+
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBinfo function <%s> completed\n", __func__);
+    fprintf(stderr, "dbg2  Return values:\n");
+    fprintf(stderr, "dbg2       fnvfp:           %p\n", (void *)anc->fnvfp);
+    fprintf(stderr, "dbg2       fbtmbio_ptr:     %p\n", (void *)anc->fbtmbio_ptr);
+    fprintf(stderr, "dbg2       error:           %d\n", *error);
+    fprintf(stderr, "dbg2  Return status:\n");
+    fprintf(stderr, "dbg2       status:          %d\n", status);
+  }
+
+  return (status);
+}
+
+/*--------------------------------------------------------------------*/
+/* write the record just read to the fnv and fbt files - the fnv lines
+   match "mblist -O tMXYHScRPr=X=Y+X+Y -UN" and the fbt records match
+   "mbcopy -D" output in format 71 */
+int mbinfo_ancillary_write(int verbose, void *mbio_ptr, struct ancillary *anc, int kind, int time_i[7],
+                           double time_d, double navlon, double navlat, double speed, double heading,
+                           double altitude, double sensordepth, char *comment, int *error) {
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBinfo function <%s> called\n", __func__);
+    fprintf(stderr, "dbg2  Input arguments:\n");
+    fprintf(stderr, "dbg2       verbose:         %d\n", verbose);
+    fprintf(stderr, "dbg2       mbio_ptr:        %p\n", (void *)mbio_ptr);
+    fprintf(stderr, "dbg2       kind:            %d\n", kind);
+    fprintf(stderr, "dbg2       time_d:          %f\n", time_d);
+    fprintf(stderr, "dbg2       navlon:          %f\n", navlon);
+    fprintf(stderr, "dbg2       navlat:          %f\n", navlat);
+  }
+
+  struct mb_io_struct *mb_io_ptr = (struct mb_io_struct *)mbio_ptr;
+  void *store_ptr = nullptr;
+  int status = mb_get_store(verbose, mbio_ptr, &store_ptr, error);
+
+  if (status == MB_SUCCESS && kind == MB_DATA_DATA) {
+    int xkind;
+    int xtime_i[7];
+    double xtime_d;
+    double xnavlon;
+    double xnavlat;
+    double xspeed;
+    double xheading;
+    int nbath;
+    int namp;
+    int nss;
+    char xcomment[MB_COMMENT_MAXLINE];
+    double draft;
+    double roll;
+    double pitch;
+    double heave;
+    status = mb_extract(verbose, mbio_ptr, store_ptr, &xkind, xtime_i, &xtime_d, &xnavlon, &xnavlat, &xspeed, &xheading,
+                        &nbath, &namp, &nss, anc->beamflag, anc->bath, anc->amp, anc->bathacrosstrack, anc->bathalongtrack,
+                        anc->ss, anc->ssacrosstrack, anc->ssalongtrack, xcomment, error);
+    if (status == MB_SUCCESS)
+      status = mb_extract_nav(verbose, mbio_ptr, store_ptr, &xkind, xtime_i, &xtime_d, &xnavlon, &xnavlat, &xspeed,
+                              &xheading, &draft, &roll, &pitch, &heave, error);
+
+    /* fnv line with the sensor navigation and the port and starboard
+        most good beam positions, skipping pings without navigation */
+    if (status == MB_SUCCESS && anc->fnvfp != nullptr && navlon != 0.0 && navlat != 0.0) {
+      int beam_port = 0;
+      int beam_vertical = 0;
+      int beam_stbd = 0;
+      int pixel_port = 0;
+      int pixel_vertical = 0;
+      int pixel_stbd = 0;
+      mb_swathbounds(verbose, true, nbath, nss, anc->beamflag, anc->bathacrosstrack, anc->ss, anc->ssacrosstrack,
+                     &beam_port, &beam_vertical, &beam_stbd, &pixel_port, &pixel_vertical, &pixel_stbd, error);
+      double mtodeglon;
+      double mtodeglat;
+      mb_coor_scale(verbose, navlat, &mtodeglon, &mtodeglat);
+      const double headingx = sin(DTR * heading);
+      const double headingy = cos(DTR * heading);
+      double portlon = navlon;
+      double portlat = navlat;
+      double stbdlon = navlon;
+      double stbdlat = navlat;
+      if (nbath > 0) {
+        portlon += headingy * mtodeglon * anc->bathacrosstrack[beam_port] + headingx * mtodeglon * anc->bathalongtrack[beam_port];
+        portlat += -headingx * mtodeglat * anc->bathacrosstrack[beam_port] + headingy * mtodeglat * anc->bathalongtrack[beam_port];
+        stbdlon += headingy * mtodeglon * anc->bathacrosstrack[beam_stbd] + headingx * mtodeglon * anc->bathalongtrack[beam_stbd];
+        stbdlat += -headingx * mtodeglat * anc->bathacrosstrack[beam_stbd] + headingy * mtodeglat * anc->bathalongtrack[beam_stbd];
+      }
+      const double seconds = time_i[5] + 1e-6 * time_i[6];
+      fprintf(anc->fnvfp,
+              "%.4d %.2d %.2d %.2d %.2d %09.6f\t%.6f\t%15.10f\t%15.10f\t%7.3f\t%6.3f\t%.4f\t%6.3f\t%6.3f\t%7.4f"
+              "\t%15.10f\t%15.10f\t%15.10f\t%15.10f\n",
+              time_i[0], time_i[1], time_i[2], time_i[3], time_i[4], seconds, time_d, navlon, navlat, heading, speed,
+              sensordepth, roll, pitch, heave, portlon, portlat, stbdlon, stbdlat);
+    }
+
+    /* bathymetry only fbt record */
+    if (status == MB_SUCCESS && anc->fbtmbio_ptr != nullptr) {
+      int sensorhead = 0;
+      int sonartype = MB_TOPOGRAPHY_TYPE_UNKNOWN;
+      int sensorhead_error = MB_ERROR_NO_ERROR;
+      mb_sensorhead(verbose, mbio_ptr, store_ptr, &sensorhead, &sensorhead_error);
+      mb_sonartype(verbose, mbio_ptr, store_ptr, &sonartype, &sensorhead_error);
+      struct mb_io_struct *fbt_io_ptr = (struct mb_io_struct *)anc->fbtmbio_ptr;
+      struct mbsys_ldeoih_struct *ostore = (struct mbsys_ldeoih_struct *)fbt_io_ptr->store_data;
+      ostore->sensorhead = sensorhead;
+      ostore->topo_type = sonartype;
+      ostore->beam_xwidth = mb_io_ptr->beamwidth_xtrack;
+      ostore->beam_lwidth = mb_io_ptr->beamwidth_ltrack;
+      ostore->kind = kind;
+      mb_insert_nav(verbose, anc->fbtmbio_ptr, (void *)ostore, time_i, time_d, navlon, navlat, speed, heading, draft, roll,
+                    pitch, heave, error);
+      mb_insert_altitude(verbose, anc->fbtmbio_ptr, (void *)ostore, draft, altitude, error);
+      status = mb_insert(verbose, anc->fbtmbio_ptr, (void *)ostore, kind, time_i, time_d, navlon, navlat, speed, heading,
+                         nbath, 0, 0, anc->beamflag, anc->bath, anc->amp, anc->bathacrosstrack, anc->bathalongtrack,
+                         anc->ss, anc->ssacrosstrack, anc->ssalongtrack, comment, error);
+      if (status == MB_SUCCESS)
+        status = mb_write_ping(verbose, anc->fbtmbio_ptr, (void *)ostore, error);
+    }
+  }
+
+  /* comments are copied to the fbt file */
+  else if (status == MB_SUCCESS && kind == MB_DATA_COMMENT && anc->fbtmbio_ptr != nullptr) {
+    struct mb_io_struct *fbt_io_ptr = (struct mb_io_struct *)anc->fbtmbio_ptr;
+    struct mbsys_ldeoih_struct *ostore = (struct mbsys_ldeoih_struct *)fbt_io_ptr->store_data;
+    ostore->kind = kind;
+    status = mb_insert(verbose, anc->fbtmbio_ptr, (void *)ostore, kind, time_i, time_d, navlon, navlat, speed, heading,
+                       0, 0, 0, anc->beamflag, anc->bath, anc->amp, anc->bathacrosstrack, anc->bathalongtrack,
+                       anc->ss, anc->ssacrosstrack, anc->ssalongtrack, comment, error);
+    if (status == MB_SUCCESS)
+      status = mb_write_ping(verbose, anc->fbtmbio_ptr, (void *)ostore, error);
+  }
+
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBinfo function <%s> completed\n", __func__);
+    fprintf(stderr, "dbg2  Return values:\n");
+    fprintf(stderr, "dbg2       error:           %d\n", *error);
+    fprintf(stderr, "dbg2  Return status:\n");
+    fprintf(stderr, "dbg2       status:          %d\n", status);
+  }
+
+  return (status);
+}
+
+/*--------------------------------------------------------------------*/
+/* close the fnv and fbt files, moving them into place if complete or
+   removing them if not */
+int mbinfo_ancillary_close(int verbose, struct ancillary *anc, bool complete, int *error) {
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBinfo function <%s> called\n", __func__);
+    fprintf(stderr, "dbg2  Input arguments:\n");
+    fprintf(stderr, "dbg2       verbose:         %d\n", verbose);
+    fprintf(stderr, "dbg2       complete:        %d\n", complete);
+  }
+
+  int status = MB_SUCCESS;
+  char tmpfile[MB_PATH_MAXLINE + 20];
+
+  if (anc->fnvfp != nullptr) {
+    snprintf(tmpfile, sizeof(tmpfile), "%s.tmp", anc->fnvfile);
+    if (fclose(anc->fnvfp) != 0)
+      complete = false;
+    anc->fnvfp = nullptr;
+    if (!complete || rename(tmpfile, anc->fnvfile) != 0) {
+      remove(tmpfile);
+      *error = MB_ERROR_WRITE_FAIL;
+      status = MB_FAILURE;
+    }
+  }
+
+  if (anc->fbtmbio_ptr != nullptr) {
+    snprintf(tmpfile, sizeof(tmpfile), "%s.tmp", anc->fbtfile);
+    int close_error = MB_ERROR_NO_ERROR;
+    if (mb_close(verbose, &anc->fbtmbio_ptr, &close_error) != MB_SUCCESS)
+      complete = false;
+    if (!complete || rename(tmpfile, anc->fbtfile) != 0) {
+      remove(tmpfile);
+      *error = MB_ERROR_WRITE_FAIL;
+      status = MB_FAILURE;
+    }
+  }
+
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBinfo function <%s> completed\n", __func__);
+    fprintf(stderr, "dbg2  Return values:\n");
+    fprintf(stderr, "dbg2       error:           %d\n", *error);
+    fprintf(stderr, "dbg2  Return status:\n");
+    fprintf(stderr, "dbg2       status:          %d\n", status);
+  }
+
+  return (status);
+}
 
 /*--------------------------------------------------------------------*/
 
@@ -102,6 +371,8 @@ int main(int argc, char **argv) {
   double maskbounds[4];
   bool print_notices = false;
   bool output_usefile = false;
+  bool make_index = false;
+  bool make_ancillary = false;
   int pings_read = 1;
   bool bathy_in_meters = true;
   output_format_t output_format = FREE_TEXT;
@@ -111,7 +382,7 @@ int main(int argc, char **argv) {
   bool help = false;
   {
     int c;
-    while ((c = getopt(argc, argv, "VvHhB:b:CcE:e:F:f:GgI:i:L:l:M:m:NnOoP:p:QqR:r:S:s:T:t:WwX:x:")) != -1) {
+    while ((c = getopt(argc, argv, "VvHhB:b:CcE:e:F:f:GgI:i:KkL:l:M:m:NnOoP:p:QqR:r:S:s:T:t:WwX:x:Yy")) != -1) {
       switch (c) {
         case 'B':
         case 'b':
@@ -143,6 +414,10 @@ int main(int argc, char **argv) {
         case 'i':
           sscanf(optarg, "%1023s", read_file);
           break;
+        case 'K':
+        case 'k':
+          make_index = true;
+          break;
         case 'L':
         case 'l':
           sscanf(optarg, "%d", &lonflip);
@@ -214,12 +489,20 @@ int main(int argc, char **argv) {
           }
           break;
         }
+        case 'Y':
+        case 'y':
+          make_ancillary = true;
+          break;
         default:
           errflg = true;
       }
     }
   }
 
+  /* the fnv and fbt files are written one ping at a time */
+  if (make_ancillary)
+    pings_get = 1;
+
   FILE * const stream = verbose <= 1 ? stdout : stderr;
 
   if (errflg) {
@@ -268,6 +551,8 @@ int main(int argc, char **argv) {
     fprintf(stream, "dbg2       quick:      %d\n", quick);
     fprintf(stream, "dbg2       bathy meters:%d\n", bathy_in_meters);
     fprintf(stream, "dbg2       lonflip_set:%d\n", lonflip_set);
+    fprintf(stream, "dbg2       make_index: %d\n", make_index);
+    fprintf(stream, "dbg2       ancillary:  %d\n", make_ancillary);
     fprintf(stream, "dbg2       coverage:   %d\n", coverage_mask);
     if (coverage_mask) {
       fprintf(stream, "dbg2       mask_nx:    %d\n", mask_nx);
@@ -611,6 +896,21 @@ int main(int argc, char **argv) {
             status = mb_register_array(verbose, mbio_ptr, MB_MEM_TYPE_SIDESCAN, sizeof(double), (void **)&datacur->sslat,
                                        &error);
         }
+        /* build a sidecar index (file.idx) of the records read, written
+            when the file is closed */
+        if (make_index && pass == 0 && error == MB_ERROR_NO_ERROR)
+          mb_index_build(verbose, mbio_ptr, &error);
+
+        /* write the fnv and fbt files (file.fnv, file.fbt) from the records
+            read on the first pass rather than reading the file again */
+        struct ancillary anc;
+        memset(&anc, 0, sizeof(struct ancillary));
+        bool anc_ok = false;
+        if (make_ancillary && pass == 0 && error == MB_ERROR_NO_ERROR) {
+          int anc_error = MB_ERROR_NO_ERROR;
+          anc_ok = mbinfo_ancillary_open(verbose, mbio_ptr, path, format, &anc, &anc_error) == MB_SUCCESS;
+        }
+
         if (pings_read > 1 && pass == 0) {
           if (error == MB_ERROR_NO_ERROR)
             status =
@@ -821,6 +1121,22 @@ int main(int argc, char **argv) {
             sslon = datacur->sslon;
             sslat = datacur->sslat;
 
+            /* add the record to the sidecar index */
+            if (make_index && pass == 0 && error <= MB_ERROR_NO_ERROR) {
+              int index_error = MB_ERROR_NO_ERROR;
+              mb_index_add(verbose, mbio_ptr, kind, time_d, navlon, navlat, &index_error);
+            }
+
+            /* add the record to the fnv and fbt files */
+            if (anc_ok && (error == MB_ERROR_NO_ERROR || error == MB_ERROR_TIME_GAP || error == MB_ERROR_COMMENT)) {
+              int anc_error = MB_ERROR_NO_ERROR;
+              if (mbinfo_ancillary_write(verbose, mbio_ptr, &anc, kind, time_i, time_d, navlon, navlat, speed, heading,
+                                         altitude, sensordepth, comment, &anc_error) != MB_SUCCESS
+                  && anc_error == MB_ERROR_WRITE_FAIL) {
+                anc_ok = false;
+              }
+            }
+
             /* increment counters */
             if (pass == 0 && (error == MB_ERROR_NO_ERROR || error == MB_ERROR_TIME_GAP)) {
               irec++;
@@ -1808,6 +2124,14 @@ int main(int argc, char **argv) {
           }
         }
 
+        /* close the fnv and fbt files before the swath file because the
+            arrays they use are registered with it */
+        if (make_ancillary && pass == 0) {
+          int anc_error = MB_ERROR_NO_ERROR;
+          if (mbinfo_ancillary_close(verbose, &anc, anc_ok, &anc_error) != MB_SUCCESS || !anc_ok)
+            fprintf(stderr, "\nUnable to write fnv and fbt files for %s\n", path);
+        }
+
         /* close the swath file */
         status &= mb_close(verbose, &mbio_ptr, &error);
 
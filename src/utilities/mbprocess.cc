@@ -46,6 +46,8 @@
  */
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
@@ -54,8 +56,10 @@
 #include <getopt.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <mutex>
 #include <thread>
 #include <unistd.h>
+#include <vector>
 
 #include "mb_aux.h"
 #include "mb_define.h"
@@ -119,6 +123,36 @@ struct mbprocess_grid_struct {
   float *data;
 };
 
+/* topography grids for backscatter correction shared by the processing
+   threads - a grid is reference counted while files using it are being
+   processed and only unreferenced grids are released to make room */
+struct mbprocess_gridcache_struct {
+  std::mutex mutex;
+  struct mbprocess_grid_struct grids[MB_PR_TOPOGRID_NUM_MAX];
+  bool grids_read[MB_PR_TOPOGRID_NUM_MAX] = {};
+  unsigned int grids_countSinceUsed[MB_PR_TOPOGRID_NUM_MAX] = {};
+  unsigned int grids_refcount[MB_PR_TOPOGRID_NUM_MAX] = {};
+};
+
+/* a file queued for processing, with its outcome and timing */
+struct mbprocess_job_struct {
+  struct mb_process_struct process;
+  off_t filesize;
+  int order;
+  bool usegrid;
+  int thread_id;
+  int status;
+  int error;
+  double time_elapsed;
+};
+
+/* raytracing table dimensions - the error bound is set by RAYTABLEERROR */
+constexpr double MBPROCESS_RAYTABLE_ANGLE_MAX = 80.0;
+constexpr double MBPROCESS_RAYTABLE_ANGLE_INTERVAL = 0.1;
+constexpr double MBPROCESS_RAYTABLE_TTIME_MAX = 10.0;
+constexpr double MBPROCESS_RAYTABLE_TTIME_INTERVAL = 0.025;
+constexpr double MBPROCESS_RAYTABLE_DEPTH_INTERVAL = 0.5;
+
 constexpr char program_name[] = "mbprocess";
 constexpr char help_message[] =
     "mbprocess is a tool for processing swath sonar bathymetry data.\n"
@@ -576,6 +610,7 @@ void process_file(int verbose, int thread_id, struct mb_process_struct *process,
   double *velocity = nullptr;
   double *velocity_sum = nullptr;
   void *rt_svp = nullptr;
+  void *rt_table = nullptr;
   double ssv;
   int sensorhead = 0;
   int sensortype = 0;
@@ -607,6 +642,11 @@ void process_file(int verbose, int thread_id, struct mb_process_struct *process,
   double *angles_null = nullptr;
   double *bheave = nullptr;
   double *alongtrack_offset = nullptr;
+  double *rt_depth = nullptr;
+  double *rt_shift = nullptr;
+  double *rt_ttime = nullptr;
+  double *rt_xx = nullptr;
+  double *rt_zz = nullptr;
 
   /* ssv handling variables */
   bool ssv_prelimpass = false;
@@ -2809,6 +2849,16 @@ void process_file(int verbose, int thread_id, struct mb_process_struct *process,
   if (*error == MB_ERROR_NO_ERROR)
     /* status = */ mb_register_array(verbose, imbio_ptr, MB_MEM_TYPE_BATHYMETRY, sizeof(double),
                                (void **)&alongtrack_offset, error);
+  if (*error == MB_ERROR_NO_ERROR)
+    /* status = */ mb_register_array(verbose, imbio_ptr, MB_MEM_TYPE_BATHYMETRY, sizeof(double), (void **)&rt_depth, error);
+  if (*error == MB_ERROR_NO_ERROR)
+    /* status = */ mb_register_array(verbose, imbio_ptr, MB_MEM_TYPE_BATHYMETRY, sizeof(double), (void **)&rt_shift, error);
+  if (*error == MB_ERROR_NO_ERROR)
+    /* status = */ mb_register_array(verbose, imbio_ptr, MB_MEM_TYPE_BATHYMETRY, sizeof(double), (void **)&rt_ttime, error);
+  if (*error == MB_ERROR_NO_ERROR)
+    /* status = */ mb_register_array(verbose, imbio_ptr, MB_MEM_TYPE_BATHYMETRY, sizeof(double), (void **)&rt_xx, error);
+  if (*error == MB_ERROR_NO_ERROR)
+    /* status = */ mb_register_array(verbose, imbio_ptr, MB_MEM_TYPE_BATHYMETRY, sizeof(double), (void **)&rt_zz, error);
 
   /* if error initializing memory then quit */
   if (*error != MB_ERROR_NO_ERROR) {
@@ -2915,6 +2965,16 @@ void process_file(int verbose, int thread_id, struct mb_process_struct *process,
       /* status = */ mb_register_array(verbose, imbio_ptr, MB_MEM_TYPE_BATHYMETRY, sizeof(double), (void **)&bheave, error);
     if (*error == MB_ERROR_NO_ERROR)
       /* status = */ mb_register_array(verbose, imbio_ptr, MB_MEM_TYPE_BATHYMETRY, sizeof(double), (void **)&alongtrack_offset, error);
+    if (*error == MB_ERROR_NO_ERROR)
+      /* status = */ mb_register_array(verbose, imbio_ptr, MB_MEM_TYPE_BATHYMETRY, sizeof(double), (void **)&rt_depth, error);
+    if (*error == MB_ERROR_NO_ERROR)
+      /* status = */ mb_register_array(verbose, imbio_ptr, MB_MEM_TYPE_BATHYMETRY, sizeof(double), (void **)&rt_shift, error);
+    if (*error == MB_ERROR_NO_ERROR)
+      /* status = */ mb_register_array(verbose, imbio_ptr, MB_MEM_TYPE_BATHYMETRY, sizeof(double), (void **)&rt_ttime, error);
+    if (*error == MB_ERROR_NO_ERROR)
+      /* status = */ mb_register_array(verbose, imbio_ptr, MB_MEM_TYPE_BATHYMETRY, sizeof(double), (void **)&rt_xx, error);
+    if (*error == MB_ERROR_NO_ERROR)
+      /* status = */ mb_register_array(verbose, imbio_ptr, MB_MEM_TYPE_BATHYMETRY, sizeof(double), (void **)&rt_zz, error);
 
     /* if error initializing memory then quit */
     if (*error != MB_ERROR_NO_ERROR) {
@@ -3960,8 +4020,18 @@ void process_file(int verbose, int thread_id, struct mb_process_struct *process,
   }
 
   /* set up the raytracing */
-  if (process->mbp_svp_mode != MBP_SVP_OFF)
+  if (process->mbp_svp_mode != MBP_SVP_OFF) {
     *status = mb_rt_init(verbose, nsvp, depth, velocity, &rt_svp, error);
+    if (*status == MB_SUCCESS && process->mbp_raytable_mode == MBP_RAYTABLE_ON &&
+        mb_rt_table_init(verbose, rt_svp, MBPROCESS_RAYTABLE_ANGLE_MAX, MBPROCESS_RAYTABLE_ANGLE_INTERVAL,
+                         MBPROCESS_RAYTABLE_TTIME_MAX, MBPROCESS_RAYTABLE_TTIME_INTERVAL,
+                         MBPROCESS_RAYTABLE_DEPTH_INTERVAL, process->mbp_raytable_error, &rt_table,
+                         error) != MB_SUCCESS) {
+      fprintf(stderr, "\nUnable to set up raytracing tables with maximum error %f m\n", process->mbp_raytable_error);
+      fprintf(stderr, "Every beam will be raytraced.\n");
+      *error = MB_ERROR_NO_ERROR;
+    }
+  }
 
   /* set up the sidescan recalculation */
   if (process->mbp_ssrecalc_mode == MBP_SSRECALC_ON) {
@@ -4557,13 +4627,41 @@ void process_file(int verbose, int thread_id, struct mb_process_struct *process,
               }
             }
 
-            /* raytrace */
-            *status = mb_rt(verbose, rt_svp, (depth_offset_use - static_shift), angles[i], 0.5 * ttimes[i],
-                           process->mbp_angle_mode, ssv, angles_null[i], 0, nullptr, nullptr, nullptr, nullptr, &xx, &zz, &ttime,
-                           &ray_stat, error);
+            rt_depth[i] = depth_offset_use - static_shift;
+            rt_shift[i] = static_shift;
+            rt_ttime[i] = 0.5 * ttimes[i];
+          }
+
+          /* else if no travel time no data */
+          else {
+            beamflag[i] = MB_FLAG_NULL;
+            rt_depth[i] = depth[0];
+            rt_shift[i] = 0.0;
+            rt_ttime[i] = 0.0;
+          }
+        }
+
+        /* raytrace, interpolating from the raytracing tables if they are used */
+        if (rt_table != nullptr) {
+          *status = mb_rt_table(verbose, rt_table, nbeams, rt_depth, angles, rt_ttime, process->mbp_angle_mode, ssv,
+                                angles_null, rt_xx, rt_zz, nullptr, nullptr, error);
+        }
+        else {
+          for (int i = 0; i < nbeams; i++) {
+            if (ttimes[i] > 0.0) {
+              *status = mb_rt(verbose, rt_svp, rt_depth[i], angles[i], rt_ttime[i], process->mbp_angle_mode, ssv,
+                             angles_null[i], 0, nullptr, nullptr, nullptr, nullptr, &rt_xx[i], &rt_zz[i], &ttime,
+                             &ray_stat, error);
+            }
+          }
+        }
+
+        for (int i = 0; i < nbeams; i++) {
+          if (ttimes[i] > 0.0) {
+            xx = rt_xx[i];
 
             /* apply static shift if any */
-            zz += static_shift;
+            zz = rt_zz[i] + rt_shift[i];
 
             /* get alongtrack and acrosstrack distances and depth */
             bathacrosstrack[i] = xx * cos(DTR * angles_forward[i]);
@@ -4587,10 +4685,6 @@ void process_file(int verbose, int thread_id, struct mb_process_struct *process,
               fprintf(stderr, "dbg5       depth:  %f\n", bath[i]);
             }
           }
-
-          /* else if no travel time no data */
-          else
-            beamflag[i] = MB_FLAG_NULL;
         }
       }
 
@@ -5596,6 +5690,8 @@ void process_file(int verbose, int thread_id, struct mb_process_struct *process,
     mb_freed(verbose, __FILE__, __LINE__, (void **)&depth, error);
     mb_freed(verbose, __FILE__, __LINE__, (void **)&velocity, error);
     mb_freed(verbose, __FILE__, __LINE__, (void **)&velocity_sum, error);
+    if (rt_table != nullptr)
+      *status = mb_rt_table_deall(verbose, &rt_table, error);
     if (rt_svp != nullptr)
       *status = mb_rt_deall(verbose, &rt_svp, error);
   }
@@ -5618,6 +5714,128 @@ void process_file(int verbose, int thread_id, struct mb_process_struct *process,
 
 }
 /*--------------------------------------------------------------------*/
+/* get the topography grid for a file from the shared cache, reading it if
+   needed, and hold a reference to it until mbprocess_gridcache_release() */
+struct mbprocess_grid_struct *mbprocess_gridcache_acquire(int verbose, struct mbprocess_gridcache_struct *cache,
+                                                          const char *file, const char *program_name)
+{
+  std::lock_guard<std::mutex> lock(cache->mutex);
+  int error = MB_ERROR_NO_ERROR;
+
+  // Check if this grid has already been read
+  struct mbprocess_grid_struct *grid_use = nullptr;
+  for (int i = 0; i < MB_PR_TOPOGRID_NUM_MAX; i++) {
+    if (cache->grids_read[i]) {
+      if (strcmp(file, cache->grids[i].file) == 0) {
+        grid_use = &cache->grids[i];
+        cache->grids_countSinceUsed[i] = 0;
+        cache->grids_refcount[i]++;
+      } else {
+        cache->grids_countSinceUsed[i]++;
+      }
+    }
+  }
+
+  // Delete any unreferenced grids in memory that haven't been used recently
+  for (int i = 0; i < MB_PR_TOPOGRID_NUM_MAX; i++) {
+    if (cache->grids_read[i] && cache->grids_refcount[i] == 0
+        && cache->grids_countSinceUsed[i] > MB_PR_TOPOGRID_NONUSE_MAX) {
+      mb_freed(verbose, __FILE__, __LINE__, (void **)&cache->grids[i].data, &error);
+      memset(&cache->grids[i], 0, sizeof(struct mbprocess_grid_struct));
+      cache->grids_read[i] = false;
+      cache->grids_countSinceUsed[i] = 0;
+    }
+  }
+  if (grid_use != nullptr)
+    return (grid_use);
+
+  // find the first available grid slot or delete an unreferenced grid to make room
+  int igrid_use = -1;
+  int igrid_delete = -1;
+  int largest_count_since_used = -1;
+  for (int i = 0; i < MB_PR_TOPOGRID_NUM_MAX && igrid_use == -1; i++) {
+    if (!cache->grids_read[i]) {
+      igrid_use = i;
+    } else if (cache->grids_refcount[i] == 0 && (int)cache->grids_countSinceUsed[i] > largest_count_since_used) {
+      largest_count_since_used = cache->grids_countSinceUsed[i];
+      igrid_delete = i;
+    }
+  }
+  if (igrid_use < 0 && igrid_delete >= 0) {
+    mb_freed(verbose, __FILE__, __LINE__, (void **)&cache->grids[igrid_delete].data, &error);
+    memset(&cache->grids[igrid_delete], 0, sizeof(struct mbprocess_grid_struct));
+    cache->grids_read[igrid_delete] = false;
+    cache->grids_countSinceUsed[igrid_delete] = 0;
+    igrid_use = igrid_delete;
+  }
+  if (igrid_use < 0) {
+    fprintf(stderr, "\nUnable to clear memory to read topography grid file: %s\n", file);
+    fprintf(stderr, "\nProgram <%s> Terminated\n", program_name);
+    exit(MB_ERROR_OPEN_FAIL);
+  }
+
+  // read the grid - other threads wait on the cache while this happens
+  struct mbprocess_grid_struct *grid = &cache->grids[igrid_use];
+  grid->data = nullptr;
+  strcpy(grid->file, file);
+  const int status = mb_read_gmt_grd(verbose, grid->file, &grid->projection_mode, grid->projection_id,
+                                     &grid->nodatavalue, &grid->nxy, &grid->n_columns, &grid->n_rows,
+                                     &grid->min, &grid->max, &grid->xmin, &grid->xmax, &grid->ymin, &grid->ymax,
+                                     &grid->dx, &grid->dy, &grid->data, nullptr, nullptr, &error);
+  if (status != MB_SUCCESS) {
+    fprintf(stderr, "\nUnable to read topography grid file: %s\n", grid->file);
+    fprintf(stderr, "\nProgram <%s> Terminated\n", program_name);
+    exit(MB_ERROR_OPEN_FAIL);
+  }
+  cache->grids_read[igrid_use] = true;
+  cache->grids_countSinceUsed[igrid_use] = 0;
+  cache->grids_refcount[igrid_use] = 1;
+
+  return (grid);
+}
+/*--------------------------------------------------------------------*/
+/* drop the reference held on a topography grid by a processed file */
+void mbprocess_gridcache_release(struct mbprocess_gridcache_struct *cache, struct mbprocess_grid_struct *grid)
+{
+  std::lock_guard<std::mutex> lock(cache->mutex);
+  const int i = grid - cache->grids;
+  if (i >= 0 && i < MB_PR_TOPOGRID_NUM_MAX && cache->grids_refcount[i] > 0)
+    cache->grids_refcount[i]--;
+}
+/*--------------------------------------------------------------------*/
+/* processing thread - keep taking the next file from the shared queue until
+   the queue is empty, so that no thread idles while another works through
+   a large file */
+void process_files(int verbose, int thread_id, std::vector<struct mbprocess_job_struct> *jobs,
+                   std::atomic<size_t> *next_job, struct mbprocess_gridcache_struct *cache,
+                   bool uselockfiles, const char *program_name)
+{
+  for (size_t ijob = (*next_job)++; ijob < jobs->size(); ijob = (*next_job)++) {
+    struct mbprocess_job_struct *job = &(*jobs)[ijob];
+    const auto time_start = std::chrono::steady_clock::now();
+
+    struct mbprocess_grid_struct *grid_use = nullptr;
+    if (job->usegrid)
+      grid_use = mbprocess_gridcache_acquire(verbose, cache, job->process.mbp_ampsscorr_topofile, program_name);
+
+    job->thread_id = thread_id;
+    job->status = MB_SUCCESS;
+    job->error = MB_ERROR_NO_ERROR;
+    process_file(verbose, thread_id, &job->process, grid_use, &job->status, &job->error);
+
+    if (grid_use != nullptr)
+      mbprocess_gridcache_release(cache, grid_use);
+
+    // unlock the raw swath file
+    if (uselockfiles) {
+      int lock_error = MB_ERROR_NO_ERROR;
+      mb_pr_unlockswathfile(verbose, job->process.mbp_ifile, MBP_LOCK_PROCESS, program_name, &lock_error);
+    }
+
+    job->time_elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - time_start).count();
+  }
+}
+/*--------------------------------------------------------------------*/
 
 int main(int argc, char **argv) {
   constexpr char usage_message[] =
@@ -5828,25 +6046,20 @@ int main(int argc, char **argv) {
   /* get number of threads to use */
   unsigned int n_concurrency = std::thread::hardware_concurrency();
   n_threads = MIN(n_threads, MIN(n_concurrency, MB_THREAD_MAX));
-  unsigned int n_thread_set = 0;
-  std::thread mbprocessThreads[MB_THREAD_MAX];
-  int thread_status[MB_THREAD_MAX];
-  int thread_error[MB_THREAD_MAX];
 
-  /* parameter controls */
-  struct mb_process_struct processPars[MB_THREAD_MAX];
+  /* files to be processed - the whole datalist is checked and the files that
+     need processing are queued before any processing starts */
+  std::vector<struct mbprocess_job_struct> jobs;
 
   /* topography grids for backscatter correction */
-  struct mbprocess_grid_struct grids[MB_PR_TOPOGRID_NUM_MAX];
-  bool grids_read[MB_PR_TOPOGRID_NUM_MAX];
-  memset(grids_read, 0, sizeof(bool) * MB_PR_TOPOGRID_NUM_MAX);
-  unsigned int grids_countSinceUsed[MB_PR_TOPOGRID_NUM_MAX];
-  memset(grids_countSinceUsed, 0, sizeof(unsigned int) * MB_PR_TOPOGRID_NUM_MAX);
+  struct mbprocess_gridcache_struct gridcache;
 
   /* loop over all files to be read */
   while (read_data) {
     /* load parameters */
-    struct mb_process_struct *process = &processPars[n_thread_set];
+    struct mbprocess_job_struct job;
+    memset(&job, 0, sizeof(struct mbprocess_job_struct));
+    struct mb_process_struct *process = &job.process;
     status = mb_pr_readpar(verbose, mbp_ifile, false, process, &error);
 
     /* set strip_comments */
@@ -5877,6 +6090,7 @@ int main(int argc, char **argv) {
     int fstat = stat(mbp_ifile, &file_status);
     if (fstat == 0 && (file_status.st_mode & S_IFMT) != S_IFDIR) {
       ifilemodtime = file_status.st_mtime;
+      job.filesize = file_status.st_size;
     }
 
     /* check for existing parameter file */
@@ -6126,103 +6340,16 @@ int main(int argc, char **argv) {
         proceedprocess = false;
     }
 
-    /* now start the processing thread for the input file */
+    /* queue the input file for processing */
     if (proceedprocess) {
-
-      // if needed read in the specified topography grid for backscatter correction
-      // - if this has already been read in then use the existing structure
-      struct mbprocess_grid_struct *grid_use = nullptr;
-      if ((process->mbp_ampcorr_mode == MBP_AMPCORR_ON &&
+      // note if a topography grid is needed for backscatter correction
+      job.usegrid = (process->mbp_ampcorr_mode == MBP_AMPCORR_ON &&
            (process->mbp_ampcorr_slope == MBP_AMPCORR_USETOPO || process->mbp_ampcorr_slope == MBP_AMPCORR_USETOPOSLOPE)) ||
           (process->mbp_sscorr_mode == MBP_SSCORR_ON &&
-           (process->mbp_sscorr_slope == MBP_SSCORR_USETOPO || process->mbp_sscorr_slope == MBP_SSCORR_USETOPOSLOPE))) {
-
-        // Check if this grid has already been read
-        bool found = false;
-        for (int i = 0; i < MB_PR_TOPOGRID_NUM_MAX; i++) {
-          if (grids_read[i]) {
-            if (strcmp(process->mbp_ampsscorr_topofile, grids[i].file) == 0) {
-              found = true;
-              grid_use = &grids[i];
-              grids_countSinceUsed[i] = 0;
-            } else {
-              grids_countSinceUsed[i]++;
-            }
-          }
-        }
-
-        // Delete any grids in memory that haven't been used recently
-        for (int i = 0; i < MB_PR_TOPOGRID_NUM_MAX; i++) {
-          if (grids_read[i] && grids_countSinceUsed[i] > MB_PR_TOPOGRID_NONUSE_MAX) {
-            mb_freed(verbose, __FILE__, __LINE__, (void **)&grids[i].data, &error);
-            memset(&grids[i], 0, sizeof(struct mbprocess_grid_struct));
-            grids_read[i] = false;
-            grids_countSinceUsed[i] = 0;
-          }
-        }
-
-        // If necessary read new grid
-        if (!found) {
-          // find the first available grid slot or delete a grid to make room
-          int igrid_use = -1;
-          int igrid_delete = -1;
-          int largest_count_since_used = -1;
-          for (int i = 0; i < MB_PR_TOPOGRID_NUM_MAX && igrid_use == -1; i++) {
-            if (!grids_read[i]) {
-              igrid_use = i;
-            } else {
-              if (grids_countSinceUsed[i] > largest_count_since_used) {
-                largest_count_since_used = grids_countSinceUsed[i];
-                igrid_delete = i;
-              }
-            }
-          }
-          if (igrid_use < 0 && igrid_delete >= 0) {
-            mb_freed(verbose, __FILE__, __LINE__, (void **)&grids[igrid_delete].data, &error);
-            memset(&grids[igrid_delete], 0, sizeof(struct mbprocess_grid_struct));
-            grids_read[igrid_delete] = false;
-            grids_countSinceUsed[igrid_delete] = 0;
-            igrid_use = igrid_delete;
-          }
-
-          // read the grid
-          if (igrid_use >= 0) {
-            grids[igrid_use].data = nullptr;
-            strcpy(grids[igrid_use].file, process->mbp_ampsscorr_topofile);
-            status = mb_read_gmt_grd(verbose, grids[igrid_use].file, &grids[igrid_use].projection_mode,
-                                    grids[igrid_use].projection_id, &grids[igrid_use].nodatavalue,
-                                    &grids[igrid_use].nxy, &grids[igrid_use].n_columns, &grids[igrid_use].n_rows,
-                                    &grids[igrid_use].min, &grids[igrid_use].max,
-                                    &grids[igrid_use].xmin, &grids[igrid_use].xmax,
-                                    &grids[igrid_use].ymin, &grids[igrid_use].ymax,
-                                    &grids[igrid_use].dx, &grids[igrid_use].dy,
-                                    &grids[igrid_use].data, nullptr, nullptr, &error);
-            if (status == MB_SUCCESS) {
-              grids_read[igrid_use] = true;
-              grids_countSinceUsed[igrid_use] = 0;
-              grid_use = &grids[igrid_use];
-            } else {
-              fprintf(stderr, "\nUnable to read topography grid file: %s\n", grids[igrid_use].file);
-              fprintf(stderr, "\nProgram <%s> Terminated\n", program_name);
-              exit(MB_ERROR_OPEN_FAIL);
-            }
-          } else {
-            fprintf(stderr, "\nUnable to clear memory to read topography grid file: %s\n", process->mbp_ampsscorr_topofile);
-            fprintf(stderr, "\nProgram <%s> Terminated\n", program_name);
-            exit(MB_ERROR_OPEN_FAIL);
-          }
-        }
-      }
-
-      // Start next processing thread
-      thread_status[n_thread_set] = MB_SUCCESS;
-      thread_error[n_thread_set] = MB_ERROR_NO_ERROR;
-      mbprocessThreads[n_thread_set]
-          = std::thread(process_file, verbose, n_thread_set, &processPars[n_thread_set], grid_use,
-                        &thread_status[n_thread_set], &thread_error[n_thread_set]);
-      n_thread_set++;
-
-    } /* end starting processing thread */
+           (process->mbp_sscorr_slope == MBP_SSCORR_USETOPO || process->mbp_sscorr_slope == MBP_SSCORR_USETOPOSLOPE));
+      job.order = jobs.size();
+      jobs.push_back(job);
+    }
 
     /* figure out whether and what to read next */
     if (read_datalist) {
@@ -6231,31 +6358,49 @@ int main(int argc, char **argv) {
       read_data = false;
     }
 
-    /* if the full number of processing threads have been started or there are no
-       more files to process, join all of the existing threads in turn until all are completed */
-    if (n_thread_set == n_threads || (!read_data && n_thread_set > 0)) {
-      for (unsigned int ithread = 0; ithread < n_thread_set; ithread++) {
-        /* join the thread (wait until it completes) */
-        mbprocessThreads[ithread].join();
-
-        // unlock the raw swath file
-        if (uselockfiles) {
-          thread_status[ithread] = mb_pr_unlockswathfile(verbose, processPars[ithread].mbp_ifile, MBP_LOCK_PROCESS,
-                                program_name, &thread_error[ithread]);
-        }
-      }
-      n_thread_set = 0;
-    }
-
   } /* end loop over datalist */
 
+  /* process the queued files, largest first so that the long running files
+     start early and the small files fill in around them */
+  if (!jobs.empty()) {
+    std::stable_sort(jobs.begin(), jobs.end(),
+                     [](const mbprocess_job_struct &a, const mbprocess_job_struct &b) { return a.filesize > b.filesize; });
+    const unsigned int n_workers = MIN(n_threads, (unsigned int)jobs.size());
+    std::atomic<size_t> next_job(0);
+    std::thread mbprocessThreads[MB_THREAD_MAX];
+    const auto time_start = std::chrono::steady_clock::now();
+    for (unsigned int ithread = 0; ithread < n_workers; ithread++) {
+      mbprocessThreads[ithread] = std::thread(process_files, verbose, ithread, &jobs, &next_job, &gridcache,
+                                              uselockfiles, program_name);
+    }
+    for (unsigned int ithread = 0; ithread < n_workers; ithread++) {
+      mbprocessThreads[ithread].join();
+    }
+    const double time_wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - time_start).count();
+
+    /* report the processing time of each file in datalist order */
+    std::sort(jobs.begin(), jobs.end(),
+              [](const mbprocess_job_struct &a, const mbprocess_job_struct &b) { return a.order < b.order; });
+    double time_sum = 0.0;
+    fprintf(stderr, "\nProcessing times:\n");
+    fprintf(stderr, "\t  Seconds  Thread     Size (MB)  Input file\n");
+    for (const mbprocess_job_struct &job : jobs) {
+      fprintf(stderr, "\t%9.2f  %6d  %12.3f  %s%s\n", job.time_elapsed, job.thread_id,
+              job.filesize / 1048576.0, job.process.mbp_ifile, job.status == MB_SUCCESS ? "" : " (failed)");
+      time_sum += job.time_elapsed;
+    }
+    fprintf(stderr, "\t%d files processed by %d threads in %.2f seconds (%.2f seconds of file processing, %.0f%% utilization)\n",
+            (int)jobs.size(), n_workers, time_wall, time_sum,
+            time_wall > 0.0 ? 100.0 * time_sum / (n_workers * time_wall) : 100.0);
+  }
+
   /* release any grids still in memory */
   for (int i = 0; i < MB_PR_TOPOGRID_NUM_MAX; i++) {
-    if (grids_read[i]) {
-      mb_freed(verbose, __FILE__, __LINE__, (void **)&grids[i].data, &error);
-      memset(&grids[i], 0, sizeof(struct mbprocess_grid_struct));
-      grids_read[i] = false;
-      grids_countSinceUsed[i] = 0;
+    if (gridcache.grids_read[i]) {
+      mb_freed(verbose, __FILE__, __LINE__, (void **)&gridcache.grids[i].data, &error);
+      memset(&gridcache.grids[i], 0, sizeof(struct mbprocess_grid_struct));
+      gridcache.grids_read[i] = false;
+      gridcache.grids_countSinceUsed[i] = 0;
     }
   }
 
@@ -618,6 +618,14 @@ int main(int argc, char **argv) {
         found = true;
 				sscanf(pargv[i], "SOUNDSPEEDREF:%d", &process.mbp_corrected);
 			}
+			if (!found && strncmp(pargv[i], "RAYTABLEMODE", 12) == 0) {
+        found = true;
+				sscanf(pargv[i], "RAYTABLEMODE:%d", &process.mbp_raytable_mode);
+			}
+			if (!found && strncmp(pargv[i], "RAYTABLEERROR", 13) == 0) {
+        found = true;
+				sscanf(pargv[i], "RAYTABLEERROR:%lf", &process.mbp_raytable_error);
+			}
 
 			/* static beam bathymetry correction */
 			if (!found && strncmp(pargv[i], "STATICMODE", 10) == 0) {
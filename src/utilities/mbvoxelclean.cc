@@ -31,11 +31,13 @@
  * applied to the data by the program mbprocess. These are the same edit save
  * files created and/or modified by mbvoxelclean and mbedit.
  * The input data are one swath file or a datalist referencing multiple
- * swath files. Each file is read and processed separately.
- * The rectangular prism including all of the flagged and unflagged soundings
- * is divided into 3D voxels of the specified size. All of the soundings are
- * read into memory and associated with one of the voxels. Once all of
- * data are read, a density filter is applied such that containing more than a
+ * swath files. Each file is read and processed separately unless cross-file
+ * cleaning is requested, in which case all of the files are read first and
+ * the soundings of overlapping files count towards the same voxels.
+ * Space is divided into 3D voxels of the specified size. All of the soundings
+ * are read into memory and associated with one of the voxels, which are held
+ * in hash tables so that only voxels containing soundings use memory. Once all
+ * of the data are read, a density filter is applied such that containing more than a
  * specified threshold of soundings are considered to be occupied by a valid target and
  * voxels containing less than the threshold are considered to be empty.
  * The user may specify one or both of the following actions:
@@ -53,13 +55,16 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <ctime>
 #include <getopt.h>
 #include <sys/stat.h>
+#include <thread>
 #include <unistd.h>
+#include <vector>
 
 #include "mb_define.h"
 #include "mb_format.h"
@@ -118,6 +123,8 @@ constexpr char usage_message[] =
     "\t--unflag-occupied\n"
     "\t--ignore-occupied\n"
     "\t--neighborhood=value\n"
+    "\t--cross-file\n"
+    "\t--threads=nthreads\n"
     "\t--range-minimum=value\n"
     "\t--range-maximum=value]\n"
     "\t--acrosstrack-minimum=value\n"
@@ -125,6 +132,530 @@ constexpr char usage_message[] =
     "\t--amplitude-minimum=value\n"
     "\t--amplitude-maximum=value]";
 
+/* counts of soundings and of the edits made to them */
+struct mbvoxelclean_count_struct {
+  int n_files;
+  int n_pings;
+  int n_beams;
+  int n_beamflag_null;
+  int n_beamflag_good;
+  int n_beamflag_flag;
+  int n_esf_flag;
+  int n_esf_unflag;
+  int n_density_flag;
+  int n_density_unflag;
+  int n_minrange_flag;
+  int n_maxrange_flag;
+  int n_minacrosstrack_flag;
+  int n_maxacrosstrack_flag;
+  int n_minamplitude_flag;
+  int n_maxamplitude_flag;
+};
+
+/* swath file read into memory for cleaning */
+struct mbvoxelclean_file_struct {
+  char swathfile[MB_PATH_MAXLINE];
+  int format;
+  char esffile[MB_PATH_MAXLINE];
+  struct mb_esf_struct esf;
+  bool esffile_open;
+  int n_pings;
+  int npings_alloc;
+  struct mbvoxelclean_ping_struct *pings;
+  struct mbvoxelclean_count_struct count;
+};
+
+/* voxel containing at least one sounding */
+struct mbvoxelclean_voxel_struct {
+  int ix;
+  int iy;
+  int iz;
+  int count;
+  bool used;
+  bool occupied;
+};
+
+/* open addressing hash table of voxels - the voxels are divided among
+   several tables by hash value so that each counting thread fills its
+   own table */
+struct mbvoxelclean_voxelset_struct {
+  std::vector<struct mbvoxelclean_voxel_struct> table;
+  size_t n_used;
+};
+
+/* sounding assigned to a voxel, partitioned by voxel table before counting */
+struct mbvoxelclean_sounding_struct {
+  uint64_t hash;
+  int ix;
+  int iy;
+  int iz;
+  bool counted;
+};
+
+/* density and range filter settings */
+struct mbvoxelclean_filter_struct {
+  double voxel_size_xy;
+  double voxel_size_z;
+  int occupy_threshold;
+  bool count_flagged;
+  empty_mode_t empty_mode;
+  occupied_mode_t occupied_mode;
+  int neighborhood;
+  bool apply_range_minimum;
+  double range_minimum;
+  bool apply_range_maximum;
+  double range_maximum;
+  bool apply_acrosstrack_minimum;
+  double acrosstrack_minimum;
+  bool apply_acrosstrack_maximum;
+  double acrosstrack_maximum;
+};
+
+/*--------------------------------------------------------------------*/
+/* hash of a voxel index - the high bits choose the voxel table and the
+   low bits the slot within it */
+static inline uint64_t mbvoxelclean_voxel_hash(int ix, int iy, int iz) {
+  uint64_t hash = (uint64_t)(uint32_t)ix * 0x9E3779B97F4A7C15ULL;
+  hash ^= (uint64_t)(uint32_t)iy * 0xC2B2AE3D27D4EB4FULL;
+  hash ^= (uint64_t)(uint32_t)iz * 0x165667B19E3779F9ULL;
+  hash ^= hash >> 31;
+  hash *= 0xBF58476D1CE4E5B9ULL;
+  hash ^= hash >> 29;
+  return hash;
+}
+
+static inline int mbvoxelclean_voxel_table(uint64_t hash, int n_voxelsets) {
+  return (int)((hash >> 40) % (uint64_t)n_voxelsets);
+}
+
+static inline void mbvoxelclean_voxel_index(const struct mbvoxelclean_filter_struct *filter, double x, double y,
+                                            double z, int *ix, int *iy, int *iz) {
+  *ix = (int)floor(x / filter->voxel_size_xy);
+  *iy = (int)floor(y / filter->voxel_size_xy);
+  *iz = (int)floor(z / filter->voxel_size_z);
+}
+
+/*--------------------------------------------------------------------*/
+/* find a voxel, returning nullptr if it holds no soundings */
+const struct mbvoxelclean_voxel_struct *mbvoxelclean_voxel_find(const struct mbvoxelclean_voxelset_struct *voxelset,
+                                                                int ix, int iy, int iz, uint64_t hash) {
+  if (voxelset->table.empty())
+    return nullptr;
+  const size_t mask = voxelset->table.size() - 1;
+  for (size_t slot = hash & mask; voxelset->table[slot].used; slot = (slot + 1) & mask) {
+    const struct mbvoxelclean_voxel_struct *voxel = &voxelset->table[slot];
+    if (voxel->ix == ix && voxel->iy == iy && voxel->iz == iz)
+      return voxel;
+  }
+  return nullptr;
+}
+
+/*--------------------------------------------------------------------*/
+/* find a voxel, adding it if not already present - the table is kept at
+   most half full */
+struct mbvoxelclean_voxel_struct *mbvoxelclean_voxel_insert(struct mbvoxelclean_voxelset_struct *voxelset,
+                                                            int ix, int iy, int iz, uint64_t hash) {
+  if (2 * (voxelset->n_used + 1) > voxelset->table.size()) {
+    std::vector<struct mbvoxelclean_voxel_struct> table_old;
+    table_old.swap(voxelset->table);
+    voxelset->table.assign(std::max((size_t)1024, 2 * table_old.size()), mbvoxelclean_voxel_struct());
+    const size_t mask = voxelset->table.size() - 1;
+    for (const struct mbvoxelclean_voxel_struct &voxel : table_old) {
+      if (voxel.used) {
+        size_t slot = mbvoxelclean_voxel_hash(voxel.ix, voxel.iy, voxel.iz) & mask;
+        while (voxelset->table[slot].used)
+          slot = (slot + 1) & mask;
+        voxelset->table[slot] = voxel;
+      }
+    }
+  }
+
+  const size_t mask = voxelset->table.size() - 1;
+  size_t slot = hash & mask;
+  for (; voxelset->table[slot].used; slot = (slot + 1) & mask) {
+    struct mbvoxelclean_voxel_struct *voxel = &voxelset->table[slot];
+    if (voxel->ix == ix && voxel->iy == iy && voxel->iz == iz)
+      return voxel;
+  }
+  struct mbvoxelclean_voxel_struct *voxel = &voxelset->table[slot];
+  voxel->ix = ix;
+  voxel->iy = iy;
+  voxel->iz = iz;
+  voxel->count = 0;
+  voxel->used = true;
+  voxel->occupied = false;
+  voxelset->n_used++;
+  return voxel;
+}
+
+/*--------------------------------------------------------------------*/
+/* partition the soundings of all of the files among the voxel tables with a
+   counting sort - soundings[bucket_start[k]] through
+   soundings[bucket_start[k+1]-1] fall in the voxels of table k */
+void mbvoxelclean_partition_soundings(const struct mbvoxelclean_filter_struct *filter,
+                                      const struct mbvoxelclean_file_struct *files, int n_files, int n_voxelsets,
+                                      std::vector<struct mbvoxelclean_sounding_struct> *soundings,
+                                      std::vector<size_t> *bucket_start) {
+  /* count the soundings in each table */
+  bucket_start->assign(n_voxelsets + 1, 0);
+  for (int ifile = 0; ifile < n_files; ifile++) {
+    const struct mbvoxelclean_file_struct *file = &files[ifile];
+    for (int i = 0; i < file->n_pings; i++) {
+      const struct mbvoxelclean_ping_struct *ping = &file->pings[i];
+      for (int j = 0; j < ping->beams_bath; j++) {
+        if (!mb_beam_check_flag_null(ping->beamflag[j])) {
+          int ix, iy, iz;
+          mbvoxelclean_voxel_index(filter, ping->bathx[j], ping->bathy[j], ping->bathz[j], &ix, &iy, &iz);
+          (*bucket_start)[mbvoxelclean_voxel_table(mbvoxelclean_voxel_hash(ix, iy, iz), n_voxelsets) + 1]++;
+        }
+      }
+    }
+  }
+  for (int k = 0; k < n_voxelsets; k++)
+    (*bucket_start)[k + 1] += (*bucket_start)[k];
+
+  /* place each sounding in its table's bucket */
+  soundings->resize((*bucket_start)[n_voxelsets]);
+  std::vector<size_t> bucket_next(bucket_start->begin(), bucket_start->end() - 1);
+  for (int ifile = 0; ifile < n_files; ifile++) {
+    const struct mbvoxelclean_file_struct *file = &files[ifile];
+    for (int i = 0; i < file->n_pings; i++) {
+      const struct mbvoxelclean_ping_struct *ping = &file->pings[i];
+      for (int j = 0; j < ping->beams_bath; j++) {
+        if (!mb_beam_check_flag_null(ping->beamflag[j])) {
+          struct mbvoxelclean_sounding_struct sounding;
+          mbvoxelclean_voxel_index(filter, ping->bathx[j], ping->bathy[j], ping->bathz[j], &sounding.ix, &sounding.iy,
+                                   &sounding.iz);
+          sounding.hash = mbvoxelclean_voxel_hash(sounding.ix, sounding.iy, sounding.iz);
+          sounding.counted = mb_beam_ok(ping->beamflag[j]) || filter->count_flagged;
+          (*soundings)[bucket_next[mbvoxelclean_voxel_table(sounding.hash, n_voxelsets)]++] = sounding;
+        }
+      }
+    }
+  }
+}
+
+/*--------------------------------------------------------------------*/
+/* counting thread - count the soundings in one voxel table's bucket */
+void mbvoxelclean_count_worker(const struct mbvoxelclean_sounding_struct *soundings, size_t n_soundings,
+                               struct mbvoxelclean_voxelset_struct *voxelset) {
+  for (size_t i = 0; i < n_soundings; i++) {
+    const struct mbvoxelclean_sounding_struct *sounding = &soundings[i];
+    struct mbvoxelclean_voxel_struct *voxel =
+        mbvoxelclean_voxel_insert(voxelset, sounding->ix, sounding->iy, sounding->iz, sounding->hash);
+    if (sounding->counted)
+      voxel->count++;
+  }
+}
+
+/*--------------------------------------------------------------------*/
+/* occupancy thread - a voxel in table ivoxelset is occupied if it or any
+   voxel within the neighborhood holds at least the threshold number of
+   soundings - the counts of all tables are only read here, and each thread
+   only sets the occupancy of its own voxels */
+void mbvoxelclean_occupy_worker(const struct mbvoxelclean_filter_struct *filter,
+                                struct mbvoxelclean_voxelset_struct *voxelsets, int n_voxelsets, int ivoxelset) {
+  const int nb = filter->neighborhood;
+  for (struct mbvoxelclean_voxel_struct &voxel : voxelsets[ivoxelset].table) {
+    if (!voxel.used)
+      continue;
+    voxel.occupied = voxel.count >= filter->occupy_threshold;
+    for (int iix = voxel.ix - nb; iix <= voxel.ix + nb && !voxel.occupied; iix++) {
+      for (int iiy = voxel.iy - nb; iiy <= voxel.iy + nb && !voxel.occupied; iiy++) {
+        for (int iiz = voxel.iz - nb; iiz <= voxel.iz + nb && !voxel.occupied; iiz++) {
+          const uint64_t hash = mbvoxelclean_voxel_hash(iix, iiy, iiz);
+          const struct mbvoxelclean_voxel_struct *neighbor =
+              mbvoxelclean_voxel_find(&voxelsets[mbvoxelclean_voxel_table(hash, n_voxelsets)], iix, iiy, iiz, hash);
+          if (neighbor != nullptr && neighbor->count >= filter->occupy_threshold)
+            voxel.occupied = true;
+        }
+      }
+    }
+  }
+}
+
+/*--------------------------------------------------------------------*/
+/* build the voxels holding the soundings of all of the files and determine
+   which are occupied, using n_threads threads for each pass */
+int mbvoxelclean_count_voxels(int verbose, const struct mbvoxelclean_filter_struct *filter,
+                              const struct mbvoxelclean_file_struct *files, int n_files,
+                              std::vector<struct mbvoxelclean_voxelset_struct> *voxelsets, int n_threads, int *error) {
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBvoxelclean function <%s> called\n", __func__);
+    fprintf(stderr, "dbg2  Input arguments:\n");
+    fprintf(stderr, "dbg2       verbose:         %d\n", verbose);
+    fprintf(stderr, "dbg2       n_files:         %d\n", n_files);
+    fprintf(stderr, "dbg2       n_threads:       %d\n", n_threads);
+  }
+
+  n_threads = std::max(1, std::min(n_threads, MB_THREAD_MAX));
+  voxelsets->assign(n_threads, mbvoxelclean_voxelset_struct());
+
+  std::vector<struct mbvoxelclean_sounding_struct> soundings;
+  std::vector<size_t> bucket_start;
+  mbvoxelclean_partition_soundings(filter, files, n_files, n_threads, &soundings, &bucket_start);
+
+  std::thread workers[MB_THREAD_MAX];
+  for (int ithread = 0; ithread < n_threads; ithread++)
+    workers[ithread] = std::thread(mbvoxelclean_count_worker, soundings.data() + bucket_start[ithread],
+                                   bucket_start[ithread + 1] - bucket_start[ithread], &(*voxelsets)[ithread]);
+  for (int ithread = 0; ithread < n_threads; ithread++)
+    workers[ithread].join();
+  std::vector<struct mbvoxelclean_sounding_struct>().swap(soundings);
+  for (int ithread = 0; ithread < n_threads; ithread++)
+    workers[ithread] = std::thread(mbvoxelclean_occupy_worker, filter, voxelsets->data(), n_threads, ithread);
+  for (int ithread = 0; ithread < n_threads; ithread++)
+    workers[ithread].join();
+
+  if (verbose >= 1) {
+    size_t n_voxel = 0;
+    size_t n_occupied = 0;
+    size_t n_bytes = 0;
+    for (const struct mbvoxelclean_voxelset_struct &voxelset : *voxelsets) {
+      n_voxel += voxelset.n_used;
+      n_bytes += voxelset.table.size() * sizeof(struct mbvoxelclean_voxel_struct);
+      for (const struct mbvoxelclean_voxel_struct &voxel : voxelset.table)
+        if (voxel.used && voxel.occupied)
+          n_occupied++;
+    }
+    fprintf(stderr, "%zu voxels containing soundings (%.1f MB), %zu occupied\n", n_voxel, n_bytes / 1048576.0, n_occupied);
+  }
+
+  const int status = MB_SUCCESS;
+
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBvoxelclean function <%s> completed\n", __func__);
+    fprintf(stderr, "dbg2  Return values:\n");
+    fprintf(stderr, "dbg2       error:           %d\n", *error);
+    fprintf(stderr, "dbg2  Return status:\n");
+    fprintf(stderr, "dbg2       status:          %d\n", status);
+  }
+
+  return (status);
+}
+
+/*--------------------------------------------------------------------*/
+/* apply the acrosstrack and range filters to the soundings of a file */
+void mbvoxelclean_filter_range(int verbose, const struct mbvoxelclean_filter_struct *filter,
+                               struct mbvoxelclean_file_struct *file, int *error) {
+  /* apply acrosstrack filter to the soundings */
+  if (filter->apply_acrosstrack_minimum || filter->apply_acrosstrack_maximum) {
+    for (int i = 0; i < file->n_pings; i++) {
+      struct mbvoxelclean_ping_struct *ping = &file->pings[i];
+      for (int j = 0; j < ping->beams_bath; j++) {
+        if (!mb_beam_check_flag_null(ping->beamflag[j])) {
+          if (filter->apply_acrosstrack_minimum
+            && mb_beam_ok(ping->beamflag[j])
+            && ping->bathacrosstrack[j] < filter->acrosstrack_minimum) {
+            ping->beamflag[j] = MB_FLAG_FLAG + MB_FLAG_FILTER;
+            const int action = MBP_EDIT_FILTER;
+            mb_ess_save(verbose, &file->esf, ping->time_d,
+                j + ping->multiplicity * MB_ESF_MULTIPLICITY_FACTOR,
+                action, error);
+            file->count.n_minacrosstrack_flag++;
+          } else if (filter->apply_acrosstrack_maximum
+            && mb_beam_ok(ping->beamflag[j])
+            && ping->bathacrosstrack[j] > filter->acrosstrack_maximum) {
+            ping->beamflag[j] = MB_FLAG_FLAG + MB_FLAG_FILTER;
+            const int action = MBP_EDIT_FILTER;
+            mb_ess_save(verbose, &file->esf, ping->time_d,
+                j + ping->multiplicity * MB_ESF_MULTIPLICITY_FACTOR,
+                action, error);
+            file->count.n_maxacrosstrack_flag++;
+          }
+        }
+      }
+    }
+  }
+
+  /* apply range filter to the soundings */
+  if (filter->apply_range_minimum || filter->apply_range_maximum) {
+    for (int i = 0; i < file->n_pings; i++) {
+      struct mbvoxelclean_ping_struct *ping = &file->pings[i];
+      for (int j = 0; j < ping->beams_bath; j++) {
+        if (!mb_beam_check_flag_null(ping->beamflag[j])) {
+          if (filter->apply_range_minimum
+            && mb_beam_ok(ping->beamflag[j])
+            && ping->bathr[j] < filter->range_minimum) {
+            ping->beamflag[j] = MB_FLAG_FLAG + MB_FLAG_FILTER;
+            const int action = MBP_EDIT_FILTER;
+            mb_ess_save(verbose, &file->esf, ping->time_d,
+                j + ping->multiplicity * MB_ESF_MULTIPLICITY_FACTOR,
+                action, error);
+            file->count.n_minrange_flag++;
+          } else if (filter->apply_range_maximum
+            && mb_beam_ok(ping->beamflag[j])
+            && ping->bathr[j] > filter->range_maximum) {
+            ping->beamflag[j] = MB_FLAG_FLAG + MB_FLAG_FILTER;
+            const int action = MBP_EDIT_FILTER;
+            mb_ess_save(verbose, &file->esf, ping->time_d,
+                j + ping->multiplicity * MB_ESF_MULTIPLICITY_FACTOR,
+                action, error);
+            file->count.n_maxrange_flag++;
+          }
+        }
+      }
+    }
+  }
+}
+
+/*--------------------------------------------------------------------*/
+/* apply the density filter to the soundings of a file */
+void mbvoxelclean_filter_density(int verbose, const struct mbvoxelclean_filter_struct *filter,
+                                 const std::vector<struct mbvoxelclean_voxelset_struct> &voxelsets,
+                                 struct mbvoxelclean_file_struct *file, int *error) {
+  if (filter->occupied_mode != MBVC_OCCUPIED_UNFLAG && filter->empty_mode != MBVC_EMPTY_FLAG)
+    return;
+
+  const int n_voxelsets = (int)voxelsets.size();
+  for (int i = 0; i < file->n_pings; i++) {
+    struct mbvoxelclean_ping_struct *ping = &file->pings[i];
+    for (int j = 0; j < ping->beams_bath; j++) {
+      if (!mb_beam_check_flag_null(ping->beamflag[j])) {
+        int ix, iy, iz;
+        mbvoxelclean_voxel_index(filter, ping->bathx[j], ping->bathy[j], ping->bathz[j], &ix, &iy, &iz);
+        const uint64_t hash = mbvoxelclean_voxel_hash(ix, iy, iz);
+        const struct mbvoxelclean_voxel_struct *voxel =
+            mbvoxelclean_voxel_find(&voxelsets[mbvoxelclean_voxel_table(hash, n_voxelsets)], ix, iy, iz, hash);
+        const bool occupied = voxel != nullptr && voxel->occupied;
+        if (filter->occupied_mode == MBVC_OCCUPIED_UNFLAG
+          && occupied
+          && !mb_beam_ok(ping->beamflag[j])) {
+          ping->beamflag[j] = MB_FLAG_NONE;
+          const int action = MBP_EDIT_UNFLAG;
+          mb_ess_save(verbose, &file->esf, ping->time_d,
+              j + ping->multiplicity * MB_ESF_MULTIPLICITY_FACTOR,
+              action, error);
+          file->count.n_density_unflag++;
+        }
+        if (filter->empty_mode == MBVC_EMPTY_FLAG
+          && !occupied
+          && mb_beam_ok(ping->beamflag[j])) {
+          ping->beamflag[j] = MB_FLAG_FLAG + MB_FLAG_FILTER;
+          const int action = MBP_EDIT_FILTER;
+          mb_ess_save(verbose, &file->esf, ping->time_d,
+                j + ping->multiplicity * MB_ESF_MULTIPLICITY_FACTOR,
+                action, error);
+          file->count.n_density_flag++;
+        }
+      }
+    }
+  }
+}
+
+/*--------------------------------------------------------------------*/
+/* write the edits of a cleaned file to its edit save file, unlock it, and
+   add its counts to the totals */
+int mbvoxelclean_finish_file(int verbose, struct mbvoxelclean_file_struct *file, bool uselockfiles,
+                             struct mbvoxelclean_count_struct *total, int *error) {
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBvoxelclean function <%s> called\n", __func__);
+    fprintf(stderr, "dbg2  Input arguments:\n");
+    fprintf(stderr, "dbg2       verbose:         %d\n", verbose);
+    fprintf(stderr, "dbg2       swathfile:       %s\n", file->swathfile);
+    fprintf(stderr, "dbg2       uselockfiles:    %d\n", uselockfiles);
+  }
+
+  int status = MB_SUCCESS;
+
+  /* write out edits for beamflags that have changed  */
+  for (int i = 0; i < file->n_pings; i++) {
+    struct mbvoxelclean_ping_struct *ping = &file->pings[i];
+    for (int j = 0; j< ping->beams_bath; j++) {
+      if (ping->beamflag[j] != ping->beamflagorg[j]) {
+        int action = MBP_EDIT_ZERO;
+        if (mb_beam_ok(ping->beamflag[j])) {
+          action = MBP_EDIT_UNFLAG;
+        }
+        else if (mb_beam_check_flag_filter2(ping->beamflag[j])) {
+          action = MBP_EDIT_FILTER;
+        }
+        else if (mb_beam_check_flag_filter(ping->beamflag[j])) {
+          action = MBP_EDIT_FILTER;
+        }
+        else if (ping->beamflag[j] != MB_FLAG_NULL) {
+          action = MBP_EDIT_FLAG;
+        }
+        else {
+          action = MBP_EDIT_ZERO;
+        }
+        mb_esf_save(verbose, &file->esf, ping->time_d,
+                    j + ping->multiplicity * MB_ESF_MULTIPLICITY_FACTOR, action, error);
+      }
+    }
+  }
+
+  /* close edit save file */
+  status = mb_esf_close(verbose, &file->esf, error);
+
+  /* update mbprocess parameter file */
+  if (file->esffile_open) {
+    /* update mbprocess parameter file */
+    status = mb_pr_update_format(verbose, file->swathfile, true, file->format, error);
+    status = mb_pr_update_edit(verbose, file->swathfile, MBP_EDIT_ON, file->esffile, error);
+  }
+
+  /* unlock the raw swath file */
+  if (uselockfiles)
+    status = mb_pr_unlockswathfile(verbose, file->swathfile, MBP_LOCK_EDITBATHY, program_name, error);
+
+  /* check memory */
+  if (verbose >= 4)
+    status = mb_memory_list(verbose, error);
+
+  /* increment the total counting variables */
+  const struct mbvoxelclean_count_struct *count = &file->count;
+  total->n_files++;
+  total->n_pings += count->n_pings;
+  total->n_beams += count->n_beams;
+  total->n_beamflag_null += count->n_beamflag_null;
+  total->n_beamflag_good += count->n_beamflag_good;
+  total->n_beamflag_flag += count->n_beamflag_flag;
+  total->n_esf_flag += count->n_esf_flag;
+  total->n_esf_unflag += count->n_esf_unflag;
+  total->n_density_flag += count->n_density_flag;
+  total->n_density_unflag += count->n_density_unflag;
+  total->n_minrange_flag += count->n_minrange_flag;
+  total->n_maxrange_flag += count->n_maxrange_flag;
+  total->n_minacrosstrack_flag += count->n_minacrosstrack_flag;
+  total->n_maxacrosstrack_flag += count->n_maxacrosstrack_flag;
+  total->n_minamplitude_flag += count->n_minamplitude_flag;
+  total->n_maxamplitude_flag += count->n_maxamplitude_flag;
+
+  /* give the statistics */
+  if (verbose >= 1) {
+    fprintf(stderr, "---------------------------------\n");
+    fprintf(stderr, "%s\n", file->swathfile);
+    fprintf(stderr, "%7d survey data records processed\n", count->n_pings);
+    fprintf(stderr, "%7d soundings processed\n", count->n_beams);
+    fprintf(stderr, "%7d beams good originally\n", count->n_beamflag_good);
+    fprintf(stderr, "%7d beams flagged originally\n", count->n_beamflag_flag);
+    fprintf(stderr, "%7d beams null originally\n", count->n_beamflag_null);
+    if (file->esf.nedit > 0) {
+      fprintf(stderr, "%7d beams flagged in old esf file\n", count->n_esf_flag);
+      fprintf(stderr, "%7d beams unflagged in old esf file\n", count->n_esf_unflag);
+    }
+    fprintf(stderr, "%7d beams flagged by density filter\n", count->n_density_flag);
+    fprintf(stderr, "%7d beams unflagged by density filter\n", count->n_density_unflag);
+    fprintf(stderr, "%7d beams flagged by minimum range filter\n", count->n_minrange_flag);
+    fprintf(stderr, "%7d beams flagged by maximum range filter\n", count->n_maxrange_flag);
+    fprintf(stderr, "%7d beams flagged by minimum acrosstrack filter\n", count->n_minacrosstrack_flag);
+    fprintf(stderr, "%7d beams flagged by maximum acrosstrack filter\n", count->n_maxacrosstrack_flag);
+    fprintf(stderr, "%7d beams flagged by minimum amplitude filter\n", count->n_minamplitude_flag);
+    fprintf(stderr, "%7d beams flagged by maximum amplitude filter\n", count->n_maxamplitude_flag);
+  }
+
+  if (verbose >= 2) {
+    fprintf(stderr, "\ndbg2  MBvoxelclean function <%s> completed\n", __func__);
+    fprintf(stderr, "dbg2  Return values:\n");
+    fprintf(stderr, "dbg2       error:           %d\n", *error);
+    fprintf(stderr, "dbg2  Return status:\n");
+    fprintf(stderr, "dbg2       status:          %d\n", status);
+  }
+
+  return (status);
+}
+
 /*--------------------------------------------------------------------*/
 
 int main(int argc, char **argv) {
@@ -170,6 +701,8 @@ int main(int argc, char **argv) {
   empty_mode_t empty_mode = MBVC_EMPTY_FLAG;
   occupied_mode_t occupied_mode = MBVC_OCCUPIED_IGNORE;
   int neighborhood = 0;
+  bool cross_file = false;
+  int n_threads = 1;
 
   /* other mbvoxelclean control parameters */
   bool apply_range_minimum = false;
@@ -202,6 +735,8 @@ int main(int argc, char **argv) {
         {"unflag-occupied", no_argument, nullptr, 0},
         {"ignore-occupied", no_argument, nullptr, 0},
         {"neighborhood", required_argument, nullptr, 0},
+        {"cross-file", no_argument, nullptr, 0},
+        {"threads", required_argument, nullptr, 0},
         {"range-minimum", required_argument, nullptr, 0},
         {"range-maximum", required_argument, nullptr, 0},
         {"acrosstrack-minimum", required_argument, nullptr, 0},
@@ -263,6 +798,13 @@ int main(int argc, char **argv) {
         else if (strcmp("neighborhood", options[option_index].name) == 0) {
           sscanf(optarg, "%d", &neighborhood);
         }
+        else if (strcmp("cross-file", options[option_index].name) == 0) {
+          cross_file = true;
+        }
+        else if (strcmp("threads", options[option_index].name) == 0) {
+          sscanf(optarg, "%d", &n_threads);
+          n_threads = std::max(n_threads, 1);
+        }
         else if (strcmp("range-minimum", options[option_index].name) == 0) {
           apply_range_minimum = true;
           sscanf(optarg, "%lf", &range_minimum);
@@ -343,6 +885,8 @@ int main(int argc, char **argv) {
       fprintf(outfp, "dbg2       empty_mode:                  %d\n", empty_mode);
       fprintf(outfp, "dbg2       occupied_mode:               %d\n", occupied_mode);
       fprintf(outfp, "dbg2       neighborhood:                %d\n", neighborhood);
+      fprintf(outfp, "dbg2       cross_file:                  %d\n", cross_file);
+      fprintf(outfp, "dbg2       n_threads:                   %d\n", n_threads);
       fprintf(outfp, "dbg2       apply_range_minimum:         %d\n", apply_range_minimum);
       fprintf(outfp, "dbg2       range_minimum:               %f\n", range_minimum);
       fprintf(outfp, "dbg2       apply_range_maximum:         %d\n", apply_range_maximum);
@@ -396,6 +940,24 @@ int main(int argc, char **argv) {
     read_data = true;
   }
 
+  /* density and range filter settings */
+  struct mbvoxelclean_filter_struct filter;
+  filter.voxel_size_xy = voxel_size_xy;
+  filter.voxel_size_z = voxel_size_z;
+  filter.occupy_threshold = occupy_threshold;
+  filter.count_flagged = count_flagged;
+  filter.empty_mode = empty_mode;
+  filter.occupied_mode = occupied_mode;
+  filter.neighborhood = neighborhood;
+  filter.apply_range_minimum = apply_range_minimum;
+  filter.range_minimum = range_minimum;
+  filter.apply_range_maximum = apply_range_maximum;
+  filter.range_maximum = range_maximum;
+  filter.apply_acrosstrack_minimum = apply_acrosstrack_minimum;
+  filter.acrosstrack_minimum = acrosstrack_minimum;
+  filter.apply_acrosstrack_maximum = apply_acrosstrack_maximum;
+  filter.acrosstrack_maximum = acrosstrack_maximum;
+
   int kind = MB_DATA_NONE;
   char swathfileread[MB_PATH_MAXLINE];
   int variable_beams;
@@ -430,38 +992,28 @@ int main(int argc, char **argv) {
   double *ssalongtrack = nullptr;
   char comment[MB_COMMENT_MAXLINE];
 
-  /* swath data storage */
-  struct mbvoxelclean_ping_struct *pings = nullptr;
+  /* swath data storage - with cross-file cleaning every file is held in
+      memory until all have been read, otherwise the first entry is reused
+      for each file */
+  struct mbvoxelclean_file_struct *files = nullptr;
+  int n_files = 0;
+  int n_files_alloc = 0;
 
   /* voxel storage */
-  unsigned char *voxel_count = nullptr;
+  std::vector<struct mbvoxelclean_voxelset_struct> voxelsets;
+
+  /* local cartesian coordinate system - with cross-file cleaning the origin
+      is the start of the first file so that all files share it */
+  bool origin_set = false;
+  double lon_origin = 0.0;
+  double lat_origin = 0.0;
+  double mtodeglon = 0.0;
+  double mtodeglat = 0.0;
+
+  struct mbvoxelclean_count_struct total;
+  memset((void *)&total, 0, sizeof(total));
 
-  /* save file control variables */
-  char esffile[MB_PATH_MAXLINE];
-  struct mb_esf_struct esf;
-  memset((void *)&esf, 0, sizeof(esf));
-
-  int n_files_tot = 0;
-  int n_pings_tot = 0;
-  int n_beams_tot = 0;
-  int n_beamflag_null_tot = 0;
-  int n_beamflag_good_tot = 0;
-  int n_beamflag_flag_tot = 0;
-  int n_esf_flag_tot = 0;
-  int n_esf_unflag_tot = 0;
-  int n_density_flag_tot = 0;
-  int n_density_unflag_tot = 0;
-  int n_minrange_flag_tot = 0;
-  int n_maxrange_flag_tot = 0;
-  int n_minacrosstrack_flag_tot = 0;
-  int n_maxacrosstrack_flag_tot = 0;
-  int n_minamplitude_flag_tot = 0;
-  int n_maxamplitude_flag_tot = 0;
-
-  bool esffile_open = false;
   bool locked = false;
-  int n_voxel_alloc = 0;
-  int npings_alloc = 0;
 
   /* loop over all files to be read */
   while (read_data) {
@@ -543,15 +1095,39 @@ int main(int argc, char **argv) {
 
     /* proceed if file locked and format ok */
     if (oktoprocess) {
+      /* get the storage for this file */
+      const int ifile = cross_file ? n_files : 0;
+      if (ifile >= n_files_alloc) {
+        status &= mb_reallocd(verbose, __FILE__, __LINE__, (ifile + 1) * sizeof(struct mbvoxelclean_file_struct),
+          (void **)&files, &error);
+        if (error != MB_ERROR_NO_ERROR) {
+          char *message = nullptr;
+          mb_error(verbose, MB_ERROR_MEMORY_FAIL, &message);
+          fprintf(outfp, "\nMBIO Error allocating files array:\n%s\n", message);
+          fprintf(outfp, "\nProgram <%s> Terminated\n", program_name);
+          mb_memory_clear(verbose, &error);
+          exit(error);
+        }
+        memset((void *)&files[n_files_alloc], 0, (ifile + 1 - n_files_alloc) * sizeof(struct mbvoxelclean_file_struct));
+        n_files_alloc = ifile + 1;
+      }
+      struct mbvoxelclean_file_struct *file = &files[ifile];
+      strcpy(file->swathfile, swathfile);
+      file->format = format;
+      file->esffile_open = false;
+      memset((void *)&file->esf, 0, sizeof(file->esf));
+      memset((void *)&file->count, 0, sizeof(file->count));
+      file->n_pings = 0;
+
       /* check for *inf file, create if necessary, and load metadata */
       int formatread = format;
       struct mb_info_struct mb_info;
       status = mb_get_info_datalist(verbose, swathfile, &formatread, &mb_info, lonflip, &error);
 
       /* allocate space to store the bathymetry data */
-      if (npings_alloc <= mb_info.nrecords) {
+      if (file->npings_alloc <= mb_info.nrecords) {
         status &= mb_reallocd(verbose, __FILE__, __LINE__, mb_info.nrecords * sizeof(struct mbvoxelclean_ping_struct),
-          (void **)&pings, &error);
+          (void **)&file->pings, &error);
         if (error != MB_ERROR_NO_ERROR) {
           char *message = nullptr;
           mb_error(verbose, MB_ERROR_MEMORY_FAIL, &message);
@@ -560,9 +1136,11 @@ int main(int argc, char **argv) {
           mb_memory_clear(verbose, &error);
           exit(error);
         }
-        memset((void *)&pings[npings_alloc], 0, (mb_info.nrecords - npings_alloc) * sizeof(struct mbvoxelclean_ping_struct));
-        npings_alloc = mb_info.nrecords;
+        memset((void *)&file->pings[file->npings_alloc], 0,
+               (mb_info.nrecords - file->npings_alloc) * sizeof(struct mbvoxelclean_ping_struct));
+        file->npings_alloc = mb_info.nrecords;
       }
+      struct mbvoxelclean_ping_struct *pings = file->pings;
       for (int i = 0; i<mb_info.nrecords; i++) {
         if (pings[i].beams_bath_alloc < mb_info.nbeams_bath) {
           if (error == MB_ERROR_NO_ERROR)
@@ -598,12 +1176,13 @@ int main(int argc, char **argv) {
         }
       }
 
-      /* define local cartesian coordinate system based on first ping navigation and heading */
-      double mtodeglon;
-      double mtodeglat;
-      mb_coor_scale(verbose, mb_info.lat_start, &mtodeglon, &mtodeglat);
-      const double headingx = sin(mb_info.heading_start * DTR);
-      const double headingy = cos(mb_info.heading_start * DTR);
+      /* define local cartesian coordinate system based on first ping navigation */
+      if (!origin_set || !cross_file) {
+        lon_origin = mb_info.lon_start;
+        lat_origin = mb_info.lat_start;
+        mb_coor_scale(verbose, lat_origin, &mtodeglon, &mtodeglat);
+        origin_set = true;
+      }
 
       /* check for "fast bathymetry" or "fbt" file */
       strcpy(swathfileread, swathfile);
@@ -629,22 +1208,8 @@ int main(int argc, char **argv) {
         exit(error);
       }
 
-      /* initialize per-file counting variables */
-      int n_pings = 0;
-      int n_beams = 0;
-      int n_beamflag_null = 0;
-      int n_beamflag_good = 0;
-      int n_beamflag_flag = 0;
-      int n_esf_flag = 0;
-      int n_esf_unflag = 0;
-      int n_density_flag = 0;
-      int n_density_unflag = 0;
-      int n_minrange_flag = 0;
-      int n_maxrange_flag = 0;
-      int n_minacrosstrack_flag = 0;
-      int n_maxacrosstrack_flag = 0;
-      int n_minamplitude_flag = 0;
-      int n_maxamplitude_flag = 0;
+      /* per-file counting variables */
+      struct mbvoxelclean_count_struct *count = &file->count;
 
       /* allocate memory for mb_get() data arrays */
       if (error == MB_ERROR_NO_ERROR)
@@ -685,12 +1250,6 @@ int main(int argc, char **argv) {
       }
 
       void *store_ptr = nullptr;
-      double x_min;
-      double x_max;
-      double y_min;
-      double y_max;
-      double z_min;
-      double z_max;
 
       /* now deal with old edit save file */
       if (status == MB_SUCCESS) {
@@ -698,26 +1257,26 @@ int main(int argc, char **argv) {
         fprintf(stderr, "\tOpening edit save file...\n");
 
         /* handle esf edits */
-        status = mb_esf_load(verbose, program_name, swathfile, true, true, esffile, &esf, &error);
-        if (status == MB_SUCCESS && esf.esffp != nullptr)
-          esffile_open = true;
+        status = mb_esf_load(verbose, program_name, swathfile, true, true, file->esffile, &file->esf, &error);
+        if (status == MB_SUCCESS && file->esf.esffp != nullptr)
+          file->esffile_open = true;
         if (status == MB_FAILURE && error == MB_ERROR_OPEN_FAIL) {
-          esffile_open = false;
-          fprintf(stderr, "\nUnable to open new edit save file %s\n", esf.esffile);
+          file->esffile_open = false;
+          fprintf(stderr, "\nUnable to open new edit save file %s\n", file->esf.esffile);
         }
         else if (status == MB_FAILURE && error == MB_ERROR_MEMORY_FAIL) {
-          esffile_open = false;
-          fprintf(stderr, "\nUnable to allocate memory for edits in esf file %s\n", esf.esffile);
+          file->esffile_open = false;
+          fprintf(stderr, "\nUnable to allocate memory for edits in esf file %s\n", file->esf.esffile);
         }
         /* reset message */
-        if (esf.nedit > 0) {
-          fprintf(stderr, "%d old edits sorted...\n", esf.nedit);
+        if (file->esf.nedit > 0) {
+          fprintf(stderr, "%d old edits sorted...\n", file->esf.nedit);
         }
       }
 
       /* read */
       bool done = false;
-      bool first = true;
+      int n_pings = 0;
       while (!done) {
         if (verbose > 1)
           fprintf(stderr, "\n");
@@ -782,25 +1341,26 @@ int main(int argc, char **argv) {
             pings[n_pings].multiplicity = 0;
           }
 
-          /* save relevant data */
+          /* save relevant data - soundings are placed using the heading
+              of their own ping */
           pings[n_pings].time_d = time_d;
           pings[n_pings].navlon = navlon;
           pings[n_pings].navlat = navlat;
           pings[n_pings].heading = heading;
           pings[n_pings].sensordepth = sensordepth;
           pings[n_pings].beams_bath = beams_bath;
-          const double sensorx = (navlon - mb_info.lon_start) / mtodeglon;
-          const double sensory = (navlat - mb_info.lat_start) / mtodeglat;
+          const double headingx = sin(heading * DTR);
+          const double headingy = cos(heading * DTR);
+          const double sensorx = (navlon - lon_origin) / mtodeglon;
+          const double sensory = (navlat - lat_origin) / mtodeglat;
           const double sensorz = -sensordepth;
           for (int j = 0; j < beams_bath; j++) {
             pings[n_pings].beamflag[j] = beamflag[j];
             pings[n_pings].beamflagorg[j] = beamflag[j];
             if (!mb_beam_check_flag_null(beamflag[j])) {
               pings[n_pings].bathacrosstrack[j] = bathacrosstrack[j];
-              pings[n_pings].bathx[j] = (navlon - mb_info.lon_start) / mtodeglon +
-                       headingy * bathacrosstrack[j] + headingx * bathalongtrack[j];
-              pings[n_pings].bathy[j] = (navlat - mb_info.lat_start) / mtodeglat -
-                       headingx * bathacrosstrack[j] + headingy * bathalongtrack[j];
+              pings[n_pings].bathx[j] = sensorx + headingy * bathacrosstrack[j] + headingx * bathalongtrack[j];
+              pings[n_pings].bathy[j] = sensory - headingx * bathacrosstrack[j] + headingy * bathalongtrack[j];
               pings[n_pings].bathz[j] = -bath[j];
               pings[n_pings].bathr[j] = sqrt((pings[n_pings].bathx[j] - sensorx)
                     * (pings[n_pings].bathx[j] - sensorx)
@@ -808,22 +1368,6 @@ int main(int argc, char **argv) {
                     * (pings[n_pings].bathy[j] - sensory)
                          + (pings[n_pings].bathz[j] - sensorz)
                     * (pings[n_pings].bathz[j] - sensorz));
-              if (first) {
-                  x_min = pings[n_pings].bathx[j];
-                  x_max = pings[n_pings].bathx[j];
-                  y_min = pings[n_pings].bathy[j];
-                  y_max = pings[n_pings].bathy[j];
-                  z_min = pings[n_pings].bathz[j];
-                  z_max = pings[n_pings].bathz[j];
-                  first = false;
-              } else {
-                  x_min = std::min(x_min, pings[n_pings].bathx[j]);
-                  x_max = std::max(x_max, pings[n_pings].bathx[j]);
-                  y_min = std::min(y_min, pings[n_pings].bathy[j]);
-                  y_max = std::max(y_max, pings[n_pings].bathy[j]);
-                  z_min = std::min(z_min, pings[n_pings].bathz[j]);
-                  z_max = std::max(z_max, pings[n_pings].bathz[j]);
-              }
 
               // apply amplitude filter here where amplitude values are available
               // = note that a density unflag setting could undo flags defined here
@@ -832,18 +1376,18 @@ int main(int argc, char **argv) {
                   if (apply_amplitude_minimum && amp[j] < amplitude_minimum) {
                     pings[n_pings].beamflag[j] = MB_FLAG_FLAG + MB_FLAG_FILTER;
                     const int action = MBP_EDIT_FILTER;
-                    mb_ess_save(verbose, &esf, pings[n_pings].time_d,
+                    mb_ess_save(verbose, &file->esf, pings[n_pings].time_d,
                         j + pings[n_pings].multiplicity * MB_ESF_MULTIPLICITY_FACTOR,
                         action, &error);
-                    n_minamplitude_flag++;
+                    count->n_minamplitude_flag++;
                   }
                   if (apply_amplitude_maximum && amp[j] > amplitude_maximum) {
                     pings[n_pings].beamflag[j] = MB_FLAG_FLAG + MB_FLAG_FILTER;
                     const int action = MBP_EDIT_FILTER;
-                    mb_ess_save(verbose, &esf, pings[n_pings].time_d,
+                    mb_ess_save(verbose, &file->esf, pings[n_pings].time_d,
                         j + pings[n_pings].multiplicity * MB_ESF_MULTIPLICITY_FACTOR,
                         action, &error);
-                    n_maxamplitude_flag++;
+                    count->n_maxamplitude_flag++;
                   }
                 }
               }
@@ -863,40 +1407,32 @@ int main(int argc, char **argv) {
               n_pings, j, pings[n_pings].bathx[j],
               pings[n_pings].bathy[j], pings[n_pings].bathz[j]);
             }
-
-            fprintf(stderr, "\ndbg2  current voxel bounds:\n");
-            fprintf(stderr, "dbg2    x_min: %10.3f m\n", x_min);
-            fprintf(stderr, "dbg2    x_max: %10.3f m\n", x_max);
-            fprintf(stderr, "dbg2    y_min: %10.3f m\n", y_min);
-            fprintf(stderr, "dbg2    y_max: %10.3f m\n", y_max);
-            fprintf(stderr, "dbg2    z_min: %10.3f m\n", z_min);
-            fprintf(stderr, "dbg2    z_max: %10.3f m\n", z_max);
           }
 
           /* update counters */
           for (int j = 0; j < pings[n_pings].beams_bath; j++) {
             if (mb_beam_ok(pings[n_pings].beamflag[j]))
-                 n_beamflag_good++;
+                 count->n_beamflag_good++;
             else if (pings[n_pings].beamflag[j] == MB_FLAG_NULL)
-                n_beamflag_null++;
+                count->n_beamflag_null++;
             else
-                n_beamflag_flag++;
+                count->n_beamflag_flag++;
           }
 
           /* apply saved edits */
-          status &= mb_esf_apply(verbose, &esf, pings[n_pings].time_d, pings[n_pings].multiplicity, pings[n_pings].beams_bath,
-                    pings[n_pings].beamflag, &error);
+          status &= mb_esf_apply(verbose, &file->esf, pings[n_pings].time_d, pings[n_pings].multiplicity,
+                    pings[n_pings].beams_bath, pings[n_pings].beamflag, &error);
 
           /* update counters */
           for (int j = 0; j < pings[n_pings].beams_bath; j++) {
             if (pings[n_pings].beamflag[j] != pings[n_pings].beamflagorg[j]) {
               if (mb_beam_ok(pings[n_pings].beamflag[j]))
-                n_esf_unflag++;
+                count->n_esf_unflag++;
               else
-                n_esf_flag++;
+                count->n_esf_flag++;
             }
           }
-          n_beams += pings[n_pings].beams_bath;
+          count->n_beams += pings[n_pings].beams_bath;
           n_pings++;
 
         }
@@ -904,333 +1440,25 @@ int main(int argc, char **argv) {
           done = true;
         }
       }
+      file->n_pings = n_pings;
+      count->n_pings = n_pings;
 
       /* close the swath file */
       status = mb_close(verbose, &mbio_ptr, &error);
 
-      /* apply acrosstrack filter to the soundings */
-      if (apply_acrosstrack_minimum || apply_acrosstrack_maximum) {
-        for (int i = 0; i < n_pings; i++) {
-          for (int j = 0; j< pings[i].beams_bath; j++) {
-            if (!mb_beam_check_flag_null(pings[i].beamflag[j])) {
-              if (apply_acrosstrack_minimum
-                && mb_beam_ok(pings[i].beamflag[j])
-                && pings[i].bathacrosstrack[j] < acrosstrack_minimum) {
-                pings[i].beamflag[j] = MB_FLAG_FLAG + MB_FLAG_FILTER;
-                const int action = MBP_EDIT_FILTER;
-                mb_ess_save(verbose, &esf, pings[i].time_d,
-                    j + pings[i].multiplicity * MB_ESF_MULTIPLICITY_FACTOR,
-                    action, &error);
-                n_minacrosstrack_flag++;
-              } else if (apply_acrosstrack_maximum
-                && mb_beam_ok(pings[i].beamflag[j])
-                && pings[i].bathacrosstrack[j] > acrosstrack_maximum) {
-                pings[i].beamflag[j] = MB_FLAG_FLAG + MB_FLAG_FILTER;
-                const int action = MBP_EDIT_FILTER;
-                mb_ess_save(verbose, &esf, pings[i].time_d,
-                    j + pings[i].multiplicity * MB_ESF_MULTIPLICITY_FACTOR,
-                    action, &error);
-                n_maxacrosstrack_flag++;
-              }
-            }
-          }
-        }
-      }
-
-      /* apply range filter to the soundings */
-      if (apply_range_minimum || apply_range_maximum) {
-        for (int i = 0; i < n_pings; i++) {
-          for (int j = 0; j< pings[i].beams_bath; j++) {
-            if (!mb_beam_check_flag_null(pings[i].beamflag[j])) {
-              if (apply_range_minimum
-                && mb_beam_ok(pings[i].beamflag[j])
-                && pings[i].bathr[j] < range_minimum) {
-                pings[i].beamflag[j] = MB_FLAG_FLAG + MB_FLAG_FILTER;
-                const int action = MBP_EDIT_FILTER;
-                mb_ess_save(verbose, &esf, pings[i].time_d,
-                    j + pings[i].multiplicity * MB_ESF_MULTIPLICITY_FACTOR,
-                    action, &error);
-                n_minrange_flag++;
-              } else if (apply_range_maximum
-                && mb_beam_ok(pings[i].beamflag[j])
-                && pings[i].bathr[j] > range_maximum) {
-                pings[i].beamflag[j] = MB_FLAG_FLAG + MB_FLAG_FILTER;
-                const int action = MBP_EDIT_FILTER;
-                mb_ess_save(verbose, &esf, pings[i].time_d,
-                    j + pings[i].multiplicity * MB_ESF_MULTIPLICITY_FACTOR,
-                    action, &error);
-                n_maxrange_flag++;
-              }
-            }
-          }
-        }
-      }
-
-      // allocate arrays of voxel beam counts - use unsigned char so that beam
-      // counts are capped at 255 - ergo the maximum occupied count threshold
-      // is 254
-      const int n_voxel_x = (x_max - x_min) / voxel_size_xy + 3;
-      x_min = x_min - 0.5 * voxel_size_xy;
-      x_max = x_min + n_voxel_x * voxel_size_xy;
-      const int n_voxel_y = (x_max - y_min) / voxel_size_xy + 3;
-      y_min = y_min - 0.5 * voxel_size_xy;
-      y_max = y_min + n_voxel_y * voxel_size_xy;
-      const int n_voxel_z = (z_max - z_min) / voxel_size_z + 3;
-      z_min = z_min - 0.5 * voxel_size_z;
-      z_max = z_min + n_voxel_z * voxel_size_z;
-      int n_voxel = n_voxel_x * n_voxel_y * n_voxel_z;
-      if (verbose >= 2) {
-        fprintf(stderr, "\ndbg2  final voxel bounds:\n");
-        fprintf(stderr, "dbg2    x_min:      %10.3f m\n", x_min);
-        fprintf(stderr, "dbg2    x_max:      %10.3f m\n", x_max);
-        fprintf(stderr, "dbg2    y_min:      %10.3f m\n", y_min);
-        fprintf(stderr, "dbg2    y_max:      %10.3f m\n", y_max);
-        fprintf(stderr, "dbg2    z_min:      %10.3f m\n", z_min);
-        fprintf(stderr, "dbg2    z_max:      %10.3f m\n", z_max);
-        fprintf(stderr, "dbg2    n_voxel_x:  %d\n", n_voxel_x);
-        fprintf(stderr, "dbg2    n_voxel_y:  %d\n", n_voxel_y);
-        fprintf(stderr, "dbg2    n_voxel_z:  %d\n", n_voxel_z);
-        fprintf(stderr, "dbg2    n_voxel:    %d\n", n_voxel);
-      }
-      if (n_voxel_alloc < n_voxel) {
-        status &= mb_reallocd(verbose, __FILE__, __LINE__, (size_t)n_voxel,
-             (void **)&voxel_count, &error);
-        if (error != MB_ERROR_NO_ERROR) {
-          char *message = nullptr;
-          mb_error(verbose, MB_ERROR_MEMORY_FAIL, &message);
-          fprintf(outfp, "\nMBIO Error allocating voxel counting arrays:\n%s\n", message);
-          fprintf(outfp, "\nProgram <%s> Terminated\n", program_name);
-          mb_memory_clear(verbose, &error);
-          exit(error);
-        }
-        memset((void *)voxel_count, 0, (size_t)n_voxel);
-        n_voxel_alloc = n_voxel;
-      }
-
-      /* count the soundings in each voxel */
-      for (int i = 0; i < n_pings; i++) {
-        for (int j = 0; j< pings[i].beams_bath; j++) {
-          if (!mb_beam_check_flag_null(pings[i].beamflag[j])) {
-            const int ix = (pings[i].bathx[j] - x_min) / voxel_size_xy;
-            const int iy = (pings[i].bathy[j] - y_min) / voxel_size_xy;
-            const int iz = (pings[i].bathz[j] - z_min) / voxel_size_z;
-            const int kk = (ix * n_voxel_y + iy) * n_voxel_z + iz;
-            if ((mb_beam_ok(pings[i].beamflag[j]) || count_flagged) && voxel_count[kk] < 254) {
-              voxel_count[kk]++;
-            }
-          }
-        }
-      }
-
-      // apply neighborhood to extend occupied region
-      if (neighborhood > 0) {
-
-        for (int ix=0; ix<n_voxel_x; ix++) {
-          for (int iy=0; iy<n_voxel_y; iy++) {
-            for (int iz=0; iz<n_voxel_z; iz++) {
-              const int kk = (ix * n_voxel_y + iy) * n_voxel_z + iz;
-
-              if (voxel_count[kk] >= occupy_threshold && voxel_count[kk] < 255) {
-                for (int iix=std::max(ix-neighborhood,0); iix<std::min(ix+neighborhood+1,n_voxel_x); iix++) {
-                  for (int iiy=std::max(iy-neighborhood,0); iiy<std::min(iy+neighborhood+1,n_voxel_y); iiy++) {
-                    for (int iiz=std::max(iz-neighborhood,0); iiz<std::min(iz+neighborhood+1,n_voxel_z); iiz++) {
-                      const int kkk = (iix * n_voxel_y + iiy) * n_voxel_z + iiz;
-                      if (voxel_count[kkk] < occupy_threshold) {
-                        voxel_count[kkk] = 255;
-                      }
-                    }
-                  }
-                }
-              }
+      /* apply acrosstrack and range filters to the soundings */
+      mbvoxelclean_filter_range(verbose, &filter, file, &error);
 
-            }
-          }
-        }
+      /* clean this file on its own, or leave it in memory until all of the
+          files have been read */
+      if (cross_file) {
+        n_files++;
       }
-
-      // apply threshold to generate binary mask of occupied voxels
-      for (int kk = 0; kk < n_voxel; kk++) {
-        if (voxel_count[kk] >= occupy_threshold) {
-          voxel_count[kk] = 1;
-        }
-        else if (voxel_count[kk] < occupy_threshold) {
-          voxel_count[kk] = 0;
-        }
-      }
-
-      /* apply density filter to the soundings  */
-      if (occupied_mode == MBVC_OCCUPIED_UNFLAG || empty_mode == MBVC_EMPTY_FLAG) {
-        for (int i = 0; i < n_pings; i++) {
-          for (int j = 0; j < pings[i].beams_bath; j++) {
-            if (!mb_beam_check_flag_null(pings[i].beamflag[j])) {
-              const int ix = (pings[i].bathx[j] - x_min) / voxel_size_xy;
-              const int iy = (pings[i].bathy[j] - y_min) / voxel_size_xy;
-              const int iz = (pings[i].bathz[j] - z_min) / voxel_size_z;
-              const int kk = (ix * n_voxel_y + iy) * n_voxel_z + iz;
-              if (occupied_mode == MBVC_OCCUPIED_UNFLAG
-                && voxel_count[kk]
-                && !mb_beam_ok(pings[i].beamflag[j])) {
-                pings[i].beamflag[j] = MB_FLAG_NONE;
-                const int action = MBP_EDIT_UNFLAG;
-                mb_ess_save(verbose, &esf, pings[i].time_d,
-                    j + pings[i].multiplicity * MB_ESF_MULTIPLICITY_FACTOR,
-                    action, &error);
-                n_density_unflag++;
-              }
-              if (empty_mode == MBVC_EMPTY_FLAG
-                && !voxel_count[kk]
-                && mb_beam_ok(pings[i].beamflag[j])) {
-                pings[i].beamflag[j] = MB_FLAG_FLAG + MB_FLAG_FILTER;
-                const int action = MBP_EDIT_FILTER;
-                mb_ess_save(verbose, &esf, pings[i].time_d,
-                      j + pings[i].multiplicity * MB_ESF_MULTIPLICITY_FACTOR,
-                      action, &error);
-                n_density_flag++;
-              }
-            }
-          }
-        }
-      }
-
-      /* apply acrosstrack filter to the soundings */
-      if (apply_acrosstrack_minimum || apply_acrosstrack_maximum) {
-        for (int i = 0; i < n_pings; i++) {
-          for (int j = 0; j< pings[i].beams_bath; j++) {
-            if (!mb_beam_check_flag_null(pings[i].beamflag[j])) {
-              if (apply_acrosstrack_minimum
-                && mb_beam_ok(pings[i].beamflag[j])
-                && pings[i].bathacrosstrack[j] < acrosstrack_minimum) {
-                pings[i].beamflag[j] = MB_FLAG_FLAG + MB_FLAG_FILTER;
-                const int action = MBP_EDIT_FILTER;
-                mb_ess_save(verbose, &esf, pings[i].time_d,
-                    j + pings[i].multiplicity * MB_ESF_MULTIPLICITY_FACTOR,
-                    action, &error);
-                n_minacrosstrack_flag++;
-              } else if (apply_acrosstrack_maximum
-                && mb_beam_ok(pings[i].beamflag[j])
-                && pings[i].bathacrosstrack[j] > acrosstrack_maximum) {
-                pings[i].beamflag[j] = MB_FLAG_FLAG + MB_FLAG_FILTER;
-                const int action = MBP_EDIT_FILTER;
-                mb_ess_save(verbose, &esf, pings[i].time_d,
-                    j + pings[i].multiplicity * MB_ESF_MULTIPLICITY_FACTOR,
-                    action, &error);
-                n_maxacrosstrack_flag++;
-              }
-            }
-          }
-        }
-      }
-
-      /* apply range filter to the soundings */
-      if (apply_range_minimum || apply_range_maximum) {
-        for (int i = 0; i < n_pings; i++) {
-          for (int j = 0; j< pings[i].beams_bath; j++) {
-            if (!mb_beam_check_flag_null(pings[i].beamflag[j])) {
-              if (apply_range_minimum
-                && mb_beam_ok(pings[i].beamflag[j])
-                && pings[i].bathr[j] < range_minimum) {
-                pings[i].beamflag[j] = MB_FLAG_FLAG + MB_FLAG_FILTER;
-                const int action = MBP_EDIT_FILTER;
-                mb_ess_save(verbose, &esf, pings[i].time_d,
-                    j + pings[i].multiplicity * MB_ESF_MULTIPLICITY_FACTOR,
-                    action, &error);
-                n_minrange_flag++;
-              } else if (apply_range_maximum
-                && mb_beam_ok(pings[i].beamflag[j])
-                && pings[i].bathr[j] > range_maximum) {
-                pings[i].beamflag[j] = MB_FLAG_FLAG + MB_FLAG_FILTER;
-                const int action = MBP_EDIT_FILTER;
-                mb_ess_save(verbose, &esf, pings[i].time_d,
-                    j + pings[i].multiplicity * MB_ESF_MULTIPLICITY_FACTOR,
-                    action, &error);
-                n_maxrange_flag++;
-              }
-            }
-          }
-        }
-      }
-
-      /* write out edits for beamflags that have changed  */
-      for (int i = 0; i < n_pings; i++) {
-        for (int j = 0; j< pings[i].beams_bath; j++) {
-          if (pings[i].beamflag[j] != pings[i].beamflagorg[j]) {
-            int action = MBP_EDIT_ZERO;
-            if (mb_beam_ok(pings[i].beamflag[j])) {
-              action = MBP_EDIT_UNFLAG;
-            }
-            else if (mb_beam_check_flag_filter2(pings[i].beamflag[j])) {
-              action = MBP_EDIT_FILTER;
-            }
-            else if (mb_beam_check_flag_filter(pings[i].beamflag[j])) {
-              action = MBP_EDIT_FILTER;
-            }
-            else if (pings[i].beamflag[j] != MB_FLAG_NULL) {
-              action = MBP_EDIT_FLAG;
-            }
-            else {
-              action = MBP_EDIT_ZERO;
-            }
-            mb_esf_save(verbose, &esf, pings[i].time_d,
-                        j + pings[i].multiplicity * MB_ESF_MULTIPLICITY_FACTOR, action, &error);
-          }
-        }
-      }
-
-      /* close edit save file */
-      status = mb_esf_close(verbose, &esf, &error);
-
-      /* update mbprocess parameter file */
-      if (esffile_open) {
-        /* update mbprocess parameter file */
-        status = mb_pr_update_format(verbose, swathfile, true, format, &error);
-        status = mb_pr_update_edit(verbose, swathfile, MBP_EDIT_ON, esffile, &error);
-      }
-
-      /* unlock the raw swath file */
-      if (uselockfiles)
-        status = mb_pr_unlockswathfile(verbose, swathfile, MBP_LOCK_EDITBATHY, program_name, &error);
-
-      /* check memory */
-      if (verbose >= 4)
-        status = mb_memory_list(verbose, &error);
-
-      /* increment the total counting variables */
-      n_files_tot++;
-      n_pings_tot += n_pings;
-      n_beams_tot += n_beams;
-      n_beamflag_null_tot += n_beamflag_null;
-      n_beamflag_good_tot += n_beamflag_good;
-      n_beamflag_flag_tot += n_beamflag_flag;
-      n_esf_flag_tot += n_esf_flag;
-      n_esf_unflag_tot += n_esf_unflag;
-      n_density_flag_tot += n_density_flag;
-      n_density_unflag_tot += n_density_unflag;
-      n_minrange_flag_tot += n_minrange_flag;
-      n_maxrange_flag_tot += n_maxrange_flag;
-      n_minacrosstrack_flag_tot += n_minacrosstrack_flag;
-      n_maxacrosstrack_flag_tot += n_maxacrosstrack_flag;
-      n_minamplitude_flag_tot += n_minamplitude_flag;
-      n_maxamplitude_flag_tot += n_maxamplitude_flag;
-
-      /* give the statistics */
-      if (verbose >= 1) {
-        fprintf(stderr, "%7d survey data records processed\n", n_pings);
-        fprintf(stderr, "%7d soundings processed\n", n_beams);
-        fprintf(stderr, "%7d beams good originally\n", n_beamflag_good);
-        fprintf(stderr, "%7d beams flagged originally\n", n_beamflag_flag);
-        fprintf(stderr, "%7d beams null originally\n", n_beamflag_null);
-        if (esf.nedit > 0) {
-          fprintf(stderr, "%7d beams flagged in old esf file\n", n_esf_flag);
-          fprintf(stderr, "%7d beams unflagged in old esf file\n", n_esf_unflag);
-        }
-        fprintf(stderr, "%7d beams flagged by density filter\n", n_density_flag);
-        fprintf(stderr, "%7d beams unflagged by density filter\n", n_density_unflag);
-        fprintf(stderr, "%7d beams flagged by minimum range filter\n", n_minrange_flag);
-        fprintf(stderr, "%7d beams flagged by maximum range filter\n", n_maxrange_flag);
-        fprintf(stderr, "%7d beams flagged by minimum acrosstrack filter\n", n_minacrosstrack_flag);
-        fprintf(stderr, "%7d beams flagged by maximum acrosstrack filter\n", n_maxacrosstrack_flag);
-        fprintf(stderr, "%7d beams flagged by minimum amplitude filter\n", n_minamplitude_flag);
-        fprintf(stderr, "%7d beams flagged by maximum amplitude filter\n", n_maxamplitude_flag);
+      else {
+        mbvoxelclean_count_voxels(verbose, &filter, file, 1, &voxelsets, n_threads, &error);
+        mbvoxelclean_filter_density(verbose, &filter, voxelsets, file, &error);
+        mbvoxelclean_filter_range(verbose, &filter, file, &error);
+        mbvoxelclean_finish_file(verbose, file, uselockfiles, &total, &error);
       }
     }
 
@@ -1247,41 +1475,60 @@ int main(int argc, char **argv) {
   if (read_datalist)
     mb_datalist_close(verbose, &datalist, &error);
 
+  /* with cross-file cleaning the soundings of every file count towards the
+      voxels, and then the edits are output to each file's own edit save file */
+  if (cross_file && n_files > 0) {
+    if (verbose > 0) {
+      fprintf(stderr, "---------------------------------\n");
+      fprintf(stderr, "Counting soundings of %d files in voxels...\n", n_files);
+    }
+    mbvoxelclean_count_voxels(verbose, &filter, files, n_files, &voxelsets, n_threads, &error);
+    for (int ifile = 0; ifile < n_files; ifile++) {
+      mbvoxelclean_filter_density(verbose, &filter, voxelsets, &files[ifile], &error);
+      mbvoxelclean_filter_range(verbose, &filter, &files[ifile], &error);
+      mbvoxelclean_finish_file(verbose, &files[ifile], uselockfiles, &total, &error);
+    }
+  }
+  voxelsets.clear();
+
   /* give the total statistics */
   if (verbose > 0) {
     fprintf(stderr, "\n---------------------------------\n");
     fprintf(stderr, "MBvoxelclean Processing Totals:\n");
     fprintf(stderr, "---------------------------------\n");
-    fprintf(stderr, "%d total swath data files processed\n", n_files_tot);
-    fprintf(stderr, "%d total survey data records processed\n", n_pings_tot);
-    fprintf(stderr, "%d total soundings processed\n", n_beams_tot);
-    fprintf(stderr, "%d total beams good originally\n", n_beamflag_good_tot);
-    fprintf(stderr, "%d total beams flagged originally\n", n_beamflag_flag_tot);
-    fprintf(stderr, "%d total beams null originally\n", n_beamflag_null_tot);
-    fprintf(stderr, "%d total beams flagged in old esf file\n", n_esf_flag_tot);
-    fprintf(stderr, "%d total beams unflagged in old esf file\n", n_esf_unflag_tot);
-    fprintf(stderr, "%d total beams flagged by density filter\n", n_density_flag_tot);
-    fprintf(stderr, "%d total beams unflagged by density filter\n", n_density_unflag_tot);
-    fprintf(stderr, "%d total beams flagged by minimum range filter\n", n_minrange_flag_tot);
-    fprintf(stderr, "%d total beams flagged by maximum range filter\n", n_maxrange_flag_tot);
-    fprintf(stderr, "%d total beams flagged by minimum acrosstrack filter\n", n_minacrosstrack_flag_tot);
-    fprintf(stderr, "%d total beams flagged by maximum acrosstrack filter\n", n_maxacrosstrack_flag_tot);
-    fprintf(stderr, "%d total beams flagged by minimum amplitude filter\n", n_minamplitude_flag_tot);
-    fprintf(stderr, "%d total beams flagged by maximum amplitude filter\n", n_maxamplitude_flag_tot);
+    fprintf(stderr, "%d total swath data files processed\n", total.n_files);
+    fprintf(stderr, "%d total survey data records processed\n", total.n_pings);
+    fprintf(stderr, "%d total soundings processed\n", total.n_beams);
+    fprintf(stderr, "%d total beams good originally\n", total.n_beamflag_good);
+    fprintf(stderr, "%d total beams flagged originally\n", total.n_beamflag_flag);
+    fprintf(stderr, "%d total beams null originally\n", total.n_beamflag_null);
+    fprintf(stderr, "%d total beams flagged in old esf file\n", total.n_esf_flag);
+    fprintf(stderr, "%d total beams unflagged in old esf file\n", total.n_esf_unflag);
+    fprintf(stderr, "%d total beams flagged by density filter\n", total.n_density_flag);
+    fprintf(stderr, "%d total beams unflagged by density filter\n", total.n_density_unflag);
+    fprintf(stderr, "%d total beams flagged by minimum range filter\n", total.n_minrange_flag);
+    fprintf(stderr, "%d total beams flagged by maximum range filter\n", total.n_maxrange_flag);
+    fprintf(stderr, "%d total beams flagged by minimum acrosstrack filter\n", total.n_minacrosstrack_flag);
+    fprintf(stderr, "%d total beams flagged by maximum acrosstrack filter\n", total.n_maxacrosstrack_flag);
+    fprintf(stderr, "%d total beams flagged by minimum amplitude filter\n", total.n_minamplitude_flag);
+    fprintf(stderr, "%d total beams flagged by maximum amplitude filter\n", total.n_maxamplitude_flag);
   }
 
-  for (int i = 0; i<npings_alloc; i++) {
-    status &= mb_freed(verbose, __FILE__, __LINE__, (void **)&pings[i].beamflag, &error);
-    status &= mb_freed(verbose, __FILE__, __LINE__, (void **)&pings[i].beamflagorg, &error);
-    status &= mb_freed(verbose, __FILE__, __LINE__, (void **)&pings[i].bathacrosstrack, &error);
-    status &= mb_freed(verbose, __FILE__, __LINE__, (void **)&pings[i].bathz, &error);
-    status &= mb_freed(verbose, __FILE__, __LINE__, (void **)&pings[i].bathx, &error);
-    status &= mb_freed(verbose, __FILE__, __LINE__, (void **)&pings[i].bathy, &error);
-    status &= mb_freed(verbose, __FILE__, __LINE__, (void **)&pings[i].bathr, &error);
-    pings[i].beams_bath_alloc = 0;
+  for (int ifile = 0; ifile < n_files_alloc; ifile++) {
+    struct mbvoxelclean_ping_struct *pings = files[ifile].pings;
+    for (int i = 0; i < files[ifile].npings_alloc; i++) {
+      status &= mb_freed(verbose, __FILE__, __LINE__, (void **)&pings[i].beamflag, &error);
+      status &= mb_freed(verbose, __FILE__, __LINE__, (void **)&pings[i].beamflagorg, &error);
+      status &= mb_freed(verbose, __FILE__, __LINE__, (void **)&pings[i].bathacrosstrack, &error);
+      status &= mb_freed(verbose, __FILE__, __LINE__, (void **)&pings[i].bathz, &error);
+      status &= mb_freed(verbose, __FILE__, __LINE__, (void **)&pings[i].bathx, &error);
+      status &= mb_freed(verbose, __FILE__, __LINE__, (void **)&pings[i].bathy, &error);
+      status &= mb_freed(verbose, __FILE__, __LINE__, (void **)&pings[i].bathr, &error);
+      pings[i].beams_bath_alloc = 0;
+    }
+    status &= mb_freed(verbose, __FILE__, __LINE__, (void **)&files[ifile].pings, &error);
   }
-  status &= mb_freed(verbose, __FILE__, __LINE__, (void **)&pings, &error);
-  status &= mb_freed(verbose, __FILE__, __LINE__, (void **)&voxel_count, &error);
+  status &= mb_freed(verbose, __FILE__, __LINE__, (void **)&files, &error);
 
   /* check memory */
   if ((status = mb_memory_list(verbose, &error)) == MB_FAILURE) {
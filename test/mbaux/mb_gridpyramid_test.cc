@@ -0,0 +1,173 @@
+// See README file for copying and redistribution conditions.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "mb_aux.h"
+#include "mb_define.h"
+#include "mb_status.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace {
+
+constexpr int kNumColumns = 600;
+constexpr int kNumRows = 300;
+constexpr float kNoData = -99999.0;
+constexpr double kXmin = 10.0;
+constexpr double kYmin = 20.0;
+constexpr double kDx = 0.5;
+constexpr double kDy = 0.25;
+
+// A plane with a block of missing nodes, so that the smoothed levels of
+// the pyramid reproduce it exactly away from the block and the edges.
+bool Missing(int i, int j) { return i >= 100 && i < 140 && j >= 50 && j < 70; }
+float Value(int i, int j) { return Missing(i, j) ? kNoData : static_cast<float>(i + 1000 * j); }
+bool Interior(int i, int j) {
+  for (int ii = i - 1; ii <= i + 1; ii++)
+    for (int jj = j - 1; jj <= j + 1; jj++)
+      if (ii < 0 || ii >= kNumColumns || jj < 0 || jj >= kNumRows || Missing(ii, jj))
+        return false;
+  return true;
+}
+
+class MbGridPyramidTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    char path[] = "/tmp/mb_gridpyramid_testXXXXXX";
+    const int fd = mkstemp(path);
+    ASSERT_NE(-1, fd);
+    ASSERT_EQ(4, write(fd, "grid", 4));
+    close(fd);
+    path_ = path;
+    data_.resize(kNumColumns * kNumRows);
+    for (int i = 0; i < kNumColumns; i++)
+      for (int j = 0; j < kNumRows; j++)
+        data_[i * kNumRows + j] = Value(i, j);
+  }
+
+  void TearDown() override {
+    unlink(path_.c_str());
+    unlink((path_ + ".mbpyr").c_str());
+  }
+
+  int Write() {
+    int error = MB_ERROR_NO_ERROR;
+    return mb_gridpyramid_write(0, path_.c_str(), 0, "Geographic WGS84", kNoData, kNumColumns, kNumRows, 0.0,
+                                kNumColumns - 1 + 1000.0 * (kNumRows - 1), kXmin, kXmin + kDx * (kNumColumns - 1), kYmin,
+                                kYmin + kDy * (kNumRows - 1), kDx, kDy, data_.data(), &error);
+  }
+
+  std::string path_;
+  std::vector<float> data_;
+};
+
+TEST_F(MbGridPyramidTest, Levels) {
+  ASSERT_EQ(MB_SUCCESS, Write());
+  struct mb_gridpyramid_struct *pyramid = nullptr;
+  int error = MB_ERROR_NO_ERROR;
+  ASSERT_EQ(MB_SUCCESS, mb_gridpyramid_open(0, path_.c_str(), &pyramid, &error));
+  EXPECT_EQ(3, pyramid->num_levels);
+  EXPECT_EQ(600, pyramid->n_columns[0]);
+  EXPECT_EQ(300, pyramid->n_rows[0]);
+  EXPECT_EQ(300, pyramid->n_columns[1]);
+  EXPECT_EQ(150, pyramid->n_rows[1]);
+  EXPECT_EQ(150, pyramid->n_columns[2]);
+  EXPECT_EQ(75, pyramid->n_rows[2]);
+  EXPECT_STREQ("Geographic WGS84", pyramid->projection_id);
+  EXPECT_EQ(kNoData, pyramid->nodatavalue);
+  EXPECT_DOUBLE_EQ(kDx, pyramid->dx);
+
+  int level = -1;
+  EXPECT_EQ(MB_SUCCESS, mb_gridpyramid_getlevel(0, pyramid, 0, kNumColumns - 1, 0, kNumRows - 1,
+                                                kNumColumns * kNumRows, &level, &error));
+  EXPECT_EQ(0, level);
+  EXPECT_EQ(MB_SUCCESS, mb_gridpyramid_getlevel(0, pyramid, 0, kNumColumns - 1, 0, kNumRows - 1, 300 * 150, &level, &error));
+  EXPECT_EQ(1, level);
+  EXPECT_EQ(MB_SUCCESS, mb_gridpyramid_getlevel(0, pyramid, 0, kNumColumns - 1, 0, kNumRows - 1, 1, &level, &error));
+  EXPECT_EQ(2, level);
+  EXPECT_EQ(MB_SUCCESS, mb_gridpyramid_getlevel(0, pyramid, 0, 99, 0, 99, 100 * 100, &level, &error));
+  EXPECT_EQ(0, level);
+
+  EXPECT_EQ(MB_SUCCESS, mb_gridpyramid_close(0, &pyramid, &error));
+  EXPECT_EQ(nullptr, pyramid);
+}
+
+TEST_F(MbGridPyramidTest, ReadFullResolutionAcrossTiles) {
+  ASSERT_EQ(MB_SUCCESS, Write());
+  struct mb_gridpyramid_struct *pyramid = nullptr;
+  int error = MB_ERROR_NO_ERROR;
+  ASSERT_EQ(MB_SUCCESS, mb_gridpyramid_open(0, path_.c_str(), &pyramid, &error));
+
+  const int ixmin = 250, ixmax = 520, jymin = 3, jymax = 299;
+  const int n_rows = jymax - jymin + 1;
+  std::vector<float> region((ixmax - ixmin + 1) * n_rows);
+  double min = 0.0, max = 0.0;
+  ASSERT_EQ(MB_SUCCESS, mb_gridpyramid_read(0, pyramid, 0, ixmin, ixmax, jymin, jymax, region.data(), &min, &max, &error));
+  for (int i = ixmin; i <= ixmax; i++)
+    for (int j = jymin; j <= jymax; j++)
+      ASSERT_EQ(Value(i, j), region[(i - ixmin) * n_rows + j - jymin]) << i << " " << j;
+  EXPECT_DOUBLE_EQ(ixmin + 1000.0 * jymin, min);
+  EXPECT_DOUBLE_EQ(ixmax + 1000.0 * jymax, max);
+
+  EXPECT_EQ(MB_FAILURE, mb_gridpyramid_read(0, pyramid, 0, 0, kNumColumns, 0, 0, region.data(), &min, &max, &error));
+  EXPECT_EQ(MB_ERROR_BAD_PARAMETER, error);
+
+  mb_gridpyramid_close(0, &pyramid, &error);
+}
+
+TEST_F(MbGridPyramidTest, ReducedLevelsKeepMissingNodes) {
+  ASSERT_EQ(MB_SUCCESS, Write());
+  struct mb_gridpyramid_struct *pyramid = nullptr;
+  int error = MB_ERROR_NO_ERROR;
+  ASSERT_EQ(MB_SUCCESS, mb_gridpyramid_open(0, path_.c_str(), &pyramid, &error));
+
+  const int n_columns = pyramid->n_columns[1];
+  const int n_rows = pyramid->n_rows[1];
+  std::vector<float> level(n_columns * n_rows);
+  double min = 0.0, max = 0.0;
+  ASSERT_EQ(MB_SUCCESS,
+            mb_gridpyramid_read(0, pyramid, 1, 0, n_columns - 1, 0, n_rows - 1, level.data(), &min, &max, &error));
+  for (int i = 0; i < n_columns; i++) {
+    for (int j = 0; j < n_rows; j++) {
+      const float value = level[i * n_rows + j];
+      if (Missing(2 * i, 2 * j))
+        ASSERT_EQ(kNoData, value) << i << " " << j;
+      else if (Interior(2 * i, 2 * j))
+        ASSERT_FLOAT_EQ(Value(2 * i, 2 * j), value) << i << " " << j;
+      else
+        ASSERT_NE(kNoData, value) << i << " " << j;
+    }
+  }
+
+  mb_gridpyramid_close(0, &pyramid, &error);
+}
+
+TEST_F(MbGridPyramidTest, StalePyramidIsRejected) {
+  ASSERT_EQ(MB_SUCCESS, Write());
+  FILE *fp = fopen(path_.c_str(), "ab");
+  ASSERT_NE(nullptr, fp);
+  fputs("changed", fp);
+  fclose(fp);
+
+  struct mb_gridpyramid_struct *pyramid = nullptr;
+  int error = MB_ERROR_NO_ERROR;
+  EXPECT_EQ(MB_FAILURE, mb_gridpyramid_open(0, path_.c_str(), &pyramid, &error));
+  EXPECT_EQ(MB_ERROR_BAD_FORMAT, error);
+  EXPECT_EQ(nullptr, pyramid);
+}
+
+TEST_F(MbGridPyramidTest, MissingPyramid) {
+  struct mb_gridpyramid_struct *pyramid = nullptr;
+  int error = MB_ERROR_NO_ERROR;
+  EXPECT_EQ(MB_FAILURE, mb_gridpyramid_open(0, path_.c_str(), &pyramid, &error));
+  EXPECT_EQ(MB_ERROR_OPEN_FAIL, error);
+}
+
+}  // namespace
@@ -0,0 +1,214 @@
+// See README file for copying and redistribution conditions.
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "mb_define.h"
+#include "mb_process.h"
+#include "mb_status.h"
+#include "mb_swap.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace {
+
+constexpr int kNumPings = 300;
+constexpr int kNumBeams = 40;
+
+struct Edit {
+  double time_d;
+  int beam;
+  int action;
+};
+
+double PingTime(int iping) { return 1.5e9 + 0.37 * iping; }
+
+class MbEsfTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    char dir[] = "/tmp/mb_esf_test_XXXXXX";
+    ASSERT_NE(nullptr, mkdtemp(dir));
+    esffile_ = std::string(dir) + "/data.mb88.esf";
+    memset(&esf_, 0, sizeof(esf_));
+  }
+
+  void TearDown() override {
+    int error = MB_ERROR_NO_ERROR;
+    mb_esf_close(0, &esf_, &error);
+    unlink(esffile_.c_str());
+    rmdir(esffile_.substr(0, esffile_.rfind('/')).c_str());
+  }
+
+  // Writes the edits the way mb_esf_save() does, after a header unless
+  // version is 1.
+  void Write(const std::vector<Edit> &edits, int version) {
+    FILE *fp = fopen(esffile_.c_str(), "wb");
+    ASSERT_NE(nullptr, fp);
+    if (version > 1) {
+      char header[MB_PATH_MAXLINE];
+      memset(header, 0, sizeof(header));
+      snprintf(header, sizeof(header), "ESFVERSION%2.2d\nESF Mode: %d\n", version, MB_ESF_MODE_EXPLICIT);
+      ASSERT_EQ(1u, fwrite(header, sizeof(header), 1, fp));
+    }
+    const bool byteswapped = mb_swap_check();
+    for (Edit edit : edits) {
+      if (byteswapped) {
+        mb_swap_double(&edit.time_d);
+        edit.beam = mb_swap_int(edit.beam);
+        edit.action = mb_swap_int(edit.action);
+      }
+      ASSERT_EQ(1u, fwrite(&edit.time_d, sizeof(double), 1, fp));
+      ASSERT_EQ(1u, fwrite(&edit.beam, sizeof(int), 1, fp));
+      ASSERT_EQ(1u, fwrite(&edit.action, sizeof(int), 1, fp));
+    }
+    fclose(fp);
+  }
+
+  void Load() {
+    int error = MB_ERROR_NO_ERROR;
+    ASSERT_EQ(MB_SUCCESS, mb_esf_open(0, "mb_esf_test", &esffile_[0], true, MBP_ESF_NOWRITE, &esf_, &error));
+  }
+
+  std::string esffile_;
+  struct mb_esf_struct esf_;
+};
+
+// Applies the edits in the order they were made.
+void ApplyReference(const std::vector<Edit> &edits, double time_d, int multiplicity, char *beamflag) {
+  for (const Edit &edit : edits) {
+    const int i = edit.beam - multiplicity * MB_ESF_MULTIPLICITY_FACTOR;
+    if (edit.time_d != time_d || i < 0 || i >= kNumBeams || mb_beam_check_flag_unusable(beamflag[i]))
+      continue;
+    if (edit.action == MBP_EDIT_FLAG)
+      beamflag[i] = mb_beam_set_flag_manual(beamflag[i]);
+    else if (edit.action == MBP_EDIT_FILTER)
+      beamflag[i] = mb_beam_set_flag_filter(beamflag[i]);
+    else if (edit.action == MBP_EDIT_SONAR)
+      beamflag[i] = mb_beam_set_flag_sonar(beamflag[i]);
+    else if (edit.action == MBP_EDIT_UNFLAG)
+      beamflag[i] = mb_beam_set_flag_none(beamflag[i]);
+    else if (edit.action == MBP_EDIT_ZERO)
+      beamflag[i] = mb_beam_set_flag_null(beamflag[i]);
+  }
+}
+
+void InitialFlags(int iping, char *beamflag) {
+  for (int i = 0; i < kNumBeams; i++) {
+    const int k = (iping * 7 + i * 3) % 11;
+    beamflag[i] = k == 0 ? MB_FLAG_NULL : k == 1 ? (char)(MB_FLAG_FLAG | MB_FLAG_FILTER) : MB_FLAG_NONE;
+  }
+}
+
+// Edits from several editing sessions appended to one file, so the beams
+// of a ping are edited repeatedly and the pings are out of order.
+std::vector<Edit> MakeSessions(int nsession) {
+  const int actions[] = {MBP_EDIT_FLAG, MBP_EDIT_UNFLAG, MBP_EDIT_ZERO, MBP_EDIT_FILTER, MBP_EDIT_SONAR};
+  std::vector<Edit> edits;
+  srand(11);
+  for (int isession = 0; isession < nsession; isession++) {
+    for (int n = 0; n < 4000; n++) {
+      const int iping = rand() % kNumPings;
+      const int multiplicity = iping % 10 == 0 ? rand() % 2 : 0;
+      int action = actions[rand() % 5];
+      // keep zeroing rare so most beams stay editable
+      if (action == MBP_EDIT_ZERO && rand() % 4 != 0)
+        action = MBP_EDIT_FLAG;
+      edits.push_back({PingTime(iping), rand() % kNumBeams + multiplicity * MB_ESF_MULTIPLICITY_FACTOR, action});
+    }
+  }
+  return edits;
+}
+
+TEST_F(MbEsfTest, MatchesEditsInOrder) {
+  const std::vector<Edit> edits = MakeSessions(5);
+  Write(edits, 3);
+  Load();
+  EXPECT_EQ(3, esf_.version);
+  EXPECT_LT(esf_.nedit, static_cast<int>(edits.size()));
+
+  // apply the pings in a scrambled order
+  std::vector<int> order;
+  for (int iping = 0; iping < kNumPings; iping++)
+    order.push_back(iping);
+  for (int iping = 0; iping < kNumPings; iping += 3)
+    std::swap(order[iping], order[kNumPings - 1 - iping]);
+  for (int iping : order) {
+    for (int multiplicity = 0; multiplicity < 2; multiplicity++) {
+      char expected[kNumBeams];
+      char beamflag[kNumBeams];
+      InitialFlags(iping, expected);
+      InitialFlags(iping, beamflag);
+      ApplyReference(edits, PingTime(iping), multiplicity, expected);
+      int error = MB_ERROR_NO_ERROR;
+      EXPECT_EQ(MB_SUCCESS, mb_esf_apply(0, &esf_, PingTime(iping), multiplicity, kNumBeams, beamflag, &error));
+      for (int i = 0; i < kNumBeams; i++)
+        ASSERT_EQ(expected[i], beamflag[i]) << "ping " << iping << " multiplicity " << multiplicity << " beam " << i;
+    }
+  }
+}
+
+TEST_F(MbEsfTest, Compacts) {
+  const double time_d = PingTime(1);
+  const std::vector<Edit> edits = {
+      // only the last of each flagging action after the unflag matter
+      {time_d, 3, MBP_EDIT_FLAG},   {time_d, 3, MBP_EDIT_UNFLAG}, {time_d, 3, MBP_EDIT_FILTER},
+      {time_d, 3, MBP_EDIT_FLAG},   {time_d, 3, MBP_EDIT_FILTER},
+      // once zeroed a beam stays zeroed
+      {time_d, 5, MBP_EDIT_FLAG},   {time_d, 5, MBP_EDIT_ZERO},   {time_d, 5, MBP_EDIT_UNFLAG},
+      {time_d, 5, MBP_EDIT_ZERO},
+      // another ping is left alone
+      {PingTime(2), 3, MBP_EDIT_FLAG}};
+  Write(edits, 3);
+  Load();
+  ASSERT_EQ(5, esf_.nedit);
+  EXPECT_EQ(MBP_EDIT_UNFLAG, esf_.edit[0].action);
+  EXPECT_EQ(MBP_EDIT_FLAG, esf_.edit[1].action);
+  EXPECT_EQ(MBP_EDIT_FILTER, esf_.edit[2].action);
+  EXPECT_EQ(MBP_EDIT_ZERO, esf_.edit[3].action);
+  EXPECT_EQ(5, esf_.edit[3].beam);
+  EXPECT_EQ(PingTime(2), esf_.edit[4].time_d);
+}
+
+TEST_F(MbEsfTest, ReadsOldVersions) {
+  const std::vector<Edit> edits = {{PingTime(4), 1, MBP_EDIT_FLAG}, {PingTime(3), 2, MBP_EDIT_ZERO}};
+  for (int version : {1, 2, 4}) {
+    Write(edits, version);
+    Load();
+    EXPECT_EQ(version, esf_.version);
+    ASSERT_EQ(2, esf_.nedit);
+    EXPECT_EQ(PingTime(3), esf_.edit[0].time_d);
+
+    char beamflag[kNumBeams];
+    memset(beamflag, MB_FLAG_NONE, sizeof(beamflag));
+    int error = MB_ERROR_NO_ERROR;
+    // version 1 files matched timestamps to the millisecond
+    const double offset = version == 1 ? 0.0005 : 0.0;
+    mb_esf_apply(0, &esf_, PingTime(4) + offset, 0, kNumBeams, beamflag, &error);
+    EXPECT_TRUE(mb_beam_ok(beamflag[0]));
+    EXPECT_TRUE(mb_beam_check_flag_manual(beamflag[1]));
+    mb_esf_close(0, &esf_, &error);
+  }
+}
+
+TEST_F(MbEsfTest, FixTimestamps) {
+  const std::vector<Edit> edits = {{PingTime(4) + 0.003, 1, MBP_EDIT_FLAG}, {PingTime(5) - 0.004, 2, MBP_EDIT_FLAG}};
+  Write(edits, 3);
+  Load();
+  int error = MB_ERROR_NO_ERROR;
+  for (int iping : {5, 4}) {
+    char beamflag[kNumBeams];
+    memset(beamflag, MB_FLAG_NONE, sizeof(beamflag));
+    mb_esf_fixtimestamps(0, &esf_, PingTime(iping), 0.01, &error);
+    mb_esf_apply(0, &esf_, PingTime(iping), 0, kNumBeams, beamflag, &error);
+    EXPECT_TRUE(mb_beam_check_flag_manual(beamflag[iping == 4 ? 1 : 2])) << "ping " << iping;
+  }
+}
+
+}  // namespace
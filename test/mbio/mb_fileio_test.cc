@@ -0,0 +1,177 @@
+// See README file for copying and redistribution conditions.
+
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "mb_define.h"
+#include "mb_io.h"
+#include "mb_status.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace {
+
+// Writes a data file and a .mbio_defaults selecting the given fileiobuffer
+// into a scratch directory used as HOME.
+class MbFileioTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    char dir[] = "/tmp/mb_fileio_test_XXXXXX";
+    ASSERT_NE(nullptr, mkdtemp(dir));
+    dir_ = dir;
+    home_ = getenv("HOME") != nullptr ? getenv("HOME") : "";
+    setenv("HOME", dir_.c_str(), 1);
+
+    data_.resize(100000);
+    for (size_t i = 0; i < data_.size(); i++)
+      data_[i] = static_cast<char>((i * 7919) % 251);
+    file_ = dir_ + "/data.bin";
+    FILE *fp = fopen(file_.c_str(), "wb");
+    ASSERT_NE(nullptr, fp);
+    ASSERT_EQ(data_.size(), fwrite(data_.data(), 1, data_.size(), fp));
+    fclose(fp);
+  }
+
+  void TearDown() override {
+    unlink(file_.c_str());
+    unlink((dir_ + "/.mbio_defaults").c_str());
+    rmdir(dir_.c_str());
+    setenv("HOME", home_.c_str(), 1);
+  }
+
+  void SetFileioBuffer(int fileiobuffer) {
+    FILE *fp = fopen((dir_ + "/.mbio_defaults").c_str(), "w");
+    ASSERT_NE(nullptr, fp);
+    fprintf(fp, "fileiobuffer:%d\n", fileiobuffer);
+    fclose(fp);
+  }
+
+  void Open(struct mb_io_struct *mb_io_ptr, bool mmap_ok) {
+    memset(mb_io_ptr, 0, sizeof(struct mb_io_struct));
+    mb_io_ptr->filemode = MB_FILEMODE_READ;
+    mb_io_ptr->file_mmap_ok = mmap_ok;
+    strcpy(mb_io_ptr->file, file_.c_str());
+    int error = MB_ERROR_NO_ERROR;
+    ASSERT_EQ(MB_SUCCESS, mb_fileio_open(0, mb_io_ptr, &error));
+    ASSERT_NE(nullptr, mb_io_ptr->mbfp);
+  }
+
+  // Reads through the file the way an indexing driver does and checks
+  // every byte returned against the file contents.
+  void CheckReads(struct mb_io_struct *mb_io_ptr) {
+    int error = MB_ERROR_NO_ERROR;
+    std::vector<char> buffer(4096);
+    long offset = -1;
+
+    size_t size = 1000;
+    EXPECT_EQ(MB_SUCCESS, mb_fileio_get(0, mb_io_ptr, buffer.data(), &size, &error));
+    EXPECT_EQ(0, memcmp(buffer.data(), &data_[0], 1000));
+    EXPECT_EQ(MB_SUCCESS, mb_fileio_tell(0, mb_io_ptr, &offset, &error));
+    EXPECT_EQ(1000, offset);
+
+    EXPECT_EQ(MB_SUCCESS, mb_fileio_seek(0, mb_io_ptr, 5000, SEEK_CUR, &error));
+    char *data = nullptr;
+    size = 2000;
+    EXPECT_EQ(MB_SUCCESS, mb_fileio_getptr(0, mb_io_ptr, buffer.data(), &data, &size, &error));
+    EXPECT_EQ(0, memcmp(data, &data_[6000], 2000));
+    EXPECT_EQ(MB_SUCCESS, mb_fileio_tell(0, mb_io_ptr, &offset, &error));
+    EXPECT_EQ(8000, offset);
+
+    EXPECT_EQ(MB_SUCCESS, mb_fileio_seek(0, mb_io_ptr, 50000, SEEK_SET, &error));
+    size = 10;
+    EXPECT_EQ(MB_SUCCESS, mb_fileio_get(0, mb_io_ptr, buffer.data(), &size, &error));
+    EXPECT_EQ(0, memcmp(buffer.data(), &data_[50000], 10));
+
+    // a read past the end returns what is left and MB_ERROR_EOF
+    EXPECT_EQ(MB_SUCCESS, mb_fileio_seek(0, mb_io_ptr, -100, SEEK_END, &error));
+    size = 1000;
+    EXPECT_EQ(MB_FAILURE, mb_fileio_get(0, mb_io_ptr, buffer.data(), &size, &error));
+    EXPECT_EQ(MB_ERROR_EOF, error);
+    EXPECT_EQ(100u, size);
+    EXPECT_EQ(0, memcmp(buffer.data(), &data_[data_.size() - 100], 100));
+  }
+
+  std::string dir_;
+  std::string home_;
+  std::string file_;
+  std::vector<char> data_;
+};
+
+TEST_F(MbFileioTest, Stdio) {
+  SetFileioBuffer(0);
+  struct mb_io_struct *mb_io_ptr = (struct mb_io_struct *)malloc(sizeof(struct mb_io_struct));
+  Open(mb_io_ptr, true);
+  EXPECT_EQ(nullptr, mb_io_ptr->file_mmap);
+  CheckReads(mb_io_ptr);
+
+  // without a map the bytes are read into the buffer
+  int error = MB_ERROR_NO_ERROR;
+  char buffer[16];
+  char *data = nullptr;
+  size_t size = sizeof(buffer);
+  EXPECT_EQ(MB_SUCCESS, mb_fileio_seek(0, mb_io_ptr, 0, SEEK_SET, &error));
+  EXPECT_EQ(MB_SUCCESS, mb_fileio_getptr(0, mb_io_ptr, buffer, &data, &size, &error));
+  EXPECT_EQ(buffer, data);
+
+  EXPECT_EQ(MB_SUCCESS, mb_fileio_close(0, mb_io_ptr, &error));
+  EXPECT_EQ(nullptr, mb_io_ptr->mbfp);
+  free(mb_io_ptr);
+}
+
+TEST_F(MbFileioTest, Mmap) {
+  SetFileioBuffer(-1);
+  struct mb_io_struct *mb_io_ptr = (struct mb_io_struct *)malloc(sizeof(struct mb_io_struct));
+  Open(mb_io_ptr, true);
+  ASSERT_NE(nullptr, mb_io_ptr->file_mmap);
+  EXPECT_EQ(data_.size(), mb_io_ptr->file_mmap_size);
+  CheckReads(mb_io_ptr);
+
+  // with a map the bytes are not copied
+  int error = MB_ERROR_NO_ERROR;
+  char buffer[16];
+  char *data = nullptr;
+  size_t size = sizeof(buffer);
+  EXPECT_EQ(MB_SUCCESS, mb_fileio_seek(0, mb_io_ptr, 64, SEEK_SET, &error));
+  EXPECT_EQ(MB_SUCCESS, mb_fileio_getptr(0, mb_io_ptr, buffer, &data, &size, &error));
+  EXPECT_EQ(mb_io_ptr->file_mmap + 64, data);
+
+  EXPECT_EQ(MB_FAILURE, mb_fileio_seek(0, mb_io_ptr, -1, SEEK_SET, &error));
+  EXPECT_EQ(MB_ERROR_BAD_PARAMETER, error);
+
+  EXPECT_EQ(MB_SUCCESS, mb_fileio_close(0, mb_io_ptr, &error));
+  EXPECT_EQ(nullptr, mb_io_ptr->file_mmap);
+  EXPECT_EQ(nullptr, mb_io_ptr->mbfp);
+  free(mb_io_ptr);
+}
+
+TEST_F(MbFileioTest, MmapNotSupportedByFormat) {
+  SetFileioBuffer(-1);
+  struct mb_io_struct *mb_io_ptr = (struct mb_io_struct *)malloc(sizeof(struct mb_io_struct));
+  Open(mb_io_ptr, false);
+  EXPECT_EQ(nullptr, mb_io_ptr->file_mmap);
+  CheckReads(mb_io_ptr);
+  int error = MB_ERROR_NO_ERROR;
+  EXPECT_EQ(MB_SUCCESS, mb_fileio_close(0, mb_io_ptr, &error));
+  free(mb_io_ptr);
+}
+
+TEST_F(MbFileioTest, UserBuffer) {
+  SetFileioBuffer(64);
+  struct mb_io_struct *mb_io_ptr = (struct mb_io_struct *)malloc(sizeof(struct mb_io_struct));
+  Open(mb_io_ptr, true);
+  EXPECT_EQ(nullptr, mb_io_ptr->file_mmap);
+  EXPECT_NE(nullptr, mb_io_ptr->file_iobuffer);
+  CheckReads(mb_io_ptr);
+  int error = MB_ERROR_NO_ERROR;
+  EXPECT_EQ(MB_SUCCESS, mb_fileio_close(0, mb_io_ptr, &error));
+  EXPECT_EQ(nullptr, mb_io_ptr->file_iobuffer);
+  free(mb_io_ptr);
+}
+
+}  // namespace
@@ -0,0 +1,214 @@
+// See README file for copying and redistribution conditions.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mb_define.h"
+#include "mb_io.h"
+#include "mb_status.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace {
+
+constexpr int kNumRecords = 500;
+constexpr int kRecordSize = 64;
+constexpr int kFormat = 71;
+constexpr double kStartTime = 1.5e9;
+
+// Every fifth record is a comment, the rest are survey records one second
+// apart moving east from longitude -122.
+double RecordTime(int i) { return kStartTime + i; }
+int RecordKind(int i) { return i % 5 == 4 ? MB_DATA_COMMENT : MB_DATA_DATA; }
+double RecordLon(int i) { return -122.0 + 0.001 * i; }
+
+class MbIndexTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    char path[] = "/tmp/mb_index_testXXXXXX";
+    const int fd = mkstemp(path);
+    ASSERT_NE(-1, fd);
+    close(fd);
+    path_ = path;
+    FILE *fp = fopen(path_.c_str(), "wb");
+    ASSERT_NE(nullptr, fp);
+    std::vector<char> record(kRecordSize);
+    for (int i = 0; i < kNumRecords; i++) {
+      memset(record.data(), 0, kRecordSize);
+      memcpy(record.data(), &i, sizeof(int));
+      ASSERT_EQ(1u, fwrite(record.data(), kRecordSize, 1, fp));
+    }
+    fclose(fp);
+  }
+
+  void TearDown() override {
+    unlink(path_.c_str());
+    unlink((path_ + ".idx").c_str());
+  }
+
+  // Opens the file the way mb_read_init() does for a format with normal
+  // files, loading and applying its index.
+  struct mb_io_struct *Open(double btime_d, double west = -360.0) {
+    struct mb_io_struct *mb_io_ptr = (struct mb_io_struct *)calloc(1, sizeof(struct mb_io_struct));
+    EXPECT_NE(nullptr, mb_io_ptr);
+    mb_io_ptr->filemode = MB_FILEMODE_READ;
+    mb_io_ptr->filetype = MB_FILETYPE_NORMAL;
+    mb_io_ptr->format = kFormat;
+    mb_io_ptr->numfile = 1;
+    mb_io_ptr->index_seek_ok = true;
+    mb_io_ptr->btime_d = btime_d;
+    mb_io_ptr->bounds[0] = west;
+    mb_io_ptr->bounds[1] = west > -360.0 ? west + 10.0 : 360.0;
+    mb_io_ptr->bounds[2] = -90.0;
+    mb_io_ptr->bounds[3] = 90.0;
+    strcpy(mb_io_ptr->file, path_.c_str());
+    mb_io_ptr->mbfp = fopen(path_.c_str(), "rb");
+    EXPECT_NE(nullptr, mb_io_ptr->mbfp);
+    int error = MB_ERROR_NO_ERROR;
+    EXPECT_EQ(MB_SUCCESS, mb_index_read(0, mb_io_ptr, &error));
+    EXPECT_EQ(MB_SUCCESS, mb_index_seek(0, mb_io_ptr, &error));
+    return mb_io_ptr;
+  }
+
+  void Close(struct mb_io_struct *mb_io_ptr) {
+    int error = MB_ERROR_NO_ERROR;
+    if (mb_io_ptr->index_build != nullptr)
+      EXPECT_EQ(MB_SUCCESS, mb_index_write(0, mb_io_ptr, &error));
+    EXPECT_EQ(MB_SUCCESS, mb_index_free(0, mb_io_ptr, &error));
+    EXPECT_EQ(nullptr, mb_io_ptr->index);
+    EXPECT_EQ(nullptr, mb_io_ptr->index_build);
+    fclose(mb_io_ptr->mbfp);
+    free(mb_io_ptr);
+  }
+
+  // Reads every record, as mbinfo -K does, saving blob as the format
+  // private index data.
+  void BuildIndex(const std::vector<char> &blob) {
+    struct mb_io_struct *mb_io_ptr = Open(0.0);
+    int error = MB_ERROR_NO_ERROR;
+    ASSERT_EQ(MB_SUCCESS, mb_index_build(0, mb_io_ptr, &error));
+    std::vector<char> record(kRecordSize);
+    for (int i = 0; i < kNumRecords; i++) {
+      ASSERT_EQ(1u, fread(record.data(), kRecordSize, 1, mb_io_ptr->mbfp));
+      ASSERT_EQ(MB_SUCCESS, mb_index_add(0, mb_io_ptr, RecordKind(i), RecordTime(i), RecordLon(i), 36.0, &error));
+    }
+    if (!blob.empty()) {
+      mb_io_ptr->index_blob = (void *)blob.data();
+      mb_io_ptr->index_blob_size = blob.size();
+    }
+    Close(mb_io_ptr);
+  }
+
+  // Index of the next record read.
+  static int NextRecord(struct mb_io_struct *mb_io_ptr) {
+    int i = -1;
+    EXPECT_EQ(1u, fread(&i, sizeof(int), 1, mb_io_ptr->mbfp));
+    return i;
+  }
+
+  std::string path_;
+};
+
+TEST_F(MbIndexTest, NoIndex) {
+  struct mb_io_struct *mb_io_ptr = Open(RecordTime(300));
+  EXPECT_EQ(nullptr, mb_io_ptr->index);
+  EXPECT_EQ(0, NextRecord(mb_io_ptr));
+  Close(mb_io_ptr);
+}
+
+TEST_F(MbIndexTest, SeekToStartTime) {
+  BuildIndex({});
+
+  // starts at the survey record before the first one at the start time
+  struct mb_io_struct *mb_io_ptr = Open(RecordTime(300));
+  ASSERT_NE(nullptr, mb_io_ptr->index);
+  EXPECT_EQ(298, NextRecord(mb_io_ptr));
+  EXPECT_EQ(298L * kRecordSize, mb_io_ptr->file_bytes);
+  Close(mb_io_ptr);
+
+  // a comment is skipped back over
+  mb_io_ptr = Open(RecordTime(305));
+  EXPECT_EQ(303, NextRecord(mb_io_ptr));
+  Close(mb_io_ptr);
+
+  // no seek before the first survey record or after the last
+  for (double btime_d : {RecordTime(0), RecordTime(kNumRecords + 10)}) {
+    mb_io_ptr = Open(btime_d);
+    EXPECT_EQ(0, NextRecord(mb_io_ptr));
+    Close(mb_io_ptr);
+  }
+}
+
+TEST_F(MbIndexTest, SeekToBounds) {
+  BuildIndex({});
+  struct mb_io_struct *mb_io_ptr = Open(0.0, RecordLon(200) - 0.0005);
+  EXPECT_EQ(198, NextRecord(mb_io_ptr));
+  Close(mb_io_ptr);
+
+  // longitudes are compared in the range of the bounds
+  mb_io_ptr = Open(0.0, RecordLon(200) + 360.0 - 0.0005);
+  EXPECT_EQ(198, NextRecord(mb_io_ptr));
+  Close(mb_io_ptr);
+}
+
+TEST_F(MbIndexTest, FormatWithoutSeekSupport) {
+  BuildIndex({});
+  struct mb_io_struct *mb_io_ptr = Open(RecordTime(300));
+  Close(mb_io_ptr);
+  mb_io_ptr = (struct mb_io_struct *)calloc(1, sizeof(struct mb_io_struct));
+  mb_io_ptr->filemode = MB_FILEMODE_READ;
+  mb_io_ptr->filetype = MB_FILETYPE_NORMAL;
+  mb_io_ptr->format = kFormat;
+  mb_io_ptr->numfile = 1;
+  mb_io_ptr->btime_d = RecordTime(300);
+  strcpy(mb_io_ptr->file, path_.c_str());
+  mb_io_ptr->mbfp = fopen(path_.c_str(), "rb");
+  int error = MB_ERROR_NO_ERROR;
+  EXPECT_EQ(MB_SUCCESS, mb_index_read(0, mb_io_ptr, &error));
+  EXPECT_NE(nullptr, mb_io_ptr->index);
+  EXPECT_EQ(MB_SUCCESS, mb_index_seek(0, mb_io_ptr, &error));
+  EXPECT_EQ(0, NextRecord(mb_io_ptr));
+  Close(mb_io_ptr);
+}
+
+TEST_F(MbIndexTest, FormatPrivateData) {
+  std::vector<char> blob(1000);
+  for (size_t i = 0; i < blob.size(); i++)
+    blob[i] = (char)(i * 7);
+  BuildIndex(blob);
+
+  struct mb_io_struct *mb_io_ptr = Open(0.0);
+  void *data = nullptr;
+  size_t size = 0;
+  int error = MB_ERROR_NO_ERROR;
+  ASSERT_EQ(MB_SUCCESS, mb_index_get_blob(0, mb_io_ptr, &data, &size, &error));
+  ASSERT_EQ(blob.size(), size);
+  EXPECT_EQ(0, memcmp(blob.data(), data, size));
+  Close(mb_io_ptr);
+}
+
+TEST_F(MbIndexTest, ChangedFileIgnoresIndex) {
+  BuildIndex({1, 2, 3, 4});
+  FILE *fp = fopen(path_.c_str(), "ab");
+  ASSERT_NE(nullptr, fp);
+  fputc(0, fp);
+  fclose(fp);
+
+  struct mb_io_struct *mb_io_ptr = Open(RecordTime(300));
+  EXPECT_EQ(nullptr, mb_io_ptr->index);
+  void *data = nullptr;
+  size_t size = 0;
+  int error = MB_ERROR_NO_ERROR;
+  EXPECT_EQ(MB_FAILURE, mb_index_get_blob(0, mb_io_ptr, &data, &size, &error));
+  EXPECT_EQ(0, NextRecord(mb_io_ptr));
+  Close(mb_io_ptr);
+}
+
+}  // namespace
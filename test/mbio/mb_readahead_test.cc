@@ -0,0 +1,223 @@
+// See README file for copying and redistribution conditions.
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "mb_define.h"
+#include "mb_io.h"
+#include "mb_status.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace {
+
+constexpr int kNumRecords = 12000;
+
+struct FakeStore {
+  int kind;
+  int count;
+  double time_d;
+};
+
+// A format that reads kNumRecords records, adding asynchronous navigation
+// and attitude the way the Kongsberg and Reson drivers do, emptying the
+// navigation list now and then as a change of source does, and growing
+// its raw data buffer as it goes.
+int FakeReadPing(int verbose, void *mbio_ptr, void *store_ptr, int *error) {
+  struct mb_io_struct *mb_io_ptr = (struct mb_io_struct *)mbio_ptr;
+  FakeStore *store = (FakeStore *)store_ptr;
+
+  const int count = ++mb_io_ptr->save1;
+  if (count > kNumRecords) {
+    *error = MB_ERROR_EOF;
+    mb_io_ptr->new_error = *error;
+    return MB_FAILURE;
+  }
+
+  if (count % 1000 == 0)
+    mb_io_ptr->nfix = 0;
+  for (int k = 0; k < 3; k++) {
+    const double time_d = count + 0.25 * k;
+    mb_navint_add(verbose, mbio_ptr, time_d, -122.0 + 0.001 * sin(time_d), 36.0 + 0.001 * cos(time_d), error);
+    mb_attint_add(verbose, mbio_ptr, time_d, 0.1 * k, 0.01 * time_d, -0.01 * time_d, error);
+  }
+  // repeated time stamps are not added
+  mb_hedint_add(verbose, mbio_ptr, (double)(count / 2), 0.5 * count, error);
+
+  if (count % 100 == 0)
+    mb_reallocd(verbose, __FILE__, __LINE__, 16 * count, &mb_io_ptr->raw_data, error);
+
+  store->kind = count % 3 == 0 ? MB_DATA_NAV : MB_DATA_DATA;
+  store->count = count;
+  store->time_d = count + 0.1;
+  mb_io_ptr->file_pos = 100L * (count - 1);
+  mb_io_ptr->file_bytes = 100L * count;
+  *error = count % 7 == 0 ? MB_ERROR_UNINTELLIGIBLE : MB_ERROR_NO_ERROR;
+  mb_io_ptr->new_kind = store->kind;
+  mb_io_ptr->new_error = *error;
+  return *error == MB_ERROR_NO_ERROR ? MB_SUCCESS : MB_FAILURE;
+}
+
+int FakeStoreAlloc(int verbose, void *mbio_ptr, void **store_ptr, int *error) {
+  (void)mbio_ptr;
+  const int status = mb_mallocd(verbose, __FILE__, __LINE__, sizeof(FakeStore), store_ptr, error);
+  memset(*store_ptr, 0, sizeof(FakeStore));
+  return status;
+}
+
+int FakeStoreFree(int verbose, void *mbio_ptr, void **store_ptr, int *error) {
+  (void)mbio_ptr;
+  return mb_freed(verbose, __FILE__, __LINE__, store_ptr, error);
+}
+
+int FakeCopyRecord(int verbose, void *mbio_ptr, void *store_ptr, void *copy_ptr, int *error) {
+  (void)verbose;
+  (void)mbio_ptr;
+  memcpy(copy_ptr, store_ptr, sizeof(FakeStore));
+  *error = MB_ERROR_NO_ERROR;
+  return MB_SUCCESS;
+}
+
+// What the application sees after each record.
+struct Result {
+  int status;
+  int error;
+  int kind;
+  int count;
+  long file_pos;
+  double navlon;
+  double navlat;
+  double navlon_earlier;
+  double roll;
+  double heading;
+};
+
+bool operator==(const Result &a, const Result &b) {
+  return a.status == b.status && a.error == b.error && a.kind == b.kind && a.count == b.count &&
+         a.file_pos == b.file_pos && a.navlon == b.navlon && a.navlat == b.navlat &&
+         a.navlon_earlier == b.navlon_earlier && a.roll == b.roll && a.heading == b.heading;
+}
+
+class MbReadaheadTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    mb_io_ptr_ = (struct mb_io_struct *)calloc(1, sizeof(struct mb_io_struct));
+    ASSERT_NE(nullptr, mb_io_ptr_);
+    mb_io_ptr_->filemode = MB_FILEMODE_READ;
+    mb_io_ptr_->filetype = MB_FILETYPE_SINGLE;
+    mb_io_ptr_->mbfp = tmpfile();
+    ASSERT_NE(nullptr, mb_io_ptr_->mbfp);
+    mb_io_ptr_->readahead_ok = true;
+    mb_io_ptr_->mb_io_read_ping = &FakeReadPing;
+    mb_io_ptr_->mb_io_store_alloc = &FakeStoreAlloc;
+    mb_io_ptr_->mb_io_store_free = &FakeStoreFree;
+    mb_io_ptr_->mb_io_copyrecord = &FakeCopyRecord;
+    int error = MB_ERROR_NO_ERROR;
+    ASSERT_EQ(MB_SUCCESS, FakeStoreAlloc(0, mb_io_ptr_, &store_, &error));
+  }
+
+  void TearDown() override {
+    int error = MB_ERROR_NO_ERROR;
+    EXPECT_EQ(MB_SUCCESS, mb_readahead_close(0, mb_io_ptr_, &error));
+    EXPECT_EQ(nullptr, mb_io_ptr_->readahead);
+    // the buffer reallocated while reading ahead is handed back
+    mb_freed(0, __FILE__, __LINE__, &mb_io_ptr_->raw_data, &error);
+    FakeStoreFree(0, mb_io_ptr_, &store_, &error);
+    fclose(mb_io_ptr_->mbfp);
+    free(mb_io_ptr_);
+  }
+
+  // Reads n records the way mb_read_ping() does, interpolating the
+  // asynchronous data at each record's time stamp, and the navigation
+  // also a little earlier.
+  std::vector<Result> Read(int n) {
+    std::vector<Result> results;
+    for (int i = 0; i < n; i++) {
+      Result r;
+      int error = MB_ERROR_NO_ERROR;
+      if (mb_io_ptr_->readahead != nullptr)
+        r.status = mb_readahead_read_ping(0, mb_io_ptr_, store_, &error);
+      else
+        r.status = FakeReadPing(0, mb_io_ptr_, store_, &error);
+      const FakeStore *store = (FakeStore *)store_;
+      r.error = error;
+      r.kind = mb_io_ptr_->new_kind;
+      r.count = store->count;
+      r.file_pos = mb_io_ptr_->file_pos;
+      double speed, heave, pitch;
+      double navlat;
+      r.navlon = r.navlat = r.navlon_earlier = r.roll = r.heading = 0.0;
+      int interp_error = MB_ERROR_NO_ERROR;
+      if (mb_io_ptr_->nfix > 0) {
+        mb_navint_interp(0, mb_io_ptr_, store->time_d, 0.0, 0.0, &r.navlon, &r.navlat, &speed, &interp_error);
+        mb_navint_interp(0, mb_io_ptr_, store->time_d - 2.0, 0.0, 0.0, &r.navlon_earlier, &navlat, &speed,
+                         &interp_error);
+      }
+      mb_attint_interp(0, mb_io_ptr_, store->time_d, &heave, &r.roll, &pitch, &interp_error);
+      mb_hedint_interp(0, mb_io_ptr_, store->time_d, &r.heading, &interp_error);
+      results.push_back(r);
+    }
+    return results;
+  }
+
+  struct mb_io_struct *mb_io_ptr_ = nullptr;
+  void *store_ = nullptr;
+};
+
+TEST_F(MbReadaheadTest, NotRequested) {
+  int error = MB_ERROR_NO_ERROR;
+  EXPECT_EQ(MB_SUCCESS, mb_readahead_init(0, mb_io_ptr_, 0, &error));
+  EXPECT_EQ(nullptr, mb_io_ptr_->readahead);
+}
+
+TEST_F(MbReadaheadTest, NotSupportedByFormat) {
+  mb_io_ptr_->readahead_ok = false;
+  int error = MB_ERROR_NO_ERROR;
+  EXPECT_EQ(MB_SUCCESS, mb_readahead_init(0, mb_io_ptr_, 8, &error));
+  EXPECT_EQ(nullptr, mb_io_ptr_->readahead);
+}
+
+TEST_F(MbReadaheadTest, MatchesSynchronousRead) {
+  const std::vector<Result> expected = Read(kNumRecords + 2);
+  mb_freed(0, __FILE__, __LINE__, &mb_io_ptr_->raw_data, &mb_io_ptr_->new_error);
+  ASSERT_EQ(MB_FAILURE, expected.back().status);
+  ASSERT_EQ(MB_ERROR_EOF, expected.back().error);
+
+  for (int nrecord : {1, 3, 16}) {
+    // start over from the beginning of the file
+    mb_io_ptr_->save1 = 0;
+    mb_io_ptr_->nfix = mb_io_ptr_->nattitude = mb_io_ptr_->nheading = 0;
+    memset(store_, 0, sizeof(FakeStore));
+
+    int error = MB_ERROR_NO_ERROR;
+    ASSERT_EQ(MB_SUCCESS, mb_readahead_init(0, mb_io_ptr_, nrecord, &error));
+    ASSERT_NE(nullptr, mb_io_ptr_->readahead);
+    const std::vector<Result> results = Read(kNumRecords + 2);
+    ASSERT_EQ(expected.size(), results.size());
+    for (size_t i = 0; i < expected.size(); i++)
+      ASSERT_TRUE(expected[i] == results[i]) << "record " << i << " nrecord " << nrecord;
+    EXPECT_EQ(MB_SUCCESS, mb_readahead_close(0, mb_io_ptr_, &error));
+    EXPECT_EQ(kNumRecords + 1, mb_io_ptr_->save1);
+    mb_freed(0, __FILE__, __LINE__, &mb_io_ptr_->raw_data, &error);
+  }
+}
+
+TEST_F(MbReadaheadTest, CloseBeforeEnd) {
+  int error = MB_ERROR_NO_ERROR;
+  ASSERT_EQ(MB_SUCCESS, mb_readahead_init(0, mb_io_ptr_, 4, &error));
+  ASSERT_NE(nullptr, mb_io_ptr_->readahead);
+  const std::vector<Result> results = Read(250);
+  EXPECT_EQ(250, results.back().count);
+
+  // the thread stops with the queue full
+  EXPECT_EQ(MB_SUCCESS, mb_readahead_close(0, mb_io_ptr_, &error));
+  EXPECT_EQ(nullptr, mb_io_ptr_->readahead);
+  EXPECT_GE(mb_io_ptr_->save1, 250);
+  EXPECT_LE(mb_io_ptr_->save1, 255);
+}
+
+}  // namespace
@@ -0,0 +1,171 @@
+// See README file for copying and redistribution conditions.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include "mb_define.h"
+#include "mb_status.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace {
+
+constexpr double kErrorBound = 0.01;
+
+// A profile with a mixed layer, a thermocline and a deep gradient, sampled
+// every few meters near the surface the way a CTD cast would be, and
+// extended to 12000 m as mbprocess does.
+void MakeProfile(std::vector<double> *depth, std::vector<double> *velocity) {
+  depth->clear();
+  velocity->clear();
+  for (double z = 0.0; z < 1000.0; z += 2.5) {
+    depth->push_back(z);
+    const double v = 1510.0 - 25.0 * (1.0 + tanh((z - 150.0) / 60.0)) + 0.017 * z + 0.5 * sin(0.05 * z);
+    velocity->push_back(v);
+  }
+  for (double z = 1000.0; z <= 5000.0; z += 250.0) {
+    depth->push_back(z);
+    velocity->push_back(1477.0 + 0.0165 * z);
+  }
+  depth->push_back(12000.0);
+  velocity->push_back(velocity->back());
+}
+
+struct Rays {
+  std::vector<double> source_depth;
+  std::vector<double> source_angle;
+  std::vector<double> end_time;
+  std::vector<double> null_angle;
+};
+
+// Swath pings from a transducer heaving about 6 m depth.
+Rays MakeRays(int nping, int nbeam) {
+  Rays rays;
+  srand(3);
+  for (int iping = 0; iping < nping; iping++) {
+    const double heave = 1.5 * sin(0.4 * iping);
+    const double roll = 5.0 * sin(0.13 * iping);
+    const double water_depth = 1500.0 + 10.0 * iping;
+    for (int ibeam = 0; ibeam < nbeam; ibeam++) {
+      const double angle = -70.0 + 140.0 * ibeam / (nbeam - 1) + roll;
+      rays.source_depth.push_back(6.0 + heave + 0.01 * (rand() % 10));
+      rays.source_angle.push_back(angle);
+      rays.end_time.push_back(water_depth / 1490.0 / cos(angle * M_PI / 180.0) + 0.001 * (rand() % 100));
+      rays.null_angle.push_back(angle - roll);
+    }
+  }
+  return rays;
+}
+
+TEST(MbRtTableTest, BadParameters) {
+  std::vector<double> depth, velocity;
+  MakeProfile(&depth, &velocity);
+  int error = MB_ERROR_NO_ERROR;
+  void *model = nullptr;
+  ASSERT_EQ(MB_SUCCESS, mb_rt_init(0, depth.size(), depth.data(), velocity.data(), &model, &error));
+
+  void *table = nullptr;
+  EXPECT_EQ(MB_FAILURE, mb_rt_table_init(0, model, 90.0, 0.1, 5.0, 0.025, 0.5, kErrorBound, &table, &error));
+  EXPECT_EQ(MB_ERROR_BAD_PARAMETER, error);
+  EXPECT_EQ(nullptr, table);
+  error = MB_ERROR_NO_ERROR;
+  EXPECT_EQ(MB_FAILURE, mb_rt_table_init(0, model, 80.0, 0.1, 5.0, 0.025, 0.5, 0.0, &table, &error));
+  EXPECT_EQ(MB_ERROR_BAD_PARAMETER, error);
+  EXPECT_EQ(nullptr, table);
+
+  EXPECT_EQ(MB_SUCCESS, mb_rt_deall(0, &model, &error));
+}
+
+TEST(MbRtTableTest, MatchesRaytracing) {
+  std::vector<double> depth, velocity;
+  MakeProfile(&depth, &velocity);
+  int error = MB_ERROR_NO_ERROR;
+  void *model = nullptr;
+  ASSERT_EQ(MB_SUCCESS, mb_rt_init(0, depth.size(), depth.data(), velocity.data(), &model, &error));
+  void *table = nullptr;
+  ASSERT_EQ(MB_SUCCESS, mb_rt_table_init(0, model, 80.0, 0.1, 8.0, 0.025, 0.5, kErrorBound, &table, &error));
+
+  const int nbeam = 256;
+  Rays rays = MakeRays(40, nbeam);
+  const int nray = rays.source_depth.size();
+  for (int ssv_mode = 0; ssv_mode <= 2; ssv_mode++) {
+    std::vector<double> x(nray), z(nray), travel_time(nray);
+    std::vector<int> ray_stat(nray);
+    for (int iray = 0; iray < nray; iray += nbeam) {
+      EXPECT_EQ(MB_SUCCESS, mb_rt_table(0, table, nbeam, &rays.source_depth[iray], &rays.source_angle[iray],
+                                        &rays.end_time[iray], ssv_mode, 1505.0, &rays.null_angle[iray], &x[iray],
+                                        &z[iray], &travel_time[iray], &ray_stat[iray], &error));
+    }
+
+    double error_max = 0.0;
+    for (int iray = 0; iray < nray; iray++) {
+      double xx, zz, ttime;
+      int rstat;
+      ASSERT_EQ(MB_SUCCESS, mb_rt(0, model, rays.source_depth[iray], rays.source_angle[iray], rays.end_time[iray],
+                                  ssv_mode, 1505.0, rays.null_angle[iray], 0, nullptr, nullptr, nullptr, nullptr, &xx,
+                                  &zz, &ttime, &rstat, &error));
+      error_max = std::max(error_max, std::max(fabs(x[iray] - xx), fabs(z[iray] - zz)));
+      EXPECT_NEAR(ttime, travel_time[iray], 1.0e-9);
+    }
+    EXPECT_LE(error_max, kErrorBound);
+  }
+
+  // nearly all of the rays come from the table
+  int nbin;
+  long ninterpolated, nexact;
+  EXPECT_EQ(MB_SUCCESS, mb_rt_table_stats(0, table, &nbin, &ninterpolated, &nexact, &error));
+  EXPECT_GT(nbin, 1);
+  EXPECT_GT(ninterpolated, 50 * nexact);
+
+  EXPECT_EQ(MB_SUCCESS, mb_rt_table_deall(0, &table, &error));
+  EXPECT_EQ(nullptr, table);
+  EXPECT_EQ(MB_SUCCESS, mb_rt_deall(0, &model, &error));
+}
+
+TEST(MbRtTableTest, OutsideTableIsTraced) {
+  std::vector<double> depth, velocity;
+  MakeProfile(&depth, &velocity);
+  int error = MB_ERROR_NO_ERROR;
+  void *model = nullptr;
+  ASSERT_EQ(MB_SUCCESS, mb_rt_init(0, depth.size(), depth.data(), velocity.data(), &model, &error));
+  void *table = nullptr;
+  ASSERT_EQ(MB_SUCCESS, mb_rt_table_init(0, model, 60.0, 0.1, 2.0, 0.025, 0.5, kErrorBound, &table, &error));
+
+  // too steep, too long and from the bottom of the model
+  std::vector<double> source_depth = {5.0, -5.0, 5.0, 12000.0};
+  std::vector<double> source_angle = {75.0, -75.0, 10.0, 10.0};
+  std::vector<double> end_time = {1.0, 1.0, 3.0, 1.0};
+  std::vector<double> null_angle(4, 0.0);
+  std::vector<double> x(4), z(4);
+  std::vector<int> ray_stat(4);
+  mb_rt_table(0, table, 4, source_depth.data(), source_angle.data(), end_time.data(), 0, 1500.0, null_angle.data(),
+              x.data(), z.data(), nullptr, ray_stat.data(), &error);
+  for (int iray = 0; iray < 4; iray++) {
+    double xx = 0.0;
+    double zz = source_depth[iray];
+    double ttime;
+    int rstat = ray_stat[iray];
+    int rt_error = MB_ERROR_NO_ERROR;
+    mb_rt(0, model, source_depth[iray], source_angle[iray], end_time[iray], 0, 1500.0, 0.0, 0, nullptr, nullptr,
+          nullptr, nullptr, &xx, &zz, &ttime, &rstat, &rt_error);
+    if (rt_error == MB_ERROR_NO_ERROR) {
+      EXPECT_DOUBLE_EQ(xx, x[iray]);
+      EXPECT_DOUBLE_EQ(zz, z[iray]);
+      EXPECT_EQ(rstat, ray_stat[iray]);
+    }
+  }
+
+  int nbin;
+  long ninterpolated, nexact;
+  EXPECT_EQ(MB_SUCCESS, mb_rt_table_stats(0, table, &nbin, &ninterpolated, &nexact, &error));
+  EXPECT_EQ(0, ninterpolated);
+  EXPECT_EQ(4, nexact);
+
+  EXPECT_EQ(MB_SUCCESS, mb_rt_table_deall(0, &table, &error));
+  EXPECT_EQ(MB_SUCCESS, mb_rt_deall(0, &model, &error));
+}
+
+}  // namespace
@@ -0,0 +1,163 @@
+// See README file for copying and redistribution conditions.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+extern "C" {
+#include "mb_define.h"
+#include "mb_status.h"
+#include "mbnavadjust_io.h"
+}
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace {
+
+constexpr int kIaDim = 6;
+
+// A sparse overdetermined system like the navigation inversion: ties between
+// pairs of unknowns plus first and second difference smoothing rows, with
+// the columns weighted very differently.
+void MakeSystem(int n, int m, std::vector<int> *nia, std::vector<int> *ia, std::vector<double> *a,
+                std::vector<double> *b) {
+  nia->assign(m, 0);
+  ia->assign(m * kIaDim, 0);
+  a->assign(m * kIaDim, 0.0);
+  b->assign(m, 0.0);
+  srand(3);
+  for (int i = 0; i < m; i++) {
+    const int j = i % n;
+    const double weight = 1.0 + 100.0 * (j % 3 == 2);
+    if (i < n) {
+      (*ia)[i * kIaDim] = j;
+      (*a)[i * kIaDim] = weight;
+      (*nia)[i] = 1;
+    } else if (i % 3 == 0 && j < n - 2) {
+      (*ia)[i * kIaDim] = j;
+      (*a)[i * kIaDim] = weight;
+      (*ia)[i * kIaDim + 1] = j + 1;
+      (*a)[i * kIaDim + 1] = -2.0 * weight;
+      (*ia)[i * kIaDim + 2] = j + 2;
+      (*a)[i * kIaDim + 2] = weight;
+      (*nia)[i] = 3;
+    } else {
+      const int k = rand() % n;
+      (*ia)[i * kIaDim] = j;
+      (*a)[i * kIaDim] = -weight;
+      (*ia)[i * kIaDim + 1] = k;
+      (*a)[i * kIaDim + 1] = 1.0;
+      (*nia)[i] = k == j ? 1 : 2;
+    }
+    (*b)[i] = 0.01 * (rand() % 1000 - 500);
+  }
+}
+
+// Solves the normal equations densely by Gaussian elimination.
+std::vector<double> NormalEquationsSolution(int n, int m, const std::vector<int> &nia, const std::vector<int> &ia,
+                                            const std::vector<double> &a, const std::vector<double> &b) {
+  std::vector<double> ata(n * n, 0.0);
+  std::vector<double> atb(n, 0.0);
+  for (int i = 0; i < m; i++) {
+    for (int l1 = 0; l1 < nia[i]; l1++) {
+      const int j1 = ia[i * kIaDim + l1];
+      atb[j1] += a[i * kIaDim + l1] * b[i];
+      for (int l2 = 0; l2 < nia[i]; l2++)
+        ata[j1 * n + ia[i * kIaDim + l2]] += a[i * kIaDim + l1] * a[i * kIaDim + l2];
+    }
+  }
+  for (int k = 0; k < n; k++) {
+    for (int i = k + 1; i < n; i++) {
+      const double factor = ata[i * n + k] / ata[k * n + k];
+      for (int j = k; j < n; j++)
+        ata[i * n + j] -= factor * ata[k * n + j];
+      atb[i] -= factor * atb[k];
+    }
+  }
+  std::vector<double> x(n, 0.0);
+  for (int i = n - 1; i >= 0; i--) {
+    double sum = atb[i];
+    for (int j = i + 1; j < n; j++)
+      sum -= ata[i * n + j] * x[j];
+    x[i] = sum / ata[i * n + i];
+  }
+  return x;
+}
+
+TEST(MbnavadjustCgls, MatchesNormalEquations) {
+  const int n = 60;
+  const int m = 4000;
+  std::vector<int> nia, ia;
+  std::vector<double> a, b;
+  MakeSystem(n, m, &nia, &ia, &a, &b);
+  const std::vector<double> expected = NormalEquationsSolution(n, m, nia, ia, a, b);
+
+  struct mbna_matrix matrix;
+  matrix.m = m;
+  matrix.n = n;
+  matrix.ia_dim = kIaDim;
+  matrix.nia = nia.data();
+  matrix.ia = ia.data();
+  matrix.a = a.data();
+
+  for (int nthreads = 1; nthreads <= 4; nthreads *= 2) {
+    std::vector<double> x(n, -1.0);
+    int istop = -1;
+    int itn = -1;
+    double rnorm = 0.0;
+    double arnorm = 0.0;
+    int error = MB_ERROR_NO_ERROR;
+    EXPECT_EQ(MB_SUCCESS, mbnavadjust_solve_cgls(0, &matrix, b.data(), x.data(), nthreads, 1.0e-12, 1.0e-12, 4 * n,
+                                                 &istop, &itn, &rnorm, &arnorm, &error));
+    EXPECT_EQ(MB_ERROR_NO_ERROR, error);
+    EXPECT_EQ(2, istop);
+    EXPECT_LE(itn, 4 * n);
+    for (int j = 0; j < n; j++)
+      EXPECT_NEAR(expected[j], x[j], 1.0e-6 * std::max(1.0, std::fabs(expected[j])));
+
+    // the reported residual norm is that of the returned solution
+    double sum = 0.0;
+    for (int i = 0; i < m; i++) {
+      double r = b[i];
+      for (int l = 0; l < nia[i]; l++)
+        r -= a[i * kIaDim + l] * x[ia[i * kIaDim + l]];
+      sum += r * r;
+    }
+    EXPECT_NEAR(std::sqrt(sum), rnorm, 1.0e-6 * rnorm);
+  }
+}
+
+TEST(MbnavadjustCgls, ZeroData) {
+  const int n = 10;
+  const int m = 30;
+  std::vector<int> nia, ia;
+  std::vector<double> a, b;
+  MakeSystem(n, m, &nia, &ia, &a, &b);
+  b.assign(m, 0.0);
+
+  struct mbna_matrix matrix;
+  matrix.m = m;
+  matrix.n = n;
+  matrix.ia_dim = kIaDim;
+  matrix.nia = nia.data();
+  matrix.ia = ia.data();
+  matrix.a = a.data();
+
+  std::vector<double> x(n, -1.0);
+  int istop = -1;
+  int itn = -1;
+  double rnorm = -1.0;
+  double arnorm = -1.0;
+  int error = MB_ERROR_NO_ERROR;
+  EXPECT_EQ(MB_SUCCESS, mbnavadjust_solve_cgls(0, &matrix, b.data(), x.data(), 2, 5.0e-7, 5.0e-7, 4 * n, &istop,
+                                               &itn, &rnorm, &arnorm, &error));
+  EXPECT_EQ(1, istop);
+  EXPECT_EQ(0, itn);
+  EXPECT_THAT(x, testing::Each(0.0));
+  EXPECT_EQ(0.0, rnorm);
+}
+
+}  // namespace
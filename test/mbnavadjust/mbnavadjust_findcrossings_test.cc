@@ -0,0 +1,155 @@
+// See README file for copying and redistribution conditions.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+extern "C" {
+#include "mb_define.h"
+#include "mb_status.h"
+#include "mbnavadjust_io.h"
+}
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace {
+
+// Builds a synthetic project of survey lines that wander over a common area
+// so that sections cross, overlap at the ends and follow each other.
+void MakeProject(int num_files, int num_sections, unsigned int seed, struct mbna_project *project) {
+  memset(project, 0, sizeof(struct mbna_project));
+  project->open = true;
+  project->num_files = num_files;
+  project->num_files_alloc = num_files;
+  project->files = (struct mbna_file *)calloc(num_files, sizeof(struct mbna_file));
+
+  srand(seed);
+  for (int ifile = 0; ifile < num_files; ifile++) {
+    struct mbna_file *file = &project->files[ifile];
+    file->id = ifile;
+    file->num_sections = num_sections;
+    file->num_sections_alloc = num_sections;
+    file->sections = (struct mbna_section *)calloc(num_sections, sizeof(struct mbna_section));
+    double lon = 0.02 * (rand() % 100);
+    double lat = 0.02 * (rand() % 100);
+    const double heading = 0.01 * (rand() % 628);
+    for (int isection = 0; isection < num_sections; isection++) {
+      struct mbna_section *section = &file->sections[isection];
+      section->file_id = ifile;
+      section->section_id = isection;
+      section->continuity = isection > 0 || ifile > 0 ? (rand() % 4 != 0) : false;
+      const double dlon = 0.03 * cos(heading + 0.002 * (rand() % 1000 - 500));
+      const double dlat = 0.03 * sin(heading + 0.002 * (rand() % 1000 - 500));
+      section->lonmin = std::min(lon, lon + dlon) - 0.005;
+      section->lonmax = std::max(lon, lon + dlon) + 0.005;
+      section->latmin = std::min(lat, lat + dlat) - 0.005;
+      section->latmax = std::max(lat, lat + dlat) + 0.005;
+      lon += dlon;
+      lat += dlat;
+      section->num_snav = 3;
+      section->snav_lon_offset[1] = 0.0001 * (rand() % 21 - 10);
+      section->snav_lat_offset[1] = 0.0001 * (rand() % 21 - 10);
+      for (int ii = 0; ii < MBNA_MASK_DIM; ii++) {
+        for (int jj = 0; jj < MBNA_MASK_DIM; jj++) {
+          // a swath along the diagonal of the section bounds with some holes
+          const bool onswath = abs(dlon * dlat >= 0.0 ? ii - jj : ii + jj - MBNA_MASK_DIM + 1) < 4;
+          section->coverage[ii + jj * MBNA_MASK_DIM] = onswath && rand() % 5 != 0 ? 1 : 0;
+        }
+      }
+    }
+  }
+}
+
+void FreeProject(struct mbna_project *project) {
+  for (int ifile = 0; ifile < project->num_files; ifile++)
+    free(project->files[ifile].sections);
+  free(project->files);
+  free(project->crossings);
+  memset(project, 0, sizeof(struct mbna_project));
+}
+
+void ExpectSameCrossings(const struct mbna_project &expected, const struct mbna_project &actual) {
+  ASSERT_EQ(expected.num_crossings, actual.num_crossings);
+  for (int icrossing = 0; icrossing < expected.num_crossings; icrossing++) {
+    EXPECT_EQ(expected.crossings[icrossing].file_id_1, actual.crossings[icrossing].file_id_1);
+    EXPECT_EQ(expected.crossings[icrossing].section_1, actual.crossings[icrossing].section_1);
+    EXPECT_EQ(expected.crossings[icrossing].file_id_2, actual.crossings[icrossing].file_id_2);
+    EXPECT_EQ(expected.crossings[icrossing].section_2, actual.crossings[icrossing].section_2);
+    EXPECT_EQ(MBNA_CROSSING_STATUS_NONE, actual.crossings[icrossing].status);
+  }
+}
+
+TEST(MbnavadjustFindcrossings, Empty) {
+  int error = MB_ERROR_NO_ERROR;
+  struct mbna_project project;
+  MakeProject(0, 0, 1, &project);
+  EXPECT_EQ(MB_SUCCESS, mbnavadjust_findcrossingsall(0, &project, 4, &error));
+  EXPECT_EQ(0, project.num_crossings);
+  FreeProject(&project);
+}
+
+TEST(MbnavadjustFindcrossings, MatchesSerialSearch) {
+  const int num_files = 12;
+  const int num_sections = 40;
+  int error = MB_ERROR_NO_ERROR;
+
+  struct mbna_project reference;
+  MakeProject(num_files, num_sections, 7, &reference);
+  for (int ifile = 0; ifile < num_files; ifile++)
+    EXPECT_EQ(MB_SUCCESS, mbnavadjust_findcrossingsfile(0, &reference, ifile, &error));
+  EXPECT_GT(reference.num_crossings, num_files);
+
+  for (int nthreads = 1; nthreads <= 4; nthreads *= 2) {
+    struct mbna_project project;
+    MakeProject(num_files, num_sections, 7, &project);
+    EXPECT_EQ(MB_SUCCESS, mbnavadjust_findcrossingsall(0, &project, nthreads, &error));
+    EXPECT_EQ(MB_ERROR_NO_ERROR, error);
+    ExpectSameCrossings(reference, project);
+    FreeProject(&project);
+  }
+
+  FreeProject(&reference);
+}
+
+TEST(MbnavadjustFindcrossings, KeepsExistingCrossings) {
+  const int num_files = 6;
+  const int num_sections = 30;
+  int error = MB_ERROR_NO_ERROR;
+
+  // find all crossings of the first half of the files, then add the rest
+  struct mbna_project reference;
+  MakeProject(num_files, num_sections, 11, &reference);
+  for (int ifile = 0; ifile < num_files; ifile++)
+    EXPECT_EQ(MB_SUCCESS, mbnavadjust_findcrossingsfile(0, &reference, ifile, &error));
+
+  struct mbna_project project;
+  MakeProject(num_files, num_sections, 11, &project);
+  project.num_files = num_files / 2;
+  EXPECT_EQ(MB_SUCCESS, mbnavadjust_findcrossingsall(0, &project, 2, &error));
+  const int num_first = project.num_crossings;
+
+  // store some of the existing crossings in the reverse order, as an
+  // interactively added crossing may be
+  for (int icrossing = 0; icrossing < num_first; icrossing += 3) {
+    struct mbna_crossing *crossing = &project.crossings[icrossing];
+    std::swap(crossing->file_id_1, crossing->file_id_2);
+    std::swap(crossing->section_1, crossing->section_2);
+  }
+  project.num_files = num_files;
+  EXPECT_EQ(MB_SUCCESS, mbnavadjust_findcrossingsall(0, &project, 2, &error));
+  for (int icrossing = 0; icrossing < num_first; icrossing += 3) {
+    struct mbna_crossing *crossing = &project.crossings[icrossing];
+    std::swap(crossing->file_id_1, crossing->file_id_2);
+    std::swap(crossing->section_1, crossing->section_2);
+  }
+  ExpectSameCrossings(reference, project);
+
+  FreeProject(&project);
+  FreeProject(&reference);
+}
+
+}  // namespace
@@ -0,0 +1,181 @@
+// See README file for copying and redistribution conditions.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <unistd.h>
+
+extern "C" {
+#include "mb_define.h"
+#include "mb_status.h"
+#include "mbnavadjust_io.h"
+}
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+namespace {
+
+constexpr int kGridDim = MBNA_MISFIT_DIMXY;
+constexpr int kGridmDim = MBNA_MISFIT_DIMXY / 2 + 1;
+constexpr int kNz = 11;
+constexpr double kZmin = -5.0;
+constexpr double kZoffDz = 1.0;
+constexpr double kOffsetZ = 0.5;
+
+// Two overlapping patches of a sloping, rippled seafloor, the second shifted
+// and offset in depth, with empty cells scattered through both.
+void MakeGrids(std::vector<double> *grid1, std::vector<int> *gridn1, std::vector<double> *grid2,
+               std::vector<int> *gridn2) {
+  grid1->assign(kGridDim * kGridDim, 0.0);
+  grid2->assign(kGridDim * kGridDim, 0.0);
+  gridn1->assign(kGridDim * kGridDim, 0);
+  gridn2->assign(kGridDim * kGridDim, 0);
+  srand(5);
+  for (int i = 0; i < kGridDim; i++) {
+    for (int j = 0; j < kGridDim; j++) {
+      const int k = i + j * kGridDim;
+      if (i < 45 && rand() % 7 != 0) {
+        (*grid1)[k] = -1000.0 + 2.0 * i + 5.0 * sin(0.3 * j);
+        (*gridn1)[k] = 1 + rand() % 5;
+      }
+      if (j > 12 && rand() % 7 != 0) {
+        (*grid2)[k] = -1003.0 + 2.0 * (i - 2) + 5.0 * sin(0.3 * (j + 1)) + 0.01 * (rand() % 100);
+        (*gridn2)[k] = 1 + rand() % 5;
+      }
+    }
+  }
+}
+
+// The misfit as mbnavadjust used to compute it, one z offset at a time.
+void BruteForceMisfit(const std::vector<double> &grid1, const std::vector<int> &gridn1, const std::vector<double> &grid2,
+                      const std::vector<int> &gridn2, std::vector<double> *gridm, std::vector<int> *gridnm) {
+  gridm->assign(kGridmDim * kGridmDim * kNz, 0.0);
+  gridnm->assign(kGridmDim * kGridmDim * kNz, 0);
+  for (int ic = 0; ic < kGridmDim; ic++)
+    for (int jc = 0; jc < kGridmDim; jc++)
+      for (int kc = 0; kc < kNz; kc++) {
+        const int lc = kc + kNz * (ic + jc * kGridmDim);
+        const int ioff = (kGridmDim / 2) - ic;
+        const int joff = (kGridmDim / 2) - jc;
+        const double zoff = kZmin + kZoffDz * kc;
+        for (int i1 = std::max(-ioff, 0); i1 < kGridDim - std::max(0, ioff); i1++)
+          for (int j1 = std::max(-joff, 0); j1 < kGridDim - std::max(0, joff); j1++) {
+            const int k1 = i1 + j1 * kGridDim;
+            const int k2 = i1 + ioff + (j1 + joff) * kGridDim;
+            if (gridn1[k1] > 0 && gridn2[k2] > 0) {
+              const double d = grid2[k2] - grid1[k1] + zoff - kOffsetZ;
+              (*gridm)[lc] += d * d;
+              (*gridnm)[lc]++;
+            }
+          }
+      }
+}
+
+TEST(MbnavadjustMisfit, MatchesBruteForce) {
+  std::vector<double> grid1, grid2, expected_m;
+  std::vector<int> gridn1, gridn2, expected_n;
+  MakeGrids(&grid1, &gridn1, &grid2, &gridn2);
+  BruteForceMisfit(grid1, gridn1, grid2, gridn2, &expected_m, &expected_n);
+
+  for (int nthreads = 1; nthreads <= 4; nthreads *= 2) {
+    std::vector<double> gridm(kGridmDim * kGridmDim * kNz, -1.0);
+    std::vector<int> gridnm(kGridmDim * kGridmDim * kNz, -1);
+    int error = MB_ERROR_NO_ERROR;
+    EXPECT_EQ(MB_SUCCESS, mbnavadjust_misfit_grid(0, nthreads, kGridDim, kGridDim, grid1.data(), gridn1.data(),
+                                                  grid2.data(), gridn2.data(), kGridmDim, kGridmDim, kNz, kZmin, kZoffDz,
+                                                  kOffsetZ, gridm.data(), gridnm.data(), &error));
+    EXPECT_EQ(MB_ERROR_NO_ERROR, error);
+    for (size_t l = 0; l < gridm.size(); l++) {
+      EXPECT_EQ(expected_n[l], gridnm[l]);
+      EXPECT_NEAR(expected_m[l], gridm[l], 1.0e-9 * std::max(1.0, expected_m[l]));
+    }
+  }
+}
+
+void WriteSection(const char *datadir, int file_id, int section_id, const char *contents) {
+  char path[MB_PATH_MAXLINE];
+  snprintf(path, sizeof(path), "%s/nvs_%4.4d_%4.4d.mb71", datadir, file_id, section_id);
+  FILE *fp = fopen(path, "w");
+  ASSERT_NE(nullptr, fp);
+  fputs(contents, fp);
+  fclose(fp);
+}
+
+TEST(MbnavadjustMisfit, Cache) {
+  struct mbna_file files[2];
+  memset(files, 0, sizeof(files));
+  struct mbna_project project;
+  memset(&project, 0, sizeof(project));
+  project.open = true;
+  project.num_files = 2;
+  project.files = files;
+  project.refgrid_select = -1;
+  char datadir[] = "/tmp/mbnavadjust_misfit_testXXXXXX";
+  ASSERT_NE(nullptr, mkdtemp(datadir));
+  strcpy(project.datadir, datadir);
+  WriteSection(datadir, 0, 3, "section one");
+  WriteSection(datadir, 1, 0, "section two");
+
+  // the key depends on the section files, the file biases and the parameters
+  double parameters[3] = {kZmin, kZoffDz, kOffsetZ};
+  uint64_t key = 0;
+  uint64_t other = 0;
+  int error = MB_ERROR_NO_ERROR;
+  ASSERT_EQ(MB_SUCCESS, mbnavadjust_misfit_cachekey(0, &project, 0, 3, 1, 0, 3, parameters, &key, &error));
+  ASSERT_EQ(MB_SUCCESS, mbnavadjust_misfit_cachekey(0, &project, 0, 3, 1, 0, 3, parameters, &other, &error));
+  EXPECT_EQ(key, other);
+  parameters[2] += 1.0;
+  ASSERT_EQ(MB_SUCCESS, mbnavadjust_misfit_cachekey(0, &project, 0, 3, 1, 0, 3, parameters, &other, &error));
+  EXPECT_NE(key, other);
+  parameters[2] -= 1.0;
+  files[1].heading_bias = 0.5;
+  ASSERT_EQ(MB_SUCCESS, mbnavadjust_misfit_cachekey(0, &project, 0, 3, 1, 0, 3, parameters, &other, &error));
+  EXPECT_NE(key, other);
+  files[1].heading_bias = 0.0;
+  EXPECT_EQ(MB_FAILURE, mbnavadjust_misfit_cachekey(0, &project, 0, 4, 1, 0, 3, parameters, &other, &error));
+  EXPECT_EQ(MB_ERROR_OPEN_FAIL, error);
+
+  // a misfit grid is found in the cache once written
+  std::vector<double> grid1, grid2;
+  std::vector<int> gridn1, gridn2;
+  MakeGrids(&grid1, &gridn1, &grid2, &gridn2);
+  std::vector<double> gridm(kGridmDim * kGridmDim * kNz);
+  std::vector<int> gridnm(kGridmDim * kGridmDim * kNz);
+  ASSERT_EQ(MB_SUCCESS, mbnavadjust_misfit_grid(0, 2, kGridDim, kGridDim, grid1.data(), gridn1.data(), grid2.data(),
+                                                gridn2.data(), kGridmDim, kGridmDim, kNz, kZmin, kZoffDz, kOffsetZ,
+                                                gridm.data(), gridnm.data(), &error));
+  std::vector<double> cachedm(gridm.size(), -1.0);
+  std::vector<int> cachednm(gridnm.size(), -1);
+  EXPECT_EQ(MB_FAILURE, mbnavadjust_misfit_cache_read(0, &project, key, static_cast<int>(cachedm.size()),
+                                                      cachedm.data(), cachednm.data(), &error));
+  EXPECT_EQ(MB_ERROR_OPEN_FAIL, error);
+  EXPECT_EQ(MB_SUCCESS, mbnavadjust_misfit_cache_write(0, &project, key, static_cast<int>(gridm.size()), gridm.data(),
+                                                       gridnm.data(), &error));
+  EXPECT_EQ(MB_SUCCESS, mbnavadjust_misfit_cache_read(0, &project, key, static_cast<int>(cachedm.size()),
+                                                      cachedm.data(), cachednm.data(), &error));
+  EXPECT_EQ(gridm, cachedm);
+  EXPECT_EQ(gridnm, cachednm);
+
+  // rewriting a section changes the key, so the stale grid is not used
+  WriteSection(datadir, 1, 0, "section two, renavigated");
+  ASSERT_EQ(MB_SUCCESS, mbnavadjust_misfit_cachekey(0, &project, 0, 3, 1, 0, 3, parameters, &other, &error));
+  EXPECT_NE(key, other);
+  EXPECT_EQ(MB_FAILURE, mbnavadjust_misfit_cache_read(0, &project, other, static_cast<int>(cachedm.size()),
+                                                      cachedm.data(), cachednm.data(), &error));
+
+  // a grid of another size is not read back
+  EXPECT_EQ(MB_FAILURE, mbnavadjust_misfit_cache_read(0, &project, key, static_cast<int>(cachedm.size()) - 1,
+                                                      cachedm.data(), cachednm.data(), &error));
+  EXPECT_EQ(MB_ERROR_BAD_FORMAT, error);
+
+  char command[2 * MB_PATH_MAXLINE];
+  snprintf(command, sizeof(command), "rm -rf %s", datadir);
+  EXPECT_EQ(0, system(command));
+}
+
+}  // namespace
@@ -8,6 +8,7 @@
 
 import os
 import subprocess
+import tempfile
 import unittest
 
 
@@ -34,6 +35,10 @@ class MbGridTest(unittest.TestCase):
     self.assertIn('curvature algorithm', output)
     self.assertIn('usage:', output)
     self.assertIn('-Xextend', output)
+    self.assertIn('--threads=nthreads', output)
+    self.assertIn('--tile-size=ncells', output)
+    self.assertIn('--percentiles=p1/p2/...', output)
+    self.assertIn('--surface', output)
 
   def testHelpVerbose2(self):
     cmd = [self.cmd, '-h', '-V', '-V']
@@ -48,6 +53,48 @@ class MbGridTest(unittest.TestCase):
     self.assertIn('dbg2', output)
     self.assertIn('lonflip', output)
     self.assertIn('minormax_weighted_mean_threshold:', output)
+    self.assertIn('n_threads:', output)
+    self.assertIn('tile_size:', output)
+    self.assertIn('npercentile:', output)
+    self.assertIn('median_cap:', output)
+    self.assertIn('use_surface:', output)
+
+  def MedianFilter(self, median_cap):
+    """Median filter 1000 soundings in the center cell of a 3 x 3 grid."""
+    cmd = os.path.abspath(self.cmd)
+    with tempfile.TemporaryDirectory() as tmpdir:
+      with open(os.path.join(tmpdir, 'soundings.xyz'), 'w') as xyz:
+        for i in range(1000):
+          xyz.write('0.001 0.001 %d\n' % (1000 + (i * 7919) % 1000))
+      with open(os.path.join(tmpdir, 'datalist.mb-1'), 'w') as datalist:
+        datalist.write('soundings.xyz 162\n')
+      cmd = [cmd, '-I', 'datalist.mb-1', '-O', 'median', '-A1', '-F2', '-G1',
+             '-R0/0.002/0/0.002', '-D3/3', '-V',
+             '--median-cap=%d' % median_cap]
+      output = subprocess.check_output(cmd, stderr=subprocess.STDOUT,
+                                       cwd=tmpdir).decode()
+      with open(os.path.join(tmpdir, 'median.asc')) as grid:
+        values = [float(v) for v in grid.read().split('\n', 3)[3].split()]
+    nodes = [v for v in values if 1000.0 <= v < 2000.0]
+    self.assertEqual(1, len(nodes))
+    return nodes[0], output
+
+  def testMedianFilterExact(self):
+    median, output = self.MedianFilter(0)
+    self.assertEqual(1500.0, median)
+    self.assertNotIn('estimated from a sample', output)
+
+  def testMedianFilterBelowCapIsExact(self):
+    median, output = self.MedianFilter(1000)
+    self.assertEqual(1500.0, median)
+    self.assertNotIn('estimated from a sample', output)
+
+  def testMedianFilterAboveCapIsSampled(self):
+    median, output = self.MedianFilter(100)
+    self.assertGreater(median, 1350.0)
+    self.assertLess(median, 1650.0)
+    self.assertIn('1 bins exceeded 100 values and were estimated from a sample',
+                  output)
 
   # TODO(schwehr): Add tests of actual usage.
 